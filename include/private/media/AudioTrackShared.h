@@ -424,6 +424,21 @@ public:
         mTimestamp.clear();
     }
 
+    // Reads the timestamp last published by the server in the control block, without the
+    // state of getTimestamp(): may be called from any thread, even if the proxy was replaced.
+    // Returns false if no timestamp was published, or the server kept publishing while reading.
+    // If sequence is not nullptr, it is set to the sequence of the timestamp read.
+    static bool readTimestamp(const audio_track_cblk_t *cblk, ExtendedTimestamp *timestamp,
+            int32_t *sequence = nullptr) {
+        return ExtendedTimestampQueue::Reader(&cblk->mExtendedTimestampQueue)
+                .read(*timestamp, sequence);
+    }
+
+    // Sequence of the timestamp last published by the server, see readTimestamp().
+    static int32_t timestampSequence(const audio_track_cblk_t *cblk) {
+        return ExtendedTimestampQueue::Reader(&cblk->mExtendedTimestampQueue).sequence();
+    }
+
     virtual void stop() { }; // called by client in AudioTrack::stop()
 
 private:
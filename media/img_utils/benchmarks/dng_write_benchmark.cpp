@@ -0,0 +1,146 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define LOG_TAG "dng_write_benchmark"
+#include <utils/Log.h>
+
+#include <img_utils/BufferStripSource.h>
+#include <img_utils/FileOutput.h>
+#include <img_utils/TagDefinitions.h>
+#include <img_utils/TiffWriter.h>
+
+#include <android-base/file.h>
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace android;
+using namespace android::img_utils;
+
+/*
+ Writes a 12 MP, 16 bit Bayer frame to a DNG file:
+   #BM_WriteDng/0     row by row through the stream, as DngCreator sources do
+   #BM_WriteDng/1     directly from the frame buffer
+   #BM_WriteDng/2..4  lossless JPEG compressed by 1, 2 and 4 threads
+ */
+
+namespace {
+
+constexpr uint32_t kWidth = 4032;
+constexpr uint32_t kHeight = 3024;
+
+// RGGB frame with 10 bit samples: smooth color gradients plus sensor noise
+const std::vector<uint16_t>& getBayerFrame() {
+    static const std::vector<uint16_t> frame = [] {
+        std::vector<uint16_t> samples(static_cast<size_t>(kWidth) * kHeight);
+        std::mt19937 random(42);
+        std::normal_distribution<float> noise(0.f, 4.f);
+        for (uint32_t y = 0; y < kHeight; ++y) {
+            for (uint32_t x = 0; x < kWidth; ++x) {
+                int channel = (y % 2) * 2 + (x % 2);
+                float base = 64.f + 200.f * channel + 300.f * x / kWidth + 200.f * y / kHeight;
+                int value = static_cast<int>(base + noise(random));
+                samples[static_cast<size_t>(y) * kWidth + x] =
+                        static_cast<uint16_t>(std::min(std::max(value, 0), 1023));
+            }
+        }
+        return samples;
+    }();
+    return frame;
+}
+
+// Source writing one row at a time through the stream
+class RowStripSource : public StripSource {
+  public:
+    explicit RowStripSource(const uint8_t* pixels) : mPixels(pixels) {}
+
+    status_t writeToStream(Output& stream, uint32_t count) override {
+        const uint32_t rowSize = kWidth * sizeof(uint16_t);
+        if (count != rowSize * kHeight) return BAD_VALUE;
+        for (uint32_t row = 0; row < kHeight; ++row) {
+            status_t ret = stream.write(mPixels, row * rowSize, rowSize);
+            if (ret != OK) return ret;
+        }
+        return OK;
+    }
+
+    uint32_t getIfd() const override { return 0; }
+
+  private:
+    const uint8_t* mPixels;
+};
+
+status_t writeDng(const String8& path, StripSource* source, uint32_t compressionThreads) {
+    sp<TiffWriter> writer = new TiffWriter();
+    const uint32_t width = kWidth;
+    const uint32_t height = kHeight;
+    const uint16_t bitsPerSample = 16;
+    const uint16_t samplesPerPixel = 1;
+    const uint16_t photometric = 32803; // CFA
+    const uint16_t compression = TAG_COMPRESSION_NONE;
+    status_t ret = OK;
+    if ((ret = writer->addIfd(0)) != OK ||
+            (ret = writer->addEntry(TAG_IMAGEWIDTH, 1, &width, 0)) != OK ||
+            (ret = writer->addEntry(TAG_IMAGELENGTH, 1, &height, 0)) != OK ||
+            (ret = writer->addEntry(TAG_BITSPERSAMPLE, 1, &bitsPerSample, 0)) != OK ||
+            (ret = writer->addEntry(TAG_SAMPLESPERPIXEL, 1, &samplesPerPixel, 0)) != OK ||
+            (ret = writer->addEntry(TAG_PHOTOMETRICINTERPRETATION, 1, &photometric, 0)) != OK ||
+            (ret = writer->addEntry(TAG_COMPRESSION, 1, &compression, 0)) != OK ||
+            (ret = writer->addStrip(0)) != OK) {
+        return ret;
+    }
+    if (compressionThreads > 0 && (ret = writer->setStripCompression(0,
+            TAG_COMPRESSION_LOSSLESS_JPEG, compressionThreads)) != OK) {
+        return ret;
+    }
+
+    FileOutput out(path);
+    StripSource* sources[] = { source };
+    if ((ret = out.open()) != OK) return ret;
+    ret = writer->write(&out, sources, 1);
+    status_t closeRet = out.close();
+    return (ret != OK) ? ret : closeRet;
+}
+
+} // namespace
+
+static void BM_WriteDng(benchmark::State& state) {
+    const int mode = state.range(0);
+    const std::vector<uint16_t>& frame = getBayerFrame();
+    const uint8_t* pixels = reinterpret_cast<const uint8_t*>(frame.data());
+    RowStripSource rowSource(pixels);
+    BufferStripSource bufferSource(pixels, 0, kWidth, kHeight, sizeof(uint16_t),
+            kWidth * sizeof(uint16_t), sizeof(uint16_t), 1);
+    StripSource* source = (mode == 0) ? static_cast<StripSource*>(&rowSource) : &bufferSource;
+    const uint32_t compressionThreads = (mode >= 2) ? 1u << (mode - 2) : 0;
+
+    TemporaryDir dir;
+    const String8 path = String8(dir.path) + String8("/frame.dng");
+    while (state.KeepRunning()) {
+        if (writeDng(path, source, compressionThreads) != OK) {
+            state.SkipWithError("Failed to write DNG");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * frame.size() * sizeof(uint16_t));
+}
+
+BENCHMARK(BM_WriteDng)->DenseRange(0, 4)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef IMG_UTILS_BUFFER_STRIP_SOURCE_H
+#define IMG_UTILS_BUFFER_STRIP_SOURCE_H
+
+#include <img_utils/Output.h>
+#include <img_utils/StripSource.h>
+
+#include <cutils/compiler.h>
+#include <utils/Errors.h>
+#include <utils/Vector.h>
+
+#include <stdint.h>
+
+namespace android {
+namespace img_utils {
+
+/**
+ * StripSource for an image held in memory, such as a locked RAW buffer.
+ *
+ * Pixels are pixelStride bytes apart, and rows rowStride bytes apart.  When the pixels of a
+ * row are contiguous, the strips are written directly from the buffer.
+ */
+class ANDROID_API BufferStripSource : public StripSource {
+    public:
+        BufferStripSource(const uint8_t* pixels, uint32_t ifd, uint32_t width, uint32_t height,
+                uint32_t pixelStride, uint32_t rowStride, uint32_t bytesPerSample,
+                uint32_t samplesPerPixel);
+
+        virtual ~BufferStripSource();
+
+        virtual status_t writeToStream(Output& stream, uint32_t count);
+
+        virtual status_t getStripVectors(uint32_t count, /*out*/Vector<struct iovec>* vectors);
+
+        virtual uint32_t getIfd() const;
+
+    private:
+        bool checkCount(uint32_t count) const;
+
+        const uint8_t* mPixels;
+        uint32_t mIfd;
+        uint32_t mWidth;
+        uint32_t mHeight;
+        uint32_t mPixelStride;
+        uint32_t mRowStride;
+        uint32_t mPixelSize;
+        uint32_t mRowSize;
+};
+
+} /*namespace img_utils*/
+} /*namespace android*/
+
+#endif /*IMG_UTILS_BUFFER_STRIP_SOURCE_H*/
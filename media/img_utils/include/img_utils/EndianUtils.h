@@ -87,6 +87,13 @@ class ANDROID_API EndianOutput : public Output {
          */
         virtual uint32_t getCurrentOffset() const;
 
+        /**
+         * Write the bytes of each of the given buffers, in order, without reordering.
+         *
+         * Returns OK on success, or a negative error code.
+         */
+        virtual status_t writeVectors(const struct iovec* vectors, size_t count);
+
 
         // TODO: switch write methods to uint32_t instead of size_t,
         // the max size of a TIFF files is bounded
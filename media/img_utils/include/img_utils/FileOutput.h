@@ -33,6 +33,7 @@ class ANDROID_API FileOutput : public Output {
         virtual ~FileOutput();
         virtual status_t open();
         virtual status_t write(const uint8_t* buf, size_t offset, size_t count);
+        virtual status_t writeVectors(const struct iovec* vectors, size_t count);
         virtual status_t close();
     private:
         FILE *mFp;
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef IMG_UTILS_LOSSLESS_JPEG_ENCODER_H
+#define IMG_UTILS_LOSSLESS_JPEG_ENCODER_H
+
+#include <img_utils/EndianUtils.h>
+
+#include <cutils/compiler.h>
+#include <utils/Errors.h>
+
+#include <stdint.h>
+#include <vector>
+
+namespace android {
+namespace img_utils {
+
+/**
+ * Encoder for the lossless JPEG (ITU T.81 lossless process, first predictor) streams used as
+ * compressed strips and tiles of DNG files.
+ */
+class ANDROID_API LosslessJpegEncoder {
+    public:
+        /**
+         * Encode an image as a single lossless JPEG stream, using Huffman tables optimized
+         * for the image.
+         *
+         * The rows argument points to height rows of width pixels, each with samplesPerPixel
+         * samples of bitsPerSample bits (8 or 16) stored with the given endianness.  For CFA
+         * images, with a single sample per pixel and an even width, the samples are encoded
+         * as two interleaved components so that each sample is predicted from the closest
+         * sample of the same color.
+         *
+         * Returns OK on success, or a negative error code.
+         */
+        static status_t encode(const uint8_t* const* rows, uint32_t width, uint32_t height,
+                uint32_t samplesPerPixel, uint32_t bitsPerSample, Endianness end,
+                /*out*/std::vector<uint8_t>* output);
+};
+
+} /*namespace img_utils*/
+} /*namespace android*/
+
+#endif /*IMG_UTILS_LOSSLESS_JPEG_ENCODER_H*/
@@ -20,6 +20,7 @@
 #include <cutils/compiler.h>
 #include <utils/Errors.h>
 #include <stdint.h>
+#include <sys/uio.h>
 
 namespace android {
 namespace img_utils {
@@ -47,6 +48,15 @@ class ANDROID_API Output {
          */
         virtual status_t write(const uint8_t* buf, size_t offset, size_t count) = 0;
 
+        /**
+         * Write the bytes of each of the given buffers, in order, as if by calling write
+         * for each of them.  Outputs backed by a file override this to hand all of the
+         * buffers to the kernel at once instead of copying them.
+         *
+         * Returns OK on success, or a negative error code.
+         */
+        virtual status_t writeVectors(const struct iovec* vectors, size_t count);
+
         /**
          * Close this Output.  It is not valid to call open on a previously closed Output.
          *
@@ -21,8 +21,10 @@
 
 #include <cutils/compiler.h>
 #include <utils/Errors.h>
+#include <utils/Vector.h>
 
 #include <stdint.h>
+#include <sys/uio.h>
 
 namespace android {
 namespace img_utils {
@@ -41,6 +43,17 @@ class ANDROID_API StripSource {
          */
         virtual status_t writeToStream(Output& stream, uint32_t count) = 0;
 
+        /**
+         * Get the memory holding the first count bytes of strip data, in the order in which
+         * they are written to the stream.  This lets the strips be written directly from
+         * that memory, without being copied through writeToStream.  The memory must stay
+         * valid until the TiffWriter write call using this source returns.
+         *
+         * Returns OK on success, or INVALID_OPERATION if the strip data isn't held in memory
+         * in the layout written to the stream.
+         */
+        virtual status_t getStripVectors(uint32_t count, /*out*/Vector<struct iovec>* vectors);
+
         /**
          * Return the source IFD.
          */
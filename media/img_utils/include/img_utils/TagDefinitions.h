@@ -206,6 +206,11 @@ enum {
     TAG_ORIENTATION_UNKNOWN = 9
 };
 
+enum {
+    TAG_COMPRESSION_NONE = 1,
+    TAG_COMPRESSION_LOSSLESS_JPEG = 7
+};
+
 /**
  * TIFF_EP_TAG_DEFINITIONS contains tags defined in the TIFF EP spec
  */
@@ -31,6 +31,7 @@
 
 #include <cutils/compiler.h>
 #include <stdint.h>
+#include <vector>
 
 namespace android {
 namespace img_utils {
@@ -55,6 +56,10 @@ class ANDROID_API TiffWriter : public LightRefBase<TiffWriter> {
             GPSINFO
         };
 
+        enum {
+            DEFAULT_COMPRESSION_THREADS = 4,
+        };
+
         /**
          * Constructs a TiffWriter with the default tag mappings. This enables
          * all of the tags defined in TagDefinitions.h, and uses the following
@@ -88,6 +93,10 @@ class ANDROID_API TiffWriter : public LightRefBase<TiffWriter> {
          * StripOffsets tags must be set to use this.  To set these tags in a
          * given IFD, use the addStrip method.
          *
+         * Strips are written directly from the memory of sources that provide it
+         * through getStripVectors, and compressed first if set with
+         * setStripCompression.
+         *
          * Returns OK on success, or a negative error code on failure.
          */
         virtual status_t write(Output* out, StripSource** sources, size_t sourcesCount,
@@ -175,6 +184,19 @@ class ANDROID_API TiffWriter : public LightRefBase<TiffWriter> {
          */
         virtual status_t addStrip(uint32_t ifd);
 
+        /**
+         * Set the compression of the strips of the given IFD, and its Compression tag.
+         * Compression is one of TAG_COMPRESSION_NONE, or TAG_COMPRESSION_LOSSLESS_JPEG
+         * for images with 8 or 16 bit samples.  Call this after addStrip.
+         *
+         * Lossless JPEG strips are encoded by write, each as its own JPEG stream, using
+         * up to threadCount threads in parallel.
+         *
+         * Returns OK on success, or a negative error code.
+         */
+        virtual status_t setStripCompression(uint32_t ifd, uint16_t compression,
+                uint32_t threadCount = DEFAULT_COMPRESSION_THREADS);
+
         /**
          * Return the TIFF entry with the given tag ID in the IFD with the given ID,
          * or an empty pointer if none exists.
@@ -259,11 +281,15 @@ class ANDROID_API TiffWriter : public LightRefBase<TiffWriter> {
         status_t writeFileHeader(EndianOutput& out);
         const TagDefinition_t* lookupDefinition(uint16_t tag) const;
         status_t calculateOffsets();
+        status_t compressStrips(const sp<TiffIfd>& ifd, StripSource* source, Endianness end,
+                uint32_t threadCount, /*out*/std::vector<std::vector<uint8_t> >* strips);
 
         sp<TiffIfd> mIfd;
         KeyedVector<uint32_t, sp<TiffIfd> > mNamedIfds;
         KeyedVector<uint16_t, const TagDefinition_t*>* mTagMaps;
         size_t mNumTagMaps;
+        // Thread count for each IFD with lossless JPEG strips
+        KeyedVector<uint32_t, uint32_t> mCompressionThreads;
 
         static KeyedVector<uint16_t, const TagDefinition_t*> sTagMaps[];
 };
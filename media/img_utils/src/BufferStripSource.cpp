@@ -0,0 +1,115 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define LOG_TAG "BufferStripSource"
+
+#include <img_utils/BufferStripSource.h>
+
+#include <utils/Log.h>
+
+#include <string.h>
+
+namespace android {
+namespace img_utils {
+
+BufferStripSource::BufferStripSource(const uint8_t* pixels, uint32_t ifd, uint32_t width,
+        uint32_t height, uint32_t pixelStride, uint32_t rowStride, uint32_t bytesPerSample,
+        uint32_t samplesPerPixel) : mPixels(pixels), mIfd(ifd), mWidth(width), mHeight(height),
+        mPixelStride(pixelStride), mRowStride(rowStride),
+        mPixelSize(bytesPerSample * samplesPerPixel), mRowSize(mPixelSize * width) {}
+
+BufferStripSource::~BufferStripSource() {}
+
+bool BufferStripSource::checkCount(uint32_t count) const {
+    uint64_t fullSize = static_cast<uint64_t>(mRowSize) * mHeight;
+    if (fullSize != count) {
+        ALOGE("%s: Invalid count %u for image with %u rows of %u bytes.", __FUNCTION__, count,
+                mHeight, mRowSize);
+        return false;
+    }
+    return true;
+}
+
+status_t BufferStripSource::writeToStream(Output& stream, uint32_t count) {
+    if (!checkCount(count)) {
+        return BAD_VALUE;
+    }
+
+    status_t ret = OK;
+    if (mPixelStride == mPixelSize) {
+        if (mRowStride == mRowSize) {
+            return stream.write(mPixels, 0, count);
+        }
+        for (uint32_t row = 0; row < mHeight; ++row) {
+            if ((ret = stream.write(mPixels, static_cast<size_t>(row) * mRowStride, mRowSize))
+                    != OK) {
+                ALOGE("%s: Failed to write row %u.", __FUNCTION__, row);
+                return ret;
+            }
+        }
+        return ret;
+    }
+
+    // Gather the pixels of each row
+    Vector<uint8_t> rowBuffer;
+    rowBuffer.resize(mRowSize);
+    uint8_t* rowBytes = rowBuffer.editArray();
+    for (uint32_t row = 0; row < mHeight; ++row) {
+        const uint8_t* rowStart = mPixels + static_cast<size_t>(row) * mRowStride;
+        for (uint32_t col = 0; col < mWidth; ++col) {
+            memcpy(rowBytes + col * mPixelSize, rowStart + static_cast<size_t>(col) * mPixelStride,
+                    mPixelSize);
+        }
+        if ((ret = stream.write(rowBytes, 0, mRowSize)) != OK) {
+            ALOGE("%s: Failed to write row %u.", __FUNCTION__, row);
+            return ret;
+        }
+    }
+    return ret;
+}
+
+status_t BufferStripSource::getStripVectors(uint32_t count,
+        /*out*/Vector<struct iovec>* vectors) {
+    if (mPixelStride != mPixelSize) {
+        return INVALID_OPERATION;
+    }
+    if (!checkCount(count)) {
+        return BAD_VALUE;
+    }
+
+    vectors->clear();
+    if (mRowStride == mRowSize) {
+        struct iovec image = { const_cast<uint8_t*>(mPixels), count };
+        vectors->add(image);
+        return OK;
+    }
+
+    vectors->setCapacity(mHeight);
+    for (uint32_t row = 0; row < mHeight; ++row) {
+        struct iovec rowVector = {
+                const_cast<uint8_t*>(mPixels + static_cast<size_t>(row) * mRowStride), mRowSize };
+        vectors->add(rowVector);
+    }
+    return OK;
+}
+
+uint32_t BufferStripSource::getIfd() const {
+    return mIfd;
+}
+
+} /*namespace img_utils*/
+} /*namespace android*/
@@ -53,6 +53,16 @@ status_t EndianOutput::write(const uint8_t* buf, size_t offset, size_t count) {
     return res;
 }
 
+status_t EndianOutput::writeVectors(const struct iovec* vectors, size_t count) {
+    status_t res = OK;
+    if((res = mOutput->writeVectors(vectors, count)) == OK) {
+        for (size_t i = 0; i < count; ++i) {
+            mOffset += vectors[i].iov_len;
+        }
+    }
+    return res;
+}
+
 status_t EndianOutput::write(const int8_t* buf, size_t offset, size_t count) {
     return write(reinterpret_cast<const uint8_t*>(buf), offset, count);
 }
@@ -18,6 +18,11 @@
 
 #include <utils/Log.h>
 
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+
 namespace android {
 namespace img_utils {
 
@@ -60,6 +65,50 @@ status_t FileOutput::write(const uint8_t* buf, size_t offset, size_t count) {
     return OK;
 }
 
+status_t FileOutput::writeVectors(const struct iovec* vectors, size_t count) {
+    if (!mOpen) {
+        ALOGE("%s: Could not write file %s, file not open.", __FUNCTION__, mPath.c_str());
+        return BAD_VALUE;
+    }
+
+    // Anything still buffered by stdio precedes these bytes in the file
+    if (::fflush(mFp) != 0) {
+        ALOGE("%s: Error flushing file %s.", __FUNCTION__, mPath.c_str());
+        return BAD_VALUE;
+    }
+
+    int fd = ::fileno(mFp);
+    struct iovec batch[IOV_MAX];
+    size_t next = 0;
+    size_t consumed = 0; // Bytes of vectors[next] already written
+    while (next < count) {
+        int batchCount = 0;
+        for (size_t i = next; i < count && batchCount < IOV_MAX; ++i) {
+            size_t skip = (i == next) ? consumed : 0;
+            batch[batchCount].iov_base = static_cast<uint8_t*>(vectors[i].iov_base) + skip;
+            batch[batchCount].iov_len = vectors[i].iov_len - skip;
+            batchCount++;
+        }
+
+        ssize_t written = TEMP_FAILURE_RETRY(::writev(fd, batch, batchCount));
+        if (written < 0) {
+            ALOGE("%s: Error %s (%d) occurred while writing file %s.", __FUNCTION__,
+                    strerror(errno), errno, mPath.c_str());
+            return BAD_VALUE;
+        }
+
+        // Skip past the fully written vectors, the last one may have been written in part
+        size_t remaining = static_cast<size_t>(written);
+        while (next < count && remaining >= vectors[next].iov_len - consumed) {
+            remaining -= vectors[next].iov_len - consumed;
+            consumed = 0;
+            next++;
+        }
+        consumed += remaining;
+    }
+    return OK;
+}
+
 status_t FileOutput::close() {
     if(!mOpen) {
         ALOGW("%s: Close called when file %s already close.", __FUNCTION__, mPath.c_str());
@@ -0,0 +1,333 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define LOG_TAG "LosslessJpegEncoder"
+
+#include <img_utils/LosslessJpegEncoder.h>
+
+#include <utils/Log.h>
+
+#include <utility>
+
+namespace android {
+namespace img_utils {
+
+namespace {
+
+enum {
+    MARKER_SOF3 = 0xC3, // Start of frame, lossless (sequential), Huffman coding
+    MARKER_DHT = 0xC4,
+    MARKER_SOI = 0xD8,
+    MARKER_EOI = 0xD9,
+    MARKER_SOS = 0xDA,
+};
+
+enum {
+    PREDICTOR_LEFT = 1, // Predictor selection value for Ra, the sample to the left
+    NUM_CATEGORIES = 17, // Difference categories (SSSS) 0 through 16
+    MAX_CODE_LENGTH = 16,
+    MAX_JPEG_DIMENSION = 0xFFFF,
+    MAX_JPEG_COMPONENTS = 4,
+};
+
+/**
+ * Accumulates Huffman codes into bytes, stuffing a zero byte after each 0xFF byte.
+ */
+class BitWriter {
+    public:
+        explicit BitWriter(std::vector<uint8_t>* output) : mOutput(output), mBits(0),
+                mCount(0) {}
+
+        // Append the low count bits of value, count being at most 16
+        inline void put(uint32_t value, uint32_t count) {
+            mBits = (mBits << count) | (value & ((1u << count) - 1));
+            mCount += count;
+            while (mCount >= 8) {
+                mCount -= 8;
+                uint8_t byte = static_cast<uint8_t>(mBits >> mCount);
+                mOutput->push_back(byte);
+                if (byte == 0xFF) {
+                    mOutput->push_back(0);
+                }
+            }
+        }
+
+        // Pad the last byte with one bits
+        void flush() {
+            if (mCount > 0) {
+                put(0xFF, 8 - mCount);
+            }
+        }
+
+    private:
+        std::vector<uint8_t>* mOutput;
+        uint64_t mBits;
+        uint32_t mCount;
+};
+
+inline uint32_t getCategory(int32_t diff) {
+    uint32_t magnitude = static_cast<uint32_t>((diff < 0) ? -diff : diff);
+    return (magnitude == 0) ? 0 : 32 - __builtin_clz(magnitude);
+}
+
+inline void writeMarker(std::vector<uint8_t>* output, uint8_t marker) {
+    output->push_back(0xFF);
+    output->push_back(marker);
+}
+
+inline void writeShort(std::vector<uint8_t>* output, uint32_t value) {
+    output->push_back(static_cast<uint8_t>(value >> 8));
+    output->push_back(static_cast<uint8_t>(value));
+}
+
+/**
+ * Build the Huffman table for the given category counts, as per ITU T.81 Annex K.2 and K.3:
+ * code lengths are limited to 16 bits, and no code consists only of one bits.
+ *
+ * Sets the count of codes of each length in lengthCounts (indexed by length), the categories
+ * in order of increasing code length in values, and the code and its length for each
+ * category in codes and codeLengths.
+ */
+void buildHuffmanTable(const uint32_t* counts, uint8_t* lengthCounts, uint8_t* values,
+        uint32_t* valueCount, uint16_t* codes, uint8_t* codeLengths) {
+    // One more symbol than there are categories reserves the all-ones code
+    const int symbolCount = NUM_CATEGORIES + 1;
+    uint64_t frequencies[symbolCount];
+    int sizes[symbolCount];
+    int others[symbolCount];
+    for (int i = 0; i < symbolCount; ++i) {
+        frequencies[i] = (i < NUM_CATEGORIES) ? counts[i] : 1;
+        sizes[i] = 0;
+        others[i] = -1;
+    }
+
+    for (;;) {
+        // Least frequent symbols, the one with the largest value first on ties
+        int v1 = -1;
+        for (int i = 0; i < symbolCount; ++i) {
+            if (frequencies[i] > 0 && (v1 < 0 || frequencies[i] <= frequencies[v1])) {
+                v1 = i;
+            }
+        }
+        int v2 = -1;
+        for (int i = 0; i < symbolCount; ++i) {
+            if (i != v1 && frequencies[i] > 0 &&
+                    (v2 < 0 || frequencies[i] <= frequencies[v2])) {
+                v2 = i;
+            }
+        }
+        if (v2 < 0) {
+            break;
+        }
+
+        frequencies[v1] += frequencies[v2];
+        frequencies[v2] = 0;
+        sizes[v1]++;
+        while (others[v1] >= 0) {
+            v1 = others[v1];
+            sizes[v1]++;
+        }
+        others[v1] = v2;
+        sizes[v2]++;
+        while (others[v2] >= 0) {
+            v2 = others[v2];
+            sizes[v2]++;
+        }
+    }
+
+    // With 18 symbols, no code is longer than 17 bits
+    const int maxSize = symbolCount;
+    int sizeCounts[maxSize + 1] = {0};
+    for (int i = 0; i < symbolCount; ++i) {
+        sizeCounts[sizes[i]]++;
+    }
+    sizeCounts[0] = 0;
+    for (int i = maxSize; i > MAX_CODE_LENGTH; --i) {
+        while (sizeCounts[i] > 0) {
+            int j = i - 2;
+            while (sizeCounts[j] == 0) {
+                j--;
+            }
+            sizeCounts[i] -= 2;
+            sizeCounts[i - 1]++;
+            sizeCounts[j + 1] += 2;
+            sizeCounts[j]--;
+        }
+    }
+    // Drop the reserved code, which is one of the longest
+    int longest = MAX_CODE_LENGTH;
+    while (sizeCounts[longest] == 0) {
+        longest--;
+    }
+    sizeCounts[longest]--;
+
+    *valueCount = 0;
+    for (int size = 1; size <= maxSize; ++size) {
+        for (int i = 0; i < NUM_CATEGORIES; ++i) {
+            if (sizes[i] == size) {
+                values[(*valueCount)++] = static_cast<uint8_t>(i);
+            }
+        }
+    }
+
+    // Assign the codes in order, as per ITU T.81 Annex C
+    uint32_t code = 0;
+    uint32_t k = 0;
+    for (int length = 1; length <= MAX_CODE_LENGTH; ++length) {
+        lengthCounts[length] = static_cast<uint8_t>(sizeCounts[length]);
+        for (int n = 0; n < sizeCounts[length]; ++n) {
+            codes[values[k]] = static_cast<uint16_t>(code++);
+            codeLengths[values[k]] = static_cast<uint8_t>(length);
+            k++;
+        }
+        code <<= 1;
+    }
+}
+
+inline void readSamples(const uint8_t* row, uint32_t count, uint32_t bytesPerSample,
+        Endianness end, uint16_t* samples) {
+    if (bytesPerSample == 1) {
+        for (uint32_t i = 0; i < count; ++i) {
+            samples[i] = row[i];
+        }
+    } else if (end == BIG) {
+        for (uint32_t i = 0; i < count; ++i) {
+            samples[i] = static_cast<uint16_t>((row[2 * i] << 8) | row[2 * i + 1]);
+        }
+    } else {
+        for (uint32_t i = 0; i < count; ++i) {
+            samples[i] = static_cast<uint16_t>(row[2 * i] | (row[2 * i + 1] << 8));
+        }
+    }
+}
+
+} // anonymous namespace
+
+status_t LosslessJpegEncoder::encode(const uint8_t* const* rows, uint32_t width,
+        uint32_t height, uint32_t samplesPerPixel, uint32_t bitsPerSample, Endianness end,
+        /*out*/std::vector<uint8_t>* output) {
+    if (bitsPerSample != 8 && bitsPerSample != 16) {
+        ALOGE("%s: Unsupported BitsPerSample %u.", __FUNCTION__, bitsPerSample);
+        return BAD_VALUE;
+    }
+    if (end != BIG && end != LITTLE) {
+        ALOGE("%s: Endianness must be set.", __FUNCTION__);
+        return BAD_VALUE;
+    }
+
+    const uint32_t components = (samplesPerPixel == 1 && (width % 2) == 0) ? 2 :
+            samplesPerPixel;
+    if (width == 0 || height == 0 || components == 0 || components > MAX_JPEG_COMPONENTS ||
+            static_cast<uint64_t>(width) * samplesPerPixel / components > MAX_JPEG_DIMENSION ||
+            height > MAX_JPEG_DIMENSION) {
+        ALOGE("%s: Invalid dimensions %ux%u with %u samples per pixel.", __FUNCTION__, width,
+                height, samplesPerPixel);
+        return BAD_VALUE;
+    }
+    const uint32_t samplesPerRow = width * samplesPerPixel;
+    const uint32_t frameWidth = samplesPerRow / components;
+    const uint32_t bytesPerSample = bitsPerSample / 8;
+
+    // Compute the differences first, to build Huffman tables suited to this image
+    std::vector<uint16_t> previous(samplesPerRow);
+    std::vector<uint16_t> current(samplesPerRow);
+    std::vector<int32_t> diffs(static_cast<size_t>(samplesPerRow) * height);
+    uint32_t counts[NUM_CATEGORIES] = {0};
+    const int32_t initialPrediction = 1 << (bitsPerSample - 1);
+    size_t index = 0;
+    for (uint32_t row = 0; row < height; ++row) {
+        readSamples(rows[row], samplesPerRow, bytesPerSample, end, current.data());
+        for (uint32_t i = 0; i < samplesPerRow; ++i) {
+            int32_t prediction;
+            if (i < components) {
+                // First column, predicted from the sample above
+                prediction = (row == 0) ? initialPrediction : previous[i];
+            } else {
+                prediction = current[i - components];
+            }
+            int32_t diff = static_cast<int32_t>(current[i]) - prediction;
+            // Differences are computed modulo 2^16
+            if (diff < -32768) {
+                diff += 65536;
+            } else if (diff > 32767) {
+                diff -= 65536;
+            }
+            diffs[index++] = diff;
+            counts[getCategory(diff)]++;
+        }
+        std::swap(previous, current);
+    }
+
+    uint8_t lengthCounts[MAX_CODE_LENGTH + 1] = {0};
+    uint8_t values[NUM_CATEGORIES];
+    uint32_t valueCount = 0;
+    uint16_t codes[NUM_CATEGORIES] = {0};
+    uint8_t codeLengths[NUM_CATEGORIES] = {0};
+    buildHuffmanTable(counts, lengthCounts, values, &valueCount, codes, codeLengths);
+
+    output->clear();
+    output->reserve(diffs.size() * bytesPerSample / 2 + 128);
+
+    writeMarker(output, MARKER_SOI);
+
+    writeMarker(output, MARKER_DHT);
+    writeShort(output, 2 + 1 + MAX_CODE_LENGTH + valueCount);
+    output->push_back(0); // DC table 0
+    output->insert(output->end(), lengthCounts + 1, lengthCounts + 1 + MAX_CODE_LENGTH);
+    output->insert(output->end(), values, values + valueCount);
+
+    writeMarker(output, MARKER_SOF3);
+    writeShort(output, 8 + 3 * components);
+    output->push_back(static_cast<uint8_t>(bitsPerSample));
+    writeShort(output, height);
+    writeShort(output, frameWidth);
+    output->push_back(static_cast<uint8_t>(components));
+    for (uint32_t c = 0; c < components; ++c) {
+        output->push_back(static_cast<uint8_t>(c)); // Component identifier
+        output->push_back(0x11); // No subsampling
+        output->push_back(0); // No quantization in lossless mode
+    }
+
+    writeMarker(output, MARKER_SOS);
+    writeShort(output, 6 + 2 * components);
+    output->push_back(static_cast<uint8_t>(components));
+    for (uint32_t c = 0; c < components; ++c) {
+        output->push_back(static_cast<uint8_t>(c));
+        output->push_back(0); // All components share table 0
+    }
+    output->push_back(PREDICTOR_LEFT);
+    output->push_back(0); // End of spectral selection, unused
+    output->push_back(0); // No point transform
+
+    BitWriter writer(output);
+    for (int32_t diff : diffs) {
+        uint32_t category = getCategory(diff);
+        writer.put(codes[category], codeLengths[category]);
+        // Differences of 32768 have no additional bits
+        if (category > 0 && category < MAX_CODE_LENGTH) {
+            writer.put(static_cast<uint32_t>((diff < 0) ? diff + (1 << category) - 1 : diff),
+                    category);
+        }
+    }
+    writer.flush();
+
+    writeMarker(output, MARKER_EOI);
+    return OK;
+}
+
+} /*namespace img_utils*/
+} /*namespace android*/
@@ -24,5 +24,16 @@ Output::~Output() {}
 status_t Output::open() { return OK; }
 status_t Output::close() { return OK; }
 
+status_t Output::writeVectors(const struct iovec* vectors, size_t count) {
+    status_t ret = OK;
+    for (size_t i = 0; i < count; ++i) {
+        if ((ret = write(static_cast<const uint8_t*>(vectors[i].iov_base), 0,
+                vectors[i].iov_len)) != OK) {
+            return ret;
+        }
+    }
+    return ret;
+}
+
 } /*namespace img_utils*/
 } /*namespace android*/
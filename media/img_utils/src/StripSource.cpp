@@ -21,5 +21,10 @@ namespace img_utils {
 
 StripSource::~StripSource() {}
 
+status_t StripSource::getStripVectors(uint32_t /*count*/,
+        /*out*/Vector<struct iovec>* /*vectors*/) {
+    return INVALID_OPERATION;
+}
+
 } /*namespace img_utils*/
 } /*namespace android*/
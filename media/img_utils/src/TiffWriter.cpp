@@ -16,11 +16,19 @@
 
 #define LOG_TAG "TiffWriter"
 
+#include <img_utils/ByteArrayOutput.h>
+#include <img_utils/LosslessJpegEncoder.h>
 #include <img_utils/TiffHelpers.h>
 #include <img_utils/TiffWriter.h>
 #include <img_utils/TagDefinitions.h>
 
 #include <assert.h>
+#include <inttypes.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <thread>
 
 namespace android {
 namespace img_utils {
@@ -56,6 +64,15 @@ TiffWriter::TiffWriter(KeyedVector<uint16_t, const TagDefinition_t*>* enabledDef
 
 TiffWriter::~TiffWriter() {}
 
+static StripSource* findSource(StripSource** sources, size_t sourcesCount, uint32_t ifd) {
+    for (size_t i = 0; i < sourcesCount; ++i) {
+        if (sources[i]->getIfd() == ifd) {
+            return sources[i];
+        }
+    }
+    return NULL;
+}
+
 status_t TiffWriter::write(Output* out, StripSource** sources, size_t sourcesCount,
         Endianness end) {
     status_t ret = OK;
@@ -66,6 +83,26 @@ status_t TiffWriter::write(Output* out, StripSource** sources, size_t sourcesCou
         return BAD_VALUE;
     }
 
+    // Compress strips first, their sizes determine the offsets
+    std::map<uint32_t, std::vector<std::vector<uint8_t> > > compressedStrips;
+    for (size_t i = 0; i < mCompressionThreads.size(); ++i) {
+        uint32_t ifdKey = mCompressionThreads.keyAt(i);
+        ssize_t index = mNamedIfds.indexOfKey(ifdKey);
+        if (index < 0 || !mNamedIfds[index]->uninitializedOffsets()) {
+            continue;
+        }
+        StripSource* source = findSource(sources, sourcesCount, ifdKey);
+        if (source == NULL) {
+            ALOGE("%s: No stream for byte strips for IFD %u", __FUNCTION__, ifdKey);
+            return BAD_VALUE;
+        }
+        if ((ret = compressStrips(mNamedIfds[index], source, end,
+                mCompressionThreads.valueAt(i), &compressedStrips[ifdKey])) != OK) {
+            ALOGE("%s: Could not compress strips for IFD %u", __FUNCTION__, ifdKey);
+            return ret;
+        }
+    }
+
     uint32_t totalSize = getTotalSize();
 
     KeyedVector<uint32_t, uint32_t> offsetVector;
@@ -104,25 +141,34 @@ status_t TiffWriter::write(Output* out, StripSource** sources, size_t sourcesCou
         log();
     }
 
+    Vector<struct iovec> vectors;
     for (size_t i = 0; i < offVecSize; ++i) {
         uint32_t ifdKey = offsetVector.keyAt(i);
-        uint32_t sizeToWrite = mNamedIfds[ifdKey]->getStripSize();
-        bool found = false;
-        for (size_t j = 0; j < sourcesCount; ++j) {
-            if (sources[j]->getIfd() == ifdKey) {
-                if ((ret = sources[i]->writeToStream(endOut, sizeToWrite)) != OK) {
-                    ALOGE("%s: Could not write to stream, received %d.", __FUNCTION__, ret);
-                    return ret;
-                }
-                ZERO_TILL_WORD(&endOut, sizeToWrite, ret);
-                found = true;
-                break;
-            }
-        }
-        if (!found) {
+        uint32_t sizeToWrite = mNamedIfds.valueFor(ifdKey)->getStripSize();
+        StripSource* source = findSource(sources, sourcesCount, ifdKey);
+        if (source == NULL) {
             ALOGE("%s: No stream for byte strips for IFD %u", __FUNCTION__, ifdKey);
             return BAD_VALUE;
         }
+
+        auto compressed = compressedStrips.find(ifdKey);
+        if (compressed != compressedStrips.end()) {
+            vectors.clear();
+            for (auto& strip : compressed->second) {
+                struct iovec stripVector = { strip.data(), strip.size() };
+                vectors.add(stripVector);
+            }
+            ret = endOut.writeVectors(vectors.array(), vectors.size());
+        } else if ((ret = source->getStripVectors(sizeToWrite, &vectors)) == OK) {
+            ret = endOut.writeVectors(vectors.array(), vectors.size());
+        } else if (ret == INVALID_OPERATION) {
+            ret = source->writeToStream(endOut, sizeToWrite);
+        }
+        if (ret != OK) {
+            ALOGE("%s: Could not write to stream, received %d.", __FUNCTION__, ret);
+            return ret;
+        }
+        ZERO_TILL_WORD(&endOut, sizeToWrite, ret);
         assert(offsetVector[i] == endOut.getCurrentOffset());
     }
 
@@ -214,6 +260,145 @@ status_t TiffWriter::addStrip(uint32_t ifd) {
     return selected->validateAndSetStripTags();
 }
 
+status_t TiffWriter::setStripCompression(uint32_t ifd, uint16_t compression,
+        uint32_t threadCount) {
+    ssize_t index = mNamedIfds.indexOfKey(ifd);
+    if (index < 0 || !mNamedIfds[index]->uninitializedOffsets()) {
+        ALOGE("%s: Ifd %u doesn't exist or has no strips.", __FUNCTION__, ifd);
+        return BAD_VALUE;
+    }
+
+    if (compression == TAG_COMPRESSION_LOSSLESS_JPEG) {
+        sp<TiffEntry> bitsEntry = mNamedIfds[index]->getEntry(TAG_BITSPERSAMPLE);
+        uint16_t bitsPerSample = (bitsEntry != NULL) ? *(bitsEntry->getData<uint16_t>()) : 0;
+        if (bitsPerSample != 8 && bitsPerSample != 16) {
+            ALOGE("%s: Lossless JPEG compression not supported for BitsPerSample %u.",
+                    __FUNCTION__, bitsPerSample);
+            return BAD_VALUE;
+        }
+        mCompressionThreads.add(ifd, std::max(threadCount, 1u));
+    } else if (compression == TAG_COMPRESSION_NONE) {
+        mCompressionThreads.removeItem(ifd);
+    } else {
+        ALOGE("%s: Unsupported compression %u.", __FUNCTION__, compression);
+        return BAD_VALUE;
+    }
+
+    return addEntry(TAG_COMPRESSION, 1, &compression, ifd);
+}
+
+status_t TiffWriter::compressStrips(const sp<TiffIfd>& ifd, StripSource* source,
+        Endianness end, uint32_t threadCount,
+        /*out*/std::vector<std::vector<uint8_t> >* strips) {
+    sp<TiffEntry> widthEntry = ifd->getEntry(TAG_IMAGEWIDTH);
+    sp<TiffEntry> heightEntry = ifd->getEntry(TAG_IMAGELENGTH);
+    sp<TiffEntry> samplesEntry = ifd->getEntry(TAG_SAMPLESPERPIXEL);
+    sp<TiffEntry> bitsEntry = ifd->getEntry(TAG_BITSPERSAMPLE);
+    sp<TiffEntry> rowsPerStripEntry = ifd->getEntry(TAG_ROWSPERSTRIP);
+    sp<TiffEntry> byteCountsEntry = ifd->getEntry(TAG_STRIPBYTECOUNTS);
+    if (widthEntry == NULL || heightEntry == NULL || samplesEntry == NULL ||
+            bitsEntry == NULL || rowsPerStripEntry == NULL || byteCountsEntry == NULL) {
+        ALOGE("%s: IFD %u is missing image or strip tags.", __FUNCTION__, ifd->getId());
+        return BAD_VALUE;
+    }
+
+    const uint32_t width = *(widthEntry->getData<uint32_t>());
+    const uint32_t height = *(heightEntry->getData<uint32_t>());
+    const uint32_t samplesPerPixel = *(samplesEntry->getData<uint16_t>());
+    const uint32_t bitsPerSample = *(bitsEntry->getData<uint16_t>());
+    const uint32_t rowsPerStrip = *(rowsPerStripEntry->getData<uint32_t>());
+    const uint32_t rowSize = width * samplesPerPixel * (bitsPerSample / 8);
+    const uint64_t imageSize = static_cast<uint64_t>(rowSize) * height;
+    const uint32_t stripCount = byteCountsEntry->getCount();
+    if (rowsPerStrip == 0 || imageSize > UINT32_MAX ||
+            stripCount != (height + rowsPerStrip - 1) / rowsPerStrip) {
+        ALOGE("%s: Invalid strip layout in IFD %u.", __FUNCTION__, ifd->getId());
+        return BAD_VALUE;
+    }
+
+    // Read rows in place when the source holds them in memory
+    Vector<const uint8_t*> rows;
+    rows.setCapacity(height);
+    Vector<struct iovec> vectors;
+    if (source->getStripVectors(static_cast<uint32_t>(imageSize), &vectors) == OK) {
+        for (size_t i = 0; i < vectors.size(); ++i) {
+            const uint8_t* base = static_cast<const uint8_t*>(vectors[i].iov_base);
+            if ((vectors[i].iov_len % rowSize) != 0) {
+                rows.clear();
+                break;
+            }
+            for (size_t offset = 0; offset < vectors[i].iov_len; offset += rowSize) {
+                rows.add(base + offset);
+            }
+        }
+    }
+
+    ByteArrayOutput staging;
+    if (rows.size() != height) {
+        status_t ret = OK;
+        rows.clear();
+        BAIL_ON_FAIL(staging.open(), ret);
+        BAIL_ON_FAIL(source->writeToStream(staging, static_cast<uint32_t>(imageSize)), ret);
+        if (staging.getSize() != imageSize) {
+            ALOGE("%s: Source for IFD %u wrote %zu bytes, expected %" PRIu64 ".", __FUNCTION__,
+                    ifd->getId(), staging.getSize(), imageSize);
+            return BAD_VALUE;
+        }
+        for (uint32_t row = 0; row < height; ++row) {
+            rows.add(staging.getArray() + static_cast<size_t>(row) * rowSize);
+        }
+    }
+
+    strips->clear();
+    strips->resize(stripCount);
+    std::atomic<uint32_t> nextStrip{0};
+    std::atomic<status_t> result{OK};
+    auto encodeStrips = [&]() {
+        uint32_t strip;
+        while (result.load() == OK && (strip = nextStrip++) < stripCount) {
+            uint32_t firstRow = strip * rowsPerStrip;
+            uint32_t stripRows = std::min(rowsPerStrip, height - firstRow);
+            status_t res = LosslessJpegEncoder::encode(rows.array() + firstRow, width,
+                    stripRows, samplesPerPixel, bitsPerSample, end, &(*strips)[strip]);
+            if (res != OK) {
+                result = res;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    uint32_t workerCount = std::min(threadCount, stripCount);
+    for (uint32_t i = 1; i < workerCount; ++i) {
+        workers.emplace_back(encodeStrips);
+    }
+    encodeStrips();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if (result.load() != OK) {
+        return result.load();
+    }
+
+    Vector<uint32_t> byteCounts;
+    uint64_t totalSize = 0;
+    for (const auto& strip : *strips) {
+        byteCounts.add(static_cast<uint32_t>(strip.size()));
+        totalSize += strip.size();
+    }
+    if (totalSize > UINT32_MAX) {
+        ALOGE("%s: Compressed strips of IFD %u are too large.", __FUNCTION__, ifd->getId());
+        return BAD_VALUE;
+    }
+
+    sp<TiffEntry> stripByteCounts = uncheckedBuildEntry(TAG_STRIPBYTECOUNTS, LONG, stripCount,
+            UNDEFINED_ENDIAN, byteCounts.array());
+    if (stripByteCounts == NULL || ifd->addEntry(stripByteCounts) != OK) {
+        ALOGE("%s: Could not update StripByteCounts in IFD %u.", __FUNCTION__, ifd->getId());
+        return BAD_VALUE;
+    }
+    return OK;
+}
+
 status_t TiffWriter::addIfd(uint32_t ifd) {
     ssize_t index = mNamedIfds.indexOfKey(ifd);
     if (index >= 0) {
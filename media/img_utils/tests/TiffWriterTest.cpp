@@ -0,0 +1,495 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "TiffWriterTest"
+
+#include <img_utils/BufferStripSource.h>
+#include <img_utils/ByteArrayOutput.h>
+#include <img_utils/FileOutput.h>
+#include <img_utils/LosslessJpegEncoder.h>
+#include <img_utils/TagDefinitions.h>
+#include <img_utils/TiffHelpers.h>
+#include <img_utils/TiffWriter.h>
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+#include <utils/Errors.h>
+#include <utils/StrongPointer.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace android;
+using namespace android::img_utils;
+
+namespace {
+
+// Strip tags of a little endian TIFF file with a single IFD
+struct TiffImage {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t bitsPerSample = 0;
+    uint32_t samplesPerPixel = 0;
+    uint32_t compression = 0;
+    uint32_t rowsPerStrip = 0;
+    std::vector<uint32_t> stripOffsets;
+    std::vector<uint32_t> stripByteCounts;
+};
+
+uint32_t readLe(const uint8_t* data, size_t size) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < size; ++i) {
+        value |= static_cast<uint32_t>(data[i]) << (8 * i);
+    }
+    return value;
+}
+
+bool parseTiff(const std::vector<uint8_t>& file, TiffImage* image) {
+    if (file.size() < FILE_HEADER_SIZE || readLe(file.data(), 2) != LITTLE_ENDIAN_MARKER ||
+            readLe(file.data() + 2, 2) != TIFF_FILE_MARKER) {
+        return false;
+    }
+    uint32_t ifdOffset = readLe(file.data() + 4, 4);
+    if (ifdOffset + IFD_HEADER_SIZE > file.size()) return false;
+    uint32_t entryCount = readLe(file.data() + ifdOffset, 2);
+    if (ifdOffset + calculateIfdSize(entryCount) > file.size()) return false;
+
+    for (uint32_t i = 0; i < entryCount; ++i) {
+        const uint8_t* entry = file.data() + ifdOffset + IFD_HEADER_SIZE + i * TIFF_ENTRY_SIZE;
+        uint16_t tag = readLe(entry, 2);
+        size_t typeSize = getTypeSize(static_cast<TagType>(readLe(entry + 2, 2)));
+        uint32_t count = readLe(entry + 4, 4);
+        const uint8_t* values = entry + 8;
+        if (typeSize * count > OFFSET_SIZE) {
+            uint32_t valuesOffset = readLe(entry + 8, 4);
+            if (valuesOffset + typeSize * count > file.size()) return false;
+            values = file.data() + valuesOffset;
+        }
+        std::vector<uint32_t> array(count);
+        for (uint32_t j = 0; j < count; ++j) {
+            array[j] = readLe(values + j * typeSize, typeSize);
+        }
+        switch (tag) {
+            case TAG_IMAGEWIDTH: image->width = array[0]; break;
+            case TAG_IMAGELENGTH: image->height = array[0]; break;
+            case TAG_BITSPERSAMPLE: image->bitsPerSample = array[0]; break;
+            case TAG_SAMPLESPERPIXEL: image->samplesPerPixel = array[0]; break;
+            case TAG_COMPRESSION: image->compression = array[0]; break;
+            case TAG_ROWSPERSTRIP: image->rowsPerStrip = array[0]; break;
+            case TAG_STRIPOFFSETS: image->stripOffsets = array; break;
+            case TAG_STRIPBYTECOUNTS: image->stripByteCounts = array; break;
+        }
+    }
+    if (image->stripOffsets.size() != image->stripByteCounts.size()) return false;
+    for (size_t i = 0; i < image->stripOffsets.size(); ++i) {
+        if (static_cast<uint64_t>(image->stripOffsets[i]) + image->stripByteCounts[i] >
+                file.size()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Reads the entropy coded segment of a JPEG stream, removing stuffed bytes
+class BitReader {
+  public:
+    BitReader(const uint8_t* data, size_t size) : mData(data), mSize(size) {}
+
+    bool read(uint32_t count, uint32_t* value) {
+        *value = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            if (mBit == 0) {
+                if (mPos >= mSize) return false;
+                mByte = mData[mPos++];
+                if (mByte == 0xFF) {
+                    if (mPos >= mSize || mData[mPos] != 0) return false;
+                    mPos++;
+                }
+                mBit = 8;
+            }
+            mBit--;
+            *value = (*value << 1) | ((mByte >> mBit) & 1);
+        }
+        return true;
+    }
+
+  private:
+    const uint8_t* mData;
+    size_t mSize;
+    size_t mPos = 0;
+    uint8_t mByte = 0;
+    uint32_t mBit = 0;
+};
+
+struct DecodedJpeg {
+    uint32_t precision = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t components = 0;
+    // Interleaved samples of each row
+    std::vector<uint16_t> samples;
+};
+
+// Decoder for the lossless JPEG streams written by LosslessJpegEncoder: a single Huffman table,
+// and the first predictor
+bool decodeLosslessJpeg(const uint8_t* data, size_t size, DecodedJpeg* image) {
+    if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) return false;
+    uint8_t lengthCounts[17] = {0};
+    std::vector<uint8_t> values;
+    size_t pos = 2;
+    for (;;) {
+        if (pos + 4 > size || data[pos] != 0xFF) return false;
+        uint8_t marker = data[pos + 1];
+        uint32_t length = (data[pos + 2] << 8) | data[pos + 3];
+        const uint8_t* segment = data + pos + 4;
+        if (pos + 2 + length > size) return false;
+        pos += 2 + length;
+        if (marker == 0xC4) {
+            if (segment[0] != 0) return false;
+            size_t valueCount = 0;
+            for (int i = 1; i <= 16; ++i) {
+                lengthCounts[i] = segment[i];
+                valueCount += segment[i];
+            }
+            values.assign(segment + 17, segment + 17 + valueCount);
+        } else if (marker == 0xC3) {
+            image->precision = segment[0];
+            image->height = (segment[1] << 8) | segment[2];
+            image->width = (segment[3] << 8) | segment[4];
+            image->components = segment[5];
+        } else if (marker == 0xDA) {
+            uint32_t scanComponents = segment[0];
+            if (scanComponents != image->components || segment[1 + 2 * scanComponents] != 1) {
+                return false;
+            }
+            break;
+        } else {
+            return false;
+        }
+    }
+
+    const uint32_t samplesPerRow = image->width * image->components;
+    image->samples.resize(static_cast<size_t>(samplesPerRow) * image->height);
+    BitReader reader(data + pos, size - pos);
+    for (uint32_t row = 0; row < image->height; ++row) {
+        uint16_t* current = image->samples.data() + static_cast<size_t>(row) * samplesPerRow;
+        for (uint32_t i = 0; i < samplesPerRow; ++i) {
+            // Canonical Huffman decoding
+            uint32_t code = 0, first = 0, index = 0, bit;
+            int category = -1;
+            for (int length = 1; length <= 16 && category < 0; ++length) {
+                if (!reader.read(1, &bit)) return false;
+                code = (code << 1) | bit;
+                if (code - first < lengthCounts[length]) {
+                    category = values[index + code - first];
+                }
+                index += lengthCounts[length];
+                first = (first + lengthCounts[length]) << 1;
+            }
+            if (category < 0) return false;
+
+            int32_t diff = 0;
+            if (category == 16) {
+                diff = 32768;
+            } else if (category > 0) {
+                uint32_t extra;
+                if (!reader.read(category, &extra)) return false;
+                diff = (extra < (1u << (category - 1))) ?
+                        static_cast<int32_t>(extra) - (1 << category) + 1 :
+                        static_cast<int32_t>(extra);
+            }
+
+            int32_t prediction;
+            if (i < image->components) {
+                prediction = (row == 0) ? 1 << (image->precision - 1) :
+                        *(current - samplesPerRow + i);
+            } else {
+                prediction = current[i - image->components];
+            }
+            current[i] = static_cast<uint16_t>((prediction + diff) & 0xFFFF);
+        }
+    }
+    return true;
+}
+
+// Synthetic RGGB Bayer frame with 10 bit samples: smooth color gradients plus noise
+std::vector<uint16_t> makeBayerFrame(uint32_t width, uint32_t height) {
+    std::vector<uint16_t> frame(static_cast<size_t>(width) * height);
+    std::mt19937 random(42);
+    std::normal_distribution<float> noise(0.f, 4.f);
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            int channel = (y % 2) * 2 + (x % 2);
+            float base = 64.f + 200.f * channel + 300.f * x / width + 200.f * y / height;
+            int value = static_cast<int>(base + noise(random));
+            frame[static_cast<size_t>(y) * width + x] =
+                    static_cast<uint16_t>(std::min(std::max(value, 0), 1023));
+        }
+    }
+    return frame;
+}
+
+// StripSource that only writes through the stream, one row at a time
+class RowStripSource : public StripSource {
+  public:
+    RowStripSource(const uint8_t* pixels, uint32_t rowSize, uint32_t height) :
+            mPixels(pixels), mRowSize(rowSize), mHeight(height) {}
+
+    status_t writeToStream(Output& stream, uint32_t count) override {
+        if (count != mRowSize * mHeight) return BAD_VALUE;
+        for (uint32_t row = 0; row < mHeight; ++row) {
+            status_t ret = stream.write(mPixels, row * mRowSize, mRowSize);
+            if (ret != OK) return ret;
+        }
+        return OK;
+    }
+
+    uint32_t getIfd() const override { return 0; }
+
+  private:
+    const uint8_t* mPixels;
+    uint32_t mRowSize;
+    uint32_t mHeight;
+};
+
+sp<TiffWriter> makeWriter(uint32_t width, uint32_t height, uint16_t compression,
+        uint32_t threadCount) {
+    sp<TiffWriter> writer = new TiffWriter();
+    const uint16_t bitsPerSample = 16;
+    const uint16_t samplesPerPixel = 1;
+    const uint16_t photometric = 32803; // CFA
+    const uint16_t uncompressed = TAG_COMPRESSION_NONE;
+    if (writer->addIfd(0) != OK ||
+            writer->addEntry(TAG_IMAGEWIDTH, 1, &width, 0) != OK ||
+            writer->addEntry(TAG_IMAGELENGTH, 1, &height, 0) != OK ||
+            writer->addEntry(TAG_BITSPERSAMPLE, 1, &bitsPerSample, 0) != OK ||
+            writer->addEntry(TAG_SAMPLESPERPIXEL, 1, &samplesPerPixel, 0) != OK ||
+            writer->addEntry(TAG_PHOTOMETRICINTERPRETATION, 1, &photometric, 0) != OK ||
+            writer->addEntry(TAG_COMPRESSION, 1, &uncompressed, 0) != OK ||
+            writer->addStrip(0) != OK) {
+        return nullptr;
+    }
+    if (compression != TAG_COMPRESSION_NONE &&
+            writer->setStripCompression(0, compression, threadCount) != OK) {
+        return nullptr;
+    }
+    return writer;
+}
+
+std::vector<uint8_t> writeToArray(const sp<TiffWriter>& writer, StripSource* source) {
+    ByteArrayOutput out;
+    StripSource* sources[] = { source };
+    if (out.open() != OK || writer->write(&out, sources, 1) != OK || out.close() != OK) {
+        return {};
+    }
+    return std::vector<uint8_t>(out.getArray(), out.getArray() + out.getSize());
+}
+
+std::vector<uint8_t> readStrips(const std::vector<uint8_t>& file, const TiffImage& image) {
+    std::vector<uint8_t> strips;
+    for (size_t i = 0; i < image.stripOffsets.size(); ++i) {
+        strips.insert(strips.end(), file.begin() + image.stripOffsets[i],
+                file.begin() + image.stripOffsets[i] + image.stripByteCounts[i]);
+    }
+    return strips;
+}
+
+} // namespace
+
+TEST(TiffWriterTest, StripsWrittenFromBuffer) {
+    const uint32_t width = 640, height = 480;
+    const uint32_t rowSize = width * sizeof(uint16_t);
+    const uint32_t rowStride = rowSize + 64;
+    std::vector<uint16_t> frame = makeBayerFrame(width, height);
+
+    // Padded rows, written one vector per row
+    std::vector<uint8_t> padded(static_cast<size_t>(rowStride) * height, 0xAB);
+    for (uint32_t row = 0; row < height; ++row) {
+        memcpy(padded.data() + row * rowStride, frame.data() + row * width, rowSize);
+    }
+    BufferStripSource paddedSource(padded.data(), 0, width, height, sizeof(uint16_t),
+            rowStride, sizeof(uint16_t), 1);
+    Vector<struct iovec> vectors;
+    ASSERT_EQ(OK, paddedSource.getStripVectors(rowSize * height, &vectors));
+    EXPECT_EQ(height, vectors.size());
+
+    sp<TiffWriter> writer = makeWriter(width, height, TAG_COMPRESSION_NONE, 1);
+    ASSERT_NE(nullptr, writer.get());
+    std::vector<uint8_t> file = writeToArray(writer, &paddedSource);
+    TiffImage image;
+    ASSERT_TRUE(parseTiff(file, &image));
+    EXPECT_EQ(static_cast<uint32_t>(TAG_COMPRESSION_NONE), image.compression);
+    std::vector<uint8_t> strips = readStrips(file, image);
+    ASSERT_EQ(static_cast<size_t>(rowSize) * height, strips.size());
+    EXPECT_EQ(0, memcmp(frame.data(), strips.data(), strips.size()));
+
+    // Same file as when written through the stream
+    RowStripSource rowSource(reinterpret_cast<const uint8_t*>(frame.data()), rowSize, height);
+    writer = makeWriter(width, height, TAG_COMPRESSION_NONE, 1);
+    ASSERT_NE(nullptr, writer.get());
+    EXPECT_EQ(file, writeToArray(writer, &rowSource));
+
+    // Pixels that aren't contiguous are gathered through the stream
+    std::vector<uint16_t> sparse(static_cast<size_t>(width) * height * 2);
+    for (size_t i = 0; i < frame.size(); ++i) {
+        sparse[2 * i] = frame[i];
+    }
+    BufferStripSource sparseSource(reinterpret_cast<const uint8_t*>(sparse.data()), 0, width,
+            height, 2 * sizeof(uint16_t), 2 * rowSize, sizeof(uint16_t), 1);
+    EXPECT_EQ(INVALID_OPERATION, sparseSource.getStripVectors(rowSize * height, &vectors));
+    writer = makeWriter(width, height, TAG_COMPRESSION_NONE, 1);
+    ASSERT_NE(nullptr, writer.get());
+    EXPECT_EQ(file, writeToArray(writer, &sparseSource));
+}
+
+TEST(TiffWriterTest, VectoredFileOutput) {
+    const uint32_t width = 1000, height = 750;
+    std::vector<uint16_t> frame = makeBayerFrame(width, height);
+    BufferStripSource source(reinterpret_cast<const uint8_t*>(frame.data()), 0, width, height,
+            sizeof(uint16_t), width * sizeof(uint16_t), sizeof(uint16_t), 1);
+
+    sp<TiffWriter> writer = makeWriter(width, height, TAG_COMPRESSION_NONE, 1);
+    ASSERT_NE(nullptr, writer.get());
+    std::vector<uint8_t> expected = writeToArray(writer, &source);
+    ASSERT_FALSE(expected.empty());
+
+    TemporaryDir dir;
+    String8 path = String8(dir.path) + String8("/vectored.dng");
+    FileOutput out(path);
+    StripSource* sources[] = { &source };
+    writer = makeWriter(width, height, TAG_COMPRESSION_NONE, 1);
+    ASSERT_NE(nullptr, writer.get());
+    ASSERT_EQ(OK, out.open());
+    ASSERT_EQ(OK, writer->write(&out, sources, 1));
+    // Bytes written after the strips go after them in the file
+    const uint8_t trailer[] = { 1, 2, 3, 4 };
+    ASSERT_EQ(OK, out.write(trailer, 0, sizeof(trailer)));
+    ASSERT_EQ(OK, out.close());
+
+    std::string contents;
+    ASSERT_TRUE(android::base::ReadFileToString(path.c_str(), &contents));
+    expected.insert(expected.end(), trailer, trailer + sizeof(trailer));
+    ASSERT_EQ(expected.size(), contents.size());
+    EXPECT_EQ(0, memcmp(expected.data(), contents.data(), expected.size()));
+}
+
+TEST(TiffWriterTest, LosslessJpegRoundTrip) {
+    const uint32_t width = 1024, height = 768;
+    std::vector<uint16_t> frame = makeBayerFrame(width, height);
+    BufferStripSource source(reinterpret_cast<const uint8_t*>(frame.data()), 0, width, height,
+            sizeof(uint16_t), width * sizeof(uint16_t), sizeof(uint16_t), 1);
+
+    sp<TiffWriter> writer = makeWriter(width, height, TAG_COMPRESSION_LOSSLESS_JPEG, 4);
+    ASSERT_NE(nullptr, writer.get());
+    std::vector<uint8_t> file = writeToArray(writer, &source);
+    TiffImage image;
+    ASSERT_TRUE(parseTiff(file, &image));
+    EXPECT_EQ(static_cast<uint32_t>(TAG_COMPRESSION_LOSSLESS_JPEG), image.compression);
+    ASSERT_GT(image.rowsPerStrip, 0u);
+    ASSERT_EQ((height + image.rowsPerStrip - 1) / image.rowsPerStrip,
+            image.stripOffsets.size());
+
+    size_t compressedSize = 0;
+    for (size_t i = 0; i < image.stripOffsets.size(); ++i) {
+        DecodedJpeg strip;
+        ASSERT_TRUE(decodeLosslessJpeg(file.data() + image.stripOffsets[i],
+                image.stripByteCounts[i], &strip)) << "strip " << i;
+        EXPECT_EQ(16u, strip.precision);
+        // Bayer rows are encoded as two interleaved components
+        EXPECT_EQ(2u, strip.components);
+        ASSERT_EQ(width, strip.width * strip.components);
+        uint32_t firstRow = i * image.rowsPerStrip;
+        ASSERT_EQ(std::min(image.rowsPerStrip, height - firstRow), strip.height);
+        EXPECT_EQ(0, memcmp(frame.data() + static_cast<size_t>(firstRow) * width,
+                strip.samples.data(), strip.samples.size() * sizeof(uint16_t)))
+                << "strip " << i;
+        compressedSize += image.stripByteCounts[i];
+    }
+    EXPECT_LT(compressedSize, frame.size() * sizeof(uint16_t) / 2);
+
+    // The output doesn't depend on the number of threads, nor on how the source is read
+    RowStripSource rowSource(reinterpret_cast<const uint8_t*>(frame.data()),
+            width * sizeof(uint16_t), height);
+    writer = makeWriter(width, height, TAG_COMPRESSION_LOSSLESS_JPEG, 1);
+    ASSERT_NE(nullptr, writer.get());
+    EXPECT_EQ(file, writeToArray(writer, &rowSource));
+}
+
+TEST(TiffWriterTest, LosslessJpegEncoderRoundTrip) {
+    struct Case {
+        uint32_t width;
+        uint32_t height;
+        uint32_t samplesPerPixel;
+        uint32_t bitsPerSample;
+        Endianness end;
+    };
+    const Case cases[] = {
+        { 33, 5, 1, 16, LITTLE }, // Odd width, as a single component
+        { 64, 3, 1, 16, BIG },
+        { 20, 4, 3, 8, LITTLE },
+        { 1, 1, 1, 16, LITTLE },
+    };
+    std::mt19937 random(7);
+    for (const auto& c : cases) {
+        const uint32_t samplesPerRow = c.width * c.samplesPerPixel;
+        const uint32_t bytesPerSample = c.bitsPerSample / 8;
+        std::vector<uint16_t> samples(static_cast<size_t>(samplesPerRow) * c.height);
+        for (size_t i = 0; i < samples.size(); ++i) {
+            // Include the largest possible differences
+            samples[i] = (i % 3 == 0) ? ((i / 3) % 2) * ((1 << c.bitsPerSample) - 1) :
+                    random() & ((1 << c.bitsPerSample) - 1);
+        }
+        std::vector<uint8_t> bytes(samples.size() * bytesPerSample);
+        for (size_t i = 0; i < samples.size(); ++i) {
+            if (bytesPerSample == 1) {
+                bytes[i] = samples[i];
+            } else if (c.end == BIG) {
+                bytes[2 * i] = samples[i] >> 8;
+                bytes[2 * i + 1] = samples[i] & 0xFF;
+            } else {
+                bytes[2 * i] = samples[i] & 0xFF;
+                bytes[2 * i + 1] = samples[i] >> 8;
+            }
+        }
+        std::vector<const uint8_t*> rows;
+        for (uint32_t row = 0; row < c.height; ++row) {
+            rows.push_back(bytes.data() + static_cast<size_t>(row) * samplesPerRow *
+                    bytesPerSample);
+        }
+
+        std::vector<uint8_t> encoded;
+        ASSERT_EQ(OK, LosslessJpegEncoder::encode(rows.data(), c.width, c.height,
+                c.samplesPerPixel, c.bitsPerSample, c.end, &encoded));
+        DecodedJpeg decoded;
+        ASSERT_TRUE(decodeLosslessJpeg(encoded.data(), encoded.size(), &decoded));
+        EXPECT_EQ(c.bitsPerSample, decoded.precision);
+        EXPECT_EQ(c.height, decoded.height);
+        EXPECT_EQ(samples, decoded.samples) << c.width << "x" << c.height;
+    }
+
+    std::vector<uint8_t> encoded;
+    const uint8_t row[4] = {};
+    const uint8_t* rows[] = { row };
+    EXPECT_EQ(BAD_VALUE, LosslessJpegEncoder::encode(rows, 2, 1, 1, 12, LITTLE, &encoded));
+    EXPECT_EQ(BAD_VALUE, LosslessJpegEncoder::encode(rows, 0, 1, 1, 16, LITTLE, &encoded));
+}
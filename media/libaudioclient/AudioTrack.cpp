@@ -673,6 +673,8 @@ status_t AudioTrack::set(
     mFramesWritten = 0;
     mFramesWrittenServerOffset = 0;
     mFramesWrittenAtRestore = -1; // -1 is a unique initializer.
+    mPollFramesWritten.store(0, std::memory_order_relaxed);
+    publishPollState_l();
     mVolumeHandler = new media::VolumeHandler();
 
     return logIfErrorAndReturnStatus(status, "");
@@ -754,6 +756,8 @@ status_t AudioTrack::start()
             mFramesWrittenServerOffset -= mStartEts.mPosition[ExtendedTimestamp::LOCATION_SERVER];
         }
         mFramesWritten = 0;
+        mPollFramesWritten.store(0, std::memory_order_relaxed);
+        publishPollState_l();
         mProxy->clearTimestamp(); // need new server push for valid timestamp
         mMarkerReached = false;
 
@@ -924,6 +928,7 @@ void AudioTrack::flush_l()
     }
     mProxy->flush();
     mAudioTrack->flush();
+    publishPollState_l();
 }
 
 bool AudioTrack::pauseAndWait(const std::chrono::milliseconds& timeout)
@@ -1898,6 +1903,14 @@ status_t AudioTrack::createTrack_l()
         mDeathNotifier.clear();
     }
     mAudioTrack = output.audioTrack;
+    if (mCblkMemory != nullptr) {
+        // Unpublish the control block before checking for readers: a pollTimestamp() which
+        // read it has set mPolled before. The new one is published with the new server offset.
+        mPollCblk.store(nullptr);
+        if (mPolled.load()) {
+            mRetiredCblkMemory.push_back(mCblkMemory);
+        }
+    }
     mCblkMemory = iMem;
     IPCThreadState::self()->flushCommands();
 
@@ -2295,6 +2308,7 @@ ssize_t AudioTrack::write(const void* buffer, size_t userSize, bool blocking)
 
     if (written > 0) {
         mFramesWritten += written / mFrameSize;
+        mPollFramesWritten.store(mFramesWritten, std::memory_order_relaxed);
 
         if (mTransfer == TRANSFER_SYNC_NOTIF_CALLBACK) {
             const sp<AudioTrackThread> t = mAudioTrackThread;
@@ -2765,6 +2779,7 @@ nsecs_t AudioTrack::processAudioBuffer()
     if (writtenFrames > 0) {
         AutoMutex lock(mLock);
         mFramesWritten += writtenFrames;
+        mPollFramesWritten.store(mFramesWritten, std::memory_order_relaxed);
     }
     mRemainingFrames = notificationFrames;
     mRetryOnPartialBuffer = true;
@@ -2892,6 +2907,7 @@ retry:
         mFramesWrittenServerOffset =
                 mStaticProxy.get() != nullptr ? staticPosition : mFramesWritten;
         mFramesWrittenAtRestore = mFramesWrittenServerOffset;
+        publishPollState_l();
     }
     if (result != NO_ERROR) {
         ALOGW("%s(%d): failed status %d, retries %d", __func__, mPortId, result, retries);
@@ -3084,6 +3100,79 @@ status_t AudioTrack::getTimestamp_l(ExtendedTimestamp *timestamp)
     return found ? OK : WOULD_BLOCK;
 }
 
+status_t AudioTrack::pollTimestamp(ExtendedTimestamp *timestamp) const
+{
+    if (timestamp == nullptr) {
+        return BAD_VALUE;
+    }
+    // Before reading mPollCblk, see createTrack_l().
+    mPolled.store(true);
+    const audio_track_cblk_t* cblk = nullptr;
+    bool supported = false;
+    int64_t serverOffset = 0;
+    int32_t staleSequence = 0;
+    for (int tries = 0; ; ) {
+        constexpr int kMaxTries = 5;
+        const uint32_t sequence = mPollSequence.load(std::memory_order_acquire);
+        if ((sequence & 1) == 0) {
+            cblk = mPollCblk.load();
+            supported = mPollSupported.load(std::memory_order_relaxed);
+            serverOffset = mPollFramesWrittenServerOffset.load(std::memory_order_relaxed);
+            staleSequence = mPollStaleTimestampSequence.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (mPollSequence.load(std::memory_order_relaxed) == sequence) {
+                break;
+            }
+        }
+        if (++tries >= kMaxTries) {
+            return WOULD_BLOCK;
+        }
+    }
+    if (!supported) {
+        return INVALID_OPERATION;
+    }
+    if (cblk == nullptr || (android_atomic_acquire_load(&cblk->mFlags) & CBLK_INVALID) != 0) {
+        return WOULD_BLOCK;
+    }
+    int32_t sequence = 0;
+    if (!AudioTrackClientProxy::readTimestamp(cblk, timestamp, &sequence)) {
+        return WOULD_BLOCK;
+    }
+    // Like the clearTimestamp() of start(), wait for a timestamp pushed after the last
+    // publishPollState_l(): an older one is not relative to serverOffset.
+    if (static_cast<int32_t>(static_cast<uint32_t>(sequence)
+            - static_cast<uint32_t>(staleSequence)) <= 0) {
+        return WOULD_BLOCK;
+    }
+    // Same adjustments as getTimestamp_l().
+    bool found = false;
+    timestamp->mPosition[ExtendedTimestamp::LOCATION_CLIENT] =
+            mPollFramesWritten.load(std::memory_order_relaxed);
+    timestamp->mTimeNs[ExtendedTimestamp::LOCATION_CLIENT] = 0;
+    for (int i = ExtendedTimestamp::LOCATION_SERVER;
+            i < ExtendedTimestamp::LOCATION_MAX; ++i) {
+        if (timestamp->mTimeNs[i] >= 0) {
+            timestamp->mPosition[i] += serverOffset;
+            found = true;
+        }
+    }
+    return found ? OK : WOULD_BLOCK;
+}
+
+void AudioTrack::publishPollState_l()
+{
+    const uint32_t sequence = mPollSequence.load(std::memory_order_relaxed);
+    mPollSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    mPollCblk.store(mCblk);
+    mPollSupported.store(!isOffloadedOrDirect_l(), std::memory_order_relaxed);
+    mPollFramesWrittenServerOffset.store(mFramesWrittenServerOffset, std::memory_order_relaxed);
+    mPollStaleTimestampSequence.store(
+            mCblk != nullptr ? AudioTrackClientProxy::timestampSequence(mCblk) : 0,
+            std::memory_order_relaxed);
+    mPollSequence.store(sequence + 2, std::memory_order_release);
+}
+
 status_t AudioTrack::getTimestamp(AudioTimestamp& timestamp)
 {
     AutoMutex lock(mLock);
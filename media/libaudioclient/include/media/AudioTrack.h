@@ -29,8 +29,10 @@
 #include <utils/threads.h>
 #include <android/content/AttributionSourceState.h>
 
+#include <atomic>
 #include <chrono>
 #include <string>
+#include <vector>
 
 #include "android/media/BnAudioTrackCallback.h"
 #include "android/media/IAudioTrack.h"
@@ -1043,6 +1045,28 @@ private:
             status_t getTimestamp_l(ExtendedTimestamp *timestamp);
 public:
 
+    /* Lock-free variant of getTimestamp(ExtendedTimestamp *timestamp), for clients polling the
+     * timestamp several times per frame such as A/V sync.
+     *
+     * Reads the timestamp published by the server in shared memory once per mix cycle, with
+     * no binder call and without taking the AudioTrack lock, so it may be called from any
+     * thread concurrently with the other methods. As it does not restore an invalidated track,
+     * callers should fall back to getTimestamp() when it does not return NO_ERROR.
+     * The LOCATION_CLIENT position may not account for a concurrent write() yet.
+     *
+     * Parameters:
+     *  timestamp: A pointer to the caller allocated ExtendedTimestamp.
+     *
+     * Returns NO_ERROR    on success; timestamp is filled with valid data.
+     *         BAD_VALUE   if timestamp is NULL.
+     *         WOULD_BLOCK if no frame was presented yet, if the server has not published a
+     *                     timestamp since the last start() or flush(), if the server was
+     *                     publishing for the whole read, or if the track must be restored by
+     *                     getTimestamp().
+     *         INVALID_OPERATION  if called on a offloaded or direct track.
+     */
+            status_t pollTimestamp(ExtendedTimestamp *timestamp) const;
+
     /* Add an AudioDeviceCallback. The caller will be notified when the audio device to which this
      * AudioTrack is routed is updated.
      * Replaces any previously installed callback.
@@ -1438,6 +1462,25 @@ public:
 
     mutable Mutex           mLock;
 
+            // Publishes the state read by pollTimestamp(), after the control block, the flags or
+            // mFramesWrittenServerOffset changed, or a flush. Timestamps the server published
+            // before are relative to the previous state, and are no longer returned.
+            void publishPollState_l();
+
+    // Read by pollTimestamp() without mLock, and only written with mLock held: mPollSequence
+    // is odd while the other fields are being updated.
+    std::atomic<uint32_t>   mPollSequence{0};
+    std::atomic<const audio_track_cblk_t*> mPollCblk{nullptr}; // nullptr while being replaced
+    std::atomic<bool>       mPollSupported{false};  // not offloaded nor direct
+    std::atomic<int64_t>    mPollFramesWrittenServerOffset{0};
+    // Sequence of the last stale timestamp of mPollCblk, see publishPollState_l()
+    std::atomic<int32_t>    mPollStaleTimestampSequence{0};
+    std::atomic<int64_t>    mPollFramesWritten{0};  // copy of mFramesWritten
+    mutable std::atomic<bool> mPolled{false};       // pollTimestamp() was called
+    // Control blocks replaced after pollTimestamp() was called, kept until destruction as a
+    // concurrent pollTimestamp() may still read them. Tracks are seldom restored.
+    std::vector<sp<IMemory>> mRetiredCblkMemory GUARDED_BY(mLock);
+
     int mPreviousPriority = ANDROID_PRIORITY_NORMAL;  // before start()
     SchedPolicy mPreviousSchedulingGroup = SP_DEFAULT;
     bool                    mAwaitBoost;    // thread should wait for priority boost before running
@@ -14,12 +14,15 @@
  * limitations under the License.
  */
 
+#include <atomic>
 #include <thread>
+#include <vector>
 
 //#define LOG_NDEBUG 0
 #define LOG_TAG "AudioTrackTests"
 
 #include <android-base/logging.h>
+#include <android-base/scopeguard.h>
 #include <binder/ProcessState.h>
 #include <gtest/gtest.h>
 
@@ -71,6 +74,86 @@ TEST(AudioTrackTest, TestSeek) {
     ap->stop();
 }
 
+// Polls until a timestamp is available, or about a second.
+static status_t waitForPolledTimestamp(const sp<AudioTrack>& track, ExtendedTimestamp* timestamp) {
+    status_t status = WOULD_BLOCK;
+    for (int i = 0; i < 100 && status == WOULD_BLOCK; ++i) {
+        status = track->pollTimestamp(timestamp);
+        if (status == WOULD_BLOCK) usleep(10000);
+    }
+    return status;
+}
+
+TEST(AudioTrackTest, PollTimestamp) {
+    AttributionSourceState attributionSource;
+    attributionSource.packageName = "AudioTrackTest";
+    attributionSource.uid = VALUE_OR_FATAL(legacy2aidl_uid_t_int32_t(getuid()));
+    attributionSource.pid = VALUE_OR_FATAL(legacy2aidl_pid_t_int32_t(getpid()));
+    attributionSource.token = sp<BBinder>::make();
+    constexpr uint32_t kSampleRate = 48000;
+    const auto track = sp<AudioTrack>::make(AUDIO_STREAM_MUSIC, kSampleRate,
+            AUDIO_FORMAT_PCM_16_BIT, AUDIO_CHANNEL_OUT_STEREO, 0 /* frameCount */,
+            AUDIO_OUTPUT_FLAG_NONE, nullptr /* callback */, 0 /* notificationFrames */,
+            AUDIO_SESSION_ALLOCATE, AudioTrack::TRANSFER_SYNC, nullptr /* offloadInfo */,
+            attributionSource);
+    ASSERT_EQ(OK, track->initCheck());
+
+    EXPECT_EQ(BAD_VALUE, track->pollTimestamp(nullptr));
+    ExtendedTimestamp polled;
+    EXPECT_EQ(WOULD_BLOCK, track->pollTimestamp(&polled)) << "nothing was played";
+
+    // start() returns before the server mixes the track and publishes a timestamp.
+    ASSERT_EQ(OK, track->start());
+    EXPECT_EQ(WOULD_BLOCK, track->pollTimestamp(&polled));
+
+    std::atomic<bool> writing{true};
+    std::thread writer([&] {
+        std::vector<int16_t> silence(kSampleRate / 100 * 2);
+        while (writing) {
+            if (track->write(silence.data(), silence.size() * sizeof(int16_t)) < 0) {
+                usleep(10000);
+            }
+        }
+    });
+    const auto stopWriting = [&] {
+        writing = false;
+        if (writer.joinable()) writer.join();
+    };
+    auto joinWriter = base::make_scope_guard(stopWriting);
+    ASSERT_EQ(OK, waitForPolledTimestamp(track, &polled)) << "no timestamp after start()";
+
+    // Both read the timestamp last published by the server, the one read second may be newer.
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_EQ(OK, track->pollTimestamp(&polled));
+        ExtendedTimestamp read;
+        ASSERT_EQ(OK, track->getTimestamp(&read));
+        EXPECT_LE(polled.mPosition[ExtendedTimestamp::LOCATION_CLIENT],
+                read.mPosition[ExtendedTimestamp::LOCATION_CLIENT]);
+        for (int location = ExtendedTimestamp::LOCATION_SERVER;
+                location < ExtendedTimestamp::LOCATION_MAX; ++location) {
+            SCOPED_TRACE(location);
+            if (polled.mTimeNs[location] < 0 || read.mTimeNs[location] < 0) continue;
+            EXPECT_LE(polled.mTimeNs[location], read.mTimeNs[location]);
+            if (polled.mTimeNs[location] == read.mTimeNs[location]) {
+                EXPECT_EQ(polled.mPosition[location], read.mPosition[location]);
+            } else {
+                EXPECT_LE(polled.mPosition[location], read.mPosition[location]);
+            }
+        }
+        usleep(5000);
+    }
+
+    // A paused track is no longer mixed, so nothing is published after the flush.
+    stopWriting();
+    track->pause();
+    usleep(200000);
+    track->flush();
+    EXPECT_EQ(WOULD_BLOCK, track->pollTimestamp(&polled)) << "after flush()";
+    usleep(50000);
+    EXPECT_EQ(WOULD_BLOCK, track->pollTimestamp(&polled)) << "after flush()";
+    track->stop();
+}
+
 TEST(AudioTrackTest, OffloadOrDirectPlayback) {
     audio_offload_info_t info = AUDIO_INFO_INITIALIZER;
     info.sample_rate = 44100;
@@ -104,6 +187,8 @@ TEST(AudioTrackTest, OffloadOrDirectPlayback) {
     }
     ASSERT_NE(nullptr, ap);
     EXPECT_EQ(OK, ap->create()) << "track creation failed";
+    ExtendedTimestamp timestamp;
+    EXPECT_EQ(INVALID_OPERATION, ap->getAudioTrackHandle()->pollTimestamp(&timestamp));
     audio_dual_mono_mode_t mode;
     if (OK != ap->getAudioTrackHandle()->getDualMonoMode(&mode)) {
         std::cerr << "no dual mono presentation is available" << std::endl;
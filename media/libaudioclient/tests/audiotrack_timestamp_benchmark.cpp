@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "AudioTrackTimestampBenchmark"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <binder/Binder.h>
+#include <binder/ProcessState.h>
+#include <media/AudioTrack.h>
+#include <utils/Log.h>
+#include <utils/Timers.h>
+
+using namespace android;
+using content::AttributionSourceState;
+
+namespace {
+
+constexpr uint32_t kSampleRate = 48000;
+
+// A playing track fed with silence by a writer thread, shared by all benchmarks so that the
+// timestamp polled is published by the server on every mix cycle.
+class PlayingTrack {
+public:
+    static PlayingTrack& get() {
+        static PlayingTrack* track = new PlayingTrack();
+        return *track;
+    }
+
+    const sp<AudioTrack>& track() const { return mTrack; }
+    bool ready() const { return mReady; }
+
+private:
+    PlayingTrack() {
+        AttributionSourceState attributionSource;
+        attributionSource.packageName = "AudioTrackTimestampBenchmark";
+        attributionSource.uid = getuid();
+        attributionSource.pid = getpid();
+        attributionSource.token = sp<BBinder>::make();
+        mTrack = sp<AudioTrack>::make(AUDIO_STREAM_MUSIC, kSampleRate, AUDIO_FORMAT_PCM_16_BIT,
+                AUDIO_CHANNEL_OUT_STEREO, 0 /* frameCount */, AUDIO_OUTPUT_FLAG_NONE,
+                nullptr /* callback */, 0 /* notificationFrames */, AUDIO_SESSION_ALLOCATE,
+                AudioTrack::TRANSFER_SYNC, nullptr /* offloadInfo */, attributionSource);
+        if (mTrack->initCheck() != OK || mTrack->start() != OK) {
+            ALOGE("cannot start the track");
+            return;
+        }
+        mWriter = std::thread([this] {
+            std::vector<int16_t> silence(kSampleRate / 100 * 2);
+            while (!mExit) {
+                mTrack->write(silence.data(), silence.size() * sizeof(int16_t));
+            }
+        });
+        // Wait for the first frames to be presented.
+        for (int i = 0; i < 200 && !mReady; ++i) {
+            ExtendedTimestamp timestamp;
+            mReady = mTrack->getTimestamp(&timestamp) == OK;
+            usleep(10000);
+        }
+    }
+
+    sp<AudioTrack> mTrack;
+    std::thread mWriter;
+    std::atomic<bool> mExit{false};
+    bool mReady = false;
+};
+
+// Reports how old the timestamp read is, that is the time since the position of its most
+// downstream location was observed by the server.
+void addAge(const ExtendedTimestamp& timestamp, double* totalAgeUs) {
+    int64_t position;
+    int64_t timeNs;
+    if (timestamp.getBestTimestamp(&position, &timeNs, ExtendedTimestamp::TIMEBASE_MONOTONIC)
+            == OK) {
+        *totalAgeUs += (systemTime() - timeNs) * 1e-3;
+    }
+}
+
+template <typename Poll>
+void runPolling(benchmark::State& state, Poll poll) {
+    const PlayingTrack& playing = PlayingTrack::get();
+    if (!playing.ready()) {
+        state.SkipWithError("no playing track");
+        return;
+    }
+    ExtendedTimestamp timestamp;
+    int64_t failures = 0;
+    double totalAgeUs = 0;
+    for (auto _ : state) {
+        if (poll(playing.track(), &timestamp) == OK) {
+            addAge(timestamp, &totalAgeUs);
+        } else {
+            ++failures;
+        }
+        benchmark::DoNotOptimize(timestamp);
+    }
+    state.counters["age_us"] = benchmark::Counter(totalAgeUs, benchmark::Counter::kAvgIterations);
+    state.counters["failures"] = failures;
+}
+
+// The existing API, holding the AudioTrack lock.
+void BM_GetTimestamp(benchmark::State& state) {
+    runPolling(state, [](const sp<AudioTrack>& track, ExtendedTimestamp* timestamp) {
+        return track->getTimestamp(timestamp);
+    });
+}
+
+// The lock-free snapshot.
+void BM_PollTimestamp(benchmark::State& state) {
+    runPolling(state, [](const sp<AudioTrack>& track, ExtendedTimestamp* timestamp) {
+        return track->pollTimestamp(timestamp);
+    });
+}
+
+// For reference, the position as used by players for A/V sync.
+void BM_GetPosition(benchmark::State& state) {
+    const PlayingTrack& playing = PlayingTrack::get();
+    if (!playing.ready()) {
+        state.SkipWithError("no playing track");
+        return;
+    }
+    uint32_t position;
+    for (auto _ : state) {
+        playing.track()->getPosition(&position);
+        benchmark::DoNotOptimize(position);
+    }
+}
+
+// Several threads polling, as a renderer, a sync clock and a UI would, while the writer thread
+// also takes the lock.
+BENCHMARK(BM_GetTimestamp)->Threads(1)->Threads(4);
+BENCHMARK(BM_PollTimestamp)->Threads(1)->Threads(4);
+BENCHMARK(BM_GetPosition)->Threads(1)->Threads(4);
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    ProcessState::self()->startThreadPool();
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
@@ -26,6 +26,7 @@
 #include <cutils/compiler.h>
 #include <media/AudioMixerBase.h>
 #include <utils/Log.h>
+#include <utils/Timers.h>
 
 #include "AudioMixerOps.h"
 
@@ -608,6 +609,26 @@ size_t AudioMixerBase::getUnreleasedFrames(int name) const
     return 0;
 }
 
+int64_t AudioMixerBase::getTrackMixTimeNs(int name) const
+{
+    const auto it = mTracks.find(name);
+    if (it != mTracks.end()) {
+        return it->second->mMixTimeNs;
+    }
+    return 0;
+}
+
+void AudioMixerBase::startTrackTiming()
+{
+    mTimingTracks = mTrackTimingInterval != 0 && ++mUntimedProcessCount >= mTrackTimingInterval;
+    if (mTimingTracks) {
+        mUntimedProcessCount = 0;
+        for (const auto &pair : mTracks) {
+            pair.second->mMixTimeNs = 0;
+        }
+    }
+}
+
 std::string AudioMixerBase::trackNames() const
 {
     std::stringstream ss;
@@ -1104,10 +1125,14 @@ void AudioMixerBase::process__genericNoResampling()
         // acquire buffer
         for (const int name : group) {
             const std::shared_ptr<TrackBase> &t = mTracks[name];
+            const nsecs_t startNs = CC_UNLIKELY(mTimingTracks) ? systemTime() : 0;
             t->buffer.frameCount = mFrameCount;
             t->bufferProvider->getNextBuffer(&t->buffer);
             t->frameCount = t->buffer.frameCount;
             t->mIn = t->buffer.raw;
+            if (CC_UNLIKELY(mTimingTracks)) {
+                t->mMixTimeNs += systemTime() - startNs;
+            }
         }
 
         int32_t *out = (int *)pair.first;
@@ -1117,6 +1142,7 @@ void AudioMixerBase::process__genericNoResampling()
             memset(outTemp, 0, sizeof(outTemp));
             for (const int name : group) {
                 const std::shared_ptr<TrackBase> &t = mTracks[name];
+                const nsecs_t startNs = CC_UNLIKELY(mTimingTracks) ? systemTime() : 0;
                 int32_t *aux = NULL;
                 if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
                     aux = t->auxBuffer + numFrames;
@@ -1150,6 +1176,9 @@ void AudioMixerBase::process__genericNoResampling()
                         t->frameCount = t->buffer.frameCount;
                     }
                 }
+                if (CC_UNLIKELY(mTimingTracks)) {
+                    t->mMixTimeNs += systemTime() - startNs;
+                }
             }
 
             const std::shared_ptr<TrackBase> &t1 = mTracks[group[0]];
@@ -1185,6 +1214,7 @@ void AudioMixerBase::process__genericResampling()
         memset(outTemp, 0, sizeof(*outTemp) * t1->mMixerChannelCount * mFrameCount);
         for (const int name : group) {
             const std::shared_ptr<TrackBase> &t = mTracks[name];
+            const nsecs_t startNs = CC_UNLIKELY(mTimingTracks) ? systemTime() : 0;
             int32_t *aux = NULL;
             if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
                 aux = t->auxBuffer;
@@ -1216,6 +1246,9 @@ void AudioMixerBase::process__genericResampling()
                     t->bufferProvider->releaseBuffer(&t->buffer);
                 }
             }
+            if (CC_UNLIKELY(mTimingTracks)) {
+                t->mMixTimeNs += systemTime() - startNs;
+            }
         }
         convertMixerFormat(t1->mainBuffer, t1->mMixerFormat,
                 outTemp, t1->mMixerInFormat, numFrames * t1->mMixerChannelCount);
@@ -1230,6 +1263,7 @@ void AudioMixerBase::process__oneTrack16BitsStereoNoResampling()
             "%zu != 1 tracks enabled", mEnabled.size());
     const int name = mEnabled[0];
     const std::shared_ptr<TrackBase> &t = mTracks[name];
+    const nsecs_t startNs = CC_UNLIKELY(mTimingTracks) ? systemTime() : 0;
 
     AudioBufferProvider::Buffer& b(t->buffer);
 
@@ -1259,6 +1293,9 @@ void AudioMixerBase::process__oneTrack16BitsStereoNoResampling()
                     "process__oneTrack16BitsStereoNoResampling: misaligned buffer"
                     " %p track %d, channels %d, needs %08x, volume %08x vfl %f vfr %f",
                     in, name, t->channelCount, t->needs, vrl, t->mVolume[0], t->mVolume[1]);
+            if (CC_UNLIKELY(mTimingTracks)) {
+                t->mMixTimeNs += systemTime() - startNs;
+            }
             return;
         }
         size_t outFrames = b.frameCount;
@@ -1306,6 +1343,9 @@ void AudioMixerBase::process__oneTrack16BitsStereoNoResampling()
         numFrames -= b.frameCount;
         t->bufferProvider->releaseBuffer(&b);
     }
+    if (CC_UNLIKELY(mTimingTracks)) {
+        t->mMixTimeNs += systemTime() - startNs;
+    }
 }
 
 /* TODO: consider whether this level of optimization is necessary.
@@ -1456,6 +1496,7 @@ void AudioMixerBase::process__noResampleOneTrack()
     TO* out = reinterpret_cast<TO*>(t->mainBuffer);
     TA* aux = reinterpret_cast<TA*>(t->auxBuffer);
     const bool ramp = t->needsRamp();
+    const nsecs_t startNs = CC_UNLIKELY(mTimingTracks) ? systemTime() : 0;
 
     for (size_t numFrames = mFrameCount; numFrames > 0; ) {
         AudioBufferProvider::Buffer& b(t->buffer);
@@ -1472,6 +1513,9 @@ void AudioMixerBase::process__noResampleOneTrack()
             ALOGE_IF((((uintptr_t)in) & 3), "process__noResampleOneTrack: bus error: "
                     "buffer %p track %p, channels %d, needs %#x",
                     in, &t, t->channelCount, t->needs);
+            if (CC_UNLIKELY(mTimingTracks)) {
+                t->mMixTimeNs += systemTime() - startNs;
+            }
             return;
         }
 
@@ -1491,6 +1535,9 @@ void AudioMixerBase::process__noResampleOneTrack()
     if (ramp) {
         t->adjustVolumeRamp(aux != NULL, std::is_same_v<TI, float>);
     }
+    if (CC_UNLIKELY(mTimingTracks)) {
+        t->mMixTimeNs += systemTime() - startNs;
+    }
 }
 
 /* This track hook is called to do resampling then mixing,
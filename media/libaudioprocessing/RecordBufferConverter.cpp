@@ -25,6 +25,8 @@
 #include <media/RecordBufferConverter.h>
 #include <utils/Log.h>
 
+#include "RecordBufferConverterOps.h"
+
 #ifndef ARRAY_SIZE
 #define ARRAY_SIZE(x) (sizeof(x)/sizeof((x)[0]))
 #endif
@@ -41,7 +43,8 @@ RecordBufferConverter::RecordBufferConverter(
         audio_channel_mask_t srcChannelMask, audio_format_t srcFormat,
         uint32_t srcSampleRate,
         audio_channel_mask_t dstChannelMask, audio_format_t dstFormat,
-        uint32_t dstSampleRate) :
+        uint32_t dstSampleRate,
+        bool allowFusedConversion) :
             mSrcChannelMask(AUDIO_CHANNEL_INVALID), // updateParameters will set following vars
             // mSrcFormat
             // mSrcSampleRate
@@ -56,6 +59,8 @@ RecordBufferConverter::RecordBufferConverter(
             mIsLegacyDownmix(false),
             mIsLegacyUpmix(false),
             mRequiresFloat(false),
+            mAllowFusedConversion(allowFusedConversion),
+            mFusedConversion(FUSED_NONE),
             mInputConverterProvider(NULL)
 {
     (void)updateParameters(srcChannelMask, srcFormat, srcSampleRate,
@@ -185,14 +190,19 @@ status_t RecordBufferConverter::updateParameters(
                    && (mDstChannelMask == AUDIO_CHANNEL_IN_STEREO
                             || mDstChannelMask == AUDIO_CHANNEL_IN_FRONT_BACK);
 
+    mFusedConversion = selectFusedConversion();
+
     // do we need to process in float?
-    mRequiresFloat = mResampler != NULL || mIsLegacyDownmix || mIsLegacyUpmix;
+    mRequiresFloat = mResampler != NULL
+            || ((mIsLegacyDownmix || mIsLegacyUpmix) && mFusedConversion == FUSED_NONE);
 
     // do we need a staging buffer to convert for destination (we can still optimize this)?
     // we use mBufFrameSize > 0 to indicate both frame size as well as buffer necessity
     if (mResampler != NULL) {
         mBufFrameSize = max(mSrcChannelCount, (uint32_t)FCC_2)
                 * audio_bytes_per_sample(AUDIO_FORMAT_PCM_FLOAT);
+    } else if (mFusedConversion != FUSED_NONE) { // straight to destination
+        mBufFrameSize = 0;
     } else if (mIsLegacyUpmix || mIsLegacyDownmix) { // legacy modes always float
         mBufFrameSize = mDstChannelCount * audio_bytes_per_sample(AUDIO_FORMAT_PCM_FLOAT);
     } else if (mSrcChannelMask != mDstChannelMask && mDstFormat != mSrcFormat) {
@@ -221,9 +231,78 @@ status_t RecordBufferConverter::updateParameters(
     return NO_ERROR;
 }
 
+RecordBufferConverter::FusedConversion RecordBufferConverter::selectFusedConversion() const
+{
+    const auto isFusedFormat = [](audio_format_t format) {
+        return format == AUDIO_FORMAT_PCM_16_BIT || format == AUDIO_FORMAT_PCM_FLOAT;
+    };
+    if (!mAllowFusedConversion || !isFusedFormat(mSrcFormat) || !isFusedFormat(mDstFormat)) {
+        return FUSED_NONE;
+    }
+    if (mResampler != NULL) {
+        // the resampler outputs float, stereo for mono input, see convertResampler().
+        if (mIsLegacyDownmix
+                || (mSrcChannelMask == mDstChannelMask && mSrcChannelCount == 1)) {
+            return FUSED_DOWNMIX;
+        }
+        if (!mIsLegacyUpmix && mSrcChannelMask != mDstChannelMask && mSrcChannelCount > 1) {
+            return FUSED_REMIX;
+        }
+        return FUSED_NONE; // already a single pass
+    }
+    if (mIsLegacyDownmix) {
+        return FUSED_DOWNMIX;
+    }
+    if (mIsLegacyUpmix) {
+        return FUSED_UPMIX;
+    }
+    if (mSrcChannelMask != mDstChannelMask && mSrcFormat != mDstFormat) {
+        return FUSED_REMIX;
+    }
+    return FUSED_NONE; // already a single pass
+}
+
+void RecordBufferConverter::convertFused(void *dst, const void *src, audio_format_t srcFormat,
+        uint32_t srcChannelCount, size_t frames)
+{
+    const auto convertTyped = [&](auto *typedDst, const auto *typedSrc) {
+        switch (mFusedConversion) {
+        case FUSED_DOWNMIX:
+            recordDownmixToMonoFromStereo(typedDst, typedSrc, frames);
+            break;
+        case FUSED_UPMIX:
+            recordUpmixToStereoFromMono(typedDst, typedSrc, frames);
+            break;
+        case FUSED_REMIX:
+            recordRemixByIndex(typedDst, mDstChannelCount, typedSrc, srcChannelCount, mIdxAry,
+                    frames);
+            break;
+        case FUSED_NONE:
+            LOG_ALWAYS_FATAL("%s: no fused conversion", __func__);
+        }
+    };
+    const auto convertToTyped = [&](auto *typedDst) {
+        if (srcFormat == AUDIO_FORMAT_PCM_16_BIT) {
+            convertTyped(typedDst, static_cast<const int16_t *>(src));
+        } else {
+            convertTyped(typedDst, static_cast<const float *>(src));
+        }
+    };
+    if (mDstFormat == AUDIO_FORMAT_PCM_16_BIT) {
+        convertToTyped(static_cast<int16_t *>(dst));
+    } else {
+        convertToTyped(static_cast<float *>(dst));
+    }
+}
+
 void RecordBufferConverter::convertNoResampler(
         void *dst, const void *src, size_t frames)
 {
+    if (mFusedConversion != FUSED_NONE) {
+        // src is native type, converted and remixed straight to dst.
+        convertFused(dst, src, mSrcFormat, mSrcChannelCount, frames);
+        return;
+    }
     // src is native type unless there is legacy upmix or downmix, whereupon it is float.
     if (mBufFrameSize != 0 && mBufFrames < frames) {
         free(mBuf);
@@ -265,6 +344,11 @@ void RecordBufferConverter::convertResampler(
         void *dst, /*not-a-const*/ void *src, size_t frames)
 {
     // src buffer format is ALWAYS float when entering this routine
+    if (mFusedConversion != FUSED_NONE) {
+        convertFused(dst, src, AUDIO_FORMAT_PCM_FLOAT, max(mSrcChannelCount, (uint32_t)FCC_2),
+                frames);
+        return;
+    }
     if (mIsLegacyUpmix) {
         ; // mono to stereo already handled by resampler
     } else if (mIsLegacyDownmix
@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <audio_utils/primitives.h>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace android {
+
+/* Single pass conversion kernels for the RecordBufferConverter.
+ *
+ * Each kernel reads samples of type TI, converts them to float, remixes
+ * and writes samples of type TO, where TI and TO are int16_t or float.
+ * The results are bit exact with the multi-pass conversion through float
+ * done with the audio_utils primitives:
+ *
+ * memcpy_to_float_from_i16(), downmix_to_mono_float_from_stereo_float(),
+ * upmix_to_stereo_float_from_mono_float(), memcpy_by_index_array() and
+ * memcpy_to_i16_from_float().
+ *
+ * Four frames at a time are processed with NEON on arm64 and SSE2 on x86,
+ * the remainder and the other architectures use the scalar version.
+ */
+
+template <typename T>
+inline float recordSampleToFloat(T sample);
+
+template <>
+inline float recordSampleToFloat<int16_t>(int16_t sample) {
+    return float_from_i16(sample);
+}
+
+template <>
+inline float recordSampleToFloat<float>(float sample) {
+    return sample;
+}
+
+template <typename T>
+inline T recordSampleFromFloat(float sample);
+
+template <>
+inline int16_t recordSampleFromFloat<int16_t>(float sample) {
+    return clamp16_from_float(sample);
+}
+
+template <>
+inline float recordSampleFromFloat<float>(float sample) {
+    return sample;
+}
+
+namespace record_ops {
+
+#if defined(__aarch64__)
+
+using float4 = float32x4_t;
+
+inline float4 i16ToFloat4(int16x4_t v) {
+    return vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(v)), 1.f / (1 << 15));
+}
+
+// vcvtnq rounds to nearest even and saturates, as clamp16_from_float() does.
+inline int16x4_t float4ToI16(float4 v) {
+    return vqmovn_s32(vcvtnq_s32_f32(vmulq_n_f32(v, 1 << 15)));
+}
+
+template <typename T> inline float4 load(const T* src);
+template <> inline float4 load<float>(const float* src) { return vld1q_f32(src); }
+template <> inline float4 load<int16_t>(const int16_t* src) { return i16ToFloat4(vld1_s16(src)); }
+
+template <typename T> inline void loadStereo(const T* src, float4* left, float4* right);
+template <> inline void loadStereo<float>(const float* src, float4* left, float4* right) {
+    const float32x4x2_t v = vld2q_f32(src);
+    *left = v.val[0];
+    *right = v.val[1];
+}
+template <> inline void loadStereo<int16_t>(const int16_t* src, float4* left, float4* right) {
+    const int16x4x2_t v = vld2_s16(src);
+    *left = i16ToFloat4(v.val[0]);
+    *right = i16ToFloat4(v.val[1]);
+}
+
+template <typename T> inline void store(T* dst, float4 v);
+template <> inline void store<float>(float* dst, float4 v) { vst1q_f32(dst, v); }
+template <> inline void store<int16_t>(int16_t* dst, float4 v) { vst1_s16(dst, float4ToI16(v)); }
+
+template <typename T> inline void storeStereo(T* dst, float4 left, float4 right);
+template <> inline void storeStereo<float>(float* dst, float4 left, float4 right) {
+    float32x4x2_t v;
+    v.val[0] = left;
+    v.val[1] = right;
+    vst2q_f32(dst, v);
+}
+template <> inline void storeStereo<int16_t>(int16_t* dst, float4 left, float4 right) {
+    int16x4x2_t v;
+    v.val[0] = float4ToI16(left);
+    v.val[1] = float4ToI16(right);
+    vst2_s16(dst, v);
+}
+
+inline float4 half(float4 left, float4 right) {
+    return vmulq_n_f32(vaddq_f32(left, right), 0.5f);
+}
+
+#define RECORD_OPS_SIMD (true)
+
+#elif defined(__SSE2__)
+
+using float4 = __m128;
+
+inline float4 i16ToFloat4(__m128i v) {  // the 4 low samples of v
+    const __m128i i32 = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+    return _mm_mul_ps(_mm_cvtepi32_ps(i32), _mm_set1_ps(1.f / (1 << 15)));
+}
+
+// Clamping before the conversion, which rounds to nearest even, gives the
+// results of clamp16_from_float().
+inline __m128i float4ToI16(float4 v) {  // in the 4 low samples
+    v = _mm_mul_ps(v, _mm_set1_ps(1 << 15));
+    v = _mm_max_ps(_mm_min_ps(v, _mm_set1_ps(32767.f)), _mm_set1_ps(-32768.f));
+    const __m128i i32 = _mm_cvtps_epi32(v);
+    return _mm_packs_epi32(i32, i32);
+}
+
+template <typename T> inline float4 load(const T* src);
+template <> inline float4 load<float>(const float* src) { return _mm_loadu_ps(src); }
+template <> inline float4 load<int16_t>(const int16_t* src) {
+    return i16ToFloat4(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src)));
+}
+
+template <typename T> inline void loadStereo(const T* src, float4* left, float4* right);
+template <> inline void loadStereo<float>(const float* src, float4* left, float4* right) {
+    const float4 lo = _mm_loadu_ps(src);
+    const float4 hi = _mm_loadu_ps(src + 4);
+    *left = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+    *right = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+}
+template <> inline void loadStereo<int16_t>(const int16_t* src, float4* left, float4* right) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    const float4 lo = i16ToFloat4(v);
+    const float4 hi = i16ToFloat4(_mm_unpackhi_epi64(v, v));
+    *left = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+    *right = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+template <typename T> inline void store(T* dst, float4 v);
+template <> inline void store<float>(float* dst, float4 v) { _mm_storeu_ps(dst, v); }
+template <> inline void store<int16_t>(int16_t* dst, float4 v) {
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), float4ToI16(v));
+}
+
+template <typename T> inline void storeStereo(T* dst, float4 left, float4 right);
+template <> inline void storeStereo<float>(float* dst, float4 left, float4 right) {
+    _mm_storeu_ps(dst, _mm_unpacklo_ps(left, right));
+    _mm_storeu_ps(dst + 4, _mm_unpackhi_ps(left, right));
+}
+template <> inline void storeStereo<int16_t>(int16_t* dst, float4 left, float4 right) {
+    store(dst, _mm_unpacklo_ps(left, right));
+    store(dst + 4, _mm_unpackhi_ps(left, right));
+}
+
+inline float4 half(float4 left, float4 right) {
+    return _mm_mul_ps(_mm_add_ps(left, right), _mm_set1_ps(0.5f));
+}
+
+#define RECORD_OPS_SIMD (true)
+
+#else
+
+#define RECORD_OPS_SIMD (false)
+
+#endif
+
+} // namespace record_ops
+
+// Stereo to mono, averaging the two channels.
+template <typename TO, typename TI>
+void recordDownmixToMonoFromStereo(TO* __restrict dst, const TI* __restrict src, size_t frames) {
+    size_t i = 0;
+#if RECORD_OPS_SIMD
+    for (; i + 4 <= frames; i += 4) {
+        record_ops::float4 left, right;
+        record_ops::loadStereo(src + 2 * i, &left, &right);
+        record_ops::store(dst + i, record_ops::half(left, right));
+    }
+#endif
+    for (; i < frames; ++i) {
+        dst[i] = recordSampleFromFloat<TO>(
+                (recordSampleToFloat(src[2 * i]) + recordSampleToFloat(src[2 * i + 1])) * 0.5f);
+    }
+}
+
+// Mono to stereo, duplicating the channel.
+template <typename TO, typename TI>
+void recordUpmixToStereoFromMono(TO* __restrict dst, const TI* __restrict src, size_t frames) {
+    size_t i = 0;
+#if RECORD_OPS_SIMD
+    for (; i + 4 <= frames; i += 4) {
+        const record_ops::float4 v = record_ops::load(src + i);
+        record_ops::storeStereo(dst + 2 * i, v, v);
+    }
+#endif
+    for (; i < frames; ++i) {
+        dst[2 * i] = dst[2 * i + 1] = recordSampleFromFloat<TO>(recordSampleToFloat(src[i]));
+    }
+}
+
+// Channel remix by index, as memcpy_by_index_array(): destination channel
+// i is source channel idxAry[i], or silence if negative.
+template <typename TO, typename TI>
+void recordRemixByIndex(TO* __restrict dst, uint32_t dstChannels,
+        const TI* __restrict src, uint32_t srcChannels, const int8_t* idxAry, size_t frames) {
+    for (size_t i = 0; i < frames; ++i) {
+        for (uint32_t c = 0; c < dstChannels; ++c) {
+            const int8_t idx = idxAry[c];
+            dst[c] = idx < 0 ? TO{} : recordSampleFromFloat<TO>(recordSampleToFloat(src[idx]));
+        }
+        dst += dstChannels;
+        src += srcChannels;
+    }
+}
+
+} // namespace android
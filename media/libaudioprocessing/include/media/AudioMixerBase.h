@@ -131,10 +131,26 @@ public:
 
     void        process() {
         preProcess();
+        // process__validate() calls process() again once the hooks are selected.
+        if (mHook != &AudioMixerBase::process__validate) {
+            startTrackTiming();
+        }
         (this->*mHook)();
         postProcess();
     }
 
+    // Per-track mix time accounting, off by default. When interval is not 0, one call to
+    // process() out of "interval" measures the time spent mixing each enabled track,
+    // including pulling its data from the buffer provider.
+    void        setTrackTimingInterval(uint32_t interval) { mTrackTimingInterval = interval; }
+
+    // Whether the last call to process() measured the track mix times.
+    bool        trackMixTimesValid() const { return mTimingTracks; }
+
+    // Time spent mixing track "name" in the last measured process(), in ns, 0 if the track
+    // was not enabled.
+    int64_t     getTrackMixTimeNs(int name) const;
+
     size_t      getUnreleasedFrames(int name) const;
 
     std::string trackNames() const;
@@ -299,6 +315,8 @@ public:
 
         uint32_t       mInputFrameSize; // The track input frame size, used for tee buffer
 
+        int64_t        mMixTimeNs = 0;  // time spent mixing in the last measured process()
+
         // consider volume muted only if all channel volume (floating point) is 0.f
         inline bool isVolumeMuted() const {
             for (const auto volume : mVolume) {
@@ -346,6 +364,10 @@ public:
         mHook = &AudioMixerBase::process__validate;
     }
 
+    // Decides whether this call to process() measures the track mix times. Each process hook
+    // then adds the time it spends on a track to that track's mMixTimeNs.
+    void startTrackTiming();
+
     void process__validate();
     void process__nop();
     void process__genericNoResampling();
@@ -368,6 +390,10 @@ public:
 
     process_hook_t mHook = &AudioMixerBase::process__nop;   // one of process__*, never nullptr
 
+    uint32_t mTrackTimingInterval = 0;  // 0 if track mix times are not measured
+    uint32_t mUntimedProcessCount = 0;  // process() calls since the last measured one
+    bool mTimingTracks = false;         // the current or last process() measures track times
+
     // the size of the type (int32_t) should be the largest of all types supported
     // by the mixer.
     std::unique_ptr<int32_t[]> mOutputTemp;
@@ -37,6 +37,10 @@ namespace android {
  * There are legacy conversion requirements for this converter, specifically
  * due to mono handling, so be careful about modifying.
  *
+ * The common conversions between PCM 16 bit and float with a channel remix
+ * are done in a single pass, bit exact with the multi-pass conversion
+ * through float which handles the other cases.
+ *
  * Original source audioflinger/Threads.{h,cpp}
  */
 class RecordBufferConverter
@@ -46,7 +50,8 @@ public:
             audio_channel_mask_t srcChannelMask, audio_format_t srcFormat,
             uint32_t srcSampleRate,
             audio_channel_mask_t dstChannelMask, audio_format_t dstFormat,
-            uint32_t dstSampleRate);
+            uint32_t dstSampleRate,
+            bool allowFusedConversion = true /* false for testing the multi-pass path */);
 
     ~RecordBufferConverter();
 
@@ -79,6 +84,20 @@ public:
     void reset();
 
 private:
+    // conversion done in a single pass by convertFused()
+    enum FusedConversion {
+        FUSED_NONE,
+        FUSED_DOWNMIX,  // stereo to mono
+        FUSED_UPMIX,    // mono to stereo
+        FUSED_REMIX,    // channel mask conversion by mIdxAry
+    };
+
+    FusedConversion selectFusedConversion() const;
+
+    // format and channel conversion of frames from src in srcFormat to dst
+    void convertFused(void *dst, const void *src, audio_format_t srcFormat,
+            uint32_t srcChannelCount, size_t frames);
+
     // format conversion when not using resampler
     void convertNoResampler(void *dst, const void *src, size_t frames);
 
@@ -109,6 +128,8 @@ private:
     bool                 mIsLegacyDownmix;  // legacy stereo to mono conversion needed
     bool                 mIsLegacyUpmix;    // legacy mono to stereo conversion needed
     bool                 mRequiresFloat;    // data processing requires float (e.g. resampler)
+    const bool           mAllowFusedConversion;
+    FusedConversion      mFusedConversion;  // after resampling if any
     PassthruBufferProvider *mInputConverterProvider;    // converts input to float
     int8_t               mIdxAry[sizeof(uint32_t) * 8]; // used for channel mask conversion
 };
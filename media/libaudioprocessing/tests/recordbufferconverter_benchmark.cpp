@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/AudioBufferProvider.h>
+#include <media/RecordBufferConverter.h>
+
+using namespace android;
+
+namespace {
+
+constexpr uint32_t kSampleRate = 48000;
+constexpr size_t kPeriodFrames = kSampleRate / 50;  // 20 ms
+constexpr audio_channel_mask_t kChannelMask = AUDIO_CHANNEL_IN_STEREO;
+constexpr audio_format_t kFormat = AUDIO_FORMAT_PCM_16_BIT;
+
+// Provides the same captured period over and over, as the record thread would provide the
+// period just read from the HAL to each of its clients.
+class PeriodProvider : public AudioBufferProvider {
+public:
+    PeriodProvider() : mPeriod(kPeriodFrames * FCC_2) {
+        for (size_t i = 0; i < mPeriod.size(); ++i) {
+            mPeriod[i] = static_cast<int16_t>((i * 997) & 0x7fff) - 0x4000;
+        }
+    }
+
+    status_t getNextBuffer(Buffer* buffer) override {
+        buffer->frameCount = std::min(buffer->frameCount, kPeriodFrames - mOffset);
+        buffer->i16 = mPeriod.data() + mOffset * FCC_2;
+        return OK;
+    }
+
+    void releaseBuffer(Buffer* buffer) override {
+        mOffset = (mOffset + buffer->frameCount) % kPeriodFrames;
+        buffer->frameCount = 0;
+    }
+
+private:
+    std::vector<int16_t> mPeriod;
+    size_t mOffset = 0;
+};
+
+// The configurations requested by typical concurrent capture clients.
+struct ClientConfig {
+    audio_channel_mask_t channelMask;
+    audio_format_t format;
+    uint32_t sampleRate;
+};
+
+constexpr ClientConfig kClientConfigs[] = {
+    {AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_16_BIT, 16000},    // voice assistant
+    {AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_16_BIT, 48000},    // VoIP
+    {AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_FLOAT, 48000},     // AAudio
+    {AUDIO_CHANNEL_INDEX_MASK_2, AUDIO_FORMAT_PCM_FLOAT, 48000},
+    {AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_16_BIT, 8000},     // telephony app
+    {AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_16_BIT, 44100},  // screen recording
+    {AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_FLOAT, 16000},
+    {AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_FLOAT, 48000},
+};
+
+// Arguments: number of record clients, 1 for the fused conversions, 0 for multi-pass.
+void BM_RecordBufferConverter(benchmark::State& state) {
+    const size_t clients = state.range(0);
+    const bool fused = state.range(1) != 0;
+
+    std::vector<std::unique_ptr<RecordBufferConverter>> converters;
+    std::vector<std::vector<uint8_t>> destinations;
+    for (size_t i = 0; i < clients; ++i) {
+        const ClientConfig& config = kClientConfigs[i % std::size(kClientConfigs)];
+        converters.push_back(std::make_unique<RecordBufferConverter>(
+                kChannelMask, kFormat, kSampleRate,
+                config.channelMask, config.format, config.sampleRate, fused));
+        if (converters.back()->initCheck() != NO_ERROR) {
+            state.SkipWithError("cannot create converter");
+            return;
+        }
+        destinations.emplace_back(kPeriodFrames
+                * audio_channel_count_from_in_mask(config.channelMask)
+                * audio_bytes_per_sample(config.format));
+    }
+    std::vector<PeriodProvider> providers(clients);
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < clients; ++i) {
+            const ClientConfig& config = kClientConfigs[i % std::size(kClientConfigs)];
+            const size_t frames = kPeriodFrames * config.sampleRate / kSampleRate;
+            benchmark::DoNotOptimize(
+                    converters[i]->convert(destinations[i].data(), &providers[i], frames));
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * clients * kPeriodFrames);
+}
+
+BENCHMARK(BM_RecordBufferConverter)
+        ->ArgNames({"clients", "fused"})
+        ->ArgsProduct({{1, 4, 8}, {0, 1}});
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "recordbufferconverter_tests"
+
+#include <string.h>
+
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <audio_utils/primitives.h>
+#include <gtest/gtest.h>
+#include <log/log.h>
+#include <media/RecordBufferConverter.h>
+
+#include "test_utils.h"
+
+using namespace android;
+
+namespace {
+
+// Interleaved source samples of the given format, noise slightly over full scale to exercise
+// clamping.
+std::vector<uint8_t> makeSource(audio_format_t format, size_t samples) {
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> distribution(-1.2f, 1.2f);
+    std::vector<uint8_t> source(samples * audio_bytes_per_sample(format));
+    for (size_t i = 0; i < samples; ++i) {
+        const float value = distribution(generator);
+        if (format == AUDIO_FORMAT_PCM_16_BIT) {
+            reinterpret_cast<int16_t*>(source.data())[i] = clamp16_from_float(value);
+        } else {
+            reinterpret_cast<float*>(source.data())[i] = value;
+        }
+    }
+    return source;
+}
+
+// Converts the whole source in periods, the provider returning frames in irregular chunks.
+std::vector<uint8_t> convert(RecordBufferConverter& converter, std::vector<uint8_t>& source,
+        size_t srcFrameSize, size_t dstFrameSize, size_t periodFrames) {
+    TestProvider provider(source.data(), source.size() / srcFrameSize, srcFrameSize,
+            {61, 256, 7, 128});
+    std::vector<uint8_t> destination;
+    for (;;) {
+        const size_t offset = destination.size();
+        destination.resize(offset + periodFrames * dstFrameSize);
+        const size_t frames = converter.convert(destination.data() + offset, &provider,
+                periodFrames);
+        destination.resize(offset + frames * dstFrameSize);
+        if (frames == 0) break;
+    }
+    return destination;
+}
+
+using ConverterConfig = std::tuple<audio_channel_mask_t /* src */, audio_channel_mask_t /* dst */,
+        audio_format_t /* src */, audio_format_t /* dst */, uint32_t /* dst sample rate */>;
+
+class RecordBufferConverterTest : public ::testing::TestWithParam<ConverterConfig> {};
+
+// The fused single pass conversions must be bit exact with the multi-pass path.
+TEST_P(RecordBufferConverterTest, FusedMatchesMultiPass) {
+    const auto [srcMask, dstMask, srcFormat, dstFormat, dstSampleRate] = GetParam();
+    constexpr uint32_t kSrcSampleRate = 48000;
+    constexpr size_t kSrcFrames = 4801;  // not a multiple of the periods nor of the vectors
+    constexpr size_t kPeriodFrames = 333;
+
+    RecordBufferConverter fused(srcMask, srcFormat, kSrcSampleRate,
+            dstMask, dstFormat, dstSampleRate);
+    RecordBufferConverter multiPass(srcMask, srcFormat, kSrcSampleRate,
+            dstMask, dstFormat, dstSampleRate, false /* allowFusedConversion */);
+    ASSERT_EQ(NO_ERROR, fused.initCheck());
+    ASSERT_EQ(NO_ERROR, multiPass.initCheck());
+
+    const size_t srcChannelCount = audio_channel_count_from_in_mask(srcMask);
+    const size_t srcFrameSize = srcChannelCount * audio_bytes_per_sample(srcFormat);
+    const size_t dstFrameSize =
+            audio_channel_count_from_in_mask(dstMask) * audio_bytes_per_sample(dstFormat);
+    std::vector<uint8_t> source = makeSource(srcFormat, kSrcFrames * srcChannelCount);
+
+    const std::vector<uint8_t> expected =
+            convert(multiPass, source, srcFrameSize, dstFrameSize, kPeriodFrames);
+    const std::vector<uint8_t> actual =
+            convert(fused, source, srcFrameSize, dstFrameSize, kPeriodFrames);
+    ASSERT_FALSE(expected.empty());
+    ASSERT_EQ(expected.size(), actual.size());
+    EXPECT_EQ(0, memcmp(expected.data(), actual.data(), expected.size()));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        RecordBufferConverter, RecordBufferConverterTest,
+        ::testing::Combine(
+                ::testing::Values(AUDIO_CHANNEL_IN_MONO, AUDIO_CHANNEL_IN_STEREO,
+                        AUDIO_CHANNEL_INDEX_MASK_4),
+                ::testing::Values(AUDIO_CHANNEL_IN_MONO, AUDIO_CHANNEL_IN_STEREO,
+                        AUDIO_CHANNEL_INDEX_MASK_2),
+                ::testing::Values(AUDIO_FORMAT_PCM_16_BIT, AUDIO_FORMAT_PCM_FLOAT),
+                ::testing::Values(AUDIO_FORMAT_PCM_16_BIT, AUDIO_FORMAT_PCM_FLOAT),
+                ::testing::Values(48000u, 16000u)),
+        [](const ::testing::TestParamInfo<ConverterConfig>& info) {
+            const auto [srcMask, dstMask, srcFormat, dstFormat, dstSampleRate] = info.param;
+            const auto formatName = [](audio_format_t format) {
+                return format == AUDIO_FORMAT_PCM_16_BIT ? "i16" : "float";
+            };
+            return "src_" + std::to_string(srcMask) + "_" + formatName(srcFormat)
+                    + "_dst_" + std::to_string(dstMask) + "_" + formatName(dstFormat)
+                    + "_" + std::to_string(dstSampleRate);
+        });
+
+} // namespace
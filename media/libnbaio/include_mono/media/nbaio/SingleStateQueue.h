@@ -31,6 +31,7 @@ public:
 
     class Mutator;
     class Observer;
+    class Reader;
 
     enum SSQ_STATUS {
         SSQ_PENDING, /* = 0 */
@@ -43,6 +44,7 @@ public:
 
         friend class Mutator;
         friend class Observer;
+        friend class Reader;
 
 private:
         void                init() { mAck = 0; mSequence = 0; }
@@ -168,6 +170,63 @@ private:
         Shared * const mShared;
     };
 
+    // Reads the last pushed value without acknowledging it.  Unlike Observer, which has state
+    // and must be used by a single thread, Readers may be used by any number of threads,
+    // concurrently with the Observer and with each other.
+    class Reader {
+    public:
+        explicit Reader(const Shared *shared)
+            : mShared(shared)
+        {
+        }
+
+        // return true if a value was read; false if no value was ever pushed, or if the
+        // Mutator kept pushing while reading. If sequence is not nullptr, it is set to the
+        // sequence number of the push read, which can be compared with sequence().
+        bool read(T& value, int32_t* sequence = nullptr) const
+        {
+            const Shared *shared = mShared;
+            int32_t before = android_atomic_acquire_load(&shared->mSequence);
+            for (int tries = 0; ; ) {
+                const int MAX_TRIES = 5;
+                if (before == 0) {
+                    return false;
+                }
+                if (before & 1) {
+                    if (++tries >= MAX_TRIES) {
+                        return false;
+                    }
+                    before = android_atomic_acquire_load(&shared->mSequence);
+                    continue;
+                }
+                android_memory_barrier();
+                T temp = shared->mValue;
+                int32_t after = android_atomic_release_load(&shared->mSequence);
+                if (after == before) {
+                    value = temp;
+                    if (sequence != nullptr) {
+                        *sequence = before;
+                    }
+                    return true;
+                }
+                if (++tries >= MAX_TRIES) {
+                    return false;
+                }
+                before = after;
+            }
+        }
+
+        // returns the sequence number of the last completed push, or of the one that will
+        // complete if a push is in progress
+        int32_t sequence() const
+        {
+            return (android_atomic_acquire_load(&mShared->mSequence) + 1) & ~1;
+        }
+
+    private:
+        const Shared * const mShared;
+    };
+
 #if 0
     SingleStateQueue(void /*Shared*/ *shared);
     /*virtual*/ ~SingleStateQueue() { }
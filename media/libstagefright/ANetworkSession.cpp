@@ -31,6 +31,7 @@
 #include <media/stagefright/ParsedMessage.h>
 #include <media/stagefright/foundation/ABuffer.h>
 #include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/AEventPoller.h>
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/foundation/ByteUtils.h>
 #include <media/stagefright/foundation/hexdump.h>
@@ -40,6 +41,11 @@ namespace android {
 static const size_t kMaxUDPSize = 1500;
 static const int32_t kMaxUDPRetries = 200;
 
+// Session IDs start at 1, the wakeup pipe is registered with the poller
+// under this cookie instead.
+static const uint64_t kPipeCookie = 0;
+static const size_t kMaxEventsPerLoop = 32;
+
 struct ANetworkSession::NetworkThread : public Thread {
     explicit NetworkThread(ANetworkSession *session);
 
@@ -84,6 +90,13 @@ struct ANetworkSession::Session : public RefBase {
     bool wantsToRead();
     bool wantsToWrite();
 
+    // The set of AEventPoller::EVENT_* this session should be polled for
+    // given its current state.
+    uint32_t pollEvents();
+
+    uint32_t registeredPollEvents() const;
+    void setRegisteredPollEvents(uint32_t events);
+
     status_t readMore();
     status_t writeMore();
 
@@ -121,6 +134,8 @@ private:
 
     int64_t mLastStallReportUs;
 
+    uint32_t mRegisteredPollEvents;
+
     void notifyError(bool send, status_t err, const char *detail);
     void notify(NotificationReason reason);
 
@@ -158,7 +173,8 @@ ANetworkSession::Session::Session(
       mSawReceiveFailure(false),
       mSawSendFailure(false),
       mUDPRetries(kMaxUDPRetries),
-      mLastStallReportUs(-1ll) {
+      mLastStallReportUs(-1ll),
+      mRegisteredPollEvents(0) {
     if (mState == CONNECTED) {
         struct sockaddr_in localAddr;
         socklen_t localAddrLen = sizeof(localAddr);
@@ -253,12 +269,36 @@ bool ANetworkSession::Session::wantsToWrite() {
             || (mState == DATAGRAM && !mOutFragments.empty()));
 }
 
+uint32_t ANetworkSession::Session::pollEvents() {
+    uint32_t events = 0;
+    if (wantsToRead()) {
+        events |= AEventPoller::EVENT_READ;
+    }
+    if (wantsToWrite()) {
+        events |= AEventPoller::EVENT_WRITE;
+    }
+    if (mState == DATAGRAM) {
+        // readMore() and writeMore() both keep going until the socket
+        // would block, which is all edge triggered polling requires.
+        events |= AEventPoller::EVENT_EDGE_TRIGGERED;
+    }
+    return events;
+}
+
+uint32_t ANetworkSession::Session::registeredPollEvents() const {
+    return mRegisteredPollEvents;
+}
+
+void ANetworkSession::Session::setRegisteredPollEvents(uint32_t events) {
+    mRegisteredPollEvents = events;
+}
+
 status_t ANetworkSession::Session::readMore() {
     if (mState == DATAGRAM) {
         CHECK_EQ(mMode, MODE_DATAGRAM);
 
         status_t err;
-        do {
+        for (;;) {
             sp<ABuffer> buf = new ABuffer(kMaxUDPSize);
 
             struct sockaddr_in remoteAddr;
@@ -271,12 +311,7 @@ status_t ANetworkSession::Session::readMore() {
                         (struct sockaddr *)&remoteAddr, &remoteAddrLen);
             } while (n < 0 && errno == EINTR);
 
-            err = OK;
-            if (n < 0) {
-                err = -errno;
-            } else if (n == 0) {
-                err = -ECONNRESET;
-            } else {
+            if (n > 0) {
                 buf->setRange(0, n);
 
                 int64_t nowUs = ALooper::GetNowUs();
@@ -300,25 +335,29 @@ status_t ANetworkSession::Session::readMore() {
 
                 notify->setBuffer("data", buf);
                 notify->post();
+                continue;
             }
-        } while (err == OK);
 
-        if (err == -EAGAIN) {
-            err = OK;
-        }
+            err = (n < 0) ? -errno : -ECONNRESET;
+
+            if (err == -EAGAIN) {
+                mUDPRetries = kMaxUDPRetries;
+                err = OK;
+                break;
+            }
 
-        if (err != OK) {
             if (!mUDPRetries) {
                 notifyError(false /* send */, err, "Recvfrom failed.");
                 mSawReceiveFailure = true;
-            } else {
-                mUDPRetries--;
-                ALOGE("Recvfrom failed, %d/%d retries left",
-                        mUDPRetries, kMaxUDPRetries);
-                err = OK;
+                break;
             }
-        } else {
-            mUDPRetries = kMaxUDPRetries;
+
+            // Keep reading after a transient error (e.g. ECONNREFUSED), the
+            // edge triggered poller won't report the datagrams queued behind
+            // it again.
+            mUDPRetries--;
+            ALOGE("Recvfrom failed, %d/%d retries left",
+                    mUDPRetries, kMaxUDPRetries);
         }
 
         return err;
@@ -786,7 +825,8 @@ void ANetworkSession::Session::notify(NotificationReason reason) {
 ////////////////////////////////////////////////////////////////////////////////
 
 ANetworkSession::ANetworkSession()
-    : mNextSessionID(1) {
+    : mNextSessionID(1),
+      mPoller(new AEventPoller) {
     mPipeFd[0] = mPipeFd[1] = -1;
 }
 
@@ -799,19 +839,29 @@ status_t ANetworkSession::start() {
         return INVALID_OPERATION;
     }
 
+    status_t err = mPoller->initCheck();
+    if (err != OK) {
+        return err;
+    }
+
     int res = pipe(mPipeFd);
     if (res != 0) {
         mPipeFd[0] = mPipeFd[1] = -1;
         return -errno;
     }
 
-    mThread = new NetworkThread(this);
+    err = mPoller->add(mPipeFd[0], AEventPoller::EVENT_READ, kPipeCookie);
 
-    status_t err = mThread->run("ANetworkSession", ANDROID_PRIORITY_AUDIO);
+    if (err == OK) {
+        mThread = new NetworkThread(this);
+
+        err = mThread->run("ANetworkSession", ANDROID_PRIORITY_AUDIO);
+    }
 
     if (err != OK) {
         mThread.clear();
 
+        mPoller->remove(mPipeFd[0]);
         close(mPipeFd[0]);
         close(mPipeFd[1]);
         mPipeFd[0] = mPipeFd[1] = -1;
@@ -833,6 +883,7 @@ status_t ANetworkSession::stop() {
 
     mThread.clear();
 
+    mPoller->remove(mPipeFd[0]);
     close(mPipeFd[0]);
     close(mPipeFd[1]);
     mPipeFd[0] = mPipeFd[1] = -1;
@@ -925,9 +976,12 @@ status_t ANetworkSession::destroySession(int32_t sessionID) {
         return -ENOENT;
     }
 
-    mSessions.removeItemsAt(index);
+    const sp<Session> session = mSessions.valueAt(index);
+    if (session->socket() >= 0) {
+        mPoller->remove(session->socket());
+    }
 
-    interrupt();
+    mSessions.removeItemsAt(index);
 
     return OK;
 }
@@ -1136,9 +1190,17 @@ status_t ANetworkSession::createClientOrServer(
         session->setMode(Session::MODE_RTSP);
     }
 
-    mSessions.add(session->sessionID(), session);
+    err = mPoller->add(s, session->pollEvents(), session->sessionID());
 
-    interrupt();
+    if (err != OK) {
+        // The session owns the socket from here on.
+        session.clear();
+        s = -1;
+        goto bail;
+    }
+
+    session->setRegisteredPollEvents(session->pollEvents());
+    mSessions.add(session->sessionID(), session);
 
     *sessionID = session->sessionID();
 
@@ -1205,7 +1267,9 @@ status_t ANetworkSession::sendRequest(
 
     status_t err = session->sendRequest(data, size, timeValid, timeUs);
 
-    interrupt();
+    // No need to interrupt the network thread, a blocked epoll_wait() picks
+    // up the new interest in writing right away.
+    updatePollEvents_l(session);
 
     return err;
 }
@@ -1236,164 +1300,163 @@ void ANetworkSession::interrupt() {
     }
 }
 
-void ANetworkSession::threadLoop() {
-    fd_set rs, ws;
-    FD_ZERO(&rs);
-    FD_ZERO(&ws);
-
-    FD_SET(mPipeFd[0], &rs);
-    int maxFd = mPipeFd[0];
+void ANetworkSession::updatePollEvents_l(const sp<Session> &session) {
+    int s = session->socket();
 
-    {
-        Mutex::Autolock autoLock(mLock);
+    if (s < 0) {
+        return;
+    }
 
-        for (size_t i = 0; i < mSessions.size(); ++i) {
-            const sp<Session> &session = mSessions.valueAt(i);
+    uint32_t events = session->pollEvents();
 
-            int s = session->socket();
+    // Re-arming an edge triggered registration makes the poller re-check
+    // the current state, this covers datagrams left queued after a send
+    // failure that did not end in EAGAIN.
+    bool rearm = (events & AEventPoller::EVENT_EDGE_TRIGGERED)
+            && (events & AEventPoller::EVENT_WRITE);
 
-            if (s < 0) {
-                continue;
-            }
-
-            if (session->wantsToRead()) {
-                FD_SET(s, &rs);
-                if (s > maxFd) {
-                    maxFd = s;
-                }
-            }
+    if (events == session->registeredPollEvents() && !rearm) {
+        return;
+    }
 
-            if (session->wantsToWrite()) {
-                FD_SET(s, &ws);
-                if (s > maxFd) {
-                    maxFd = s;
-                }
-            }
-        }
+    if (mPoller->modify(s, events, session->sessionID()) == OK) {
+        session->setRegisteredPollEvents(events);
     }
+}
 
-    int res = select(maxFd + 1, &rs, &ws, NULL, NULL /* tv */);
+void ANetworkSession::threadLoop() {
+    AEventPoller::Event events[kMaxEventsPerLoop];
 
-    if (res == 0) {
+    ssize_t res = mPoller->wait(events, kMaxEventsPerLoop, -1 /* timeoutMs */);
+
+    if (res <= 0) {
         return;
     }
 
-    if (res < 0) {
-        if (errno == EINTR) {
-            return;
-        }
+    Mutex::Autolock autoLock(mLock);
 
-        ALOGE("select failed w/ error %d (%s)", errno, strerror(errno));
-        return;
-    }
+    List<sp<Session> > sessionsToAdd;
 
-    if (FD_ISSET(mPipeFd[0], &rs)) {
-        char c;
-        ssize_t n;
-        do {
-            n = read(mPipeFd[0], &c, 1);
-        } while (n < 0 && errno == EINTR);
+    for (ssize_t i = 0; i < res; ++i) {
+        const AEventPoller::Event &event = events[i];
+
+        if (event.mCookie == kPipeCookie) {
+            char c[16];
+            ssize_t n;
+            do {
+                n = read(mPipeFd[0], c, sizeof(c));
+            } while (n < 0 && errno == EINTR);
 
-        if (n < 0) {
-            ALOGW("Error reading from pipe (%s)", strerror(errno));
+            if (n < 0) {
+                ALOGW("Error reading from pipe (%s)", strerror(errno));
+            }
+            continue;
         }
 
-        --res;
-    }
+        ssize_t index = mSessions.indexOfKey((int32_t)event.mCookie);
 
-    {
-        Mutex::Autolock autoLock(mLock);
+        if (index < 0) {
+            // Destroyed after the poller reported it.
+            continue;
+        }
 
-        List<sp<Session> > sessionsToAdd;
+        const sp<Session> session = mSessions.valueAt(index);
 
-        for (size_t i = mSessions.size(); res > 0 && i > 0;) {
-            i--;
-            const sp<Session> &session = mSessions.valueAt(i);
+        int s = session->socket();
 
-            int s = session->socket();
+        if (s < 0) {
+            continue;
+        }
 
-            if (s < 0) {
-                continue;
-            }
+        bool error = event.mEvents & AEventPoller::EVENT_ERROR;
 
-            if (FD_ISSET(s, &rs) || FD_ISSET(s, &ws)) {
-                --res;
-            }
+        if ((error || (event.mEvents & AEventPoller::EVENT_READ))
+                && session->wantsToRead()) {
+            if (session->isRTSPServer() || session->isTCPDatagramServer()) {
+                struct sockaddr_in remoteAddr;
+                socklen_t remoteAddrLen = sizeof(remoteAddr);
 
-            if (FD_ISSET(s, &rs)) {
-                if (session->isRTSPServer() || session->isTCPDatagramServer()) {
-                    struct sockaddr_in remoteAddr;
-                    socklen_t remoteAddrLen = sizeof(remoteAddr);
-
-                    int clientSocket = accept(
-                            s, (struct sockaddr *)&remoteAddr, &remoteAddrLen);
-
-                    if (clientSocket >= 0) {
-                        status_t err = MakeSocketNonBlocking(clientSocket);
-
-                        if (err != OK) {
-                            ALOGE("Unable to make client socket non blocking, "
-                                  "failed w/ error %d (%s)",
-                                  err, strerror(-err));
-
-                            close(clientSocket);
-                            clientSocket = -1;
-                        } else {
-                            in_addr_t addr = ntohl(remoteAddr.sin_addr.s_addr);
-
-                            ALOGI("incoming connection from %d.%d.%d.%d:%d "
-                                  "(socket %d)",
-                                  (addr >> 24),
-                                  (addr >> 16) & 0xff,
-                                  (addr >> 8) & 0xff,
-                                  addr & 0xff,
-                                  ntohs(remoteAddr.sin_port),
-                                  clientSocket);
-
-                            sp<Session> clientSession =
-                                new Session(
-                                        mNextSessionID++,
-                                        Session::CONNECTED,
-                                        clientSocket,
-                                        session->getNotificationMessage());
-
-                            clientSession->setMode(
-                                    session->isRTSPServer()
-                                        ? Session::MODE_RTSP
-                                        : Session::MODE_DATAGRAM);
-
-                            sessionsToAdd.push_back(clientSession);
-                        }
+                int clientSocket = accept(
+                        s, (struct sockaddr *)&remoteAddr, &remoteAddrLen);
+
+                if (clientSocket >= 0) {
+                    status_t err = MakeSocketNonBlocking(clientSocket);
+
+                    if (err != OK) {
+                        ALOGE("Unable to make client socket non blocking, "
+                              "failed w/ error %d (%s)",
+                              err, strerror(-err));
+
+                        close(clientSocket);
+                        clientSocket = -1;
                     } else {
-                        ALOGE("accept returned error %d (%s)",
-                              errno, strerror(errno));
+                        in_addr_t addr = ntohl(remoteAddr.sin_addr.s_addr);
+
+                        ALOGI("incoming connection from %d.%d.%d.%d:%d "
+                              "(socket %d)",
+                              (addr >> 24),
+                              (addr >> 16) & 0xff,
+                              (addr >> 8) & 0xff,
+                              addr & 0xff,
+                              ntohs(remoteAddr.sin_port),
+                              clientSocket);
+
+                        sp<Session> clientSession =
+                            new Session(
+                                    mNextSessionID++,
+                                    Session::CONNECTED,
+                                    clientSocket,
+                                    session->getNotificationMessage());
+
+                        clientSession->setMode(
+                                session->isRTSPServer()
+                                    ? Session::MODE_RTSP
+                                    : Session::MODE_DATAGRAM);
+
+                        sessionsToAdd.push_back(clientSession);
                     }
                 } else {
-                    status_t err = session->readMore();
-                    if (err != OK) {
-                        ALOGE("readMore on socket %d failed w/ error %d (%s)",
-                              s, err, strerror(-err));
-                    }
+                    ALOGE("accept returned error %d (%s)",
+                          errno, strerror(errno));
                 }
-            }
-
-            if (FD_ISSET(s, &ws)) {
-                status_t err = session->writeMore();
+            } else {
+                status_t err = session->readMore();
                 if (err != OK) {
-                    ALOGE("writeMore on socket %d failed w/ error %d (%s)",
+                    ALOGE("readMore on socket %d failed w/ error %d (%s)",
                           s, err, strerror(-err));
                 }
             }
         }
 
-        while (!sessionsToAdd.empty()) {
-            sp<Session> session = *sessionsToAdd.begin();
-            sessionsToAdd.erase(sessionsToAdd.begin());
+        if ((error || (event.mEvents & AEventPoller::EVENT_WRITE))
+                && session->wantsToWrite()) {
+            status_t err = session->writeMore();
+            if (err != OK) {
+                ALOGE("writeMore on socket %d failed w/ error %d (%s)",
+                      s, err, strerror(-err));
+            }
+        }
+
+        updatePollEvents_l(session);
+    }
+
+    while (!sessionsToAdd.empty()) {
+        sp<Session> session = *sessionsToAdd.begin();
+        sessionsToAdd.erase(sessionsToAdd.begin());
 
-            mSessions.add(session->sessionID(), session);
+        status_t err = mPoller->add(
+                session->socket(), session->pollEvents(), session->sessionID());
 
-            ALOGI("added clientSession %d", session->sessionID());
+        if (err != OK) {
+            ALOGE("Unable to poll clientSession %d, failed w/ error %d (%s)",
+                  session->sessionID(), err, strerror(-err));
+            continue;
         }
+
+        session->setRegisteredPollEvents(session->pollEvents());
+        mSessions.add(session->sessionID(), session);
+
+        ALOGI("added clientSession %d", session->sessionID());
     }
 }
 
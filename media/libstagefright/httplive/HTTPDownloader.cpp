@@ -228,7 +228,8 @@ ssize_t HTTPDownloader::fetchFile(
 }
 
 sp<M3UParser> HTTPDownloader::fetchPlaylist(
-        const char *url, uint8_t *curPlaylistHash, bool *unchanged) {
+        const char *url, uint8_t *curPlaylistHash, bool *unchanged,
+        const sp<M3UParser> &previous) {
     ALOGV("fetchPlaylist '%s'", url);
 
     *unchanged = false;
@@ -264,13 +265,18 @@ sp<M3UParser> HTTPDownloader::fetchPlaylist(
     }
 #endif
 
-    sp<M3UParser> playlist =
-        new M3UParser(actualUrl.c_str(), buffer->data(), buffer->size());
+    sp<M3UParser> playlist;
+    if (previous != NULL && previous->update(
+            actualUrl.c_str(), buffer->data(), buffer->size()) == OK) {
+        playlist = previous;
+    } else {
+        playlist = new M3UParser(actualUrl.c_str(), buffer->data(), buffer->size());
 
-    if (playlist->initCheck() != OK) {
-        ALOGE("failed to parse .m3u8 playlist");
+        if (playlist->initCheck() != OK) {
+            ALOGE("failed to parse .m3u8 playlist");
 
-        return NULL;
+            return NULL;
+        }
     }
 
 #if defined(__ANDROID__)
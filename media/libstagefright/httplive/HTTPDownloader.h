@@ -66,9 +66,11 @@ struct HTTPDownloader : public RefBase {
             sp<ABuffer> *out,
             String8 *actualUrl = NULL);
 
-    // fetch a playlist file
+    // fetch a playlist file; if "previous" is given and the new copy can be
+    // applied to it incrementally, it is updated in place and returned
     sp<M3UParser> fetchPlaylist(
-            const char *url, uint8_t *curPlaylistHash, bool *unchanged);
+            const char *url, uint8_t *curPlaylistHash, bool *unchanged,
+            const sp<M3UParser> &previous = NULL);
 
 private:
     sp<HTTPBase> mHTTPDataSource;
@@ -22,6 +22,7 @@
 #include "HTTPDownloader.h"
 #include "M3UParser.h"
 #include "PlaylistFetcher.h"
+#include "SegmentPrefetcher.h"
 
 #include <mpeg2ts/AnotherPacketSource.h>
 
@@ -54,6 +55,13 @@ const int64_t LiveSession::kResumeThresholdUs = 100000LL;
 // default buffer underflow mark
 static const int kUnderflowMarkMs = 1000;  // 1 second
 
+// Segment prefetch defaults, the number of segments fetched ahead can be
+// overridden (0 disables prefetching) with media.httplive.prefetch-segments.
+static const size_t kDefaultNumPrefetchSegments = 2;
+static const size_t kMaxNumPrefetchSegments = 8;
+static const size_t kNumPrefetchWorkers = 2;
+static const size_t kMaxPrefetchBufferedBytes = 16 * 1024 * 1024;
+
 struct LiveSession::BandwidthEstimator : public RefBase {
     BandwidthEstimator();
 
@@ -317,6 +325,9 @@ LiveSession::LiveSession(
 }
 
 LiveSession::~LiveSession() {
+    if (mSegmentPrefetcher != NULL) {
+        mSegmentPrefetcher->stop();
+    }
     if (mFetcherLooper != NULL) {
         mFetcherLooper->stop();
     }
@@ -495,6 +506,10 @@ sp<HTTPDownloader> LiveSession::getHTTPDownloader() {
     return new HTTPDownloader(mHTTPService, mExtraHeaders);
 }
 
+sp<SegmentPrefetcher> LiveSession::getSegmentPrefetcher() const {
+    return mSegmentPrefetcher;
+}
+
 void LiveSession::setBufferingSettings(
         const BufferingSettings &buffering) {
     sp<AMessage> msg = new AMessage(kWhatSetBufferingSettings, this);
@@ -919,6 +934,16 @@ void LiveSession::onMessageReceived(const sp<AMessage> &msg) {
             break;
         }
 
+        case kWhatPrefetcherNotify:
+        {
+            int32_t numBytes;
+            int64_t delayUs;
+            CHECK(msg->findInt32("bytes", &numBytes));
+            CHECK(msg->findInt64("delayUs", &delayUs));
+            addBandwidthMeasurement(numBytes, delayUs);
+            break;
+        }
+
         case kWhatChangeConfiguration:
         {
             onChangeConfiguration(msg);
@@ -1019,6 +1044,24 @@ void LiveSession::onConnect(const sp<AMessage> &msg) {
                               true  /* canCallJava */);
     }
 
+    if (mSegmentPrefetcher == NULL) {
+        size_t numSegments = kDefaultNumPrefetchSegments;
+        char value[PROPERTY_VALUE_MAX];
+        if (property_get("media.httplive.prefetch-segments", value, NULL)) {
+            char *end;
+            unsigned long n = strtoul(value, &end, 10);
+            if (end > value && *end == '\0') {
+                numSegments = min((size_t)n, kMaxNumPrefetchSegments);
+            }
+        }
+        if (numSegments > 0) {
+            ALOGV("prefetching %zu segments ahead", numSegments);
+            mSegmentPrefetcher = new SegmentPrefetcher(
+                    this, new AMessage(kWhatPrefetcherNotify, this),
+                    numSegments, kNumPrefetchWorkers, kMaxPrefetchBufferedBytes);
+        }
+    }
+
     // create fetcher to fetch the master playlist
     addFetcher(mMasterURL.c_str())->fetchPlaylistAsync();
 }
@@ -1149,6 +1192,10 @@ void LiveSession::finishDisconnect() {
     }
     mFetcherInfos.clear();
 
+    if (mSegmentPrefetcher != NULL) {
+        mSegmentPrefetcher->stop();
+    }
+
     mPacketSources.valueFor(STREAMTYPE_AUDIO)->signalEOS(ERROR_END_OF_STREAM);
     mPacketSources.valueFor(STREAMTYPE_VIDEO)->signalEOS(ERROR_END_OF_STREAM);
 
@@ -39,6 +39,7 @@ struct M3UParser;
 struct PlaylistFetcher;
 struct HLSTime;
 struct HTTPDownloader;
+struct SegmentPrefetcher;
 
 struct LiveSession : public AHandler {
     enum Flags {
@@ -82,6 +83,9 @@ struct LiveSession : public AHandler {
 
     sp<HTTPDownloader> getHTTPDownloader();
 
+    // NULL if segment prefetching is disabled.
+    sp<SegmentPrefetcher> getSegmentPrefetcher() const;
+
     void connectAsync(
             const char *url,
             const KeyedVector<String8, String8> *headers = NULL);
@@ -128,6 +132,7 @@ private:
         kWhatDisconnect                 = 'disc',
         kWhatSeek                       = 'seek',
         kWhatFetcherNotify              = 'notf',
+        kWhatPrefetcherNotify           = 'pfnf',
         kWhatChangeConfiguration        = 'chC0',
         kWhatChangeConfiguration2       = 'chC2',
         kWhatChangeConfiguration3       = 'chC3',
@@ -210,6 +215,7 @@ private:
     int32_t mMaxHeight;
 
     sp<ALooper> mFetcherLooper;
+    sp<SegmentPrefetcher> mSegmentPrefetcher;
     KeyedVector<AString, FetcherInfo> mFetcherInfos;
     uint32_t mStreamMask;
 
@@ -260,12 +260,31 @@ M3UParser::M3UParser(
       mFirstSeqNumber(-1),
       mLastSeqNumber(-1),
       mTargetDurationUs(-1LL),
+      mPartTargetDurationUs(-1LL),
+      mCanSkipUntilUs(-1LL),
       mDiscontinuitySeq(0),
       mDiscontinuityCount(0),
       mSelectedIndex(-1) {
     mInitCheck = parse(data, size);
 }
 
+M3UParser::M3UParser(const char *baseURI)
+    : mInitCheck(NO_INIT),
+      mBaseURI(baseURI),
+      mIsExtM3U(false),
+      mIsVariantPlaylist(false),
+      mIsComplete(false),
+      mIsEvent(false),
+      mFirstSeqNumber(-1),
+      mLastSeqNumber(-1),
+      mTargetDurationUs(-1LL),
+      mPartTargetDurationUs(-1LL),
+      mCanSkipUntilUs(-1LL),
+      mDiscontinuitySeq(0),
+      mDiscontinuityCount(0),
+      mSelectedIndex(-1) {
+}
+
 M3UParser::~M3UParser() {
 }
 
@@ -273,6 +292,65 @@ status_t M3UParser::initCheck() const {
     return mInitCheck;
 }
 
+status_t M3UParser::update(const char *baseURI, const void *data, size_t size) {
+    if (mInitCheck != OK || mIsVariantPlaylist || mIsComplete || mItems.empty()) {
+        return INVALID_OPERATION;
+    }
+
+    // Parse into a scratch playlist that continues where this one ends, so
+    // that nothing changes here unless all of the update is good.
+    sp<M3UParser> next = new M3UParser(baseURI);
+    status_t err = next->parse(data, size, this);
+    if (err != OK) {
+        return err;
+    }
+
+    size_t numDropped = next->mFirstSeqNumber - mFirstSeqNumber;
+    if (numDropped > 0) {
+        // A key applies to all segments up to the next key, the segments
+        // that are kept must not lose the one they were encrypted with.
+        const Item &first = mItems.itemAt(numDropped);
+        AString method;
+        if (!first.mMeta->findString("cipher-method", &method)) {
+            for (ssize_t i = numDropped - 1; i >= 0; --i) {
+                const sp<AMessage> &meta = mItems.itemAt(i).mMeta;
+                if (meta->findString("cipher-method", &method)) {
+                    sp<AMessage> firstMeta = first.mMeta->dup();
+                    const char *keys[] = {"cipher-method", "cipher-uri", "cipher-iv"};
+                    for (size_t j = 0; j < sizeof(keys) / sizeof(const char *); ++j) {
+                        AString val;
+                        if (meta->findString(keys[j], &val)) {
+                            firstMeta->setString(keys[j], val.c_str(), val.size());
+                        }
+                    }
+                    mItems.editItemAt(numDropped).mMeta = firstMeta;
+                    break;
+                }
+            }
+        }
+
+        mItems.removeItemsAt(0, numDropped);
+    }
+    mItems.appendVector(next->mItems);
+    mParts = next->mParts;
+
+    mBaseURI = next->mBaseURI;
+    mMeta = next->mMeta;
+    mIsComplete = next->mIsComplete;
+    mIsEvent = next->mIsEvent;
+    mFirstSeqNumber = next->mFirstSeqNumber;
+    mLastSeqNumber = next->mLastSeqNumber;
+    mTargetDurationUs = next->mTargetDurationUs;
+    mPartTargetDurationUs = next->mPartTargetDurationUs;
+    mCanSkipUntilUs = next->mCanSkipUntilUs;
+    mDiscontinuitySeq = next->mDiscontinuitySeq;
+
+    ALOGV("updated playlist: %zu segments dropped, %zu added",
+          numDropped, next->mItems.size());
+
+    return OK;
+}
+
 bool M3UParser::isExtM3U() const {
     return mIsExtM3U;
 }
@@ -306,6 +384,14 @@ void M3UParser::getSeqNumberRange(int32_t *firstSeq, int32_t *lastSeq) const {
     *lastSeq = mLastSeqNumber;
 }
 
+int64_t M3UParser::getPartTargetDuration() const {
+    return mPartTargetDurationUs;
+}
+
+int64_t M3UParser::getCanSkipUntilUs() const {
+    return mCanSkipUntilUs;
+}
+
 sp<AMessage> M3UParser::meta() {
     return mMeta;
 }
@@ -338,6 +424,34 @@ bool M3UParser::itemAt(size_t index, AString *uri, sp<AMessage> *meta) {
     return true;
 }
 
+size_t M3UParser::partCount() const {
+    return mParts.size();
+}
+
+bool M3UParser::partAt(size_t index, AString *uri, sp<AMessage> *meta) {
+    if (uri) {
+        uri->clear();
+    }
+
+    if (meta) {
+        *meta = NULL;
+    }
+
+    if (index >= mParts.size()) {
+        return false;
+    }
+
+    if (uri) {
+        *uri = mParts.itemAt(index).makeURL(mBaseURI.c_str());
+    }
+
+    if (meta) {
+        *meta = mParts.itemAt(index).mMeta;
+    }
+
+    return true;
+}
+
 void M3UParser::pickRandomMediaItems() {
     for (size_t i = 0; i < mMediaGroups.size(); ++i) {
         mMediaGroups.valueAt(i)->pickRandomMediaItems();
@@ -566,27 +680,76 @@ AString M3UParser::MediaGroup::Media::makeURL(const char *baseURL) const {
     return out;
 }
 
-status_t M3UParser::parse(const void *_data, size_t size) {
+status_t M3UParser::parse(
+        const void *_data, size_t size, const M3UParser *previous) {
     int32_t lineNo = 0;
 
     sp<AMessage> itemMeta;
+    Vector<Item> parts;
 
     const char *data = (const char *)_data;
     size_t offset = 0;
     uint64_t segmentRangeOffset = 0;
+    uint64_t partRangeOffset = 0;
+
+    // Number of segments already known to "previous" that are still to be
+    // skipped over, or -1 until the first segment is reached.
+    int32_t segmentsToSkip = previous != NULL ? -1 : 0;
+
     while (offset < size) {
-        size_t offsetLF = offset;
-        while (offsetLF < size && data[offsetLF] != '\n') {
-            ++offsetLF;
+        const char *lf = (const char *)memchr(&data[offset], '\n', size - offset);
+        size_t offsetLF = lf != NULL ? lf - data : size;
+
+        size_t lineLength = offsetLF - offset;
+        if (lineLength > 0 && data[offsetLF - 1] == '\r') {
+            --lineLength;
         }
 
-        AString line;
-        if (offsetLF > offset && data[offsetLF - 1] == '\r') {
-            line.setTo(&data[offset], offsetLF - offset - 1);
-        } else {
-            line.setTo(&data[offset], offsetLF - offset);
+        if (segmentsToSkip > 0) {
+            // Known segments are only scanned for their URI lines, which
+            // close them, and for EXT-X-SKIP, which stands in for several.
+            const char *s = &data[offset];
+            status_t err = OK;
+
+            if (lineLength > 0 && s[0] != '#') {
+                if (--segmentsToSkip == 0) {
+                    const AString &lastURI =
+                        previous->mItems.itemAt(previous->mItems.size() - 1).mURI;
+
+                    if (lineLength != lastURI.size()
+                            || memcmp(s, lastURI.c_str(), lineLength)) {
+                        ALOGV("playlist does not extend the previous one");
+                        return ERROR_MALFORMED;
+                    }
+                }
+            } else if (lineLength >= 11 && !memcmp(s, "#EXT-X-SKIP", 11)) {
+                int32_t numSkipped;
+                err = parseSkip(AString(s, lineLength), &numSkipped);
+                if (err == OK) {
+                    if (numSkipped > segmentsToSkip) {
+                        return ERROR_MALFORMED;
+                    }
+                    segmentsToSkip -= numSkipped;
+                }
+            }
+
+            if (err == OK && segmentsToSkip == 0) {
+                err = resumeAfter(previous, &segmentRangeOffset);
+                itemMeta.clear();
+                parts.clear();
+            }
+
+            if (err != OK) {
+                return err;
+            }
+
+            offset = offsetLF + 1;
+            ++lineNo;
+            continue;
         }
 
+        AString line(&data[offset], lineLength);
+
         // ALOGI("#%s#", line.c_str());
 
         if (line.empty()) {
@@ -598,6 +761,35 @@ status_t M3UParser::parse(const void *_data, size_t size) {
             mIsExtM3U = true;
         }
 
+        if (segmentsToSkip < 0
+                && (!line.startsWith("#")
+                    || line.startsWith("#EXTINF")
+                    || line.startsWith("#EXT-X-SKIP"))) {
+            // First segment; the header tells how many of the segments
+            // listed from here on are already known.
+            if (!mIsExtM3U || mIsVariantPlaylist) {
+                return ERROR_MALFORMED;
+            }
+
+            int32_t firstSeqNumber = 0;
+            if (mMeta != NULL) {
+                mMeta->findInt32("media-sequence", &firstSeqNumber);
+            }
+
+            if (firstSeqNumber < previous->mFirstSeqNumber
+                    || firstSeqNumber > previous->mLastSeqNumber) {
+                ALOGV("playlist window [%d, ...) does not overlap [%d, %d]",
+                      firstSeqNumber,
+                      previous->mFirstSeqNumber,
+                      previous->mLastSeqNumber);
+                return ERROR_MALFORMED;
+            }
+
+            // Look at this line again, as part of the known segments.
+            segmentsToSkip = previous->mLastSeqNumber - firstSeqNumber + 1;
+            continue;
+        }
+
         if (mIsExtM3U) {
             status_t err = OK;
 
@@ -670,6 +862,33 @@ status_t M3UParser::parse(const void *_data, size_t size) {
 
                     segmentRangeOffset = offset + length;
                 }
+            } else if (line.startsWith("#EXT-X-PART-INF")) {
+                if (mIsVariantPlaylist) {
+                    return ERROR_MALFORMED;
+                }
+                err = parsePartInf(line);
+            } else if (line.startsWith("#EXT-X-PART")) {
+                if (mIsVariantPlaylist) {
+                    return ERROR_MALFORMED;
+                }
+
+                Item part;
+                err = parsePart(line, partRangeOffset, &part);
+
+                if (err == OK) {
+                    int64_t rangeOffset, rangeLength;
+                    if (part.mMeta->findInt64("range-offset", &rangeOffset)
+                            && part.mMeta->findInt64("range-length", &rangeLength)) {
+                        partRangeOffset = rangeOffset + rangeLength;
+                    }
+                    parts.push(part);
+                }
+            } else if (line.startsWith("#EXT-X-SERVER-CONTROL")) {
+                err = parseServerControl(line);
+            } else if (line.startsWith("#EXT-X-SKIP")) {
+                // Only valid in an update of a playlist we already have.
+                ALOGE("Unexpected #EXT-X-SKIP in a full playlist");
+                return ERROR_MALFORMED;
             } else if (line.startsWith("#EXT-X-MEDIA")) {
                 err = parseMedia(line);
             }
@@ -693,6 +912,12 @@ status_t M3UParser::parse(const void *_data, size_t size) {
                         mDiscontinuitySeq + mDiscontinuityCount);
             }
 
+            if (!parts.empty()) {
+                itemMeta->setInt32("part-count", parts.size());
+                parts.clear();
+            }
+            partRangeOffset = 0;
+
             mItems.push();
             Item *item = &mItems.editItemAt(mItems.size() - 1);
 
@@ -707,12 +932,19 @@ status_t M3UParser::parse(const void *_data, size_t size) {
         ++lineNo;
     }
 
+    if (segmentsToSkip != 0) {
+        ALOGV("playlist ends within the segments already known");
+        return ERROR_MALFORMED;
+    }
+
     // playlist has no item, would cause exception
-    if (mItems.size() == 0) {
+    if (mItems.size() == 0 && previous == NULL) {
         ALOGE("playlist has no item");
         return ERROR_MALFORMED;
     }
 
+    mParts = parts;
+
     // error checking of all fields that's required to appear once
     // (currently only checking "target-duration"), and
     // initialization of playlist properties (eg. mTargetDurationUs)
@@ -729,7 +961,11 @@ status_t M3UParser::parse(const void *_data, size_t size) {
         if (mMeta != NULL) {
             mMeta->findInt32("media-sequence", &mFirstSeqNumber);
         }
-        mLastSeqNumber = mFirstSeqNumber + mItems.size() - 1;
+        if (previous != NULL) {
+            mLastSeqNumber = previous->mLastSeqNumber + mItems.size();
+        } else {
+            mLastSeqNumber = mFirstSeqNumber + mItems.size() - 1;
+        }
     }
 
     for (size_t i = 0; i < mItems.size(); ++i) {
@@ -751,6 +987,32 @@ status_t M3UParser::parse(const void *_data, size_t size) {
     return OK;
 }
 
+// Picks up the numbering state left after the last segment of "previous",
+// so that the segments that follow it get the same meta data a full parse
+// would have given them.
+status_t M3UParser::resumeAfter(
+        const M3UParser *previous, uint64_t *segmentRangeOffset) {
+    const sp<AMessage> &lastMeta =
+        previous->mItems.itemAt(previous->mItems.size() - 1).mMeta;
+
+    int32_t discontinuitySeq;
+    if (!lastMeta->findInt32("discontinuity-sequence", &discontinuitySeq)
+            || discontinuitySeq < (int32_t)mDiscontinuitySeq) {
+        return ERROR_MALFORMED;
+    }
+    mDiscontinuityCount = discontinuitySeq - mDiscontinuitySeq;
+
+    int64_t rangeOffset, rangeLength;
+    if (lastMeta->findInt64("range-offset", &rangeOffset)
+            && lastMeta->findInt64("range-length", &rangeLength)) {
+        *segmentRangeOffset = rangeOffset + rangeLength;
+    } else {
+        *segmentRangeOffset = 0;
+    }
+
+    return OK;
+}
+
 // static
 status_t M3UParser::parseMetaData(
         const AString &line, sp<AMessage> *meta, const char *key) {
@@ -822,6 +1084,49 @@ static ssize_t FindNextUnquoted(
     return -1;
 }
 
+// Splits the attribute list that follows the colon in "line" into keys,
+// lowercased, and their values, quotes included.
+static status_t ParseAttributeList(
+        const AString &line, KeyedVector<AString, AString> *attrs) {
+    ssize_t colonPos = line.find(":");
+
+    if (colonPos < 0) {
+        return ERROR_MALFORMED;
+    }
+
+    size_t offset = colonPos + 1;
+
+    while (offset < line.size()) {
+        ssize_t end = FindNextUnquoted(line, ',', offset);
+        if (end < 0) {
+            end = line.size();
+        }
+
+        AString attr(line, offset, end - offset);
+        attr.trim();
+
+        offset = end + 1;
+
+        ssize_t equalPos = attr.find("=");
+        if (equalPos < 0) {
+            continue;
+        }
+
+        AString key(attr, 0, equalPos);
+        key.trim();
+        key.tolower();
+
+        AString val(attr, equalPos + 1, attr.size() - equalPos - 1);
+        val.trim();
+
+        ALOGV("key=%s value=%s", key.c_str(), val.c_str());
+
+        attrs->add(key, val);
+    }
+
+    return OK;
+}
+
 status_t M3UParser::parseStreamInf(
         const AString &line, sp<AMessage> *meta) const {
     ssize_t colonPos = line.find(":");
@@ -999,6 +1304,129 @@ status_t M3UParser::parseCipherInfo(
     return OK;
 }
 
+status_t M3UParser::parsePartInf(const AString &line) {
+    KeyedVector<AString, AString> attrs;
+    status_t err = ParseAttributeList(line, &attrs);
+    if (err != OK) {
+        return err;
+    }
+
+    ssize_t index = attrs.indexOfKey(AString("part-target"));
+    if (index < 0) {
+        return ERROR_MALFORMED;
+    }
+
+    double x;
+    err = ParseDouble(attrs.valueAt(index).c_str(), &x);
+    if (err != OK) {
+        return err;
+    }
+    mPartTargetDurationUs = (int64_t)(x * 1E6);
+
+    return OK;
+}
+
+status_t M3UParser::parseServerControl(const AString &line) {
+    KeyedVector<AString, AString> attrs;
+    status_t err = ParseAttributeList(line, &attrs);
+    if (err != OK) {
+        return err;
+    }
+
+    ssize_t index = attrs.indexOfKey(AString("can-skip-until"));
+    if (index >= 0) {
+        double x;
+        err = ParseDouble(attrs.valueAt(index).c_str(), &x);
+        if (err != OK) {
+            return err;
+        }
+        mCanSkipUntilUs = (int64_t)(x * 1E6);
+    }
+
+    return OK;
+}
+
+// static
+status_t M3UParser::parsePart(
+        const AString &line, uint64_t curOffset, Item *part) {
+    KeyedVector<AString, AString> attrs;
+    status_t err = ParseAttributeList(line, &attrs);
+    if (err != OK) {
+        return err;
+    }
+
+    part->mMeta = new AMessage;
+
+    for (size_t i = 0; i < attrs.size(); ++i) {
+        const AString &key = attrs.keyAt(i);
+        const AString &val = attrs.valueAt(i);
+
+        if (key == "duration") {
+            double x;
+            err = ParseDouble(val.c_str(), &x);
+            if (err != OK) {
+                return err;
+            }
+            part->mMeta->setInt64("durationUs", (int64_t)(x * 1E6));
+        } else if (key == "uri" || key == "byterange") {
+            if (!isQuotedString(val)) {
+                ALOGE("Expected quoted string for %s attribute, "
+                      "got '%s' instead.",
+                      key.c_str(), val.c_str());
+
+                return ERROR_MALFORMED;
+            }
+
+            if (key == "uri") {
+                part->mURI = unquoteString(val);
+                continue;
+            }
+
+            // Same syntax as the value of #EXT-X-BYTERANGE.
+            AString range(":");
+            range.append(unquoteString(val));
+
+            uint64_t length, offset;
+            err = parseByteRange(range, curOffset, &length, &offset);
+            if (err != OK) {
+                return err;
+            }
+            part->mMeta->setInt64("range-offset", offset);
+            part->mMeta->setInt64("range-length", length);
+        } else if (key == "independent") {
+            part->mMeta->setInt32("independent", val == "YES");
+        }
+    }
+
+    int64_t durationUs;
+    if (part->mURI.empty() || !part->mMeta->findInt64("durationUs", &durationUs)) {
+        return ERROR_MALFORMED;
+    }
+
+    return OK;
+}
+
+// static
+status_t M3UParser::parseSkip(const AString &line, int32_t *numSkipped) {
+    KeyedVector<AString, AString> attrs;
+    status_t err = ParseAttributeList(line, &attrs);
+    if (err != OK) {
+        return err;
+    }
+
+    ssize_t index = attrs.indexOfKey(AString("skipped-segments"));
+    if (index < 0) {
+        return ERROR_MALFORMED;
+    }
+
+    err = ParseInt32(attrs.valueAt(index).c_str(), numSkipped);
+    if (err != OK) {
+        return err;
+    }
+
+    return *numSkipped >= 0 ? OK : ERROR_MALFORMED;
+}
+
 AString M3UParser::getFullCipherUri(const AString &partial) {
     AString full;
     if (MakeURL(mBaseURI.c_str(), partial.c_str(), &full)) {
@@ -31,6 +31,14 @@ struct M3UParser : public RefBase {
 
     status_t initCheck() const;
 
+    // Brings a live media playlist up to date with a newer copy of it,
+    // in place. Lines describing segments that are already known are only
+    // scanned, not parsed, and the ones that slid out of the window are
+    // dropped. The newer copy may be a delta update (EXT-X-SKIP). On failure
+    // the playlist is left untouched and the caller should parse the newer
+    // copy from scratch instead.
+    status_t update(const char *baseURI, const void *data, size_t size);
+
     bool isExtM3U() const;
     bool isVariantPlaylist() const;
     bool isComplete() const;
@@ -40,11 +48,25 @@ struct M3UParser : public RefBase {
     int32_t getFirstSeqNumber() const;
     void getSeqNumberRange(int32_t *firstSeq, int32_t *lastSeq) const;
 
+    // EXT-X-PART-INF:PART-TARGET, or -1 if the playlist has no partial
+    // segments.
+    int64_t getPartTargetDuration() const;
+
+    // EXT-X-SERVER-CONTROL:CAN-SKIP-UNTIL, or -1 if the server does not
+    // support delta updates.
+    int64_t getCanSkipUntilUs() const;
+
     sp<AMessage> meta();
 
     size_t size();
     bool itemAt(size_t index, AString *uri, sp<AMessage> *meta = NULL);
 
+    // Partial segments (EXT-X-PART) of the segment that is still being
+    // produced, i.e. those listed after the last complete segment. Parts of
+    // complete segments are only counted, in their "part-count" meta.
+    size_t partCount() const;
+    bool partAt(size_t index, AString *uri, sp<AMessage> *meta = NULL);
+
     void pickRandomMediaItems();
     status_t selectTrack(size_t index, bool select);
     size_t getTrackCount() const;
@@ -79,17 +101,25 @@ private:
     int32_t mFirstSeqNumber;
     int32_t mLastSeqNumber;
     int64_t mTargetDurationUs;
+    int64_t mPartTargetDurationUs;
+    int64_t mCanSkipUntilUs;
     size_t mDiscontinuitySeq;
     int32_t mDiscontinuityCount;
 
     sp<AMessage> mMeta;
     Vector<Item> mItems;
+    Vector<Item> mParts;
     ssize_t mSelectedIndex;
 
     // Media groups keyed by group ID.
     KeyedVector<AString, sp<MediaGroup> > mMediaGroups;
 
-    status_t parse(const void *data, size_t size);
+    explicit M3UParser(const char *baseURI);
+
+    // If "previous" is set, the segments it already knows about are skipped
+    // and only the ones that follow are added to mItems.
+    status_t parse(const void *data, size_t size, const M3UParser *previous = NULL);
+    status_t resumeAfter(const M3UParser *previous, uint64_t *segmentRangeOffset);
 
     static status_t parseMetaData(
             const AString &line, sp<AMessage> *meta, const char *key);
@@ -109,6 +139,12 @@ private:
 
     status_t parseMedia(const AString &line);
 
+    status_t parsePartInf(const AString &line);
+    status_t parseServerControl(const AString &line);
+
+    static status_t parsePart(const AString &line, uint64_t curOffset, Item *part);
+    static status_t parseSkip(const AString &line, int32_t *numSkipped);
+
     static status_t parseDiscontinuitySequence(const AString &line, size_t *seq);
 
     static status_t ParseInt32(const char *s, int32_t *x);
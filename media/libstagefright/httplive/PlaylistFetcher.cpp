@@ -24,6 +24,7 @@
 #include "HTTPDownloader.h"
 #include "LiveSession.h"
 #include "M3UParser.h"
+#include "SegmentPrefetcher.h"
 #include <ID3.h>
 #include <mpeg2ts/AnotherPacketSource.h>
 #include <mpeg2ts/HlsSampleDecryptor.h>
@@ -65,6 +66,7 @@ struct PlaylistFetcher::DownloadState : public RefBase {
             sp<AMessage> &itemMeta,
             sp<ABuffer> &buffer,
             sp<ABuffer> &tsBuffer,
+            sp<SegmentPrefetcher::Segment> &segment,
             int32_t &firstSeqNumberInPlaylist,
             int32_t &lastSeqNumberInPlaylist);
     void saveState(
@@ -72,6 +74,7 @@ struct PlaylistFetcher::DownloadState : public RefBase {
             sp<AMessage> &itemMeta,
             sp<ABuffer> &buffer,
             sp<ABuffer> &tsBuffer,
+            sp<SegmentPrefetcher::Segment> &segment,
             int32_t &firstSeqNumberInPlaylist,
             int32_t &lastSeqNumberInPlaylist);
 
@@ -81,6 +84,7 @@ private:
     sp<AMessage> mItemMeta;
     sp<ABuffer> mBuffer;
     sp<ABuffer> mTsBuffer;
+    sp<SegmentPrefetcher::Segment> mSegment;
     int32_t mFirstSeqNumberInPlaylist;
     int32_t mLastSeqNumberInPlaylist;
 };
@@ -100,6 +104,7 @@ void PlaylistFetcher::DownloadState::resetState() {
     mItemMeta = NULL;
     mBuffer = NULL;
     mTsBuffer = NULL;
+    mSegment = NULL;
     mFirstSeqNumberInPlaylist = 0;
     mLastSeqNumberInPlaylist = 0;
 }
@@ -109,6 +114,7 @@ void PlaylistFetcher::DownloadState::restoreState(
         sp<AMessage> &itemMeta,
         sp<ABuffer> &buffer,
         sp<ABuffer> &tsBuffer,
+        sp<SegmentPrefetcher::Segment> &segment,
         int32_t &firstSeqNumberInPlaylist,
         int32_t &lastSeqNumberInPlaylist) {
     if (!mHasSavedState) {
@@ -119,6 +125,7 @@ void PlaylistFetcher::DownloadState::restoreState(
     itemMeta = mItemMeta;
     buffer = mBuffer;
     tsBuffer = mTsBuffer;
+    segment = mSegment;
     firstSeqNumberInPlaylist = mFirstSeqNumberInPlaylist;
     lastSeqNumberInPlaylist = mLastSeqNumberInPlaylist;
 
@@ -130,6 +137,7 @@ void PlaylistFetcher::DownloadState::saveState(
         sp<AMessage> &itemMeta,
         sp<ABuffer> &buffer,
         sp<ABuffer> &tsBuffer,
+        sp<SegmentPrefetcher::Segment> &segment,
         int32_t &firstSeqNumberInPlaylist,
         int32_t &lastSeqNumberInPlaylist) {
     mHasSavedState = true;
@@ -138,6 +146,7 @@ void PlaylistFetcher::DownloadState::saveState(
     mItemMeta = itemMeta;
     mBuffer = buffer;
     mTsBuffer = tsBuffer;
+    mSegment = segment;
     mFirstSeqNumberInPlaylist = firstSeqNumberInPlaylist;
     mLastSeqNumberInPlaylist = lastSeqNumberInPlaylist;
 }
@@ -180,6 +189,8 @@ PlaylistFetcher::PlaylistFetcher(
       mHasMetadata(false) {
     memset(mPlaylistHash, 0, sizeof(mPlaylistHash));
     mHTTPDownloader = mSession->getHTTPDownloader();
+    mSegmentPrefetcher = mSession->getSegmentPrefetcher();
+    mPrefetchOwnerId = mSegmentPrefetcher != NULL ? mSegmentPrefetcher->newOwnerId() : -1;
 
     memset(mKeyData, 0, sizeof(mKeyData));
     memset(mAESInitVec, 0, sizeof(mAESInitVec));
@@ -525,6 +536,9 @@ void PlaylistFetcher::setStoppingThreshold(float thresholdRatio, bool disconnect
     }
     if (disconnect) {
         mHTTPDownloader->disconnect();
+        if (mSegmentPrefetcher != NULL) {
+            mSegmentPrefetcher->cancel(mPrefetchOwnerId);
+        }
     }
 }
 
@@ -779,6 +793,9 @@ status_t PlaylistFetcher::onStart(const sp<AMessage> &msg) {
         mSeqNumber = -1;
         mTimeChangeSignaled = false;
         mDownloadState->resetState();
+        if (mSegmentPrefetcher != NULL) {
+            mSegmentPrefetcher->cancel(mPrefetchOwnerId);
+        }
     }
 
     postMonitorQueue();
@@ -806,6 +823,9 @@ void PlaylistFetcher::onStop(const sp<AMessage> &msg) {
     }
 
     mDownloadState->resetState();
+    if (mSegmentPrefetcher != NULL) {
+        mSegmentPrefetcher->cancel(mPrefetchOwnerId);
+    }
     mPacketSources.clear();
     mStreamTypeMask = 0;
 
@@ -935,9 +955,29 @@ void PlaylistFetcher::onMonitorQueue() {
 
 status_t PlaylistFetcher::refreshPlaylist() {
     if (delayUsToRefreshPlaylist() <= 0) {
+        // Ask for a delta update (EXT-X-SKIP) if the server supports them
+        // and our copy is recent enough for one to apply.
+        AString url = mURI;
+        bool deltaUpdate = false;
+        if (mPlaylist != NULL
+                && mPlaylist->getCanSkipUntilUs() > 0
+                && mURI.startsWithIgnoreCase("http")
+                && ALooper::GetNowUs() - mLastPlaylistFetchTimeUs
+                        < mPlaylist->getCanSkipUntilUs() / 2) {
+            url.append(mURI.find("?") < 0 ? "?" : "&");
+            url.append("_HLS_skip=YES");
+            deltaUpdate = true;
+        }
+
         bool unchanged;
         sp<M3UParser> playlist = mHTTPDownloader->fetchPlaylist(
-                mURI.c_str(), mPlaylistHash, &unchanged);
+                url.c_str(), mPlaylistHash, &unchanged, mPlaylist);
+
+        if (playlist == NULL && !unchanged && deltaUpdate) {
+            ALOGW("delta update of playlist failed, fetching all of it");
+            playlist = mHTTPDownloader->fetchPlaylist(
+                    mURI.c_str(), mPlaylistHash, &unchanged, mPlaylist);
+        }
 
         if (playlist == NULL) {
             if (unchanged) {
@@ -1327,14 +1367,56 @@ bool PlaylistFetcher::initDownloadState(
     return true;
 }
 
+bool PlaylistFetcher::shouldPrefetchSegments() const {
+    // Subtitle segments are too small to be worth it, and when resuming
+    // until a stop point we don't know how many more segments are needed.
+    return mSegmentPrefetcher != NULL
+            && mStopParams == NULL
+            && (mStreamTypeMask
+                    & (LiveSession::STREAMTYPE_AUDIO
+                    | LiveSession::STREAMTYPE_VIDEO));
+}
+
+void PlaylistFetcher::prefetchSegmentsAfter(
+        int32_t seqNumber,
+        int32_t firstSeqNumberInPlaylist,
+        int32_t lastSeqNumberInPlaylist) {
+    int32_t numSegmentsAhead = mSegmentPrefetcher->getNumSegmentsAhead();
+    for (int32_t i = 1; i <= numSegmentsAhead; ++i) {
+        int32_t nextSeqNumber = seqNumber + i;
+        if (nextSeqNumber > lastSeqNumberInPlaylist) {
+            break;
+        }
+
+        AString uri;
+        sp<AMessage> itemMeta;
+        if (!mPlaylist->itemAt(
+                nextSeqNumber - firstSeqNumberInPlaylist, &uri, &itemMeta)) {
+            break;
+        }
+
+        int64_t range_offset, range_length;
+        if (!itemMeta->findInt64("range-offset", &range_offset)
+                || !itemMeta->findInt64("range-length", &range_length)) {
+            range_offset = 0;
+            range_length = -1;
+        }
+
+        mSegmentPrefetcher->prefetch(
+                mPrefetchOwnerId, nextSeqNumber, uri, range_offset, range_length);
+    }
+}
+
 void PlaylistFetcher::onDownloadNext() {
     AString uri;
     sp<AMessage> itemMeta;
     sp<ABuffer> buffer;
     sp<ABuffer> tsBuffer;
+    sp<SegmentPrefetcher::Segment> segment;
     int32_t firstSeqNumberInPlaylist = 0;
     int32_t lastSeqNumberInPlaylist = 0;
     bool connectHTTP = true;
+    bool resumed = false;
 
     if (mDownloadState->hasSavedState()) {
         mDownloadState->restoreState(
@@ -1342,9 +1424,11 @@ void PlaylistFetcher::onDownloadNext() {
                 itemMeta,
                 buffer,
                 tsBuffer,
+                segment,
                 firstSeqNumberInPlaylist,
                 lastSeqNumberInPlaylist);
         connectHTTP = false;
+        resumed = true;
         FLOGV("resuming: '%s'", uri.c_str());
     } else {
         if (!initDownloadState(
@@ -1364,14 +1448,42 @@ void PlaylistFetcher::onDownloadNext() {
         range_length = -1;
     }
 
+    // Pick up the current segment if it was queued while we were busy with
+    // the previous one. The pipeline behind it is refilled once its first
+    // block is in, so that read-ahead doesn't compete with the first bytes.
+    bool prefetchPending = false;
+    if (!resumed && shouldPrefetchSegments()) {
+        segment = mSegmentPrefetcher->take(
+                mPrefetchOwnerId, mSeqNumber, uri, range_offset, range_length);
+        prefetchPending = true;
+    }
+
     // block-wise download
     bool shouldPause = false;
     ssize_t bytesRead;
     do {
         int64_t startUs = ALooper::GetNowUs();
-        bytesRead = mHTTPDownloader->fetchBlock(
-                uri.c_str(), &buffer, range_offset, range_length, kDownloadBlockSize,
-                NULL /* actualURL */, connectHTTP);
+        if (segment != NULL) {
+            bytesRead = mSegmentPrefetcher->readBlock(
+                    segment, &buffer, kDownloadBlockSize);
+            if (bytesRead < 0) {
+                if (mHTTPDownloader->isDisconnecting()) {
+                    bytesRead = ERROR_NOT_CONNECTED;
+                } else {
+                    // Prefetch failed or was dropped; continue the download
+                    // from where it left off on our own connection.
+                    FLOGV("prefetched segment %d unusable (%zd), fetching directly",
+                            mSeqNumber, bytesRead);
+                    segment.clear();
+                    connectHTTP = true;
+                }
+            }
+        }
+        if (segment == NULL) {
+            bytesRead = mHTTPDownloader->fetchBlock(
+                    uri.c_str(), &buffer, range_offset, range_length, kDownloadBlockSize,
+                    NULL /* actualURL */, connectHTTP);
+        }
         int64_t delayUs = ALooper::GetNowUs() - startUs;
 
         if (bytesRead == ERROR_NOT_CONNECTED) {
@@ -1386,8 +1498,12 @@ void PlaylistFetcher::onDownloadNext() {
 
         // add sample for bandwidth estimation, excluding samples from subtitles (as
         // its too small), or during startup/resumeUntil (when we could have more than
-        // one connection open which affects bandwidth)
+        // one connection open which affects bandwidth). Prefetched blocks are
+        // accounted for by the prefetcher itself, and while it is busy our own
+        // transfer shares the link with its workers.
         if (!mStartup && mStopParams == NULL && bytesRead > 0
+                && segment == NULL
+                && (mSegmentPrefetcher == NULL || mSegmentPrefetcher->isIdle())
                 && (mStreamTypeMask
                         & (LiveSession::STREAMTYPE_AUDIO
                         | LiveSession::STREAMTYPE_VIDEO))) {
@@ -1400,6 +1516,12 @@ void PlaylistFetcher::onDownloadNext() {
 
         connectHTTP = false;
 
+        if (prefetchPending) {
+            prefetchSegmentsAfter(
+                    mSeqNumber, firstSeqNumberInPlaylist, lastSeqNumberInPlaylist);
+            prefetchPending = false;
+        }
+
         CHECK(buffer != NULL);
 
         size_t size = buffer->size();
@@ -1468,6 +1590,7 @@ void PlaylistFetcher::onDownloadNext() {
                         itemMeta,
                         buffer,
                         tsBuffer,
+                        segment,
                         firstSeqNumberInPlaylist,
                         lastSeqNumberInPlaylist);
                 return;
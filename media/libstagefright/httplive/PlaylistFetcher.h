@@ -32,6 +32,7 @@ class DataSource;
 struct HTTPBase;
 struct LiveDataSource;
 struct M3UParser;
+struct SegmentPrefetcher;
 class String8;
 
 struct PlaylistFetcher : public AHandler {
@@ -118,6 +119,8 @@ private:
     sp<AMessage> mStartTimeUsNotify;
 
     sp<HTTPDownloader> mHTTPDownloader;
+    sp<SegmentPrefetcher> mSegmentPrefetcher;
+    int32_t mPrefetchOwnerId;
     sp<LiveSession> mSession;
     AString mURI;
 
@@ -231,6 +234,11 @@ private:
             sp<AMessage> &itemMeta,
             int32_t &firstSeqNumberInPlaylist,
             int32_t &lastSeqNumberInPlaylist);
+    bool shouldPrefetchSegments() const;
+    void prefetchSegmentsAfter(
+            int32_t seqNumber,
+            int32_t firstSeqNumberInPlaylist,
+            int32_t lastSeqNumberInPlaylist);
 
     // Resume a fetcher to continue until the stopping point stored in msg.
     status_t onResumeUntil(const sp<AMessage> &msg);
@@ -0,0 +1,567 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "SegmentPrefetcher"
+#include <utils/Log.h>
+
+#include "SegmentPrefetcher.h"
+#include "HTTPDownloader.h"
+#include "LiveSession.h"
+#include "PlaylistFetcher.h"
+
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/AMessage.h>
+#include <media/stagefright/MediaErrors.h>
+#include <openssl/aes.h>
+#include <utils/Thread.h>
+
+namespace android {
+
+struct SegmentPrefetcher::WorkerThread : public Thread {
+    WorkerThread(SegmentPrefetcher *prefetcher, size_t index);
+
+protected:
+    virtual ~WorkerThread();
+
+private:
+    SegmentPrefetcher *mPrefetcher;
+    const size_t mIndex;
+
+    virtual bool threadLoop();
+
+    DISALLOW_EVIL_CONSTRUCTORS(WorkerThread);
+};
+
+SegmentPrefetcher::WorkerThread::WorkerThread(
+        SegmentPrefetcher *prefetcher, size_t index)
+    : mPrefetcher(prefetcher),
+      mIndex(index) {
+}
+
+SegmentPrefetcher::WorkerThread::~WorkerThread() {
+}
+
+bool SegmentPrefetcher::WorkerThread::threadLoop() {
+    return mPrefetcher->threadLoop(mIndex);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+SegmentPrefetcher::Segment::Segment(
+        int32_t ownerId,
+        int32_t seqNumber,
+        const AString &uri,
+        int64_t rangeOffset,
+        int64_t rangeLength)
+    : mOwnerId(ownerId),
+      mSeqNumber(seqNumber),
+      mUri(uri),
+      mRangeOffset(rangeOffset),
+      mRangeLength(rangeLength),
+      mState(QUEUED),
+      mStatus(OK),
+      mWanted(false),
+      mCancelled(false),
+      mHandedOut(false),
+      mBufferMayMove(false),
+      mReaderWaiting(false),
+      mAvailable(0),
+      mAccountedBytes(0) {
+}
+
+bool SegmentPrefetcher::Segment::matches(
+        int32_t ownerId,
+        int32_t seqNumber,
+        const AString &uri,
+        int64_t rangeOffset,
+        int64_t rangeLength) const {
+    return mOwnerId == ownerId
+            && mSeqNumber == seqNumber
+            && mRangeOffset == rangeOffset
+            && mRangeLength == rangeLength
+            && mUri == uri;
+}
+
+SegmentPrefetcher::SegmentPrefetcher(
+        const sp<LiveSession> &session,
+        const sp<AMessage> &notify,
+        size_t numSegmentsAhead,
+        size_t numWorkers,
+        size_t maxBufferedBytes)
+    : mNotify(notify),
+      mNumSegmentsAhead(numSegmentsAhead),
+      mMaxBufferedBytes(maxBufferedBytes),
+      mNextOwnerId(0),
+      mStarted(false),
+      mStopped(false),
+      mBufferedBytes(0),
+      mActiveTransfers(0),
+      mBusySinceUs(0),
+      mBusyUs(0),
+      mUnreportedBytes(0) {
+    // Each worker keeps its own connection, so that a segment download never
+    // has to wait for another one to finish.
+    for (size_t i = 0; i < numWorkers; ++i) {
+        Worker worker;
+        worker.mDownloader = session->getHTTPDownloader();
+        mWorkers.push(worker);
+    }
+}
+
+SegmentPrefetcher::~SegmentPrefetcher() {
+    stop();
+}
+
+size_t SegmentPrefetcher::getNumSegmentsAhead() const {
+    return mNumSegmentsAhead;
+}
+
+int32_t SegmentPrefetcher::newOwnerId() {
+    Mutex::Autolock autoLock(mLock);
+    return mNextOwnerId++;
+}
+
+void SegmentPrefetcher::startWorkers_l() {
+    if (mStarted) {
+        return;
+    }
+    mStarted = true;
+
+    for (size_t i = 0; i < mWorkers.size(); ++i) {
+        Worker &worker = mWorkers.editItemAt(i);
+        worker.mThread = new WorkerThread(this, i);
+        status_t err = worker.mThread->run("SegmentPrefetcher");
+        if (err != OK) {
+            ALOGE("failed to start prefetch worker %zu (%d)", i, err);
+            worker.mThread.clear();
+        }
+    }
+}
+
+void SegmentPrefetcher::prefetch(
+        int32_t ownerId,
+        int32_t seqNumber,
+        const AString &uri,
+        int64_t rangeOffset,
+        int64_t rangeLength) {
+    Mutex::Autolock autoLock(mLock);
+    if (mStopped) {
+        return;
+    }
+
+    for (List<sp<Segment> >::iterator it = mSegments.begin();
+            it != mSegments.end(); ++it) {
+        if ((*it)->matches(ownerId, seqNumber, uri, rangeOffset, rangeLength)) {
+            return;
+        }
+    }
+
+    ALOGV("[%d] prefetching segment %d", ownerId, seqNumber);
+    mSegments.push_back(
+            new Segment(ownerId, seqNumber, uri, rangeOffset, rangeLength));
+
+    startWorkers_l();
+    mCondition.broadcast();
+}
+
+sp<SegmentPrefetcher::Segment> SegmentPrefetcher::take(
+        int32_t ownerId,
+        int32_t seqNumber,
+        const AString &uri,
+        int64_t rangeOffset,
+        int64_t rangeLength) {
+    Mutex::Autolock autoLock(mLock);
+
+    sp<Segment> found;
+    List<sp<Segment> >::iterator foundIt = mSegments.end();
+    List<sp<Segment> >::iterator it = mSegments.begin();
+    while (it != mSegments.end()) {
+        const sp<Segment> &segment = *it;
+        if (segment->mOwnerId != ownerId) {
+            ++it;
+            continue;
+        }
+
+        if (found == NULL
+                && segment->matches(ownerId, seqNumber, uri, rangeOffset, rangeLength)
+                && (segment->mStatus == OK
+                        || segment->mStatus == ERROR_END_OF_STREAM)) {
+            found = segment;
+            foundIt = it++;
+        } else if (segment->mSeqNumber <= seqNumber
+                || segment->mSeqNumber > seqNumber + (int64_t)mNumSegmentsAhead) {
+            dropSegment_l(it++);
+        } else {
+            ++it;
+        }
+    }
+
+    if (found != NULL && found->mState == Segment::QUEUED
+            && numFreeWorkers_l() == 0) {
+        ALOGV("[%d] no worker free for segment %d, fetching directly",
+                ownerId, seqNumber);
+        dropSegment_l(foundIt);
+        found.clear();
+    }
+
+    if (found != NULL) {
+        ALOGV("[%d] using prefetched segment %d (%zu bytes ready)",
+                ownerId, seqNumber, found->mAvailable);
+        found->mWanted = true;
+        mCondition.broadcast();
+    }
+    return found;
+}
+
+size_t SegmentPrefetcher::numFreeWorkers_l() const {
+    size_t numFree = 0;
+    for (size_t i = 0; i < mWorkers.size(); ++i) {
+        if (mWorkers[i].mSegment == NULL) {
+            ++numFree;
+        }
+    }
+    // Free workers are about to start on the segments already wanted.
+    for (List<sp<Segment> >::const_iterator it = mSegments.begin();
+            it != mSegments.end() && numFree > 0; ++it) {
+        if ((*it)->mState == Segment::QUEUED && (*it)->mWanted) {
+            --numFree;
+        }
+    }
+    return numFree;
+}
+
+ssize_t SegmentPrefetcher::readBlock(
+        const sp<Segment> &segment, sp<ABuffer> *out, size_t maxBytes) {
+    size_t delivered = *out != NULL ? (*out)->size() : 0;
+    Mutex::Autolock autoLock(mLock);
+
+    if (!segment->mWanted) {
+        segment->mWanted = true;
+        mCondition.broadcast();
+    }
+
+    size_t n = 0;
+    for (;;) {
+        if (mStopped || segment->mCancelled) {
+            // The caller goes on writing to the buffer it has, make sure the
+            // worker is done with it.
+            while (segment->mHandedOut
+                    && segment->mState == Segment::DOWNLOADING) {
+                mCondition.wait(mLock);
+            }
+            segment->mReaderWaiting = false;
+            return ERROR_NOT_CONNECTED;
+        }
+
+        if (segment->mAvailable < delivered) {
+            ALOGE("read past the end of segment %d", segment->mSeqNumber);
+            segment->mReaderWaiting = false;
+            return ERROR_OUT_OF_RANGE;
+        }
+
+        bool done = segment->mState == Segment::DONE;
+        n = segment->mAvailable - delivered;
+        if (n > maxBytes) {
+            n = maxBytes;
+        }
+        if (!done) {
+            // Decryption must be fed whole cipher blocks until the end.
+            n -= n % AES_BLOCK_SIZE;
+        }
+        if (n > 0 && !segment->mBufferMayMove) {
+            break;
+        }
+
+        if (n == 0 && done) {
+            segment->mReaderWaiting = false;
+            status_t err = segment->mStatus;
+            if (err == ERROR_END_OF_STREAM) {
+                for (List<sp<Segment> >::iterator it = mSegments.begin();
+                        it != mSegments.end(); ++it) {
+                    if (*it == segment) {
+                        dropSegment_l(it);
+                        break;
+                    }
+                }
+                if (*out == NULL) {
+                    // Like fetchBlock(), always hand back a buffer.
+                    *out = new ABuffer(0);
+                }
+                return 0;
+            }
+            return err;
+        }
+
+        if (!segment->mReaderWaiting) {
+            segment->mReaderWaiting = true;
+            mCondition.broadcast();
+        }
+        mCondition.wait(mLock);
+    }
+    segment->mReaderWaiting = false;
+
+    // On the first block, or if the worker has since moved to a larger
+    // buffer; that one starts with a copy of what we had, see
+    // downloadSegment().
+    segment->mHandedOut = true;
+    *out = segment->mBuffer;
+    (*out)->setRange(0, delivered + n);
+
+    return n;
+}
+
+void SegmentPrefetcher::cancel(int32_t ownerId) {
+    Mutex::Autolock autoLock(mLock);
+
+    List<sp<Segment> >::iterator it = mSegments.begin();
+    while (it != mSegments.end()) {
+        if ((*it)->mOwnerId == ownerId) {
+            dropSegment_l(it++);
+        } else {
+            ++it;
+        }
+    }
+    mCondition.broadcast();
+}
+
+bool SegmentPrefetcher::isIdle() {
+    Mutex::Autolock autoLock(mLock);
+    return mActiveTransfers == 0;
+}
+
+void SegmentPrefetcher::stop() {
+    Vector<sp<WorkerThread> > threads;
+    {
+        Mutex::Autolock autoLock(mLock);
+        if (mStopped) {
+            return;
+        }
+        mStopped = true;
+
+        while (!mSegments.empty()) {
+            dropSegment_l(mSegments.begin());
+        }
+        for (size_t i = 0; i < mWorkers.size(); ++i) {
+            if (mWorkers[i].mThread != NULL) {
+                mWorkers[i].mThread->requestExit();
+                threads.push(mWorkers[i].mThread);
+            }
+        }
+        mCondition.broadcast();
+    }
+
+    for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i]->requestExitAndWait();
+    }
+}
+
+void SegmentPrefetcher::dropSegment_l(List<sp<Segment> >::iterator it) {
+    sp<Segment> segment = *it;
+    mSegments.erase(it);
+
+    segment->mCancelled = true;
+    mBufferedBytes -= segment->mAccountedBytes;
+    segment->mAccountedBytes = 0;
+
+    if (segment->mState == Segment::DOWNLOADING) {
+        for (size_t i = 0; i < mWorkers.size(); ++i) {
+            if (mWorkers[i].mSegment == segment) {
+                // Worker reconnects before starting on its next segment.
+                mWorkers[i].mDownloader->disconnect();
+                break;
+            }
+        }
+    }
+}
+
+void SegmentPrefetcher::onTransferStarted_l() {
+    if (mActiveTransfers++ == 0) {
+        mBusySinceUs = ALooper::GetNowUs();
+    }
+}
+
+void SegmentPrefetcher::onTransferStopped_l() {
+    CHECK_GT(mActiveTransfers, 0u);
+    if (--mActiveTransfers == 0) {
+        mBusyUs += ALooper::GetNowUs() - mBusySinceUs;
+    }
+}
+
+bool SegmentPrefetcher::accountBytes_l(
+        size_t numBytes, size_t *reportBytes, int64_t *reportUs) {
+    mUnreportedBytes += numBytes;
+    if (mUnreportedBytes < (size_t)PlaylistFetcher::kDownloadBlockSize) {
+        return false;
+    }
+
+    int64_t nowUs = ALooper::GetNowUs();
+    int64_t busyUs = mBusyUs;
+    if (mActiveTransfers > 0) {
+        busyUs += nowUs - mBusySinceUs;
+    }
+
+    *reportBytes = mUnreportedBytes;
+    *reportUs = busyUs;
+
+    mUnreportedBytes = 0;
+    mBusyUs = 0;
+    mBusySinceUs = nowUs;
+
+    return busyUs > 0;
+}
+
+bool SegmentPrefetcher::threadLoop(size_t index) {
+    sp<Segment> segment;
+    sp<HTTPDownloader> downloader;
+    {
+        Mutex::Autolock autoLock(mLock);
+        for (;;) {
+            if (mStopped) {
+                return false;
+            }
+
+            // Serve the segment a fetcher is blocked on before any
+            // read-ahead.
+            for (List<sp<Segment> >::iterator it = mSegments.begin();
+                    it != mSegments.end(); ++it) {
+                if ((*it)->mState != Segment::QUEUED) {
+                    continue;
+                }
+                if (segment == NULL || (*it)->mWanted) {
+                    segment = *it;
+                }
+                if (segment->mWanted) {
+                    break;
+                }
+            }
+            if (segment != NULL) {
+                break;
+            }
+            mCondition.wait(mLock);
+        }
+
+        segment->mState = Segment::DOWNLOADING;
+        mWorkers.editItemAt(index).mSegment = segment;
+        downloader = mWorkers[index].mDownloader;
+        downloader->reconnect();
+    }
+
+    downloadSegment(downloader, segment);
+
+    Mutex::Autolock autoLock(mLock);
+    segment->mState = Segment::DONE;
+    mWorkers.editItemAt(index).mSegment.clear();
+    mCondition.broadcast();
+
+    return true;
+}
+
+void SegmentPrefetcher::downloadSegment(
+        const sp<HTTPDownloader> &downloader, const sp<Segment> &segment) {
+    // fetchBlock() appends through a window onto segment->mBuffer, so that
+    // it never touches the range of the buffer object the owner reads.
+    sp<ABuffer> window;
+    sp<ABuffer> buffer;
+    bool connectHTTP = true;
+
+    for (;;) {
+        {
+            Mutex::Autolock autoLock(mLock);
+            for (;;) {
+                bool wait = !segment->mWanted && mBufferedBytes >= mMaxBufferedBytes;
+                // If the size is unknown, fetchBlock() moves to a larger
+                // buffer once this one fills up, copying the bytes the owner
+                // may be decrypting in place. Only let it do so while the
+                // owner waits for more, and hold back the buffer until then.
+                segment->mBufferMayMove = window != NULL
+                        && window->capacity() - window->size()
+                                <= (size_t)PlaylistFetcher::kDownloadBlockSize;
+                if (segment->mBufferMayMove && segment->mHandedOut
+                        && !segment->mReaderWaiting) {
+                    wait = true;
+                }
+                if (!wait || mStopped || segment->mCancelled) {
+                    break;
+                }
+                mCondition.wait(mLock);
+            }
+            if (mStopped || segment->mCancelled) {
+                segment->mBufferMayMove = false;
+                segment->mStatus = ERROR_NOT_CONNECTED;
+                return;
+            }
+            onTransferStarted_l();
+        }
+
+        ssize_t bytesRead = downloader->fetchBlock(
+                segment->mUri.c_str(), &buffer,
+                segment->mRangeOffset, segment->mRangeLength,
+                PlaylistFetcher::kDownloadBlockSize,
+                NULL /* actualUrl */, connectHTTP);
+        connectHTTP = false;
+
+        size_t reportBytes = 0;
+        int64_t reportUs = 0;
+        bool report = false;
+        {
+            Mutex::Autolock autoLock(mLock);
+            onTransferStopped_l();
+            segment->mBufferMayMove = false;
+
+            if (bytesRead < 0) {
+                if (!segment->mCancelled) {
+                    ALOGW("[%d] failed to prefetch segment %d (%zd)",
+                            segment->mOwnerId, segment->mSeqNumber, bytesRead);
+                }
+                segment->mStatus = bytesRead;
+                return;
+            }
+
+            if (bytesRead == 0) {
+                segment->mStatus = ERROR_END_OF_STREAM;
+                return;
+            }
+
+            if (buffer != window) {
+                // Allocated or grown by fetchBlock(), which is done with its
+                // range now.
+                segment->mBuffer = buffer;
+                window = new ABuffer(buffer->data(), buffer->capacity());
+                window->setRange(0, buffer->size());
+                buffer = window;
+            }
+            segment->mAvailable = buffer->size();
+            if (!segment->mCancelled) {
+                mBufferedBytes += bytesRead;
+                segment->mAccountedBytes += bytesRead;
+            }
+            report = accountBytes_l(bytesRead, &reportBytes, &reportUs);
+            mCondition.broadcast();
+        }
+
+        if (report) {
+            sp<AMessage> notify = mNotify->dup();
+            notify->setInt32("bytes", reportBytes);
+            notify->setInt64("delayUs", reportUs);
+            notify->post();
+        }
+    }
+}
+
+}  // namespace android
@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SEGMENT_PREFETCHER_H_
+
+#define SEGMENT_PREFETCHER_H_
+
+#include <media/stagefright/foundation/ABase.h>
+#include <media/stagefright/foundation/AString.h>
+#include <utils/Condition.h>
+#include <utils/List.h>
+#include <utils/Mutex.h>
+#include <utils/RefBase.h>
+#include <utils/Vector.h>
+
+namespace android {
+
+struct ABuffer;
+struct AMessage;
+struct HTTPDownloader;
+struct LiveSession;
+
+// Downloads media segments ahead of the PlaylistFetchers that will consume
+// them, over a small pool of worker threads shared by all fetchers of a
+// LiveSession. Segments are handed to the owning fetcher while they are
+// still downloading so that it can decrypt and extract them block by block
+// as the bytes arrive.
+//
+// Bandwidth samples are taken from the pool as a whole: bytes received by
+// any worker are accounted against the wall time during which at least one
+// transfer was in progress, and posted to the session every few blocks
+// rather than at the end of a segment.
+struct SegmentPrefetcher : public RefBase {
+    // Only touched by SegmentPrefetcher, with mLock held; consumers treat it
+    // as an opaque handle.
+    struct Segment : public RefBase {
+        Segment(int32_t ownerId,
+                int32_t seqNumber,
+                const AString &uri,
+                int64_t rangeOffset,
+                int64_t rangeLength);
+
+        bool matches(
+                int32_t ownerId,
+                int32_t seqNumber,
+                const AString &uri,
+                int64_t rangeOffset,
+                int64_t rangeLength) const;
+
+        enum State {
+            QUEUED,
+            DOWNLOADING,
+            DONE,
+        };
+
+        const int32_t mOwnerId;
+        const int32_t mSeqNumber;
+        const AString mUri;
+        const int64_t mRangeOffset;
+        const int64_t mRangeLength;
+
+        State mState;
+        // OK while downloading, ERROR_END_OF_STREAM once complete.
+        status_t mStatus;
+        // Set when the owner is (about to be) reading this segment; such
+        // downloads are picked first and not held back by the memory limit.
+        bool mWanted;
+        bool mCancelled;
+        // Filled by the worker through a window of its own; once handed out
+        // the buffer object, and the bytes below mAvailable, belong to the
+        // owner.
+        sp<ABuffer> mBuffer;
+        bool mHandedOut;
+        // Set while a transfer may move the download to a larger buffer.
+        bool mBufferMayMove;
+        // Set while the owner blocks in readBlock().
+        bool mReaderWaiting;
+        size_t mAvailable;
+        size_t mAccountedBytes;
+
+    private:
+        DISALLOW_EVIL_CONSTRUCTORS(Segment);
+    };
+
+    // Bandwidth samples are posted on a copy of "notify", with the
+    // "bytes" (int32) and "delayUs" (int64) they were measured over.
+    SegmentPrefetcher(
+            const sp<LiveSession> &session,
+            const sp<AMessage> &notify,
+            size_t numSegmentsAhead,
+            size_t numWorkers,
+            size_t maxBufferedBytes);
+
+    // Number of segments each owner should keep queued past the one it is
+    // currently reading.
+    size_t getNumSegmentsAhead() const;
+
+    // Returns an id that identifies a consumer (one per PlaylistFetcher).
+    int32_t newOwnerId();
+
+    // Queues a download of the given segment for "ownerId", unless it is
+    // already queued or downloaded.
+    void prefetch(
+            int32_t ownerId,
+            int32_t seqNumber,
+            const AString &uri,
+            int64_t rangeOffset,
+            int64_t rangeLength);
+
+    // Returns the segment previously queued by "ownerId" for seqNumber, or
+    // NULL if there is none. Segments of the same owner that lie before
+    // seqNumber, or too far past it, are dropped. A segment not started yet
+    // is dropped too if no worker is free to start it right away: the owner
+    // fetches it faster on its own connection than by waiting for a worker
+    // to finish a read-ahead segment.
+    sp<Segment> take(
+            int32_t ownerId,
+            int32_t seqNumber,
+            const AString &uri,
+            int64_t rangeOffset,
+            int64_t rangeLength);
+
+    // Same contract as HTTPDownloader::fetchBlock() for the given segment:
+    // appends up to maxBytes to *out, blocking until at least one cipher
+    // block is available. Returns the number of bytes appended, 0 at the end
+    // of the segment, or an error. ERROR_NOT_CONNECTED is returned if the
+    // segment was cancelled.
+    // *out must be NULL or what the previous call for the segment returned
+    // in it. It is set to the buffer the segment is downloaded into, not to
+    // a copy, and may be replaced by a larger one if the download outgrows
+    // it.
+    ssize_t readBlock(
+            const sp<Segment> &segment, sp<ABuffer> *out, size_t maxBytes);
+
+    // Drops all segments of "ownerId", aborting their downloads and waking
+    // up any reader.
+    void cancel(int32_t ownerId);
+
+    // True if no segment download is currently in progress.
+    bool isIdle();
+
+    // Aborts everything and waits for the worker threads to exit.
+    void stop();
+
+protected:
+    virtual ~SegmentPrefetcher();
+
+private:
+    struct WorkerThread;
+
+    struct Worker {
+        sp<WorkerThread> mThread;
+        sp<HTTPDownloader> mDownloader;
+        sp<Segment> mSegment;
+    };
+
+    sp<AMessage> mNotify;
+    const size_t mNumSegmentsAhead;
+    const size_t mMaxBufferedBytes;
+
+    Mutex mLock;
+    Condition mCondition;
+    int32_t mNextOwnerId;
+    bool mStarted;
+    bool mStopped;
+    Vector<Worker> mWorkers;
+    List<sp<Segment> > mSegments;
+    size_t mBufferedBytes;
+
+    // Pool-wide bandwidth accounting.
+    size_t mActiveTransfers;
+    int64_t mBusySinceUs;
+    int64_t mBusyUs;
+    size_t mUnreportedBytes;
+
+    bool threadLoop(size_t index);
+    void startWorkers_l();
+    size_t numFreeWorkers_l() const;
+    void downloadSegment(
+            const sp<HTTPDownloader> &downloader, const sp<Segment> &segment);
+    void onTransferStarted_l();
+    void onTransferStopped_l();
+    bool accountBytes_l(size_t numBytes, size_t *reportBytes, int64_t *reportUs);
+    void dropSegment_l(List<sp<Segment> >::iterator it);
+
+    DISALLOW_EVIL_CONSTRUCTORS(SegmentPrefetcher);
+};
+
+}  // namespace android
+
+#endif  // SEGMENT_PREFETCHER_H_
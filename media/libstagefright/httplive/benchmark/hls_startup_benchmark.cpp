@@ -0,0 +1,374 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Plays a recorded HLS ladder through LiveSession from a local stand-in for
+// the HTTP stack and measures time-to-first-frame and the latency of a
+// bandwidth down-switch, with and without segment prefetching.
+//
+// Usage (as root, so media.httplive.* can be set):
+//     hls_startup_benchmark [benchmark flags] [ladder directory]
+//
+// The ladder directory (default /data/local/tmp/hls_ladder) must contain a
+// master playlist named master.m3u8 with at least two video variants, using
+// relative URIs. Every request pays a fixed round trip latency, and all
+// connections share one simulated link whose rate drops once playback has
+// warmed up; the switch latency is the time from that drop until the first
+// video access unit of another variant is dequeued.
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <android-base/properties.h>
+#include <benchmark/benchmark.h>
+
+#include <LiveSession.h>
+#include <media/MediaHTTPConnection.h>
+#include <media/MediaHTTPService.h>
+#include <media/stagefright/MediaErrors.h>
+#include <media/stagefright/MetaData.h>
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/foundation/AHandler.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/AMessage.h>
+
+using namespace android;
+
+static constexpr char kUrlPrefix[] = "http://hls.local/";
+static constexpr char kDefaultLadder[] = "/data/local/tmp/hls_ladder";
+static constexpr int64_t kRequestLatencyUs = 40000ll;
+static constexpr int64_t kFastLinkBps = 40000000ll;
+static constexpr int64_t kSlowLinkBps = 1500000ll;
+static constexpr int64_t kWarmupUs = 10000000ll;
+static constexpr int64_t kMaxPlaybackUs = 60000000ll;
+static constexpr int64_t kPrerollUs = 100000ll;
+static constexpr int64_t kPollIntervalUs = 2000ll;
+
+static std::string gLadder = kDefaultLadder;
+
+// Serializes all transfers over one link of a given rate.
+struct SimulatedLink {
+    void setRate(int64_t bitsPerSecond) {
+        std::lock_guard<std::mutex> lock(mLock);
+        mBitsPerSecond = bitsPerSecond;
+    }
+
+    void transfer(size_t numBytes) {
+        int64_t doneUs;
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            int64_t startUs = std::max(ALooper::GetNowUs(), mIdleAtUs);
+            doneUs = startUs + (int64_t)numBytes * 8 * 1000000ll / mBitsPerSecond;
+            mIdleAtUs = doneUs;
+        }
+        int64_t delayUs = doneUs - ALooper::GetNowUs();
+        if (delayUs > 0) {
+            usleep(delayUs);
+        }
+    }
+
+private:
+    std::mutex mLock;
+    int64_t mBitsPerSecond = kFastLinkBps;
+    int64_t mIdleAtUs = 0;
+};
+
+static SimulatedLink gLink;
+
+struct LocalHTTPConnection : public MediaHTTPConnection {
+    LocalHTTPConnection() {}
+
+    bool connect(const char *uri, const KeyedVector<String8, String8> *headers) override {
+        closeFile();
+        mDisconnected = false;
+        mUri = uri;
+
+        if (strncmp(uri, kUrlPrefix, strlen(kUrlPrefix))) {
+            return false;
+        }
+        std::string path = gLadder + "/" + (uri + strlen(kUrlPrefix));
+        mFd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (mFd < 0 || fstat(mFd, &st) < 0) {
+            closeFile();
+            return false;
+        }
+
+        mStart = 0;
+        mLength = st.st_size;
+        ssize_t index = headers != NULL ? headers->indexOfKey(String8("Range")) : -1;
+        if (index >= 0) {
+            long long first = 0, last = -1;
+            int n = sscanf(headers->valueAt(index).c_str(), "bytes=%lld-%lld", &first, &last);
+            if (n < 1 || first > st.st_size) {
+                closeFile();
+                return false;
+            }
+            mStart = first;
+            mLength = (n == 2 ? std::min<off64_t>(last + 1, st.st_size) : st.st_size) - first;
+        }
+
+        usleep(kRequestLatencyUs);
+        return true;
+    }
+
+    void disconnect() override {
+        mDisconnected = true;
+    }
+
+    ssize_t readAt(off64_t offset, void *data, size_t size) override {
+        if (mDisconnected || mFd < 0) {
+            return ERROR_NOT_CONNECTED;
+        }
+        if (offset >= mLength) {
+            return 0;
+        }
+        size = std::min<off64_t>(size, mLength - offset);
+        ssize_t n = pread(mFd, data, size, mStart + offset);
+        if (n > 0) {
+            gLink.transfer(n);
+        }
+        return n < 0 ? ERROR_IO : n;
+    }
+
+    off64_t getSize() override {
+        return mLength;
+    }
+
+    status_t getMIMEType(String8 *mimeType) override {
+        if (mUri.size() >= 5 && mUri.compare(mUri.size() - 5, 5, ".m3u8") == 0) {
+            *mimeType = "application/vnd.apple.mpegurl";
+        } else {
+            *mimeType = "video/mp2t";
+        }
+        return OK;
+    }
+
+    status_t getUri(String8 *uri) override {
+        *uri = mUri.c_str();
+        return OK;
+    }
+
+protected:
+    ~LocalHTTPConnection() override {
+        closeFile();
+    }
+
+private:
+    std::atomic<bool> mDisconnected = false;
+    std::string mUri;
+    int mFd = -1;
+    off64_t mStart = 0;
+    off64_t mLength = 0;
+
+    void closeFile() {
+        if (mFd >= 0) {
+            close(mFd);
+            mFd = -1;
+        }
+    }
+
+    DISALLOW_EVIL_CONSTRUCTORS(LocalHTTPConnection);
+};
+
+struct LocalHTTPService : public MediaHTTPService {
+    LocalHTTPService() {}
+
+    sp<MediaHTTPConnection> makeHTTPConnection() override {
+        return new LocalHTTPConnection();
+    }
+
+private:
+    DISALLOW_EVIL_CONSTRUCTORS(LocalHTTPService);
+};
+
+struct SessionObserver : public AHandler {
+    SessionObserver() {}
+
+    // Returns OK once prepared, or the preparation error.
+    status_t waitForPrepared() {
+        std::unique_lock<std::mutex> lock(mLock);
+        mCondition.wait(lock, [this] { return mPrepared; });
+        return mPrepareResult;
+    }
+
+protected:
+    void onMessageReceived(const sp<AMessage> &msg) override {
+        int32_t what;
+        if (!msg->findInt32("what", &what)) {
+            return;
+        }
+        if (what == LiveSession::kWhatPrepared
+                || what == LiveSession::kWhatPreparationFailed) {
+            std::lock_guard<std::mutex> lock(mLock);
+            mPrepared = true;
+            if (what == LiveSession::kWhatPreparationFailed
+                    && !msg->findInt32("err", &mPrepareResult)) {
+                mPrepareResult = UNKNOWN_ERROR;
+            }
+            mCondition.notify_all();
+        }
+    }
+
+private:
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    bool mPrepared = false;
+    status_t mPrepareResult = OK;
+};
+
+// Dequeues one stream at playback rate, keeping one access unit back until
+// it is due.
+struct StreamPlayer {
+    StreamPlayer(const sp<LiveSession> &session, LiveSession::StreamType stream)
+        : mSession(session), mStream(stream) {}
+
+    // Returns the number of access units dequeued and sets *format to the
+    // format of the last one.
+    size_t play(int64_t clockUs, sp<RefBase> *format) {
+        size_t count = 0;
+        for (;;) {
+            if (mPending == NULL) {
+                status_t err = mSession->dequeueAccessUnit(mStream, &mPending);
+                if (err != OK) {
+                    mPending.clear();
+                    return count;
+                }
+            }
+            int64_t timeUs;
+            if (clockUs >= 0 && mPending->meta()->findInt64("timeUs", &timeUs)
+                    && timeUs > clockUs + kPrerollUs) {
+                return count;
+            }
+            if (format != NULL) {
+                mPending->meta()->findObject("format", format);
+            }
+            mPending.clear();
+            ++count;
+        }
+    }
+
+private:
+    sp<LiveSession> mSession;
+    LiveSession::StreamType mStream;
+    sp<ABuffer> mPending;
+};
+
+static void BM_StartupAndSwitch(benchmark::State &state) {
+    android::base::SetProperty(
+            "media.httplive.prefetch-segments", std::to_string(state.range(0)));
+
+    double totalFirstFrameMs = 0;
+    double totalSwitchMs = 0;
+    size_t numSwitches = 0;
+
+    for (auto _ : state) {
+        gLink.setRate(kFastLinkBps);
+
+        sp<ALooper> looper = new ALooper;
+        looper->setName("hls_startup_benchmark");
+        looper->start();
+
+        sp<SessionObserver> observer = new SessionObserver;
+        looper->registerHandler(observer);
+
+        sp<LiveSession> session = new LiveSession(
+                new AMessage(0, observer), 0 /* flags */, new LocalHTTPService);
+        looper->registerHandler(session);
+
+        std::string url = std::string(kUrlPrefix) + "master.m3u8";
+        int64_t startUs = ALooper::GetNowUs();
+        session->connectAsync(url.c_str());
+
+        StreamPlayer video(session, LiveSession::STREAMTYPE_VIDEO);
+        StreamPlayer audio(session, LiveSession::STREAMTYPE_AUDIO);
+        int64_t firstFrameUs = -1;
+        int64_t linkDropUs = -1;
+        sp<RefBase> initialFormat;
+
+        for (;;) {
+            int64_t nowUs = ALooper::GetNowUs();
+            if (nowUs - startUs > kMaxPlaybackUs) {
+                break;
+            }
+
+            int64_t clockUs = firstFrameUs < 0 ? -1 : nowUs - firstFrameUs;
+            sp<RefBase> format;
+            if (video.play(clockUs, &format) > 0) {
+                if (firstFrameUs < 0) {
+                    firstFrameUs = ALooper::GetNowUs();
+                    initialFormat = format;
+                    totalFirstFrameMs += (firstFrameUs - startUs) / 1000.0;
+                    state.SetIterationTime((firstFrameUs - startUs) / 1e6);
+                } else if (linkDropUs >= 0 && format != initialFormat) {
+                    totalSwitchMs += (nowUs - linkDropUs) / 1000.0;
+                    ++numSwitches;
+                    break;
+                }
+            }
+            audio.play(clockUs, NULL);
+
+            if (firstFrameUs >= 0 && linkDropUs < 0 && nowUs - firstFrameUs >= kWarmupUs) {
+                gLink.setRate(kSlowLinkBps);
+                linkDropUs = nowUs;
+            }
+            usleep(kPollIntervalUs);
+        }
+
+        session->disconnect();
+        looper->unregisterHandler(session->id());
+        looper->unregisterHandler(observer->id());
+        looper->stop();
+
+        if (firstFrameUs < 0) {
+            state.SkipWithError("no video frame played, check the ladder");
+            break;
+        }
+    }
+
+    size_t iterations = state.iterations();
+    state.counters["first_frame_ms"] = iterations > 0 ? totalFirstFrameMs / iterations : 0.0;
+    state.counters["switch_ms"] = numSwitches > 0 ? totalSwitchMs / numSwitches : 0.0;
+    state.counters["switches"] = numSwitches;
+}
+
+// Argument is the number of segments prefetched ahead (0 disables it).
+BENCHMARK(BM_StartupAndSwitch)
+        ->Arg(0)
+        ->Arg(2)
+        ->Iterations(3)
+        ->UseManualTime()
+        ->Unit(benchmark::kMillisecond);
+
+int main(int argc, char **argv) {
+    benchmark::Initialize(&argc, argv);
+    if (argc > 1) {
+        gLadder = argv[1];
+    }
+    if (access((gLadder + "/master.m3u8").c_str(), R_OK) != 0) {
+        fprintf(stderr, "no HLS ladder found at %s\n", gLadder.c_str());
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
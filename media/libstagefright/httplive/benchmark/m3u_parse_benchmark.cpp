@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the cost of a live playlist reload in M3UParser over large
+// synthetic low-latency media playlists: a full parse of the new copy, an
+// incremental update of the previous copy, and an incremental update from a
+// delta playlist (EXT-X-SKIP).
+
+#include <benchmark/benchmark.h>
+
+#include <M3UParser.h>
+#include <media/stagefright/foundation/AString.h>
+
+using namespace android;
+
+static constexpr char kBaseURI[] = "http://hls.local/live/index.m3u8";
+// Segments listed explicitly at the end of a delta playlist.
+static constexpr size_t kNumRecentSegments = 3;
+static constexpr size_t kNumPartsPerSegment = 4;
+static constexpr int32_t kKeyRotationInterval = 100;
+
+// Returns a live playlist of numSegments segments starting at firstSeq, of
+// which the first numSkipped are left out as in a delta update. The last
+// segments are also announced as parts, and the segment after them is
+// partially available.
+static AString makePlaylist(int32_t firstSeq, size_t numSegments, size_t numSkipped) {
+    AString s;
+    s.append("#EXTM3U\n"
+             "#EXT-X-VERSION:9\n"
+             "#EXT-X-TARGETDURATION:4\n"
+             "#EXT-X-SERVER-CONTROL:CAN-SKIP-UNTIL=24.0\n"
+             "#EXT-X-PART-INF:PART-TARGET=1.0\n");
+    s.append(AStringPrintf("#EXT-X-MEDIA-SEQUENCE:%d\n", firstSeq));
+    if (numSkipped > 0) {
+        s.append(AStringPrintf("#EXT-X-SKIP:SKIPPED-SEGMENTS=%zu\n", numSkipped));
+    }
+
+    for (size_t i = numSkipped; i <= numSegments; ++i) {
+        int32_t seq = firstSeq + i;
+        if (i + kNumRecentSegments >= numSegments) {
+            size_t numParts = i < numSegments ? kNumPartsPerSegment : kNumPartsPerSegment / 2;
+            for (size_t j = 0; j < numParts; ++j) {
+                s.append(AStringPrintf(
+                        "#EXT-X-PART:DURATION=1.0,URI=\"seg%d.part%zu.ts\"%s\n",
+                        seq, j, j == 0 ? ",INDEPENDENT=YES" : ""));
+            }
+        }
+        if (i == numSegments) {
+            break;
+        }
+        if (i == numSkipped || seq % kKeyRotationInterval == 0) {
+            s.append(AStringPrintf(
+                    "#EXT-X-KEY:METHOD=AES-128,URI=\"key%d.bin\"\n",
+                    seq / kKeyRotationInterval));
+        }
+        s.append(AStringPrintf("#EXTINF:4.000,\nseg%d.ts\n", seq));
+    }
+
+    return s;
+}
+
+static sp<M3UParser> parse(const AString &playlist) {
+    return new M3UParser(kBaseURI, playlist.c_str(), playlist.size());
+}
+
+static void BM_FullParse(benchmark::State &state) {
+    size_t numSegments = state.range(0);
+    AString next = makePlaylist(1, numSegments, 0);
+
+    for (auto _ : state) {
+        sp<M3UParser> playlist = parse(next);
+        if (playlist->initCheck() != OK) {
+            state.SkipWithError("parse failed");
+            break;
+        }
+    }
+
+    state.SetBytesProcessed(state.iterations() * next.size());
+}
+
+// Argument 1 selects a delta update rather than a full copy.
+static void BM_IncrementalUpdate(benchmark::State &state) {
+    size_t numSegments = state.range(0);
+    bool delta = state.range(1) != 0;
+    AString previous = makePlaylist(0, numSegments, 0);
+    AString next = makePlaylist(
+            1, numSegments, delta ? numSegments - 1 - kNumRecentSegments : 0);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        sp<M3UParser> playlist = parse(previous);
+        state.ResumeTiming();
+
+        if (playlist->update(kBaseURI, next.c_str(), next.size()) != OK) {
+            state.SkipWithError("update failed");
+            break;
+        }
+    }
+
+    state.SetBytesProcessed(state.iterations() * next.size());
+}
+
+BENCHMARK(BM_FullParse)
+        ->Arg(1000)
+        ->Arg(10000)
+        ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_IncrementalUpdate)
+        ->Args({1000, 0})
+        ->Args({1000, 1})
+        ->Args({10000, 0})
+        ->Args({10000, 1})
+        ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,254 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "M3UParserUnitTest"
+#include <utils/Log.h>
+
+#include <gtest/gtest.h>
+
+#include <M3UParser.h>
+#include <media/stagefright/MediaErrors.h>
+#include <media/stagefright/foundation/AMessage.h>
+#include <media/stagefright/foundation/AString.h>
+
+using namespace android;
+
+static constexpr char kBaseURI[] = "http://hls.local/live/index.m3u8";
+// Segments are byte ranges of files of kSegmentsPerFile segments, each file
+// with its own key.
+static constexpr int32_t kSegmentsPerFile = 4;
+static constexpr int32_t kSegmentSize = 1000;
+static constexpr int32_t kDiscontinuities[] = {11, 14, 17};
+static constexpr int32_t kFirstSeqWithParts = 13;
+static constexpr int32_t kPartsPerSegment = 2;
+
+// Returns the live playlist of segments [firstSeq, lastSeq] of stream "name",
+// of which the first numSkipped are left out as in a delta update. The
+// segment after lastSeq is partially available.
+static AString makePlaylist(
+        int32_t firstSeq, int32_t lastSeq, int32_t numSkipped = 0,
+        const char *name = "stream") {
+    int32_t discontinuitySeq = 0;
+    for (int32_t seq : kDiscontinuities) {
+        if (seq < firstSeq) {
+            ++discontinuitySeq;
+        }
+    }
+
+    AString s;
+    s.append("#EXTM3U\n"
+             "#EXT-X-VERSION:9\n"
+             "#EXT-X-TARGETDURATION:4\n"
+             "#EXT-X-SERVER-CONTROL:CAN-SKIP-UNTIL=24.0\n"
+             "#EXT-X-PART-INF:PART-TARGET=2.0\n");
+    s.append(AStringPrintf("#EXT-X-MEDIA-SEQUENCE:%d\n", firstSeq));
+    s.append(AStringPrintf("#EXT-X-DISCONTINUITY-SEQUENCE:%d\n", discontinuitySeq));
+    if (numSkipped > 0) {
+        s.append(AStringPrintf("#EXT-X-SKIP:SKIPPED-SEGMENTS=%d\n", numSkipped));
+    }
+
+    for (int32_t seq = firstSeq + numSkipped; seq <= lastSeq + 1; ++seq) {
+        if (seq >= kFirstSeqWithParts) {
+            int32_t numParts = seq <= lastSeq ? kPartsPerSegment : 1;
+            for (int32_t i = 0; i < numParts; ++i) {
+                s.append(AStringPrintf(
+                        "#EXT-X-PART:DURATION=2.0,URI=\"%s%d.part%d.ts\"\n", name, seq, i));
+            }
+        }
+        if (seq > lastSeq) {
+            break;
+        }
+
+        bool firstListed = seq == firstSeq + numSkipped;
+        int32_t file = seq / kSegmentsPerFile;
+        if (firstListed || seq % kSegmentsPerFile == 0) {
+            s.append(AStringPrintf(
+                    "#EXT-X-KEY:METHOD=AES-128,URI=\"key%d.bin\","
+                    "IV=0x000000000000000000000000000000%02x\n", file, file));
+        }
+        for (int32_t discontinuity : kDiscontinuities) {
+            if (seq == discontinuity) {
+                s.append("#EXT-X-DISCONTINUITY\n");
+            }
+        }
+        s.append("#EXTINF:4.000,\n");
+        if (firstListed || seq % kSegmentsPerFile == 0) {
+            s.append(AStringPrintf("#EXT-X-BYTERANGE:%d@%d\n",
+                    kSegmentSize, (seq % kSegmentsPerFile) * kSegmentSize));
+        } else {
+            s.append(AStringPrintf("#EXT-X-BYTERANGE:%d\n", kSegmentSize));
+        }
+        s.append(AStringPrintf("%s%d.ts\n", name, file));
+    }
+
+    return s;
+}
+
+static sp<M3UParser> parse(const AString &playlist) {
+    return new M3UParser(kBaseURI, playlist.c_str(), playlist.size());
+}
+
+static status_t update(const sp<M3UParser> &playlist, const AString &next) {
+    return playlist->update(kBaseURI, next.c_str(), next.size());
+}
+
+static void expectSameInt32(const sp<AMessage> &a, const sp<AMessage> &b, const char *key) {
+    int32_t x = 0, y = 0;
+    bool hasX = a->findInt32(key, &x);
+    EXPECT_EQ(hasX, b->findInt32(key, &y)) << key;
+    EXPECT_EQ(x, y) << key;
+}
+
+static void expectSameInt64(const sp<AMessage> &a, const sp<AMessage> &b, const char *key) {
+    int64_t x = 0, y = 0;
+    bool hasX = a->findInt64(key, &x);
+    EXPECT_EQ(hasX, b->findInt64(key, &y)) << key;
+    EXPECT_EQ(x, y) << key;
+}
+
+static void expectSameString(const sp<AMessage> &a, const sp<AMessage> &b, const char *key) {
+    AString x, y;
+    bool hasX = a->findString(key, &x);
+    EXPECT_EQ(hasX, b->findString(key, &y)) << key;
+    EXPECT_STREQ(x.c_str(), y.c_str()) << key;
+}
+
+static void expectSamePlaylist(const sp<M3UParser> &updated, const sp<M3UParser> &fresh) {
+    int32_t updatedFirst, updatedLast, freshFirst, freshLast;
+    updated->getSeqNumberRange(&updatedFirst, &updatedLast);
+    fresh->getSeqNumberRange(&freshFirst, &freshLast);
+    EXPECT_EQ(freshFirst, updatedFirst);
+    EXPECT_EQ(freshLast, updatedLast);
+    EXPECT_EQ(fresh->getDiscontinuitySeq(), updated->getDiscontinuitySeq());
+    EXPECT_EQ(fresh->getTargetDuration(), updated->getTargetDuration());
+    EXPECT_EQ(fresh->getPartTargetDuration(), updated->getPartTargetDuration());
+    EXPECT_EQ(fresh->getCanSkipUntilUs(), updated->getCanSkipUntilUs());
+
+    ASSERT_EQ(fresh->size(), updated->size());
+    for (size_t i = 0; i < fresh->size(); ++i) {
+        SCOPED_TRACE(testing::Message() << "segment " << freshFirst + (int32_t)i);
+        AString updatedURI, freshURI;
+        sp<AMessage> updatedMeta, freshMeta;
+        ASSERT_TRUE(updated->itemAt(i, &updatedURI, &updatedMeta));
+        ASSERT_TRUE(fresh->itemAt(i, &freshURI, &freshMeta));
+        EXPECT_STREQ(freshURI.c_str(), updatedURI.c_str());
+        expectSameInt64(updatedMeta, freshMeta, "durationUs");
+        expectSameInt32(updatedMeta, freshMeta, "discontinuity");
+        expectSameInt32(updatedMeta, freshMeta, "discontinuity-sequence");
+        expectSameString(updatedMeta, freshMeta, "cipher-method");
+        expectSameString(updatedMeta, freshMeta, "cipher-uri");
+        expectSameString(updatedMeta, freshMeta, "cipher-iv");
+        expectSameInt64(updatedMeta, freshMeta, "range-offset");
+        expectSameInt64(updatedMeta, freshMeta, "range-length");
+        expectSameInt32(updatedMeta, freshMeta, "part-count");
+    }
+
+    ASSERT_EQ(fresh->partCount(), updated->partCount());
+    for (size_t i = 0; i < fresh->partCount(); ++i) {
+        AString updatedURI, freshURI;
+        ASSERT_TRUE(updated->partAt(i, &updatedURI));
+        ASSERT_TRUE(fresh->partAt(i, &freshURI));
+        EXPECT_STREQ(freshURI.c_str(), updatedURI.c_str());
+    }
+}
+
+// Checks that a failed update left the playlist of [10, 14] untouched.
+static void expectUnchanged(const sp<M3UParser> &playlist) {
+    expectSamePlaylist(playlist, parse(makePlaylist(10, 14)));
+}
+
+TEST(M3UParserUnitTest, FullUpdateMatchesFullParse) {
+    sp<M3UParser> playlist = parse(makePlaylist(10, 14));
+    ASSERT_EQ(OK, playlist->initCheck());
+    ASSERT_EQ(5u, playlist->size());
+
+    AString next = makePlaylist(13, 18);
+    ASSERT_EQ(OK, update(playlist, next));
+    sp<M3UParser> fresh = parse(next);
+    ASSERT_EQ(OK, fresh->initCheck());
+    expectSamePlaylist(playlist, fresh);
+
+    // The first segment kept was encrypted with the key of a dropped one.
+    AString method;
+    sp<AMessage> meta;
+    ASSERT_TRUE(playlist->itemAt(0, NULL, &meta));
+    EXPECT_TRUE(meta->findString("cipher-method", &method));
+}
+
+TEST(M3UParserUnitTest, DeltaUpdateMatchesFullParse) {
+    sp<M3UParser> playlist = parse(makePlaylist(10, 14));
+    ASSERT_EQ(OK, playlist->initCheck());
+
+    ASSERT_EQ(OK, update(playlist, makePlaylist(13, 18, 1 /* numSkipped */)));
+    sp<M3UParser> fresh = parse(makePlaylist(13, 18));
+    ASSERT_EQ(OK, fresh->initCheck());
+    expectSamePlaylist(playlist, fresh);
+
+    // And again, from the updated playlist.
+    ASSERT_EQ(OK, update(playlist, makePlaylist(15, 21, 3 /* numSkipped */)));
+    fresh = parse(makePlaylist(15, 21));
+    ASSERT_EQ(OK, fresh->initCheck());
+    expectSamePlaylist(playlist, fresh);
+}
+
+TEST(M3UParserUnitTest, DeltaIsOnlyValidAsAnUpdate) {
+    EXPECT_NE(OK, parse(makePlaylist(13, 18, 1 /* numSkipped */))->initCheck());
+}
+
+TEST(M3UParserUnitTest, RejectsSkipBeyondKnownSegments) {
+    sp<M3UParser> playlist = parse(makePlaylist(10, 14));
+    ASSERT_EQ(OK, playlist->initCheck());
+
+    // Only 13 and 14 are known.
+    EXPECT_NE(OK, update(playlist, makePlaylist(13, 18, 3 /* numSkipped */)));
+    expectUnchanged(playlist);
+}
+
+TEST(M3UParserUnitTest, RejectsDeltaWithoutMatchingBase) {
+    // The window of the update does not overlap the playlist.
+    sp<M3UParser> playlist = parse(makePlaylist(10, 14));
+    ASSERT_EQ(OK, playlist->initCheck());
+    EXPECT_NE(OK, update(playlist, makePlaylist(16, 21, 1 /* numSkipped */)));
+    expectUnchanged(playlist);
+
+    // The update is of another stream.
+    EXPECT_NE(OK, update(playlist, makePlaylist(13, 18, 1 /* numSkipped */, "other")));
+    expectUnchanged(playlist);
+}
+
+TEST(M3UParserUnitTest, RejectsMalformedPart) {
+    sp<M3UParser> playlist = parse(makePlaylist(10, 14));
+    ASSERT_EQ(OK, playlist->initCheck());
+
+    const char *malformedParts[] = {
+        "#EXT-X-PART:DURATION=2.0\n",                           // no URI
+        "#EXT-X-PART:URI=\"stream19.part1.ts\"\n",              // no duration
+        "#EXT-X-PART:DURATION=2.0,URI=stream19.part1.ts\n",     // unquoted URI
+        "#EXT-X-PART:DURATION=2.0,URI=\"stream19.part1.ts\",BYTERANGE=\"x@0\"\n",
+    };
+    for (const char *part : malformedParts) {
+        SCOPED_TRACE(part);
+        AString next = makePlaylist(13, 18, 1 /* numSkipped */);
+        next.append(part);
+        EXPECT_NE(OK, update(playlist, next));
+        expectUnchanged(playlist);
+
+        next = makePlaylist(13, 18);
+        next.append(part);
+        EXPECT_NE(OK, parse(next)->initCheck());
+    }
+}
@@ -27,6 +27,7 @@
 
 namespace android {
 
+struct AEventPoller;
 struct AMessage;
 
 // Helper class to manage a number of live sockets (datagram and stream-based)
@@ -104,6 +105,9 @@ private:
 
     int mPipeFd[2];
 
+    // All session sockets and the read end of mPipeFd are registered here.
+    sp<AEventPoller> mPoller;
+
     KeyedVector<int32_t, sp<Session> > mSessions;
 
     enum Mode {
@@ -125,6 +129,8 @@ private:
     void threadLoop();
     void interrupt();
 
+    void updatePollEvents_l(const sp<Session> &session);
+
     static status_t MakeSocketNonBlocking(int s);
 
     DISALLOW_EVIL_CONSTRUCTORS(ANetworkSession);
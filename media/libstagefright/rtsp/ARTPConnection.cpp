@@ -26,11 +26,13 @@
 
 #include <media/stagefright/rtsp/ARTPAssembler.h>
 #include <media/stagefright/rtsp/ARTPConnection.h>
+#include <media/stagefright/rtsp/ARTPPacketPool.h>
 #include <media/stagefright/rtsp/ARTPSource.h>
 #include <media/stagefright/rtsp/ASessionDescription.h>
 
 #include <media/stagefright/foundation/ABuffer.h>
 #include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/AEventPoller.h>
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/foundation/AString.h>
 #include <media/stagefright/foundation/hexdump.h>
@@ -40,10 +42,24 @@
 #include <arpa/inet.h>
 #include <sys/socket.h>
 
+#include <algorithm>
+
 namespace android {
 
 static const size_t kMaxUDPSize = 1500;
 
+// Datagrams pulled off an RTP socket per recvmmsg() call.
+static const size_t kMaxRTPBatchSize = 8;
+// RTP over UDP is not limited to the path MTU, but nearly all packets fit
+// into a pooled slot; anything larger spills into a per-batch overflow area
+// and is copied out.
+static const size_t kMaxRTPDatagramSize = 65536;
+static const size_t kRTPPacketSlotSize = 2048;
+static const size_t kRTPPacketSlotsPerArena = 128;
+static const size_t kMaxRTPPacketArenas = 32;
+
+static const size_t kMaxPollEvents = 32;
+
 static uint16_t u16at(const uint8_t *data) {
     return data[0] << 8 | data[1];
 }
@@ -88,6 +104,7 @@ struct ARTPConnection::StreamInfo {
 
 ARTPConnection::ARTPConnection(uint32_t flags)
     : mFlags(flags),
+      mPoller(new AEventPoller),
       mPollEventPending(false),
       mLastReceiverReportTimeUs(-1),
       mLastBitrateReportTimeUs(-1),
@@ -397,6 +414,24 @@ void ARTPConnection::onAddStream(const sp<AMessage> &msg) {
     }
 
     if (!injected) {
+        // The low bit of the cookie tells RTP (0) and RTCP (1) apart,
+        // list nodes are at least pointer aligned.
+        status_t err = mPoller->add(
+                info->mRTPSocket, AEventPoller::EVENT_READ, (uintptr_t)info);
+        if (err == OK) {
+            err = mPoller->add(
+                    info->mRTCPSocket, AEventPoller::EVENT_READ, (uintptr_t)info | 1);
+        }
+
+        if (err != OK) {
+            // Nothing would ever be received on this stream, drop it like
+            // one whose sockets failed.
+            ALOGE("failed to poll rtp socket(%d)/rtcp socket(%d). err=%s",
+                    info->mRTPSocket, info->mRTCPSocket, strerror(-err));
+            eraseStream(--mStreams.end());
+            return;
+        }
+
         postPollEvent();
     }
 }
@@ -428,7 +463,17 @@ void ARTPConnection::onRemoveStream(const sp<AMessage> &msg) {
         return;
     }
 
-    mStreams.erase(it);
+    eraseStream(it);
+}
+
+List<ARTPConnection::StreamInfo>::iterator ARTPConnection::eraseStream(
+        List<StreamInfo>::iterator it) {
+    if (!it->mIsInjected) {
+        mPoller->remove(it->mRTPSocket);
+        mPoller->remove(it->mRTCPSocket);
+    }
+
+    return mStreams.erase(it);
 }
 
 void ARTPConnection::postPollEvent() {
@@ -449,37 +494,88 @@ void ARTPConnection::onPollStreams() {
         return;
     }
 
-    struct timeval tv;
-    tv.tv_sec = 0;
-    tv.tv_usec = kSelectTimeoutUs;
-
-    fd_set rs;
-    FD_ZERO(&rs);
-
-    int maxSocket = -1;
+    bool hasPolledStreams = false;
     for (List<StreamInfo>::iterator it = mStreams.begin();
          it != mStreams.end(); ++it) {
-        if ((*it).mIsInjected) {
-            continue;
+        if (!(*it).mIsInjected) {
+            hasPolledStreams = true;
+            break;
         }
+    }
+
+    if (!hasPolledStreams) {
+        return;
+    }
 
-        FD_SET(it->mRTPSocket, &rs);
-        FD_SET(it->mRTCPSocket, &rs);
+    AEventPoller::Event events[kMaxPollEvents];
 
-        if (it->mRTPSocket > maxSocket) {
-            maxSocket = it->mRTPSocket;
+    int64_t nowUs = ALooper::GetNowUs();
+    ssize_t res = mPoller->wait(
+            events, kMaxPollEvents, (int)(kSelectTimeoutUs / 1000ll));
+
+    // Fold the RTP and RTCP events of each stream together, a stream may
+    // also only be touched once since it can be erased below.
+    struct ReadyStream {
+        StreamInfo *mInfo;
+        bool mRTPReady;
+        bool mRTCPReady;
+    };
+    ReadyStream ready[kMaxPollEvents];
+    size_t numReady = 0;
+
+    for (ssize_t i = 0; i < res; ++i) {
+        StreamInfo *info = (StreamInfo *)(uintptr_t)(events[i].mCookie & ~1ull);
+        bool isRTCP = events[i].mCookie & 1;
+
+        size_t j = 0;
+        while (j < numReady && ready[j].mInfo != info) {
+            ++j;
         }
-        if (it->mRTCPSocket > maxSocket) {
-            maxSocket = it->mRTCPSocket;
+        if (j == numReady) {
+            ready[numReady].mInfo = info;
+            ready[numReady].mRTPReady = false;
+            ready[numReady].mRTCPReady = false;
+            ++numReady;
+        }
+        if (isRTCP) {
+            ready[j].mRTCPReady = true;
+        } else {
+            ready[j].mRTPReady = true;
         }
     }
 
-    if (maxSocket == -1) {
-        return;
-    }
+    for (size_t i = 0; i < numReady; ++i) {
+        StreamInfo *s = ready[i].mInfo;
 
-    int64_t nowUs = ALooper::GetNowUs();
-    int res = select(maxSocket + 1, &rs, NULL, NULL, &tv);
+        status_t err = OK;
+        if (ready[i].mRTPReady) {
+            err = receive(s, true);
+        }
+        if (err == OK && ready[i].mRTCPReady) {
+            err = receive(s, false);
+        }
+
+        if (err == -ECONNRESET) {
+            // socket failure, this stream is dead, Jim.
+            for (size_t j = 0; j < s->mSources.size(); ++j) {
+                sp<AMessage> notify = s->mNotifyMsg->dup();
+                notify->setInt32("rtcp-event", 1);
+                notify->setInt32("payload-type", 400);
+                notify->setInt32("feedback-type", 1);
+                notify->setInt32("sender", s->mSources.valueAt(j)->getSelfID());
+                notify->post();
+
+                ALOGW("failed to receive RTP/RTCP datagram.");
+            }
+
+            List<StreamInfo>::iterator it = mStreams.begin();
+            while (it != mStreams.end() && &*it != s) {
+                ++it;
+            }
+            CHECK(it != mStreams.end());
+            eraseStream(it);
+        }
+    }
 
     if (res > 0) {
         List<StreamInfo>::iterator it = mStreams.begin();
@@ -490,30 +586,6 @@ void ARTPConnection::onPollStreams() {
             }
             it->mLastPollTimeUs = nowUs;
 
-            status_t err = OK;
-            if (FD_ISSET(it->mRTPSocket, &rs)) {
-                err = receive(&*it, true);
-            }
-            if (err == OK && FD_ISSET(it->mRTCPSocket, &rs)) {
-                err = receive(&*it, false);
-            }
-
-            if (err == -ECONNRESET) {
-                // socket failure, this stream is dead, Jim.
-                for (size_t i = 0; i < it->mSources.size(); ++i) {
-                    sp<AMessage> notify = it->mNotifyMsg->dup();
-                    notify->setInt32("rtcp-event", 1);
-                    notify->setInt32("payload-type", 400);
-                    notify->setInt32("feedback-type", 1);
-                    notify->setInt32("sender", it->mSources.valueAt(i)->getSelfID());
-                    notify->post();
-
-                    ALOGW("failed to receive RTP/RTCP datagram.");
-                }
-                it = mStreams.erase(it);
-                continue;
-            }
-
             // add NACK and FIR that needs to be sent immediately.
             sp<ABuffer> buffer = new ABuffer(kMaxUDPSize);
             for (size_t i = 0; i < it->mSources.size(); ++i) {
@@ -619,6 +691,10 @@ status_t ARTPConnection::receive(StreamInfo *s, bool receiveRTP) {
 
     CHECK(!s->mIsInjected);
 
+    if (receiveRTP) {
+        return receiveRTPBatch(s);
+    }
+
     sp<ABuffer> buffer = new ABuffer(65536);
 
     struct msghdr sMsg = {};
@@ -662,14 +738,109 @@ status_t ARTPConnection::receive(StreamInfo *s, bool receiveRTP) {
 
     // ALOGI("received %d bytes.", buffer->size());
 
-    status_t err;
-    if (receiveRTP) {
-        err = parseRTP(s, buffer);
-    } else {
-        err = parseRTCP(s, buffer);
+    return parseRTCP(s, buffer);
+}
+
+status_t ARTPConnection::receiveRTPBatch(StreamInfo *s) {
+    if (mPacketPool == NULL) {
+        mPacketPool = new ARTPPacketPool(
+                kRTPPacketSlotSize, kRTPPacketSlotsPerArena, kMaxRTPPacketArenas);
+        mRTPOverflow = new ABuffer(kMaxRTPBatchSize * kMaxRTPDatagramSize);
+    }
+
+    static const int cMsgSize = sizeof(struct cmsghdr) + sizeof(uint8_t);
+
+    struct mmsghdr msgs[kMaxRTPBatchSize];
+    struct iovec iovs[kMaxRTPBatchSize][2];
+    char control[kMaxRTPBatchSize][CMSG_SPACE(cMsgSize)];
+    sp<ABuffer> slots[kMaxRTPBatchSize];
+
+    memset(msgs, 0, sizeof(msgs));
+    for (size_t i = 0; i < kMaxRTPBatchSize; ++i) {
+        uint8_t *overflow = mRTPOverflow->data() + i * kMaxRTPDatagramSize;
+
+        slots[i] = mPacketPool->acquire();
+
+        if (slots[i] != NULL) {
+            iovs[i][0].iov_base = slots[i]->data();
+            iovs[i][0].iov_len = slots[i]->capacity();
+            iovs[i][1].iov_base = overflow;
+            iovs[i][1].iov_len = kMaxRTPDatagramSize - slots[i]->capacity();
+            msgs[i].msg_hdr.msg_iovlen = 2;
+        } else {
+            iovs[i][0].iov_base = overflow;
+            iovs[i][0].iov_len = kMaxRTPDatagramSize;
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        msgs[i].msg_hdr.msg_iov = iovs[i];
+        msgs[i].msg_hdr.msg_control = control[i];
+        msgs[i].msg_hdr.msg_controllen = sizeof(control[i]);
+    }
+
+    // The socket was reported readable, so at least one datagram is
+    // waiting; pick up whatever else has queued behind it without blocking.
+    int n;
+    do {
+        n = recvmmsg(s->mRTPSocket, msgs, kMaxRTPBatchSize, MSG_DONTWAIT, NULL);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0 && errno == EAGAIN) {
+        return OK;
     }
 
-    return err;
+    if (n <= 0) {
+        ALOGW("failed to recv rtp packet. cause=%s", strerror(errno));
+        // ECONNREFUSED may happen in next recvfrom() calling if one of
+        // outgoing packet can not be delivered to remote by using sendto()
+        if (errno == ECONNREFUSED) {
+            return -ECONNREFUSED;
+        } else {
+            return -ECONNRESET;
+        }
+    }
+
+    // Sources that had packets queued by this batch, their assemblers run
+    // once all of the batch has been queued.
+    Vector<sp<ARTPSource> > sources;
+
+    status_t firstErr = OK;
+    for (int i = 0; i < n; ++i) {
+        size_t nbytes = msgs[i].msg_len;
+        mCumulativeBytes += nbytes;
+
+        if (nbytes == 0) {
+            continue;
+        }
+
+        handleIpHeadersIfReceived(s, msgs[i].msg_hdr);
+
+        sp<ABuffer> buffer;
+        if (slots[i] != NULL && nbytes <= slots[i]->capacity()) {
+            buffer = slots[i];
+            buffer->setRange(0, nbytes);
+        } else {
+            buffer = new ABuffer(nbytes);
+
+            size_t offset = 0;
+            for (size_t j = 0; j < msgs[i].msg_hdr.msg_iovlen && offset < nbytes; ++j) {
+                size_t copy = std::min(nbytes - offset, iovs[i][j].iov_len);
+                memcpy(buffer->data() + offset, iovs[i][j].iov_base, copy);
+                offset += copy;
+            }
+        }
+
+        status_t err = parseRTP(s, buffer, &sources);
+        if (firstErr == OK) {
+            firstErr = err;
+        }
+    }
+
+    for (size_t i = 0; i < sources.size(); ++i) {
+        sources[i]->processQueuedRTPPackets();
+    }
+
+    return firstErr;
 }
 
 /* This function will check if TOS is present or not in received IP packet.
@@ -761,7 +932,8 @@ ssize_t ARTPConnection::send(const StreamInfo *info, const sp<ABuffer> buffer) {
         return n;
 }
 
-status_t ARTPConnection::parseRTP(StreamInfo *s, const sp<ABuffer> &buffer) {
+status_t ARTPConnection::parseRTP(
+        StreamInfo *s, const sp<ABuffer> &buffer, Vector<sp<ARTPSource> > *batchSources) {
     size_t size = buffer->size();
 
     if (size < 12) {
@@ -860,7 +1032,12 @@ status_t ARTPConnection::parseRTP(StreamInfo *s, const sp<ABuffer> &buffer) {
         ALOGD("send first-rtp event to upper layer");
     }
 
-    source->processRTPPacket(buffer);
+    if (batchSources == NULL) {
+        source->processRTPPacket(buffer);
+    } else if (source->queueRTPPacket(buffer)
+            && batchSources->indexOf(source) < 0) {
+        batchSources->push_back(source);
+    }
 
     return OK;
 }
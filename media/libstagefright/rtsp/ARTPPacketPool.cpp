@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ARTPPacketPool"
+#include <utils/Log.h>
+
+#include <media/stagefright/rtsp/ARTPPacketPool.h>
+
+#include <media/stagefright/foundation/ADebug.h>
+#include <media/stagefright/foundation/AMessage.h>
+
+#include <atomic>
+#include <stdlib.h>
+
+namespace android {
+
+struct ARTPPacketPool::Arena : public RefBase {
+    explicit Arena(size_t size)
+        : mData((uint8_t *)malloc(size)) {
+    }
+
+    uint8_t *data() const { return mData; }
+
+protected:
+    virtual ~Arena() {
+        free(mData);
+        mData = NULL;
+    }
+
+private:
+    uint8_t *mData;
+
+    DISALLOW_EVIL_CONSTRUCTORS(Arena);
+};
+
+struct ARTPPacketPool::Slot : public ABuffer {
+    Slot(const sp<Arena> &arena, uint8_t *data, size_t capacity)
+        : ABuffer(data, capacity),
+          mArena(arena) {
+    }
+
+protected:
+    virtual ~Slot() {}
+
+private:
+    // Keeps the backing memory alive while the slot is referenced.
+    sp<Arena> mArena;
+
+    DISALLOW_EVIL_CONSTRUCTORS(Slot);
+};
+
+ARTPPacketPool::ARTPPacketPool(
+        size_t slotSize, size_t slotsPerArena, size_t maxArenas)
+    : mSlotSize(slotSize),
+      mSlotsPerArena(slotsPerArena),
+      mMaxArenas(maxArenas),
+      mNextSlot(0),
+      mNumArenas(0),
+      mNumExhausted(0) {
+    CHECK_GT(mSlotSize, 0u);
+    CHECK_GT(mSlotsPerArena, 0u);
+}
+
+ARTPPacketPool::~ARTPPacketPool() {
+    ALOGV("%zu slots in %zu arenas, exhausted %zu times",
+            mSlots.size(), mNumArenas, mNumExhausted);
+}
+
+bool ARTPPacketPool::grow() {
+    if (mNumArenas >= mMaxArenas) {
+        return false;
+    }
+
+    sp<Arena> arena = new Arena(mSlotSize * mSlotsPerArena);
+    if (arena->data() == NULL) {
+        return false;
+    }
+
+    for (size_t i = 0; i < mSlotsPerArena; ++i) {
+        mSlots.push_back(new Slot(arena, arena->data() + i * mSlotSize, mSlotSize));
+    }
+    ++mNumArenas;
+
+    return true;
+}
+
+sp<ABuffer> ARTPPacketPool::acquire() {
+    // Packets are released roughly in the order they were received, so
+    // continuing the scan where the last one ended usually finds a free
+    // slot right away.
+    for (size_t n = 0; n < mSlots.size(); ++n) {
+        if (mNextSlot >= mSlots.size()) {
+            mNextSlot = 0;
+        }
+
+        const sp<Slot> &slot = mSlots[mNextSlot++];
+
+        if (slot->getStrongCount() == 1) {
+            // Pairs with the release in the last decStrong() of whoever
+            // used the slot before.
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            slot->setRange(0, slot->capacity());
+            slot->setInt32Data(0);
+            slot->meta()->clear();
+            return slot;
+        }
+    }
+
+    size_t first = mSlots.size();
+    if (!grow()) {
+        ++mNumExhausted;
+        return NULL;
+    }
+
+    mNextSlot = first + 1;
+    return mSlots[first];
+}
+
+}  // namespace android
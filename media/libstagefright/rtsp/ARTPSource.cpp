@@ -126,6 +126,16 @@ void ARTPSource::processRTPPacket(const sp<ABuffer> &buffer) {
     }
 }
 
+bool ARTPSource::queueRTPPacket(const sp<ABuffer> &buffer) {
+    return mAssembler != NULL && queuePacket(buffer);
+}
+
+void ARTPSource::processQueuedRTPPackets() {
+    if (mAssembler != NULL) {
+        mAssembler->onPacketReceived(this);
+    }
+}
+
 void ARTPSource::processRTPPacket() {
     if (mAssembler != NULL && !mQueue.empty()) {
         mAssembler->onPacketReceived(this);
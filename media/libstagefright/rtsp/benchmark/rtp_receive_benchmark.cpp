@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Replays an RTP video session over loopback UDP into ARTPConnection and
+// reports the process CPU time spent per received Mbit.
+//
+// Usage: rtp_receive_benchmark [benchmark flags] [capture]
+//
+// "capture" holds the RTP packets of an H.265 session, each prefixed by its
+// 16-bit big-endian length (the RTSP interleaved framing without the '$'
+// and channel bytes). Without one, a synthetic 4K-like H.265 stream of
+// 1200-byte single NAL unit packets is replayed.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <media/stagefright/foundation/ABuffer.h>
+#include <media/stagefright/foundation/AHandler.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/AMessage.h>
+#include <media/stagefright/rtsp/ARTPConnection.h>
+#include <media/stagefright/rtsp/ASessionDescription.h>
+
+using namespace android;
+
+static constexpr char kSdp[] =
+        "v=0\r\n"
+        "o=- 0 0 IN IP4 127.0.0.1\r\n"
+        "s=rtp_receive_benchmark\r\n"
+        "c=IN IP4 127.0.0.1\r\n"
+        "t=0 0\r\n"
+        "m=video 0 RTP/AVP 96\r\n"
+        "a=rtpmap:96 H265/90000\r\n";
+
+static constexpr size_t kSyntheticPayloadSize = 1200;
+static constexpr size_t kSyntheticPacketsPerFrame = 100;
+static constexpr size_t kSyntheticFrames = 60;
+static constexpr int64_t kMaxIdleUs = 500000ll;
+
+static std::vector<std::vector<uint8_t>> gPackets;
+
+static void makeSyntheticSession() {
+    uint16_t seq = 0;
+    for (size_t frame = 0; frame < kSyntheticFrames; ++frame) {
+        const uint32_t rtpTime = frame * 1500;  // 60fps at 90kHz
+        for (size_t i = 0; i < kSyntheticPacketsPerFrame; ++i) {
+            std::vector<uint8_t> packet(12 + kSyntheticPayloadSize, 0x5a);
+            const bool marker = (i + 1 == kSyntheticPacketsPerFrame);
+            packet[0] = 0x80;
+            packet[1] = (marker ? 0x80 : 0x00) | 96;
+            packet[2] = seq >> 8;
+            packet[3] = seq & 0xff;
+            packet[4] = rtpTime >> 24;
+            packet[5] = (rtpTime >> 16) & 0xff;
+            packet[6] = (rtpTime >> 8) & 0xff;
+            packet[7] = rtpTime & 0xff;
+            packet[8] = 0x12;
+            packet[9] = 0x34;
+            packet[10] = 0x56;
+            packet[11] = 0x78;
+            // Single NAL unit packet carrying a TRAIL_R slice.
+            packet[12] = 1 << 1;
+            packet[13] = 1;
+            gPackets.push_back(std::move(packet));
+            ++seq;
+        }
+    }
+}
+
+static bool loadCapture(const char *path) {
+    std::ifstream in(path, std::ios::binary);
+    uint8_t header[2];
+    while (in.read((char *)header, sizeof(header))) {
+        size_t size = header[0] << 8 | header[1];
+        std::vector<uint8_t> packet(size);
+        if (!in.read((char *)packet.data(), size)) {
+            return false;
+        }
+        gPackets.push_back(std::move(packet));
+    }
+    return !gPackets.empty();
+}
+
+struct AccessUnitCounter : public AHandler {
+    std::atomic<size_t> mNumBytes{0};
+    std::atomic<int64_t> mLastUs{0};
+
+protected:
+    void onMessageReceived(const sp<AMessage> &msg) override {
+        sp<ABuffer> accessUnit;
+        if (msg->findBuffer("access-unit", &accessUnit)) {
+            mNumBytes += accessUnit->size();
+            mLastUs = ALooper::GetNowUs();
+        }
+    }
+};
+
+static int64_t processCpuUs() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000ll
+            + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static void BM_RTPReceive(benchmark::State &state) {
+    sp<ASessionDescription> desc = new ASessionDescription;
+    if (!desc->setTo(kSdp, strlen(kSdp))) {
+        state.SkipWithError("invalid session description");
+        return;
+    }
+
+    sp<ALooper> looper = new ALooper;
+    looper->setName("rtp_receive_benchmark");
+    looper->start(false /* runOnCallingThread */, false /* canCallJava */,
+            PRIORITY_AUDIO);
+
+    sp<AccessUnitCounter> counter = new AccessUnitCounter;
+    looper->registerHandler(counter);
+
+    int64_t cpuUs = 0;
+    size_t totalBits = 0;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        sp<ARTPConnection> connection = new ARTPConnection;
+        looper->registerHandler(connection);
+
+        int rtpSocket, rtcpSocket;
+        unsigned rtpPort;
+        ARTPConnection::MakePortPair(&rtpSocket, &rtcpSocket, &rtpPort);
+        connection->addStream(
+                rtpSocket, rtcpSocket, desc, 1 /* index */,
+                new AMessage(0, counter), false /* injected */);
+
+        int sender = socket(AF_INET, SOCK_DGRAM, 0);
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(rtpPort);
+
+        const size_t startBytes = counter->mNumBytes;
+        state.ResumeTiming();
+
+        const int64_t startCpuUs = processCpuUs();
+        for (size_t i = 0; i < gPackets.size(); ++i) {
+            sendto(sender, gPackets[i].data(), gPackets[i].size(), 0,
+                    (const struct sockaddr *)&addr, sizeof(addr));
+            if ((i % 64) == 63) {
+                // Stay below the receive buffer size.
+                usleep(500);
+            }
+        }
+
+        counter->mLastUs = ALooper::GetNowUs();
+        while (ALooper::GetNowUs() - counter->mLastUs < kMaxIdleUs) {
+            usleep(10000);
+        }
+        cpuUs += processCpuUs() - startCpuUs;
+        totalBits += (counter->mNumBytes - startBytes) * 8;
+
+        state.PauseTiming();
+        close(sender);
+        connection->removeStream(rtpSocket, rtcpSocket);
+        looper->unregisterHandler(connection->id());
+        close(rtpSocket);
+        close(rtcpSocket);
+        state.ResumeTiming();
+    }
+
+    state.counters["Mbit"] = totalBits / 1e6;
+    state.counters["cpu_ms_per_Mbit"] =
+            totalBits > 0 ? (cpuUs / 1000.0) / (totalBits / 1e6) : 0.0;
+
+    looper->unregisterHandler(counter->id());
+    looper->stop();
+}
+
+BENCHMARK(BM_RTPReceive)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+int main(int argc, char **argv) {
+    benchmark::Initialize(&argc, argv);
+    if (argc > 1) {
+        if (!loadCapture(argv[1])) {
+            fprintf(stderr, "unable to load RTP capture from %s\n", argv[1]);
+            return 1;
+        }
+    } else {
+        makeSyntheticSession();
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
@@ -20,11 +20,14 @@
 
 #include <media/stagefright/foundation/AHandler.h>
 #include <utils/List.h>
+#include <utils/Vector.h>
 #include <sys/socket.h>
 
 namespace android {
 
 struct ABuffer;
+struct AEventPoller;
+struct ARTPPacketPool;
 struct ARTPSource;
 struct ASessionDescription;
 
@@ -88,6 +91,14 @@ private:
     struct StreamInfo;
     List<StreamInfo> mStreams;
 
+    // The RTP and RTCP sockets of every non-injected stream.
+    sp<AEventPoller> mPoller;
+
+    // RTP packets are received straight into pooled buffers, datagrams
+    // that do not fit a pool slot continue into mRTPOverflow.
+    sp<ARTPPacketPool> mPacketPool;
+    sp<ABuffer> mRTPOverflow;
+
     bool mPollEventPending;
     int64_t mLastReceiverReportTimeUs;
     int64_t mLastBitrateReportTimeUs;
@@ -115,9 +126,15 @@ private:
     void handleIpHeadersIfReceived(StreamInfo *s, struct msghdr sMsg);
 
     status_t receive(StreamInfo *info, bool receiveRTP);
+    status_t receiveRTPBatch(StreamInfo *info);
     ssize_t send(const StreamInfo *info, const sp<ABuffer> buffer);
 
-    status_t parseRTP(StreamInfo *info, const sp<ABuffer> &buffer);
+    // Hands the packet to its source's assembler right away unless
+    // batchSources is given, in which case the packet is only queued and the
+    // source is added to batchSources.
+    status_t parseRTP(
+            StreamInfo *info, const sp<ABuffer> &buffer,
+            Vector<sp<ARTPSource> > *batchSources = NULL);
     status_t parseRTPExt(StreamInfo *s, const uint8_t *extData, size_t extLen, int32_t *cvoDegrees);
     status_t parseRTCP(StreamInfo *info, const sp<ABuffer> &buffer);
     status_t parseSenderReport(StreamInfo *info, const uint8_t *data, size_t size);
@@ -132,6 +149,8 @@ private:
 
     void postPollEvent();
 
+    List<StreamInfo>::iterator eraseStream(List<StreamInfo>::iterator it);
+
     DISALLOW_EVIL_CONSTRUCTORS(ARTPConnection);
 };
 
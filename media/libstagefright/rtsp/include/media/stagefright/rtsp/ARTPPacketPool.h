@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef A_RTP_PACKET_POOL_H_
+
+#define A_RTP_PACKET_POOL_H_
+
+#include <media/stagefright/foundation/ABase.h>
+#include <media/stagefright/foundation/ABuffer.h>
+#include <utils/RefBase.h>
+#include <utils/Vector.h>
+
+namespace android {
+
+// Recycles fixed-size packet buffers carved out of a few large arenas, so
+// that receiving an RTP packet neither allocates its payload nor copies it.
+//
+// A buffer handed out by acquire() is free again as soon as the pool holds
+// the only reference to it, i.e. once the assembler and everybody
+// downstream has dropped it. Arenas outlive the pool for as long as any of
+// their buffers is still referenced.
+struct ARTPPacketPool : public RefBase {
+    ARTPPacketPool(size_t slotSize, size_t slotsPerArena, size_t maxArenas);
+
+    size_t slotSize() const { return mSlotSize; }
+
+    // Returns an unreferenced buffer with its full capacity in range and
+    // empty meta data, or NULL if every slot is in use and the pool has
+    // already grown to its limit.
+    sp<ABuffer> acquire();
+
+    size_t numSlots() const { return mSlots.size(); }
+    size_t numExhausted() const { return mNumExhausted; }
+
+protected:
+    virtual ~ARTPPacketPool();
+
+private:
+    struct Arena;
+    struct Slot;
+
+    const size_t mSlotSize;
+    const size_t mSlotsPerArena;
+    const size_t mMaxArenas;
+
+    Vector<sp<Slot> > mSlots;
+    size_t mNextSlot;
+    size_t mNumArenas;
+    size_t mNumExhausted;
+
+    bool grow();
+
+    DISALLOW_EVIL_CONSTRUCTORS(ARTPPacketPool);
+};
+
+}  // namespace android
+
+#endif  // A_RTP_PACKET_POOL_H_
@@ -61,6 +61,10 @@ struct ARTPSource : public RefBase {
 
     void processRTPPacket(const sp<ABuffer> &buffer);
     void processRTPPacket();
+    // Batched variant of processRTPPacket(buffer): queue every packet of a
+    // receive batch, then run the assembler once for all of them.
+    bool queueRTPPacket(const sp<ABuffer> &buffer);
+    void processQueuedRTPPackets();
     void processReceptionReportBlock(
             int64_t recvTimeUs, uint32_t senderId, sp<ReceptionReportBlock> rrb);
     void timeReset();
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Loopback UDP throughput of ANetworkSession with 1 to 256 live sessions.
+// Reports received packets per second and process CPU time per 1000
+// packets, the latter including the network and looper threads.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <media/stagefright/ANetworkSession.h>
+#include <media/stagefright/foundation/AHandler.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/AMessage.h>
+
+using namespace android;
+
+static constexpr unsigned kBasePort = 41000;
+static constexpr size_t kPacketsPerSession = 64;
+static constexpr size_t kPacketSize = 1200;
+static constexpr int64_t kDrainTimeoutUs = 2000000ll;
+static constexpr int kMaxIdleChecks = 20;
+
+struct DatagramCounter : public AHandler {
+    std::atomic<size_t> mCount{0};
+
+protected:
+    void onMessageReceived(const sp<AMessage> &msg) override {
+        int32_t reason;
+        if (msg->findInt32("reason", &reason)
+                && reason == ANetworkSession::kWhatDatagram) {
+            ++mCount;
+        }
+    }
+};
+
+static int64_t processCpuUs() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000ll
+            + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static void BM_UDPLoopback(benchmark::State &state) {
+    const size_t numSessions = state.range(0);
+
+    sp<ALooper> looper = new ALooper;
+    looper->setName("ANetworkSession_benchmark");
+    looper->start();
+
+    sp<DatagramCounter> counter = new DatagramCounter;
+    looper->registerHandler(counter);
+
+    sp<ANetworkSession> session = new ANetworkSession;
+    if (session->start() != OK) {
+        state.SkipWithError("unable to start ANetworkSession");
+        return;
+    }
+
+    std::vector<int32_t> sessionIDs;
+    for (size_t i = 0; i < numSessions; ++i) {
+        int32_t sessionID;
+        if (session->createUDPSession(
+                kBasePort + i, new AMessage(0, counter), &sessionID) != OK) {
+            state.SkipWithError("unable to create UDP session");
+            break;
+        }
+        sessionIDs.push_back(sessionID);
+    }
+
+    int sender = socket(AF_INET, SOCK_DGRAM, 0);
+    char payload[kPacketSize] = {};
+
+    size_t totalReceived = 0;
+    int64_t cpuUs = 0;
+
+    for (auto _ : state) {
+        const size_t base = counter->mCount;
+        const size_t target = base + sessionIDs.size() * kPacketsPerSession;
+        const int64_t startCpuUs = processCpuUs();
+
+        for (size_t n = 0; n < kPacketsPerSession; ++n) {
+            for (size_t i = 0; i < sessionIDs.size(); ++i) {
+                struct sockaddr_in addr = {};
+                addr.sin_family = AF_INET;
+                addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                addr.sin_port = htons(kBasePort + i);
+                sendto(sender, payload, sizeof(payload), 0,
+                        (const struct sockaddr *)&addr, sizeof(addr));
+            }
+        }
+
+        // Loopback UDP can still drop under pressure, so wait for the count
+        // to settle rather than for every single packet.
+        const int64_t deadlineUs = ALooper::GetNowUs() + kDrainTimeoutUs;
+        size_t last = base;
+        int idleChecks = 0;
+        while (counter->mCount < target && ALooper::GetNowUs() < deadlineUs
+                && idleChecks < kMaxIdleChecks) {
+            usleep(1000);
+            idleChecks = (counter->mCount == last) ? idleChecks + 1 : 0;
+            last = counter->mCount;
+        }
+
+        cpuUs += processCpuUs() - startCpuUs;
+        totalReceived += std::min<size_t>(counter->mCount, target) - base;
+    }
+
+    state.counters["packets/s"] =
+            benchmark::Counter(totalReceived, benchmark::Counter::kIsRate);
+    state.counters["cpu_us_per_kpkt"] =
+            totalReceived > 0 ? cpuUs * 1000.0 / totalReceived : 0.0;
+
+    close(sender);
+
+    for (int32_t sessionID : sessionIDs) {
+        session->destroySession(sessionID);
+    }
+    session->stop();
+
+    looper->unregisterHandler(counter->id());
+    looper->stop();
+}
+
+BENCHMARK(BM_UDPLoopback)->RangeMultiplier(4)->Range(1, 256)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "AEventPoller"
+#include <utils/Log.h>
+
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include "AEventPoller.h"
+
+namespace android {
+
+// Upper bound on the number of events fetched from the kernel per wait().
+static const size_t kMaxEventsPerWait = 64;
+
+static uint32_t toEpollEvents(uint32_t events) {
+    uint32_t epollEvents = 0;
+    if (events & AEventPoller::EVENT_READ) {
+        epollEvents |= EPOLLIN;
+    }
+    if (events & AEventPoller::EVENT_WRITE) {
+        epollEvents |= EPOLLOUT;
+    }
+    if (events & AEventPoller::EVENT_EDGE_TRIGGERED) {
+        epollEvents |= EPOLLET;
+    }
+    return epollEvents;
+}
+
+AEventPoller::AEventPoller()
+    : mEpollFd(epoll_create1(EPOLL_CLOEXEC)) {
+    if (mEpollFd < 0) {
+        ALOGE("epoll_create1 failed (%s)", strerror(errno));
+    }
+}
+
+AEventPoller::~AEventPoller() {
+    if (mEpollFd >= 0) {
+        close(mEpollFd);
+        mEpollFd = -1;
+    }
+}
+
+status_t AEventPoller::initCheck() const {
+    return mEpollFd >= 0 ? OK : NO_INIT;
+}
+
+status_t AEventPoller::add(int fd, uint32_t events, uint64_t cookie) {
+    struct epoll_event ev = {};
+    ev.events = toEpollEvents(events);
+    ev.data.u64 = cookie;
+
+    if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        ALOGW("failed to add fd %d (%s)", fd, strerror(errno));
+        return -errno;
+    }
+    return OK;
+}
+
+status_t AEventPoller::modify(int fd, uint32_t events, uint64_t cookie) {
+    struct epoll_event ev = {};
+    ev.events = toEpollEvents(events);
+    ev.data.u64 = cookie;
+
+    if (epoll_ctl(mEpollFd, EPOLL_CTL_MOD, fd, &ev) < 0) {
+        ALOGW("failed to modify fd %d (%s)", fd, strerror(errno));
+        return -errno;
+    }
+    return OK;
+}
+
+status_t AEventPoller::remove(int fd) {
+    // Pre-2.6.9 kernels required a non-null event, be conservative.
+    struct epoll_event ev = {};
+
+    if (epoll_ctl(mEpollFd, EPOLL_CTL_DEL, fd, &ev) < 0) {
+        return -errno;
+    }
+    return OK;
+}
+
+ssize_t AEventPoller::wait(Event *events, size_t maxEvents, int timeoutMs) {
+    if (maxEvents == 0) {
+        return 0;
+    }
+    if (maxEvents > kMaxEventsPerWait) {
+        maxEvents = kMaxEventsPerWait;
+    }
+
+    struct epoll_event epollEvents[kMaxEventsPerWait];
+
+    int res = epoll_wait(mEpollFd, epollEvents, maxEvents, timeoutMs);
+
+    if (res < 0) {
+        if (errno == EINTR) {
+            return 0;
+        }
+        ALOGE("epoll_wait failed w/ error %d (%s)", errno, strerror(errno));
+        return -errno;
+    }
+
+    for (int i = 0; i < res; ++i) {
+        uint32_t in = epollEvents[i].events;
+        uint32_t out = 0;
+        if (in & (EPOLLIN | EPOLLRDHUP)) {
+            out |= EVENT_READ;
+        }
+        if (in & EPOLLOUT) {
+            out |= EVENT_WRITE;
+        }
+        if (in & (EPOLLERR | EPOLLHUP)) {
+            out |= EVENT_ERROR;
+        }
+        events[i].mCookie = epollEvents[i].data.u64;
+        events[i].mEvents = out;
+    }
+
+    return res;
+}
+
+}  // namespace android
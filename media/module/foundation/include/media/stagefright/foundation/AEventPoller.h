@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef A_EVENT_POLLER_H_
+
+#define A_EVENT_POLLER_H_
+
+#include <media/stagefright/foundation/ABase.h>
+#include <utils/Errors.h>
+#include <utils/RefBase.h>
+
+namespace android {
+
+// Thin wrapper around an epoll instance, shared by the socket handling code
+// (ANetworkSession, ARTPConnection) that used to rebuild fd_sets for select()
+// on every iteration. Each registered descriptor carries an opaque cookie
+// that is handed back when it becomes ready, so the cost of a wakeup is
+// proportional to the number of ready descriptors rather than the number of
+// registered ones, and descriptors at or above FD_SETSIZE are supported.
+struct AEventPoller : public RefBase {
+    enum {
+        EVENT_READ           = 1,
+        EVENT_WRITE          = 2,
+        // Only reported by wait(), never requested. Like select() reporting
+        // the descriptor as ready, the owner should retry the operations it
+        // registered for in order to pick up the pending error.
+        EVENT_ERROR          = 4,
+        // Requested only; the owner must drain the descriptor (until EAGAIN)
+        // after every notification.
+        EVENT_EDGE_TRIGGERED = 8,
+    };
+
+    struct Event {
+        uint64_t mCookie;
+        uint32_t mEvents;
+    };
+
+    AEventPoller();
+
+    status_t initCheck() const;
+
+    // An fd registered with no events stays registered but is never reported.
+    status_t add(int fd, uint32_t events, uint64_t cookie);
+    status_t modify(int fd, uint32_t events, uint64_t cookie);
+    status_t remove(int fd);
+
+    // Blocks for at most timeoutMs milliseconds (forever if negative) and
+    // returns the number of entries filled into "events", 0 on timeout or
+    // a negative errno. EINTR is reported as a timeout.
+    ssize_t wait(Event *events, size_t maxEvents, int timeoutMs);
+
+protected:
+    virtual ~AEventPoller();
+
+private:
+    int mEpollFd;
+
+    DISALLOW_EVIL_CONSTRUCTORS(AEventPoller);
+};
+
+}  // namespace android
+
+#endif  // A_EVENT_POLLER_H_
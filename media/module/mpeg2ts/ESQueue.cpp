@@ -33,6 +33,9 @@
 #include <media/cas/DescramblerAPI.h>
 #include <media/hardware/CryptoAPI.h>
 
+#include <algorithm>
+#include <atomic>
+
 #include <inttypes.h>
 #include <netinet/in.h>
 
@@ -42,6 +45,28 @@
 
 namespace android {
 
+// Chunks are large compared to access units, so that the unconsumed tail
+// carried over into a new chunk is small compared to what was handed out
+// of the previous one.
+static const size_t kMinChunkSize = 256 * 1024;
+static const size_t kMaxPooledChunks = 4;
+
+struct ElementaryStreamQueue::AccessUnitView : public ABuffer {
+    AccessUnitView(const sp<ABuffer> &storage, uint8_t *data, size_t size)
+        : ABuffer(data, size),
+          mStorage(storage) {
+    }
+
+protected:
+    virtual ~AccessUnitView() {}
+
+private:
+    // Keeps the chunk from being recycled while the view is referenced.
+    sp<ABuffer> mStorage;
+
+    DISALLOW_EVIL_CONSTRUCTORS(AccessUnitView);
+};
+
 ElementaryStreamQueue::ElementaryStreamQueue(Mode mode, uint32_t flags)
     : mMode(mode),
       mFlags(flags),
@@ -69,7 +94,7 @@ sp<MetaData> ElementaryStreamQueue::getFormat() {
 
 void ElementaryStreamQueue::clear(bool clearFormat) {
     if (mBuffer != NULL) {
-        mBuffer->setRange(0, 0);
+        consumeData(mBuffer->size());
     }
 
     mRangeInfos.clear();
@@ -1161,25 +1186,21 @@ status_t ElementaryStreamQueue::appendData(
         }
     }
 
-    size_t neededSize = (mBuffer == NULL ? 0 : mBuffer->size()) + size;
-    if (mBuffer == NULL || neededSize > mBuffer->capacity()) {
-        neededSize = (neededSize + 65535) & ~65535;
+    if (mBuffer == NULL
+            || mBuffer->offset() + mBuffer->size() + size > mBuffer->capacity()) {
+        size_t neededSize = (mBuffer == NULL ? 0 : mBuffer->size()) + size;
 
-        ALOGV("resizing buffer to size %zu", neededSize);
-
-        sp<ABuffer> buffer = new ABuffer(neededSize);
+        sp<ABuffer> buffer = acquireChunk(neededSize);
         if (mBuffer != NULL) {
             memcpy(buffer->data(), mBuffer->data(), mBuffer->size());
             buffer->setRange(0, mBuffer->size());
-        } else {
-            buffer->setRange(0, 0);
         }
 
         mBuffer = buffer;
     }
 
     memcpy(mBuffer->data() + mBuffer->size(), data, size);
-    mBuffer->setRange(0, mBuffer->size() + size);
+    mBuffer->setRange(mBuffer->offset(), mBuffer->size() + size);
 
     RangeInfo info;
     info.mLength = size;
@@ -1198,6 +1219,54 @@ status_t ElementaryStreamQueue::appendData(
     return OK;
 }
 
+sp<ABuffer> ElementaryStreamQueue::acquireChunk(size_t size) {
+    for (size_t i = 0; i < mChunkPool.size(); ++i) {
+        const sp<ABuffer> &chunk = mChunkPool[i];
+
+        // Only the pool refers to it: neither mBuffer nor any access unit.
+        if (chunk->capacity() >= size && chunk->getStrongCount() == 1) {
+            // Pairs with the release in the last decStrong() of the access
+            // units that pointed into it.
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            chunk->setRange(0, 0);
+            return chunk;
+        }
+    }
+
+    size_t capacity = std::max(kMinChunkSize, (size + 65535) & ~65535);
+
+    ALOGV("allocating chunk of size %zu", capacity);
+
+    sp<ABuffer> chunk = new ABuffer(capacity);
+    chunk->setRange(0, 0);
+
+    if (mChunkPool.size() < kMaxPooledChunks) {
+        mChunkPool.push_back(chunk);
+    } else {
+        // Replace one that is too small for the current stream, if any.
+        for (size_t i = 0; i < mChunkPool.size(); ++i) {
+            if (mChunkPool[i]->capacity() < size) {
+                mChunkPool[i] = chunk;
+                break;
+            }
+        }
+    }
+
+    return chunk;
+}
+
+void ElementaryStreamQueue::consumeData(size_t size) {
+    mBuffer->setRange(mBuffer->offset() + size, mBuffer->size() - size);
+}
+
+sp<ABuffer> ElementaryStreamQueue::takeAccessUnit(size_t offset, size_t size) {
+    sp<ABuffer> accessUnit =
+        new AccessUnitView(mBuffer, mBuffer->data() + offset, size);
+    consumeData(offset + size);
+    return accessUnit;
+}
+
 void ElementaryStreamQueue::appendScrambledData(
         const void *data, size_t size,
         size_t leadingClearBytes,
@@ -1281,9 +1350,10 @@ sp<ABuffer> ElementaryStreamQueue::dequeueScrambledAccessUnit() {
     // range on mBuffer. Note that the leading clear bytes includes the
     // PES header portion, while mBuffer doesn't.
     if ((int32_t)leadingClearBytes > pesOffset) {
-        mBuffer->setRange(0, leadingClearBytes - pesOffset);
+        mBuffer->setRange(mBuffer->offset(),
+                std::min(leadingClearBytes - pesOffset, mBuffer->size()));
     } else {
-        mBuffer->setRange(0, 0);
+        mBuffer->setRange(mBuffer->offset(), 0);
     }
 
     // Try to parse formats, and if unavailable set up a dummy format.
@@ -1339,7 +1409,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueScrambledAccessUnit() {
                 0, mCasSessionId.data(), mCasSessionId.size());
     }
 
-    mBuffer->setRange(0, 0);
+    consumeData(mBuffer->size());
 
     // copy into scrambled access unit
     sp<ABuffer> scrambledAccessUnit = ABuffer::CreateAsCopy(
@@ -1384,16 +1454,9 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnit() {
         RangeInfo info = *mRangeInfos.begin();
         mRangeInfos.erase(mRangeInfos.begin());
 
-        sp<ABuffer> accessUnit = new ABuffer(info.mLength);
-        memcpy(accessUnit->data(), mBuffer->data(), info.mLength);
+        sp<ABuffer> accessUnit = takeAccessUnit(0, info.mLength);
         accessUnit->meta()->setInt64("timeUs", info.mTimestampUs);
 
-        memmove(mBuffer->data(),
-                mBuffer->data() + info.mLength,
-                mBuffer->size() - info.mLength);
-
-        mBuffer->setRange(0, mBuffer->size() - info.mLength);
-
         if (mFormat == NULL) {
             mFormat = new MetaData;
             if (!MakeAVCCodecSpecificData(*mFormat, accessUnit->data(), accessUnit->size())) {
@@ -1473,19 +1536,11 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitDTSOrDTSHD() {
     }
     mAUIndex++;
 
-    sp<ABuffer> accessUnit = new ABuffer(syncStartPos + payloadSize);
-    memcpy(accessUnit->data(), mBuffer->data(), syncStartPos + payloadSize);
+    sp<ABuffer> accessUnit = takeAccessUnit(0, syncStartPos + payloadSize);
 
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
 
-    memmove(
-        mBuffer->data(),
-        mBuffer->data() + syncStartPos + payloadSize,
-        mBuffer->size() - syncStartPos - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - syncStartPos - payloadSize);
-
     return accessUnit;
 }
 
@@ -1527,19 +1582,11 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitDTSUHD()
     }
     mAUIndex++;
 
-    sp<ABuffer> accessUnit = new ABuffer(syncStartPos + payloadSize);
-    memcpy(accessUnit->data(), mBuffer->data(), syncStartPos + payloadSize);
+    sp<ABuffer> accessUnit = takeAccessUnit(0, syncStartPos + payloadSize);
 
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
 
-    memmove(
-        mBuffer->data(),
-        mBuffer->data() + syncStartPos + payloadSize,
-        mBuffer->size() - syncStartPos - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - syncStartPos - payloadSize);
-
     return accessUnit;
 }
 
@@ -1599,19 +1646,11 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitEAC3() {
     }
     mAUIndex++;
 
-    sp<ABuffer> accessUnit = new ABuffer(syncStartPos + payloadSize);
-    memcpy(accessUnit->data(), mBuffer->data(), syncStartPos + payloadSize);
+    sp<ABuffer> accessUnit = takeAccessUnit(0, syncStartPos + payloadSize);
 
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
 
-    memmove(
-            mBuffer->data(),
-            mBuffer->data() + syncStartPos + payloadSize,
-            mBuffer->size() - syncStartPos - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - syncStartPos - payloadSize);
-
     return accessUnit;
 }
 
@@ -1663,18 +1702,10 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitAC4() {
     }
     mAUIndex++;
 
-    sp<ABuffer> accessUnit = new ABuffer(syncStartPos + payloadSize);
-    memcpy(accessUnit->data(), mBuffer->data(), syncStartPos + payloadSize);
+    sp<ABuffer> accessUnit = takeAccessUnit(0, syncStartPos + payloadSize);
 
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
-
-    memmove(
-            mBuffer->data(),
-            mBuffer->data() + syncStartPos + payloadSize,
-            mBuffer->size() - syncStartPos - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - syncStartPos - payloadSize);
     return accessUnit;
 }
 
@@ -1736,12 +1767,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitPCMAudio() {
         ptr[i] = ntohs(ptr[i]);
     }
 
-    memmove(
-            mBuffer->data(),
-            mBuffer->data() + 4 + payloadSize,
-            mBuffer->size() - 4 - payloadSize);
-
-    mBuffer->setRange(0, mBuffer->size() - 4 - payloadSize);
+    consumeData(4 + payloadSize);
 
     return accessUnit;
 }
@@ -1882,12 +1908,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitAAC() {
 
     int64_t timeUs = fetchTimestamp(offset);
 
-    sp<ABuffer> accessUnit = new ABuffer(offset);
-    memcpy(accessUnit->data(), mBuffer->data(), offset);
-
-    memmove(mBuffer->data(), mBuffer->data() + offset,
-            mBuffer->size() - offset);
-    mBuffer->setRange(0, mBuffer->size() - offset);
+    sp<ABuffer> accessUnit = takeAccessUnit(0, offset);
 
     accessUnit->meta()->setInt64("timeUs", timeUs);
     accessUnit->meta()->setInt32("isSync", 1);
@@ -1937,6 +1958,29 @@ int64_t ElementaryStreamQueue::fetchTimestamp(
     return timeUs;
 }
 
+// Returns true if the NAL units follow each other in "data", each behind a
+// 4-byte start code, exactly as they would be laid out in an access unit.
+static bool IsContiguousAccessUnit(
+        const uint8_t *data, const Vector<NALPosition> &nals) {
+    for (size_t i = 0; i < nals.size(); ++i) {
+        const NALPosition &pos = nals.itemAt(i);
+
+        if (pos.nalOffset < 4
+                || memcmp(&data[pos.nalOffset - 4], "\x00\x00\x00\x01", 4)) {
+            return false;
+        }
+
+        if (i > 0) {
+            const NALPosition &prev = nals.itemAt(i - 1);
+            if (prev.nalOffset + prev.nalSize + 4 != pos.nalOffset) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
 sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitH264() {
     const uint8_t *data = mBuffer->data();
 
@@ -1992,7 +2036,22 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitH264() {
             // the current one, separated by 0x00 0x00 0x00 0x01 startcodes.
 
             size_t auSize = 4 * nals.size() + totalSize;
-            sp<ABuffer> accessUnit = new ABuffer(auSize);
+            const NALPosition &pos = nals.itemAt(nals.size() - 1);
+            size_t nextScan = pos.nalOffset + pos.nalSize;
+
+            // Usually every NAL unit already sits behind a 4-byte start code
+            // with nothing in between, then the access unit is handed out
+            // as it is in the buffer.
+            bool isView = mSampleDecryptor == NULL
+                    && IsContiguousAccessUnit(mBuffer->data(), nals);
+
+            sp<ABuffer> accessUnit;
+            if (isView) {
+                accessUnit = new AccessUnitView(
+                        mBuffer, mBuffer->data() + nextScan - auSize, auSize);
+            } else {
+                accessUnit = new ABuffer(auSize);
+            }
             sp<ABuffer> sei;
 
             if (seiCount > 0) {
@@ -2031,6 +2090,11 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitH264() {
                 out.append(tmp);
 #endif
 
+                if (isView) {
+                    dstOffset += pos.nalSize + 4;
+                    continue;
+                }
+
                 memcpy(accessUnit->data() + dstOffset, "\x00\x00\x00\x01", 4);
 
                 if (mSampleDecryptor != NULL && (nalType == 1 || nalType == 5)) {
@@ -2069,14 +2133,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitH264() {
             ALOGV("accessUnit contains nal types %s", out.c_str());
 #endif
 
-            const NALPosition &pos = nals.itemAt(nals.size() - 1);
-            size_t nextScan = pos.nalOffset + pos.nalSize;
-
-            memmove(mBuffer->data(),
-                    mBuffer->data() + nextScan,
-                    mBuffer->size() - nextScan);
-
-            mBuffer->setRange(0, mBuffer->size() - nextScan);
+            consumeData(nextScan);
 
             int64_t timeUs = fetchTimestamp(nextScan);
             if (timeUs < 0LL) {
@@ -2145,7 +2202,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGAudio() {
                 header, &frameSize, &samplingRate, &numChannels,
                 &bitrate, &numSamples)) {
         ALOGE("Failed to get audio frame size");
-        mBuffer->setRange(0, 0);
+        consumeData(mBuffer->size());
         return NULL;
     }
 
@@ -2155,14 +2212,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGAudio() {
 
     unsigned layer = 4 - ((header >> 17) & 3);
 
-    sp<ABuffer> accessUnit = new ABuffer(frameSize);
-    memcpy(accessUnit->data(), data, frameSize);
-
-    memmove(mBuffer->data(),
-            mBuffer->data() + frameSize,
-            mBuffer->size() - frameSize);
-
-    mBuffer->setRange(0, mBuffer->size() - frameSize);
+    sp<ABuffer> accessUnit = takeAccessUnit(0, frameSize);
 
     int64_t timeUs = fetchTimestamp(frameSize);
     if (timeUs < 0LL) {
@@ -2285,11 +2335,11 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGVideo() {
         currentStartCode = data[offset + 3];
 
         if (currentStartCode == 0xb3 && mFormat == NULL) {
-            memmove(mBuffer->data(), mBuffer->data() + offset, size - offset);
+            consumeData(offset);
+            data = mBuffer->data();
             size -= offset;
             (void)fetchTimestamp(offset);
             offset = 0;
-            mBuffer->setRange(0, size);
         }
 
         if ((prevStartCode == 0xb3 && currentStartCode != 0xb5)
@@ -2318,11 +2368,8 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGVideo() {
                 sp<ABuffer> csd = new ABuffer(offset);
                 memcpy(csd->data(), data, offset);
 
-                memmove(mBuffer->data(),
-                        mBuffer->data() + offset,
-                        mBuffer->size() - offset);
-
-                mBuffer->setRange(0, mBuffer->size() - offset);
+                consumeData(offset);
+                data = mBuffer->data();
                 size -= offset;
                 (void)fetchTimestamp(offset);
                 offset = 0;
@@ -2358,14 +2405,7 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEGVideo() {
             if (!sawPictureStart) {
                 sawPictureStart = true;
             } else {
-                sp<ABuffer> accessUnit = new ABuffer(offset);
-                memcpy(accessUnit->data(), data, offset);
-
-                memmove(mBuffer->data(),
-                        mBuffer->data() + offset,
-                        mBuffer->size() - offset);
-
-                mBuffer->setRange(0, mBuffer->size() - offset);
+                sp<ABuffer> accessUnit = takeAccessUnit(0, offset);
 
                 int64_t timeUs = fetchTimestamp(offset);
                 if (timeUs < 0LL) {
@@ -2557,12 +2597,8 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEG4Video() {
 
                     offset += chunkSize;
 
-                    sp<ABuffer> accessUnit = new ABuffer(offset);
-                    memcpy(accessUnit->data(), data, offset);
-
-                    memmove(data, &data[offset], size - offset);
+                    sp<ABuffer> accessUnit = takeAccessUnit(0, offset);
                     size -= offset;
-                    mBuffer->setRange(0, size);
 
                     int64_t timeUs = fetchTimestamp(offset);
                     if (timeUs < 0LL) {
@@ -2598,10 +2634,10 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMPEG4Video() {
 
         if (discard) {
             (void)fetchTimestamp(offset);
-            memmove(data, &data[offset], size - offset);
+            consumeData(offset);
+            data = mBuffer->data();
             size -= offset;
             offset = 0;
-            mBuffer->setRange(0, size);
         } else {
             offset += chunkSize;
         }
@@ -2628,13 +2664,10 @@ sp<ABuffer> ElementaryStreamQueue::dequeueAccessUnitMetadata() {
         return NULL;
     }
 
-    sp<ABuffer> accessUnit = new ABuffer(size);
     int64_t timeUs = fetchTimestamp(size);
+    sp<ABuffer> accessUnit = takeAccessUnit(0, size);
     accessUnit->meta()->setInt64("timeUs", timeUs);
 
-    memcpy(accessUnit->data(), mBuffer->data(), size);
-    mBuffer->setRange(0, 0);
-
     if (mFormat == NULL) {
         mFormat = new MetaData;
         mFormat->setCString(kKeyMIMEType, MEDIA_MIMETYPE_DATA_TIMED_ID3);
@@ -98,11 +98,19 @@ private:
         sp<ABuffer> mEncSizes;
     };
 
+    struct AccessUnitView;
+
     Mode mMode;
     uint32_t mFlags;
     bool mEOSReached;
 
+    // Consumed data is dropped by advancing the range of mBuffer rather than
+    // by moving what remains to the front. Access units are handed out as
+    // views into it wherever their bytes can be used as they are, so its
+    // storage is only recycled, through mChunkPool, once all of them have
+    // been released; data that no longer fits moves on to another chunk.
     sp<ABuffer> mBuffer;
+    std::vector<sp<ABuffer>> mChunkPool;
     List<RangeInfo> mRangeInfos;
 
     sp<ABuffer> mScrambledBuffer;
@@ -131,6 +139,15 @@ private:
     sp<ABuffer> dequeueAccessUnitDTSOrDTSHD();
     sp<ABuffer> dequeueAccessUnitDTSUHD();
 
+    sp<ABuffer> acquireChunk(size_t size);
+
+    // drops the first "size" bytes of mBuffer.
+    void consumeData(size_t size);
+
+    // returns "size" bytes of mBuffer at "offset" as an access unit,
+    // without copying them, and consumes everything up to its end.
+    sp<ABuffer> takeAccessUnit(size_t offset, size_t size);
+
     // consume a logical (compressed) access unit of size "size",
     // returns its timestamp in us (or -1 if no time information).
     int64_t fetchTimestamp(size_t size,
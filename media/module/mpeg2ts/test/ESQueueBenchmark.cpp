@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures ElementaryStreamQueue access unit assembly throughput, in MB of
+// elementary stream per second, for synthetic streams of the main codec
+// types. Every PES payload is appended the way ATSParser does it, and the
+// queue is drained after each one.
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <media/stagefright/foundation/ABuffer.h>
+#include <mpeg2ts/ESQueue.h>
+
+using namespace android;
+
+typedef std::vector<uint8_t> PesPayload;
+
+static constexpr size_t kNumPesPayloads = 240;
+static constexpr int64_t kFrameDurationUs = 33333;
+
+// Filler that never forms a start code or sync word.
+static void appendFiller(PesPayload *pes, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        pes->push_back(0x55 + (i & 0x0f));
+    }
+}
+
+// Access unit delimiter plus one slice, 1080p-ish sizes with an IDR frame
+// every 30.
+static std::vector<PesPayload> makeH264Stream() {
+    std::vector<PesPayload> stream;
+    for (size_t i = 0; i < kNumPesPayloads; ++i) {
+        PesPayload pes = {0x00, 0x00, 0x00, 0x01, 0x09, 0xf0};
+        bool idr = i % 30 == 0;
+        // nal_unit_type 5 or 1, first_mb_in_slice 0.
+        pes.insert(pes.end(), {0x00, 0x00, 0x00, 0x01, (uint8_t)(idr ? 0x65 : 0x41), 0x88});
+        appendFiller(&pes, idr ? 250000 : 60000);
+        stream.push_back(pes);
+    }
+    return stream;
+}
+
+// Sequence header once, then a GOP header and picture per PES.
+static std::vector<PesPayload> makeMPEGVideoStream() {
+    std::vector<PesPayload> stream;
+    for (size_t i = 0; i < kNumPesPayloads; ++i) {
+        PesPayload pes;
+        if (i == 0) {
+            // 1920x1080, aspect 16:9, 29.97 fps.
+            pes.insert(pes.end(), {0x00, 0x00, 0x01, 0xb3, 0x78, 0x04, 0x38, 0x34,
+                                   0xff, 0xff, 0xe0, 0x18});
+        }
+        if (i % 15 == 0) {
+            // Closed GOP.
+            pes.insert(pes.end(), {0x00, 0x00, 0x01, 0xb8, 0x00, 0x08, 0x00, 0x40});
+        }
+        pes.insert(pes.end(), {0x00, 0x00, 0x01, 0x00, 0x00, 0x0f, 0xff, 0xf8});
+        appendFiller(&pes, i % 15 == 0 ? 200000 : 50000);
+        stream.push_back(pes);
+    }
+    return stream;
+}
+
+// ADTS, AAC LC at 48 kHz stereo, a few frames per PES.
+static std::vector<PesPayload> makeAACStream() {
+    static constexpr size_t kFrameLength = 768;
+    std::vector<PesPayload> stream;
+    for (size_t i = 0; i < kNumPesPayloads; ++i) {
+        PesPayload pes;
+        for (size_t j = 0; j < 4; ++j) {
+            pes.insert(pes.end(), {
+                    0xff, 0xf1,
+                    (1 << 6) | (3 << 2),  // LC, 48 kHz
+                    (2 << 6) | ((kFrameLength >> 11) & 3),  // 2 channels
+                    (kFrameLength >> 3) & 0xff,
+                    ((kFrameLength & 7) << 5) | 0x1f,
+                    0xfc});
+            appendFiller(&pes, kFrameLength - 7);
+        }
+        stream.push_back(pes);
+    }
+    return stream;
+}
+
+// MPEG-1 layer III, 320 kbps at 48 kHz, a few frames per PES.
+static std::vector<PesPayload> makeMPEGAudioStream() {
+    static constexpr size_t kFrameSize = 144 * 320000 / 48000;
+    std::vector<PesPayload> stream;
+    for (size_t i = 0; i < kNumPesPayloads; ++i) {
+        PesPayload pes;
+        for (size_t j = 0; j < 4; ++j) {
+            pes.insert(pes.end(), {0xff, 0xfb, 0xe4, 0x00});
+            appendFiller(&pes, kFrameSize - 4);
+        }
+        stream.push_back(pes);
+    }
+    return stream;
+}
+
+static void runQueue(
+        benchmark::State &state,
+        ElementaryStreamQueue::Mode mode,
+        const std::vector<PesPayload> &stream) {
+    ElementaryStreamQueue queue(mode);
+
+    size_t bytes = 0;
+    size_t accessUnits = 0;
+    int64_t timeUs = 0;
+
+    for (auto _ : state) {
+        for (const PesPayload &pes : stream) {
+            if (queue.appendData(pes.data(), pes.size(), timeUs) != OK) {
+                state.SkipWithError("appendData failed");
+                return;
+            }
+            timeUs += kFrameDurationUs;
+            bytes += pes.size();
+
+            sp<ABuffer> accessUnit;
+            while ((accessUnit = queue.dequeueAccessUnit()) != NULL) {
+                ++accessUnits;
+            }
+        }
+    }
+
+    if (accessUnits == 0) {
+        state.SkipWithError("no access unit assembled");
+        return;
+    }
+
+    state.counters["MB/s"] = benchmark::Counter(bytes / 1E6, benchmark::Counter::kIsRate);
+    state.counters["AU/s"] = benchmark::Counter(accessUnits, benchmark::Counter::kIsRate);
+}
+
+static void BM_H264(benchmark::State &state) {
+    runQueue(state, ElementaryStreamQueue::H264, makeH264Stream());
+}
+
+static void BM_MPEGVideo(benchmark::State &state) {
+    runQueue(state, ElementaryStreamQueue::MPEG_VIDEO, makeMPEGVideoStream());
+}
+
+static void BM_AAC(benchmark::State &state) {
+    runQueue(state, ElementaryStreamQueue::AAC, makeAACStream());
+}
+
+static void BM_MPEGAudio(benchmark::State &state) {
+    runQueue(state, ElementaryStreamQueue::MPEG_AUDIO, makeMPEGAudioStream());
+}
+
+BENCHMARK(BM_H264)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MPEGVideo)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_AAC)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MPEGAudio)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,186 @@
+/*
+**
+** Copyright 2026, The Android Open Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#define LOG_TAG "AudioFlinger::EffectChainWorkerPool"
+//#define LOG_NDEBUG 0
+
+#include "EffectChainWorkerPool.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include <android-base/stringprintf.h>
+#include <pthread.h>
+#include <system/thread_defs.h>
+#include <unistd.h>
+#include <utils/Log.h>
+#include <utils/ThreadDefs.h>
+#include <utils/Timers.h>
+
+namespace android {
+
+EffectChainWorkerPool::EffectChainWorkerPool(const std::string& name, size_t numWorkers) {
+    numWorkers = std::min(numWorkers, kMaxWorkers);
+    mTids.resize(numWorkers, -1);
+    mThreads.reserve(numWorkers);
+    for (size_t i = 0; i < numWorkers; ++i) {
+        mThreads.emplace_back([this, i, name] {
+            // thread names are limited to 16 characters including the terminating null
+            const std::string threadName = (name + "_fx" + std::to_string(i)).substr(0, 15);
+            pthread_setname_np(pthread_self(), threadName.c_str());
+            // Until the real-time priority requested by the owner is granted, run at the
+            // priority of a normal mixer thread.
+            androidSetThreadPriority(0 /* tid */, ANDROID_PRIORITY_URGENT_AUDIO);
+            threadLoop(i);
+        });
+    }
+
+    // wait for the tids to be published, so that the owner can request a priority for them
+    std::unique_lock _l(mMutex);
+    mJoinCondition.wait(_l, [this] { return mStarted == mTids.size(); });
+}
+
+EffectChainWorkerPool::~EffectChainWorkerPool() {
+    {
+        std::lock_guard _l(mMutex);
+        mExit = true;
+    }
+    mWorkCondition.notify_all();
+    for (auto& thread : mThreads) {
+        thread.join();
+    }
+}
+
+void EffectChainWorkerPool::threadLoop(size_t index) {
+    std::unique_lock _l(mMutex);
+    mTids[index] = gettid();
+    if (++mStarted == mTids.size()) {
+        mJoinCondition.notify_all();
+    }
+
+    uint32_t generation = mGeneration;
+    while (true) {
+        mWorkCondition.wait(_l, [&] { return mExit || mGeneration != generation; });
+        if (mExit) {
+            return;
+        }
+        generation = mGeneration;
+        const size_t count = mCount;
+        const std::function<void(size_t)>* task = mTask;
+        _l.unlock();
+
+        size_t taskIndex;
+        size_t ran = 0;
+        while (claim(generation, count, &taskIndex)) {
+            runClaimed(*task, taskIndex, count);
+            ++ran;
+        }
+        if (ran > 0) {
+            mTasksOnWorkers.fetch_add(ran, std::memory_order_relaxed);
+        }
+        _l.lock();
+    }
+}
+
+bool EffectChainWorkerPool::claim(uint32_t generation, size_t count, size_t* index) {
+    uint64_t next = mNext.load(std::memory_order_acquire);
+    while (true) {
+        if ((next >> 32) != generation || (next & 0xffffffff) >= count) {
+            return false;
+        }
+        if (mNext.compare_exchange_weak(next, next + 1,
+                std::memory_order_acq_rel, std::memory_order_acquire)) {
+            *index = next & 0xffffffff;
+            return true;
+        }
+    }
+}
+
+void EffectChainWorkerPool::runClaimed(
+        const std::function<void(size_t)>& task, size_t index, size_t count) {
+    task(index);
+    if (mCompleted.fetch_add(1, std::memory_order_acq_rel) + 1 == count) {
+        // take the mutex so that the notification cannot be lost between the caller
+        // checking mCompleted and waiting.
+        std::lock_guard _l(mMutex);
+        mJoinCondition.notify_all();
+    }
+}
+
+void EffectChainWorkerPool::run(
+        size_t count, const std::function<void(size_t)>& task, int64_t deadlineNs) {
+    if (count == 0) {
+        return;
+    }
+    mRuns.fetch_add(1, std::memory_order_relaxed);
+    mTasks.fetch_add(count, std::memory_order_relaxed);
+
+    uint32_t generation;
+    {
+        std::lock_guard _l(mMutex);
+        generation = ++mGeneration;
+        mCount = count;
+        mTask = &task;
+        mCompleted.store(0, std::memory_order_relaxed);
+        mNext.store(static_cast<uint64_t>(generation) << 32, std::memory_order_release);
+    }
+    // Only wake up as many workers as can get a task, the caller takes one itself.
+    if (count > 2) {
+        mWorkCondition.notify_all();
+    } else if (count == 2) {
+        mWorkCondition.notify_one();
+    }
+
+    size_t index;
+    while (claim(generation, count, &index)) {
+        runClaimed(task, index, count);
+    }
+
+    if (mCompleted.load(std::memory_order_acquire) == count) {
+        return;
+    }
+    const int64_t waitStartNs = systemTime();
+    std::unique_lock _l(mMutex);
+    const auto done = [&] { return mCompleted.load(std::memory_order_acquire) == count; };
+    if (!mJoinCondition.wait_for(_l,
+            std::chrono::nanoseconds(std::max<int64_t>(0, deadlineNs - waitStartNs)), done)) {
+        mLateJoins.fetch_add(1, std::memory_order_relaxed);
+        // The remaining tasks are writing to buffers needed for the mix, keep waiting.
+        mJoinCondition.wait(_l, done);
+    }
+    const int64_t waitNs = systemTime() - waitStartNs;
+    if (waitNs > mMaxJoinWaitNs.load(std::memory_order_relaxed)) {
+        mMaxJoinWaitNs.store(waitNs, std::memory_order_relaxed);
+    }
+}
+
+std::string EffectChainWorkerPool::dump() const {
+    std::string tids;
+    for (pid_t tid : mTids) {
+        tids.append(" ").append(std::to_string(tid));
+    }
+    return base::StringPrintf("%zu workers (tids%s), runs: %llu, tasks: %llu (%llu on workers),"
+            " late joins: %llu, max join wait: %.3f ms",
+            mTids.size(), tids.c_str(),
+            (unsigned long long)mRuns.load(std::memory_order_relaxed),
+            (unsigned long long)mTasks.load(std::memory_order_relaxed),
+            (unsigned long long)mTasksOnWorkers.load(std::memory_order_relaxed),
+            (unsigned long long)mLateJoins.load(std::memory_order_relaxed),
+            mMaxJoinWaitNs.load(std::memory_order_relaxed) * 1e-6);
+}
+
+}  // namespace android
@@ -0,0 +1,94 @@
+/*
+**
+** Copyright 2026, The Android Open Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace android {
+
+// A small, fixed set of worker threads used by a PlaybackThread to process independent
+// session effect chains in parallel.
+//
+// run() is called once per mixer period from the thread loop. The calling thread takes part in
+// the work: tasks are claimed with a single atomic counter, so a task that no worker has picked
+// up yet is simply run by the caller, and a worker that wakes up late never delays the period.
+// Only tasks already claimed by a worker are waited for; if that wait exceeds the deadline the
+// join is counted as late (see dump()), but the caller still waits as the output buffers of
+// those tasks are needed for the mix.
+class EffectChainWorkerPool {
+public:
+    // Upper bound on the number of workers of a pool, the caller excluded.
+    static constexpr size_t kMaxWorkers = 3;
+
+    EffectChainWorkerPool(const std::string& name, size_t numWorkers);
+    ~EffectChainWorkerPool();
+
+    size_t numWorkers() const { return mTids.size(); }
+
+    // Thread ids of the workers, for priority requests.
+    const std::vector<pid_t>& tids() const { return mTids; }
+
+    // Runs task(0) .. task(count - 1) and returns once all have completed.
+    // deadlineNs is in the CLOCK_MONOTONIC time base of systemTime().
+    void run(size_t count, const std::function<void(size_t)>& task, int64_t deadlineNs);
+
+    std::string dump() const;
+
+private:
+    void threadLoop(size_t index);
+
+    // Claims the next task of generation "generation", returns false if there is none left.
+    bool claim(uint32_t generation, size_t count, size_t* index);
+    void runClaimed(const std::function<void(size_t)>& task, size_t index, size_t count);
+
+    std::vector<std::thread> mThreads;
+    std::vector<pid_t> mTids;
+
+    std::mutex mMutex;
+    std::condition_variable mWorkCondition;  // workers wait for a new generation or exit
+    std::condition_variable mJoinCondition;  // the caller waits for claimed tasks to complete
+    uint32_t mGeneration = 0;                 // guarded by mMutex
+    size_t mCount = 0;                        // guarded by mMutex
+    const std::function<void(size_t)>* mTask = nullptr;  // guarded by mMutex
+    bool mExit = false;                       // guarded by mMutex
+    size_t mStarted = 0;                      // guarded by mMutex
+
+    // Generation in the upper 32 bits, index of the next unclaimed task in the lower 32 bits.
+    // Tagging claims with the generation keeps a worker that wakes up after its generation
+    // completed from picking up a task of the next one.
+    std::atomic<uint64_t> mNext{0};
+    std::atomic<size_t> mCompleted{0};
+
+    // Statistics, read by dump() on another thread. mTasksOnWorkers is updated by the workers,
+    // the others by the caller of run().
+    std::atomic<uint64_t> mRuns{0};
+    std::atomic<uint64_t> mTasks{0};
+    std::atomic<uint64_t> mTasksOnWorkers{0};
+    std::atomic<uint64_t> mLateJoins{0};
+    std::atomic<int64_t> mMaxJoinWaitNs{0};
+};
+
+}  // namespace android
@@ -48,6 +48,7 @@
 #include <system/audio_effects/effect_spatializer.h>
 #include <system/audio_effects/effect_visualizer.h>
 #include <utils/Log.h>
+#include <utils/Timers.h>
 
 #include <algorithm>
 
@@ -771,7 +772,9 @@ void EffectModule::process()
                     outBuffer = mOutConversionBuffer;
                 }
             }
+            const nsecs_t processStartNs = systemTime();
             ret = mEffectInterface->process();
+            mProcessTimes.add(systemTime() - processStartNs);
             if (!mSupportsFloat) { // convert output int16_t back to float.
                 sp<EffectBufferHalInterface> target =
                         mOutChannelCountRequested != outChannelCount
@@ -1757,6 +1760,10 @@ void EffectModule::dump(int fd, const Vector<String16>& args) const {
             dumpInOutBuffer(false /* isInput */, mOutBuffer).c_str(),
             dumpInOutBuffer(false /* isInput */, mOutConversionBuffer).c_str());
 
+    if (mProcessTimes.count() > 0) {
+        result.appendFormat("\t\t- process time (us): %s\n", mProcessTimes.toString().c_str());
+    }
+
     write(fd, result.c_str(), result.length());
 
     if (mEffectInterface != 0) {
@@ -2324,6 +2331,14 @@ void EffectChain::clearInputBuffer_l()
 
 // Must be called with EffectChain::mutex() locked
 void EffectChain::process_l() {
+    if (prepareProcess_l()) {
+        processEffects_l();
+    }
+    finishProcess_l();
+}
+
+// Must be called with EffectChain::mutex() locked
+bool EffectChain::prepareProcess_l() {
     // never process effects when:
     // - on an OFFLOAD thread
     // - no more tracks are on the session and the effect tail has been rendered
@@ -2346,26 +2361,35 @@ void EffectChain::process_l() {
             }
         }
     }
+    return doProcess;
+}
 
-    size_t size = mEffects.size();
-    if (doProcess) {
-        // Only the input and output buffers of the chain can be external,
-        // and 'update' / 'commit' do nothing for allocated buffers, thus
-        // it's not needed to consider any other buffers here.
-        mInBuffer->update();
-        if (mInBuffer->audioBuffer()->raw != mOutBuffer->audioBuffer()->raw) {
-            mOutBuffer->update();
-        }
-        for (size_t i = 0; i < size; i++) {
-            mEffects[i]->process();
-        }
-        mInBuffer->commit();
-        if (mInBuffer->audioBuffer()->raw != mOutBuffer->audioBuffer()->raw) {
-            mOutBuffer->commit();
-        }
+// Must be called with EffectChain::mutex() held, possibly by another thread waiting for
+// this one to return.
+void EffectChain::processEffects_l() {
+    const int64_t startNs = systemTime();
+    // Only the input and output buffers of the chain can be external,
+    // and 'update' / 'commit' do nothing for allocated buffers, thus
+    // it's not needed to consider any other buffers here.
+    mInBuffer->update();
+    if (mInBuffer->audioBuffer()->raw != mOutBuffer->audioBuffer()->raw) {
+        mOutBuffer->update();
     }
+    for (size_t i = 0; i < mEffects.size(); i++) {
+        mEffects[i]->process();
+    }
+    mInBuffer->commit();
+    if (mInBuffer->audioBuffer()->raw != mOutBuffer->audioBuffer()->raw) {
+        mOutBuffer->commit();
+    }
+    mLastProcessTimeNs = systemTime() - startNs;
+    mProcessTimeUs.add(mLastProcessTimeNs * 1e-3);
+}
+
+// Must be called with EffectChain::mutex() locked
+void EffectChain::finishProcess_l() {
     bool doResetVolume = false;
-    for (size_t i = 0; i < size; i++) {
+    for (size_t i = 0; i < mEffects.size(); i++) {
         // reset volume when any effect just started or stopped.
         // resetVolume_l will check if the volume controller effect in the chain needs update and
         // apply the correct volume
@@ -2827,6 +2851,10 @@ void EffectChain::dump(int fd, const Vector<String16>& args) const
             (int)outBufferStr.size(), "Out buffer      ");
     result.appendFormat("\t%s   %s   %d\n",
             inBufferStr.c_str(), outBufferStr.c_str(), mActiveTrackCnt);
+    if (mProcessTimeUs.getN() > 0) {
+        result.appendFormat("\tProcess time us: last %.1f, stats: %s\n",
+                mLastProcessTimeNs * 1e-3, mProcessTimeUs.toString().c_str());
+    }
     write(fd, result.c_str(), result.size());
 
     for (size_t i = 0; i < numEffects; ++i) {
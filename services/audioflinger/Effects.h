@@ -21,8 +21,10 @@
 #include "IAfEffect.h"
 
 #include <android-base/macros.h>  // DISALLOW_COPY_AND_ASSIGN
+#include <audio_utils/Statistics.h>
 #include <mediautils/Synchronization.h>
 #include <private/media/AudioEffectShared.h>
+#include <timing/PhaseTimes.h>
 
 #include <map>  // avoid transitive dependency
 #include <optional>
@@ -293,6 +295,9 @@ private:
     uint32_t mInChannelCountRequested;
     uint32_t mOutChannelCountRequested;
 
+    // Time spent in the effect engine process(), written by the thread processing the effect.
+    audioflinger::LatencyHistogram mProcessTimes;
+
     template <typename MUTEX>
     class AutoLockReentrant {
     public:
@@ -475,6 +480,9 @@ public:
                 const sp<IAfThreadCallback>& afThreadCallback);
 
     void process_l() final REQUIRES(audio_utils::EffectChain_Mutex);
+    bool prepareProcess_l() final REQUIRES(audio_utils::EffectChain_Mutex);
+    void processEffects_l() final REQUIRES(audio_utils::EffectChain_Mutex);
+    void finishProcess_l() final REQUIRES(audio_utils::EffectChain_Mutex);
 
     audio_utils::mutex& mutex() const final RETURN_CAPABILITY(audio_utils::EffectChain_Mutex) {
         return mMutex;
@@ -770,6 +778,11 @@ public:
              const sp<EffectCallback> mEffectCallback;
 
              wp<IAfEffectModule> mVolumeControlEffect;
+
+             // time spent in processEffects_l(), on whichever thread ran it
+             audio_utils::Statistics<double> mProcessTimeUs
+                     GUARDED_BY(mutex()) {0.995 /* alpha */};
+             int64_t mLastProcessTimeNs GUARDED_BY(mutex()) = 0;
 };
 
 class DeviceEffectProxy : public IAfDeviceEffectProxy, public EffectBase {
@@ -237,6 +237,14 @@ public:
 
     virtual void process_l() REQUIRES(audio_utils::EffectChain_Mutex) = 0;
 
+    // process_l() is prepareProcess_l(), then processEffects_l() if prepareProcess_l() returned
+    // true, then finishProcess_l(). processEffects_l() only touches the effects and the chain
+    // buffers: for a chain that does not share its buffers with other chains, it can be called
+    // from a worker thread while the caller holds the chain mutex and waits for it to return.
+    virtual bool prepareProcess_l() REQUIRES(audio_utils::EffectChain_Mutex) = 0;
+    virtual void processEffects_l() REQUIRES(audio_utils::EffectChain_Mutex) = 0;
+    virtual void finishProcess_l() REQUIRES(audio_utils::EffectChain_Mutex) = 0;
+
     virtual audio_utils::mutex& mutex() const RETURN_CAPABILITY(audio_utils::EffectChain_Mutex) = 0;
 
     virtual status_t createEffect(sp<IAfEffectModule>& effect, effect_descriptor_t* desc, int id,
@@ -23,6 +23,7 @@
 #include <binder/IMemory.h>
 #include <media/AppOpsSession.h>
 #include <mediautils/SingleThreadExecutor.h>
+#include <datapath/DuplicationRing.h>
 #include <datapath/VolumePortInterface.h>
 #include <fastpath/FastMixerDumpState.h>
 #include <media/AudioSystem.h>
@@ -557,9 +558,17 @@ public:
             IAfPlaybackThread* playbackThread,
             IAfDuplicatingThread* sourceThread, uint32_t sampleRate,
             audio_format_t format, audio_channel_mask_t channelMask, size_t frameCount,
-            const AttributionSourceState& attributionSource);
+            const AttributionSourceState& attributionSource,
+            const sp<DuplicationRing>& ring);
 
     virtual ssize_t write(void* data, uint32_t frames) = 0;
+    /**
+     * When the track reads from a DuplicationRing, called by the duplicating thread before
+     * it writes "frames" to the ring. Returns false if that would overwrite frames the track
+     * accepted and has not released yet, in which case the ring must not be written: write()
+     * then copies the data instead.
+     */
+    virtual bool prepareSharedWrite(size_t frames) = 0;
     virtual bool bufferQueueEmpty() const = 0;
     virtual bool isActive() const = 0;
 
@@ -669,6 +678,10 @@ public:
     virtual audioflinger::SynchronizedRecordState& synchronizedRecordState() = 0;
     virtual RecordBufferConverter* recordBufferConverter() const = 0;
     virtual ResamplerBufferProvider* resamplerBufferProvider() const = 0;
+    // Replaces the converter, returning the previous one which the caller now owns.
+    // Used to hand the conversion state over to and from a SharedRecordConverter.
+    virtual RecordBufferConverter* exchangeRecordBufferConverter(
+            RecordBufferConverter* converter) = 0;
 };
 
 // PatchProxyBufferProvider interface is implemented by PatchTrack and PatchRecord.
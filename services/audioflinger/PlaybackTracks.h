@@ -442,7 +442,8 @@ public:
                                 audio_format_t format,
                                 audio_channel_mask_t channelMask,
                                 size_t frameCount,
-                                const AttributionSourceState& attributionSource);
+                                const AttributionSourceState& attributionSource,
+                                const sp<DuplicationRing>& ring);
     ~OutputTrack() override;
 
     status_t start(AudioSystem::sync_event_t event =
@@ -450,9 +451,16 @@ public:
                              audio_session_t triggerSession = AUDIO_SESSION_NONE) final;
     void stop() final;
     ssize_t write(void* data, uint32_t frames) final;
-    bool bufferQueueEmpty() const final { return mBufferQueue.size() == 0; }
+    bool prepareSharedWrite(size_t frames) final;
+    bool bufferQueueEmpty() const final {
+        return mBufferQueue.size() == 0
+                && (mRingReader == nullptr || mRingReader->pendingFrames() == 0);
+    }
     bool isActive() const final { return mActive; }
 
+    // AudioBufferProvider interface, redirects reads to the DuplicationRing if there is one.
+    status_t getNextBuffer(AudioBufferProvider::Buffer* buffer) final;
+
     void copyMetadataTo(MetadataInserter& backInserter) const final;
     /** Set the metadatas of the upstream tracks. Thread safe. */
     void setMetadatas(const SourceMetadatas& metadatas) final;
@@ -473,6 +481,8 @@ private:
                                      uint32_t waitTimeMs);
     void                queueBuffer(Buffer& inBuffer);
     void                clearBufferQueue();
+    // write() when reading from a DuplicationRing, data has usually already been written to it.
+    ssize_t writeShared(void* data, uint32_t frames);
 
     void restartIfDisabled() override;
 
@@ -485,6 +495,15 @@ private:
     IAfDuplicatingThread* const mSourceThread; // for waitTimeMs() in write()
     sp<AudioTrackClientProxy>   mClientProxy;
 
+    // Set when the output of the duplicating thread is shared through a DuplicationRing:
+    // the control block then only carries positions and the downstream thread reads the
+    // frames from the ring. Accepting, dropping and stop() happen on the duplicating thread,
+    // getNextBuffer() on the downstream thread.
+    const std::unique_ptr<DuplicationRing::Reader> mRingReader;
+    // Ring write position after the write prepared by prepareSharedWrite(), to tell in
+    // writeShared() whether the data was written to the ring.
+    int64_t mSharedWriteEnd = -1;
+
     /** Attributes of the source tracks.
      *
      * This member must be accessed with mTrackMetadatasMutex taken.
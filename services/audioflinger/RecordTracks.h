@@ -98,6 +98,10 @@ public:
     ResamplerBufferProvider* resamplerBufferProvider() const final {
         return mResamplerBufferProvider;
     }
+    RecordBufferConverter* exchangeRecordBufferConverter(
+            RecordBufferConverter* converter) final {
+        return std::exchange(mRecordBufferConverter, converter);
+    }
 
     std::string trackFlagsAsString() const final { return toString(mFlags); }
 
@@ -236,9 +236,14 @@ static const enum {
 static const int kPriorityAudioApp = 2;
 static const int kPriorityFastMixer = 3;
 static const int kPriorityFastCapture = 3;
+static const int kPriorityEffectChainWorker = 2;
 // Request real-time priority for PlaybackThread in ARC
 static const int kPriorityPlaybackThreadArc = 1;
 
+// Output parameter enabling parallel session effect chains on a mixer thread, the value is the
+// number of worker threads (0 disables).
+static constexpr char kParallelEffectChainsKey[] = "parallel_effect_chains";
+
 // IAudioFlinger::createTrack() has an in/out parameter 'pFrameCount' for the total size of the
 // track buffer in shared memory.  Zero on input means to use a default value.  For fast tracks,
 // AudioFlinger derives the default from HAL buffer size and 'fast track multiplier'.
@@ -1143,6 +1148,10 @@ void ThreadBase::dumpBase_l(int fd, const Vector<String16>& /* args */)
         dprintf(fd, "  Process time ms stats: %s\n", mProcessTimeMs.toString().c_str());
     }
 
+    if (mPhaseTimes.cycles() > 0) {
+        dprintf(fd, "%s", mPhaseTimes.dump("  ").c_str());
+    }
+
     if (mIoJitterMs.getN() > 0) {
         dprintf(fd, "  Hal %s jitter ms stats: %s\n",
                 isOutput() ? "write" : "read",
@@ -2100,6 +2109,11 @@ NO_THREAD_SAFETY_ANALYSIS
         item->setDouble(MM_PREFIX "processTimeMs.mean", mProcessTimeMs.getMean());
         item->setDouble(MM_PREFIX "processTimeMs.std", mProcessTimeMs.getStdDev());
     }
+    if (mPhaseTimes.cycles() > 0) {
+        item->setInt64(MM_PREFIX "cycles", mPhaseTimes.cycles());
+        item->setInt64(MM_PREFIX "cyclesOverBudget", mPhaseTimes.cyclesOverBudget());
+        item->setCString(MM_PREFIX "phaseTimesUs", mPhaseTimes.toMetricsString().c_str());
+    }
     const auto tsjitter = mTimestampVerifier.getJitterMs();
     if (tsjitter.getN() > 0) {
         item->setDouble(MM_PREFIX "timestampJitterMs.mean", tsjitter.getMean());
@@ -2182,7 +2196,7 @@ PlaybackThread::PlaybackThread(const sp<IAfThreadCallback>& afThreadCallback,
         mDrainSequence(0),
         mScreenState(mAfThreadCallback->getScreenState()),
         // index 0 is reserved for normal mixer's submix
-        mFastTrackAvailMask(((1 << FastMixerState::sMaxFastTracks) - 1) & ~1),
+        mFastTracksAvailable(FastTrackSet::range(1, FastMixerState::sMaxFastTracks)),
         mHwSupportsPause(false), mHwPaused(false), mFlushPending(false),
         mLeftVolFloat(-1.0), mRightVolFloat(-1.0),
         mDownStreamPatch{},
@@ -2372,8 +2386,11 @@ void PlaybackThread::dumpInternals_l(int fd, const Vector<String16>& args)
     dprintf(fd, "  Delayed writes: %d\n", mNumDelayedWrites);
     dprintf(fd, "  Blocked in write: %s\n", mInWrite ? "yes" : "no");
     dprintf(fd, "  Suspend count: %d\n", (int32_t)mSuspended);
-    dprintf(fd, "  Fast track availMask=%#x\n", mFastTrackAvailMask);
+    dprintf(fd, "  Fast track availMask=%s\n", mFastTracksAvailable.toString().c_str());
     dprintf(fd, "  Standby delay ns=%lld\n", (long long)mStandbyDelayNs);
+    if (mEffectChainWorkers != nullptr) {
+        dprintf(fd, "  Parallel effect chains: %s\n", mEffectChainWorkers->dump().c_str());
+    }
     AudioStreamOut *output = mOutput;
     audio_output_flags_t flags = output != NULL ? output->flags : AUDIO_OUTPUT_FLAG_NONE;
     dprintf(fd, "  AudioStreamOut: %p flags %#x (%s)\n",
@@ -2482,7 +2499,7 @@ sp<IAfTrack> PlaybackThread::createTrack_l(
             // normal mixer has an associated fast mixer
             hasFastMixer() &&
             // there are sufficient fast track slots available
-            (mFastTrackAvailMask != 0)
+            !mFastTracksAvailable.empty()
             // FIXME test that MixerThread for this fast track has a capable output HAL
             // FIXME add a permission test also?
         ) {
@@ -2523,10 +2540,10 @@ sp<IAfTrack> PlaybackThread::createTrack_l(
         ALOGD("AUDIO_OUTPUT_FLAG_FAST denied: sharedBuffer=%p frameCount=%zu "
                 "mFrameCount=%zu format=%#x mFormat=%#x isLinear=%d channelMask=%#x "
                 "sampleRate=%u mSampleRate=%u "
-                "hasFastMixer=%d tid=%d fastTrackAvailMask=%#x",
+                "hasFastMixer=%d tid=%d fastTrackAvailMask=%s",
                 sharedBuffer.get(), frameCount, mFrameCount, format, mFormat,
                 audio_is_linear_pcm(format), channelMask, sampleRate,
-                mSampleRate, hasFastMixer(), tid, mFastTrackAvailMask);
+                mSampleRate, hasFastMixer(), tid, mFastTracksAvailable.toString().c_str());
         *flags = (audio_output_flags_t)(*flags & ~AUDIO_OUTPUT_FLAG_FAST);
       }
     }
@@ -3090,8 +3107,8 @@ void PlaybackThread::removeTrack_l(const sp<IAfTrack>& track)
     if (track->isFastTrack()) {
         int index = track->fastIndex();
         ALOG_ASSERT(0 < index && index < (int)FastMixerState::sMaxFastTracks);
-        ALOG_ASSERT(!(mFastTrackAvailMask & (1 << index)));
-        mFastTrackAvailMask |= 1 << index;
+        ALOG_ASSERT(!mFastTracksAvailable.contains(index));
+        mFastTracksAvailable.add(index);
         // redundant as track is about to be destroyed, for dumpsys only
         track->fastIndex() = -1;
     }
@@ -3409,6 +3426,10 @@ NO_THREAD_SAFETY_ANALYSIS
             this/* srcThread */, this/* dstThread */);
     }
 
+    // A cycle longer than a mix period is reported as over budget.
+    mPhaseTimes.setBudgetNs(mSampleRate == 0 ? 0
+            : (int64_t)mNormalFrameCount * NANOS_PER_SECOND / mSampleRate);
+
     audio_output_flags_t flags = mOutput->flags;
     mediametrics::LogItem item(mThreadMetrics.getMetricsId()); // TODO: method in ThreadMetrics?
     item.set(AMEDIAMETRICS_PROP_EVENT, AMEDIAMETRICS_PROP_EVENT_VALUE_READPARAMETERS)
@@ -3917,6 +3938,18 @@ status_t PlaybackThread::addEffectChain_l(const sp<IAfEffectChain>& chain)
                 buffer = halInBuffer ? halInBuffer->audioBuffer()->f32 : buffer;
                 ALOGV("addEffectChain_l() creating new input buffer %p session %d",
                         buffer, session);
+
+                // With parallel effect chains, the chain also gets its own output buffer
+                // which the thread loop accumulates into the effect buffer.
+                if (mType == MIXER && mParallelEffectChainWorkers > 0) {
+                    const status_t outStatus =
+                            mAfThreadCallback->getEffectsFactoryHal()->allocateBuffer(
+                            numSamples * sizeof(float),
+                            &halOutBuffer);
+                    if (outStatus != OK) return outStatus;
+                    ALOGV("addEffectChain_l() creating new output buffer %p session %d",
+                            halOutBuffer->audioBuffer()->f32, session);
+                }
             }
         }
     }
@@ -3972,6 +4005,7 @@ status_t PlaybackThread::addEffectChain_l(const sp<IAfEffectChain>& chain)
     }
     mEffectChains.insertAt(chain, i);
     checkSuspendOnAddEffectChain_l(chain);
+    updatePrivateEffectOutputChains_l();
 
     return NO_ERROR;
 }
@@ -3985,6 +4019,7 @@ size_t PlaybackThread::removeEffectChain_l(const sp<IAfEffectChain>& chain)
     for (size_t i = 0; i < mEffectChains.size(); i++) {
         if (chain == mEffectChains[i]) {
             mEffectChains.removeAt(i);
+            updatePrivateEffectOutputChains_l();
             // detach all active tracks from the chain
             for (const sp<IAfTrack>& track : mActiveTracks) {
                 if (session == track->sessionId()) {
@@ -4008,6 +4043,101 @@ size_t PlaybackThread::removeEffectChain_l(const sp<IAfEffectChain>& chain)
     return mEffectChains.size();
 }
 
+status_t PlaybackThread::setParallelEffectChains_l(int numWorkers)
+{
+    if (mType != MIXER) {
+        return INVALID_OPERATION;
+    }
+    if (numWorkers < 0) {
+        return BAD_VALUE;
+    }
+    const size_t workers = std::min<size_t>(numWorkers, EffectChainWorkerPool::kMaxWorkers);
+    if (workers == mParallelEffectChainWorkers) {
+        return NO_ERROR;
+    }
+    // Chains already attached keep their buffers: those with a private output buffer are
+    // processed inline when the pool is removed, the others stay serial until re-added.
+    mEffectChainWorkers.reset();
+    mParallelEffectChainWorkers = workers;
+    if (workers > 0) {
+        mEffectChainWorkers = std::make_unique<EffectChainWorkerPool>(mThreadName, workers);
+        for (pid_t tid : mEffectChainWorkers->tids()) {
+            sendPrioConfigEvent_l(getpid(), tid, kPriorityEffectChainWorker, false /*forApp*/);
+        }
+    }
+    ALOGI("%s: %s parallel effect chains with %zu workers",
+            __func__, mThreadName, workers);
+    return NO_ERROR;
+}
+
+bool PlaybackThread::hasPrivateEffectOutput(const sp<IAfEffectChain>& chain) const
+{
+    // Buffers of a chain are set before it is added to mEffectChains and never change after.
+    return mType == MIXER
+            && !audio_is_global_session(chain->sessionId())
+            && chain->outBuffer() != nullptr
+            && chain->outBuffer() != (mEffectBufferEnabled ? mEffectBuffer : mSinkBuffer);
+}
+
+void PlaybackThread::updatePrivateEffectOutputChains_l()
+{
+    mPrivateEffectOutputChains = 0;
+    for (const sp<IAfEffectChain>& chain : mEffectChains) {
+        if (hasPrivateEffectOutput(chain)) {
+            mPrivateEffectOutputChains++;
+        }
+    }
+}
+
+void PlaybackThread::processPrivateEffectChains(
+        const Vector<sp<IAfEffectChain>>& effectChains)
+        NO_THREAD_SAFETY_ANALYSIS  // chain mutexes are held by this thread for the workers
+{
+    mReadyEffectChains.clear();
+    for (size_t i = 0; i < effectChains.size(); i++) {
+        mPrivateEffectChainProcessed[i] = hasPrivateEffectOutput(effectChains[i]);
+        if (mPrivateEffectChainProcessed[i] && effectChains[i]->prepareProcess_l()) {
+            mReadyEffectChains.push_back(i);
+        }
+    }
+
+    mProcessingEffectChains = &effectChains;
+    if (mEffectChainWorkers != nullptr && mReadyEffectChains.size() > 1) {
+        // Join by the middle of the period, leaving the rest to the global chains and the write.
+        const int64_t periodNs = (int64_t)mNormalFrameCount * NANOS_PER_SECOND / mSampleRate;
+        mEffectChainWorkers->run(
+                mReadyEffectChains.size(), mReadyEffectChainTask, systemTime() + periodNs / 2);
+    } else {
+        for (size_t n = 0; n < mReadyEffectChains.size(); n++) {
+            processReadyEffectChain(n);
+        }
+    }
+    mProcessingEffectChains = nullptr;
+
+    const size_t audioSamples =
+            mNormalFrameCount * audio_channel_count_from_out_mask(mMixerChannelMask);
+    float* const mixBuffer = reinterpret_cast<float*>(
+            mEffectBufferEnabled ? mEffectBuffer : mSinkBuffer);
+    for (size_t i : mReadyEffectChains) {
+        accumulate_float(mixBuffer, effectChains[i]->outBuffer(), audioSamples);
+    }
+    for (size_t i = 0; i < effectChains.size(); i++) {
+        if (mPrivateEffectChainProcessed[i]) {
+            effectChains[i]->finishProcess_l();
+        }
+    }
+}
+
+void PlaybackThread::processReadyEffectChain(size_t n)
+        NO_THREAD_SAFETY_ANALYSIS  // chain mutexes are held by the thread loop
+{
+    const sp<IAfEffectChain>& chain = (*mProcessingEffectChains)[mReadyEffectChains[n]];
+    // effects accumulate into the chain output
+    memset(chain->outBuffer(), 0, mNormalFrameCount
+            * audio_channel_count_from_out_mask(mMixerChannelMask) * sizeof(float));
+    chain->processEffects_l();
+}
+
 status_t PlaybackThread::attachAuxEffect(
         const sp<IAfTrack>& track, int EffectId)
 {
@@ -4127,7 +4257,13 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
     {
         cpuStats.sample(myName);
 
+        // Phase times of this cycle, recorded if it writes to the HAL.
+        audioflinger::ThreadPhaseTimes::Cycle cycle;
+        cycle.startNs = systemTime();
+
         Vector<sp<IAfEffectChain>> effectChains;
+        // Whether some of effectChains have a private output buffer
+        bool hasPrivateEffectChains = false;
         audio_session_t activeHapticSessionId = AUDIO_SESSION_NONE;
         bool isHapticSessionSpatialized = false;
         std::vector<sp<IAfTrack>> activeTracks;
@@ -4271,7 +4407,10 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                 }
             }
             // mMixerStatusIgnoringFastTracks is also updated internally
+            const int64_t prepareBeginNs = systemTime();
             mMixerStatus = prepareTracks_l(&tracksToRemove);
+            cycle.phaseNs[audioflinger::ThreadPhaseTimes::PHASE_PREPARE] =
+                    systemTime() - prepareBeginNs;
 
             mActiveTracks.updatePowerState_l(this);
 
@@ -4316,6 +4455,12 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
             // during mixing and effect process as the audio buffers could be deleted
             // or modified if an effect is created or deleted
             lockEffectChains_l(effectChains);
+            hasPrivateEffectChains = mPrivateEffectOutputChains > 0;
+            if (hasPrivateEffectChains
+                    && mPrivateEffectChainProcessed.size() != effectChains.size()) {
+                mPrivateEffectChainProcessed.resize(effectChains.size());
+                mReadyEffectChains.reserve(effectChains.size());
+            }
 
             // Determine which session to pick up haptic data.
             // This must be done under the same lock as prepareTracks_l().
@@ -4345,7 +4490,10 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
             mCurrentWriteLength = 0;
             if (mMixerStatus == MIXER_TRACKS_READY) {
                 // threadLoop_mix() sets mCurrentWriteLength
+                const int64_t mixBeginNs = systemTime();
                 threadLoop_mix();
+                cycle.phaseNs[audioflinger::ThreadPhaseTimes::PHASE_MIX] =
+                        systemTime() - mixBeginNs;
             } else if ((mMixerStatus != MIXER_DRAIN_TRACK)
                         && (mMixerStatus != MIXER_DRAIN_ALL)) {
                 // threadLoop_sleepTime sets mSleepTimeUs to 0 if data
@@ -4432,9 +4580,19 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
             }
 
             // only process effects if we're going to write
-            if (mSleepTimeUs == 0 && mType != OFFLOAD) {
+            if (mSleepTimeUs == 0 && mType != OFFLOAD && !effectChains.isEmpty()) {
+                const int64_t effectsBeginNs = systemTime();
+                // Chains with a private output buffer are done first, possibly in parallel,
+                // and their output is already accumulated into the mix when this returns.
+                if (hasPrivateEffectChains) {
+                    processPrivateEffectChains(effectChains);
+                }
                 for (size_t i = 0; i < effectChains.size(); i ++) {
-                    effectChains[i]->process_l();
+                    const bool processed =
+                            hasPrivateEffectChains && mPrivateEffectChainProcessed[i];
+                    if (!processed) {
+                        effectChains[i]->process_l();
+                    }
                     // TODO: Write haptic data directly to sink buffer when mixing.
                     if (activeHapticSessionId != AUDIO_SESSION_NONE
                             && activeHapticSessionId == effectChains[i]->sessionId()) {
@@ -4450,13 +4608,20 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                         const size_t audioBufferSize = mNormalFrameCount
                             * audio_bytes_per_frame(hapticSessionChannelCount,
                                                     AUDIO_FORMAT_PCM_FLOAT);
+                        // A private output buffer has already been accumulated into the mix.
+                        uint8_t* const hapticOutBuffer = processed
+                                ? reinterpret_cast<uint8_t*>(
+                                        mEffectBufferEnabled ? mEffectBuffer : mSinkBuffer)
+                                : reinterpret_cast<uint8_t*>(effectChains[i]->outBuffer());
                         memcpy_by_audio_format(
-                                (uint8_t*)effectChains[i]->outBuffer() + audioBufferSize,
+                                hapticOutBuffer + audioBufferSize,
                                 AUDIO_FORMAT_PCM_FLOAT,
                                 (const uint8_t*)effectChains[i]->inBuffer() + audioBufferSize,
                                 AUDIO_FORMAT_PCM_FLOAT, mNormalFrameCount * mHapticChannelCount);
                     }
                 }
+                cycle.phaseNs[audioflinger::ThreadPhaseTimes::PHASE_EFFECTS] =
+                        systemTime() - effectsBeginNs;
             }
         }
         // Process effect chains for offloaded thread even if no audio
@@ -4556,6 +4721,11 @@ NO_THREAD_SAFETY_ANALYSIS  // manual locking of AudioFlinger
                         const int64_t frames = ret / mFrameSize;
                         mFramesWritten += frames;
 
+                        cycle.phaseNs[audioflinger::ThreadPhaseTimes::PHASE_WRITE] =
+                                lastIoEndNs - lastIoBeginNs;
+                        cycle.totalNs = lastIoEndNs - cycle.startNs;
+                        mPhaseTimes.recordCycle(cycle);
+
                         writePeriodNs = lastIoEndNs - mLastIoEndNs;
                         // process information relating to write time.
                         if (audio_has_proportional_frames(mFormat)) {
@@ -5179,6 +5349,7 @@ MixerThread::MixerThread(const sp<IAfThreadCallback>& afThreadCallback, AudioStr
             mSampleRate, mChannelMask, mChannelCount, mFormat, mFrameSize, mFrameCount,
             mNormalFrameCount);
     mAudioMixer = new AudioMixer(mNormalFrameCount, mSampleRate);
+    mAudioMixer->setTrackTimingInterval(kTrackMixTimingInterval);
 
     if (type == DUPLICATING) {
         // The Duplicating thread uses the AudioMixer and delivers data to OutputTracks
@@ -5296,7 +5467,8 @@ MixerThread::MixerThread(const sp<IAfThreadCallback>& afThreadCallback, AudioStr
         snprintf(fastTrack->mTraceName, sizeof(fastTrack->mTraceName),
                  "%s.0.0.%d", AUDIO_TRACE_PREFIX_AUDIO_TRACK_FRDY, mId);
         state->mFastTracksGen++;
-        state->mTrackMask = 1;
+        state->mActiveTracks.clear();
+        state->mActiveTracks.add(0);
         // fast mixer will use the HAL output sink
         state->mOutputSink = mOutputSink.get();
         state->mOutputSinkGen++;
@@ -5379,7 +5551,7 @@ MixerThread::~MixerThread()
         // We'll use that extract the final state which contains one remaining fast track
         // corresponding to our sub-mix.
         state = sq->begin();
-        ALOG_ASSERT(state->mTrackMask == 1);
+        ALOG_ASSERT(state->mActiveTracks.size() == 1 && state->mActiveTracks.contains(0));
         FastTrack *fastTrack = &state->mFastTracks[0];
         ALOG_ASSERT(fastTrack->mBufferProvider != NULL);
         delete fastTrack->mBufferProvider;
@@ -5429,7 +5601,7 @@ ssize_t MixerThread::threadLoop_write()
         FastMixerStateQueue *sq = mFastMixer->sq();
         FastMixerState *state = sq->begin();
         if (state->mCommand != FastMixerState::MIX_WRITE &&
-                (kUseFastMixer != FastMixer_Dynamic || state->mTrackMask > 1)) {
+                (kUseFastMixer != FastMixer_Dynamic || state->hasFastTracks())) {
             if (state->mCommand == FastMixerState::COLD_IDLE) {
 
                 // FIXME workaround for first HAL write being CPU bound on some devices
@@ -5563,6 +5735,7 @@ void MixerThread::threadLoop_mix()
 {
     // mix buffers...
     mAudioMixer->process();
+    mTrackMixTimesPending = mAudioMixer->trackMixTimesValid();
     mCurrentWriteLength = mSinkBufferSize;
     // increase sleep time progressively when application underrun condition clears.
     // Only increase sleep time if the mixer is ready for two consecutive times to avoid
@@ -5643,6 +5816,20 @@ PlaybackThread::mixer_state MixerThread::prepareTracks_l(
     });
     mTracks.clearDeletedTrackIds();
 
+    // account for the mix time of each track, if measured by the last mix.
+    if (mTrackMixTimesPending) {
+        mTrackMixTimesPending = false;
+        for (const auto& track : mActiveTracks) {
+            const int trackId = track->id();
+            if (mAudioMixer->exists(trackId)) {
+                const int64_t mixTimeNs = mAudioMixer->getTrackMixTimeNs(trackId);
+                if (mixTimeNs > 0) {
+                    mPhaseTimes.recordTrackMixTime(trackId, mixTimeNs);
+                }
+            }
+        }
+    }
+
     mixer_state mixerStatus = MIXER_IDLE;
     // find out which tracks need to be processed
     size_t count = mActiveTracks.size();
@@ -5744,7 +5931,7 @@ PlaybackThread::mixer_state MixerThread::prepareTracks_l(
             // is impossible because the slot isn't marked available until the end of each cycle.
             int j = track->fastIndex();
             ALOG_ASSERT(0 < j && j < (int)FastMixerState::sMaxFastTracks);
-            ALOG_ASSERT(!(mFastTrackAvailMask & (1 << j)));
+            ALOG_ASSERT(!mFastTracksAvailable.contains(j));
             FastTrack *fastTrack = &state->mFastTracks[j];
 
             // Determine whether the track is currently in underrun condition,
@@ -5854,7 +6041,7 @@ PlaybackThread::mixer_state MixerThread::prepareTracks_l(
 
             if (isActive) {
                 // was it previously inactive?
-                if (!(state->mTrackMask & (1 << j))) {
+                if (!state->mActiveTracks.contains(j)) {
                     ExtendedAudioBufferProvider *eabp = track->asExtendedAudioBufferProvider();
                     VolumeProvider *vp = track->asVolumeProvider();
                     fastTrack->mBufferProvider = eabp;
@@ -5868,7 +6055,7 @@ PlaybackThread::mixer_state MixerThread::prepareTracks_l(
                     snprintf(fastTrack->mTraceName, sizeof(fastTrack->mTraceName),
                              "%s%s", AUDIO_TRACE_PREFIX_AUDIO_TRACK_FRDY,
                              track->getTraceSuffix().c_str());
-                    state->mTrackMask |= 1 << j;
+                    state->mActiveTracks.add(j);
                     didModify = true;
                     // no acknowledgement required for newly active tracks
                 }
@@ -5940,10 +6127,10 @@ PlaybackThread::mixer_state MixerThread::prepareTracks_l(
                 ++fastTracks;
             } else {
                 // was it previously active?
-                if (state->mTrackMask & (1 << j)) {
+                if (state->mActiveTracks.contains(j)) {
                     fastTrack->mBufferProvider = NULL;
                     fastTrack->mGeneration++;
-                    state->mTrackMask &= ~(1 << j);
+                    state->mActiveTracks.remove(j);
                     didModify = true;
                     // If any fast tracks were removed, we must wait for acknowledgement
                     // because we're about to decrement the last sp<> on those tracks.
@@ -5955,8 +6142,9 @@ PlaybackThread::mixer_state MixerThread::prepareTracks_l(
                     // FastTrack state hasn't had time to update.
                     // TODO Remove the ALOGW when this theory is confirmed.
                     ALOGW("fast track %d should have been active; "
-                            "mState=%d, mTrackMask=%#x, recentUnderruns=%u, isShared=%d",
-                            j, (int)track->state(), state->mTrackMask, recentUnderruns,
+                            "mState=%d, mActiveTracks=%s, recentUnderruns=%u, isShared=%d",
+                            j, (int)track->state(), state->mActiveTracks.toString().c_str(),
+                            recentUnderruns,
                             track->sharedBuffer() != 0);
                     // Since the FastMixer state already has the track inactive, do nothing here.
                 }
@@ -6394,7 +6582,7 @@ PlaybackThread::mixer_state MixerThread::prepareTracks_l(
         state->mFastTracksGen++;
         // if the fast mixer was active, but now there are no fast tracks, then put it in cold idle
         if (kUseFastMixer == FastMixer_Dynamic &&
-                state->mCommand == FastMixerState::MIX_WRITE && state->mTrackMask <= 1) {
+                state->mCommand == FastMixerState::MIX_WRITE && !state->hasFastTracks()) {
             state->mCommand = FastMixerState::COLD_IDLE;
             state->mColdFutexAddr = &mFastMixerFutex;
             state->mColdGen++;
@@ -6605,23 +6793,31 @@ bool MixerThread::checkForNewParameter_l(const String8& keyValuePair,
     if (param.getInt(String8(AudioParameter::keyRouting), value) == NO_ERROR) {
         LOG_FATAL("Should not set routing device in MixerThread");
     }
+    // handled here, not forwarded to the HAL
+    String8 halKeyValuePair = keyValuePair;
+    if (param.getInt(String8(kParallelEffectChainsKey), value) == NO_ERROR) {
+        status = setParallelEffectChains_l(value);
+        param.remove(String8(kParallelEffectChainsKey));
+        halKeyValuePair = param.toString();
+    }
 
-    if (status == NO_ERROR) {
-        status = mOutput->stream->setParameters(keyValuePair);
+    if (status == NO_ERROR && halKeyValuePair.length() != 0) {
+        status = mOutput->stream->setParameters(halKeyValuePair);
         if (!mStandby && status == INVALID_OPERATION) {
             ALOGW("%s: setParameters failed with keyValuePair %s, entering standby",
-                    __func__, keyValuePair.c_str());
+                    __func__, halKeyValuePair.c_str());
             mOutput->standby();
             mThreadMetrics.logEndInterval();
             mThreadSnapshot.onEnd();
             setStandby_l();
             mBytesWritten = 0;
-            status = mOutput->stream->setParameters(keyValuePair);
+            status = mOutput->stream->setParameters(halKeyValuePair);
         }
         if (status == NO_ERROR && reconfig) {
             readOutputParameters_l();
             delete mAudioMixer;
             mAudioMixer = new AudioMixer(mNormalFrameCount, mSampleRate);
+            mAudioMixer->setTrackTimingInterval(kTrackMixTimingInterval);
             for (const auto &track : mTracks) {
                 const int trackId = track->id();
                 const status_t createStatus = mAudioMixer->create(
@@ -7875,6 +8071,17 @@ DuplicatingThread::DuplicatingThread(const sp<IAfThreadCallback>& afThreadCallba
                     systemReady, DUPLICATING),
         mWaitTimeMs(UINT_MAX)
 {
+    // Share the mixed output through one ring rather than copying it into each OutputTrack.
+    // The ring must hold the frames accepted but not read yet by a track, at most its
+    // frameCount, plus the period written, or the tracks copy that period. A track added
+    // later that needs more than that copies as before.
+    if (property_get_bool("af.duplicating.shared_ring", true /* default_value */)) {
+        sp<DuplicationRing> ring = sp<DuplicationRing>::make(
+                2 * outputTrackFrameCount(mainThread) + 8 * mNormalFrameCount, mFrameSize);
+        if (ring->initCheck()) {
+            mRing = std::move(ring);
+        }
+    }
     addOutputTrack(mainThread);
 }
 
@@ -7926,6 +8133,19 @@ void DuplicatingThread::threadLoop_sleepTime()
 ssize_t DuplicatingThread::threadLoop_write()
 {
     ATRACE_BEGIN("write");
+    if (mRing != nullptr && writeFrames != 0) {
+        // Written once for the OutputTracks reading from the ring, unless one of them has not
+        // released the frames it would overwrite. They then copy this period.
+        bool shared = true;
+        for (size_t i = 0; i < outputTracks.size(); i++) {
+            shared = outputTracks[i]->prepareSharedWrite(writeFrames) && shared;
+        }
+        if (shared) {
+            mRing->write(mSinkBuffer, writeFrames);
+        } else {
+            mRing->skipWrite(writeFrames);
+        }
+    }
     for (size_t i = 0; i < outputTracks.size(); i++) {
         const ssize_t actualWritten = outputTracks[i]->write(mSinkBuffer, writeFrames);
 
@@ -8002,6 +8222,12 @@ void DuplicatingThread::dumpInternals_l(int fd, const Vector<String16>& args)
         }
     }
     ss << "\n";
+    if (mRing != nullptr) {
+        ss << "  Shared ring: " << mRing->frameCount() << " frames, written "
+                << mRing->framesWritten() << ", shared " << mRing->framesShared()
+                << ", dropped " << mRing->framesDropped()
+                << ", skipped " << mRing->framesSkipped() << "\n";
+    }
     std::string result = ss.str();
     write(fd, result.c_str(), result.size());
 }
@@ -8019,11 +8245,7 @@ void DuplicatingThread::clearOutputTracks()
 void DuplicatingThread::addOutputTrack(IAfPlaybackThread* thread)
 {
     audio_utils::lock_guard _l(mutex());
-    // The downstream MixerThread consumes thread->frameCount() amount of frames per mix pass.
-    // Adjust for thread->sampleRate() to determine minimum buffer frame count.
-    // Then triple buffer because Threads do not run synchronously and may not be clock locked.
-    const size_t frameCount =
-            3 * sourceFramesNeeded(mSampleRate, thread->frameCount(), thread->sampleRate());
+    const size_t frameCount = outputTrackFrameCount(thread);
     // TODO: Consider asynchronous sample rate conversion to handle clock disparity
     // from different OutputTracks and their associated MixerThreads (e.g. one may
     // nearly empty and the other may be dropping data).
@@ -8035,13 +8257,16 @@ void DuplicatingThread::addOutputTrack(IAfPlaybackThread* thread)
     attributionSource.pid = VALUE_OR_FATAL(legacy2aidl_pid_t_int32_t(
       IPCThreadState::self()->getCallingPid()));
     attributionSource.token = sp<BBinder>::make();
+    const bool shared = mRing != nullptr
+            && frameCount + mNormalFrameCount <= mRing->frameCount();
     sp<IAfOutputTrack> outputTrack = IAfOutputTrack::create(thread,
                                             this,
                                             mSampleRate,
                                             mFormat,
                                             mChannelMask,
                                             frameCount,
-                                            attributionSource);
+                                            attributionSource,
+                                            shared ? mRing : sp<DuplicationRing>());
     status_t status = outputTrack != 0 ? outputTrack->initCheck() : (status_t) NO_MEMORY;
     if (status != NO_ERROR) {
         ALOGE("addOutputTrack() initCheck failed %d", status);
@@ -8056,6 +8281,14 @@ void DuplicatingThread::addOutputTrack(IAfPlaybackThread* thread)
     updateWaitTime_l();
 }
 
+size_t DuplicatingThread::outputTrackFrameCount(IAfPlaybackThread* thread) const
+{
+    // The downstream MixerThread consumes thread->frameCount() amount of frames per mix pass.
+    // Adjust for thread->sampleRate() to determine minimum buffer frame count.
+    // Then triple buffer because Threads do not run synchronously and may not be clock locked.
+    return 3 * sourceFramesNeeded(mSampleRate, thread->frameCount(), thread->sampleRate());
+}
+
 void DuplicatingThread::removeOutputTrack(IAfPlaybackThread* thread)
 {
     audio_utils::lock_guard _l(mutex());
@@ -8678,6 +8911,9 @@ reacquire_wakelock:
                 mStartStopCV.notify_all();
             }
 
+            // also drops the readers which stopped
+            updateSharedRecordConverters_l(activeTracks);
+
             // sleep if there are no active tracks to process
             if (activeTracks.isEmpty()) {
                 if (sleepUs == 0) {
@@ -8906,6 +9142,12 @@ reacquire_wakelock:
         }
         mRsmpInRear = audio_utils::safe_add_overflow(mRsmpInRear, (int32_t)framesRead);
 
+        // convert once for the tracks sharing a conversion
+        for (const auto& sharedConverter : mSharedRecordConverters) {
+            sharedConverter->convert({mRsmpInBuffer, mRsmpInFrames, mRsmpInFramesP2, mFrameSize,
+                    mRsmpInRear});
+        }
+
         size = activeTracks.size();
 
         // loop over each active track
@@ -8923,6 +9165,14 @@ reacquire_wakelock:
             // TODO: This code probably should be moved to RecordTrack.
             // TODO: Update the activeTrack buffer converter in case of reconfigure.
 
+            // the frames of a track sharing a conversion are already converted, just copy them
+            SharedRecordConverter* const sharedConverter = sharedRecordConverter(activeTrack->id());
+            if (sharedConverter != nullptr) {
+                // keep the track front current for getOldestFront_l()
+                activeTrack->resamplerBufferProvider()->setFront(
+                        sharedConverter->readerInputFront(activeTrack->id()));
+            }
+
             enum {
                 OVERRUN_UNKNOWN,
                 OVERRUN_TRUE,
@@ -8941,7 +9191,11 @@ reacquire_wakelock:
                 // if the record track isn't draining fast enough.
                 bool hasOverrun;
                 size_t framesIn;
-                activeTrack->resamplerBufferProvider()->sync(&framesIn, &hasOverrun);
+                if (sharedConverter != nullptr) {
+                    framesIn = sharedConverter->sync(activeTrack->id(), &hasOverrun);
+                } else {
+                    activeTrack->resamplerBufferProvider()->sync(&framesIn, &hasOverrun);
+                }
                 if (hasOverrun) {
                     overrun = OVERRUN_TRUE;
                 }
@@ -8953,7 +9207,9 @@ reacquire_wakelock:
                 // from framesIn.
                 // This isn't strictly necessary but helps limit buffer resizing in
                 // RecordBufferConverter.  TODO: remove when no longer needed.
-                if (audio_is_linear_pcm(activeTrack->format())) {
+                if (sharedConverter != nullptr) {
+                    framesOut = min(framesOut, framesIn); // already converted
+                } else if (audio_is_linear_pcm(activeTrack->format())) {
                     framesOut = min(framesOut,
                             destinationFramesPossible(
                                     framesIn, mSampleRate, activeTrack->sampleRate()));
@@ -8979,6 +9235,9 @@ reacquire_wakelock:
                         ALOGE("%s() cannot fill request, status: %d, frameCount: %zu",
                             __func__, getNextBufferStatus, buffer.frameCount);
                     }
+                } else if (sharedConverter != nullptr) {
+                    framesOut = sharedConverter->read(
+                            activeTrack->id(), activeTrack->sinkBuffer().raw, framesOut);
                 } else {
                     // process frames from the RecordThread buffer provider to the RecordTrack
                     // buffer
@@ -9667,6 +9926,12 @@ void RecordThread::dumpInternals_l(int fd, const Vector<String16>& /* args */)
 
     dprintf(fd, "  Fast capture thread: %s\n", hasFastCapture() ? "yes" : "no");
     dprintf(fd, "  Fast track available: %s\n", mFastTrackAvail ? "yes" : "no");
+    if (!mSharedRecordConverters.empty()) {
+        dprintf(fd, "  Shared conversions:\n");
+        for (const auto& sharedConverter : mSharedRecordConverters) {
+            dprintf(fd, "    %s\n", sharedConverter->toString().c_str());
+        }
+    }
 
     // Make a non-atomic copy of fast capture dump state so it won't change underneath us
     // while we are dumping it.  It may be inconsistent, but it won't mutate!
@@ -10002,6 +10267,9 @@ void RecordThread::ioConfigChanged_l(audio_io_config_event_t event, pid_t pid,
 
 void RecordThread::readInputParameters_l()
 {
+    // the shared conversions are from the previous parameters
+    clearSharedRecordConverters_l();
+
     const audio_config_base_t audioConfig = mInput->getAudioProperties();
     mSampleRate = audioConfig.sample_rate;
     mChannelMask = audioConfig.channel_mask;
@@ -10247,6 +10515,153 @@ void RecordThread::updateFronts_l(int32_t offset)
         front = audio_utils::safe_sub_overflow(front, offset);
         mTracks[i]->resamplerBufferProvider()->setFront(front);
     }
+    for (const auto& sharedConverter : mSharedRecordConverters) {
+        sharedConverter->setInputFront(
+                audio_utils::safe_sub_overflow(sharedConverter->inputFront(), offset));
+    }
+}
+
+void RecordThread::updateSharedRecordConverters_l(
+        const Vector<sp<IAfRecordTrack>>& activeTracks)
+{
+    // Tracks asking for audio history read it from their own front.
+    const auto isShareable = [](const sp<IAfRecordTrack>& track) {
+        return !track->isFastTrack() && !track->isDirect() && track->startFrames() < 0
+                && audio_is_linear_pcm(track->format());
+    };
+    const auto findTrack = [&](int id) -> sp<IAfRecordTrack> {
+        for (const auto& track : activeTracks) {
+            if (track->id() == id && isShareable(track)) return track;
+        }
+        return nullptr;
+    };
+
+    // Drop the readers no longer active, and the shared conversions no longer needed. The last
+    // reader continues on its own once it has read all the frames converted for it.
+    for (auto it = mSharedRecordConverters.begin(); it != mSharedRecordConverters.end(); ) {
+        SharedRecordConverter* const sharedConverter = it->get();
+        for (const int id : sharedConverter->readerIds()) {
+            if (findTrack(id) == nullptr) {
+                sharedConverter->removeReader(id);
+            }
+        }
+        const std::vector<int> ids = sharedConverter->readerIds();
+        if (ids.empty() || (ids.size() == 1 && sharedConverter->sync(ids[0]) == 0)) {
+            dissolveSharedRecordConverter_l(sharedConverter);
+            it = mSharedRecordConverters.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (size_t i = 0; i < activeTracks.size(); ++i) {
+        const sp<IAfRecordTrack>& track = activeTracks[i];
+        if (!isShareable(track) || sharedRecordConverter(track->id()) != nullptr) continue;
+        const auto matches = [&track](const sp<IAfRecordTrack>& other) {
+            return other->channelMask() == track->channelMask()
+                    && other->format() == track->format()
+                    && other->sampleRate() == track->sampleRate();
+        };
+
+        // Join the shared conversion of the same parameters.
+        const auto it = std::find_if(mSharedRecordConverters.begin(),
+                mSharedRecordConverters.end(), [&track](const auto& sharedConverter) {
+                    return sharedConverter->matches(
+                            track->channelMask(), track->format(), track->sampleRate());
+                });
+        if (it != mSharedRecordConverters.end()) {
+            // A track whose front is too far from the shared one keeps converting on its own.
+            (void)(*it)->addReader(track->id(), track->resamplerBufferProvider()->getFront());
+            continue;
+        }
+
+        // Or create one with the other tracks of the same parameters.
+        std::vector<sp<IAfRecordTrack>> readers{track};
+        for (size_t j = i + 1; j < activeTracks.size(); ++j) {
+            const sp<IAfRecordTrack>& other = activeTracks[j];
+            if (isShareable(other) && matches(other)
+                    && sharedRecordConverter(other->id()) == nullptr) {
+                readers.push_back(other);
+            }
+        }
+        if (readers.size() < 2) continue;
+        auto sharedConverter = std::make_unique<SharedRecordConverter>(
+                mChannelMask, mFormat, mSampleRate,
+                track->channelMask(), track->format(), track->sampleRate(), mRsmpInFrames);
+        if (!sharedConverter->initCheck()) {
+            ALOGW("%s: cannot share conversion to %#x %#x %u", __func__,
+                    track->format(), track->channelMask(), track->sampleRate());
+            continue;
+        }
+        // The track with the oldest front continues its conversion without discontinuity, the
+        // others skip the converted frames of the input they already read on their own.
+        const sp<IAfRecordTrack>& first = *std::max_element(readers.begin(), readers.end(),
+                [this](const auto& a, const auto& b) {
+                    return audio_utils::safe_sub_overflow(
+                                    mRsmpInRear, a->resamplerBufferProvider()->getFront())
+                            < audio_utils::safe_sub_overflow(
+                                    mRsmpInRear, b->resamplerBufferProvider()->getFront());
+                });
+        std::unique_ptr<RecordBufferConverter> converter = sharedConverter->exchangeConverter(
+                std::unique_ptr<RecordBufferConverter>(
+                        first->exchangeRecordBufferConverter(nullptr)));
+        first->exchangeRecordBufferConverter(converter.release());
+        sharedConverter->setInputFront(first->resamplerBufferProvider()->getFront());
+        for (const auto& reader : readers) {
+            if (!sharedConverter->addReader(
+                    reader->id(), reader->resamplerBufferProvider()->getFront())) {
+                ALOGW("%s: track %d front too far ahead to share its conversion",
+                        __func__, reader->id());
+            }
+        }
+        ALOGV("%s: %s", __func__, sharedConverter->toString().c_str());
+        mSharedRecordConverters.push_back(std::move(sharedConverter));
+    }
+}
+
+void RecordThread::dissolveSharedRecordConverter_l(SharedRecordConverter* sharedConverter)
+{
+    // Each reader still present continues on its own from the input of the converted frames
+    // it has not read, converting them again. The conversion state goes to a reader which read
+    // all of them, if any, so that one continues without discontinuity.
+    const std::vector<int> ids = sharedConverter->readerIds();
+    auto handOverTo = std::find_if(ids.begin(), ids.end(), [sharedConverter](int id) {
+        return sharedConverter->readerInputFront(id) == sharedConverter->inputFront();
+    });
+    if (handOverTo == ids.end()) {
+        handOverTo = ids.begin();
+    }
+    for (auto it = ids.begin(); it != ids.end(); ++it) {
+        for (size_t i = 0; i < mTracks.size(); ++i) {
+            const sp<IAfRecordTrack>& track = mTracks[i];
+            if (track->id() != *it) continue;
+            if (it == handOverTo) {
+                std::unique_ptr<RecordBufferConverter> converter =
+                        sharedConverter->exchangeConverter(std::unique_ptr<RecordBufferConverter>(
+                                track->exchangeRecordBufferConverter(nullptr)));
+                track->exchangeRecordBufferConverter(converter.release());
+            }
+            track->resamplerBufferProvider()->setFront(sharedConverter->readerInputFront(*it));
+        }
+    }
+}
+
+void RecordThread::clearSharedRecordConverters_l()
+{
+    for (const auto& sharedConverter : mSharedRecordConverters) {
+        dissolveSharedRecordConverter_l(sharedConverter.get());
+    }
+    mSharedRecordConverters.clear();
+}
+
+SharedRecordConverter* RecordThread::sharedRecordConverter(int trackId) const
+{
+    for (const auto& sharedConverter : mSharedRecordConverters) {
+        if (sharedConverter->hasReader(trackId)) {
+            return sharedConverter.get();
+        }
+    }
+    return nullptr;
 }
 
 void RecordThread::resizeInputBuffer_l(int32_t maxSharedAudioHistoryMs)
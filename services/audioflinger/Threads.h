@@ -19,6 +19,7 @@
 
 // ADD_BATTERY_DATA AUDIO_WATCHDOG FAST_THREAD_STATISTICS STATE_QUEUE_DUMP TEE_SINK
 #include "Configuration.h"
+#include "EffectChainWorkerPool.h"
 #include "IAfThread.h"
 #include "IAfTrack.h"
 
@@ -28,6 +29,7 @@
 #include <afutils/NBAIO_Tee.h>
 #include <audio_utils/Balance.h>
 #include <audio_utils/SimpleLog.h>
+#include <datapath/SharedRecordConverter.h>
 #include <datapath/ThreadMetrics.h>
 #include <fastpath/FastCapture.h>
 #include <fastpath/FastMixer.h>
@@ -35,6 +37,7 @@
 #include <mediautils/ThreadSnapshot.h>
 #include <psh_utils/Token.h>
 #include <timing/MonotonicFrameCounter.h>
+#include <timing/PhaseTimes.h>
 #include <utils/Log.h>
 
 namespace android {
@@ -766,6 +769,9 @@ protected:
     audio_utils::Statistics<double> mIoJitterMs GUARDED_BY(mutex()) {0.995 /* alpha */};
     audio_utils::Statistics<double> mProcessTimeMs GUARDED_BY(mutex()) {0.995 /* alpha */};
 
+                // Per phase thread loop times, written lock-free by threadLoop, read by dump().
+                audioflinger::ThreadPhaseTimes mPhaseTimes;
+
     // NO_THREAD_SAFETY_ANALYSIS  GUARDED_BY(mutex())
                 audio_utils::Statistics<double> mLatencyMs{0.995 /* alpha */};
                 audio_utils::Statistics<double> mMonopipePipeDepthStats{0.999 /* alpha */};
@@ -1338,6 +1344,40 @@ protected:
     // Size of mPostSpatializerBuffer in bytes
     size_t mPostSpatializerBufferSize GUARDED_BY(mutex());
 
+    // Parallel session effect chains (MIXER threads only, off by default).
+    //
+    // Enabled per output with the "parallel_effect_chains=<number of workers>" parameter.
+    // Session effect chains added while enabled get a private output buffer instead of
+    // accumulating directly into the effect buffer. They are then independent of each other:
+    // their effects are processed on mEffectChainWorkers and the thread loop accumulates the
+    // private outputs into the effect buffer, in chain order, before the global chains run.
+    status_t setParallelEffectChains_l(int numWorkers) REQUIRES(mutex());
+    bool hasPrivateEffectOutput(const sp<IAfEffectChain>& chain) const;
+    // Counts the chains for which hasPrivateEffectOutput() is true, when chains are added or
+    // removed.
+    void updatePrivateEffectOutputChains_l() REQUIRES(mutex());
+    // Processes the chains for which hasPrivateEffectOutput() is true and sets their entry in
+    // mPrivateEffectChainProcessed. Called with all chains locked, only if there are such
+    // chains.
+    void processPrivateEffectChains(const Vector<sp<IAfEffectChain>>& effectChains)
+            REQUIRES(ThreadBase_ThreadLoop);
+    // Processes the effects of mReadyEffectChains[n], on a worker or on the thread loop.
+    void processReadyEffectChain(size_t n);
+
+    size_t mParallelEffectChainWorkers GUARDED_BY(mutex()) = 0;
+    // Created and destroyed with mutex() held on the thread loop, which is the only other user.
+    std::unique_ptr<EffectChainWorkerPool> mEffectChainWorkers;
+    size_t mPrivateEffectOutputChains GUARDED_BY(mutex()) = 0;
+
+    // Thread loop storage for processPrivateEffectChains(), resized when the effect chains
+    // locked for a cycle are not as many as before, so that a cycle does not allocate.
+    std::vector<bool> mPrivateEffectChainProcessed;
+    std::vector<size_t> mReadyEffectChains;
+    // The chains locked for the cycle, while processPrivateEffectChains() runs.
+    const Vector<sp<IAfEffectChain>>* mProcessingEffectChains = nullptr;
+    const std::function<void(size_t)> mReadyEffectChainTask =
+            [this](size_t n) { processReadyEffectChain(n); };
+
     // suspend count, > 0 means suspended.  While suspended, the thread continues to pull from
     // tracks and mix, but doesn't write to HAL.  A2DP and SCO HAL implementations can't handle
     // concurrent use of both of them, so Audio Policy Service suspends one of the threads to
@@ -1574,8 +1614,10 @@ public:
 
 protected:
                 // accessed by both binder threads and within threadLoop(), lock on mutex needed
-     uint32_t& fastTrackAvailMask_l() final REQUIRES(mutex()) { return mFastTrackAvailMask; }
-     uint32_t mFastTrackAvailMask;  // bit i set if fast track [i] is available
+     FastTrackSet& fastTracksAvailable_l() final REQUIRES(mutex()) {
+         return mFastTracksAvailable;
+     }
+     FastTrackSet mFastTracksAvailable;  // contains i if fast track [i] is available
                 bool        mHwSupportsPause;
                 bool        mHwPaused;
                 bool        mFlushPending;
@@ -1680,6 +1722,11 @@ protected:
 
                 AudioMixer* mAudioMixer;    // normal mixer
 
+                // The AudioMixer measures the mix time of each track once every
+                // kTrackMixTimingInterval mixes, read back by the next prepareTracks_l().
+    static constexpr uint32_t kTrackMixTimingInterval = 16;
+                bool mTrackMixTimesPending GUARDED_BY(ThreadBase_ThreadLoop) = false;
+
             // Support low latency mode by default as unless explicitly indicated by the audio HAL
             // we assume the audio path is compatible with the head tracking latency requirements
             std::vector<audio_latency_mode_t> mSupportedLatencyModes = {AUDIO_LATENCY_MODE_LOW};
@@ -1928,6 +1975,8 @@ protected:
 
 private:
     bool outputsReady() REQUIRES(ThreadBase_ThreadLoop);
+    // Frame count of the OutputTrack on a downstream thread.
+    size_t outputTrackFrameCount(IAfPlaybackThread* thread) const;
 protected:
     // threadLoop snippets
     void threadLoop_mix() final REQUIRES(ThreadBase_ThreadLoop);
@@ -1949,6 +1998,9 @@ private:
     // NO_THREAD_SAFETY_ANALYSIS  GUARDED_BY(ThreadBase_ThreadLoop)
     SortedVector <sp<IAfOutputTrack>> outputTracks;
     SortedVector <sp<IAfOutputTrack>> mOutputTracks GUARDED_BY(mutex());
+    // Holds each mixed period once for all OutputTracks created with it, null if disabled.
+    // Set in the constructor only.
+    sp<DuplicationRing> mRing;
 public:
     virtual     bool        hasFastMixer() const { return false; }
                 status_t    threadloop_getHalTimestamp_l(
@@ -2167,6 +2219,15 @@ private:
     int32_t getOldestFront_l() REQUIRES(mutex());
     void updateFronts_l(int32_t offset) REQUIRES(mutex());
 
+    // Groups the active tracks converting to the same parameters on a SharedRecordConverter.
+    void updateSharedRecordConverters_l(const Vector<sp<IAfRecordTrack>>& activeTracks)
+            REQUIRES(mutex());
+    // Hands the conversion back to the readers, which continue on their own.
+    void dissolveSharedRecordConverter_l(SharedRecordConverter* sharedConverter)
+            REQUIRES(mutex());
+    void clearSharedRecordConverters_l() REQUIRES(mutex());
+    SharedRecordConverter* sharedRecordConverter(int trackId) const;
+
             AudioStreamIn                       *mInput;
             Source                              *mSource;
             SortedVector <sp<IAfRecordTrack>>    mTracks;
@@ -2185,6 +2246,10 @@ private:
             // rolling index that is never cleared
             int32_t                             mRsmpInRear;    // last filled frame + 1
 
+            // Conversions shared by active tracks with the same parameters. Only modified by
+            // the thread loop with mutex() held, so the thread loop reads it unlocked.
+            std::vector<std::unique_ptr<SharedRecordConverter>> mSharedRecordConverters;
+
             // For dumpsys
             const sp<MemoryDealer>              mReadOnlyHeap;
 
@@ -315,6 +315,8 @@ TrackBase::~TrackBase()
 // This implementation of releaseBuffer() is used by Track and RecordTrack
 void TrackBase::releaseBuffer(AudioBufferProvider::Buffer* buffer)
 {
+    // The frames are read before the server proxy releases them: for an OutputTrack, they may
+    // be in a DuplicationRing, which can be overwritten once they are released.
 #ifdef TEE_SINK
     mTee.write(buffer->raw, buffer->frameCount);
 #endif
@@ -969,15 +971,15 @@ Track::Track(
         // race with setSyncEvent(). However, if we call it, we cannot properly start
         // static fast tracks (SoundPool) immediately after stopping.
         //mAudioTrackServerProxy->framesReadyIsCalledByMultipleThreads();
-        ALOG_ASSERT(thread->fastTrackAvailMask_l() != 0);
-        const int i = __builtin_ctz(thread->fastTrackAvailMask_l());
+        ALOG_ASSERT(!thread->fastTracksAvailable_l().empty());
+        const int i = thread->fastTracksAvailable_l().lowest();
         ALOG_ASSERT(0 < i && i < (int)FastMixerState::sMaxFastTracks);
         // FIXME This is too eager.  We allocate a fast track index before the
         //       fast track becomes active.  Since fast tracks are a scarce resource,
         //       this means we are potentially denying other more important fast tracks from
         //       being created.  It would be better to allocate the index dynamically.
         mFastIndex = i;
-        thread->fastTrackAvailMask_l() &= ~(1 << i);
+        thread->fastTracksAvailable_l().remove(i);
     }
 
     populateUsageAndContentTypeFromStreamType();
@@ -2348,7 +2350,8 @@ sp<IAfOutputTrack> IAfOutputTrack::create(
         audio_format_t format,
         audio_channel_mask_t channelMask,
         size_t frameCount,
-        const AttributionSourceState& attributionSource) {
+        const AttributionSourceState& attributionSource,
+        const sp<DuplicationRing>& ring) {
     return sp<OutputTrack>::make(
             playbackThread,
             sourceThread,
@@ -2356,7 +2359,8 @@ sp<IAfOutputTrack> IAfOutputTrack::create(
             format,
             channelMask,
             frameCount,
-            attributionSource);
+            attributionSource,
+            ring);
 }
 
 OutputTrack::OutputTrack(
@@ -2366,7 +2370,8 @@ OutputTrack::OutputTrack(
             audio_format_t format,
             audio_channel_mask_t channelMask,
             size_t frameCount,
-            const AttributionSourceState& attributionSource)
+            const AttributionSourceState& attributionSource,
+            const sp<DuplicationRing>& ring)
     :
     AfPlaybackCommon(*this, *playbackThread, /* volume= */ 0.0f,
                      /* muted= */ false,
@@ -2378,7 +2383,8 @@ OutputTrack::OutputTrack(
               nullptr /* buffer */, (size_t)0 /* bufferSize */, nullptr /* sharedBuffer */,
               AUDIO_SESSION_NONE, getpid(), attributionSource, AUDIO_OUTPUT_FLAG_NONE,
               TYPE_OUTPUT),
-    mActive(false), mSourceThread(sourceThread)
+    mActive(false), mSourceThread(sourceThread),
+    mRingReader(ring != nullptr ? std::make_unique<DuplicationRing::Reader>(ring) : nullptr)
 {
     if (mCblk != NULL) {
         mOutBuffer.frameCount = 0;
@@ -2423,12 +2429,18 @@ void OutputTrack::stop()
 {
     Track::stop();
     clearBufferQueue();
+    if (mRingReader != nullptr) {
+        (void) mRingReader->dropAllPending();
+    }
     mOutBuffer.frameCount = 0;
     mActive = false;
 }
 
 ssize_t OutputTrack::write(void* data, uint32_t frames)
 {
+    if (mRingReader != nullptr) {
+        return writeShared(data, frames);
+    }
     if (!mActive && frames != 0) {
         const sp<IAfThreadBase> thread = mThread.promote();
         if (thread != nullptr && thread->inStandby()) {
@@ -2553,6 +2565,154 @@ ssize_t OutputTrack::write(void* data, uint32_t frames)
     return frames - inBuffer.frameCount;  // number of frames consumed.
 }
 
+ssize_t OutputTrack::writeShared(void* data, uint32_t frames)
+{
+    // Same as write() above, except that the frames are not copied: they are already in the
+    // DuplicationRing and are accepted at the current rear position of the control block.
+    // Frames that cannot be accepted stay pending in the ring, in place of the overflow buffers.
+    // If the ring could not be written, the frames are copied after the pending ones, and
+    // those that do not fit are dropped.
+    const bool inRing = mRingReader->ring()->writePosition() == mSharedWriteEnd;
+    const auto* copyData = static_cast<const uint8_t*>(data);
+    size_t copyFrames = inRing ? 0 : frames;
+    if (inRing) {
+        // drop the pending frames just overwritten
+        const size_t overwritten = mRingReader->dropPendingFor(0);
+        ALOGV_IF(overwritten != 0, "%s(%d): thread %d dropped %zu pending frames",
+                __func__, mId, (int)mThreadIoHandle, overwritten);
+    }
+    mSharedWriteEnd = -1;
+
+    if (!mActive && frames != 0) {
+        const sp<IAfThreadBase> thread = mThread.promote();
+        if (thread != nullptr && thread->inStandby()) {
+            // preload one silent buffer to trigger mixer on start()
+            ClientProxy::Buffer buf { .mFrameCount = mClientProxy->getStartThresholdInFrames() };
+            status_t status = mClientProxy->obtainBuffer(&buf);
+            if (status != NO_ERROR && status != NOT_ENOUGH_DATA && status != WOULD_BLOCK) {
+                ALOGE("%s(%d): could not obtain buffer on start", __func__, mId);
+                return 0;
+            }
+            if (!mRingReader->acceptSilence(mCblk->u.mStreaming.mRear, buf.mFrameCount)) {
+                buf.mFrameCount = 0;
+            }
+            mClientProxy->releaseBuffer(&buf);
+
+            (void) start();
+
+            // See write(): wait for the HAL stream to start, and leave the new frames pending
+            // so that other OutputTracks also start before they are consumed.
+            auto* const pt = thread->asIAfPlaybackThread().get();
+            if (!pt->waitForHalStart()) {
+                ALOGW("%s(%d): timeout waiting for thread to exit standby", __func__, mId);
+                stop();
+                return 0;
+            }
+            mRingReader->dropCopy(copyFrames);
+            return frames - copyFrames;
+        } else {
+            (void) start();
+        }
+    }
+
+    uint32_t waitTimeLeftMs = mSourceThread->waitTimeMs();
+    while (waitTimeLeftMs && (mRingReader->pendingFrames() > 0 || copyFrames > 0)) {
+        const size_t pendingFrames = mRingReader->pendingFrames();
+        AudioBufferProvider::Buffer outBuffer;
+        outBuffer.frameCount = pendingFrames > 0 ? pendingFrames : copyFrames;
+        nsecs_t startTime = systemTime();
+        status_t status = obtainBuffer(&outBuffer, waitTimeLeftMs);
+        if (status != NO_ERROR && status != NOT_ENOUGH_DATA) {
+            ALOGV("%s(%d): thread %d no more output buffers; status %d",
+                    __func__, mId,
+                    (int)mThreadIoHandle, status);
+            break;
+        }
+        uint32_t waitTimeMs = (uint32_t)ns2ms(systemTime() - startTime);
+        if (waitTimeLeftMs >= waitTimeMs) {
+            waitTimeLeftMs -= waitTimeMs;
+        } else {
+            waitTimeLeftMs = 0;
+        }
+        if (status == NOT_ENOUGH_DATA) {
+            deferRestartIfDisabled();
+            continue;
+        }
+
+        // The client proxy writes the rear position, read it back for the frames obtained.
+        Proxy::Buffer buf;
+        buf.mFrameCount = outBuffer.frameCount;
+        buf.mRaw = NULL;
+        const int32_t rear = mCblk->u.mStreaming.mRear;
+        if (pendingFrames > 0 ? !mRingReader->accept(rear, buf.mFrameCount)
+                : !mRingReader->acceptCopied(rear, buf.mFrameCount)) {
+            // the frames obtained are not released, they are obtained again next time.
+            ALOGV("%s(%d): thread %d ring run table full", __func__, mId, (int)mThreadIoHandle);
+            break;
+        }
+        if (pendingFrames == 0) {
+            memcpy(outBuffer.raw, copyData, buf.mFrameCount * mFrameSize);
+            copyData += buf.mFrameCount * mFrameSize;
+            copyFrames -= buf.mFrameCount;
+        }
+        mClientProxy->releaseBuffer(&buf);
+        deferRestartIfDisabled();
+    }
+
+    // Frames not in the ring are not queued.
+    mRingReader->dropCopy(copyFrames);
+    size_t dropped = copyFrames;
+
+    // As write() only queues the frames not written while the downstream thread is active,
+    // drop the pending frames otherwise.
+    if (mRingReader->pendingFrames() > 0) {
+        const sp<IAfThreadBase> thread = mThread.promote();
+        if (thread == nullptr || thread->inStandby()) {
+            dropped += mRingReader->dropAllPending();
+        }
+    }
+
+    if (frames == 0 && mRingReader->pendingFrames() == 0 && mActive) {
+        stop();
+    }
+
+    return frames - std::min<size_t>(dropped, frames);  // number of frames consumed.
+}
+
+bool OutputTrack::prepareSharedWrite(size_t frames)
+{
+    if (mRingReader == nullptr) {
+        return true;
+    }
+    // The front is only advanced once the downstream thread released the frames, including
+    // after teeing them, so frames it may still be reading are never overwritten. The ring
+    // holds twice our buffer, so this only fails when the downstream thread stalls.
+    if (!mRingReader->canWrite(
+            android_atomic_acquire_load(&mCblk->u.mStreaming.mFront), frames)) {
+        ALOGV("%s(%d): thread %d has not read frames the write would overwrite",
+                __func__, mId, (int)mThreadIoHandle);
+        return false;
+    }
+    mSharedWriteEnd = mRingReader->ring()->writePosition() + static_cast<int64_t>(frames);
+    return true;
+}
+
+status_t OutputTrack::getNextBuffer(AudioBufferProvider::Buffer* buffer)
+{
+    status_t status = Track::getNextBuffer(buffer);
+    if (mRingReader != nullptr && buffer->frameCount > 0) {
+        // The server proxy obtains frames at the front position, which it owns.
+        // Copied frames are read from the control block buffer, where they were obtained.
+        size_t frames = buffer->frameCount;
+        const void* raw = mRingReader->map(mCblk->u.mStreaming.mFront, &frames);
+        if (raw != nullptr) {
+            buffer->raw = const_cast<void*>(raw);
+        }
+        buffer->frameCount = frames;
+    }
+    return status;
+}
+
 void OutputTrack::queueBuffer(Buffer& inBuffer) {
 
     if (mBufferQueue.size() < kMaxOverFlowBuffers) {
@@ -0,0 +1,214 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "DuplicationRing"
+//#define LOG_NDEBUG 0
+
+#include "DuplicationRing.h"
+
+#include <utils/Log.h>
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace android {
+
+DuplicationRing::DuplicationRing(size_t frameCount, size_t frameSize)
+    : mFrameCount(frameCount),
+      mFrameSize(frameSize),
+      mData(frameCount == 0 || frameSize == 0 || frameCount > SIZE_MAX / frameSize
+              ? nullptr : new (std::nothrow) uint8_t[frameCount * frameSize]),
+      mSilence(new (std::nothrow) uint8_t[kSilenceFrames * frameSize]())
+{
+    ALOGE_IF(mData == nullptr || mSilence == nullptr,
+            "%s: cannot allocate %zu frames of %zu bytes", __func__, frameCount, frameSize);
+}
+
+void DuplicationRing::write(const void* data, size_t frames)
+{
+    const int64_t position = mWritePosition.load(std::memory_order_relaxed);
+    const auto* in = static_cast<const uint8_t*>(data);
+    size_t index = position % mFrameCount;
+    size_t remaining = std::min(frames, mFrameCount);
+    while (remaining > 0) {
+        const size_t part = std::min(remaining, mFrameCount - index);
+        memcpy(mData.get() + index * mFrameSize, in, part * mFrameSize);
+        in += part * mFrameSize;
+        remaining -= part;
+        index = 0;
+    }
+    mWritePosition.store(position + frames, std::memory_order_release);
+}
+
+DuplicationRing::Reader::Reader(const sp<DuplicationRing>& ring)
+    : mRing(ring), mPendingPosition(ring->writePosition())
+{
+}
+
+size_t DuplicationRing::Reader::pendingFrames() const
+{
+    return mRing->writePosition() - mPendingPosition;
+}
+
+bool DuplicationRing::Reader::append(
+        int32_t consumerPosition, size_t frames, int64_t ringStart)
+{
+    const size_t tail = mTail.load(std::memory_order_relaxed);
+    const size_t head = mHead.load(std::memory_order_acquire);
+    if (tail > head) {
+        // Extend the last run if both ranges are contiguous. The consumer cannot have read
+        // past its end yet, as these frames are only released after this returns.
+        Run& last = mRuns[(tail - 1) % kMaxRuns];
+        const uint32_t lastFrames = last.mFrames.load(std::memory_order_relaxed);
+        const bool contiguousRing = ringStart < 0
+                ? last.mRingStart == ringStart
+                : last.mRingStart >= 0 && last.mRingStart + lastFrames == ringStart;
+        if (contiguousRing
+                && static_cast<uint32_t>(last.mConsumerStart) + lastFrames
+                        == static_cast<uint32_t>(consumerPosition)
+                && lastFrames + frames <= UINT32_MAX) {
+            last.mFrames.store(lastFrames + frames, std::memory_order_release);
+            return true;
+        }
+    }
+    if (tail - head >= kMaxRuns) {
+        return false;
+    }
+    Run& run = mRuns[tail % kMaxRuns];
+    run.mConsumerStart = consumerPosition;
+    run.mRingStart = ringStart;
+    run.mFrames.store(frames, std::memory_order_relaxed);
+    mTail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool DuplicationRing::Reader::accept(int32_t consumerPosition, size_t frames)
+{
+    if (frames == 0) {
+        return true;
+    }
+    if (!append(consumerPosition, frames, mPendingPosition)) {
+        return false;
+    }
+    mPendingPosition += frames;
+    mRing->mFramesShared.fetch_add(frames, std::memory_order_relaxed);
+    return true;
+}
+
+bool DuplicationRing::Reader::acceptSilence(int32_t consumerPosition, size_t frames)
+{
+    return frames == 0 || append(consumerPosition, frames, kSilence);
+}
+
+bool DuplicationRing::Reader::acceptCopied(int32_t consumerPosition, size_t frames)
+{
+    return frames == 0 || append(consumerPosition, frames, kCopied);
+}
+
+int64_t DuplicationRing::Reader::oldestPosition(int32_t consumerFront) const
+{
+    const size_t tail = mTail.load(std::memory_order_relaxed);
+    for (size_t i = mHead.load(std::memory_order_acquire); i < tail; ++i) {
+        const Run& run = mRuns[i % kMaxRuns];
+        if (run.mRingStart < 0) {
+            continue;
+        }
+        const uint32_t frames = run.mFrames.load(std::memory_order_relaxed);
+        const uint32_t offset = static_cast<uint32_t>(consumerFront)
+                - static_cast<uint32_t>(run.mConsumerStart);
+        if (offset >= (1u << 31)) {
+            return run.mRingStart;  // not started yet
+        }
+        if (offset < frames) {
+            return run.mRingStart + offset;
+        }
+        // read already, or skipped by a flush
+    }
+    return mPendingPosition;
+}
+
+bool DuplicationRing::Reader::canWrite(int32_t consumerFront, size_t frames) const
+{
+    // The oldest position is the first pending frame if no accepted frame is left to read.
+    const int64_t oldest = oldestPosition(consumerFront);
+    return oldest == mPendingPosition
+            || oldest >= mRing->writePosition() + static_cast<int64_t>(frames)
+                    - static_cast<int64_t>(mRing->frameCount());
+}
+
+size_t DuplicationRing::Reader::dropPendingFor(size_t frames)
+{
+    const int64_t limit = mRing->writePosition() + static_cast<int64_t>(frames)
+            - static_cast<int64_t>(mRing->frameCount());
+    if (mPendingPosition >= limit) {
+        return 0;
+    }
+    const size_t dropped = std::min(limit, mRing->writePosition()) - mPendingPosition;
+    mPendingPosition += dropped;
+    mRing->mFramesDropped.fetch_add(dropped, std::memory_order_relaxed);
+    return dropped;
+}
+
+size_t DuplicationRing::Reader::dropAllPending()
+{
+    const size_t dropped = pendingFrames();
+    mPendingPosition += dropped;
+    mRing->mFramesDropped.fetch_add(dropped, std::memory_order_relaxed);
+    return dropped;
+}
+
+void DuplicationRing::Reader::dropCopy(size_t frames)
+{
+    mRing->mFramesDropped.fetch_add(frames, std::memory_order_relaxed);
+}
+
+const void* DuplicationRing::Reader::map(int32_t consumerPosition, size_t* frames)
+{
+    const size_t tail = mTail.load(std::memory_order_acquire);
+    size_t head = mHead.load(std::memory_order_relaxed);
+    for (; head < tail; ++head) {
+        const Run& run = mRuns[head % kMaxRuns];
+        const uint32_t runFrames = run.mFrames.load(std::memory_order_acquire);
+        const uint32_t offset = static_cast<uint32_t>(consumerPosition)
+                - static_cast<uint32_t>(run.mConsumerStart);
+        if (offset >= (1u << 31)) {
+            // in a gap before this run
+            *frames = std::min<size_t>(*frames, 0u - offset);
+            break;
+        }
+        if (offset >= runFrames) {
+            continue;  // fully read, or skipped by a flush
+        }
+        mHead.store(head, std::memory_order_release);
+        *frames = std::min<size_t>(*frames, runFrames - offset);
+        if (run.mRingStart == kSilence) {
+            *frames = std::min(*frames, kSilenceFrames);
+            return mRing->mSilence.get();
+        }
+        if (run.mRingStart == kCopied) {
+            return nullptr;
+        }
+        const size_t index = (run.mRingStart + offset) % mRing->mFrameCount;
+        *frames = std::min(*frames, mRing->mFrameCount - index);
+        return mRing->mData.get() + index * mRing->mFrameSize;
+    }
+    mHead.store(head, std::memory_order_release);
+    *frames = std::min(*frames, kSilenceFrames);
+    return mRing->mSilence.get();
+}
+
+} // namespace android
@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <utils/RefBase.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace android {
+
+/**
+ * DuplicationRing holds the output of a DuplicatingThread once for all of its OutputTracks.
+ *
+ * The duplicating thread appends each mixed period with write(). Every OutputTrack owns a
+ * Reader which keeps its own position in the ring: frames are "accepted" by the OutputTrack
+ * client proxy without copying them, and the downstream mixer thread reads them in place
+ * through Reader::map(). A consumer that falls behind only holds on to its read position, and
+ * the frames it has not accepted yet are dropped once they would be overwritten. Frames it
+ * accepted are never overwritten before it released them: when a write would reach them, the
+ * period is not written to the ring and each OutputTrack copies it to its own buffer instead.
+ *
+ * Positions in the ring are absolute frame counts since creation. Positions on the consumer
+ * side are the 32 bit, wrapping, frame positions of the OutputTrack control block.
+ *
+ * Threading: write(), skipWrite(), Reader::accept*(), Reader::oldestPosition(),
+ * Reader::canWrite() and Reader::drop*() are called by the duplicating thread; Reader::map()
+ * by the consumer's mixer thread.
+ */
+class DuplicationRing : public RefBase {
+public:
+    DuplicationRing(size_t frameCount, size_t frameSize);
+
+    [[nodiscard]] bool initCheck() const { return mData != nullptr; }
+    [[nodiscard]] size_t frameCount() const { return mFrameCount; }
+    [[nodiscard]] size_t frameSize() const { return mFrameSize; }
+    [[nodiscard]] int64_t writePosition() const {
+        return mWritePosition.load(std::memory_order_acquire);
+    }
+
+    // Appends frames at writePosition(). The caller must first check that no reader still
+    // references the frames that are overwritten, see Reader::canWrite().
+    void write(const void* data, size_t frames);
+    // Records a period that could not be written, as a reader still references the frames
+    // that would be overwritten.
+    void skipWrite(size_t frames) { mFramesSkipped.fetch_add(frames, std::memory_order_relaxed); }
+
+    // Frames written since creation, frames accepted by all readers (each of which an
+    // OutputTrack used to copy), pending frames dropped by readers that fell behind and
+    // frames that were not written, see skipWrite().
+    [[nodiscard]] int64_t framesWritten() const {
+        return mWritePosition.load(std::memory_order_relaxed);
+    }
+    [[nodiscard]] int64_t framesShared() const {
+        return mFramesShared.load(std::memory_order_relaxed);
+    }
+    [[nodiscard]] int64_t framesDropped() const {
+        return mFramesDropped.load(std::memory_order_relaxed);
+    }
+    [[nodiscard]] int64_t framesSkipped() const {
+        return mFramesSkipped.load(std::memory_order_relaxed);
+    }
+
+    class Reader {
+    public:
+        explicit Reader(const sp<DuplicationRing>& ring);
+
+        [[nodiscard]] const sp<DuplicationRing>& ring() const { return mRing; }
+
+        // Ring frames written but not accepted yet.
+        [[nodiscard]] size_t pendingFrames() const;
+
+        // The next "frames" pending ring frames are now at consumer positions
+        // [consumerPosition, consumerPosition + frames). Returns false if the run table is
+        // full, in which case nothing is recorded.
+        [[nodiscard]] bool accept(int32_t consumerPosition, size_t frames);
+        // Same for frames of silence that do not come from the ring.
+        [[nodiscard]] bool acceptSilence(int32_t consumerPosition, size_t frames);
+        // Same for frames the consumer holds in its own buffer, copied there when the ring
+        // could not be written.
+        [[nodiscard]] bool acceptCopied(int32_t consumerPosition, size_t frames);
+
+        // Oldest ring position still needed by this reader, given the consumer front
+        // (first position not read yet).
+        [[nodiscard]] int64_t oldestPosition(int32_t consumerFront) const;
+        // Whether "frames" more can be written to the ring without overwriting frames accepted
+        // and not released yet, given the consumer front. Pending frames can be dropped.
+        [[nodiscard]] bool canWrite(int32_t consumerFront, size_t frames) const;
+
+        // Drops pending frames so that writing "frames" more does not overwrite any of them.
+        // Returns the number of frames dropped.
+        size_t dropPendingFor(size_t frames);
+        // Drops all pending frames, accepted frames are still read.
+        size_t dropAllPending();
+        // Counts frames of a period not written to the ring, that could not be copied either.
+        void dropCopy(size_t frames);
+
+        // Returns the address of the frame at consumer position "consumerPosition" and limits
+        // *frames to the number of contiguous frames available there. Positions not covered
+        // by an accepted run read as silence. Returns nullptr for copied frames, which are read
+        // from the consumer's own buffer.
+        const void* map(int32_t consumerPosition, size_t* frames);
+
+    private:
+        struct Run {
+            int32_t mConsumerStart = 0;
+            std::atomic<uint32_t> mFrames{0};  // may grow while the run is the last one
+            int64_t mRingStart = 0;            // kSilence or kCopied if not in the ring
+        };
+        static constexpr int64_t kSilence = -1;
+        static constexpr int64_t kCopied = -2;
+        static constexpr size_t kMaxRuns = 32;
+
+        bool append(int32_t consumerPosition, size_t frames, int64_t ringStart);
+
+        const sp<DuplicationRing> mRing;
+        int64_t mPendingPosition;                 // duplicating thread
+        std::array<Run, kMaxRuns> mRuns;
+        std::atomic<size_t> mHead{0};             // first run not fully read, set by map()
+        std::atomic<size_t> mTail{0};             // one past the last run, set by accept()
+    };
+
+private:
+    // Zeroed storage returned by Reader::map() for silence.
+    static constexpr size_t kSilenceFrames = 256;
+
+    const size_t mFrameCount;
+    const size_t mFrameSize;
+    const std::unique_ptr<uint8_t[]> mData;
+    const std::unique_ptr<uint8_t[]> mSilence;
+    std::atomic<int64_t> mWritePosition{0};
+    std::atomic<int64_t> mFramesShared{0};
+    std::atomic<int64_t> mFramesDropped{0};
+    std::atomic<int64_t> mFramesSkipped{0};
+};
+
+} // namespace android
@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "SharedRecordConverter"
+//#define LOG_NDEBUG 0
+
+#include "SharedRecordConverter.h"
+
+#include <android-base/stringprintf.h>
+#include <audio_utils/safe_math.h>
+#include <media/AudioResamplerPublic.h>
+#include <media/RecordBufferConverter.h>
+#include <utils/Log.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <new>
+
+namespace android {
+
+namespace {
+
+// Output ring large enough for a full input ring converted, so that a reader which reads
+// everything available once per loop never overruns.
+size_t outputFramesP2(size_t inputFrames, uint32_t srcSampleRate, uint32_t dstSampleRate) {
+    if (srcSampleRate == 0) return 0;
+    const uint64_t frames = ((uint64_t)inputFrames * dstSampleRate + srcSampleRate - 1)
+            / srcSampleRate + 1;
+    return std::bit_ceil(static_cast<size_t>(frames));
+}
+
+} // namespace
+
+SharedRecordConverter::SharedRecordConverter(
+        audio_channel_mask_t srcChannelMask, audio_format_t srcFormat,
+        uint32_t srcSampleRate,
+        audio_channel_mask_t dstChannelMask, audio_format_t dstFormat,
+        uint32_t dstSampleRate,
+        size_t inputFrames)
+    : mDstChannelMask(dstChannelMask),
+      mDstFormat(dstFormat),
+      mSrcSampleRate(srcSampleRate),
+      mDstSampleRate(dstSampleRate),
+      mDstFrameSize(audio_channel_count_from_in_mask(dstChannelMask)
+              * audio_bytes_per_sample(dstFormat)),
+      mFramesP2(outputFramesP2(inputFrames, srcSampleRate, dstSampleRate)),
+      mConverter(std::make_unique<RecordBufferConverter>(
+              srcChannelMask, srcFormat, srcSampleRate,
+              dstChannelMask, dstFormat, dstSampleRate)),
+      mBuffer(mFramesP2 == 0 || mDstFrameSize == 0
+              ? nullptr : new (std::nothrow) uint8_t[mFramesP2 * mDstFrameSize])
+{
+    ALOGE_IF(mBuffer == nullptr, "%s: cannot allocate %zu frames of %zu bytes",
+            __func__, mFramesP2, mDstFrameSize);
+}
+
+SharedRecordConverter::~SharedRecordConverter() = default;
+
+bool SharedRecordConverter::initCheck() const
+{
+    return mBuffer != nullptr && mConverter != nullptr && mConverter->initCheck() == NO_ERROR;
+}
+
+std::unique_ptr<RecordBufferConverter> SharedRecordConverter::exchangeConverter(
+        std::unique_ptr<RecordBufferConverter> converter)
+{
+    std::swap(mConverter, converter);
+    return converter;
+}
+
+size_t SharedRecordConverter::convert(const Input& input)
+{
+    mInputProvider.mInput = input;
+    size_t converted = 0;
+    for (;;) {
+        const size_t framesIn = mInputProvider.sync();
+        const size_t rear = static_cast<uint32_t>(mRear) & (mFramesP2 - 1);
+        const size_t framesOut = std::min(
+                destinationFramesPossible(framesIn, mSrcSampleRate, mDstSampleRate),
+                mFramesP2 - rear);
+        if (framesOut == 0) break;
+        const size_t frames = mConverter->convert(
+                mBuffer.get() + rear * mDstFrameSize, &mInputProvider, framesOut);
+        if (frames == 0) break;
+        mRear = audio_utils::safe_add_overflow(mRear, static_cast<int32_t>(frames));
+        converted += frames;
+    }
+    mFramesConverted.store(framesConverted() + converted, std::memory_order_relaxed);
+    return converted;
+}
+
+bool SharedRecordConverter::addReader(int id, int32_t inputFront)
+{
+    if (hasReader(id)) {
+        return true;
+    }
+    const int64_t offset = outputFrames(
+            audio_utils::safe_sub_overflow(inputFront, mInputProvider.mFront));
+    const int64_t history = std::min<int64_t>(framesConverted(), mFramesP2);
+    if (offset < -history || offset > static_cast<int64_t>(mFramesP2)) {
+        return false;
+    }
+    mReaders.push_back({id, audio_utils::safe_add_overflow(mRear, static_cast<int32_t>(offset))});
+    return true;
+}
+
+void SharedRecordConverter::removeReader(int id)
+{
+    std::erase_if(mReaders, [id](const Reader& reader) { return reader.mId == id; });
+}
+
+std::vector<int> SharedRecordConverter::readerIds() const
+{
+    std::vector<int> ids;
+    ids.reserve(mReaders.size());
+    for (const auto& reader : mReaders) {
+        ids.push_back(reader.mId);
+    }
+    return ids;
+}
+
+size_t SharedRecordConverter::sync(int id, bool* hasOverrun)
+{
+    Reader* const reader = findReader(id);
+    LOG_ALWAYS_FATAL_IF(reader == nullptr, "%s: no reader %d", __func__, id);
+    const ssize_t filled = audio_utils::safe_sub_overflow(mRear, reader->mFront);
+    size_t frames = filled;
+    bool overrun = false;
+    if (filled < 0 && (size_t)-filled <= mFramesP2) {
+        // still skipping the frames of the input it read on its own
+        frames = 0;
+    } else if (filled < 0) {
+        // should not happen, but treat like a massive overrun and re-sync
+        frames = 0;
+        reader->mFront = mRear;
+        overrun = true;
+    } else if ((size_t)filled > mFramesP2) {
+        frames = mFramesP2;
+        reader->mFront = audio_utils::safe_sub_overflow(mRear, static_cast<int32_t>(frames));
+        overrun = true;
+    }
+    if (overrun) {
+        mOverruns.store(mOverruns.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+    }
+    if (hasOverrun != nullptr) {
+        *hasOverrun = overrun;
+    }
+    return frames;
+}
+
+int32_t SharedRecordConverter::readerInputFront(int id) const
+{
+    const Reader* const reader = findReader(id);
+    LOG_ALWAYS_FATAL_IF(reader == nullptr, "%s: no reader %d", __func__, id);
+    // Converted frames not read yet, negative while skipping, and at most the output ring.
+    const int64_t unread = std::min<int64_t>(
+            audio_utils::safe_sub_overflow(mRear, reader->mFront), mFramesP2);
+    return audio_utils::safe_sub_overflow(
+            mInputProvider.mFront, static_cast<int32_t>(inputFrames(unread)));
+}
+
+size_t SharedRecordConverter::read(int id, void* dst, size_t frames)
+{
+    frames = std::min(frames, sync(id));
+    Reader* const reader = findReader(id);
+    auto* out = static_cast<uint8_t*>(dst);
+    size_t front = static_cast<uint32_t>(reader->mFront) & (mFramesP2 - 1);
+    for (size_t remaining = frames; remaining > 0; ) {
+        const size_t part = std::min(remaining, mFramesP2 - front);
+        memcpy(out, mBuffer.get() + front * mDstFrameSize, part * mDstFrameSize);
+        out += part * mDstFrameSize;
+        remaining -= part;
+        front = 0;
+    }
+    reader->mFront = audio_utils::safe_add_overflow(reader->mFront, static_cast<int32_t>(frames));
+    mFramesRead.store(framesRead() + frames, std::memory_order_relaxed);
+    return frames;
+}
+
+std::string SharedRecordConverter::toString() const
+{
+    return base::StringPrintf("%#x %#x %u: %zu readers, %lld frames converted, %lld read,"
+            " %lld overruns", mDstFormat, mDstChannelMask, mDstSampleRate, mReaders.size(),
+            (long long)framesConverted(), (long long)framesRead(),
+            (long long)mOverruns.load(std::memory_order_relaxed));
+}
+
+SharedRecordConverter::Reader* SharedRecordConverter::findReader(int id)
+{
+    const auto it = std::find_if(mReaders.begin(), mReaders.end(),
+            [id](const Reader& reader) { return reader.mId == id; });
+    return it != mReaders.end() ? &*it : nullptr;
+}
+
+const SharedRecordConverter::Reader* SharedRecordConverter::findReader(int id) const
+{
+    return const_cast<SharedRecordConverter*>(this)->findReader(id);
+}
+
+size_t SharedRecordConverter::InputProvider::sync()
+{
+    const ssize_t filled = audio_utils::safe_sub_overflow(mInput.rear, mFront);
+    if (filled < 0) {
+        // should not happen, but re-sync
+        mFront = mInput.rear;
+        return 0;
+    }
+    if ((size_t)filled > mInput.frames) {
+        // not converted in time, skip to the oldest frame available
+        mFront = audio_utils::safe_sub_overflow(mInput.rear, static_cast<int32_t>(mInput.frames));
+        return mInput.frames;
+    }
+    return filled;
+}
+
+status_t SharedRecordConverter::InputProvider::getNextBuffer(Buffer* buffer)
+{
+    const size_t filled = sync();
+    // 'filled' may be non-contiguous, so return only the first contiguous chunk
+    const size_t front = static_cast<uint32_t>(mFront) & (mInput.framesP2 - 1);
+    const size_t frames = std::min({filled, mInput.framesP2 - front, buffer->frameCount});
+    if (frames == 0) {
+        // out of data is fine since the resampler will return a short-count.
+        buffer->raw = nullptr;
+        buffer->frameCount = 0;
+        return NOT_ENOUGH_DATA;
+    }
+    buffer->raw = const_cast<uint8_t*>(static_cast<const uint8_t*>(mInput.buffer))
+            + front * mInput.frameSize;
+    buffer->frameCount = frames;
+    return NO_ERROR;
+}
+
+void SharedRecordConverter::InputProvider::releaseBuffer(Buffer* buffer)
+{
+    mFront = audio_utils::safe_add_overflow(mFront, static_cast<int32_t>(buffer->frameCount));
+    buffer->raw = nullptr;
+    buffer->frameCount = 0;
+}
+
+} // namespace android
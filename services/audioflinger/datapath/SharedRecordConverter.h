@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <media/AudioBufferProvider.h>
+#include <system/audio.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace android {
+
+class RecordBufferConverter;
+
+/**
+ * SharedRecordConverter converts the input of a RecordThread once for all of the RecordTracks
+ * with the same destination channel mask, format and sample rate.
+ *
+ * convert() reads the RecordThread input ring from its own front, like a
+ * ResamplerBufferProvider, and appends the converted frames to an output ring. Each reader,
+ * identified by its track id, keeps its own position in the output ring and copies from it
+ * with read(). A reader which falls behind by more than the output ring overruns and skips to
+ * the oldest frame still available, as a RecordTrack does on the input ring.
+ *
+ * Readers join and leave at their own position in the input ring: a reader which read the
+ * input on its own up to a different front than the shared one starts with the conversion of
+ * the input after its front, and a reader which leaves continues on its own from the input
+ * of the frames it has not read yet.
+ *
+ * Positions are 32 bit wrapping frame counters, as mRsmpInRear.
+ *
+ * Threading: all methods are called by the RecordThread loop. The counters may be read by
+ * any thread for dumpsys.
+ */
+class SharedRecordConverter {
+public:
+    // The RecordThread input ring, mRsmpInBuffer.
+    struct Input {
+        const void* buffer = nullptr;
+        size_t frames = 0;     // frames readable behind rear
+        size_t framesP2 = 0;   // ring size, a power of 2
+        size_t frameSize = 0;
+        int32_t rear = 0;      // next frame to be written
+    };
+
+    SharedRecordConverter(
+            audio_channel_mask_t srcChannelMask, audio_format_t srcFormat,
+            uint32_t srcSampleRate,
+            audio_channel_mask_t dstChannelMask, audio_format_t dstFormat,
+            uint32_t dstSampleRate,
+            size_t inputFrames);
+    ~SharedRecordConverter();
+
+    [[nodiscard]] bool initCheck() const;
+
+    [[nodiscard]] bool matches(audio_channel_mask_t channelMask, audio_format_t format,
+            uint32_t sampleRate) const {
+        return channelMask == mDstChannelMask && format == mDstFormat
+                && sampleRate == mDstSampleRate;
+    }
+
+    // Swaps the converter with one of the same parameters, typically the one a RecordTrack
+    // used so far, to continue its conversion without discontinuity.
+    [[nodiscard]] std::unique_ptr<RecordBufferConverter> exchangeConverter(
+            std::unique_ptr<RecordBufferConverter> converter);
+
+    // Position in the input ring of the next frame to convert.
+    [[nodiscard]] int32_t inputFront() const { return mInputProvider.mFront; }
+    void setInputFront(int32_t front) { mInputProvider.mFront = front; }
+
+    // Converts all the frames available in the input ring. Returns the number of frames
+    // appended to the output ring.
+    size_t convert(const Input& input);
+
+    // Adds a reader which read the input up to "inputFront" on its own. It starts with the
+    // conversion of the input after it: the frames still in the output ring if it is behind
+    // inputFront(), or the frames converted next after skipping those of the input it already
+    // read. Returns false, and does not add it, if those frames were overwritten or the reader
+    // is too far ahead. No-op if already present.
+    [[nodiscard]] bool addReader(int id, int32_t inputFront);
+    void removeReader(int id);
+    [[nodiscard]] bool hasReader(int id) const { return findReader(id) != nullptr; }
+    [[nodiscard]] std::vector<int> readerIds() const;
+    [[nodiscard]] size_t readerCount() const { return mReaders.size(); }
+
+    // Returns the frames available to a reader, after handling an overrun.
+    [[nodiscard]] size_t sync(int id, bool* hasOverrun = nullptr);
+
+    // Position in the input ring from which a reader continues on its own: the input of the
+    // converted frames it has not read yet, or past inputFront() if it is still skipping.
+    [[nodiscard]] int32_t readerInputFront(int id) const;
+
+    // Copies up to "frames" frames available to a reader. Returns the number of frames copied.
+    size_t read(int id, void* dst, size_t frames);
+
+    [[nodiscard]] size_t dstFrameSize() const { return mDstFrameSize; }
+
+    // Frames converted, and frames read by all readers: without sharing every frame read
+    // would have been converted.
+    [[nodiscard]] int64_t framesConverted() const {
+        return mFramesConverted.load(std::memory_order_relaxed);
+    }
+    [[nodiscard]] int64_t framesRead() const {
+        return mFramesRead.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] std::string toString() const;
+
+private:
+    // Reads the input ring for the converter.
+    struct InputProvider : public AudioBufferProvider {
+        status_t getNextBuffer(Buffer* buffer) final;
+        void releaseBuffer(Buffer* buffer) final;
+
+        // Frames available, after skipping the frames overwritten in the input ring.
+        size_t sync();
+
+        Input mInput;
+        int32_t mFront = 0;
+    };
+
+    struct Reader {
+        int mId;
+        int32_t mFront;  // ahead of mRear while skipping the input it read on its own
+    };
+
+    // Converted frames for a number of input frames, and the reverse, ignoring the frames
+    // held back by the resampler.
+    [[nodiscard]] int64_t outputFrames(int64_t inputFrames) const {
+        return inputFrames * mDstSampleRate / mSrcSampleRate;
+    }
+    [[nodiscard]] int64_t inputFrames(int64_t outputFrames) const {
+        return outputFrames * mSrcSampleRate / mDstSampleRate;
+    }
+
+    [[nodiscard]] Reader* findReader(int id);
+    [[nodiscard]] const Reader* findReader(int id) const;
+
+    const audio_channel_mask_t mDstChannelMask;
+    const audio_format_t mDstFormat;
+    const uint32_t mSrcSampleRate;
+    const uint32_t mDstSampleRate;
+    const size_t mDstFrameSize;
+    const size_t mFramesP2;  // output ring size
+
+    std::unique_ptr<RecordBufferConverter> mConverter;
+    InputProvider mInputProvider;
+    const std::unique_ptr<uint8_t[]> mBuffer;
+    int32_t mRear = 0;       // next frame to be converted in the output ring
+    std::vector<Reader> mReaders;
+
+    std::atomic<int64_t> mFramesConverted{0};
+    std::atomic<int64_t> mFramesRead{0};
+    std::atomic<int64_t> mOverruns{0};
+};
+
+} // namespace android
@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "duplicationring_tests"
+
+#include "../DuplicationRing.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace android;
+
+namespace {
+
+constexpr size_t kFrameSize = sizeof(int16_t);
+
+std::vector<int16_t> ramp(int16_t first, size_t frames) {
+    std::vector<int16_t> v(frames);
+    for (size_t i = 0; i < frames; ++i) v[i] = first + i;
+    return v;
+}
+
+// Reads "frames" frames at consumer position "position" through map(), following its
+// contiguous chunks.
+std::vector<int16_t> readFrames(DuplicationRing::Reader& reader, int32_t position,
+        size_t frames) {
+    std::vector<int16_t> out;
+    while (frames > 0) {
+        size_t chunk = frames;
+        const auto* data = static_cast<const int16_t*>(reader.map(position, &chunk));
+        EXPECT_GT(chunk, 0u);
+        if (chunk == 0) break;
+        out.insert(out.end(), data, data + chunk);
+        position += chunk;
+        frames -= chunk;
+    }
+    return out;
+}
+
+TEST(DuplicationRingTest, AcceptAndMap) {
+    sp<DuplicationRing> ring = new DuplicationRing(64, kFrameSize);
+    ASSERT_TRUE(ring->initCheck());
+    DuplicationRing::Reader reader(ring);
+
+    const auto input = ramp(1, 48);
+    ring->write(input.data(), input.size());
+    EXPECT_EQ(48u, reader.pendingFrames());
+
+    // accepted in two calls at contiguous consumer positions
+    ASSERT_TRUE(reader.accept(1000, 16));
+    ASSERT_TRUE(reader.accept(1016, 32));
+    EXPECT_EQ(0u, reader.pendingFrames());
+    EXPECT_EQ(input, readFrames(reader, 1000, 48));
+    EXPECT_EQ(48, ring->framesShared());
+    EXPECT_EQ(0, ring->framesDropped());
+}
+
+TEST(DuplicationRingTest, MapIsLimitedToContiguousFrames) {
+    sp<DuplicationRing> ring = new DuplicationRing(64, kFrameSize);
+    DuplicationRing::Reader reader(ring);
+
+    const auto first = ramp(0, 48);
+    ring->write(first.data(), first.size());
+    ASSERT_TRUE(reader.accept(0, 48));
+    EXPECT_EQ(first, readFrames(reader, 0, 48));
+
+    // wraps around the end of the ring
+    const auto second = ramp(100, 32);
+    ring->write(second.data(), second.size());
+    ASSERT_TRUE(reader.accept(48, 32));
+    size_t frames = 32;
+    reader.map(48, &frames);
+    EXPECT_EQ(16u, frames);
+    EXPECT_EQ(second, readFrames(reader, 48, 32));
+}
+
+TEST(DuplicationRingTest, SilenceAndGaps) {
+    sp<DuplicationRing> ring = new DuplicationRing(64, kFrameSize);
+    DuplicationRing::Reader reader(ring);
+
+    ASSERT_TRUE(reader.acceptSilence(0, 8));
+    const auto input = ramp(1, 8);
+    ring->write(input.data(), input.size());
+    ASSERT_TRUE(reader.accept(12, 8));  // 4 frame gap at [8, 12)
+
+    std::vector<int16_t> expected(12, 0);
+    expected.insert(expected.end(), input.begin(), input.end());
+    EXPECT_EQ(expected, readFrames(reader, 0, 20));
+
+    // positions past all accepted frames read as silence
+    EXPECT_EQ(std::vector<int16_t>(4, 0), readFrames(reader, 20, 4));
+}
+
+TEST(DuplicationRingTest, ConsumerPositionWraps) {
+    sp<DuplicationRing> ring = new DuplicationRing(64, kFrameSize);
+    DuplicationRing::Reader reader(ring);
+
+    const int32_t start = INT32_MAX - 7;
+    const auto input = ramp(1, 16);
+    ring->write(input.data(), input.size());
+    ASSERT_TRUE(reader.accept(start, 8));
+    ASSERT_TRUE(reader.accept(static_cast<int32_t>(static_cast<uint32_t>(start) + 8), 8));
+    EXPECT_EQ(input, readFrames(reader, start, 16));
+}
+
+TEST(DuplicationRingTest, OldestPositionFollowsConsumer) {
+    sp<DuplicationRing> ring = new DuplicationRing(64, kFrameSize);
+    DuplicationRing::Reader reader(ring);
+
+    const auto input = ramp(0, 32);
+    ring->write(input.data(), input.size());
+    EXPECT_EQ(0, reader.oldestPosition(0));  // pending frames are still needed
+    ASSERT_TRUE(reader.accept(500, 16));
+    EXPECT_EQ(0, reader.oldestPosition(500));
+    EXPECT_EQ(10, reader.oldestPosition(510));
+    EXPECT_EQ(16, reader.oldestPosition(516));  // first pending frame
+    ASSERT_TRUE(reader.accept(516, 16));
+    EXPECT_EQ(32, reader.oldestPosition(532));
+}
+
+TEST(DuplicationRingTest, SlowReaderDropsPendingFrames) {
+    sp<DuplicationRing> ring = new DuplicationRing(64, kFrameSize);
+    DuplicationRing::Reader fast(ring);
+    DuplicationRing::Reader slow(ring);
+
+    for (int16_t i = 0; i < 6; ++i) {
+        const auto input = ramp(i * 16, 16);
+        // make room as the duplicating thread does before each write
+        EXPECT_EQ(0u, fast.dropPendingFor(16));
+        slow.dropPendingFor(16);
+        ASSERT_LE(ring->writePosition() + 16 - fast.oldestPosition(i * 16), 64);
+        ASSERT_LE(ring->writePosition() + 16 - slow.oldestPosition(0), 64);
+        ring->write(input.data(), input.size());
+        ASSERT_TRUE(fast.accept(i * 16, 16));
+        EXPECT_EQ(input, readFrames(fast, i * 16, 16));
+    }
+    EXPECT_EQ(64u, slow.pendingFrames());
+    EXPECT_EQ(32, ring->framesDropped());
+
+    // the slow reader gets the most recent frames
+    ASSERT_TRUE(slow.accept(0, 64));
+    EXPECT_EQ(ramp(32, 64), readFrames(slow, 0, 64));
+
+    EXPECT_EQ(0u, slow.dropAllPending());
+    const auto input = ramp(0, 8);
+    ring->write(input.data(), input.size());
+    EXPECT_EQ(8u, slow.dropAllPending());
+    EXPECT_EQ(0u, slow.pendingFrames());
+}
+
+TEST(DuplicationRingTest, AcceptedFramesAreNotOverwritten) {
+    sp<DuplicationRing> ring = new DuplicationRing(64, kFrameSize);
+    DuplicationRing::Reader stalled(ring);
+    DuplicationRing::Reader reader(ring);
+
+    const auto input = ramp(0, 32);
+    ring->write(input.data(), input.size());
+    ASSERT_TRUE(stalled.accept(0, 16));
+    ASSERT_TRUE(reader.accept(0, 32));
+    EXPECT_EQ(input, readFrames(reader, 0, 32));
+
+    // pending frames can be dropped, accepted frames not released yet cannot
+    EXPECT_TRUE(stalled.canWrite(0, 16));
+    EXPECT_TRUE(stalled.canWrite(0, 32));
+    EXPECT_FALSE(stalled.canWrite(0, 33));
+    EXPECT_TRUE(stalled.canWrite(8, 40));
+    EXPECT_FALSE(stalled.canWrite(8, 41));
+    EXPECT_TRUE(reader.canWrite(32, 64));
+
+    // the period is copied by the readers instead
+    ring->skipWrite(48);
+    EXPECT_EQ(48, ring->framesSkipped());
+    ASSERT_TRUE(reader.acceptCopied(32, 48));
+    size_t frames = 64;
+    EXPECT_EQ(nullptr, reader.map(32, &frames));
+    EXPECT_EQ(48u, frames);
+    stalled.dropCopy(48);
+    EXPECT_EQ(48, ring->framesDropped());
+    EXPECT_EQ(ramp(0, 16), readFrames(stalled, 0, 16));
+
+    // the copied run is followed by ring frames
+    EXPECT_TRUE(stalled.canWrite(16, 48));
+    EXPECT_TRUE(reader.canWrite(80, 48));
+    ring->write(input.data(), input.size());
+    ASSERT_TRUE(reader.accept(80, 32));
+    EXPECT_EQ(input, readFrames(reader, 80, 32));
+}
+
+TEST(DuplicationRingTest, RunTableFull) {
+    sp<DuplicationRing> ring = new DuplicationRing(256, kFrameSize);
+    DuplicationRing::Reader reader(ring);
+
+    const auto input = ramp(0, 256);
+    ring->write(input.data(), input.size());
+    // non contiguous consumer positions cannot be merged into one run
+    size_t runs = 0;
+    while (reader.accept(runs * 8, 4)) {
+        ++runs;
+    }
+    EXPECT_GT(runs, 1u);
+    const size_t pending = reader.pendingFrames();
+
+    // reading the first run frees its entry
+    EXPECT_EQ(ramp(0, 4), readFrames(reader, 0, 4));
+    EXPECT_EQ(ramp(4, 4), readFrames(reader, 8, 4));
+    EXPECT_TRUE(reader.accept(runs * 8, 4));
+    EXPECT_EQ(pending - 4, reader.pendingFrames());
+}
+
+} // namespace
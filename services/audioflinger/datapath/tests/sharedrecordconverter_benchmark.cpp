@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../SharedRecordConverter.h"
+
+#include <benchmark/benchmark.h>
+#include <media/AudioResamplerPublic.h>
+#include <media/RecordBufferConverter.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+using namespace android;
+
+namespace {
+
+// A null input: a 48 kHz stereo ring of silence, advanced by one 20 ms period per iteration,
+// converted to 16 kHz mono for every client as for hotword, assistant and VoIP clients.
+constexpr uint32_t kSrcSampleRate = 48000;
+constexpr uint32_t kDstSampleRate = 16000;
+constexpr size_t kInputFramesP2 = 4096;
+constexpr size_t kPeriodFrames = kSrcSampleRate / 50;
+constexpr size_t kFrameSize = 2 * sizeof(int16_t);
+
+// Reads the input ring from its own front, as ResamplerBufferProvider.
+class RingProvider : public AudioBufferProvider {
+public:
+    RingProvider(const std::vector<int16_t>& ring, const int32_t& rear)
+        : mRing(ring), mRear(rear) {}
+
+    status_t getNextBuffer(Buffer* buffer) override {
+        const size_t front = static_cast<uint32_t>(mFront) & (kInputFramesP2 - 1);
+        buffer->frameCount = std::min({buffer->frameCount,
+                static_cast<size_t>(mRear - mFront), kInputFramesP2 - front});
+        if (buffer->frameCount == 0) {
+            buffer->raw = nullptr;
+            return NOT_ENOUGH_DATA;
+        }
+        buffer->raw = const_cast<int16_t*>(mRing.data()) + front * 2;
+        return NO_ERROR;
+    }
+
+    void releaseBuffer(Buffer* buffer) override {
+        mFront += buffer->frameCount;
+        buffer->frameCount = 0;
+    }
+
+private:
+    const std::vector<int16_t>& mRing;
+    const int32_t& mRear;
+    int32_t mFront = 0;
+};
+
+std::unique_ptr<RecordBufferConverter> makeConverter() {
+    return std::make_unique<RecordBufferConverter>(
+            AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_16_BIT, kSrcSampleRate,
+            AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_16_BIT, kDstSampleRate);
+}
+
+// Each client converts on its own, as before sharing.
+void BM_IndividualConversion(benchmark::State& state) {
+    const size_t clients = state.range(0);
+    std::vector<int16_t> ring(kInputFramesP2 * 2);
+    int32_t rear = 0;
+    std::vector<std::unique_ptr<RecordBufferConverter>> converters;
+    std::vector<std::unique_ptr<RingProvider>> providers;
+    for (size_t i = 0; i < clients; ++i) {
+        converters.push_back(makeConverter());
+        providers.push_back(std::make_unique<RingProvider>(ring, rear));
+    }
+    std::vector<int16_t> sink(kPeriodFrames);
+
+    for (auto _ : state) {
+        rear += kPeriodFrames;
+        for (size_t i = 0; i < clients; ++i) {
+            benchmark::DoNotOptimize(converters[i]->convert(
+                    sink.data(), providers[i].get(),
+                    destinationFramesPossible(kPeriodFrames, kSrcSampleRate, kDstSampleRate)));
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * clients * kPeriodFrames);
+}
+
+// The clients share one conversion and copy from its output.
+void BM_SharedConversion(benchmark::State& state) {
+    const size_t clients = state.range(0);
+    std::vector<int16_t> ring(kInputFramesP2 * 2);
+    int32_t rear = 0;
+    SharedRecordConverter converter(AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_16_BIT,
+            kSrcSampleRate, AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_16_BIT, kDstSampleRate,
+            kInputFramesP2);
+    if (!converter.initCheck()) {
+        state.SkipWithError("cannot create converter");
+        return;
+    }
+    for (size_t i = 0; i < clients; ++i) {
+        (void)converter.addReader(i, converter.inputFront());
+    }
+    std::vector<int16_t> sink(kPeriodFrames);
+
+    for (auto _ : state) {
+        rear += kPeriodFrames;
+        converter.convert({ring.data(), kInputFramesP2, kInputFramesP2, kFrameSize, rear});
+        for (size_t i = 0; i < clients; ++i) {
+            benchmark::DoNotOptimize(converter.read(i, sink.data(), sink.size()));
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * clients * kPeriodFrames);
+}
+
+BENCHMARK(BM_IndividualConversion)->ArgName("clients")->DenseRange(1, 8);
+BENCHMARK(BM_SharedConversion)->ArgName("clients")->DenseRange(1, 8);
+
+} // namespace
+
+BENCHMARK_MAIN();
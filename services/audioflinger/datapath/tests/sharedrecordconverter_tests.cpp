@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "sharedrecordconverter_tests"
+
+#include "../SharedRecordConverter.h"
+
+#include <gtest/gtest.h>
+#include <media/RecordBufferConverter.h>
+
+#include <vector>
+
+using namespace android;
+
+namespace {
+
+constexpr uint32_t kSrcSampleRate = 48000;
+constexpr size_t kSrcChannels = 2;
+constexpr size_t kInputFrames = 4096;  // as mRsmpInFrames
+constexpr size_t kInputFramesP2 = 4096;
+constexpr size_t kPeriodFrames = 960;
+
+// A RecordThread input ring fed with a stereo ramp.
+class InputRing {
+public:
+    InputRing() : mBuffer(kInputFramesP2 * kSrcChannels) {}
+
+    void write(size_t frames) {
+        for (size_t i = 0; i < frames; ++i) {
+            const size_t index = (static_cast<uint32_t>(mRear) & (kInputFramesP2 - 1))
+                    * kSrcChannels;
+            mBuffer[index] = mBuffer[index + 1] = static_cast<int16_t>(mNext++ * 7);
+            ++mRear;
+        }
+    }
+
+    SharedRecordConverter::Input input() const {
+        return {mBuffer.data(), kInputFrames, kInputFramesP2, kSrcChannels * sizeof(int16_t),
+                mRear};
+    }
+
+private:
+    std::vector<int16_t> mBuffer;
+    int32_t mRear = 0;
+    int16_t mNext = 0;
+};
+
+SharedRecordConverter makeConverter(uint32_t dstSampleRate) {
+    return SharedRecordConverter(AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_16_BIT, kSrcSampleRate,
+            AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_16_BIT, dstSampleRate, kInputFrames);
+}
+
+std::vector<int16_t> readAll(SharedRecordConverter& converter, int id, size_t chunk) {
+    std::vector<int16_t> out;
+    std::vector<int16_t> buffer(chunk);
+    while (size_t frames = converter.read(id, buffer.data(), chunk)) {
+        out.insert(out.end(), buffer.begin(), buffer.begin() + frames);
+    }
+    return out;
+}
+
+TEST(SharedRecordConverterTest, ReadersReceiveTheSameFrames) {
+    SharedRecordConverter converter = makeConverter(16000);
+    ASSERT_TRUE(converter.initCheck());
+    ASSERT_TRUE(converter.addReader(1, converter.inputFront()));
+    ASSERT_TRUE(converter.addReader(2, converter.inputFront()));
+    EXPECT_EQ(2u, converter.readerCount());
+
+    InputRing ring;
+    std::vector<int16_t> frames1, frames2;
+    for (int cycle = 0; cycle < 50; ++cycle) {
+        ring.write(kPeriodFrames);
+        converter.convert(ring.input());
+        const auto read1 = readAll(converter, 1, 100);
+        const auto read2 = readAll(converter, 2, 37);
+        frames1.insert(frames1.end(), read1.begin(), read1.end());
+        frames2.insert(frames2.end(), read2.begin(), read2.end());
+    }
+    EXPECT_EQ(frames1, frames2);
+    // The resampler holds back a few frames.
+    EXPECT_NEAR(50. * kPeriodFrames / 3, frames1.size(), 64);
+    EXPECT_EQ(converter.framesConverted(), static_cast<int64_t>(frames1.size()));
+    EXPECT_EQ(converter.framesRead(), static_cast<int64_t>(2 * frames1.size()));
+}
+
+TEST(SharedRecordConverterTest, ReaderJoinsAtNextConvertedFrame) {
+    SharedRecordConverter converter = makeConverter(kSrcSampleRate);
+    ASSERT_TRUE(converter.initCheck());
+    ASSERT_TRUE(converter.addReader(1, converter.inputFront()));
+
+    InputRing ring;
+    ring.write(kPeriodFrames);
+    converter.convert(ring.input());
+    ASSERT_TRUE(converter.addReader(2, converter.inputFront()));
+    EXPECT_EQ(kPeriodFrames, converter.sync(1));
+    EXPECT_EQ(0u, converter.sync(2));
+
+    ring.write(kPeriodFrames);
+    converter.convert(ring.input());
+    const auto frames1 = readAll(converter, 1, kPeriodFrames);
+    const auto frames2 = readAll(converter, 2, kPeriodFrames);
+    ASSERT_EQ(2 * kPeriodFrames, frames1.size());
+    EXPECT_EQ(std::vector<int16_t>(frames1.begin() + kPeriodFrames, frames1.end()), frames2);
+
+    converter.removeReader(1);
+    EXPECT_FALSE(converter.hasReader(1));
+    EXPECT_TRUE(converter.hasReader(2));
+}
+
+TEST(SharedRecordConverterTest, ReadersJoinAtTheirInputFront) {
+    SharedRecordConverter converter = makeConverter(kSrcSampleRate);
+    ASSERT_TRUE(converter.initCheck());
+    ASSERT_TRUE(converter.addReader(1, converter.inputFront()));
+
+    InputRing ring;
+    ring.write(kPeriodFrames);
+    converter.convert(ring.input());
+    EXPECT_EQ(0, converter.readerInputFront(1));
+
+    // Behind: it reads the frames converted from its front.
+    ASSERT_TRUE(converter.addReader(2, 0));
+    EXPECT_EQ(kPeriodFrames, converter.sync(2));
+    // Ahead: it skips the frames of the input it already read.
+    ASSERT_TRUE(converter.addReader(3, 2 * kPeriodFrames));
+    EXPECT_EQ(0u, converter.sync(3));
+    EXPECT_EQ(2 * static_cast<int32_t>(kPeriodFrames), converter.readerInputFront(3));
+    // Too far behind for the frames converted so far.
+    EXPECT_FALSE(converter.addReader(4, -1));
+    EXPECT_FALSE(converter.hasReader(4));
+
+    ring.write(2 * kPeriodFrames);
+    converter.convert(ring.input());
+    const auto frames1 = readAll(converter, 1, kPeriodFrames);
+    const auto frames2 = readAll(converter, 2, kPeriodFrames);
+    const auto frames3 = readAll(converter, 3, kPeriodFrames);
+    ASSERT_EQ(3 * kPeriodFrames, frames1.size());
+    EXPECT_EQ(frames1, frames2);
+    EXPECT_EQ(std::vector<int16_t>(frames1.begin() + 2 * kPeriodFrames, frames1.end()), frames3);
+    EXPECT_EQ(converter.inputFront(), converter.readerInputFront(3));
+}
+
+TEST(SharedRecordConverterTest, SlowReaderOverruns) {
+    SharedRecordConverter converter = makeConverter(kSrcSampleRate);
+    ASSERT_TRUE(converter.initCheck());
+    ASSERT_TRUE(converter.addReader(1, converter.inputFront()));
+    ASSERT_TRUE(converter.addReader(2, converter.inputFront()));
+
+    InputRing ring;
+    bool hasOverrun = false;
+    for (int cycle = 0; cycle < 20; ++cycle) {
+        ring.write(kPeriodFrames);
+        converter.convert(ring.input());
+        (void)readAll(converter, 1, kPeriodFrames);
+        const size_t available = converter.sync(2, &hasOverrun);
+        if (hasOverrun) {
+            // Only the most recent frames are left, the output ring is at least as large as
+            // the input ring.
+            EXPECT_GE(available, kInputFrames);
+            break;
+        }
+    }
+    EXPECT_TRUE(hasOverrun);
+    EXPECT_FALSE(readAll(converter, 2, kPeriodFrames).empty());
+    EXPECT_EQ(0u, converter.sync(2, &hasOverrun));
+    EXPECT_FALSE(hasOverrun);
+}
+
+TEST(SharedRecordConverterTest, SkipsInputNotConvertedInTime) {
+    SharedRecordConverter converter = makeConverter(kSrcSampleRate);
+    ASSERT_TRUE(converter.initCheck());
+    ASSERT_TRUE(converter.addReader(1, converter.inputFront()));
+
+    InputRing ring;
+    ring.write(kInputFrames + kPeriodFrames);  // part of the input was overwritten
+    EXPECT_EQ(kInputFrames, converter.convert(ring.input()));
+    EXPECT_EQ(kInputFrames, readAll(converter, 1, kPeriodFrames).size());
+}
+
+TEST(SharedRecordConverterTest, ExchangeConverter) {
+    SharedRecordConverter converter = makeConverter(16000);
+    ASSERT_TRUE(converter.initCheck());
+    auto own = std::make_unique<RecordBufferConverter>(
+            AUDIO_CHANNEL_IN_STEREO, AUDIO_FORMAT_PCM_16_BIT, kSrcSampleRate,
+            AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_16_BIT, 16000);
+    RecordBufferConverter* const ownPointer = own.get();
+    std::unique_ptr<RecordBufferConverter> previous = converter.exchangeConverter(std::move(own));
+    ASSERT_NE(nullptr, previous);
+    EXPECT_NE(ownPointer, previous.get());
+    EXPECT_TRUE(converter.initCheck());
+    EXPECT_EQ(ownPointer, converter.exchangeConverter(std::move(previous)).get());
+}
+
+} // namespace
@@ -40,7 +40,6 @@
 #include <audio_utils/channels.h>
 #include <audio_utils/format.h>
 #include <audio_utils/mono_blend.h>
-#include <cutils/bitops.h>
 #include <media/AudioMixer.h>
 #include "FastMixer.h"
 #include <afutils/TypedLogger.h>
@@ -204,7 +203,7 @@ void FastMixer::onStateChange()
 
     // handle state change here, but since we want to diff the state,
     // we're prepared for previous == &sInitial the first time through
-    unsigned previousTrackMask;
+    const FastTrackSet* previousTracks;
 
     // check for change in output HAL configuration
     const NBAIO_Format previousFormat = mFormat;
@@ -278,7 +277,7 @@ void FastMixer::onStateChange()
         }
         mMixerBufferState = UNDEFINED;
         // we need to reconfigure all active tracks
-        previousTrackMask = 0;
+        previousTracks = &sInitial.mActiveTracks;
         mFastTracksGen = current->mFastTracksGen - 1;
         dumpState->mFrameCount = frameCount;
 #ifdef TEE_SINK
@@ -286,39 +285,29 @@ void FastMixer::onStateChange()
         mTee.setId(std::string("_") + std::to_string(mThreadIoHandle) + "_F");
 #endif
     } else {
-        previousTrackMask = previous->mTrackMask;
+        previousTracks = &previous->mActiveTracks;
     }
 
     // check for change in active track set
-    const unsigned currentTrackMask = current->mTrackMask;
-    dumpState->mTrackMask = currentTrackMask;
-    dumpState->mNumTracks = popcount(currentTrackMask);
+    const FastTrackSet& currentTracks = current->mActiveTracks;
+    dumpState->mActiveTracks = currentTracks;
+    dumpState->mNumTracks = currentTracks.size();
     if (current->mFastTracksGen != mFastTracksGen) {
+        // The active sets are visited rather than all slots, so this is proportional to the
+        // number of active tracks and not to the capacity.
 
         // process removed tracks first to avoid running out of track names
-        unsigned removedTracks = previousTrackMask & ~currentTrackMask;
-        while (removedTracks != 0) {
-            const int i = __builtin_ctz(removedTracks);
-            removedTracks &= ~(1 << i);
-            updateMixerTrack(i, REASON_REMOVE);
-            // don't reset track dump state, since other side is ignoring it
-        }
-
-        // now process added tracks
-        unsigned addedTracks = currentTrackMask & ~previousTrackMask;
-        while (addedTracks != 0) {
-            const int i = __builtin_ctz(addedTracks);
-            addedTracks &= ~(1 << i);
-            updateMixerTrack(i, REASON_ADD);
+        for (const unsigned i : *previousTracks) {
+            if (!currentTracks.contains(i)) {
+                updateMixerTrack(i, REASON_REMOVE);
+                // don't reset track dump state, since other side is ignoring it
+            }
         }
 
-        // finally process (potentially) modified tracks; these use the same slot
+        // now process added tracks, then (potentially) modified tracks; these use the same slot
         // but may have a different buffer provider or volume provider
-        unsigned modifiedTracks = currentTrackMask & previousTrackMask;
-        while (modifiedTracks != 0) {
-            const int i = __builtin_ctz(modifiedTracks);
-            modifiedTracks &= ~(1 << i);
-            updateMixerTrack(i, REASON_MODIFY);
+        for (const unsigned i : currentTracks) {
+            updateMixerTrack(i, previousTracks->contains(i) ? REASON_MODIFY : REASON_ADD);
         }
 
         mFastTracksGen = current->mFastTracksGen;
@@ -358,11 +347,8 @@ void FastMixer::onWork()
         // so we keep a side copy of enabledTracks
         bool anyEnabledTracks = false;
 
-        // for each track, update volume and check for underrun
-        unsigned currentTrackMask = current->mTrackMask;
-        while (currentTrackMask != 0) {
-            const int i = __builtin_ctz(currentTrackMask);
-            currentTrackMask &= ~(1 << i);
+        // for each active track, update volume and check for underrun
+        for (const unsigned i : current->mActiveTracks) {
             const FastTrack* fastTrack = &current->mFastTracks[i];
 
             const int64_t trackFramesWrittenButNotPresented =
@@ -158,12 +158,12 @@ void FastMixerDumpState::dump(int fd) const
     // then we might display an obsolete track or omit an active track.
     // Instead we always display all tracks, with an indication
     // of whether we think the track is active.
-    uint32_t trackMask = mTrackMask;
-    dprintf(fd, "  Fast tracks: sMaxFastTracks=%u activeMask=%#x\n",
-            FastMixerState::sMaxFastTracks, trackMask);
+    const FastTrackSet activeTracks = mActiveTracks;
+    dprintf(fd, "  Fast tracks: sMaxFastTracks=%u activeMask=%s\n",
+            FastMixerState::sMaxFastTracks, activeTracks.toString().c_str());
     dprintf(fd, "  Index Active Full Partial Empty  Recent Ready    Written\n");
-    for (uint32_t i = 0; i < FastMixerState::sMaxFastTracks; ++i, trackMask >>= 1) {
-        const bool isActive = trackMask & 1;
+    for (uint32_t i = 0; i < FastMixerState::sMaxFastTracks; ++i) {
+        const bool isActive = activeTracks.contains(i);
         const FastTrackDump *ftDump = &mTracks[i];
         const FastTrackUnderruns& underruns = ftDump->mUnderruns;
         const char *mostRecent;
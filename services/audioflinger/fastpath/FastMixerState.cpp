@@ -17,6 +17,7 @@
 #define LOG_TAG "FastMixerState"
 //#define LOG_NDEBUG 0
 
+#include <android-base/stringprintf.h>
 #include <cutils/properties.h>
 #include "FastMixerState.h"
 
@@ -65,4 +66,62 @@ void FastMixerState::sMaxFastTracksInit()
     ALOGI("sMaxFastTracks = %u", sMaxFastTracks);
 }
 
+// static
+FastTrackSet FastTrackSet::range(unsigned first, unsigned last)
+{
+    FastTrackSet set;
+    for (unsigned i = first; i < last && i < kCapacity; ++i) {
+        set.add(i);
+    }
+    return set;
+}
+
+void FastTrackSet::add(unsigned index)
+{
+    if (index >= kCapacity || contains(index)) {
+        return;
+    }
+    mMask[index / 64] |= uint64_t{1} << (index % 64);
+    mPositions[index] = mCount;
+    mIndices[mCount++] = index;
+}
+
+void FastTrackSet::remove(unsigned index)
+{
+    if (!contains(index)) {
+        return;
+    }
+    mMask[index / 64] &= ~(uint64_t{1} << (index % 64));
+    // move the last index into the hole
+    const unsigned position = mPositions[index];
+    const unsigned last = mIndices[--mCount];
+    mIndices[position] = last;
+    mPositions[last] = position;
+}
+
+int FastTrackSet::lowest() const
+{
+    for (unsigned word = 0; word < kWords; ++word) {
+        if (mMask[word] != 0) {
+            return word * 64 + __builtin_ctzll(mMask[word]);
+        }
+    }
+    return -1;
+}
+
+std::string FastTrackSet::toString() const
+{
+    std::string result;
+    for (unsigned word = kWords; word-- > 0; ) {
+        if (result.empty()) {
+            if (mMask[word] != 0 || word == 0) {
+                result = base::StringPrintf("%#llx", (unsigned long long)mMask[word]);
+            }
+        } else {
+            base::StringAppendF(&result, "%016llx", (unsigned long long)mMask[word]);
+        }
+    }
+    return result;
+}
+
 }   // namespace android
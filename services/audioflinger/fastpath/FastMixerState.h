@@ -17,6 +17,8 @@
 #pragma once
 
 #include <math.h>
+#include <array>
+#include <string>
 #include <type_traits>
 
 #include <audio_utils/minifloat.h>
@@ -62,13 +64,55 @@ struct FastTrack {
 // No virtuals.
 static_assert(!std::is_polymorphic_v<FastTrack>);
 
+// A set of fast track indices, kept both as a bit mask for membership tests and as a compact
+// list so that the fast mixer only visits the active tracks.
+// It is trivially copyable, as required by the StateQueue.
+class FastTrackSet {
+public:
+    static constexpr unsigned kCapacity = 128;
+
+    // Returns the set of indices in [first, last).
+    static FastTrackSet range(unsigned first, unsigned last);
+
+    [[nodiscard]] bool contains(unsigned index) const {
+        return index < kCapacity && (mMask[index / 64] >> (index % 64)) & 1;
+    }
+    // Adding an index already in the set, or removing one not in the set, does nothing.
+    void add(unsigned index);
+    void remove(unsigned index);
+    void clear() { *this = FastTrackSet(); }
+
+    [[nodiscard]] unsigned size() const { return mCount; }
+    [[nodiscard]] bool empty() const { return mCount == 0; }
+    // Returns the lowest index in the set, or -1 if empty.
+    [[nodiscard]] int lowest() const;
+
+    // The indices, in no particular order. add() and remove() invalidate iterators.
+    [[nodiscard]] const uint8_t* begin() const { return mIndices.data(); }
+    [[nodiscard]] const uint8_t* end() const { return mIndices.data() + mCount; }
+
+    // Returns the bit mask in hexadecimal, e.g. "0x1e".
+    [[nodiscard]] std::string toString() const;
+
+private:
+    static constexpr unsigned kWords = (kCapacity + 63) / 64;
+
+    std::array<uint64_t, kWords> mMask{};
+    std::array<uint8_t, kCapacity> mIndices{};    // the first mCount are in the set
+    std::array<uint8_t, kCapacity> mPositions{};  // position in mIndices of each index in the set
+    unsigned mCount = 0;
+};
+
+static_assert(std::is_trivially_copyable_v<FastTrackSet>);
+static_assert(FastTrackSet::kCapacity <= 256);  // indices are stored as uint8_t
+
 // Represents a single state of the fast mixer
 struct FastMixerState : FastThreadState {
     FastMixerState();
 
     // These are the minimum, maximum, and default values for maximum number of fast tracks
     static constexpr unsigned kMinFastTracks = 2;
-    static constexpr unsigned kMaxFastTracks = 32;
+    static constexpr unsigned kMaxFastTracks = FastTrackSet::kCapacity;
     static constexpr unsigned kDefaultFastTracks = 8;
 
     static unsigned sMaxFastTracks;             // Configured maximum number of fast tracks
@@ -78,7 +122,7 @@ struct FastMixerState : FastThreadState {
     FastTrack   mFastTracks[kMaxFastTracks];
     int         mFastTracksGen = 0; // increment when any
                                     // mFastTracks[i].mGeneration is incremented
-    unsigned    mTrackMask = 0;     // bit i is set if and only if mFastTracks[i] is active
+    FastTrackSet mActiveTracks;     // contains i if and only if mFastTracks[i] is active
     NBAIO_Sink* mOutputSink = nullptr; // HAL output device, must already be negotiated
     int         mOutputSinkGen = 0; // increment when mOutputSink is assigned
     size_t      mFrameCount = 0;    // number of frames per fast mix buffer
@@ -99,6 +143,11 @@ struct FastMixerState : FastThreadState {
     // initialize sMaxFastTracks
     static void sMaxFastTracksInit();
 
+    // Whether any track other than the normal mixer's submix at index 0 is active.
+    [[nodiscard]] bool hasFastTracks() const {
+        return mActiveTracks.size() > (mActiveTracks.contains(0) ? 1u : 0u);
+    }
+
 };  // struct FastMixerState
 
 // No virtuals.
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fastmixer_test_utils.h"
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+
+using namespace android;
+
+namespace {
+
+// Runs a FastMixer with state.range(0) active fast tracks for a second per iteration and reports
+// the thread CPU time of its cycles.
+void BM_FastMixerCycle(benchmark::State& state) {
+    const size_t tracks = state.range(0);
+    CycleStats stats;
+    for (auto _ : state) {
+        stats = runFastMixer(tracks, std::chrono::milliseconds(1000));
+    }
+    if (stats.cycles == 0 || stats.tracksMixed != tracks) {
+        state.SkipWithError("the fast mixer did not mix all tracks");
+        return;
+    }
+    // The work of a cycle must fit in its period, with room to spare.
+    const double budgetUs = kFrameCount * 1e6 / kSampleRate / 2;
+    state.counters["cycles"] = stats.cycles;
+    state.counters["mean_load_us"] = stats.meanLoadUs;
+    state.counters["max_load_us"] = stats.maxLoadUs;
+    state.counters["budget_us"] = budgetUs;
+    if (stats.meanLoadUs >= budgetUs) {
+        state.SkipWithError("mean cycle load over half the period");
+    }
+}
+
+BENCHMARK(BM_FastMixerCycle)->ArgName("tracks")->Arg(8)->Arg(32)->Arg(64)->Iterations(1)
+        ->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <fastpath/FastMixer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace android {
+
+// Mixer configuration of the cycle test and benchmark.
+constexpr uint32_t kSampleRate = 48000;
+constexpr size_t kFrameCount = 192;  // 4 ms
+constexpr uint32_t kChannelCount = 2;
+
+// Stands in for the HAL: write() discards the data and blocks until the next period.
+class NullHalSink : public NBAIO_Sink {
+public:
+    NullHalSink()
+        : NBAIO_Sink(Format_from_SR_C(kSampleRate, kChannelCount, AUDIO_FORMAT_PCM_16_BIT)) {
+        mNegotiated = true;
+    }
+
+    ssize_t write(const void* /* buffer */, size_t count) override {
+        const auto now = std::chrono::steady_clock::now();
+        if (mNextWrite < now) {
+            mNextWrite = now;
+        }
+        std::this_thread::sleep_until(mNextWrite);
+        mNextWrite += std::chrono::microseconds(kFrameCount * 1'000'000 / kSampleRate);
+        mFramesWritten += count;
+        return count;
+    }
+
+private:
+    std::chrono::steady_clock::time_point mNextWrite;
+};
+
+// A fast track that is never short of data.
+class ToneProvider : public ExtendedAudioBufferProvider {
+public:
+    ToneProvider() : mData(kFrameCount * kChannelCount) {
+        for (size_t i = 0; i < mData.size(); ++i) {
+            mData[i] = static_cast<int16_t>(i % 64 * 256 - 8192);
+        }
+    }
+
+    status_t getNextBuffer(Buffer* buffer) override {
+        buffer->frameCount = std::min(buffer->frameCount, kFrameCount);
+        buffer->i16 = mData.data();
+        return OK;
+    }
+    void releaseBuffer(Buffer* buffer) override {
+        mFramesReleased += buffer->frameCount;
+        buffer->raw = nullptr;
+        buffer->frameCount = 0;
+    }
+    size_t framesReady() const override { return kFrameCount * 4; }
+    int64_t framesReleased() const override { return mFramesReleased; }
+
+private:
+    std::vector<int16_t> mData;
+    int64_t mFramesReleased = 0;  // fast mixer thread only
+};
+
+struct CycleStats {
+    size_t tracksMixed = 0;   // tracks that had frames released
+    size_t dumpedTracks = 0;  // tracks reported by the dump state
+    size_t cycles = 0;
+    double meanLoadUs = 0.;   // thread CPU time per cycle
+    double maxLoadUs = 0.;
+};
+
+// Runs a FastMixer with "tracks" active fast tracks and returns the statistics of its cycles.
+inline CycleStats runFastMixer(size_t tracks, std::chrono::milliseconds duration) {
+    const auto sink = sp<NullHalSink>::make();
+    std::vector<ToneProvider> providers(tracks);
+    // large because of the statistics arrays
+    auto dumpState = std::make_unique<FastMixerDumpState>();
+    dumpState->increaseSamplingN(FastThreadDumpState::kSamplingNforLowRamDevice);
+
+    const auto fastMixer = sp<FastMixer>::make(AUDIO_IO_HANDLE_NONE);
+    FastMixerStateQueue* const sq = fastMixer->sq();
+    FastMixerState* state = sq->begin();
+    for (size_t i = 0; i < tracks; ++i) {
+        const unsigned index = i + 1;  // as in MixerThread, 0 is the normal mixer's submix
+        FastTrack* const fastTrack = &state->mFastTracks[index];
+        fastTrack->mBufferProvider = &providers[i];
+        fastTrack->mChannelMask = AUDIO_CHANNEL_OUT_STEREO;
+        fastTrack->mFormat = AUDIO_FORMAT_PCM_16_BIT;
+        fastTrack->mGeneration++;
+        state->mActiveTracks.add(index);
+    }
+    state->mFastTracksGen++;
+    state->mOutputSink = sink.get();
+    state->mOutputSinkGen++;
+    state->mFrameCount = kFrameCount;
+    state->mSinkChannelMask = AUDIO_CHANNEL_NONE;
+    state->mCommand = FastMixerState::MIX_WRITE;
+    state->mDumpState = dumpState.get();
+    sq->end();
+    sq->push(FastMixerStateQueue::BLOCK_UNTIL_PUSHED);
+    fastMixer->run("FastMixerTest", PRIORITY_URGENT_AUDIO);
+
+    std::this_thread::sleep_for(duration);
+
+    state = sq->begin();
+    state->mCommand = FastMixerState::EXIT;
+    sq->end();
+    sq->push(FastMixerStateQueue::BLOCK_UNTIL_PUSHED);
+    fastMixer->join();
+
+    CycleStats stats;
+    stats.tracksMixed = std::count_if(providers.begin(), providers.end(),
+            [](const ToneProvider& provider) { return provider.framesReleased() > 0; });
+    stats.dumpedTracks = dumpState->mNumTracks;
+
+    // valid samples are in [oldest, newest) modulo mSamplingN, see FastThreadDumpState
+    const uint32_t bounds = dumpState->mBounds;
+    const uint32_t newest = bounds & 0xFFFF;
+    uint32_t oldest = bounds >> 16;
+    for (; oldest != newest; oldest = (oldest + 1) & 0xFFFF) {
+        const double loadUs =
+                dumpState->mLoadNs[oldest & (dumpState->mSamplingN - 1)] * 1e-3;
+        stats.meanLoadUs += loadUs;
+        stats.maxLoadUs = std::max(stats.maxLoadUs, loadUs);
+        ++stats.cycles;
+    }
+    if (stats.cycles > 0) {
+        stats.meanLoadUs /= stats.cycles;
+    }
+    return stats;
+}
+
+} // namespace android
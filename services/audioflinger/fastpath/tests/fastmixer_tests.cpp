@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "fastmixer_tests"
+
+#include "fastmixer_test_utils.h"
+
+#include <gtest/gtest.h>
+#include <utils/Log.h>
+
+#include <chrono>
+#include <set>
+
+namespace android {
+namespace {
+
+TEST(FastTrackSetTest, AddRemove) {
+    FastTrackSet set;
+    EXPECT_TRUE(set.empty());
+    EXPECT_EQ(-1, set.lowest());
+    EXPECT_EQ("0", set.toString());
+
+    for (const unsigned i : {5u, 64u, 127u, 0u, 64u /* again */}) {
+        set.add(i);
+    }
+    EXPECT_EQ(4u, set.size());
+    EXPECT_TRUE(set.contains(64));
+    EXPECT_FALSE(set.contains(63));
+    EXPECT_FALSE(set.contains(FastTrackSet::kCapacity));
+    EXPECT_EQ(0, set.lowest());
+    EXPECT_EQ("0x80000000000000010000000000000021", set.toString());
+
+    set.remove(0);
+    set.remove(0);  // not in the set
+    set.remove(64);
+    EXPECT_EQ(5, set.lowest());
+    EXPECT_EQ(std::set<unsigned>({5, 127}), std::set<unsigned>(set.begin(), set.end()));
+
+    set.clear();
+    EXPECT_TRUE(set.empty());
+    EXPECT_EQ(set.begin(), set.end());
+}
+
+TEST(FastTrackSetTest, IndicesMatchMask) {
+    FastTrackSet set = FastTrackSet::range(1, FastTrackSet::kCapacity);
+    EXPECT_EQ(FastTrackSet::kCapacity - 1, set.size());
+    EXPECT_EQ(1, set.lowest());
+
+    std::set<unsigned> expected;
+    for (unsigned i = 1; i < FastTrackSet::kCapacity; ++i) expected.insert(i);
+    // remove in an order that moves indices around the compact list
+    for (unsigned i = 1; i < FastTrackSet::kCapacity; i += 3) {
+        set.remove(i);
+        expected.erase(i);
+        ASSERT_EQ(expected, std::set<unsigned>(set.begin(), set.end()));
+    }
+    for (unsigned i = 0; i < FastTrackSet::kCapacity; ++i) {
+        EXPECT_EQ(expected.count(i) != 0, set.contains(i)) << i;
+    }
+}
+
+class FastMixerCycleTest : public ::testing::TestWithParam<size_t> {};
+
+TEST_P(FastMixerCycleTest, CycleTime) {
+    const size_t tracks = GetParam();
+    ASSERT_LT(tracks, FastMixerState::kMaxFastTracks);
+
+    const CycleStats stats = runFastMixer(tracks, std::chrono::milliseconds(1000));
+    EXPECT_EQ(tracks, stats.tracksMixed) << "not all tracks were mixed";
+    EXPECT_EQ(tracks, stats.dumpedTracks);
+    ASSERT_GT(stats.cycles, 0u) << "the fast mixer never warmed up";
+    // The load is only recorded, fastmixer_benchmark checks it fits in the period.
+    RecordProperty("meanLoadUs", std::to_string(stats.meanLoadUs));
+    RecordProperty("maxLoadUs", std::to_string(stats.maxLoadUs));
+}
+
+INSTANTIATE_TEST_SUITE_P(Tracks, FastMixerCycleTest, ::testing::Values(8, 32, 64));
+
+} // namespace
+} // namespace android
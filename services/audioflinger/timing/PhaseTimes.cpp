@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "PhaseTimes"
+
+#include "PhaseTimes.h"
+
+#include <android-base/stringprintf.h>
+#include <utils/Log.h>
+
+#include <algorithm>
+#include <bit>
+
+namespace android::audioflinger {
+
+using base::StringAppendF;
+
+// static
+size_t LatencyHistogram::bucketOf(int64_t durationNs) {
+    const uint64_t us = durationNs > 0 ? static_cast<uint64_t>(durationNs) / 1000 : 0;
+    // us == 0 is bucket 0, [2^(i-1), 2^i) is bucket i.
+    return std::min<size_t>(std::bit_width(us), kBuckets - 1);
+}
+
+void LatencyHistogram::add(int64_t durationNs) {
+    // Single writer, plain load and store are enough.
+    auto increment = [](std::atomic<int64_t>& value, int64_t delta) {
+        value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    };
+    increment(mCounts[bucketOf(durationNs)], 1);
+    increment(mCount, 1);
+    increment(mTotalNs, durationNs);
+    if (durationNs > mMaxNs.load(std::memory_order_relaxed)) {
+        mMaxNs.store(durationNs, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::reset() {
+    for (auto& count : mCounts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    mCount.store(0, std::memory_order_relaxed);
+    mTotalNs.store(0, std::memory_order_relaxed);
+    mMaxNs.store(0, std::memory_order_relaxed);
+}
+
+int64_t LatencyHistogram::percentileNs(double percentile) const {
+    std::array<int64_t, kBuckets> counts;
+    int64_t total = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        counts[i] = bucketCount(i);
+        total += counts[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    const auto rank = static_cast<int64_t>(
+            std::clamp(percentile, 0., 100.) * static_cast<double>(total) / 100.);
+    int64_t seen = 0;
+    size_t bucket = 0;
+    for (; bucket < kBuckets - 1; ++bucket) {
+        seen += counts[bucket];
+        if (seen > rank) break;
+    }
+    const int64_t upperNs = (int64_t{1} << bucket) * 1000;
+    return std::min(upperNs, maxNs());
+}
+
+std::string LatencyHistogram::toString() const {
+    const int64_t n = count();
+    if (n == 0) {
+        return "n=0";
+    }
+    return base::StringPrintf("n=%lld mean=%.1f p50=%lld p90=%lld p99=%lld max=%lld",
+            (long long)n, totalNs() * 1e-3 / n,
+            (long long)(percentileNs(50) / 1000), (long long)(percentileNs(90) / 1000),
+            (long long)(percentileNs(99) / 1000), (long long)(maxNs() / 1000));
+}
+
+// static
+const char* ThreadPhaseTimes::toString(Phase phase) {
+    switch (phase) {
+        case PHASE_PREPARE: return "prepare";
+        case PHASE_MIX: return "mix";
+        case PHASE_EFFECTS: return "effects";
+        case PHASE_WRITE: return "write";
+        case PHASE_COUNT: break;
+    }
+    return "unknown";
+}
+
+void ThreadPhaseTimes::recordCycle(const Cycle& cycle) {
+    for (size_t i = 0; i < PHASE_COUNT; ++i) {
+        if (cycle.phaseNs[i] > 0) {
+            mPhaseTimes[i].add(cycle.phaseNs[i]);
+        }
+    }
+    mCycleTimes.add(cycle.totalNs);
+
+    const int64_t budgetNs = mBudgetNs.load(std::memory_order_relaxed);
+    if (budgetNs <= 0 || cycle.totalNs - cycle.phaseNs[PHASE_WRITE] <= budgetNs) {
+        return;
+    }
+    const int64_t overBudget = mCyclesOverBudget.load(std::memory_order_relaxed);
+    mCyclesOverBudget.store(overBudget + 1, std::memory_order_relaxed);
+
+    CycleSlot& slot = mRecentOverBudget[overBudget % kRecentCycles];
+    const uint32_t sequence = slot.mSequence.load(std::memory_order_relaxed);
+    slot.mSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.mStartNs.store(cycle.startNs, std::memory_order_relaxed);
+    for (size_t i = 0; i < PHASE_COUNT; ++i) {
+        slot.mPhaseNs[i].store(cycle.phaseNs[i], std::memory_order_relaxed);
+    }
+    slot.mTotalNs.store(cycle.totalNs, std::memory_order_relaxed);
+    slot.mSequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool ThreadPhaseTimes::readCycle(const CycleSlot& slot, Cycle* cycle) const {
+    const uint32_t sequence = slot.mSequence.load(std::memory_order_acquire);
+    if (sequence == 0 || (sequence & 1) != 0) {
+        return false;  // never written or being written
+    }
+    cycle->startNs = slot.mStartNs.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < PHASE_COUNT; ++i) {
+        cycle->phaseNs[i] = slot.mPhaseNs[i].load(std::memory_order_relaxed);
+    }
+    cycle->totalNs = slot.mTotalNs.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.mSequence.load(std::memory_order_relaxed) == sequence;
+}
+
+void ThreadPhaseTimes::recordTrackMixTime(int trackId, int64_t mixTimeNs) {
+    const int64_t cycle = mCycleTimes.count();
+    TrackSlot* found = nullptr;
+    TrackSlot* oldest = nullptr;
+    for (auto& slot : mTracks) {
+        const int id = slot.mTrackId.load(std::memory_order_relaxed);
+        if (id == trackId) {
+            found = &slot;
+            break;
+        }
+        if (oldest == nullptr || id == 0
+                || (oldest->mTrackId.load(std::memory_order_relaxed) != 0
+                        && slot.mLastCycle < oldest->mLastCycle)) {
+            oldest = &slot;
+        }
+    }
+    if (found == nullptr) {
+        // Reuse a free slot, or the one of the track not mixed for the longest time.
+        found = oldest;
+        found->mMixTimes.reset();
+        found->mTrackId.store(trackId, std::memory_order_relaxed);
+    }
+    found->mLastCycle = cycle;
+    found->mMixTimes.add(mixTimeNs);
+}
+
+std::string ThreadPhaseTimes::toMetricsString() const {
+    std::string result;
+    auto append = [&result](const char* name, const LatencyHistogram& histogram) {
+        if (!result.empty()) result.append("|");
+        StringAppendF(&result, "%s:%lld/%lld/%lld", name,
+                (long long)(histogram.percentileNs(50) / 1000),
+                (long long)(histogram.percentileNs(99) / 1000),
+                (long long)(histogram.maxNs() / 1000));
+    };
+    for (size_t i = 0; i < PHASE_COUNT; ++i) {
+        append(toString(static_cast<Phase>(i)), mPhaseTimes[i]);
+    }
+    append("cycle", mCycleTimes);
+    return result;
+}
+
+std::string ThreadPhaseTimes::dump(const std::string& prefix) const {
+    std::string result;
+    StringAppendF(&result, "%sPhase times (us), %lld cycles, %lld over budget of %lld us:\n",
+            prefix.c_str(), (long long)cycles(), (long long)cyclesOverBudget(),
+            (long long)(mBudgetNs.load(std::memory_order_relaxed) / 1000));
+    for (size_t i = 0; i < PHASE_COUNT; ++i) {
+        StringAppendF(&result, "%s  %-8s %s\n", prefix.c_str(),
+                toString(static_cast<Phase>(i)), mPhaseTimes[i].toString().c_str());
+    }
+    StringAppendF(&result, "%s  %-8s %s\n", prefix.c_str(), "cycle",
+            mCycleTimes.toString().c_str());
+
+    std::string tracks;
+    for (const auto& slot : mTracks) {
+        const int id = slot.mTrackId.load(std::memory_order_relaxed);
+        if (id != 0) {
+            StringAppendF(&tracks, "%s  %-8d %s\n", prefix.c_str(), id,
+                    slot.mMixTimes.toString().c_str());
+        }
+    }
+    if (!tracks.empty()) {
+        StringAppendF(&result, "%sTrack mix times (us, sampled):\n", prefix.c_str());
+        result.append(tracks);
+    }
+
+    std::string recent;
+    for (const auto& slot : mRecentOverBudget) {
+        Cycle cycle;
+        if (!readCycle(slot, &cycle)) continue;
+        StringAppendF(&recent, "%s  at %lld ms: total %lld", prefix.c_str(),
+                (long long)(cycle.startNs / 1000000), (long long)(cycle.totalNs / 1000));
+        for (size_t i = 0; i < PHASE_COUNT; ++i) {
+            StringAppendF(&recent, " %s %lld", toString(static_cast<Phase>(i)),
+                    (long long)(cycle.phaseNs[i] / 1000));
+        }
+        recent.append("\n");
+    }
+    if (!recent.empty()) {
+        StringAppendF(&result, "%sRecent cycles over budget (us):\n", prefix.c_str());
+        result.append(recent);
+    }
+    return result;
+}
+
+} // namespace android::audioflinger
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace android::audioflinger {
+
+/**
+ * LatencyHistogram counts durations in log2 spaced buckets.
+ *
+ * Bucket 0 holds durations below 1 us, bucket i > 0 durations in [2^(i-1), 2^i) us and the
+ * last bucket everything longer. Percentiles are reported as the upper bound of their bucket.
+ *
+ * add() and reset() must be called by a single writer, typically a real-time thread, and do
+ * not block nor use atomic read-modify-write operations. Any thread may read concurrently,
+ * possibly seeing an add() partially applied.
+ */
+class LatencyHistogram {
+public:
+    static constexpr size_t kBuckets = 24;  // the last bucket starts at 2^22 us, about 4 s
+
+    void add(int64_t durationNs);
+    void reset();
+
+    [[nodiscard]] int64_t count() const { return mCount.load(std::memory_order_relaxed); }
+    [[nodiscard]] int64_t totalNs() const { return mTotalNs.load(std::memory_order_relaxed); }
+    [[nodiscard]] int64_t maxNs() const { return mMaxNs.load(std::memory_order_relaxed); }
+    [[nodiscard]] int64_t bucketCount(size_t bucket) const {
+        return mCounts[bucket].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns the upper bound in ns of the bucket holding the given percentile (0 to 100),
+     * limited to maxNs(), or 0 if empty.
+     */
+    [[nodiscard]] int64_t percentileNs(double percentile) const;
+
+    /** Returns e.g. "n=1000 mean=412.3 p50=512 p90=1024 p99=2048 max=2877" in us. */
+    [[nodiscard]] std::string toString() const;
+
+    [[nodiscard]] static size_t bucketOf(int64_t durationNs);
+
+private:
+    std::array<std::atomic<int64_t>, kBuckets> mCounts{};
+    std::atomic<int64_t> mCount{0};
+    std::atomic<int64_t> mTotalNs{0};
+    std::atomic<int64_t> mMaxNs{0};
+};
+
+/**
+ * ThreadPhaseTimes accounts for where the time of each thread loop cycle goes.
+ *
+ * The thread loop reports the duration of each phase of a cycle with recordCycle(), and the
+ * sampled mix time of its tracks with recordTrackMixTime(). Both update histograms and a
+ * small ring of the recent cycles over budget without locks, so they can be called on every
+ * cycle. dump() and the accessors may be called from any thread.
+ */
+class ThreadPhaseTimes {
+public:
+    enum Phase : size_t {
+        PHASE_PREPARE,  // prepareTracks_l()
+        PHASE_MIX,      // threadLoop_mix()
+        PHASE_EFFECTS,  // effect chains
+        PHASE_WRITE,    // threadLoop_write()
+        PHASE_COUNT,
+    };
+    static const char* toString(Phase phase);
+
+    struct Cycle {
+        int64_t startNs = 0;                     // CLOCK_MONOTONIC
+        std::array<int64_t, PHASE_COUNT> phaseNs{};  // 0 if the phase did not run
+        int64_t totalNs = 0;                     // start of cycle to end of write
+    };
+
+    // Cycles whose processing time, that is the total less the write which usually blocks on
+    // the HAL, exceeds the budget (the thread period) are kept for dump(), 0 to disable.
+    void setBudgetNs(int64_t budgetNs) { mBudgetNs.store(budgetNs, std::memory_order_relaxed); }
+
+    // Thread loop only.
+    void recordCycle(const Cycle& cycle);
+    void recordTrackMixTime(int trackId, int64_t mixTimeNs);
+
+    [[nodiscard]] int64_t cycles() const { return mCycleTimes.count(); }
+    [[nodiscard]] int64_t cyclesOverBudget() const {
+        return mCyclesOverBudget.load(std::memory_order_relaxed);
+    }
+    [[nodiscard]] const LatencyHistogram& phaseTimes(Phase phase) const {
+        return mPhaseTimes[phase];
+    }
+    [[nodiscard]] const LatencyHistogram& cycleTimes() const { return mCycleTimes; }
+
+    // Compact per phase summary "prepare:p50/p99/max|mix:...|cycle:..." in us, for metrics.
+    [[nodiscard]] std::string toMetricsString() const;
+
+    [[nodiscard]] std::string dump(const std::string& prefix) const;
+
+private:
+    static constexpr size_t kMaxTracks = 32;
+    static constexpr size_t kRecentCycles = 8;
+
+    // A cycle readable while being overwritten: the writer makes mSequence odd while
+    // updating, readers retry or skip if it changed.
+    struct CycleSlot {
+        std::atomic<uint32_t> mSequence{0};
+        std::atomic<int64_t> mStartNs{0};
+        std::array<std::atomic<int64_t>, PHASE_COUNT> mPhaseNs{};
+        std::atomic<int64_t> mTotalNs{0};
+    };
+
+    struct TrackSlot {
+        std::atomic<int> mTrackId{0};     // 0 if free
+        int64_t mLastCycle = 0;           // writer only, for eviction
+        LatencyHistogram mMixTimes;
+    };
+
+    [[nodiscard]] bool readCycle(const CycleSlot& slot, Cycle* cycle) const;
+
+    std::atomic<int64_t> mBudgetNs{0};
+    std::array<LatencyHistogram, PHASE_COUNT> mPhaseTimes;
+    LatencyHistogram mCycleTimes;
+    std::atomic<int64_t> mCyclesOverBudget{0};
+    std::array<CycleSlot, kRecentCycles> mRecentOverBudget;
+    std::array<TrackSlot, kMaxTracks> mTracks;
+};
+
+} // namespace android::audioflinger
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "phasetimes_tests"
+
+#include "../PhaseTimes.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+using namespace android::audioflinger;
+
+namespace {
+
+TEST(LatencyHistogramTest, Buckets) {
+    EXPECT_EQ(0u, LatencyHistogram::bucketOf(-1));
+    EXPECT_EQ(0u, LatencyHistogram::bucketOf(999));
+    EXPECT_EQ(1u, LatencyHistogram::bucketOf(1000));
+    EXPECT_EQ(2u, LatencyHistogram::bucketOf(2000));
+    EXPECT_EQ(2u, LatencyHistogram::bucketOf(3999));
+    EXPECT_EQ(3u, LatencyHistogram::bucketOf(4000));
+    EXPECT_EQ(LatencyHistogram::kBuckets - 1, LatencyHistogram::bucketOf(INT64_MAX));
+}
+
+TEST(LatencyHistogramTest, Percentiles) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(0, histogram.percentileNs(50));
+    EXPECT_EQ("n=0", histogram.toString());
+
+    // 90 values of 100 us, 10 of 3 ms
+    for (int i = 0; i < 90; ++i) histogram.add(100'000);
+    for (int i = 0; i < 10; ++i) histogram.add(3'000'000);
+    EXPECT_EQ(100, histogram.count());
+    EXPECT_EQ(9'000'000 + 30'000'000, histogram.totalNs());
+    EXPECT_EQ(3'000'000, histogram.maxNs());
+    EXPECT_EQ(128'000, histogram.percentileNs(50));  // upper bound of [64, 128) us
+    EXPECT_EQ(128'000, histogram.percentileNs(89));
+    EXPECT_EQ(3'000'000, histogram.percentileNs(99));  // limited to max
+    EXPECT_EQ("n=100 mean=390.0 p50=128 p90=3000 p99=3000 max=3000", histogram.toString());
+
+    histogram.reset();
+    EXPECT_EQ(0, histogram.count());
+    EXPECT_EQ(0, histogram.maxNs());
+}
+
+TEST(ThreadPhaseTimesTest, CyclesOverBudget) {
+    ThreadPhaseTimes phaseTimes;
+    phaseTimes.setBudgetNs(10'000'000);
+
+    ThreadPhaseTimes::Cycle cycle;
+    cycle.phaseNs = {100'000, 2'000'000, 0 /* no effects */, 5'000'000};
+    cycle.totalNs = 7'500'000;
+    for (int i = 0; i < 10; ++i) {
+        cycle.startNs = i * 10'000'000;
+        phaseTimes.recordCycle(cycle);
+    }
+    cycle.phaseNs[ThreadPhaseTimes::PHASE_EFFECTS] = 8'000'000;
+    cycle.totalNs = 15'500'000;
+    phaseTimes.recordCycle(cycle);
+
+    EXPECT_EQ(11, phaseTimes.cycles());
+    EXPECT_EQ(1, phaseTimes.cyclesOverBudget());
+    EXPECT_EQ(11, phaseTimes.phaseTimes(ThreadPhaseTimes::PHASE_MIX).count());
+    EXPECT_EQ(1, phaseTimes.phaseTimes(ThreadPhaseTimes::PHASE_EFFECTS).count());
+
+    const std::string dump = phaseTimes.dump("  ");
+    EXPECT_NE(std::string::npos, dump.find("11 cycles, 1 over budget of 10000 us"));
+    EXPECT_NE(std::string::npos,
+            dump.find("at 90 ms: total 15500 prepare 100 mix 2000 effects 8000 write 5000"))
+            << dump;
+
+    const std::string metrics = phaseTimes.toMetricsString();
+    // percentiles are bucket bounds, limited to the maximum
+    EXPECT_EQ("prepare:100/100/100|mix:2000/2000/2000|effects:8000/8000/8000"
+            "|write:5000/5000/5000|cycle:8192/15500/15500", metrics);
+}
+
+TEST(ThreadPhaseTimesTest, TrackSlotsAreReused) {
+    ThreadPhaseTimes phaseTimes;
+    ThreadPhaseTimes::Cycle cycle;
+    cycle.totalNs = 1'000'000;
+
+    // more tracks than slots, one cycle each
+    for (int id = 1; id <= 100; ++id) {
+        phaseTimes.recordTrackMixTime(id, id * 1000);
+        phaseTimes.recordCycle(cycle);
+    }
+    phaseTimes.recordTrackMixTime(100, 100'000);
+
+    const std::string dump = phaseTimes.dump("");
+    EXPECT_EQ(std::string::npos, dump.find("\n  1 ")) << dump;  // evicted
+    EXPECT_NE(std::string::npos, dump.find("  100      n=2 ")) << dump;
+}
+
+TEST(ThreadPhaseTimesTest, ConcurrentDump) {
+    ThreadPhaseTimes phaseTimes;
+    phaseTimes.setBudgetNs(1);
+    std::atomic<bool> done = false;
+    std::thread reader([&] {
+        while (!done) {
+            (void)phaseTimes.dump("");
+        }
+    });
+    ThreadPhaseTimes::Cycle cycle;
+    for (int i = 1; i <= 100000; ++i) {
+        cycle.startNs = i;
+        cycle.phaseNs.fill(i);
+        cycle.totalNs = 4 * i;
+        phaseTimes.recordCycle(cycle);
+        phaseTimes.recordTrackMixTime(1 + i % 40, i);
+    }
+    done = true;
+    reader.join();
+    EXPECT_EQ(100000, phaseTimes.cyclesOverBudget());
+}
+
+} // namespace
@@ -54,6 +54,9 @@ public:
     // The suffix of the "engine default" implementation shared library name.
     static const constexpr char* const kDefaultEngineLibraryNameSuffix = "default";
     static const constexpr char* const kCapEngineLibraryNameSuffix = "configurable";
+    // Where the snapshot of the system XML configuration is kept, see AudioPolicyConfigSnapshot.h.
+    static const constexpr char* const kXmlConfigSnapshotPath =
+            "/data/misc/audioserver/audio_policy_configuration.snapshot";
 
     // Creates the default (fallback) configuration.
     static sp<const AudioPolicyConfig> createDefault();
@@ -61,7 +64,8 @@ public:
     static sp<const AudioPolicyConfig> loadFromApmAidlConfigWithFallback(
             const media::AudioPolicyConfig& aidl);
     // Attempts to load the configuration from the XML file, falls back to default on failure.
-    // If the XML file path is not provided, uses `audio_get_audio_policy_config_file` function.
+    // If the XML file path is not provided, uses `audio_get_audio_policy_config_file` function,
+    // and the snapshot at kXmlConfigSnapshotPath when valid instead of parsing the XML.
     static sp<const AudioPolicyConfig> loadFromApmXmlConfigWithFallback(
             const std::string& xmlFilePath = "");
     // The factory method to use in APM tests which craft the configuration manually.
@@ -69,6 +73,12 @@ public:
     // The factory method to use in APM tests which use a custom XML file.
     static error::Result<sp<AudioPolicyConfig>> loadFromCustomXmlConfigForTests(
             const std::string& xmlFilePath);
+    // The factory method to use in APM tests and benchmarks of the configuration snapshot.
+    // Loads the snapshot if valid for the XML file, otherwise the XML file, then saves a
+    // snapshot of it. 'fromSnapshot' tells which one was used.
+    static error::Result<sp<AudioPolicyConfig>> loadFromCustomXmlConfigWithSnapshotForTests(
+            const std::string& xmlFilePath, const std::string& snapshotPath,
+            bool* fromSnapshot = nullptr);
     // The factory method to use in VTS tests. If the 'configPath' is empty,
     // it is determined automatically from the list of known config paths.
     static error::Result<sp<AudioPolicyConfig>> loadFromCustomXmlConfigForVtsTests(
@@ -158,7 +168,11 @@ private:
 
     void augmentData();
     status_t loadFromAidl(const media::AudioPolicyConfig& aidl);
-    status_t loadFromXml(const std::string& xmlFilePath, bool forVts);
+    status_t loadFromXml(const std::string& xmlFilePath, bool forVts,
+            const std::string& snapshotPath = {});
+    status_t loadFromSnapshot(const std::string& snapshotPath, const std::string& xmlFilePath);
+    static sp<AudioPolicyConfig> loadFromSnapshotOrXml(const std::string& xmlFilePath,
+            const std::string& snapshotPath, bool* fromSnapshot);
 
     std::string mSource;  // Not kDefaultConfigSource. Empty source means an empty config.
     std::string mEngineLibraryNameSuffix = kDefaultEngineLibraryNameSuffix;
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "AudioPolicyConfig.h"
+
+namespace android {
+
+// A snapshot is a binary image of an AudioPolicyConfig deserialized from an XML file, before
+// augmentation. It records the path, size and hash of the XML file and of all the files it
+// includes, and is only loaded if none of them changed, the snapshot format version matches and
+// it was written by the same system and vendor builds.
+
+// Saves the modules, devices and global configuration of 'config', loaded from 'xmlFilePath'.
+// The snapshot is written to a temporary file which then atomically replaces 'snapshotPath'.
+status_t saveAudioPolicyConfigSnapshot(const std::string& snapshotPath,
+        const std::string& xmlFilePath, const AudioPolicyConfig& config);
+
+// Fills 'config', which must be empty, from the snapshot at 'snapshotPath' if it is valid for
+// 'xmlFilePath'. Returns NAME_NOT_FOUND if there is no snapshot, BAD_VALUE if the snapshot is
+// corrupt or from another format version, INVALID_OPERATION if the XML files or the builds
+// changed.
+status_t loadAudioPolicyConfigSnapshot(const std::string& snapshotPath,
+        const std::string& xmlFilePath, AudioPolicyConfig* config);
+
+} // namespace android
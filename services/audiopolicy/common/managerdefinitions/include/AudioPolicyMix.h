@@ -27,6 +27,11 @@
 #include <DeviceDescriptor.h>
 #include <AudioOutputDescriptor.h>
 
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 namespace android {
 
 /**
@@ -147,6 +152,7 @@ public:
 private:
     bool mixMatch(const AudioMix* mix, size_t mixIndex,
                             const audio_attributes_t& attributes,
+                            const std::optional<std::string>& tagAddress,
                             const audio_output_flags_t outputFlags,
                             const audio_config_base_t& config,
                             uid_t uid,
@@ -158,6 +164,29 @@ private:
 
     sp<DeviceDescriptor> getOutputDeviceForMix(const AudioMix* mix,
                             const DeviceVector& availableOutputDevices);
+
+    /**
+     * Index of the mixes getOutputForAttr() must consider for given attributes and uid.
+     * A mix with positive usage, capture preset or uid rules can only match if one of these
+     * rules does, and any mix can match by the address in the attributes tags. Mixes that can
+     * match otherwise, or have an effect even when not matching, are always considered.
+     * Candidates are positions in the collection, the index is rebuilt after any change to the
+     * mixes, their criteria or route flags.
+     */
+    void invalidateOutputMixIndex() { mOutputMixIndexValid = false; }
+    void buildOutputMixIndex();
+    const std::vector<size_t>& getOutputMixCandidates(const audio_attributes_t& attributes,
+                                                      const std::optional<std::string>& tagAddress,
+                                                      uid_t uid);
+
+    bool mOutputMixIndexValid = false;
+    size_t mIndexedMixes = 0;
+    std::vector<size_t> mAlwaysCandidates;
+    std::unordered_map<audio_usage_t, std::vector<size_t>> mCandidatesByUsage;
+    std::unordered_map<audio_source_t, std::vector<size_t>> mCandidatesBySource;
+    std::unordered_map<uid_t, std::vector<size_t>> mCandidatesByUid;
+    std::unordered_map<std::string, std::vector<size_t>> mCandidatesByAddress;
+    std::vector<size_t> mCandidates;  // result of the last getOutputMixCandidates()
 };
 
 std::optional<std::string> extractAddressFromAudioAttributes(const audio_attributes_t& attr);
@@ -18,6 +18,7 @@
 
 #include <android-base/properties.h>
 #include <AudioPolicyConfig.h>
+#include <AudioPolicyConfigSnapshot.h>
 #include <IOProfile.h>
 #include <Serializer.h>
 #include <hardware/audio.h>
@@ -198,6 +199,14 @@ sp<const AudioPolicyConfig> AudioPolicyConfig::loadFromApmAidlConfigWithFallback
 // static
 sp<const AudioPolicyConfig> AudioPolicyConfig::loadFromApmXmlConfigWithFallback(
         const std::string& xmlFilePath) {
+    // Only the system configuration is snapshotted, custom files are usually tests.
+    if (xmlFilePath.empty() && property_get_bool("audio.policy.config_snapshot.enabled", true)) {
+        if (auto config = loadFromSnapshotOrXml(audio_get_audio_policy_config_file(),
+                        kXmlConfigSnapshotPath, nullptr /*fromSnapshot*/); config != nullptr) {
+            return config;
+        }
+        return createDefault();
+    }
     const std::string filePath =
             xmlFilePath.empty() ? audio_get_audio_policy_config_file() : xmlFilePath;
     auto config = sp<AudioPolicyConfig>::make();
@@ -207,6 +216,23 @@ sp<const AudioPolicyConfig> AudioPolicyConfig::loadFromApmXmlConfigWithFallback(
     return createDefault();
 }
 
+// static
+sp<AudioPolicyConfig> AudioPolicyConfig::loadFromSnapshotOrXml(const std::string& xmlFilePath,
+        const std::string& snapshotPath, bool* fromSnapshot) {
+    auto config = sp<AudioPolicyConfig>::make();
+    if (config->loadFromSnapshot(snapshotPath, xmlFilePath) == NO_ERROR) {
+        if (fromSnapshot != nullptr) *fromSnapshot = true;
+        return config;
+    }
+    // A partially loaded snapshot is discarded.
+    config = sp<AudioPolicyConfig>::make();
+    if (fromSnapshot != nullptr) *fromSnapshot = false;
+    if (config->loadFromXml(xmlFilePath, false /*forVts*/, snapshotPath) == NO_ERROR) {
+        return config;
+    }
+    return nullptr;
+}
+
 // static
 sp<AudioPolicyConfig> AudioPolicyConfig::createWritableForTests() {
     return sp<AudioPolicyConfig>::make();
@@ -223,6 +249,16 @@ error::Result<sp<AudioPolicyConfig>> AudioPolicyConfig::loadFromCustomXmlConfigF
     }
 }
 
+// static
+error::Result<sp<AudioPolicyConfig>> AudioPolicyConfig::loadFromCustomXmlConfigWithSnapshotForTests(
+        const std::string& xmlFilePath, const std::string& snapshotPath, bool* fromSnapshot) {
+    if (auto config = loadFromSnapshotOrXml(xmlFilePath, snapshotPath, fromSnapshot);
+            config != nullptr) {
+        return config;
+    }
+    return base::unexpected(BAD_VALUE);
+}
+
 // static
 error::Result<sp<AudioPolicyConfig>> AudioPolicyConfig::loadFromCustomXmlConfigForVtsTests(
         const std::string& configPath, const std::string& xmlFileName) {
@@ -288,7 +324,8 @@ status_t AudioPolicyConfig::loadFromAidl(const media::AudioPolicyConfig& aidl) {
     return NO_ERROR;
 }
 
-status_t AudioPolicyConfig::loadFromXml(const std::string& xmlFilePath, bool forVts) {
+status_t AudioPolicyConfig::loadFromXml(const std::string& xmlFilePath, bool forVts,
+        const std::string& snapshotPath) {
     if (xmlFilePath.empty()) {
         ALOGE("Audio policy configuration file name is empty");
         return BAD_VALUE;
@@ -296,6 +333,11 @@ status_t AudioPolicyConfig::loadFromXml(const std::string& xmlFilePath, bool for
     status_t status = forVts ? deserializeAudioPolicyFileForVts(xmlFilePath.c_str(), this)
             : deserializeAudioPolicyFile(xmlFilePath.c_str(), this);
     if (status == NO_ERROR) {
+        if (!snapshotPath.empty()) {
+            // Before augmentData(), which is applied again after loading the snapshot.
+            // Failing to save only costs parsing the XML again on the next start.
+            (void)saveAudioPolicyConfigSnapshot(snapshotPath, xmlFilePath, *this);
+        }
         mSource = xmlFilePath;
         augmentData();
     } else {
@@ -305,6 +347,19 @@ status_t AudioPolicyConfig::loadFromXml(const std::string& xmlFilePath, bool for
     return status;
 }
 
+status_t AudioPolicyConfig::loadFromSnapshot(const std::string& snapshotPath,
+        const std::string& xmlFilePath) {
+    if (status_t status = loadAudioPolicyConfigSnapshot(snapshotPath, xmlFilePath, this);
+            status != NO_ERROR) {
+        ALOGI_IF(status != NAME_NOT_FOUND, "Not using snapshot \"%s\" of \"%s\": %d",
+                snapshotPath.c_str(), xmlFilePath.c_str(), status);
+        return status;
+    }
+    mSource = xmlFilePath;
+    augmentData();
+    return NO_ERROR;
+}
+
 void AudioPolicyConfig::setDefault() {
     mSource = kDefaultConfigSource;
     mEngineLibraryNameSuffix = kDefaultEngineLibraryNameSuffix;
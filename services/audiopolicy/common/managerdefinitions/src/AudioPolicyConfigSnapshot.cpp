@@ -0,0 +1,468 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "APM_ConfigSnapshot"
+//#define LOG_NDEBUG 0
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <regex>
+#include <set>
+#include <vector>
+
+#include <AudioPolicyConfigSnapshot.h>
+#include <AudioRoute.h>
+#include <HwModule.h>
+#include <IOProfile.h>
+#include <android-base/file.h>
+#include <android-base/unique_fd.h>
+#include <binder/Parcel.h>
+#include <cutils/properties.h>
+#include <media/AidlConversionUtil.h>
+#include <utils/Log.h>
+
+namespace android {
+
+namespace {
+
+constexpr uint32_t kMagic = 0x53435041;  // "APCS"
+// Increment whenever the payload layout, or the parcelable of the ports, changes.
+constexpr uint32_t kVersion = 2;
+constexpr int kMaxIncludeDepth = 8;
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    // The XML deserializer and the parcelables of the ports can change with an update, without
+    // kVersion being incremented, so a snapshot is only used by the builds that wrote it.
+    char buildFingerprint[PROPERTY_VALUE_MAX];
+    char vendorBuildFingerprint[PROPERTY_VALUE_MAX];
+    uint64_t payloadSize;
+    uint64_t payloadHash;
+};
+
+// Fills the fingerprints of 'header', which must be zeroed, with those of the running builds.
+void getBuildFingerprints(Header* header) {
+    property_get("ro.build.fingerprint", header->buildFingerprint, "");
+    property_get("ro.vendor.build.fingerprint", header->vendorBuildFingerprint, "");
+}
+
+uint64_t hashBytes(const void* data, size_t size) {
+    // FNV-1a, to detect changes and corruption, not tampering: the snapshot is only as trusted
+    // as the directory it is stored in.
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+struct SourceFile {
+    std::string path;
+    uint64_t size;
+    uint64_t hash;
+};
+
+// Collects the XML file and, recursively, the files it includes with XInclude.
+status_t collectSourceFiles(const std::string& path, int depth, std::set<std::string>* visited,
+        std::vector<SourceFile>* files) {
+    if (!visited->insert(path).second) {
+        return NO_ERROR;
+    }
+    std::string content;
+    if (!base::ReadFileToString(path, &content)) {
+        ALOGV("%s: cannot read %s", __func__, path.c_str());
+        return NAME_NOT_FOUND;
+    }
+    files->push_back({path, content.size(), hashBytes(content.data(), content.size())});
+    if (depth >= kMaxIncludeDepth) {
+        return NO_ERROR;
+    }
+    static const std::regex kIncludeRegex(R"(<\s*[\w]*:?include\s[^>]*href\s*=\s*"([^"]+)\")");
+    const std::string directory = base::Dirname(path);
+    for (auto it = std::sregex_iterator(content.begin(), content.end(), kIncludeRegex);
+            it != std::sregex_iterator(); ++it) {
+        std::string includePath = (*it)[1].str();
+        if (includePath.empty() || includePath[0] != '/') {
+            includePath = directory + "/" + includePath;
+        }
+        // Missing includes are not fatal for the XML parser either.
+        collectSourceFiles(includePath, depth + 1, visited, files);
+    }
+    return NO_ERROR;
+}
+
+status_t writeSourceFiles(const std::vector<SourceFile>& files, Parcel* parcel) {
+    RETURN_STATUS_IF_ERROR(parcel->writeInt32(files.size()));
+    for (const auto& file : files) {
+        RETURN_STATUS_IF_ERROR(parcel->writeString8(String8(file.path.c_str())));
+        RETURN_STATUS_IF_ERROR(parcel->writeUint64(file.size));
+        RETURN_STATUS_IF_ERROR(parcel->writeUint64(file.hash));
+    }
+    return NO_ERROR;
+}
+
+// Checks that the recorded files are unchanged. Additional includes can only come from a change
+// to one of them.
+status_t checkSourceFiles(const std::string& xmlFilePath, const Parcel& parcel) {
+    const int32_t count = parcel.readInt32();
+    if (count <= 0) {
+        return BAD_VALUE;
+    }
+    for (int32_t i = 0; i < count; ++i) {
+        const std::string path = parcel.readString8().c_str();
+        const uint64_t size = parcel.readUint64();
+        const uint64_t hash = parcel.readUint64();
+        if (i == 0 && path != xmlFilePath) {
+            ALOGV("%s: snapshot of %s, not %s", __func__, path.c_str(), xmlFilePath.c_str());
+            return INVALID_OPERATION;
+        }
+        std::string content;
+        if (!base::ReadFileToString(path, &content) || content.size() != size
+                || hashBytes(content.data(), content.size()) != hash) {
+            ALOGI("%s: %s changed since the snapshot", __func__, path.c_str());
+            return INVALID_OPERATION;
+        }
+    }
+    return NO_ERROR;
+}
+
+// Ports are referenced by their position in the module: mix ports, then declared devices.
+using PortPositions = std::map<const PolicyAudioPort*, int32_t>;
+
+status_t writeModule(const sp<HwModule>& module, Parcel* parcel) {
+    RETURN_STATUS_IF_ERROR(parcel->writeString8(String8(module->getName())));
+    RETURN_STATUS_IF_ERROR(parcel->writeUint32(module->getHalVersionMajor()));
+    RETURN_STATUS_IF_ERROR(parcel->writeUint32(module->getHalVersionMinor()));
+
+    PortPositions positions;
+    IOProfileCollection mixPorts = module->getOutputProfiles();
+    mixPorts.appendVector(module->getInputProfiles());
+    RETURN_STATUS_IF_ERROR(parcel->writeInt32(mixPorts.size()));
+    for (const auto& mixPort : mixPorts) {
+        media::AudioPortFw fwPort;
+        RETURN_STATUS_IF_ERROR(mixPort->writeToParcelable(&fwPort));
+        RETURN_STATUS_IF_ERROR(parcel->writeParcelable(fwPort));
+        positions.emplace(mixPort.get(), positions.size());
+    }
+    const DeviceVector& devicePorts = module->getDeclaredDevices();
+    RETURN_STATUS_IF_ERROR(parcel->writeInt32(devicePorts.size()));
+    for (const auto& devicePort : devicePorts) {
+        media::AudioPortFw fwPort;
+        RETURN_STATUS_IF_ERROR(parcel->writeString8(String8(devicePort->getTagName().c_str())));
+        RETURN_STATUS_IF_ERROR(devicePort->writeToParcelable(&fwPort));
+        RETURN_STATUS_IF_ERROR(parcel->writeParcelable(fwPort));
+        positions.emplace(devicePort.get(), positions.size());
+    }
+
+    auto writePort = [&](const sp<PolicyAudioPort>& port) -> status_t {
+        const auto it = positions.find(port.get());
+        if (it == positions.end()) {
+            ALOGE("%s: route of module %s to an undeclared port", __func__, module->getName());
+            return BAD_VALUE;
+        }
+        return parcel->writeInt32(it->second);
+    };
+    RETURN_STATUS_IF_ERROR(parcel->writeInt32(module->getRoutes().size()));
+    for (const auto& route : module->getRoutes()) {
+        RETURN_STATUS_IF_ERROR(parcel->writeInt32(route->getType()));
+        RETURN_STATUS_IF_ERROR(writePort(route->getSink()));
+        RETURN_STATUS_IF_ERROR(parcel->writeInt32(route->getSources().size()));
+        for (const auto& source : route->getSources()) {
+            RETURN_STATUS_IF_ERROR(writePort(source));
+        }
+    }
+    return NO_ERROR;
+}
+
+status_t readModule(const Parcel& parcel, sp<HwModule>* module,
+        std::vector<sp<DeviceDescriptor>>* devices) {
+    const String8 name = parcel.readString8();
+    const uint32_t versionMajor = parcel.readUint32();
+    const uint32_t versionMinor = parcel.readUint32();
+    *module = sp<HwModule>::make(name.c_str(), versionMajor, versionMinor);
+
+    std::vector<sp<PolicyAudioPort>> ports;
+    IOProfileCollection mixPorts;
+    const int32_t mixPortCount = parcel.readInt32();
+    for (int32_t i = 0; i < mixPortCount; ++i) {
+        media::AudioPortFw fwPort;
+        RETURN_STATUS_IF_ERROR(parcel.readParcelable(&fwPort));
+        auto mixPort = sp<IOProfile>::make("", AUDIO_PORT_ROLE_NONE);
+        RETURN_STATUS_IF_ERROR(mixPort->readFromParcelable(fwPort));
+        mixPorts.add(mixPort);
+        ports.push_back(mixPort);
+    }
+    (*module)->setProfiles(mixPorts);
+
+    DeviceVector devicePorts;
+    const int32_t devicePortCount = parcel.readInt32();
+    for (int32_t i = 0; i < devicePortCount; ++i) {
+        const String8 tagName = parcel.readString8();
+        media::AudioPortFw fwPort;
+        RETURN_STATUS_IF_ERROR(parcel.readParcelable(&fwPort));
+        auto devicePort = sp<DeviceDescriptor>::make(AUDIO_DEVICE_NONE, tagName.c_str());
+        RETURN_STATUS_IF_ERROR(devicePort->readFromParcelable(fwPort));
+        devicePorts.add(devicePort);
+        devices->push_back(devicePort);
+        ports.push_back(devicePort);
+    }
+    (*module)->setDeclaredDevices(devicePorts);
+
+    auto readPort = [&](sp<PolicyAudioPort>* port) -> status_t {
+        const int32_t position = parcel.readInt32();
+        if (position < 0 || static_cast<size_t>(position) >= ports.size()) {
+            return BAD_VALUE;
+        }
+        *port = ports[position];
+        return NO_ERROR;
+    };
+    AudioRouteVector routes;
+    const int32_t routeCount = parcel.readInt32();
+    for (int32_t i = 0; i < routeCount; ++i) {
+        auto route = sp<AudioRoute>::make(static_cast<audio_route_type_t>(parcel.readInt32()));
+        sp<PolicyAudioPort> sink;
+        RETURN_STATUS_IF_ERROR(readPort(&sink));
+        PolicyAudioPortVector sources;
+        const int32_t sourceCount = parcel.readInt32();
+        for (int32_t j = 0; j < sourceCount; ++j) {
+            sp<PolicyAudioPort> source;
+            RETURN_STATUS_IF_ERROR(readPort(&source));
+            sources.add(source);
+        }
+        // Same order of operations as the XML deserializer.
+        route->setSink(sink);
+        sink->addRoute(route);
+        for (const auto& source : sources) {
+            source->addRoute(route);
+        }
+        route->setSources(sources);
+        routes.add(route);
+    }
+    (*module)->setRoutes(routes);
+    return parcel.errorCheck();
+}
+
+// Attached and default devices are referenced by module and device position.
+using DevicePositions = std::map<const DeviceDescriptor*, std::pair<int32_t, int32_t>>;
+
+status_t writeDevice(const sp<DeviceDescriptor>& device, const DevicePositions& positions,
+        Parcel* parcel) {
+    if (device == nullptr) {
+        RETURN_STATUS_IF_ERROR(parcel->writeInt32(-1));
+        return parcel->writeInt32(-1);
+    }
+    const auto it = positions.find(device.get());
+    if (it == positions.end()) {
+        ALOGE("%s: device %s is not declared by a module", __func__,
+                device->getTagName().c_str());
+        return BAD_VALUE;
+    }
+    RETURN_STATUS_IF_ERROR(parcel->writeInt32(it->second.first));
+    return parcel->writeInt32(it->second.second);
+}
+
+status_t readDevice(const Parcel& parcel,
+        const std::vector<std::vector<sp<DeviceDescriptor>>>& devices,
+        sp<DeviceDescriptor>* device) {
+    const int32_t module = parcel.readInt32();
+    const int32_t position = parcel.readInt32();
+    if (module == -1 && position == -1) {
+        *device = nullptr;
+        return NO_ERROR;
+    }
+    if (module < 0 || static_cast<size_t>(module) >= devices.size() || position < 0
+            || static_cast<size_t>(position) >= devices[module].size()) {
+        return BAD_VALUE;
+    }
+    *device = devices[module][position];
+    return NO_ERROR;
+}
+
+status_t writeConfig(const AudioPolicyConfig& config, Parcel* parcel) {
+    RETURN_STATUS_IF_ERROR(parcel->writeString8(
+            String8(config.getEngineLibraryNameSuffix().c_str())));
+    RETURN_STATUS_IF_ERROR(parcel->writeBool(config.isCallScreenModeSupported()));
+    RETURN_STATUS_IF_ERROR(parcel->writeInt32(config.getSurroundFormats().size()));
+    for (const auto& [format, subFormats] : config.getSurroundFormats()) {
+        RETURN_STATUS_IF_ERROR(parcel->writeUint32(format));
+        RETURN_STATUS_IF_ERROR(parcel->writeInt32(subFormats.size()));
+        for (audio_format_t subFormat : subFormats) {
+            RETURN_STATUS_IF_ERROR(parcel->writeUint32(subFormat));
+        }
+    }
+
+    DevicePositions positions;
+    const HwModuleCollection& modules = config.getHwModules();
+    RETURN_STATUS_IF_ERROR(parcel->writeInt32(modules.size()));
+    for (size_t i = 0; i < modules.size(); ++i) {
+        RETURN_STATUS_IF_ERROR(writeModule(modules[i], parcel));
+        const DeviceVector& declared = modules[i]->getDeclaredDevices();
+        for (size_t j = 0; j < declared.size(); ++j) {
+            positions.emplace(declared[j].get(), std::make_pair(i, j));
+        }
+    }
+    for (const DeviceVector* attached : {&config.getOutputDevices(), &config.getInputDevices()}) {
+        RETURN_STATUS_IF_ERROR(parcel->writeInt32(attached->size()));
+        for (const auto& device : *attached) {
+            RETURN_STATUS_IF_ERROR(writeDevice(device, positions, parcel));
+        }
+    }
+    return writeDevice(config.getDefaultOutputDevice(), positions, parcel);
+}
+
+status_t readConfig(const Parcel& parcel, AudioPolicyConfig* config) {
+    config->setEngineLibraryNameSuffix(parcel.readString8().c_str());
+    config->setCallScreenModeSupported(parcel.readBool());
+    AudioPolicyConfig::SurroundFormats surroundFormats;
+    const int32_t surroundFormatCount = parcel.readInt32();
+    for (int32_t i = 0; i < surroundFormatCount && parcel.errorCheck() == NO_ERROR; ++i) {
+        auto& subFormats = surroundFormats[static_cast<audio_format_t>(parcel.readUint32())];
+        const int32_t subFormatCount = parcel.readInt32();
+        for (int32_t j = 0; j < subFormatCount && parcel.errorCheck() == NO_ERROR; ++j) {
+            subFormats.insert(static_cast<audio_format_t>(parcel.readUint32()));
+        }
+    }
+    config->setSurroundFormats(surroundFormats);
+
+    HwModuleCollection modules;
+    std::vector<std::vector<sp<DeviceDescriptor>>> devices;
+    const int32_t moduleCount = parcel.readInt32();
+    for (int32_t i = 0; i < moduleCount; ++i) {
+        sp<HwModule> module;
+        RETURN_STATUS_IF_ERROR(readModule(parcel, &module, &devices.emplace_back()));
+        modules.add(module);
+    }
+    config->setHwModules(modules);
+    for (int attached = 0; attached < 2; ++attached) {
+        const int32_t count = parcel.readInt32();
+        for (int32_t i = 0; i < count; ++i) {
+            sp<DeviceDescriptor> device;
+            RETURN_STATUS_IF_ERROR(readDevice(parcel, devices, &device));
+            if (device == nullptr) return BAD_VALUE;
+            config->addDevice(device);
+        }
+    }
+    sp<DeviceDescriptor> defaultOutputDevice;
+    RETURN_STATUS_IF_ERROR(readDevice(parcel, devices, &defaultOutputDevice));
+    config->setDefaultOutputDevice(defaultOutputDevice);
+    return parcel.errorCheck();
+}
+
+}  // namespace
+
+status_t saveAudioPolicyConfigSnapshot(const std::string& snapshotPath,
+        const std::string& xmlFilePath, const AudioPolicyConfig& config) {
+    std::vector<SourceFile> files;
+    std::set<std::string> visited;
+    RETURN_STATUS_IF_ERROR(collectSourceFiles(xmlFilePath, 0, &visited, &files));
+
+    Parcel parcel;
+    RETURN_STATUS_IF_ERROR(writeSourceFiles(files, &parcel));
+    if (status_t status = writeConfig(config, &parcel); status != NO_ERROR) {
+        ALOGW("%s: cannot snapshot %s: %d", __func__, xmlFilePath.c_str(), status);
+        return status;
+    }
+    Header header = {};
+    header.magic = kMagic;
+    header.version = kVersion;
+    getBuildFingerprints(&header);
+    header.payloadSize = parcel.dataSize();
+    header.payloadHash = hashBytes(parcel.data(), parcel.dataSize());
+    std::string content(reinterpret_cast<const char*>(&header), sizeof(header));
+    content.append(reinterpret_cast<const char*>(parcel.data()), parcel.dataSize());
+
+    const std::string tmpPath = snapshotPath + ".tmp";
+    if (!base::WriteStringToFile(content, tmpPath, S_IRUSR | S_IWUSR | S_IRGRP,
+                    getuid(), getgid())) {
+        ALOGW("%s: cannot write %s: %s", __func__, tmpPath.c_str(), strerror(errno));
+        return -errno;
+    }
+    if (rename(tmpPath.c_str(), snapshotPath.c_str()) != 0) {
+        const int error = errno;
+        ALOGW("%s: cannot rename %s: %s", __func__, tmpPath.c_str(), strerror(error));
+        unlink(tmpPath.c_str());
+        return -error;
+    }
+    ALOGI("%s: saved %s for %s (%zu files, %zu bytes)", __func__, snapshotPath.c_str(),
+            xmlFilePath.c_str(), files.size(), content.size());
+    return NO_ERROR;
+}
+
+status_t loadAudioPolicyConfigSnapshot(const std::string& snapshotPath,
+        const std::string& xmlFilePath, AudioPolicyConfig* config) {
+    base::unique_fd fd(TEMP_FAILURE_RETRY(open(snapshotPath.c_str(), O_RDONLY | O_CLOEXEC)));
+    if (fd < 0) {
+        return NAME_NOT_FOUND;
+    }
+    struct stat st;
+    if (fstat(fd.get(), &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+        return BAD_VALUE;
+    }
+    const size_t size = st.st_size;
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+    if (mapped == MAP_FAILED) {
+        ALOGW("%s: cannot map %s: %s", __func__, snapshotPath.c_str(), strerror(errno));
+        return BAD_VALUE;
+    }
+    const auto unmap = [mapped, size](status_t status) {
+        munmap(mapped, size);
+        return status;
+    };
+    Header header;
+    memcpy(&header, mapped, sizeof(header));
+    const auto* payload = static_cast<const uint8_t*>(mapped) + sizeof(header);
+    if (header.magic != kMagic || header.version != kVersion
+            || header.payloadSize != size - sizeof(header)
+            || header.payloadHash != hashBytes(payload, header.payloadSize)) {
+        ALOGW("%s: ignoring %s: version %u, %zu bytes", __func__, snapshotPath.c_str(),
+                header.version, size);
+        return unmap(BAD_VALUE);
+    }
+    Header build = {};
+    getBuildFingerprints(&build);
+    if (strncmp(header.buildFingerprint, build.buildFingerprint,
+                    sizeof(build.buildFingerprint)) != 0
+            || strncmp(header.vendorBuildFingerprint, build.vendorBuildFingerprint,
+                    sizeof(build.vendorBuildFingerprint)) != 0) {
+        ALOGI("%s: ignoring %s of build %.*s, vendor build %.*s", __func__,
+                snapshotPath.c_str(), PROPERTY_VALUE_MAX, header.buildFingerprint,
+                PROPERTY_VALUE_MAX, header.vendorBuildFingerprint);
+        return unmap(INVALID_OPERATION);
+    }
+
+    Parcel parcel;
+    if (status_t status = parcel.setData(payload, header.payloadSize); status != NO_ERROR) {
+        return unmap(status);
+    }
+    unmap(NO_ERROR);
+    RETURN_STATUS_IF_ERROR(checkSourceFiles(xmlFilePath, parcel));
+    if (status_t status = readConfig(parcel, config); status != NO_ERROR) {
+        ALOGW("%s: cannot read %s: %d", __func__, snapshotPath.c_str(), status);
+        return BAD_VALUE;
+    }
+    ALOGV("%s: loaded %s from %s", __func__, xmlFilePath.c_str(), snapshotPath.c_str());
+    return NO_ERROR;
+}
+
+} // namespace android
@@ -35,8 +35,7 @@ namespace audiopolicy_flags = android::media::audiopolicy;
 namespace android {
 namespace {
 
-bool matchAddressToTags(const audio_attributes_t& attr, const String8& addr) {
-    std::optional<std::string> tagAddress = extractAddressFromAudioAttributes(attr);
+bool matchAddressToTags(const std::optional<std::string>& tagAddress, const String8& addr) {
     return tagAddress.has_value() && tagAddress->compare(addr.c_str()) == 0;
 }
 
@@ -207,6 +206,7 @@ status_t AudioPolicyMixCollection::registerMix(const AudioMix& mix,
     }
     sp<AudioPolicyMix> policyMix = sp<AudioPolicyMix>::make(mix);
     add(policyMix);
+    invalidateOutputMixIndex();
     ALOGD("registerMix(): adding mix for dev=0x%x addr=%s",
             policyMix->mDeviceType, policyMix->mDeviceAddress.c_str());
 
@@ -226,6 +226,7 @@ status_t AudioPolicyMixCollection::unregisterMix(const AudioMix& mix)
                 ALOGD("unregisterMix(): removing mix for dev=0x%x addr=%s",
                       mix.mDeviceType, mix.mDeviceAddress.c_str());
                 removeAt(i);
+                invalidateOutputMixIndex();
                 return NO_ERROR;
             }
         } else {
@@ -234,6 +235,7 @@ status_t AudioPolicyMixCollection::unregisterMix(const AudioMix& mix)
                 ALOGD("unregisterMix(): removing mix for dev=0x%x addr=%s",
                       mix.mDeviceType, mix.mDeviceAddress.c_str());
                 removeAt(i);
+                invalidateOutputMixIndex();
                 return NO_ERROR;
             }
         }
@@ -258,6 +260,7 @@ status_t AudioPolicyMixCollection::updateMix(
             mix.mDeviceAddress.compare(registeredMix->mDeviceAddress) == 0 &&
             mix.mRouteFlags == registeredMix->mRouteFlags) {
             registeredMix->mCriteria = updatedCriteria;
+            invalidateOutputMixIndex();
             ALOGV("updateMix(): updated mix for dev=0x%x addr=%s", mix.mDeviceType,
                   mix.mDeviceAddress.c_str());
             return NO_ERROR;
@@ -331,11 +334,13 @@ status_t AudioPolicyMixCollection::getOutputForAttr(
         std::vector<sp<AudioPolicyMix>> *secondaryMixes,
         bool& usePrimaryOutputFromPolicyMixes)
 {
-    ALOGV("getOutputForAttr() querying %zu mixes:", size());
     primaryMix.clear();
     bool mixesDisallowsRequestedDevice = false;
     const bool isMmapRequested = (flags & AUDIO_OUTPUT_FLAG_MMAP_NOIRQ);
-    for (size_t i = 0; i < size(); i++) {
+    const std::optional<std::string> tagAddress = extractAddressFromAudioAttributes(attributes);
+    const std::vector<size_t>& candidates = getOutputMixCandidates(attributes, tagAddress, uid);
+    ALOGV("getOutputForAttr() querying %zu of %zu mixes:", candidates.size(), size());
+    for (size_t i : candidates) {
         sp<AudioPolicyMix> policyMix = itemAt(i);
         const bool primaryOutputMix = !is_mix_loopback_render(policyMix->mRouteFlags);
         sp<DeviceDescriptor> mixDevice = getOutputDeviceForMix(policyMix.get(),
@@ -361,7 +366,7 @@ status_t AudioPolicyMixCollection::getOutputForAttr(
             continue; // Primary output already found
         }
 
-        if(!mixMatch(policyMix.get(), i, attributes, flags, config, uid, session)) {
+        if(!mixMatch(policyMix.get(), i, attributes, tagAddress, flags, config, uid, session)) {
             ALOGV("%s: Mix %zu: does not match", __func__, i);
             continue; // skip the mix
         }
@@ -422,8 +427,9 @@ bool AudioPolicyMixCollection::mixDisallowsRequestedDevice(const AudioMix* mix,
 }
 
 bool AudioPolicyMixCollection::mixMatch(const AudioMix* mix, size_t mixIndex,
-    const audio_attributes_t& attributes, const audio_output_flags_t outputFlags,
-    const audio_config_base_t& config, uid_t uid, audio_session_t session) {
+    const audio_attributes_t& attributes, const std::optional<std::string>& tagAddress,
+    const audio_output_flags_t outputFlags, const audio_config_base_t& config, uid_t uid,
+    audio_session_t session) {
 
     if (mix->mMixType == MIX_TYPE_PLAYERS) {
         // Permit match only if requested format and mix format are PCM and can be format
@@ -441,20 +447,96 @@ bool AudioPolicyMixCollection::mixMatch(const AudioMix* mix, size_t mixIndex,
         }
 
         // if there is an address match, prioritize that match
-        if (matchAddressToTags(attributes, mix->mDeviceAddress)
+        if (matchAddressToTags(tagAddress, mix->mDeviceAddress)
             || areMixCriteriaMatched(mix->mCriteria, attributes, uid, session)) {
                 ALOGV("\tgetOutputForAttr will use mix %zu", mixIndex);
                 return true;
         }
     } else if (mix->mMixType == MIX_TYPE_RECORDERS) {
         if (attributes.usage == AUDIO_USAGE_VIRTUAL_SOURCE &&
-            matchAddressToTags(attributes, mix->mDeviceAddress)) {
+            matchAddressToTags(tagAddress, mix->mDeviceAddress)) {
             return true;
         }
     }
     return false;
 }
 
+void AudioPolicyMixCollection::buildOutputMixIndex()
+{
+    mAlwaysCandidates.clear();
+    mCandidatesByUsage.clear();
+    mCandidatesBySource.clear();
+    mCandidatesByUid.clear();
+    mCandidatesByAddress.clear();
+    for (size_t i = 0; i < size(); i++) {
+        const AudioPolicyMix* mix = itemAt(i).get();
+        // Any mix may match by the address in the tags, see mixMatch().
+        mCandidatesByAddress[mix->mDeviceAddress.c_str()].push_back(i);
+        if (is_mix_loopback_render(mix->mRouteFlags)
+                || is_mix_disallows_preferred_device(mix->mRouteFlags)) {
+            // Considered even when not matching.
+            mAlwaysCandidates.push_back(i);
+            continue;
+        }
+        if (mix->mMixType != MIX_TYPE_PLAYERS) {
+            continue;  // recorder mixes only match by address
+        }
+        // Positive rules of a given kind must have one matching for the criteria to match,
+        // see areMixCriteriaMatched(). Key the mix on the first kind present.
+        auto positiveRules = [mix](uint32_t rule) {
+            std::vector<AudioMixMatchCriterion> rules;
+            std::copy_if(mix->mCriteria.begin(), mix->mCriteria.end(),
+                         std::back_inserter(rules),
+                         [rule](const AudioMixMatchCriterion& c) { return c.mRule == rule; });
+            return rules;
+        };
+        if (auto rules = positiveRules(RULE_MATCH_ATTRIBUTE_USAGE); !rules.empty()) {
+            for (const auto& rule : rules) {
+                mCandidatesByUsage[rule.mValue.mUsage].push_back(i);
+            }
+        } else if (rules = positiveRules(RULE_MATCH_ATTRIBUTE_CAPTURE_PRESET); !rules.empty()) {
+            for (const auto& rule : rules) {
+                mCandidatesBySource[rule.mValue.mSource].push_back(i);
+            }
+        } else if (rules = positiveRules(RULE_MATCH_UID); !rules.empty()) {
+            for (const auto& rule : rules) {
+                mCandidatesByUid[rule.mValue.mUid].push_back(i);
+            }
+        } else {
+            mAlwaysCandidates.push_back(i);
+        }
+    }
+    mIndexedMixes = size();
+    mOutputMixIndexValid = true;
+    ALOGV("%s: %zu mixes, %zu always considered", __func__, size(), mAlwaysCandidates.size());
+}
+
+const std::vector<size_t>& AudioPolicyMixCollection::getOutputMixCandidates(
+        const audio_attributes_t& attributes, const std::optional<std::string>& tagAddress,
+        uid_t uid)
+{
+    // Mixes are also added and removed through the Vector interface.
+    if (!mOutputMixIndexValid || mIndexedMixes != size()) {
+        buildOutputMixIndex();
+    }
+    mCandidates = mAlwaysCandidates;
+    auto addCandidates = [this](const auto& candidatesByKey, const auto& key) {
+        if (const auto it = candidatesByKey.find(key); it != candidatesByKey.end()) {
+            mCandidates.insert(mCandidates.end(), it->second.begin(), it->second.end());
+        }
+    };
+    addCandidates(mCandidatesByUsage, attributes.usage);
+    addCandidates(mCandidatesBySource, attributes.source);
+    addCandidates(mCandidatesByUid, uid);
+    if (tagAddress.has_value()) {
+        addCandidates(mCandidatesByAddress, *tagAddress);
+    }
+    // Mixes are considered in the order of the collection, the first matching one wins.
+    std::sort(mCandidates.begin(), mCandidates.end());
+    mCandidates.erase(std::unique(mCandidates.begin(), mCandidates.end()), mCandidates.end());
+    return mCandidates;
+}
+
 sp<DeviceDescriptor> AudioPolicyMixCollection::getDeviceAndMixForOutput(
         const sp<SwAudioOutputDescriptor> &output,
         const DeviceVector &availableOutputDevices)
@@ -585,6 +667,7 @@ status_t AudioPolicyMixCollection::setUidDeviceAffinities(uid_t uid,
         }
     }
 
+    invalidateOutputMixIndex();
     return NO_ERROR;
 }
 
@@ -602,6 +685,7 @@ status_t AudioPolicyMixCollection::removeUidDeviceAffinities(uid_t uid) {
             return c.mRule == RULE_EXCLUDE_UID && c.mValue.mUid == uid;
         });
     }
+    invalidateOutputMixIndex();
     return NO_ERROR;
 }
 
@@ -677,6 +761,7 @@ status_t AudioPolicyMixCollection::setUserIdDeviceAffinities(int userId,
         }
     }
 
+    invalidateOutputMixIndex();
     return NO_ERROR;
 }
 
@@ -698,6 +783,7 @@ status_t AudioPolicyMixCollection::removeUserIdDeviceAffinities(int userId) {
             mix->mRouteFlags = mix->mRouteFlags & ~MIX_ROUTE_FLAG_DISALLOWS_PREFERRED_DEVICE;
         }
     }
+    invalidateOutputMixIndex();
     return NO_ERROR;
 }
 
@@ -45,6 +45,7 @@ public:
     status_t setForceUse(audio_policy_force_use_t usage, audio_policy_forced_cfg_t config) override
     {
         mForceUse[usage] = config;
+        ++mDeviceSelectionGeneration;
         return NO_ERROR;
     }
 
@@ -178,6 +179,14 @@ public:
 
     void updateDeviceSelectionCache() override;
 
+    void beginDeviceSelectionBatch() override;
+
+    void endDeviceSelectionBatch() override;
+
+    void invalidateDeviceSelection() override { ++mDeviceSelectionGeneration; }
+
+    DeviceSelectionCacheStats getDeviceSelectionCacheStats() const override;
+
     engineConfig::ParsingResult parseAndSetDefaultConfiguration();
 
 protected:
@@ -217,6 +226,18 @@ private:
     /** current forced use configuration. */
     audio_policy_forced_cfg_t mForceUse[AUDIO_POLICY_FORCE_USE_CNT] = {};
 
+    /**
+     * bumped when an input of the device selection changes: the phone state, the forced usages,
+     * the device roles of strategies, the last removable devices, or any of the policy manager
+     * state reported by invalidateDeviceSelection().
+     */
+    uint64_t mDeviceSelectionGeneration = 0;
+    int mDeviceSelectionBatchDepth = 0;
+    /** generation of the memoized selection. */
+    mutable uint64_t mMemoizedDeviceSelectionGeneration = 0;
+    mutable DeviceStrategyMap mMemoizedDevicesForStrategies;
+    mutable DeviceSelectionCacheStats mDeviceSelectionCacheStats;
+
 protected:
     /**
      * Set the device information for a given strategy.
@@ -237,6 +258,13 @@ protected:
      */
     virtual DeviceVector getDevicesForProductStrategy(product_strategy_t strategy) const = 0;
 
+    /**
+     * Same as getDevicesForProductStrategy(), memoized within a device selection batch.
+     *
+     * @param strategy the strategy to query
+     */
+    DeviceVector getMemoizedDevicesForProductStrategy(product_strategy_t strategy) const;
+
     sp<DeviceDescriptor> getInputDeviceForEchoRef(const audio_attributes_t &attr,
             const DeviceVector &availableInputDevices) const;
 
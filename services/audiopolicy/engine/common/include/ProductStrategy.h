@@ -20,6 +20,7 @@
 
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -117,7 +118,9 @@ class ProductStrategyMap : public std::map<product_strategy_t, sp<ProductStrateg
 {
 public:
     /**
-     * @brief initialize: set default product strategy in cache.
+     * @brief initialize: set default product strategy in cache and index the attributes of all
+     *        strategies for getProductStrategyForAttributes() and the volume group queries.
+     *        Must be called again once the strategies have been changed.
      */
     void initialize();
     /**
@@ -166,7 +169,32 @@ private:
     VolumeGroupAttributes getVolumeGroupAttributesForAttributes(
             const audio_attributes_t &attr, bool fallbackOnDefault = true) const;
 
+    /**
+     * An attributes entry of a strategy, in the order getProductStrategyForAttributes()
+     * considers them: strategies by id, then attributes in their order within the strategy.
+     */
+    struct IndexedAttributes {
+        product_strategy_t strategy;
+        VolumeGroupAttributes volumeGroupAttributes;
+    };
+
+    void buildIndex();
+    bool isIndexValid() const { return mIndexedStrategies == size() && !mIndex.empty(); }
+
+    /**
+     * @brief findBestIndexedAttributes returns the index in mIndex of the first entry with the
+     *        highest matching score for the given attributes, or -1 if none matches.
+     *        An entry whose usage is neither unknown nor the one of the attributes never
+     *        matches, so only the entries of these two usages are scored.
+     */
+    ssize_t findBestIndexedAttributes(const audio_attributes_t &attr, int *score) const;
+
     product_strategy_t mDefaultStrategy = PRODUCT_STRATEGY_NONE;
+
+    std::vector<IndexedAttributes> mIndex;
+    /** Positions in mIndex of the entries per usage, in increasing order. */
+    std::unordered_map<audio_usage_t, std::vector<size_t>> mIndexByUsage;
+    size_t mIndexedStrategies = 0;
 };
 
 using ProductStrategyDevicesRoleMap =
@@ -17,6 +17,8 @@
 #define LOG_TAG "APM::AudioPolicyEngine/Base"
 //#define LOG_NDEBUG 0
 
+#include <algorithm>
+#include <cinttypes>
 #include <functional>
 #include <string>
 #include <sys/stat.h>
@@ -57,6 +59,7 @@ status_t EngineBase::setPhoneState(audio_mode_t state)
     // store previous phone state for management of sonification strategy below
     int oldState = mPhoneState;
     mPhoneState = state;
+    ++mDeviceSelectionGeneration;
 
     if (!is_state_in_call(oldState) && is_state_in_call(state)) {
         ALOGV("  Entering call in setPhoneState()");
@@ -80,6 +83,7 @@ status_t EngineBase::setDeviceConnectionState(const sp<DeviceDescriptor> devDesc
         // LE audio broadcast device has a specific policy depending on active strategies and
         // devices and does not follow the rule of last connected removable device.
         mLastRemovableMediaDevices.setRemovableMediaDevices(devDesc, state);
+        ++mDeviceSelectionGeneration;
     }
 
     return NO_ERROR;
@@ -569,6 +573,7 @@ status_t EngineBase::setDevicesRoleForStrategy(product_strategy_t strategy, devi
     std::function<bool(product_strategy_t)> p = [this](product_strategy_t strategy) {
         return mProductStrategies.find(strategy) != mProductStrategies.end();
     };
+    ++mDeviceSelectionGeneration;
     return setDevicesRoleForT(
             mProductStrategyDeviceRoleMap, strategy, role, devices, "strategy" /*logStr*/, p);
 }
@@ -579,6 +584,7 @@ status_t EngineBase::removeDevicesRoleForStrategy(product_strategy_t strategy, d
     std::function<bool(product_strategy_t)> p = [this](product_strategy_t strategy) {
         return mProductStrategies.find(strategy) != mProductStrategies.end();
     };
+    ++mDeviceSelectionGeneration;
     return removeDevicesRoleForT(
             mProductStrategyDeviceRoleMap, strategy, role, devices, "strategy" /*logStr*/, p);
 }
@@ -589,6 +595,7 @@ status_t EngineBase::clearDevicesRoleForStrategy(product_strategy_t strategy,
     std::function<bool(product_strategy_t)> p = [this](product_strategy_t strategy) {
         return mProductStrategies.find(strategy) != mProductStrategies.end();
     };
+    ++mDeviceSelectionGeneration;
     return removeAllDevicesRoleForT(
             mProductStrategyDeviceRoleMap, strategy, role, "strategy" /*logStr*/, p);
 }
@@ -769,12 +776,51 @@ void EngineBase::updateDeviceSelectionCache() {
         if (strategy->isPatchStrategy()) {
             continue;
         }
-        auto devices = getDevicesForProductStrategy(strategy->getId());
+        auto devices = getMemoizedDevicesForProductStrategy(strategy->getId());
         mDevicesForStrategies[strategy->getId()] = devices;
         setStrategyDevices(strategy, devices);
     }
 }
 
+void EngineBase::beginDeviceSelectionBatch() {
+    ++mDeviceSelectionBatchDepth;
+}
+
+void EngineBase::endDeviceSelectionBatch() {
+    ALOG_ASSERT(mDeviceSelectionBatchDepth > 0, "%s without begin", __func__);
+    if (--mDeviceSelectionBatchDepth == 0) {
+        // The selection also depends on how recently outputs were active, which the generation
+        // does not capture: do not carry it over to the next batch.
+        mMemoizedDevicesForStrategies.clear();
+    }
+}
+
+DeviceSelectionCacheStats EngineBase::getDeviceSelectionCacheStats() const {
+    return mDeviceSelectionCacheStats;
+}
+
+DeviceVector EngineBase::getMemoizedDevicesForProductStrategy(product_strategy_t strategy) const {
+    if (mDeviceSelectionBatchDepth == 0) {
+        return getDevicesForProductStrategy(strategy);
+    }
+    if (mDeviceSelectionGeneration != mMemoizedDeviceSelectionGeneration) {
+        if (!mMemoizedDevicesForStrategies.empty()) {
+            mMemoizedDevicesForStrategies.clear();
+            mDeviceSelectionCacheStats.invalidations++;
+        }
+        mMemoizedDeviceSelectionGeneration = mDeviceSelectionGeneration;
+    }
+    if (auto it = mMemoizedDevicesForStrategies.find(strategy);
+            it != mMemoizedDevicesForStrategies.end()) {
+        mDeviceSelectionCacheStats.hits++;
+        return it->second;
+    }
+    mDeviceSelectionCacheStats.misses++;
+    DeviceVector devices = getDevicesForProductStrategy(strategy);
+    mMemoizedDevicesForStrategies[strategy] = devices;
+    return devices;
+}
+
 DeviceVector EngineBase::getPreferredAvailableDevicesForProductStrategy(
         const DeviceVector& availableOutputDevices, product_strategy_t strategy) const {
     DeviceVector preferredAvailableDevVec = {};
@@ -859,6 +905,11 @@ void EngineBase::dump(String8 *dst) const
     dumpProductStrategyDevicesRoleMap(mProductStrategyDeviceRoleMap, dst, 2);
     dumpCapturePresetDevicesRoleMap(dst, 2);
     mVolumeGroups.dump(dst, 2);
+    const DeviceSelectionCacheStats &stats = mDeviceSelectionCacheStats;
+    const uint64_t lookups = stats.hits + stats.misses;
+    dst->appendFormat("  Device selection cache: %" PRIu64 " lookups, %" PRIu64
+            " hits (%.1f%%), %" PRIu64 " invalidations\n", lookups, stats.hits,
+            lookups != 0 ? 100. * stats.hits / lookups : 0., stats.invalidations);
 }
 
 } // namespace audio_policy
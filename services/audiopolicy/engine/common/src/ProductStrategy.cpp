@@ -159,6 +159,14 @@ product_strategy_t ProductStrategyMap::getProductStrategyForAttributes(
 {
     product_strategy_t bestStrategyOrdefault = PRODUCT_STRATEGY_NONE;
     int matchScore = AudioProductStrategy::NO_MATCH;
+    if (isIndexValid()) {
+        const ssize_t best = findBestIndexedAttributes(attributes, &matchScore);
+        if (best >= 0) {
+            bestStrategyOrdefault = mIndex[best].strategy;
+        }
+        return (matchScore != AudioProductStrategy::MATCH_ON_DEFAULT_SCORE || fallbackOnDefault) ?
+                bestStrategyOrdefault : PRODUCT_STRATEGY_NONE;
+    }
     for (const auto &iter : *this) {
         int score = iter.second->matchesScore(attributes);
         if (score == AudioProductStrategy::MATCH_EQUALS) {
@@ -255,6 +263,14 @@ VolumeGroupAttributes ProductStrategyMap::getVolumeGroupAttributesForAttributes(
 {
     int matchScore = AudioProductStrategy::NO_MATCH;
     VolumeGroupAttributes bestVolumeGroupAttributes = {};
+    if (isIndexValid()) {
+        const ssize_t best = findBestIndexedAttributes(attr, &matchScore);
+        if (best >= 0) {
+            bestVolumeGroupAttributes = mIndex[best].volumeGroupAttributes;
+        }
+        return (matchScore != AudioProductStrategy::MATCH_ON_DEFAULT_SCORE || fallbackOnDefault) ?
+                bestVolumeGroupAttributes : VolumeGroupAttributes();
+    }
     for (const auto &iter : *this) {
         for (const auto &volGroupAttr : iter.second->getVolumeGroupAttributes()) {
             int score = volGroupAttr.matchesScore(attr);
@@ -312,6 +328,54 @@ void ProductStrategyMap::initialize()
     mDefaultStrategy = PRODUCT_STRATEGY_NONE;
     mDefaultStrategy = getDefault();
     ALOG_ASSERT(mDefaultStrategy != PRODUCT_STRATEGY_NONE, "No default product strategy found");
+    buildIndex();
+}
+
+void ProductStrategyMap::buildIndex()
+{
+    mIndex.clear();
+    mIndexByUsage.clear();
+    for (const auto &iter : *this) {
+        for (const auto &volGroupAttr : iter.second->getVolumeGroupAttributes()) {
+            mIndexByUsage[volGroupAttr.getAttributes().usage].push_back(mIndex.size());
+            mIndex.push_back({iter.second->getId(), volGroupAttr});
+        }
+    }
+    mIndexedStrategies = size();
+    ALOGV("%s: %zu attributes of %zu strategies in %zu usages", __func__,
+          mIndex.size(), mIndexedStrategies, mIndexByUsage.size());
+}
+
+ssize_t ProductStrategyMap::findBestIndexedAttributes(
+        const audio_attributes_t &attr, int *score) const
+{
+    // Same outcome as scoring all entries in order and keeping the first best one: the first
+    // MATCH_EQUALS is the first entry with the highest possible score.
+    ssize_t best = -1;
+    *score = AudioProductStrategy::NO_MATCH;
+    auto scoreEntries = [&](audio_usage_t usage) {
+        const auto entries = mIndexByUsage.find(usage);
+        if (entries == mIndexByUsage.end()) {
+            return;
+        }
+        for (size_t position : entries->second) {
+            if (best >= 0 && *score == AudioProductStrategy::MATCH_EQUALS
+                    && position > static_cast<size_t>(best)) {
+                break;
+            }
+            const int entryScore = mIndex[position].volumeGroupAttributes.matchesScore(attr);
+            if (entryScore > *score || (entryScore == *score && entryScore
+                    != AudioProductStrategy::NO_MATCH && position < static_cast<size_t>(best))) {
+                *score = entryScore;
+                best = position;
+            }
+        }
+    };
+    scoreEntries(AUDIO_USAGE_UNKNOWN);
+    if (attr.usage != AUDIO_USAGE_UNKNOWN) {
+        scoreEntries(attr.usage);
+    }
+    return best;
 }
 
 void ProductStrategyMap::dump(String8 *dst, int spaces) const
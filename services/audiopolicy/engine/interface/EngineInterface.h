@@ -41,6 +41,16 @@ using VolumeGroupVector = std::vector<volume_group_t>;
 using CapturePresetDevicesRoleMap =
         std::map<std::pair<audio_source_t, device_role_t>, AudioDeviceTypeAddrVector>;
 
+/**
+ * Counters of the device selection memoized during routing evaluations,
+ * see EngineInterface::beginDeviceSelectionBatch().
+ */
+struct DeviceSelectionCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t invalidations = 0;  // a change of inputs discarded the memoized selection
+};
+
 /**
  * This interface is dedicated to the policy manager that a Policy Engine shall implement.
  */
@@ -253,6 +263,32 @@ public:
      */
     virtual void updateDeviceSelectionCache() = 0;
 
+    /**
+     * @brief beginDeviceSelectionBatch / endDeviceSelectionBatch bracket a routing evaluation,
+     * such as handling a device connection or a phone state change, during which the same device
+     * selection is queried many times by the policy manager.
+     * Within a batch, the devices selected for a product strategy (the fromCache == false path)
+     * are memoized until an input of the selection changes: the phone state, the forced usages,
+     * the device roles, or the policy manager state reported by invalidateDeviceSelection().
+     * Outside of a batch, the selection is always computed, as it also depends on the recent
+     * activity of the outputs. Batches can be nested.
+     */
+    virtual void beginDeviceSelectionBatch() = 0;
+    virtual void endDeviceSelectionBatch() = 0;
+
+    /**
+     * @brief invalidateDeviceSelection is called by the policy manager when its own inputs of the
+     * device selection change: the available output devices, the outputs opened, their devices
+     * or their active clients. It discards the selection memoized in the current batch.
+     */
+    virtual void invalidateDeviceSelection() = 0;
+
+    /**
+     * @brief getDeviceSelectionCacheStats
+     * @return the counters of the device selection memoized within batches.
+     */
+    virtual DeviceSelectionCacheStats getDeviceSelectionCacheStats() const = 0;
+
     /**
      * @brief listAudioProductStrategies. Introspection API to retrieve a collection of
      * AudioProductStrategyVector that allows to build AudioAttributes according to a
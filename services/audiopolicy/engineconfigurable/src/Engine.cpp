@@ -489,7 +489,7 @@ DeviceVector Engine::getOutputDevicesForAttributes(const audio_attributes_t &att
     if (device != nullptr) {
         return DeviceVector(device);
     }
-    return fromCache? getCachedDevices(strategy) : getDevicesForProductStrategy(strategy);
+    return fromCache? getCachedDevices(strategy) : getMemoizedDevicesForProductStrategy(strategy);
 }
 
 DeviceVector Engine::getCachedDevices(product_strategy_t ps) const
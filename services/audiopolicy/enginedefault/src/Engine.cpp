@@ -864,7 +864,8 @@ DeviceVector Engine::getOutputDevicesForAttributes(const audio_attributes_t &att
         return DeviceVector(device);
     }
 
-    return fromCache? mDevicesForStrategies.at(strategy) : getDevicesForProductStrategy(strategy);
+    return fromCache? mDevicesForStrategies.at(strategy) :
+                      getMemoizedDevicesForProductStrategy(strategy);
 }
 
 DeviceVector Engine::getOutputDevicesForStream(audio_stream_type_t stream, bool fromCache) const
@@ -193,6 +193,7 @@ status_t AudioPolicyManager::setDeviceConnectionStateInt(const sp<DeviceDescript
                                                          audio_policy_dev_state_t state,
                                                          bool deviceSwitch)
 {
+    DeviceSelectionBatch deviceSelectionBatch(mEngine.get());
     // handle output devices
     if (audio_is_output_device(device->type())) {
         SortedVector <audio_io_handle_t> outputs;
@@ -217,7 +218,7 @@ status_t AudioPolicyManager::setDeviceConnectionStateInt(const sp<DeviceDescript
                     __func__, device->toString().c_str(), device->getEncodedFormat());
 
             // register new device as available
-            if (mAvailableOutputDevices.add(device) < 0) {
+            if (addAvailableOutputDevice(device) < 0) {
                 return NO_MEMORY;
             }
 
@@ -225,7 +226,7 @@ status_t AudioPolicyManager::setDeviceConnectionStateInt(const sp<DeviceDescript
             // parameters on newly connected devices (instead of opening the outputs...)
             if (broadcastDeviceConnectionState(
                         device, media::DeviceConnectedState::CONNECTED) != NO_ERROR) {
-                mAvailableOutputDevices.remove(device);
+                removeAvailableOutputDevice(device);
                 mHwModules.cleanUpForDevice(device);
                 ALOGE("%s() device %s format %x connection failed", __func__,
                       device->toString().c_str(), device->getEncodedFormat());
@@ -233,7 +234,7 @@ status_t AudioPolicyManager::setDeviceConnectionStateInt(const sp<DeviceDescript
             }
 
             if (checkOutputsForDevice(device, state, outputs) != NO_ERROR) {
-                mAvailableOutputDevices.remove(device);
+                removeAvailableOutputDevice(device);
 
                 broadcastDeviceConnectionState(device, media::DeviceConnectedState::DISCONNECTED);
 
@@ -265,7 +266,7 @@ status_t AudioPolicyManager::setDeviceConnectionStateInt(const sp<DeviceDescript
                     device, media::DeviceConnectedState::PREPARE_TO_DISCONNECT);
 
             // remove device from available output devices
-            mAvailableOutputDevices.remove(device);
+            removeAvailableOutputDevice(device);
 
             mOutputs.clearSessionRoutesForDevice(device);
 
@@ -939,6 +940,7 @@ void AudioPolicyManager::connectTelephonyTxAudioSource(
 void AudioPolicyManager::setPhoneState(audio_mode_t state)
 {
     ALOGV("setPhoneState() state %d", state);
+    DeviceSelectionBatch deviceSelectionBatch(mEngine.get());
     // store previous phone state for management of sonification strategy below
     int oldState = mEngine->getPhoneState();
     bool wasLeUnicastActive = isLeUnicastActive();
@@ -1054,6 +1056,7 @@ void AudioPolicyManager::setForceUse(audio_policy_force_use_t usage,
         return;
     }
 
+    DeviceSelectionBatch deviceSelectionBatch(mEngine.get());
     if (mEngine->setForceUse(usage, config) != NO_ERROR) {
         ALOGW("setForceUse() could not set force cfg %d for usage %d", config, usage);
         return;
@@ -2562,6 +2565,7 @@ status_t AudioPolicyManager::startSource(const sp<SwAudioOutputDescriptor>& outp
     // NOTE that the usage count is the same for duplicated output and hardware output which is
     // necessary for a correct control of hardware output routing by startOutput() and stopOutput()
     outputDesc->setClientActive(client, true);
+    mEngine->invalidateDeviceSelection();
 
     if (client->hasPreferredDevice(true)) {
         if (outputDesc->sameExclusivePreferredDevicesCount() > 0) {
@@ -2836,6 +2840,7 @@ status_t AudioPolicyManager::stopSource(const sp<SwAudioOutputDescriptor>& outpu
 
         // decrement usage count of this stream on the output
         outputDesc->setClientActive(client, false);
+        mEngine->invalidateDeviceSelection();
 
         // store time at which the stream was stopped - see isStreamActive()
         if (outputDesc->getActivityCount(clientVolSrc) == 0 || forceDeviceUpdate) {
@@ -6942,7 +6947,7 @@ void AudioPolicyManager::onNewAudioModulesAvailableInt(DeviceVector *newDevices)
                 // give a valid ID to an attached device once confirmed it is reachable
                 if (!device->isAttached()) {
                     device->attach(hwModule);
-                    mAvailableOutputDevices.add(device);
+                    addAvailableOutputDevice(device);
                     device->setEncapsulationInfoFromHal(mpClientInterface);
                     if (newDevices) newDevices->add(device);
                     setEngineDeviceConnectionState(device, AUDIO_POLICY_DEVICE_STATE_AVAILABLE);
@@ -7051,6 +7056,7 @@ void AudioPolicyManager::addOutput(audio_io_handle_t output,
                                    const sp<SwAudioOutputDescriptor>& outputDesc)
 {
     mOutputs.add(output, outputDesc);
+    mEngine->invalidateDeviceSelection();
     applyStreamVolumes(outputDesc, DeviceTypeSet(), 0 /* delayMs */, true /* force */);
     updateMono(output); // update mono status when adding to output list
     selectOutputForMusicEffects();
@@ -7064,9 +7070,22 @@ void AudioPolicyManager::removeOutput(audio_io_handle_t output)
         mPrimaryOutput = nullptr;
     }
     mOutputs.removeItem(output);
+    mEngine->invalidateDeviceSelection();
     selectOutputForMusicEffects();
 }
 
+ssize_t AudioPolicyManager::addAvailableOutputDevice(const sp<DeviceDescriptor>& device)
+{
+    mEngine->invalidateDeviceSelection();
+    return mAvailableOutputDevices.add(device);
+}
+
+ssize_t AudioPolicyManager::removeAvailableOutputDevice(const sp<DeviceDescriptor>& device)
+{
+    mEngine->invalidateDeviceSelection();
+    return mAvailableOutputDevices.remove(device);
+}
+
 void AudioPolicyManager::addInput(audio_io_handle_t input,
                                   const sp<AudioInputDescriptor>& inputDesc)
 {
@@ -7409,6 +7428,7 @@ void AudioPolicyManager::closeOutput(audio_io_handle_t output)
             const bool wasActive = remainingOutput->isActive();
             // Note: no-op on the closing output where all clients has already been set inactive
             dupOutput->setAllClientsInactive();
+            mEngine->invalidateDeviceSelection();
             // stop() will be a no op if the output is still active but is needed in case all
             // active streams refcounts where cleared above
             if (wasActive) {
@@ -7530,6 +7550,7 @@ SortedVector<audio_io_handle_t> AudioPolicyManager::getOutputsForDevices(
 
 void AudioPolicyManager::checkForDeviceAndOutputChanges(std::function<bool()> onOutputsChecked)
 {
+    DeviceSelectionBatch deviceSelectionBatch(mEngine.get());
     // checkA2dpSuspend must run before checkOutputForAllStrategies so that A2DP
     // output is suspended before any tracks are moved to it
     checkA2dpSuspend();
@@ -8195,6 +8216,7 @@ uint32_t AudioPolicyManager::setOutputDevices(const char *caller,
 
     if (!filteredDevices.isEmpty()) {
         outputDesc->setDevices(filteredDevices);
+        mEngine->invalidateDeviceSelection();
     }
 
     // if the outputs are not materially active, there is no need to mute.
@@ -8216,6 +8238,7 @@ uint32_t AudioPolicyManager::setOutputDevices(const char *caller,
               devices.toString().c_str());
         // restore previous device after evaluating strategy mute state
         outputDesc->setDevices(prevDevices);
+        mEngine->invalidateDeviceSelection();
         applyStreamVolumes(outputDesc, prevDevices.types(), delayMs, true /*force*/);
         return muteWaitMs;
     }
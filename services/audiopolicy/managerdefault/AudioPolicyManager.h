@@ -544,6 +544,10 @@ protected:
 
         void addOutput(audio_io_handle_t output, const sp<SwAudioOutputDescriptor>& outputDesc);
         void removeOutput(audio_io_handle_t output);
+        // Only change mAvailableOutputDevices through these, they invalidate the device
+        // selection memoized by the engine.
+        ssize_t addAvailableOutputDevice(const sp<DeviceDescriptor>& device);
+        ssize_t removeAvailableOutputDevice(const sp<DeviceDescriptor>& device);
         void addInput(audio_io_handle_t input, const sp<AudioInputDescriptor>& inputDesc);
         bool checkCloseInput(const sp<AudioInputDescriptor>& input);
 
@@ -713,6 +717,21 @@ protected:
         // A2DP suspend status is rechecked.
         void checkForDeviceAndOutputChanges(std::function<bool()> onOutputsChecked = nullptr);
 
+        // Memoizes the engine device selection while in scope, so that the routing evaluation
+        // of an event queries it once per product strategy. See
+        // EngineInterface::beginDeviceSelectionBatch().
+        class DeviceSelectionBatch {
+        public:
+            explicit DeviceSelectionBatch(EngineInterface *engine) : mEngine(engine) {
+                mEngine->beginDeviceSelectionBatch();
+            }
+            ~DeviceSelectionBatch() { mEngine->endDeviceSelectionBatch(); }
+            DeviceSelectionBatch(const DeviceSelectionBatch&) = delete;
+            DeviceSelectionBatch& operator=(const DeviceSelectionBatch&) = delete;
+        private:
+            EngineInterface * const mEngine;
+        };
+
         /**
          * @brief updates routing for all outputs (including call if call in progress).
          * @param delayMs delay for unmuting if required
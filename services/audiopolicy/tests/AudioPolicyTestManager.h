@@ -49,6 +49,15 @@ class AudioPolicyTestManager : public AudioPolicyManager {
     using AudioPolicyManager::getInputProfile;
     uint32_t getAudioPortGeneration() const { return mAudioPortGeneration; }
     HwModuleCollection getHwModules() const { return mHwModules; }
+    DeviceSelectionCacheStats getDeviceSelectionCacheStats() const {
+        return mEngine->getDeviceSelectionCacheStats();
+    }
+    void beginDeviceSelectionBatch() { mEngine->beginDeviceSelectionBatch(); }
+    void endDeviceSelectionBatch() { mEngine->endDeviceSelectionBatch(); }
+    DeviceVector getEngineOutputDevicesForAttributes(const audio_attributes_t& attr,
+            bool fromCache) const {
+        return mEngine->getOutputDevicesForAttributes(attr, nullptr, fromCache);
+    }
 };
 
 }  // namespace android
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "audiopolicy_config_benchmark"
+
+#include <string>
+
+#include <AudioPolicyConfig.h>
+#include <android-base/file.h>
+#include <benchmark/benchmark.h>
+
+using namespace android;
+
+namespace {
+
+constexpr const char* kConfigFiles[] = {
+        "test_audio_policy_configuration.xml",
+        "test_audio_policy_primary_only_configuration.xml",
+        "test_car_ap_atmos_offload_configuration.xml",
+        "test_phone_apm_configuration.xml",
+        "test_settop_box_surround_configuration.xml",
+        "test_tv_apm_configuration.xml",
+};
+
+std::string configPath(int64_t index) {
+    return base::GetExecutableDirectory() + "/" + kConfigFiles[index];
+}
+
+void configArgs(benchmark::internal::Benchmark* b) {
+    for (size_t i = 0; i < std::size(kConfigFiles); ++i) {
+        b->Arg(i);
+    }
+}
+
+// Argument: index of the configuration file. Cold start parsing the XML configuration.
+void BM_LoadFromXml(benchmark::State& state) {
+    const std::string source = configPath(state.range(0));
+    state.SetLabel(kConfigFiles[state.range(0)]);
+    for (auto _ : state) {
+        auto config = AudioPolicyConfig::loadFromCustomXmlConfigForTests(source);
+        if (!config.ok()) {
+            state.SkipWithError("cannot load the configuration");
+            break;
+        }
+        benchmark::DoNotOptimize(config.value());
+    }
+}
+
+// Argument: index of the configuration file. Cold start from a valid snapshot, including the
+// validation of the XML files against it.
+void BM_LoadFromSnapshot(benchmark::State& state) {
+    const std::string source = configPath(state.range(0));
+    state.SetLabel(kConfigFiles[state.range(0)]);
+    TemporaryDir snapshotDir;
+    const std::string snapshot = std::string(snapshotDir.path) + "/config.snapshot";
+    bool fromSnapshot = false;
+    if (!AudioPolicyConfig::loadFromCustomXmlConfigWithSnapshotForTests(
+                source, snapshot, &fromSnapshot).ok()) {
+        state.SkipWithError("cannot load the configuration");
+        return;
+    }
+    for (auto _ : state) {
+        auto config = AudioPolicyConfig::loadFromCustomXmlConfigWithSnapshotForTests(
+                source, snapshot, &fromSnapshot);
+        if (!config.ok() || !fromSnapshot) {
+            state.SkipWithError("cannot load the snapshot");
+            break;
+        }
+        benchmark::DoNotOptimize(config.value());
+    }
+}
+
+BENCHMARK(BM_LoadFromXml)->Apply(configArgs);
+BENCHMARK(BM_LoadFromSnapshot)->Apply(configArgs);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -14,7 +14,9 @@
  * limitations under the License.
  */
 
+#include <cinttypes>
 #include <cstring>
+#include <functional>
 #include <memory>
 #include <string>
 #include <sys/wait.h>
@@ -37,6 +39,7 @@
 #include <media/RecordingActivityTracker.h>
 #include <media/TypeConverter.h>
 #include <utils/Log.h>
+#include <utils/Timers.h>
 #include <utils/Vector.h>
 #include <cutils/multiuser.h>
 
@@ -131,6 +134,176 @@ TEST(AudioPolicyConfigTest, LoadForTests) {
     }
 }
 
+void expectSameDevices(const DeviceVector& expected, const DeviceVector& actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (const auto& device : expected) {
+        SCOPED_TRACE(device->getTagName());
+        auto found = actual.getDeviceFromTagName(device->getTagName());
+        ASSERT_NE(nullptr, found);
+        EXPECT_TRUE(device->equals(found));
+        EXPECT_EQ(device->encodedFormats(), found->encodedFormats());
+    }
+}
+
+void expectSameProfiles(const IOProfileCollection& expected, const IOProfileCollection& actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        SCOPED_TRACE(expected[i]->getName());
+        EXPECT_TRUE(expected[i]->AudioPort::equals(actual[i]));
+        EXPECT_EQ(expected[i]->maxOpenCount, actual[i]->maxOpenCount);
+        EXPECT_EQ(expected[i]->maxActiveCount, actual[i]->maxActiveCount);
+        expectSameDevices(expected[i]->getSupportedDevices(), actual[i]->getSupportedDevices());
+    }
+}
+
+bool isRouteOfPort(const sp<AudioRoute>& route, const sp<PolicyAudioPort>& port) {
+    for (const auto& portRoute : port->getRoutes()) {
+        if (portRoute == route) return true;
+    }
+    return false;
+}
+
+void expectSameRoutes(const AudioRouteVector& expected, const AudioRouteVector& actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        const sp<AudioRoute>& expectedRoute = expected[i];
+        const sp<AudioRoute>& actualRoute = actual[i];
+        SCOPED_TRACE(expectedRoute->getSink()->getTagName());
+        EXPECT_EQ(expectedRoute->getType(), actualRoute->getType());
+        ASSERT_NE(nullptr, actualRoute->getSink());
+        EXPECT_EQ(expectedRoute->getSink()->getTagName(), actualRoute->getSink()->getTagName());
+        EXPECT_TRUE(isRouteOfPort(actualRoute, actualRoute->getSink()));
+        ASSERT_EQ(expectedRoute->getSources().size(), actualRoute->getSources().size());
+        for (size_t j = 0; j < expectedRoute->getSources().size(); ++j) {
+            const sp<PolicyAudioPort>& source = actualRoute->getSources()[j];
+            ASSERT_NE(nullptr, source);
+            EXPECT_EQ(expectedRoute->getSources()[j]->getTagName(), source->getTagName());
+            EXPECT_TRUE(isRouteOfPort(actualRoute, source));
+        }
+    }
+}
+
+void expectSameConfig(const AudioPolicyConfig& expected, const AudioPolicyConfig& actual) {
+    EXPECT_EQ(expected.getSource(), actual.getSource());
+    EXPECT_EQ(expected.getEngineLibraryNameSuffix(), actual.getEngineLibraryNameSuffix());
+    EXPECT_EQ(expected.isCallScreenModeSupported(), actual.isCallScreenModeSupported());
+    EXPECT_EQ(expected.getSurroundFormats(), actual.getSurroundFormats());
+    expectSameDevices(expected.getOutputDevices(), actual.getOutputDevices());
+    expectSameDevices(expected.getInputDevices(), actual.getInputDevices());
+    ASSERT_EQ(expected.getDefaultOutputDevice() == nullptr,
+            actual.getDefaultOutputDevice() == nullptr);
+    if (expected.getDefaultOutputDevice() != nullptr) {
+        EXPECT_TRUE(expected.getDefaultOutputDevice()->equals(actual.getDefaultOutputDevice()));
+    }
+    const HwModuleCollection& expectedModules = expected.getHwModules();
+    const HwModuleCollection& actualModules = actual.getHwModules();
+    ASSERT_EQ(expectedModules.size(), actualModules.size());
+    for (size_t i = 0; i < expectedModules.size(); ++i) {
+        const sp<HwModule>& expectedModule = expectedModules[i];
+        const sp<HwModule>& actualModule = actualModules[i];
+        SCOPED_TRACE(expectedModule->getName());
+        EXPECT_STREQ(expectedModule->getName(), actualModule->getName());
+        EXPECT_EQ(expectedModule->getHalVersionMajor(), actualModule->getHalVersionMajor());
+        EXPECT_EQ(expectedModule->getHalVersionMinor(), actualModule->getHalVersionMinor());
+        expectSameDevices(expectedModule->getDeclaredDevices(), actualModule->getDeclaredDevices());
+        expectSameProfiles(expectedModule->getOutputProfiles(),
+                actualModule->getOutputProfiles());
+        expectSameProfiles(expectedModule->getInputProfiles(), actualModule->getInputProfiles());
+        expectSameRoutes(expectedModule->getRoutes(), actualModule->getRoutes());
+    }
+}
+
+TEST(AudioPolicyConfigTest, SnapshotMatchesXml) {
+    for (const char* file : {"test_audio_policy_configuration.xml",
+                    "test_audio_policy_primary_only_configuration.xml",
+                    "test_car_ap_atmos_offload_configuration.xml",
+                    "test_phone_apm_configuration.xml",
+                    "test_settop_box_surround_configuration.xml",
+                    "test_tv_apm_configuration.xml"}) {
+        SCOPED_TRACE(file);
+        const std::string source = base::GetExecutableDirectory() + "/" + file;
+        TemporaryDir snapshotDir;
+        const std::string snapshot = std::string(snapshotDir.path) + "/config.snapshot";
+        auto xml = AudioPolicyConfig::loadFromCustomXmlConfigForTests(source);
+        ASSERT_TRUE(xml.ok());
+
+        bool fromSnapshot = true;
+        auto saved = AudioPolicyConfig::loadFromCustomXmlConfigWithSnapshotForTests(
+                source, snapshot, &fromSnapshot);
+        ASSERT_TRUE(saved.ok());
+        EXPECT_FALSE(fromSnapshot);
+        ASSERT_NO_FATAL_FAILURE(expectSameConfig(*xml.value(), *saved.value()));
+
+        auto loaded = AudioPolicyConfig::loadFromCustomXmlConfigWithSnapshotForTests(
+                source, snapshot, &fromSnapshot);
+        ASSERT_TRUE(loaded.ok());
+        EXPECT_TRUE(fromSnapshot);
+        ASSERT_NO_FATAL_FAILURE(expectSameConfig(*xml.value(), *loaded.value()));
+    }
+}
+
+TEST(AudioPolicyConfigTest, SnapshotOfAnotherFileIsIgnored) {
+    TemporaryDir snapshotDir;
+    const std::string snapshot = std::string(snapshotDir.path) + "/config.snapshot";
+    bool fromSnapshot = true;
+    ASSERT_TRUE(AudioPolicyConfig::loadFromCustomXmlConfigWithSnapshotForTests(
+            base::GetExecutableDirectory() + "/test_tv_apm_configuration.xml",
+            snapshot, &fromSnapshot).ok());
+    EXPECT_FALSE(fromSnapshot);
+    const std::string source =
+            base::GetExecutableDirectory() + "/test_audio_policy_configuration.xml";
+    auto config = AudioPolicyConfig::loadFromCustomXmlConfigWithSnapshotForTests(
+            source, snapshot, &fromSnapshot);
+    ASSERT_TRUE(config.ok());
+    EXPECT_FALSE(fromSnapshot);
+    EXPECT_EQ(source, config.value()->getSource());
+}
+
+TEST(AudioPolicyConfigTest, CorruptSnapshotIsIgnored) {
+    TemporaryDir snapshotDir;
+    const std::string snapshot = std::string(snapshotDir.path) + "/config.snapshot";
+    const std::string source =
+            base::GetExecutableDirectory() + "/test_audio_policy_configuration.xml";
+    bool fromSnapshot = true;
+    ASSERT_TRUE(AudioPolicyConfig::loadFromCustomXmlConfigWithSnapshotForTests(
+            source, snapshot, &fromSnapshot).ok());
+    std::string content;
+    ASSERT_TRUE(base::ReadFileToString(snapshot, &content));
+    content[content.size() / 2] ^= 0xff;
+    ASSERT_TRUE(base::WriteStringToFile(content, snapshot));
+    auto config = AudioPolicyConfig::loadFromCustomXmlConfigWithSnapshotForTests(
+            source, snapshot, &fromSnapshot);
+    ASSERT_TRUE(config.ok());
+    EXPECT_FALSE(fromSnapshot);
+    EXPECT_FALSE(config.value()->getHwModules().isEmpty());
+}
+
+TEST(AudioPolicyConfigTest, SnapshotOfAnotherBuildIsIgnored) {
+    const std::string fingerprint = base::GetProperty("ro.build.fingerprint", "");
+    if (fingerprint.empty()) {
+        GTEST_SKIP() << "No build fingerprint";
+    }
+    TemporaryDir snapshotDir;
+    const std::string snapshot = std::string(snapshotDir.path) + "/config.snapshot";
+    const std::string source =
+            base::GetExecutableDirectory() + "/test_audio_policy_configuration.xml";
+    bool fromSnapshot = true;
+    ASSERT_TRUE(AudioPolicyConfig::loadFromCustomXmlConfigWithSnapshotForTests(
+            source, snapshot, &fromSnapshot).ok());
+    std::string content;
+    ASSERT_TRUE(base::ReadFileToString(snapshot, &content));
+    // The fingerprint is in the header, which is not covered by the payload hash.
+    const size_t position = content.find(fingerprint);
+    ASSERT_NE(std::string::npos, position);
+    content[position + fingerprint.size() - 1] ^= 0x01;
+    ASSERT_TRUE(base::WriteStringToFile(content, snapshot));
+    auto config = AudioPolicyConfig::loadFromCustomXmlConfigWithSnapshotForTests(
+            source, snapshot, &fromSnapshot);
+    ASSERT_TRUE(config.ok());
+    EXPECT_FALSE(fromSnapshot);
+    EXPECT_FALSE(config.value()->getHwModules().isEmpty());
+}
+
 TEST(AudioPolicyManagerTestInit, EngineFailure) {
     AudioPolicyTestClient client;
     auto config = AudioPolicyConfig::createWritableForTests();
@@ -150,6 +323,96 @@ TEST(AudioPolicyManagerTestInit, ClientFailure) {
     ASSERT_EQ(NO_INIT, manager.initCheck());
 }
 
+class AudioPolicyMixCollectionTest : public testing::Test {
+  protected:
+    static constexpr size_t kUidMixes = 96;
+    static constexpr size_t kUsageMixes = 32;
+    static constexpr uid_t kFirstUid = 10000;
+    static constexpr audio_usage_t kUsages[] = {
+            AUDIO_USAGE_MEDIA, AUDIO_USAGE_GAME, AUDIO_USAGE_ALARM, AUDIO_USAGE_ASSISTANT};
+
+    // Mix i < kUidMixes matches uid kFirstUid + i, the following ones match a usage of kUsages
+    // but exclude kFirstUid.
+    void SetUp() override {
+        for (size_t i = 0; i < kUidMixes + kUsageMixes; ++i) {
+            std::vector<AudioMixMatchCriterion> criteria;
+            if (i < kUidMixes) {
+                criteria.push_back(createUidCriterion(kFirstUid + i));
+            } else {
+                criteria.push_back(createUsageCriterion(kUsages[i % std::size(kUsages)]));
+                criteria.push_back(createUidCriterion(kFirstUid, /*exclude=*/true));
+            }
+            ASSERT_EQ(NO_ERROR, addMix(criteria, "mix_" + std::to_string(i)));
+        }
+    }
+
+    status_t addMix(const std::vector<AudioMixMatchCriterion>& criteria,
+                    const std::string& address) {
+        audio_config_t config = AUDIO_CONFIG_INITIALIZER;
+        AudioMix mix(criteria, MIX_TYPE_PLAYERS, config, MIX_ROUTE_FLAG_RENDER,
+                     String8(address.c_str()), 0);
+        mix.mDeviceType = AUDIO_DEVICE_OUT_REMOTE_SUBMIX;
+        mix.mToken = sp<BBinder>::make();
+        return mMixes.registerMix(mix, nullptr);
+    }
+
+    // Returns the address of the primary mix for the given usage, uid and tags, or "".
+    std::string primaryMixFor(audio_usage_t usage, uid_t uid, const std::string& tags = "") {
+        audio_attributes_t attr = AUDIO_ATTRIBUTES_INITIALIZER;
+        attr.usage = usage;
+        strncpy(attr.tags, tags.c_str(), AUDIO_ATTRIBUTES_TAGS_MAX_SIZE - 1);
+        sp<AudioPolicyMix> primaryMix;
+        std::vector<sp<AudioPolicyMix>> secondaryMixes;
+        bool usePrimaryOutputFromPolicyMixes = false;
+        EXPECT_EQ(NO_ERROR, mMixes.getOutputForAttr(attr, AUDIO_CONFIG_BASE_INITIALIZER, uid,
+                AUDIO_SESSION_NONE, AUDIO_OUTPUT_FLAG_NONE, DeviceVector(), nullptr,
+                primaryMix, &secondaryMixes, usePrimaryOutputFromPolicyMixes));
+        EXPECT_EQ(primaryMix != nullptr, usePrimaryOutputFromPolicyMixes);
+        return primaryMix != nullptr ? primaryMix->mDeviceAddress.c_str() : "";
+    }
+
+    AudioPolicyMixCollection mMixes;
+};
+
+TEST_F(AudioPolicyMixCollectionTest, FirstMatchingMixWins) {
+    EXPECT_EQ("mix_5", primaryMixFor(AUDIO_USAGE_MEDIA, kFirstUid + 5));
+    EXPECT_EQ("mix_0", primaryMixFor(AUDIO_USAGE_GAME, kFirstUid));
+    // No uid mix, first mix of the usage.
+    EXPECT_EQ("mix_97", primaryMixFor(AUDIO_USAGE_GAME, kFirstUid + 1000));
+    EXPECT_EQ("mix_96", primaryMixFor(AUDIO_USAGE_MEDIA, kFirstUid + 1000));
+    EXPECT_EQ("", primaryMixFor(AUDIO_USAGE_NOTIFICATION, kFirstUid + 1000));
+}
+
+TEST_F(AudioPolicyMixCollectionTest, AddressInTagsMatches) {
+    EXPECT_EQ("mix_100", primaryMixFor(AUDIO_USAGE_NOTIFICATION, kFirstUid + 1000,
+                                       "addr=mix_100"));
+    // But an earlier mix matching on its criteria still wins.
+    EXPECT_EQ("mix_3", primaryMixFor(AUDIO_USAGE_MEDIA, kFirstUid + 3, "addr=mix_100"));
+}
+
+TEST_F(AudioPolicyMixCollectionTest, MixWithoutPositiveRulesAlwaysConsidered) {
+    ASSERT_EQ(NO_ERROR, addMix({createUsageCriterion(AUDIO_USAGE_MEDIA, /*exclude=*/true)},
+                               "catch_all"));
+    EXPECT_EQ("catch_all", primaryMixFor(AUDIO_USAGE_NOTIFICATION, kFirstUid + 1000));
+    EXPECT_EQ("mix_96", primaryMixFor(AUDIO_USAGE_MEDIA, kFirstUid + 1000));
+}
+
+TEST_F(AudioPolicyMixCollectionTest, ChangesAreReflected) {
+    audio_config_t config = AUDIO_CONFIG_INITIALIZER;
+    AudioMix mix({}, MIX_TYPE_PLAYERS, config, MIX_ROUTE_FLAG_RENDER, String8("mix_5"), 0);
+    mix.mDeviceType = AUDIO_DEVICE_OUT_REMOTE_SUBMIX;
+    ASSERT_EQ(NO_ERROR, mMixes.updateMix(mix, {createUsageCriterion(AUDIO_USAGE_ALARM)}));
+    EXPECT_EQ("mix_96", primaryMixFor(AUDIO_USAGE_MEDIA, kFirstUid + 5));
+    EXPECT_EQ("mix_5", primaryMixFor(AUDIO_USAGE_ALARM, kFirstUid + 1000));
+
+    // Excluding the uid from all mixes not routed to the given device.
+    ASSERT_EQ(NO_ERROR, mMixes.setUidDeviceAffinities(kFirstUid + 1000,
+            {AudioDeviceTypeAddr(AUDIO_DEVICE_OUT_REMOTE_SUBMIX, "mix_98")}));
+    EXPECT_EQ("mix_98", primaryMixFor(AUDIO_USAGE_ALARM, kFirstUid + 1000));
+    ASSERT_EQ(NO_ERROR, mMixes.removeUidDeviceAffinities(kFirstUid + 1000));
+    EXPECT_EQ("mix_5", primaryMixFor(AUDIO_USAGE_ALARM, kFirstUid + 1000));
+}
+
 
 class PatchCountCheck {
   public:
@@ -1060,6 +1323,62 @@ TEST_F(AudioPolicyManagerTestWithConfigurationFile, HandleDeviceConfigChange) {
     }
 }
 
+TEST_F(AudioPolicyManagerTestWithConfigurationFile, DeviceConnectionStormUsesSelectionCache) {
+    // Replays the bursts of routing events seen when a BT headset connects while a call starts
+    // and checks that the memoized device selection matches a fresh one after each event.
+    constexpr int kCycles = 50;
+    const audio_attributes_t mediaAttr = {
+        .content_type = AUDIO_CONTENT_TYPE_MUSIC, .usage = AUDIO_USAGE_MEDIA};
+    const audio_attributes_t voiceAttr = {
+        .content_type = AUDIO_CONTENT_TYPE_SPEECH, .usage = AUDIO_USAGE_VOICE_COMMUNICATION};
+    const std::vector<std::function<void()>> events = {
+        [&] { mManager->setDeviceConnectionState(AUDIO_DEVICE_OUT_BLUETOOTH_A2DP,
+                AUDIO_POLICY_DEVICE_STATE_AVAILABLE, "", "", AUDIO_FORMAT_SBC); },
+        [&] { mManager->setDeviceConnectionState(AUDIO_DEVICE_OUT_BLUETOOTH_SCO,
+                AUDIO_POLICY_DEVICE_STATE_AVAILABLE, "hfp_client_out", "", AUDIO_FORMAT_DEFAULT); },
+        [&] { mManager->setPhoneState(AUDIO_MODE_IN_COMMUNICATION); },
+        [&] { mManager->setDeviceConnectionState(AUDIO_DEVICE_OUT_USB_DEVICE,
+                AUDIO_POLICY_DEVICE_STATE_AVAILABLE, "", "", AUDIO_FORMAT_DEFAULT); },
+        [&] { mManager->setForceUse(AUDIO_POLICY_FORCE_FOR_COMMUNICATION,
+                AUDIO_POLICY_FORCE_SPEAKER); },
+        [&] { mManager->setForceUse(AUDIO_POLICY_FORCE_FOR_COMMUNICATION,
+                AUDIO_POLICY_FORCE_NONE); },
+        [&] { mManager->setPhoneState(AUDIO_MODE_NORMAL); },
+        [&] { mManager->setDeviceConnectionState(AUDIO_DEVICE_OUT_USB_DEVICE,
+                AUDIO_POLICY_DEVICE_STATE_UNAVAILABLE, "", "", AUDIO_FORMAT_DEFAULT); },
+        [&] { mManager->setDeviceConnectionState(AUDIO_DEVICE_OUT_BLUETOOTH_SCO,
+                AUDIO_POLICY_DEVICE_STATE_UNAVAILABLE, "hfp_client_out", "",
+                AUDIO_FORMAT_DEFAULT); },
+        [&] { mManager->setDeviceConnectionState(AUDIO_DEVICE_OUT_BLUETOOTH_A2DP,
+                AUDIO_POLICY_DEVICE_STATE_UNAVAILABLE, "", "", AUDIO_FORMAT_SBC); },
+    };
+    const DeviceSelectionCacheStats before = mManager->getDeviceSelectionCacheStats();
+    int64_t totalNs = 0;
+    for (int cycle = 0; cycle < kCycles; ++cycle) {
+        for (size_t i = 0; i < events.size(); ++i) {
+            SCOPED_TRACE(testing::Message() << "cycle " << cycle << " event " << i);
+            const int64_t startNs = systemTime();
+            events[i]();
+            totalNs += systemTime() - startNs;
+            for (const auto& attr : {mediaAttr, voiceAttr}) {
+                EXPECT_EQ(mManager->getEngineOutputDevicesForAttributes(
+                                attr, false /*fromCache*/).toString(),
+                        mManager->getEngineOutputDevicesForAttributes(
+                                attr, true /*fromCache*/).toString());
+            }
+        }
+    }
+    const DeviceSelectionCacheStats after = mManager->getDeviceSelectionCacheStats();
+    const uint64_t hits = after.hits - before.hits;
+    const uint64_t lookups = hits + after.misses - before.misses;
+    ALOGI("%s: %.1f us per event, %" PRIu64 "/%" PRIu64 " device selection cache hits", __func__,
+            totalNs / 1000. / (kCycles * events.size()), hits, lookups);
+    EXPECT_GT(hits, 0u);
+    EXPECT_LT(hits, lookups);
+    EXPECT_EQ(DeviceTypeSet({AUDIO_DEVICE_OUT_SPEAKER}),
+            mManager->getEngineOutputDevicesForAttributes(mediaAttr, true /*fromCache*/).types());
+}
+
 TEST_F(AudioPolicyManagerTestWithConfigurationFile, PreferredMixerAttributes) {
     mClient->addSupportedFormat(AUDIO_FORMAT_PCM_16_BIT);
     mClient->addSupportedChannelMask(AUDIO_CHANNEL_OUT_STEREO);
@@ -3792,6 +4111,48 @@ TEST_F(AudioPolicyManagerDynamicHwModulesTest, ClientIsUpdated) {
     EXPECT_GT(mManager->getAudioPortGeneration(), prevAudioPortGeneration);
 }
 
+class AudioPolicyManagerLateModuleTest : public AudioPolicyManagerTest {
+protected:
+    void SetUpManagerConfig() override;
+};
+
+void AudioPolicyManagerLateModuleTest::SetUpManagerConfig() {
+    ASSERT_NO_FATAL_FAILURE(AudioPolicyManagerTest::SetUpManagerConfig());
+    // A module with an attached headphone, which only loads after initialization.
+    sp<DeviceDescriptor> headphone = new DeviceDescriptor(AUDIO_DEVICE_OUT_WIRED_HEADPHONE);
+    sp<AudioProfile> pcmOutputProfile = new AudioProfile(
+            AUDIO_FORMAT_PCM_16_BIT, AUDIO_CHANNEL_OUT_STEREO, k48000SamplingRate);
+    headphone->addAudioProfile(pcmOutputProfile);
+    mConfig->addDevice(headphone);
+
+    sp<HwModule> lateModule = new HwModule("late", AUDIO_DEVICE_API_VERSION_2_0);
+    HwModuleCollection modules = mConfig->getHwModules();
+    modules.add(lateModule);
+    mConfig->setHwModules(modules);
+    sp<OutputProfile> outputProfile = new OutputProfile("late output");
+    outputProfile->addAudioProfile(pcmOutputProfile);
+    outputProfile->addSupportedDevice(headphone);
+    lateModule->addOutputProfile(outputProfile);
+
+    mClient->swapAllowedModuleNames({AUDIO_HARDWARE_MODULE_ID_PRIMARY});
+}
+
+TEST_F(AudioPolicyManagerLateModuleTest, MemoizedSelectionUsesLateModuleDevice) {
+    const audio_attributes_t mediaAttr = {
+        .content_type = AUDIO_CONTENT_TYPE_MUSIC, .usage = AUDIO_USAGE_MEDIA};
+    // The module loads while a routing evaluation has memoized the selection.
+    mManager->beginDeviceSelectionBatch();
+    EXPECT_EQ(DeviceTypeSet({AUDIO_DEVICE_OUT_SPEAKER}),
+            mManager->getEngineOutputDevicesForAttributes(mediaAttr, false /*fromCache*/).types());
+    mClient->swapAllowedModuleNames();
+    mManager->onNewAudioModulesAvailable();
+    EXPECT_EQ(DeviceTypeSet({AUDIO_DEVICE_OUT_WIRED_HEADPHONE}),
+            mManager->getEngineOutputDevicesForAttributes(mediaAttr, false /*fromCache*/).types());
+    mManager->endDeviceSelectionBatch();
+    EXPECT_EQ(DeviceTypeSet({AUDIO_DEVICE_OUT_WIRED_HEADPHONE}),
+            mManager->getEngineOutputDevicesForAttributes(mediaAttr, false /*fromCache*/).types());
+}
+
 using DevicesRoleForCapturePresetParam = std::tuple<audio_source_t, device_role_t>;
 
 class AudioPolicyManagerDevicesRoleForCapturePresetTest
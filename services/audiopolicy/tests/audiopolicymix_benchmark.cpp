@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "audiopolicy_mix_benchmark"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <AudioPolicyMix.h>
+#include <benchmark/benchmark.h>
+#include <binder/Binder.h>
+
+using namespace android;
+
+namespace {
+
+constexpr uid_t kFirstUid = 10000;
+constexpr audio_usage_t kUsages[] = {
+        AUDIO_USAGE_MEDIA, AUDIO_USAGE_GAME, AUDIO_USAGE_ALARM, AUDIO_USAGE_ASSISTANT};
+
+// Registers "mixes" render mixes, as a car audio setup or a multi-zone policy would: three
+// quarters keyed on a uid, the others on a usage and excluding a uid.
+void registerMixes(AudioPolicyMixCollection& collection, size_t mixes) {
+    for (size_t i = 0; i < mixes; ++i) {
+        std::vector<AudioMixMatchCriterion> criteria(1);
+        if (i % 4 != 3) {
+            criteria[0].mRule = RULE_MATCH_UID;
+            criteria[0].mValue.mUid = kFirstUid + i;
+        } else {
+            criteria[0].mRule = RULE_MATCH_ATTRIBUTE_USAGE;
+            criteria[0].mValue.mUsage = kUsages[(i / 4) % std::size(kUsages)];
+            criteria.emplace_back();
+            criteria[1].mRule = RULE_EXCLUDE_UID;
+            criteria[1].mValue.mUid = kFirstUid;
+        }
+        audio_config_t config = AUDIO_CONFIG_INITIALIZER;
+        AudioMix mix(criteria, MIX_TYPE_PLAYERS, config, MIX_ROUTE_FLAG_RENDER,
+                     String8(("mix_" + std::to_string(i)).c_str()), 0);
+        mix.mDeviceType = AUDIO_DEVICE_OUT_REMOTE_SUBMIX;
+        mix.mToken = sp<BBinder>::make();
+        collection.registerMix(mix, nullptr);
+    }
+}
+
+// Arguments: number of mixes, uid of the client (0: matching the last uid mix, 1: none).
+void BM_GetOutputForAttr(benchmark::State& state) {
+    const size_t mixes = state.range(0);
+    AudioPolicyMixCollection collection;
+    registerMixes(collection, mixes);
+    const uid_t uid = state.range(1) == 0 ? kFirstUid + mixes - 2 : kFirstUid + mixes;
+    audio_attributes_t attr = AUDIO_ATTRIBUTES_INITIALIZER;
+    attr.usage = AUDIO_USAGE_MEDIA;
+    const DeviceVector availableOutputDevices;
+    for (auto _ : state) {
+        sp<AudioPolicyMix> primaryMix;
+        std::vector<sp<AudioPolicyMix>> secondaryMixes;
+        bool usePrimaryOutputFromPolicyMixes = false;
+        collection.getOutputForAttr(attr, AUDIO_CONFIG_BASE_INITIALIZER, uid,
+                AUDIO_SESSION_NONE, AUDIO_OUTPUT_FLAG_NONE, availableOutputDevices, nullptr,
+                primaryMix, &secondaryMixes, usePrimaryOutputFromPolicyMixes);
+        benchmark::DoNotOptimize(primaryMix);
+    }
+}
+
+// Same with the address of the last mix in the tags.
+void BM_GetOutputForAttrTagAddress(benchmark::State& state) {
+    const size_t mixes = state.range(0);
+    AudioPolicyMixCollection collection;
+    registerMixes(collection, mixes);
+    audio_attributes_t attr = AUDIO_ATTRIBUTES_INITIALIZER;
+    attr.usage = AUDIO_USAGE_NOTIFICATION;
+    const std::string tags = "addr=mix_" + std::to_string(mixes - 1);
+    strncpy(attr.tags, tags.c_str(), AUDIO_ATTRIBUTES_TAGS_MAX_SIZE - 1);
+    const DeviceVector availableOutputDevices;
+    for (auto _ : state) {
+        sp<AudioPolicyMix> primaryMix;
+        std::vector<sp<AudioPolicyMix>> secondaryMixes;
+        bool usePrimaryOutputFromPolicyMixes = false;
+        collection.getOutputForAttr(attr, AUDIO_CONFIG_BASE_INITIALIZER, kFirstUid + mixes,
+                AUDIO_SESSION_NONE, AUDIO_OUTPUT_FLAG_NONE, availableOutputDevices, nullptr,
+                primaryMix, &secondaryMixes, usePrimaryOutputFromPolicyMixes);
+        benchmark::DoNotOptimize(primaryMix);
+    }
+}
+
+} // namespace
+
+BENCHMARK(BM_GetOutputForAttr)->ArgsProduct({{8, 32, 128, 512}, {0, 1}});
+BENCHMARK(BM_GetOutputForAttrTagAddress)->Arg(8)->Arg(128)->Arg(512);
+
+BENCHMARK_MAIN();
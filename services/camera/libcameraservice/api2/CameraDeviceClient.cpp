@@ -2312,6 +2312,12 @@ status_t CameraDeviceClient::dumpClient(int fd, const Vector<String16>& args) {
     } else {
         dprintf(fd, "      No output streams configured.\n");
     }
+    for (size_t i = 0; i < mCompositeStreamMap.size(); i++) {
+        const auto& compositeStream = mCompositeStreamMap.valueAt(i);
+        std::string name = fmt::sprintf("      Composite stream %d processing latency",
+                compositeStream->getStreamId());
+        compositeStream->dumpProcessingLatency(fd, name.c_str());
+    }
     // TODO: print dynamic/request section from most recent requests
     mFrameProcessor->dump(fd, args);
 
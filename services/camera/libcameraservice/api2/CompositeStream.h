@@ -26,6 +26,7 @@
 #include <gui/Surface.h>
 #include "common/CameraDeviceBase.h"
 #include "device3/Camera3StreamInterface.h"
+#include "utils/LatencyHistogram.h"
 
 namespace android {
 
@@ -86,6 +87,10 @@ public:
     // Get composite stream stats
     virtual void getStreamStats(hardware::CameraStreamStats* streamStats /*out*/) = 0;
 
+    void dumpProcessingLatency(int fd, const char* name) const {
+        mProcessingLatency.dump(fd, name);
+    }
+
     void onResultAvailable(const CaptureResult& result);
     bool onError(int32_t errorCode, const CaptureResultExtras& resultExtras);
 
@@ -149,6 +154,9 @@ protected:
     // Frame number to request time map
     std::unordered_map<int64_t, nsecs_t> mRequestTimeMap;
 
+    // Time taken to produce each composite output from its input buffers
+    CameraLogLatencyHistogram mProcessingLatency;
+
 };
 
 }; //namespace camera3
@@ -48,12 +48,13 @@ DepthCompositeStream::DepthCompositeStream(sp<CameraDeviceBase> device,
         mDepthSurfaceId(-1),
         mBlobWidth(0),
         mBlobHeight(0),
-        mDepthBufferAcquired(false),
-        mBlobBufferAcquired(false),
+        mDepthBuffersAcquired(0),
+        mBlobBuffersAcquired(0),
         mStreamSurfaceListener(new StreamSurfaceListener()),
         mMaxJpegBufferSize(-1),
         mUHRMaxJpegBufferSize(-1),
-        mIsLogicalCamera(false) {
+        mIsLogicalCamera(false),
+        mFramesInFlight(0) {
     if (device != nullptr) {
         CameraMetadata staticInfo = device->info();
         auto entry = staticInfo.find(ANDROID_JPEG_MAX_SIZE);
@@ -108,6 +109,7 @@ DepthCompositeStream::DepthCompositeStream(sp<CameraDeviceBase> device,
 }
 
 DepthCompositeStream::~DepthCompositeStream() {
+    mDepthPhotoPipeline.reset();
     mBlobConsumer.clear(),
     mBlobSurface.clear(),
     mBlobStreamId = -1;
@@ -121,7 +123,7 @@ DepthCompositeStream::~DepthCompositeStream() {
 void DepthCompositeStream::compilePendingInputLocked() {
     CpuConsumer::LockedBuffer imgBuffer;
 
-    while (!mInputJpegBuffers.empty() && !mBlobBufferAcquired) {
+    while (!mInputJpegBuffers.empty() && (mBlobBuffersAcquired < kMaxFramesInFlight)) {
         auto it = mInputJpegBuffers.begin();
         auto res = mBlobConsumer->lockNextBuffer(&imgBuffer);
         if (res == NOT_ENOUGH_DATA) {
@@ -145,12 +147,12 @@ void DepthCompositeStream::compilePendingInputLocked() {
             mBlobConsumer->unlockBuffer(imgBuffer);
         } else {
             mPendingInputFrames[imgBuffer.timestamp].jpegBuffer = imgBuffer;
-            mBlobBufferAcquired = true;
+            mBlobBuffersAcquired++;
         }
         mInputJpegBuffers.erase(it);
     }
 
-    while (!mInputDepthBuffers.empty() && !mDepthBufferAcquired) {
+    while (!mInputDepthBuffers.empty() && (mDepthBuffersAcquired < kMaxFramesInFlight)) {
         auto it = mInputDepthBuffers.begin();
         auto res = mDepthConsumer->lockNextBuffer(&imgBuffer);
         if (res == NOT_ENOUGH_DATA) {
@@ -174,7 +176,7 @@ void DepthCompositeStream::compilePendingInputLocked() {
             mDepthConsumer->unlockBuffer(imgBuffer);
         } else {
             mPendingInputFrames[imgBuffer.timestamp].depthBuffer = imgBuffer;
-            mDepthBufferAcquired = true;
+            mDepthBuffersAcquired++;
         }
         mInputDepthBuffers.erase(it);
     }
@@ -224,7 +226,8 @@ bool DepthCompositeStream::getNextReadyInputLocked(int64_t *currentTs /*inout*/)
 
     bool newInputAvailable = false;
     for (const auto& it : mPendingInputFrames) {
-        if ((!it.second.error) && (it.second.depthBuffer.data != nullptr) &&
+        if ((!it.second.error) && (!it.second.processing) &&
+                (it.second.depthBuffer.data != nullptr) &&
                 (it.second.jpegBuffer.data != nullptr) && (it.first < *currentTs)) {
             *currentTs = it.first;
             newInputAvailable = true;
@@ -241,7 +244,8 @@ int64_t DepthCompositeStream::getNextFailingInputLocked(int64_t *currentTs /*ino
     }
 
     for (const auto& it : mPendingInputFrames) {
-        if (it.second.error && !it.second.errorNotified && (it.first < *currentTs)) {
+        if (it.second.error && !it.second.errorNotified && !it.second.processing &&
+                (it.first < *currentTs)) {
             *currentTs = it.first;
             ret = it.second.frameNumber;
         }
@@ -305,9 +309,15 @@ status_t DepthCompositeStream::processInputFrame(nsecs_t ts, const InputFrame &i
         return res;
     }
 
-    sp<GraphicBuffer> gb = GraphicBuffer::from(anb);
-    GraphicBufferLocker gbLocker(gb);
-    res = gbLocker.lockAsync(&dstBuffer, fenceFd);
+    // The output buffer stays locked while the frame is being processed on the pipeline
+    auto outputFrame = std::make_shared<OutputFrame>();
+    outputFrame->timestamp = ts;
+    outputFrame->anb = anb;
+    outputFrame->graphicBuffer = GraphicBuffer::from(anb);
+    outputFrame->locker = std::make_unique<GraphicBufferLocker>(outputFrame->graphicBuffer);
+    outputFrame->size = finalJpegBufferSize;
+    sp<GraphicBuffer> gb = outputFrame->graphicBuffer;
+    res = outputFrame->locker->lockAsync(&dstBuffer, fenceFd);
     if (res != OK) {
         ALOGE("%s: Error trying to lock output buffer fence: %s (%d)", __FUNCTION__,
                 strerror(-res), res);
@@ -321,6 +331,7 @@ status_t DepthCompositeStream::processInputFrame(nsecs_t ts, const InputFrame &i
         outputANW->cancelBuffer(mOutputSurface.get(), anb, /*fence*/ -1);
         return BAD_VALUE;
     }
+    outputFrame->data = dstBuffer;
 
     DepthPhotoInputFrame depthPhoto;
     depthPhoto.mMainJpegBuffer = reinterpret_cast<const char*> (inputFrame.jpegBuffer.data);
@@ -368,37 +379,76 @@ status_t DepthCompositeStream::processInputFrame(nsecs_t ts, const InputFrame &i
         }
     }
 
-    size_t actualJpegSize = 0;
-    res = processDepthPhotoFrame(depthPhoto, finalJpegBufferSize, dstBuffer, &actualJpegSize);
-    if (res != 0) {
-        ALOGE("%s: Depth photo processing failed: %s (%d)", __FUNCTION__, strerror(-res), res);
+    // Depth photo processing continues on the pipeline, which holds on to the input buffers
+    // until 'onDepthPhotoProcessed()' releases them.
+    res = mDepthPhotoPipeline->submit(depthPhoto, finalJpegBufferSize, dstBuffer,
+            [this, outputFrame](const DepthPhotoPipeline::Result& result) {
+                onDepthPhotoProcessed(outputFrame.get(), result);
+            });
+    if (res != OK) {
+        ALOGE("%s: Failed to submit depth photo: %s (%d)", __FUNCTION__, strerror(-res), res);
+        outputFrame->locker.reset();
         outputANW->cancelBuffer(mOutputSurface.get(), anb, /*fence*/ -1);
         return res;
     }
 
-    size_t finalJpegSize = actualJpegSize + sizeof(CameraBlob);
-    if (finalJpegSize > finalJpegBufferSize) {
+    return OK;
+}
+
+void DepthCompositeStream::onDepthPhotoProcessed(OutputFrame* outputFrame,
+        const DepthPhotoPipeline::Result& result) {
+    ATRACE_CALL();
+    sp<ANativeWindow> outputANW = mOutputSurface;
+    status_t res = result.status;
+    if (res != 0) {
+        ALOGE("%s: Depth photo processing failed: %s (%d)", __FUNCTION__, strerror(-res), res);
+    } else if (result.actualSize + sizeof(CameraBlob) > outputFrame->size) {
         ALOGE("%s: Final jpeg buffer not large enough for the jpeg blob header", __FUNCTION__);
-        outputANW->cancelBuffer(mOutputSurface.get(), anb, /*fence*/ -1);
-        return NO_MEMORY;
+        res = NO_MEMORY;
     }
 
-    res = native_window_set_buffers_timestamp(mOutputSurface.get(), ts);
-    if (res != OK) {
-        ALOGE("%s: Stream %d: Error setting timestamp: %s (%d)", __FUNCTION__,
-                getStreamId(), strerror(-res), res);
-        return res;
+    if (res == OK) {
+        res = native_window_set_buffers_timestamp(mOutputSurface.get(), outputFrame->timestamp);
+        if (res != OK) {
+            ALOGE("%s: Stream %d: Error setting timestamp: %s (%d)", __FUNCTION__,
+                    getStreamId(), strerror(-res), res);
+        }
     }
 
-    ALOGV("%s: Final jpeg size: %zu", __func__, finalJpegSize);
-    uint8_t* header = static_cast<uint8_t *> (dstBuffer) +
-        (gb->getWidth() - sizeof(CameraBlob));
-    CameraBlob *blob = reinterpret_cast<CameraBlob*> (header);
-    blob->blobId = CameraBlobId::JPEG;
-    blob->blobSizeBytes = actualJpegSize;
-    outputANW->queueBuffer(mOutputSurface.get(), anb, /*fence*/ -1);
+    if (res == OK) {
+        ALOGV("%s: Final jpeg size: %zu", __func__, result.actualSize + sizeof(CameraBlob));
+        uint8_t* header = static_cast<uint8_t *> (outputFrame->data) +
+            (outputFrame->graphicBuffer->getWidth() - sizeof(CameraBlob));
+        CameraBlob *blob = reinterpret_cast<CameraBlob*> (header);
+        blob->blobId = CameraBlobId::JPEG;
+        blob->blobSizeBytes = result.actualSize;
+        outputFrame->locker.reset();
+        outputANW->queueBuffer(mOutputSurface.get(), outputFrame->anb, /*fence*/ -1);
+
+        const DepthPhotoStageTimes& stageTimes = result.stageTimes;
+        mDepthMapLatency.add(stageTimes.mDepthMapEncoding);
+        mMainImageLatency.add(stageTimes.mMainImagePackaging);
+        mContainerLatency.add(stageTimes.mContainerAssembly);
+        mProcessingLatency.add(result.totalTime);
+    } else {
+        outputFrame->locker.reset();
+        outputANW->cancelBuffer(mOutputSurface.get(), outputFrame->anb, /*fence*/ -1);
+    }
 
-    return res;
+    Mutex::Autolock l(mMutex);
+    mFramesInFlight--;
+    auto it = mPendingInputFrames.find(outputFrame->timestamp);
+    if (it != mPendingInputFrames.end()) {
+        it->second.processing = false;
+        if (res != OK) {
+            ALOGE("%s: Failed processing frame with timestamp: %" PRIu64 ": %s (%d)",
+                    __FUNCTION__, outputFrame->timestamp, strerror(-res), res);
+            it->second.error = true;
+        }
+    }
+
+    releaseInputFramesLocked(outputFrame->timestamp);
+    mInputReadyCondition.signal();
 }
 
 void DepthCompositeStream::releaseInputFrameLocked(InputFrame *inputFrame /*out*/) {
@@ -409,13 +459,13 @@ void DepthCompositeStream::releaseInputFrameLocked(InputFrame *inputFrame /*out*
     if (inputFrame->depthBuffer.data != nullptr) {
         mDepthConsumer->unlockBuffer(inputFrame->depthBuffer);
         inputFrame->depthBuffer.data = nullptr;
-        mDepthBufferAcquired = false;
+        mDepthBuffersAcquired--;
     }
 
     if (inputFrame->jpegBuffer.data != nullptr) {
         mBlobConsumer->unlockBuffer(inputFrame->jpegBuffer);
         inputFrame->jpegBuffer.data = nullptr;
-        mBlobBufferAcquired = false;
+        mBlobBuffersAcquired--;
     }
 
     if ((inputFrame->error || mErrorState) && !inputFrame->errorNotified) {
@@ -428,7 +478,8 @@ void DepthCompositeStream::releaseInputFrameLocked(InputFrame *inputFrame /*out*
 void DepthCompositeStream::releaseInputFramesLocked(int64_t currentTs) {
     auto it = mPendingInputFrames.begin();
     while (it != mPendingInputFrames.end()) {
-        if (it->first <= currentTs) {
+        // Frames still being processed are released once their depth photo completes
+        if ((it->first <= currentTs) && !it->second.processing) {
             releaseInputFrameLocked(&it->second);
             it = mPendingInputFrames.erase(it);
         } else {
@@ -440,6 +491,7 @@ void DepthCompositeStream::releaseInputFramesLocked(int64_t currentTs) {
 bool DepthCompositeStream::threadLoop() {
     int64_t currentTs = INT64_MAX;
     bool newInputAvailable = false;
+    InputFrame* inputFrame = nullptr;
 
     {
         Mutex::Autolock l(mMutex);
@@ -454,7 +506,8 @@ bool DepthCompositeStream::threadLoop() {
 
         while (!newInputAvailable) {
             compilePendingInputLocked();
-            newInputAvailable = getNextReadyInputLocked(&currentTs);
+            newInputAvailable = (mFramesInFlight < kMaxFramesInFlight) &&
+                    getNextReadyInputLocked(&currentTs);
             if (!newInputAvailable) {
                 auto failingFrameNumber = getNextFailingInputLocked(&currentTs);
                 if (failingFrameNumber >= 0) {
@@ -478,18 +531,24 @@ bool DepthCompositeStream::threadLoop() {
                 }
             }
         }
+
+        inputFrame = &mPendingInputFrames[currentTs];
+        inputFrame->processing = true;
+        mFramesInFlight++;
     }
 
-    auto res = processInputFrame(currentTs, mPendingInputFrames[currentTs]);
-    Mutex::Autolock l(mMutex);
+    // On success, the input frame is released once the pipeline completes it
+    auto res = processInputFrame(currentTs, *inputFrame);
     if (res != OK) {
+        Mutex::Autolock l(mMutex);
         ALOGE("%s: Failed processing frame with timestamp: %" PRIu64 ": %s (%d)", __FUNCTION__,
                 currentTs, strerror(-res), res);
-        mPendingInputFrames[currentTs].error = true;
+        inputFrame->processing = false;
+        inputFrame->error = true;
+        mFramesInFlight--;
+        releaseInputFramesLocked(currentTs);
     }
 
-    releaseInputFramesLocked(currentTs);
-
     return true;
 }
 
@@ -617,7 +676,7 @@ status_t DepthCompositeStream::createInternalStreams(const std::vector<SurfaceHo
     }
 
     std::tie(mBlobConsumer, mBlobSurface) =
-            CpuConsumer::create(/*maxLockedBuffers*/ 1, /*controlledByApp*/ true);
+            CpuConsumer::create(kMaxFramesInFlight, /*controlledByApp*/ true);
     mBlobConsumer->setFrameAvailableListener(this);
     mBlobConsumer->setName(String8("Camera3-JpegCompositeStream"));
 
@@ -639,7 +698,7 @@ status_t DepthCompositeStream::createInternalStreams(const std::vector<SurfaceHo
     }
 
     std::tie(mDepthConsumer, mDepthSurface) =
-            CpuConsumer::create(/*maxLockedBuffers*/ 1, /*controlledByApp*/ true);
+            CpuConsumer::create(kMaxFramesInFlight, /*controlledByApp*/ true);
     mDepthConsumer->setFrameAvailableListener(this);
     mDepthConsumer->setName(String8("Camera3-DepthCompositeStream"));
 
@@ -720,12 +779,18 @@ status_t DepthCompositeStream::configureStream() {
         return res;
     }
 
-    if ((res = native_window_set_buffer_count(
-                    anwConsumer, maxProducerBuffers + maxConsumerBuffers)) != OK) {
+    // Each frame in flight holds one output buffer while it is being processed
+    if ((res = native_window_set_buffer_count(anwConsumer,
+                    maxProducerBuffers + maxConsumerBuffers + kMaxFramesInFlight - 1)) != OK) {
         ALOGE("%s: Unable to set buffer count for stream %d", __FUNCTION__, mBlobStreamId);
         return res;
     }
 
+    if (mDepthPhotoPipeline == nullptr) {
+        mDepthPhotoPipeline = std::make_unique<DepthPhotoPipeline>(
+                DepthPhotoPipeline::kDefaultWorkerCount, kMaxFramesInFlight);
+    }
+
     run("DepthCompositeStreamProc");
 
     return NO_ERROR;
@@ -741,6 +806,15 @@ status_t DepthCompositeStream::deleteInternalStreams() {
                 strerror(-ret), ret);
     }
 
+    if (mDepthPhotoPipeline != nullptr) {
+        // Hand back the output buffers of the frames still being processed
+        mDepthPhotoPipeline->waitForIdle();
+        mDepthMapLatency.log("Stream %d depth map encoding latency", mBlobStreamId);
+        mMainImageLatency.log("Stream %d main image packaging latency", mBlobStreamId);
+        mContainerLatency.log("Stream %d container assembly latency", mBlobStreamId);
+        mProcessingLatency.log("Stream %d depth photo latency", mBlobStreamId);
+    }
+
     if (mDepthStreamId >= 0) {
         // Camera devices may not be valid after switching to offline mode.
         // In this case, all offline streams including internal composite streams
@@ -17,7 +17,11 @@
 #ifndef ANDROID_SERVERS_CAMERA_CAMERA3_DEPTH_COMPOSITE_STREAM_H
 #define ANDROID_SERVERS_CAMERA_CAMERA3_DEPTH_COMPOSITE_STREAM_H
 
+#include <memory>
+
+#include "common/DepthPhotoPipeline.h"
 #include "common/DepthPhotoProcessor.h"
+#include "utils/LatencyHistogram.h"
 #include <dynamic_depth/imaging_model.h>
 #include <dynamic_depth/depth_map.h>
 
@@ -86,10 +90,23 @@ private:
         CameraMetadata            result;
         bool                      error;
         bool                      errorNotified;
+        // Submitted to the depth photo pipeline and not completed yet
+        bool                      processing;
         int64_t                   frameNumber;
         int32_t                   requestId;
 
-        InputFrame() : error(false), errorNotified(false), frameNumber(-1), requestId(-1) { }
+        InputFrame() : error(false), errorNotified(false), processing(false), frameNumber(-1),
+                requestId(-1) { }
+    };
+
+    // Output buffer held while its depth photo is being processed
+    struct OutputFrame {
+        nsecs_t                              timestamp;
+        ANativeWindowBuffer*                 anb;
+        sp<GraphicBuffer>                    graphicBuffer;
+        std::unique_ptr<GraphicBufferLocker> locker;
+        void*                                data;
+        size_t                               size;
     };
 
     // Helper methods
@@ -112,7 +129,11 @@ private:
             size_t maxJpegSize, uint8_t jpegQuality,
             std::vector<std::unique_ptr<Item>>* items /*out*/);
     std::unique_ptr<ImagingModel> getImagingModel();
+    // Dequeue an output buffer and submit the frame to the depth photo pipeline
     status_t processInputFrame(nsecs_t ts, const InputFrame &inputFrame);
+    // Called by the depth photo pipeline, in submission order
+    void onDepthPhotoProcessed(OutputFrame* outputFrame,
+            const DepthPhotoPipeline::Result& result);
 
     // Buffer/Results handling
     void compilePendingInputLocked();
@@ -129,11 +150,13 @@ private:
     static const auto kDepthMapPixelFormat = HAL_PIXEL_FORMAT_Y16;
     static const auto kDepthMapDataSpace = HAL_DATASPACE_DEPTH;
     static const auto kJpegDataSpace = HAL_DATASPACE_V0_JFIF;
+    // Frames processed concurrently, each one holding a depth, a jpeg and an output buffer
+    static const size_t kMaxFramesInFlight = DepthPhotoPipeline::kDefaultMaxInFlight;
 
     int                         mBlobStreamId, mBlobSurfaceId, mDepthStreamId, mDepthSurfaceId;
     size_t                      mBlobWidth, mBlobHeight;
     sp<CpuConsumer>             mBlobConsumer, mDepthConsumer;
-    bool                        mDepthBufferAcquired, mBlobBufferAcquired;
+    size_t                      mDepthBuffersAcquired, mBlobBuffersAcquired;
     sp<Surface>                 mDepthSurface, mBlobSurface, mOutputSurface;
     sp<StreamSurfaceListener>   mStreamSurfaceListener;
 
@@ -156,6 +179,17 @@ private:
 
     // Map of all input frames pending further processing.
     std::unordered_map<int64_t, InputFrame> mPendingInputFrames;
+
+    // Frames submitted to the depth photo pipeline and not completed yet.
+    size_t               mFramesInFlight;
+
+    // Only updated from the in-order pipeline completions.
+    CameraLogLatencyHistogram mDepthMapLatency;
+    CameraLogLatencyHistogram mMainImageLatency;
+    CameraLogLatencyHistogram mContainerLatency;
+
+    // Last, so that it's drained before any of the state its completions use is destroyed.
+    std::unique_ptr<DepthPhotoPipeline> mDepthPhotoPipeline;
 };
 
 }; //namespace camera3
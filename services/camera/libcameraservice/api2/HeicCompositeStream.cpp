@@ -310,6 +310,7 @@ status_t HeicCompositeStream::deleteInternalStreams() {
     }
 
     deinitCodec();
+    mProcessingLatency.log("Stream %d HEIC encoding latency", mMainImageStreamId);
 
     if (mAppSegmentStreamId >= 0) {
         // Camera devices may not be valid after switching to offline mode.
@@ -480,6 +481,11 @@ bool HeicCompositeStream::isSizeSupportedByHeifEncoder(int32_t width, int32_t he
     return heicManager.isSizeSupported(width, height, useHeic, useGrid, stall, hevcName);
 }
 
+uint64_t HeicCompositeStream::getHeifEncoderCapabilitiesHash(bool allowSWCodec) {
+    static HeicEncoderInfoManager& heicManager = HeicEncoderInfoManager::getInstance(allowSWCodec);
+    return heicManager.getCapabilitiesHash();
+}
+
 bool HeicCompositeStream::isInMemoryTempFileSupported() {
     int memfd = syscall(__NR_memfd_create, "HEIF-try-memfd", MFD_CLOEXEC);
     if (memfd == -1) {
@@ -1075,6 +1081,10 @@ status_t HeicCompositeStream::processInputFrame(int64_t frameNumber,
     ATRACE_CALL();
     status_t res = OK;
 
+    if (inputFrame.processingStart == 0) {
+        inputFrame.processingStart = systemTime();
+    }
+
     bool appSegmentReady =
             (inputFrame.appSegmentBuffer.data != nullptr || inputFrame.exifError) &&
             !inputFrame.appSegmentWritten && inputFrame.result != nullptr &&
@@ -1689,6 +1699,9 @@ status_t HeicCompositeStream::processCompletedInputFrame(int64_t frameNumber,
     }
     inputFrame.anb = nullptr;
     mDequeuedOutputBufferCnt--;
+    // Encoding a frame spans several iterations of the processing thread, interleaved with the
+    // asynchronous codec callbacks
+    mProcessingLatency.add(inputFrame.processingStart, systemTime());
 
     ALOGV("%s: [%" PRId64 "]", __FUNCTION__, frameNumber);
     ATRACE_ASYNC_END("HEIC capture", frameNumber);
@@ -89,6 +89,9 @@ public:
     static bool isSizeSupportedByHeifEncoder(int32_t width, int32_t height,
             bool* useHeic, bool* useGrid, int64_t* stall, AString* hevcName = nullptr,
             bool allowSWCodec = false);
+    // Changes whenever the answers of isSizeSupportedByHeifEncoder() may, e.g. on a media
+    // module update
+    static uint64_t getHeifEncoderCapabilitiesHash(bool allowSWCodec = false);
     static bool isInMemoryTempFileSupported();
 
     // HDR Gainmap subsampling
@@ -183,6 +186,8 @@ private:
         bool                      exifError; // Exif/APP_SEGMENT buffer error
         int64_t                   timestamp;
         int32_t                   requestId;
+        // When the processing thread first worked on this frame, for the encoding latency
+        nsecs_t                   processingStart;
 
         sp<AMessage>              format, gainmapFormat;
         sp<MediaMuxer>            muxer;
@@ -207,6 +212,7 @@ private:
               exifError(false),
               timestamp(-1),
               requestId(-1),
+              processingStart(0),
               fenceFd(-1),
               fileFd(-1),
               trackIndex(-1),
@@ -18,6 +18,7 @@
 //#define LOG_NDEBUG 0
 
 #include <cstdint>
+#include <map>
 #include <regex>
 
 #include <com_android_internal_camera_flags.h>
@@ -113,6 +114,46 @@ bool HeicEncoderInfoManager::isSizeSupported(int32_t width, int32_t height, bool
     return true;
 }
 
+uint64_t HeicEncoderInfoManager::getCapabilitiesHash() const {
+    // FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    auto add = [&hash](int64_t value) {
+        for (size_t i = 0; i < sizeof(value); i++) {
+            hash ^= static_cast<uint8_t>(value >> (8 * i));
+            hash *= 0x100000001b3ULL;
+        }
+    };
+    auto addPair = [&add](const std::pair<int32_t, int32_t>& pair) {
+        add(pair.first);
+        add(pair.second);
+    };
+    auto addMaps = [&add, &addPair](const FrameRateMaps& maps) {
+        // In a stable order
+        std::map<std::pair<int32_t, int32_t>, std::pair<int32_t, int32_t>> sorted(
+                maps.begin(), maps.end());
+        add(sorted.size());
+        for (const auto& [size, fpsRange] : sorted) {
+            addPair(size);
+            addPair(fpsRange);
+        }
+    };
+
+    add(mIsInited);
+    add(mDisableGrid);
+    add(mHasHEIC);
+    addPair(mMinSizeHeic);
+    addPair(mMaxSizeHeic);
+    addMaps(mHeicFrameRateMaps);
+    add(mHasHEVC);
+    addPair(mMinSizeHevc);
+    addPair(mMaxSizeHevc);
+    addMaps(mHevcFrameRateMaps);
+    for (size_t i = 0; i < mHevcName.size(); i++) {
+        add(mHevcName.c_str()[i]);
+    }
+    return hash;
+}
+
 status_t HeicEncoderInfoManager::initialize(bool allowSWCodec) {
     mDisableGrid = property_get_bool("camera.heic.disable_grid", false);
     sp<IMediaCodecList> codecsList = MediaCodecList::getInstance();
@@ -38,6 +38,9 @@ public:
     bool isSizeSupported(int32_t width, int32_t height,
             bool* useHeic, bool* useGrid, int64_t* stall, AString* hevcName) const;
 
+    // Hash of the encoder capabilities isSizeSupported() answers from
+    uint64_t getCapabilitiesHash() const;
+
     // kGridWidth and kGridHeight should be 2^n
     static const auto kGridWidth = 512;
     static const auto kGridHeight = 512;
@@ -483,7 +483,11 @@ bool JpegRCompositeStream::threadLoop() {
         }
     }
 
+    nsecs_t processingStart = systemTime();
     auto res = processInputFrame(currentTs, mPendingInputFrames[currentTs]);
+    if (res == OK) {
+        mProcessingLatency.add(processingStart, systemTime());
+    }
     Mutex::Autolock l(mMutex);
     if (res != OK) {
         ALOGE("%s: Failed processing frame with timestamp: %" PRIu64 ": %s (%d)", __FUNCTION__,
@@ -713,6 +717,7 @@ status_t JpegRCompositeStream::deleteInternalStreams() {
         ALOGE("%s: Failed to join with the main processing thread: %s (%d)", __FUNCTION__,
                 strerror(-ret), ret);
     }
+    mProcessingLatency.log("Stream %d Jpeg/R processing latency", mBlobStreamId);
 
     if (mBlobStreamId >= 0) {
         // Camera devices may not be valid after switching to offline mode.
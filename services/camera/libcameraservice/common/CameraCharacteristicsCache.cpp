@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "CameraCharacteristicsCache"
+//#define LOG_NDEBUG 0
+
+#include <ctype.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include <android-base/file.h>
+#include <android-base/stringprintf.h>
+#include <utils/Log.h>
+
+#include "common/CameraCharacteristicsCache.h"
+
+namespace android {
+
+namespace {
+
+constexpr uint32_t kMagic = 0x45484343; // 'CCHE'
+constexpr uint32_t kFormatVersion = 1;
+
+constexpr uint32_t kFlagSupportNativeZoomRatio = 1 << 0;
+constexpr uint32_t kFlagCompositeJpegRDisabled = 1 << 1;
+
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t keySize;
+    uint32_t flags;
+    uint64_t metadataSize;
+    // FNV-1a of the key and metadata
+    uint64_t checksum;
+};
+
+constexpr uint64_t kFnvOffsetBasis = 0xcbf29ce484222325ULL;
+
+uint64_t fnv1a(const void* data, size_t size, uint64_t hash = kFnvOffsetBasis) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+} // anonymous namespace
+
+CameraCharacteristicsCache::CameraCharacteristicsCache(const std::string& directory,
+        const std::string& buildFingerprint) :
+        mDirectory(directory), mBuildFingerprint(buildFingerprint) {
+}
+
+status_t CameraCharacteristicsCache::load(const Key& key, Entry* entry) {
+    if (entry == nullptr) return BAD_VALUE;
+
+    std::string contents;
+    if (!base::ReadFileToString(path(key), &contents)) {
+        mMisses++;
+        return NAME_NOT_FOUND;
+    }
+
+    FileHeader header;
+    if (contents.size() < sizeof(header)) {
+        ALOGW("%s: Truncated cache entry for %s", __FUNCTION__, key.deviceName.c_str());
+        mInvalid++;
+        return BAD_VALUE;
+    }
+    memcpy(&header, contents.data(), sizeof(header));
+    if (header.magic != kMagic || header.version != kFormatVersion) {
+        // Written by another version of the service
+        mMisses++;
+        return NAME_NOT_FOUND;
+    }
+    if (contents.size() != sizeof(header) + header.keySize + header.metadataSize) {
+        ALOGW("%s: Cache entry for %s has the wrong size", __FUNCTION__,
+                key.deviceName.c_str());
+        mInvalid++;
+        return BAD_VALUE;
+    }
+
+    const char* storedKey = contents.data() + sizeof(header);
+    const char* metadata = storedKey + header.keySize;
+    if (fnv1a(storedKey, header.keySize + header.metadataSize) != header.checksum) {
+        ALOGW("%s: Corrupt cache entry for %s", __FUNCTION__, key.deviceName.c_str());
+        mInvalid++;
+        return BAD_VALUE;
+    }
+    if (keyString(key) != std::string(storedKey, header.keySize)) {
+        ALOGV("%s: Stale cache entry for %s", __FUNCTION__, key.deviceName.c_str());
+        mMisses++;
+        return NAME_NOT_FOUND;
+    }
+
+    // Aligned copy for the metadata structure
+    std::vector<uint64_t> buffer((header.metadataSize + sizeof(uint64_t) - 1) /
+            sizeof(uint64_t));
+    memcpy(buffer.data(), metadata, header.metadataSize);
+    const camera_metadata_t* characteristics =
+            reinterpret_cast<const camera_metadata_t*>(buffer.data());
+    size_t expectedSize = header.metadataSize;
+    if (validate_camera_metadata_structure(characteristics, &expectedSize) != OK) {
+        ALOGW("%s: Malformed metadata in cache entry for %s", __FUNCTION__,
+                key.deviceName.c_str());
+        mInvalid++;
+        return BAD_VALUE;
+    }
+
+    entry->characteristics = characteristics;
+    entry->supportNativeZoomRatio = header.flags & kFlagSupportNativeZoomRatio;
+    entry->compositeJpegRDisabled = header.flags & kFlagCompositeJpegRDisabled;
+    mHits++;
+    return OK;
+}
+
+status_t CameraCharacteristicsCache::store(const Key& key, const Entry& entry) {
+    if (mkdir(mDirectory.c_str(), 0700) != 0 && errno != EEXIST) {
+        ALOGW("%s: Unable to create %s: %s (%d)", __FUNCTION__, mDirectory.c_str(),
+                strerror(errno), errno);
+        return -errno;
+    }
+
+    // Compact copy, without the spare capacity of the in-memory characteristics
+    const camera_metadata_t* characteristics = entry.characteristics.getAndLock();
+    camera_metadata_t* compact = clone_camera_metadata(characteristics);
+    entry.characteristics.unlock(characteristics);
+    if (compact == nullptr) return NO_MEMORY;
+    const size_t metadataSize = get_camera_metadata_size(compact);
+
+    const std::string storedKey = keyString(key);
+    FileHeader header = {
+        .magic = kMagic,
+        .version = kFormatVersion,
+        .keySize = static_cast<uint32_t>(storedKey.size()),
+        .flags = (entry.supportNativeZoomRatio ? kFlagSupportNativeZoomRatio : 0u) |
+                (entry.compositeJpegRDisabled ? kFlagCompositeJpegRDisabled : 0u),
+        .metadataSize = metadataSize,
+        .checksum = 0,
+    };
+    std::string contents(reinterpret_cast<const char*>(&header), sizeof(header));
+    contents.append(storedKey);
+    contents.append(reinterpret_cast<const char*>(compact), metadataSize);
+    free_camera_metadata(compact);
+    header.checksum = fnv1a(contents.data() + sizeof(header), contents.size() - sizeof(header));
+    memcpy(contents.data(), &header, sizeof(header));
+
+    // Replace atomically, so that a crash while writing leaves the previous entry or none
+    const std::string entryPath = path(key);
+    const std::string tmpPath = entryPath + ".tmp";
+    if (!base::WriteStringToFile(contents, tmpPath)) {
+        ALOGW("%s: Unable to write %s: %s (%d)", __FUNCTION__, tmpPath.c_str(),
+                strerror(errno), errno);
+        unlink(tmpPath.c_str());
+        return UNKNOWN_ERROR;
+    }
+    if (rename(tmpPath.c_str(), entryPath.c_str()) != 0) {
+        ALOGW("%s: Unable to rename %s: %s (%d)", __FUNCTION__, tmpPath.c_str(),
+                strerror(errno), errno);
+        unlink(tmpPath.c_str());
+        return UNKNOWN_ERROR;
+    }
+    mStores++;
+    return OK;
+}
+
+uint64_t CameraCharacteristicsCache::hash(const CameraMetadata& metadata) {
+    const camera_metadata_t* buffer = metadata.getAndLock();
+    uint64_t hash = kFnvOffsetBasis;
+    const size_t count = buffer != nullptr ? get_camera_metadata_entry_count(buffer) : 0;
+    for (size_t i = 0; i < count; i++) {
+        camera_metadata_ro_entry_t entry;
+        if (get_camera_metadata_ro_entry(buffer, i, &entry) != OK) continue;
+        hash = fnv1a(&entry.tag, sizeof(entry.tag), hash);
+        hash = fnv1a(&entry.type, sizeof(entry.type), hash);
+        hash = fnv1a(&entry.count, sizeof(entry.count), hash);
+        hash = fnv1a(entry.data.u8, entry.count * camera_metadata_type_size[entry.type], hash);
+    }
+    metadata.unlock(buffer);
+    return hash;
+}
+
+void CameraCharacteristicsCache::dump(int fd) const {
+    dprintf(fd, "  Characteristics cache %s: %d hits, %d misses, %d invalid, %d stored\n",
+            mDirectory.c_str(), mHits.load(), mMisses.load(), mInvalid.load(), mStores.load());
+}
+
+std::string CameraCharacteristicsCache::path(const Key& key) const {
+    std::string name = key.providerName + "_" + key.deviceName;
+    for (auto& c : name) {
+        if (!isalnum(static_cast<unsigned char>(c)) && c != '.' && c != '-') c = '_';
+    }
+    return mDirectory + "/" + name;
+}
+
+std::string CameraCharacteristicsCache::keyString(const Key& key) const {
+    return base::StringPrintf("%s\n%s\n%d\n%016" PRIx64 "\n%08x\n%016" PRIx64 "\n%s",
+            key.providerName.c_str(), key.deviceName.c_str(), key.interfaceVersion,
+            key.halCharacteristicsHash, key.derivationFlags, key.mediaCodecsHash,
+            mBuildFingerprint.c_str());
+}
+
+} // namespace android
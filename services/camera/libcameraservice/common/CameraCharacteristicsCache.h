@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SERVERS_CAMERA_CAMERACHARACTERISTICSCACHE_H
+#define ANDROID_SERVERS_CAMERA_CAMERACHARACTERISTICSCACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include <camera/CameraMetadata.h>
+#include <utils/Errors.h>
+
+namespace android {
+
+/**
+ * On-disk cache of the static metadata the camera service derives from the characteristics
+ * of each camera device (HEIC, Jpeg/R and dynamic depth stream configurations, zoom ratio
+ * overrides, default tags, ...), so that the derivation can be skipped when cameraserver
+ * restarts.
+ *
+ * An entry is only used if it was derived from the same HAL characteristics, by the same
+ * build with the same framework flags and media codecs; otherwise it is derived again and
+ * replaced. Entries are checksummed and their metadata structure validated when loaded.
+ *
+ * Thread safe, as long as concurrent calls are for different devices.
+ */
+class CameraCharacteristicsCache {
+  public:
+    // In the cameraserver data directory
+    static constexpr const char* kDefaultDirectory = "/data/misc/cameraserver/characteristics";
+
+    CameraCharacteristicsCache(const std::string& directory, const std::string& buildFingerprint);
+
+    // What an entry was derived from
+    struct Key {
+        std::string providerName;
+        // Full device instance name, including the device HAL major and minor versions
+        std::string deviceName;
+        int32_t interfaceVersion = 0;
+        // hash() of the characteristics from the HAL
+        uint64_t halCharacteristicsHash = 0;
+        // Framework flags changing the derivation
+        uint32_t derivationFlags = 0;
+        // Capabilities of the media codecs the HEIC tags are derived from. Media codecs are
+        // updated with the media module, without a new build fingerprint.
+        uint64_t mediaCodecsHash = 0;
+    };
+
+    struct Entry {
+        CameraMetadata characteristics;
+        bool supportNativeZoomRatio = false;
+        bool compositeJpegRDisabled = false;
+    };
+
+    /**
+     * Load the entry for the key. Returns NAME_NOT_FOUND if there is none, or it was derived
+     * from something else, and BAD_VALUE if it is corrupt.
+     */
+    status_t load(const Key& key, Entry* entry);
+
+    /**
+     * Store the entry for the key, replacing any previous entry for the device.
+     */
+    status_t store(const Key& key, const Entry& entry);
+
+    // Hash of the entries of the metadata, independent of its layout and capacity
+    static uint64_t hash(const CameraMetadata& metadata);
+
+    void dump(int fd) const;
+
+  private:
+    std::string path(const Key& key) const;
+    std::string keyString(const Key& key) const;
+
+    const std::string mDirectory;
+    const std::string mBuildFingerprint;
+
+    std::atomic<int32_t> mHits{0};
+    std::atomic<int32_t> mMisses{0};
+    std::atomic<int32_t> mInvalid{0};
+    std::atomic<int32_t> mStores{0};
+}; // class CameraCharacteristicsCache
+
+} // namespace android
+
+#endif
@@ -28,6 +28,7 @@
 #include <aidl/android/hardware/camera/device/ICameraDevice.h>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include "common/DepthPhotoProcessor.h"
 #include "hidl/HidlProviderInfo.h"
@@ -43,6 +44,7 @@
 #include <com_android_internal_camera_flags.h>
 #include <com_android_window_flags.h>
 #include <functional>
+#include <thread>
 #include <camera_metadata_hidden.h>
 #include <android-base/parseint.h>
 #include <android-base/logging.h>
@@ -85,6 +87,8 @@ const bool CameraProviderManager::kFrameworkHeicUltraHDRDisabled =
     property_get_bool("ro.camera.disableHeicUltraHDR", false);
 const bool CameraProviderManager::kFrameworkHeicAllowSWCodecs =
     property_get_bool("ro.camera.enableSWHEVC", false);
+const bool CameraProviderManager::kCharacteristicsCacheDisabled =
+    property_get_bool("ro.camera.disableCharacteristicsCache", false);
 
 CameraProviderManager::HidlServiceInteractionProxyImpl
 CameraProviderManager::sHidlServiceInteractionProxy{};
@@ -236,6 +240,19 @@ status_t CameraProviderManager::initialize(wp<CameraProviderManager::StatusListe
 
     mListener = listener;
     mDeviceState = 0;
+    if (mCharacteristicsCache == nullptr && !kCharacteristicsCacheDisabled) {
+        // The derived characteristics depend on the framework, so entries from other system or
+        // vendor builds are not used. Media codecs are part of the key of each entry.
+        char fingerprint[PROPERTY_VALUE_MAX];
+        char vendorFingerprint[PROPERTY_VALUE_MAX];
+        property_get("ro.build.fingerprint", fingerprint, "");
+        property_get("ro.vendor.build.fingerprint", vendorFingerprint, "");
+        mCharacteristicsCache = std::make_unique<CameraCharacteristicsCache>(
+                CameraCharacteristicsCache::kDefaultDirectory,
+                std::string(fingerprint) + "|" + vendorFingerprint);
+    }
+
+    nsecs_t startTime = systemTime();
     auto res = tryToInitAndAddHidlProvidersLocked(hidlProxy);
     if (res != OK) {
         // Logging done in called function;
@@ -244,6 +261,9 @@ status_t CameraProviderManager::initialize(wp<CameraProviderManager::StatusListe
     res = tryToAddAidlProvidersLocked();
 
     IPCThreadState::self()->flushCommands();
+    mInitializeDuration = systemTime() - startTime;
+    ALOGI("%s: Camera providers initialized in %" PRId64 " ms", __FUNCTION__,
+            ns2ms(mInitializeDuration));
 
     return res;
 }
@@ -449,6 +469,19 @@ status_t CameraProviderManager::getCameraInfo(const std::string &id,
 status_t CameraProviderManager::isSessionConfigurationSupported(const std::string& id,
         const SessionConfiguration &configuration, bool overrideForPerfClass,
         bool checkSessionParams, bool *status /*out*/) const {
+    // Answered before for a device that still exists, since the cache is invalidated
+    // whenever a device is removed
+    SessionConfigurationQueryCache::Key cacheKey;
+    bool cacheable = SessionConfigurationQueryCache::makeKey(id, configuration,
+            overrideForPerfClass, checkSessionParams, &cacheKey);
+    if (cacheable) {
+        if (mSessionConfigurationQueryCache.lookup(&cacheKey, status)) {
+            return OK;
+        }
+    } else {
+        mSessionConfigurationQueryCache.countUncacheable();
+    }
+
     std::lock_guard<std::mutex> lock(mInterfaceMutex);
     auto deviceInfo = findDeviceInfoLocked(id);
     if (deviceInfo == nullptr) {
@@ -463,8 +496,12 @@ status_t CameraProviderManager::isSessionConfigurationSupported(const std::strin
                                              hardware::ICameraService::ROTATION_OVERRIDE_NONE);
         return metadata;
     };
-    return deviceInfo->isSessionConfigurationSupported(configuration,
+    status_t res = deviceInfo->isSessionConfigurationSupported(configuration,
             overrideForPerfClass, getMetadata, checkSessionParams, status);
+    if (cacheable && res == OK) {
+        mSessionConfigurationQueryCache.insert(cacheKey, *status);
+    }
+    return res;
 }
 
 status_t  CameraProviderManager::createDefaultRequest(const std::string& cameraId,
@@ -799,6 +836,8 @@ status_t CameraProviderManager::usbDeviceDetached(const std::string &usbDeviceId
 status_t CameraProviderManager::notifyDeviceStateChange(int64_t newState) {
     std::lock_guard<std::mutex> lock(mInterfaceMutex);
     mDeviceState = newState;
+    // The static info of the devices may depend on the device state
+    mSessionConfigurationQueryCache.invalidate();
     status_t res = OK;
     // Make a copy of mProviders because we unlock mInterfaceMutex temporarily
     // within the loop. It's possible that during the time mInterfaceMutex is
@@ -1056,6 +1095,15 @@ hardware::Return<void> CameraProviderManager::onRegistration(
 status_t CameraProviderManager::dump(int fd, const Vector<String16>& args) {
     std::lock_guard<std::mutex> lock(mInterfaceMutex);
 
+    dprintf(fd, "== Camera provider manager: initialized in %" PRId64 " ms ==\n",
+            ns2ms(mInitializeDuration));
+    if (mCharacteristicsCache != nullptr) {
+        mCharacteristicsCache->dump(fd);
+    } else {
+        dprintf(fd, "  Characteristics cache disabled\n");
+    }
+    mSessionConfigurationQueryCache.dump(fd);
+
     for (auto& provider : mProviders) {
         provider->dump(fd, args);
     }
@@ -1064,18 +1112,78 @@ status_t CameraProviderManager::dump(int fd, const Vector<String16>& args) {
 
 void CameraProviderManager::ProviderInfo::initializeProviderInfoCommon(
         const std::vector<std::string> &devices) {
-    for (auto& device : devices) {
+    nsecs_t startTime = systemTime();
+
+    struct NewDevice {
+        std::string name;
         std::string id;
-        status_t res = addDevice(device, CameraDeviceStatus::PRESENT, &id);
+        uint16_t minorVersion = 0;
+        std::unique_ptr<DeviceInfo> deviceInfo;
+    };
+    std::vector<NewDevice> newDevices;
+    newDevices.reserve(devices.size());
+    for (auto& device : devices) {
+        NewDevice newDevice{device};
+        status_t res = checkNewDevice(device, &newDevice.id, &newDevice.minorVersion);
+        if (res == OK) {
+            // Not registered yet, so not caught by checkNewDevice
+            for (auto& other : newDevices) {
+                if (other.id == newDevice.id) {
+                    ALOGE("%s: Device %s: ID %s is already in use", __FUNCTION__,
+                            device.c_str(), newDevice.id.c_str());
+                    res = BAD_VALUE;
+                    break;
+                }
+            }
+        }
         if (res != OK) {
             ALOGE("%s: Unable to enumerate camera device '%s': %s (%d)",
                     __FUNCTION__, device.c_str(), strerror(-res), res);
             continue;
         }
+        newDevices.push_back(std::move(newDevice));
+    }
+
+    // Querying the static info of a device from the HAL and deriving the framework keys from
+    // it is independent of the other devices, so spread the devices over a few threads,
+    // including this one. The caller holds the provider interface for the duration.
+    const size_t threadCount = std::max<size_t>(1,
+            std::min(newDevices.size(), kMaxDeviceInitThreads));
+    std::atomic<size_t> nextDevice{0};
+    auto initializeDevices = [&]() {
+        for (size_t i = nextDevice++; i < newDevices.size(); i = nextDevice++) {
+            NewDevice& newDevice = newDevices[i];
+            nsecs_t deviceStartTime = systemTime();
+            newDevice.deviceInfo = initializeDeviceInfo(newDevice.name, mProviderTagid,
+                    newDevice.id, newDevice.minorVersion);
+            if (newDevice.deviceInfo != nullptr) {
+                newDevice.deviceInfo->mInitDuration = systemTime() - deviceStartTime;
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < threadCount; i++) {
+        workers.emplace_back(initializeDevices);
+    }
+    initializeDevices();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // Register in the order the provider listed the devices
+    for (auto& newDevice : newDevices) {
+        if (newDevice.deviceInfo == nullptr) {
+            ALOGE("%s: Unable to enumerate camera device '%s': %s (%d)",
+                    __FUNCTION__, newDevice.name.c_str(), strerror(-BAD_VALUE), BAD_VALUE);
+            continue;
+        }
+        registerDevice(std::move(newDevice.deviceInfo), CameraDeviceStatus::PRESENT);
     }
+    mInitDuration = systemTime() - startTime;
+    mInitThreadCount = threadCount;
 
-    ALOGI("Camera provider %s ready with %zu camera devices",
-            mProviderName.c_str(), mDevices.size());
+    ALOGI("Camera provider %s ready with %zu camera devices in %" PRId64 " ms",
+            mProviderName.c_str(), mDevices.size(), ns2ms(mInitDuration));
 
     // Process cached status callbacks
     {
@@ -2426,6 +2534,7 @@ status_t CameraProviderManager::filterSmallJpegSizes(const std::string& cameraId
     for (auto& provider : mProviders) {
         for (auto& deviceInfo : provider->mDevices) {
             if (deviceInfo->mId == cameraId) {
+                mSessionConfigurationQueryCache.invalidate();
                 return deviceInfo->filterSmallJpegSizes();
             }
         }
@@ -2631,6 +2740,7 @@ status_t CameraProviderManager::removeProvider(const std::string& provider) {
             }
             removedProviderName = (*it)->mProviderName;
             mProviders.erase(it);
+            mSessionConfigurationQueryCache.invalidate();
             res = OK;
             break;
         }
@@ -2702,14 +2812,34 @@ const std::string& CameraProviderManager::ProviderInfo::getType() const {
 status_t CameraProviderManager::ProviderInfo::addDevice(
         const std::string& name, CameraDeviceStatus initialStatus,
         /*out*/ std::string* parsedId) {
+    std::string id;
+    uint16_t minor;
+    status_t res = checkNewDevice(name, &id, &minor);
+    if (res != OK) {
+        return res;
+    }
+
+    nsecs_t startTime = systemTime();
+    std::unique_ptr<DeviceInfo> deviceInfo = initializeDeviceInfo(name, mProviderTagid, id, minor);
+    if (deviceInfo == nullptr) return BAD_VALUE;
+    deviceInfo->mInitDuration = systemTime() - startTime;
+    registerDevice(std::move(deviceInfo), initialStatus);
+
+    if (parsedId != nullptr) {
+        *parsedId = id;
+    }
+    return OK;
+}
 
+status_t CameraProviderManager::ProviderInfo::checkNewDevice(const std::string& name,
+        /*out*/ std::string* id, /*out*/ uint16_t* minorVersion) {
     ALOGI("Enumerating new camera device: %s", name.c_str());
 
     uint16_t major, minor;
-    std::string type, id;
+    std::string type;
     IPCTransport transport = getIPCTransport();
 
-    status_t res = parseDeviceName(name, &major, &minor, &type, &id);
+    status_t res = parseDeviceName(name, &major, &minor, &type, id);
     if (res != OK) {
         return res;
     }
@@ -2719,13 +2849,12 @@ status_t CameraProviderManager::ProviderInfo::addDevice(
                 type.c_str(), mType.c_str());
         return BAD_VALUE;
     }
-    if (mManager->isValidDeviceLocked(id, major, transport)) {
+    if (mManager->isValidDeviceLocked(*id, major, transport)) {
         ALOGE("%s: Device %s: ID %s is already in use for device major version %d", __FUNCTION__,
-                name.c_str(), id.c_str(), major);
+                name.c_str(), id->c_str(), major);
         return BAD_VALUE;
     }
 
-    std::unique_ptr<DeviceInfo> deviceInfo;
     switch (transport) {
         case IPCTransport::HIDL:
             switch (major) {
@@ -2749,13 +2878,19 @@ status_t CameraProviderManager::ProviderInfo::addDevice(
             return BAD_VALUE;
     }
 
-    deviceInfo = initializeDeviceInfo(name, mProviderTagid, id, minor);
-    if (deviceInfo == nullptr) return BAD_VALUE;
+    *minorVersion = minor;
+    return OK;
+}
+
+void CameraProviderManager::ProviderInfo::registerDevice(std::unique_ptr<DeviceInfo> deviceInfo,
+        CameraDeviceStatus initialStatus) {
+    const std::string id = deviceInfo->mId;
     deviceInfo->notifyDeviceStateChange(getDeviceState());
     deviceInfo->mStatus = initialStatus;
     bool isAPI1Compatible = deviceInfo->isAPI1Compatible();
 
     mDevices.push_back(std::move(deviceInfo));
+    mManager->mSessionConfigurationQueryCache.invalidate();
 
     mUniqueCameraIds.insert(id);
     if (isAPI1Compatible) {
@@ -2766,11 +2901,6 @@ status_t CameraProviderManager::ProviderInfo::addDevice(
             mUniqueAPI1CompatibleCameraIds.push_back(id);
         }
     }
-
-    if (parsedId != nullptr) {
-        *parsedId = id;
-    }
-    return OK;
 }
 
 void CameraProviderManager::ProviderInfo::removeDevice(const std::string &id) {
@@ -2790,6 +2920,7 @@ void CameraProviderManager::ProviderInfo::removeDevice(const std::string &id) {
             mManager->removeRef(DeviceMode::TORCH, id);
 
             mDevices.erase(it);
+            mManager->mSessionConfigurationQueryCache.invalidate();
             break;
         }
     }
@@ -2849,10 +2980,15 @@ status_t CameraProviderManager::ProviderInfo::dump(int fd, const Vector<String16
             mMinorVersion,
             mIsRemote ? "remote" : "passthrough",
             mDevices.size());
+    dprintf(fd, "  Initialized in %" PRId64 " ms using %zu threads\n", ns2ms(mInitDuration),
+            mInitThreadCount);
 
     for (auto& device : mDevices) {
         dprintf(fd, "== Camera HAL device %s (v%d.%d) static information: ==\n", device->mName.c_str(),
                 device->mVersion.get_major(), device->mVersion.get_minor());
+        dprintf(fd, "  Initialized in %" PRId64 " ms, derived characteristics %s\n",
+                ns2ms(device->mInitDuration),
+                device->mCharacteristicsFromCache ? "cached" : "not cached");
         dprintf(fd, "  Resource cost: %d\n", device->mResourceCost.resourceCost);
         if (device->mResourceCost.conflictingDevices.size() == 0) {
             dprintf(fd, "  Conflicting devices: None\n");
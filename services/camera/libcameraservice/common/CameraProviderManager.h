@@ -44,6 +44,8 @@
 #include <binder/IServiceManager.h>
 #include <camera/VendorTagDescriptor.h>
 
+#include "common/CameraCharacteristicsCache.h"
+#include "common/SessionConfigurationQueryCache.h"
 #include "config/SharedSessionConfigUtils.h"
 
 namespace android {
@@ -484,6 +486,7 @@ public:
     static const bool kFrameworkJpegRDisabled;
     static const bool kFrameworkHeicUltraHDRDisabled;
     static const bool kFrameworkHeicAllowSWCodecs;
+    static const bool kCharacteristicsCacheDisabled;
 
 private:
     // All private members, unless otherwise noted, expect mInterfaceMutex to be locked before use
@@ -496,6 +499,17 @@ private:
     // Current overall Android device physical status
     int64_t mDeviceState;
 
+    // Static metadata derived from the characteristics of the devices, saved across
+    // cameraserver restarts. Null if disabled.
+    std::unique_ptr<CameraCharacteristicsCache> mCharacteristicsCache;
+
+    // Time taken by initialize() to enumerate the providers and their devices
+    nsecs_t mInitializeDuration = 0;
+
+    // Answers of isSessionConfigurationSupported, invalidated whenever a device is added or
+    // removed, or its static info changes. Has its own lock.
+    mutable SessionConfigurationQueryCache mSessionConfigurationQueryCache;
+
     // mProviderLifecycleLock is locked during onRegistration and removeProvider
     mutable std::mutex mProviderLifecycleLock;
 
@@ -635,6 +649,11 @@ private:
             int32_t mTorchMaximumStrengthLevel;
             int32_t mTorchDefaultStrengthLevel;
 
+            // Time taken to query and derive the static info, and whether the derived
+            // characteristics came from the characteristics cache
+            nsecs_t mInitDuration = 0;
+            bool mCharacteristicsFromCache = false;
+
             // Wait for lazy HALs to confirm device availability
             static const nsecs_t kDeviceAvailableTimeout = 2000e6; // 2000 ms
             Mutex     mDeviceAvailableLock;
@@ -849,6 +868,12 @@ private:
         std::vector<CameraStatusInfoT> mCachedStatus;
         // End of scope for mInitLock
 
+        // Maximum number of devices initialized concurrently by initializeProviderInfoCommon
+        static constexpr size_t kMaxDeviceInitThreads = 4;
+        // Time taken by initializeProviderInfoCommon, and the number of threads it used
+        nsecs_t mInitDuration = 0;
+        size_t mInitThreadCount = 0;
+
         std::unique_ptr<ProviderInfo::DeviceInfo>
         virtual initializeDeviceInfo(
                 const std::string &name, const metadata_vendor_id_t tagId,
@@ -873,6 +898,13 @@ private:
                 const std::string& name, CameraDeviceStatus initialStatus,
                 /*out*/ std::string* parsedId);
 
+        // The steps of addDevice before and after initializeDeviceInfo, which may run
+        // concurrently for different devices
+        status_t checkNewDevice(const std::string& name,
+                /*out*/ std::string* id, /*out*/ uint16_t* minorVersion);
+        void registerDevice(std::unique_ptr<DeviceInfo> deviceInfo,
+                CameraDeviceStatus initialStatus);
+
         void cameraDeviceStatusChangeInternal(const std::string& cameraDeviceName,
                 CameraDeviceStatus newStatus);
 
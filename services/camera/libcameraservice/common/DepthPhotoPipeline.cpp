@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "Camera3-DepthPhotoPipeline"
+#define ATRACE_TAG ATRACE_TAG_CAMERA
+//#define LOG_NDEBUG 0
+
+#include <pthread.h>
+
+#include <algorithm>
+
+#include <utils/Log.h>
+#include <utils/Trace.h>
+
+#include "common/DepthPhotoPipeline.h"
+
+namespace android {
+namespace camera3 {
+
+void DepthPhotoPipeline::StageStats::add(nsecs_t duration) {
+    count++;
+    total += duration;
+    max = std::max(max, duration);
+}
+
+DepthPhotoPipeline::DepthPhotoPipeline(size_t workerCount, size_t maxInFlight) :
+        mMaxInFlight(std::max<size_t>(maxInFlight, 1)) {
+    workerCount = std::max<size_t>(workerCount, 1);
+    mWorkers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; i++) {
+        mWorkers.emplace_back([this]() {
+            pthread_setname_np(pthread_self(), "DepthPhotoProc");
+            workerLoop();
+        });
+    }
+}
+
+DepthPhotoPipeline::~DepthPhotoPipeline() {
+    waitForIdle();
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mExiting = true;
+    }
+    mWorkAvailable.notify_all();
+    mFrameCompleted.notify_all();
+    for (auto& worker : mWorkers) {
+        worker.join();
+    }
+}
+
+status_t DepthPhotoPipeline::submit(const DepthPhotoInputFrame& input, size_t outputSize,
+        void* output, Completion completion) {
+    std::unique_lock<std::mutex> lock(mLock);
+    mFrameCompleted.wait(lock, [this]() {
+        return mExiting || mFrames.size() < mMaxInFlight;
+    });
+    if (mExiting) {
+        return INVALID_OPERATION;
+    }
+
+    mFrames.push_back(Frame{input, outputSize, output, std::move(completion), systemTime()});
+    mQueue.push_back(&mFrames.back());
+    lock.unlock();
+    mWorkAvailable.notify_one();
+
+    return OK;
+}
+
+void DepthPhotoPipeline::waitForIdle() {
+    std::unique_lock<std::mutex> lock(mLock);
+    mFrameCompleted.wait(lock, [this]() { return mFrames.empty() && !mDelivering; });
+}
+
+size_t DepthPhotoPipeline::inFlight() const {
+    std::lock_guard<std::mutex> lock(mLock);
+    return mFrames.size();
+}
+
+DepthPhotoPipeline::Stats DepthPhotoPipeline::getStats() const {
+    std::lock_guard<std::mutex> lock(mLock);
+    return mStats;
+}
+
+void DepthPhotoPipeline::workerLoop() {
+    std::unique_lock<std::mutex> lock(mLock);
+    while (true) {
+        mWorkAvailable.wait(lock, [this]() { return mExiting || !mQueue.empty(); });
+        if (mQueue.empty()) {
+            return;
+        }
+        Frame* frame = mQueue.front();
+        mQueue.pop_front();
+        lock.unlock();
+
+        Result& result = frame->result;
+        nsecs_t start = systemTime();
+        result.queueTime = start - frame->submitTime;
+        {
+            ATRACE_NAME("processDepthPhotoFrame");
+            result.status = processDepthPhotoFrame(frame->input, frame->outputSize,
+                    frame->output, &result.actualSize, &result.stageTimes);
+        }
+        result.totalTime = systemTime() - frame->submitTime;
+
+        lock.lock();
+        frame->done = true;
+        mStats.queue.add(result.queueTime);
+        if (result.status == OK) {
+            mStats.depthMapEncoding.add(result.stageTimes.mDepthMapEncoding);
+            mStats.mainImagePackaging.add(result.stageTimes.mMainImagePackaging);
+            mStats.containerAssembly.add(result.stageTimes.mContainerAssembly);
+            mStats.total.add(result.totalTime);
+        } else {
+            ALOGV("%s: Depth photo processing failed: %s (%d)", __FUNCTION__,
+                    strerror(-result.status), result.status);
+            mStats.failures++;
+        }
+        deliverLocked(lock);
+    }
+}
+
+void DepthPhotoPipeline::deliverLocked(std::unique_lock<std::mutex>& lock) {
+    if (mDelivering) {
+        // The thread delivering now will also deliver this frame once it's the oldest one
+        return;
+    }
+
+    mDelivering = true;
+    while (!mFrames.empty() && mFrames.front().done) {
+        // Only the delivering thread removes frames, so the front one stays valid, and keeps
+        // counting as in flight until its buffers are handed back.
+        Frame& frame = mFrames.front();
+        lock.unlock();
+        if (frame.completion) {
+            frame.completion(frame.result);
+        }
+        lock.lock();
+        mFrames.pop_front();
+        mFrameCompleted.notify_all();
+    }
+    mDelivering = false;
+    mFrameCompleted.notify_all();
+}
+
+}; // namespace camera3
+}; // namespace android
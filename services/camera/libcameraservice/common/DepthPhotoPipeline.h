@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SERVERS_CAMERA_CAMERA3_DEPTH_PHOTO_PIPELINE_H
+#define ANDROID_SERVERS_CAMERA_CAMERA3_DEPTH_PHOTO_PIPELINE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <utils/Errors.h>
+#include <utils/Timers.h>
+
+#include "common/DepthPhotoProcessor.h"
+
+namespace android {
+namespace camera3 {
+
+/**
+ * Processes depth photo frames on a small pool of worker threads.
+ *
+ * Consecutive frames overlap: while one worker assembles the container of a frame, another one
+ * encodes the depth map of the next. At most 'maxInFlight' frames are accepted at a time, which
+ * bounds the input and output buffers held by the pipeline. Completions are delivered one at a
+ * time, in submission order, from one of the worker threads.
+ *
+ * Thread safe.
+ */
+class DepthPhotoPipeline {
+  public:
+    static constexpr size_t kDefaultWorkerCount = 2;
+    static constexpr size_t kDefaultMaxInFlight = 2;
+
+    struct Result {
+        status_t status = OK;
+        size_t actualSize = 0;
+        DepthPhotoStageTimes stageTimes;
+        // Time from submission until a worker picked the frame up, and until it was processed
+        nsecs_t queueTime = 0;
+        nsecs_t totalTime = 0;
+    };
+    using Completion = std::function<void(const Result&)>;
+
+    explicit DepthPhotoPipeline(size_t workerCount = kDefaultWorkerCount,
+            size_t maxInFlight = kDefaultMaxInFlight);
+    // Waits for all submitted frames to complete
+    ~DepthPhotoPipeline();
+
+    /**
+     * Queue a frame for processing into 'output'. The input and output buffers must stay valid
+     * until 'completion' is called. Blocks while 'maxInFlight' frames are in flight, so must not
+     * be called from a completion.
+     */
+    status_t submit(const DepthPhotoInputFrame& input, size_t outputSize, void* output,
+            Completion completion);
+
+    // Wait until all submitted frames have completed
+    void waitForIdle();
+
+    // Number of frames submitted and not completed yet
+    size_t inFlight() const;
+    size_t maxInFlight() const { return mMaxInFlight; }
+
+    struct StageStats {
+        int64_t count = 0;
+        nsecs_t total = 0;
+        nsecs_t max = 0;
+
+        void add(nsecs_t duration);
+        nsecs_t mean() const { return count > 0 ? total / count : 0; }
+    };
+    struct Stats {
+        StageStats depthMapEncoding;
+        StageStats mainImagePackaging;
+        StageStats containerAssembly;
+        StageStats queue;
+        StageStats total;
+        int64_t failures = 0;
+    };
+    Stats getStats() const;
+
+  private:
+    struct Frame {
+        DepthPhotoInputFrame input;
+        size_t outputSize;
+        void* output;
+        Completion completion;
+        nsecs_t submitTime;
+        bool done = false;
+        Result result;
+    };
+
+    void workerLoop();
+    // Deliver the completions of the oldest frames, as long as they are done
+    void deliverLocked(std::unique_lock<std::mutex>& lock);
+
+    const size_t mMaxInFlight;
+
+    mutable std::mutex mLock;
+    std::condition_variable mWorkAvailable;
+    std::condition_variable mFrameCompleted;
+    // All frames not completed yet, in submission order
+    std::list<Frame> mFrames;
+    // Frames waiting for a worker
+    std::deque<Frame*> mQueue;
+    bool mDelivering = false;
+    bool mExiting = false;
+    Stats mStats;
+
+    std::vector<std::thread> mWorkers;
+}; // class DepthPhotoPipeline
+
+}; // namespace camera3
+}; // namespace android
+
+#endif
@@ -36,6 +36,8 @@
 #include <libexif/exif-system.h>
 #include <math.h>
 #include <sstream>
+#include <streambuf>
+#include <thread>
 #include <utils/Errors.h>
 #include <utils/ExifUtils.h>
 #include <utils/Log.h>
@@ -392,36 +394,78 @@ std::unique_ptr<dynamic_depth::DepthMap> processDepthMapFrame(DepthPhotoInputFra
     depthParams.mime = "image/jpeg";
     depthParams.depth_image_data.resize(inputFrame.mMaxJpegSize);
     depthParams.confidence_data.resize(inputFrame.mMaxJpegSize);
+    // Both maps are independent of each other, the confidence map is encoded concurrently.
+    size_t actualConfidenceSize = 0;
+    status_t confidenceRet = NO_ERROR;
+    std::thread confidenceEncoder([&]() {
+        confidenceRet = encodeGrayscaleJpeg(width, height, confidenceQuantized.data(),
+                depthParams.confidence_data.data(), inputFrame.mMaxJpegSize,
+                inputFrame.mJpegQuality, exifOrientation, actualConfidenceSize);
+    });
     size_t actualJpegSize;
     auto ret = encodeGrayscaleJpeg(width, height, pointsQuantized.data(),
             depthParams.depth_image_data.data(), inputFrame.mMaxJpegSize,
             inputFrame.mJpegQuality, exifOrientation, actualJpegSize);
+    confidenceEncoder.join();
     if (ret != NO_ERROR) {
         ALOGE("%s: Depth map compression failed!", __FUNCTION__);
         return nullptr;
     }
     depthParams.depth_image_data.resize(actualJpegSize);
 
-    ret = encodeGrayscaleJpeg(width, height, confidenceQuantized.data(),
-            depthParams.confidence_data.data(), inputFrame.mMaxJpegSize,
-            inputFrame.mJpegQuality, exifOrientation, actualJpegSize);
-    if (ret != NO_ERROR) {
+    if (confidenceRet != NO_ERROR) {
         ALOGE("%s: Confidence map compression failed!", __FUNCTION__);
         return nullptr;
     }
-    depthParams.confidence_data.resize(actualJpegSize);
+    depthParams.confidence_data.resize(actualConfidenceSize);
 
     return DepthMap::FromData(depthParams, items);
 }
 
+// Read-only stream buffer over the main image, so that it doesn't need to be copied before
+// being written out with the depth photo metadata.
+class MemoryInputStreamBuf : public std::streambuf {
+public:
+    MemoryInputStreamBuf(const char* data, size_t size) {
+        char* begin = const_cast<char*>(data);
+        setg(begin, begin, begin + size);
+    }
+
+protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+            std::ios_base::openmode which) override {
+        if ((which & std::ios_base::in) == 0) {
+            return pos_type(off_type(-1));
+        }
+        off_type position = off;
+        if (dir == std::ios_base::cur) {
+            position += gptr() - eback();
+        } else if (dir == std::ios_base::end) {
+            position += egptr() - eback();
+        }
+        if ((position < 0) || (position > egptr() - eback())) {
+            return pos_type(off_type(-1));
+        }
+        setg(eback(), eback() + position, egptr());
+        return pos_type(position);
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+};
+
 int processDepthPhotoFrame(DepthPhotoInputFrame inputFrame, size_t depthPhotoBufferSize,
-        void* depthPhotoBuffer /*out*/, size_t* depthPhotoActualSize /*out*/) {
+        void* depthPhotoBuffer /*out*/, size_t* depthPhotoActualSize /*out*/,
+        DepthPhotoStageTimes* stageTimes /*out*/) {
     if ((inputFrame.mMainJpegBuffer == nullptr) || (inputFrame.mDepthMapBuffer == nullptr) ||
             (depthPhotoBuffer == nullptr) || (depthPhotoActualSize == nullptr) ||
             (inputFrame.mMaxJpegSize < MIN_JPEG_BUFFER_SIZE)) {
         return BAD_VALUE;
     }
 
+    DepthPhotoStageTimes times;
+    nsecs_t stageStart = systemTime();
     std::vector<std::unique_ptr<Item>> items;
     std::vector<std::unique_ptr<Camera>> cameraList;
     auto image = Image::FromDataForPrimaryImage("image/jpeg", &items);
@@ -434,6 +478,10 @@ int processDepthPhotoFrame(DepthPhotoInputFrame inputFrame, size_t depthPhotoBuf
     ExifOrientation exifOrientation = getExifOrientation(
             reinterpret_cast<const unsigned char*> (inputFrame.mMainJpegBuffer),
             inputFrame.mMainJpegSize);
+    nsecs_t stageEnd = systemTime();
+    times.mMainImagePackaging = stageEnd - stageStart;
+    stageStart = stageEnd;
+
     bool switchDimensions;
     cameraParams->depth_map = processDepthMapFrame(inputFrame, exifOrientation, &items,
             &switchDimensions);
@@ -441,6 +489,9 @@ int processDepthPhotoFrame(DepthPhotoInputFrame inputFrame, size_t depthPhotoBuf
         ALOGE("%s: Depth map processing failed!", __FUNCTION__);
         return BAD_VALUE;
     }
+    stageEnd = systemTime();
+    times.mDepthMapEncoding = stageEnd - stageStart;
+    stageStart = stageEnd;
 
     // It is not possible to generate an imaging model without intrinsic calibration.
     if (inputFrame.mIsIntrinsicCalibrationValid) {
@@ -476,6 +527,9 @@ int processDepthPhotoFrame(DepthPhotoInputFrame inputFrame, size_t depthPhotoBuf
 
         cameraParams->imaging_model = ImagingModel::FromData(imagingParams);
     }
+    stageEnd = systemTime();
+    times.mMainImagePackaging += stageEnd - stageStart;
+    stageStart = stageEnd;
 
     if (inputFrame.mIsLogical) {
         cameraParams->trait = dynamic_depth::CameraTrait::LOGICAL;
@@ -496,9 +550,9 @@ int processDepthPhotoFrame(DepthPhotoInputFrame inputFrame, size_t depthPhotoBuf
         return BAD_VALUE;
     }
 
-    std::istringstream inputJpegStream(
-            std::string(inputFrame.mMainJpegBuffer, inputFrame.mMainJpegSize));
-    std::ostringstream outputJpegStream;
+    MemoryInputStreamBuf inputJpegBuffer(inputFrame.mMainJpegBuffer, inputFrame.mMainJpegSize);
+    std::istream inputJpegStream(&inputJpegBuffer);
+    std::stringstream outputJpegStream;
     if (!WriteImageAndMetadataAndContainer(&inputJpegStream, device.get(), &outputJpegStream)) {
         ALOGE("%s: Failed writing depth output", __FUNCTION__);
         return BAD_VALUE;
@@ -511,7 +565,17 @@ int processDepthPhotoFrame(DepthPhotoInputFrame inputFrame, size_t depthPhotoBuf
         return NO_MEMORY;
     }
 
-    memcpy(depthPhotoBuffer, outputJpegStream.str().c_str(), *depthPhotoActualSize);
+    // Read the output back directly, instead of through a copy of the whole string
+    if (outputJpegStream.rdbuf()->sgetn(static_cast<char*>(depthPhotoBuffer),
+            *depthPhotoActualSize) != static_cast<std::streamsize>(*depthPhotoActualSize)) {
+        ALOGE("%s: Failed reading back depth output", __FUNCTION__);
+        return BAD_VALUE;
+    }
+    times.mContainerAssembly = systemTime() - stageStart;
+
+    if (stageTimes != nullptr) {
+        *stageTimes = times;
+    }
 
     return 0;
 }
@@ -20,6 +20,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <utils/Timers.h>
+
 namespace android {
 namespace camera3 {
 
@@ -67,9 +69,20 @@ struct DepthPhotoInputFrame {
             mOrientation(DepthPhotoOrientation::DEPTH_ORIENTATION_0_DEGREES) {}
 };
 
+// Time spent in each stage of processing a depth photo frame
+struct DepthPhotoStageTimes {
+    // Unpacking, quantization and JPEG encoding of the depth and confidence maps
+    nsecs_t mDepthMapEncoding = 0;
+    // EXIF orientation of the main image, primary image item and imaging model
+    nsecs_t mMainImagePackaging = 0;
+    // Dynamic depth metadata, and the main image with XMP and container written out
+    nsecs_t mContainerAssembly = 0;
+};
+
 int processDepthPhotoFrame(DepthPhotoInputFrame /*inputFrame*/,
         size_t /*depthPhotoBufferSize*/, void* /*depthPhotoBuffer out*/,
-        size_t* /*depthPhotoActualSize out*/);
+        size_t* /*depthPhotoActualSize out*/,
+        DepthPhotoStageTimes* /*stageTimes out*/ = nullptr);
 
 }; // namespace camera3
 }; // namespace android
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "SessionConfigurationQueryCache"
+//#define LOG_NDEBUG 0
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <utils/Log.h>
+
+#include "common/SessionConfigurationQueryCache.h"
+
+namespace android {
+
+using hardware::camera2::params::OutputConfiguration;
+using hardware::camera2::params::SessionConfiguration;
+
+namespace {
+
+void append(std::string* encoding, int64_t value) {
+    encoding->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void append(std::string* encoding, const std::string& value) {
+    append(encoding, static_cast<int64_t>(value.size()));
+    encoding->append(value);
+}
+
+// Entries sorted by tag, so that the encoding doesn't depend on the order the app set them in
+void appendMetadata(std::string* encoding, const CameraMetadata& metadata) {
+    const camera_metadata_t* buffer = metadata.getAndLock();
+    const size_t count = buffer != nullptr ? get_camera_metadata_entry_count(buffer) : 0;
+    std::vector<camera_metadata_ro_entry_t> entries;
+    entries.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        camera_metadata_ro_entry_t entry;
+        if (get_camera_metadata_ro_entry(buffer, i, &entry) == OK) {
+            entries.push_back(entry);
+        }
+    }
+    std::sort(entries.begin(), entries.end(),
+            [](const auto& a, const auto& b) { return a.tag < b.tag; });
+
+    append(encoding, static_cast<int64_t>(entries.size()));
+    for (const auto& entry : entries) {
+        append(encoding, entry.tag);
+        append(encoding, entry.type);
+        append(encoding, static_cast<int64_t>(entry.count));
+        encoding->append(reinterpret_cast<const char*>(entry.data.u8),
+                entry.count * camera_metadata_type_size[entry.type]);
+    }
+    metadata.unlock(buffer);
+}
+
+void appendOutput(std::string* encoding, const OutputConfiguration& output) {
+    append(encoding, output.getSurfaceType());
+    append(encoding, output.getWidth());
+    append(encoding, output.getHeight());
+    append(encoding, output.getFormat());
+    append(encoding, output.getDataspace());
+    append(encoding, output.getUsage());
+    append(encoding, output.getRotation());
+    append(encoding, output.getSurfaceSetID());
+    append(encoding, output.isDeferred());
+    append(encoding, output.isShared());
+    append(encoding, output.getPhysicalCameraId());
+    append(encoding, output.isMultiResolution());
+    append(encoding, output.getDynamicRangeProfile());
+    append(encoding, output.getColorSpace());
+    append(encoding, output.getStreamUseCase());
+    append(encoding, output.getTimestampBase());
+    append(encoding, output.getMirrorMode());
+    append(encoding, output.useReadoutTimestamp());
+
+    std::vector<int32_t> sensorPixelModes = output.getSensorPixelModesUsed();
+    std::sort(sensorPixelModes.begin(), sensorPixelModes.end());
+    append(encoding, static_cast<int64_t>(sensorPixelModes.size()));
+    for (int32_t mode : sensorPixelModes) {
+        append(encoding, mode);
+    }
+}
+
+} // anonymous namespace
+
+SessionConfigurationQueryCache::SessionConfigurationQueryCache(size_t capacity) :
+        mCapacity(capacity) {
+}
+
+bool SessionConfigurationQueryCache::makeKey(const std::string& cameraId,
+        const SessionConfiguration& configuration, bool overrideForPerfClass,
+        bool checkSessionParams, /*out*/ Key* key) {
+    if (key == nullptr) return false;
+
+    const auto& outputs = configuration.getOutputConfigurations();
+    for (const auto& output : outputs) {
+        if (!output.getSurfaces().empty()) {
+            return false;
+        }
+    }
+
+    std::string& encoding = key->encoding;
+    encoding.clear();
+    append(&encoding, cameraId);
+    append(&encoding, overrideForPerfClass);
+    append(&encoding, checkSessionParams);
+    append(&encoding, configuration.getOperatingMode());
+    append(&encoding, configuration.getInputWidth());
+    append(&encoding, configuration.getInputHeight());
+    append(&encoding, configuration.getInputFormat());
+    append(&encoding, configuration.inputIsMultiResolution());
+    append(&encoding, static_cast<int64_t>(outputs.size()));
+    for (const auto& output : outputs) {
+        appendOutput(&encoding, output);
+    }
+    append(&encoding, configuration.hasSessionParameters());
+    if (configuration.hasSessionParameters()) {
+        appendMetadata(&encoding, configuration.getSessionParameters());
+    }
+
+    key->hash = std::hash<std::string>{}(encoding);
+    return true;
+}
+
+bool SessionConfigurationQueryCache::lookup(Key* key, /*out*/ bool* supported) {
+    std::lock_guard<std::mutex> lock(mLock);
+    key->generation = mGeneration;
+    auto range = mIndex.equal_range(key->hash);
+    for (auto it = range.first; it != range.second; it++) {
+        if (it->second->second.encoding == key->encoding) {
+            mEntries.splice(mEntries.begin(), mEntries, it->second);
+            *supported = it->second->second.supported;
+            mHits++;
+            return true;
+        }
+    }
+    mMisses++;
+    return false;
+}
+
+void SessionConfigurationQueryCache::insert(const Key& key, bool supported) {
+    std::lock_guard<std::mutex> lock(mLock);
+    if (key.generation != mGeneration || mCapacity == 0) {
+        return;
+    }
+
+    auto range = mIndex.equal_range(key.hash);
+    for (auto it = range.first; it != range.second; it++) {
+        if (it->second->second.encoding == key.encoding) {
+            // Answered concurrently
+            it->second->second.supported = supported;
+            return;
+        }
+    }
+    mEntries.emplace_front(key.hash, Entry{key.encoding, supported});
+    mIndex.emplace(key.hash, mEntries.begin());
+
+    if (mEntries.size() > mCapacity) {
+        auto oldest = std::prev(mEntries.end());
+        auto oldestRange = mIndex.equal_range(oldest->first);
+        for (auto it = oldestRange.first; it != oldestRange.second; it++) {
+            if (it->second == oldest) {
+                mIndex.erase(it);
+                break;
+            }
+        }
+        mEntries.erase(oldest);
+    }
+}
+
+void SessionConfigurationQueryCache::invalidate() {
+    std::lock_guard<std::mutex> lock(mLock);
+    mEntries.clear();
+    mIndex.clear();
+    mGeneration++;
+    mInvalidations++;
+}
+
+void SessionConfigurationQueryCache::dump(int fd) const {
+    size_t entryCount;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        entryCount = mEntries.size();
+    }
+    dprintf(fd, "  Session configuration query cache: %zu entries, %d hits, %d misses, "
+            "%d uncacheable, %d invalidations\n", entryCount, mHits.load(), mMisses.load(),
+            mUncacheable.load(), mInvalidations.load());
+}
+
+} // namespace android
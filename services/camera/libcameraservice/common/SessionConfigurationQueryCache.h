@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SERVERS_CAMERA_SESSIONCONFIGURATIONQUERYCACHE_H
+#define ANDROID_SERVERS_CAMERA_SESSIONCONFIGURATIONQUERYCACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <camera/camera2/SessionConfiguration.h>
+
+namespace android {
+
+/**
+ * Memoized answers to session configuration support queries.
+ *
+ * Apps, and CameraX in particular, probe many stream combinations while starting up, and the
+ * same ones again each time they rebind. Each query converts the configuration to a HAL stream
+ * combination and asks the HAL, whose answer only depends on the configuration and on the
+ * static info of the device.
+ *
+ * Only configurations fully described by their values are cached: outputs with surfaces are
+ * not, since the properties of a surface can change. The whole cache must be invalidated when
+ * the providers or their devices change.
+ *
+ * Thread safe.
+ */
+class SessionConfigurationQueryCache {
+  public:
+    // Number of answers kept; the least recently used ones are evicted first
+    static constexpr size_t kDefaultCapacity = 256;
+
+    explicit SessionConfigurationQueryCache(size_t capacity = kDefaultCapacity);
+
+    struct Key {
+        // Canonical encoding of the query, and its hash
+        std::string encoding;
+        uint64_t hash = 0;
+        // Generation of the cache when the key was looked up
+        uint32_t generation = 0;
+    };
+
+    /**
+     * Build the key of a query. Returns false if the configuration can't be cached.
+     */
+    static bool makeKey(const std::string& cameraId,
+            const hardware::camera2::params::SessionConfiguration& configuration,
+            bool overrideForPerfClass, bool checkSessionParams, /*out*/ Key* key);
+
+    /**
+     * Look up the answer to a query. On a miss, the answer can be inserted with the same key
+     * once known; it is dropped if the cache was invalidated in between.
+     */
+    bool lookup(Key* key, /*out*/ bool* supported);
+    void insert(const Key& key, bool supported);
+
+    /**
+     * Drop all answers, e.g. because a provider or device was added or removed.
+     */
+    void invalidate();
+
+    int32_t hits() const { return mHits.load(); }
+    int32_t misses() const { return mMisses.load(); }
+    int32_t uncacheable() const { return mUncacheable.load(); }
+    void countUncacheable() { mUncacheable++; }
+
+    void dump(int fd) const;
+
+  private:
+    struct Entry {
+        std::string encoding;
+        bool supported;
+    };
+    using EntryList = std::list<std::pair<uint64_t, Entry>>;
+
+    const size_t mCapacity;
+
+    mutable std::mutex mLock;
+    // Most recently used first
+    EntryList mEntries;
+    std::unordered_multimap<uint64_t, EntryList::iterator> mIndex;
+    uint32_t mGeneration = 0;
+
+    std::atomic<int32_t> mHits{0};
+    std::atomic<int32_t> mMisses{0};
+    std::atomic<int32_t> mUncacheable{0};
+    std::atomic<int32_t> mInvalidations{0};
+}; // class SessionConfigurationQueryCache
+
+} // namespace android
+
+#endif
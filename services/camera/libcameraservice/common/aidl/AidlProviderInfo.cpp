@@ -27,6 +27,7 @@
 #include <android/hardware/ICameraService.h>
 #include <camera_metadata_hidden.h>
 
+#include "api2/HeicCompositeStream.h"
 #include "device3/DistortionMapper.h"
 #include "device3/ZoomRatioMapper.h"
 #include <filesystem>
@@ -435,7 +436,7 @@ std::unique_ptr<CameraProviderManager::ProviderInfo::DeviceInfo>
     return std::unique_ptr<DeviceInfo3>(
         new AidlDeviceInfo3(name, tagId, id, static_cast<uint16_t>(interfaceVersion),
                 HalToFrameworkResourceCost(resourceCost), this,
-                mProviderPublicCameraIds, cameraInterface));
+                mProviderPublicCameraIds, cameraInterface, mManager->mCharacteristicsCache.get()));
 }
 
 status_t AidlProviderInfo::reCacheConcurrentStreamingCameraIdsLocked() {
@@ -485,7 +486,8 @@ AidlProviderInfo::AidlDeviceInfo3::AidlDeviceInfo3(
         const CameraResourceCost& resourceCost,
         sp<CameraProviderManager::ProviderInfo> parentProvider,
         const std::vector<std::string>& publicCameraIds,
-        std::shared_ptr<aidl::android::hardware::camera::device::ICameraDevice> interface) :
+        std::shared_ptr<aidl::android::hardware::camera::device::ICameraDevice> interface,
+        CameraCharacteristicsCache* characteristicsCache) :
         DeviceInfo3(name, tagId, id, minorVersion, resourceCost, parentProvider, publicCameraIds) {
 
     // Get camera characteristics and initialize flash unit availability
@@ -544,110 +546,12 @@ AidlProviderInfo::AidlDeviceInfo3::AidlDeviceInfo3(
 
     mSystemCameraKind = getSystemCameraKind();
 
-    status_t res = fixupMonochromeTags();
-    if (OK != res) {
-        ALOGE("%s: Unable to fix up monochrome tags based for older HAL version: %s (%d)",
-                __FUNCTION__, strerror(-res), res);
-        return;
-    }
-    res = fixupManualFlashStrengthControlTags(mCameraCharacteristics);
+    status_t res = deriveCharacteristics(characteristicsCache, parentProvider->mProviderName,
+            minorVersion);
     if (OK != res) {
-        ALOGE("%s: Unable to fix up manual flash strength control tags: %s (%d)",
-                __FUNCTION__, strerror(-res), res);
         return;
     }
 
-    auto stat = addDynamicDepthTags();
-    if (OK != stat) {
-        ALOGE("%s: Failed appending dynamic depth tags: %s (%d)", __FUNCTION__, strerror(-stat),
-                stat);
-    }
-    res = deriveHeicTags();
-    if (OK != res) {
-        ALOGE("%s: Unable to derive HEIC tags based on camera and media capabilities: %s (%d)",
-                __FUNCTION__, strerror(-res), res);
-    }
-    res = deriveJpegRTags();
-    if (OK != res) {
-        ALOGE("%s: Unable to derive Jpeg/R tags based on camera and media capabilities: %s (%d)",
-                __FUNCTION__, strerror(-res), res);
-    }
-    res = deriveHeicUltraHDRTags();
-    if (OK != res) {
-        ALOGE("%s: Unable to derive Heic UltraHDR tags based on camera and "
-                "media capabilities: %s (%d)",
-                __FUNCTION__, strerror(-res), res);
-    }
-    using camera3::SessionConfigurationUtils::supportsUltraHighResolutionCapture;
-    if (supportsUltraHighResolutionCapture(mCameraCharacteristics)) {
-        status_t status = addDynamicDepthTags(/*maxResolution*/true);
-        if (OK != status) {
-            ALOGE("%s: Failed appending dynamic depth tags for maximum resolution mode: %s (%d)",
-                    __FUNCTION__, strerror(-status), status);
-        }
-
-        status = deriveHeicTags(/*maxResolution*/true);
-        if (OK != status) {
-            ALOGE("%s: Unable to derive HEIC tags based on camera and media capabilities for"
-                    "maximum resolution mode: %s (%d)", __FUNCTION__, strerror(-status), status);
-        }
-
-        status = deriveJpegRTags(/*maxResolution*/true);
-        if (OK != status) {
-            ALOGE("%s: Unable to derive Jpeg/R tags based on camera and media capabilities for"
-                    "maximum resolution mode: %s (%d)", __FUNCTION__, strerror(-status), status);
-        }
-        status = deriveHeicUltraHDRTags(/*maxResolution*/true);
-        if (OK != status) {
-            ALOGE("%s: Unable to derive Heic UltraHDR tags based on camera and "
-                    "media capabilities: %s (%d)",
-                    __FUNCTION__, strerror(-status), status);
-        }
-    }
-
-    res = addRotateCropTags();
-    if (OK != res) {
-        ALOGE("%s: Unable to add default SCALER_ROTATE_AND_CROP tags: %s (%d)", __FUNCTION__,
-                strerror(-res), res);
-    }
-    res = addAutoframingTags();
-    if (OK != res) {
-        ALOGE("%s: Unable to add default AUTOFRAMING tags: %s (%d)", __FUNCTION__,
-                strerror(-res), res);
-    }
-    res = addPreCorrectionActiveArraySize();
-    if (OK != res) {
-        ALOGE("%s: Unable to add PRE_CORRECTION_ACTIVE_ARRAY_SIZE: %s (%d)", __FUNCTION__,
-                strerror(-res), res);
-    }
-    res = camera3::ZoomRatioMapper::overrideZoomRatioTags(
-            &mCameraCharacteristics, &mSupportNativeZoomRatio);
-    if (OK != res) {
-        ALOGE("%s: Unable to override zoomRatio related tags: %s (%d)",
-                __FUNCTION__, strerror(-res), res);
-    }
-    res = addReadoutTimestampTag();
-    if (OK != res) {
-        ALOGE("%s: Unable to add sensorReadoutTimestamp tag: %s (%d)",
-                __FUNCTION__, strerror(-res), res);
-    }
-
-    if (flags::color_temperature()) {
-        res = addColorCorrectionAvailableModesTag(mCameraCharacteristics);
-        if (OK != res) {
-            ALOGE("%s: Unable to add COLOR_CORRECTION_AVAILABLE_MODES tag: %s (%d)",
-                    __FUNCTION__, strerror(-res), res);
-        }
-    }
-
-    if (flags::ae_priority()) {
-        res = addAePriorityModeTags();
-        if (OK != res) {
-            ALOGE("%s: Unable to add CONTROL_AE_AVAILABLE_PRIORITY_MODES tag: %s (%d)",
-                    __FUNCTION__, strerror(-res), res);
-        }
-    }
-
     camera_metadata_entry flashAvailable =
             mCameraCharacteristics.find(ANDROID_FLASH_INFO_AVAILABLE);
     if (flashAvailable.count == 1 &&
@@ -780,6 +684,171 @@ AidlProviderInfo::AidlDeviceInfo3::AidlDeviceInfo3(
     }
 }
 
+status_t AidlProviderInfo::AidlDeviceInfo3::deriveCharacteristics() {
+    status_t res = fixupMonochromeTags();
+    if (OK != res) {
+        ALOGE("%s: Unable to fix up monochrome tags based for older HAL version: %s (%d)",
+                __FUNCTION__, strerror(-res), res);
+        return res;
+    }
+    res = fixupManualFlashStrengthControlTags(mCameraCharacteristics);
+    if (OK != res) {
+        ALOGE("%s: Unable to fix up manual flash strength control tags: %s (%d)",
+                __FUNCTION__, strerror(-res), res);
+        return res;
+    }
+
+    auto stat = addDynamicDepthTags();
+    if (OK != stat) {
+        ALOGE("%s: Failed appending dynamic depth tags: %s (%d)", __FUNCTION__, strerror(-stat),
+                stat);
+    }
+    res = deriveHeicTags();
+    if (OK != res) {
+        ALOGE("%s: Unable to derive HEIC tags based on camera and media capabilities: %s (%d)",
+                __FUNCTION__, strerror(-res), res);
+    }
+    res = deriveJpegRTags();
+    if (OK != res) {
+        ALOGE("%s: Unable to derive Jpeg/R tags based on camera and media capabilities: %s (%d)",
+                __FUNCTION__, strerror(-res), res);
+    }
+    res = deriveHeicUltraHDRTags();
+    if (OK != res) {
+        ALOGE("%s: Unable to derive Heic UltraHDR tags based on camera and "
+                "media capabilities: %s (%d)",
+                __FUNCTION__, strerror(-res), res);
+    }
+    using camera3::SessionConfigurationUtils::supportsUltraHighResolutionCapture;
+    if (supportsUltraHighResolutionCapture(mCameraCharacteristics)) {
+        status_t status = addDynamicDepthTags(/*maxResolution*/true);
+        if (OK != status) {
+            ALOGE("%s: Failed appending dynamic depth tags for maximum resolution mode: %s (%d)",
+                    __FUNCTION__, strerror(-status), status);
+        }
+
+        status = deriveHeicTags(/*maxResolution*/true);
+        if (OK != status) {
+            ALOGE("%s: Unable to derive HEIC tags based on camera and media capabilities for"
+                    "maximum resolution mode: %s (%d)", __FUNCTION__, strerror(-status), status);
+        }
+
+        status = deriveJpegRTags(/*maxResolution*/true);
+        if (OK != status) {
+            ALOGE("%s: Unable to derive Jpeg/R tags based on camera and media capabilities for"
+                    "maximum resolution mode: %s (%d)", __FUNCTION__, strerror(-status), status);
+        }
+        status = deriveHeicUltraHDRTags(/*maxResolution*/true);
+        if (OK != status) {
+            ALOGE("%s: Unable to derive Heic UltraHDR tags based on camera and "
+                    "media capabilities: %s (%d)",
+                    __FUNCTION__, strerror(-status), status);
+        }
+    }
+
+    res = addRotateCropTags();
+    if (OK != res) {
+        ALOGE("%s: Unable to add default SCALER_ROTATE_AND_CROP tags: %s (%d)", __FUNCTION__,
+                strerror(-res), res);
+    }
+    res = addAutoframingTags();
+    if (OK != res) {
+        ALOGE("%s: Unable to add default AUTOFRAMING tags: %s (%d)", __FUNCTION__,
+                strerror(-res), res);
+    }
+    res = addPreCorrectionActiveArraySize();
+    if (OK != res) {
+        ALOGE("%s: Unable to add PRE_CORRECTION_ACTIVE_ARRAY_SIZE: %s (%d)", __FUNCTION__,
+                strerror(-res), res);
+    }
+    res = camera3::ZoomRatioMapper::overrideZoomRatioTags(
+            &mCameraCharacteristics, &mSupportNativeZoomRatio);
+    if (OK != res) {
+        ALOGE("%s: Unable to override zoomRatio related tags: %s (%d)",
+                __FUNCTION__, strerror(-res), res);
+    }
+    res = addReadoutTimestampTag();
+    if (OK != res) {
+        ALOGE("%s: Unable to add sensorReadoutTimestamp tag: %s (%d)",
+                __FUNCTION__, strerror(-res), res);
+    }
+
+    if (flags::color_temperature()) {
+        res = addColorCorrectionAvailableModesTag(mCameraCharacteristics);
+        if (OK != res) {
+            ALOGE("%s: Unable to add COLOR_CORRECTION_AVAILABLE_MODES tag: %s (%d)",
+                    __FUNCTION__, strerror(-res), res);
+        }
+    }
+
+    if (flags::ae_priority()) {
+        res = addAePriorityModeTags();
+        if (OK != res) {
+            ALOGE("%s: Unable to add CONTROL_AE_AVAILABLE_PRIORITY_MODES tag: %s (%d)",
+                    __FUNCTION__, strerror(-res), res);
+        }
+    }
+
+    return OK;
+}
+
+status_t AidlProviderInfo::AidlDeviceInfo3::deriveCharacteristics(
+        CameraCharacteristicsCache* cache, const std::string& providerName,
+        int32_t interfaceVersion) {
+    if (cache == nullptr) {
+        return deriveCharacteristics();
+    }
+
+    CameraCharacteristicsCache::Key key;
+    key.providerName = providerName;
+    key.deviceName = mName;
+    key.interfaceVersion = interfaceVersion;
+    key.halCharacteristicsHash = CameraCharacteristicsCache::hash(mCameraCharacteristics);
+    key.derivationFlags = (flags::color_temperature() ? 1 << 0 : 0) |
+            (flags::ae_priority() ? 1 << 1 : 0) |
+            (flags::camera_heif_gainmap() ? 1 << 2 : 0) |
+            (CameraProviderManager::kFrameworkJpegRDisabled ? 1 << 3 : 0) |
+            (CameraProviderManager::kFrameworkHeicUltraHDRDisabled ? 1 << 4 : 0) |
+            (CameraProviderManager::kFrameworkHeicAllowSWCodecs ? 1 << 5 : 0) |
+            (property_get_bool("ro.camera.enableCompositeAPI0JpegR", false) ? 1 << 6 : 0);
+    key.mediaCodecsHash = camera3::HeicCompositeStream::getHeifEncoderCapabilitiesHash(
+            CameraProviderManager::kFrameworkHeicAllowSWCodecs);
+
+    CameraCharacteristicsCache::Entry entry;
+    if (cache->load(key, &entry) == OK) {
+        if (flags::metadata_resize_fix()) {
+            // Leave the same room for later additions as when derived
+            const camera_metadata_t* cached = entry.characteristics.getAndLock();
+            CameraMetadata characteristics(
+                    get_camera_metadata_entry_count(cached) + CHARACTERISTICS_EXTRA_ENTRIES,
+                    get_camera_metadata_data_count(cached) + CHARACTERISTICS_EXTRA_DATA_SIZE);
+            characteristics.append(cached);
+            entry.characteristics.unlock(cached);
+            mCameraCharacteristics.acquire(characteristics);
+        } else {
+            mCameraCharacteristics.acquire(entry.characteristics);
+        }
+        mSupportNativeZoomRatio = entry.supportNativeZoomRatio;
+        mCompositeJpegRDisabled = entry.compositeJpegRDisabled;
+        mCharacteristicsFromCache = true;
+        return OK;
+    }
+
+    status_t res = deriveCharacteristics();
+    if (OK != res) {
+        return res;
+    }
+    entry.characteristics = mCameraCharacteristics;
+    entry.supportNativeZoomRatio = mSupportNativeZoomRatio;
+    entry.compositeJpegRDisabled = mCompositeJpegRDisabled;
+    status_t storeRes = cache->store(key, entry);
+    if (OK != storeRes) {
+        ALOGW("%s: Unable to cache the characteristics of %s: %s (%d)", __FUNCTION__,
+                mName.c_str(), strerror(-storeRes), storeRes);
+    }
+    return OK;
+}
+
 status_t AidlProviderInfo::AidlDeviceInfo3::setTorchMode(bool enabled) {
     const std::shared_ptr<camera::device::ICameraDevice> interface = startDeviceInterface();
     ::ndk::ScopedAStatus s = interface->setTorchMode(enabled);
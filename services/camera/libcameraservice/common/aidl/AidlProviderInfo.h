@@ -115,7 +115,8 @@ struct AidlProviderInfo : public CameraProviderManager::ProviderInfo {
                 const CameraResourceCost& ,
                 sp<ProviderInfo> ,
                 const std::vector<std::string>& ,
-                std::shared_ptr<aidl::android::hardware::camera::device::ICameraDevice>);
+                std::shared_ptr<aidl::android::hardware::camera::device::ICameraDevice>,
+                CameraCharacteristicsCache* characteristicsCache = nullptr);
 
         ~AidlDeviceInfo3() {}
 
@@ -142,6 +143,15 @@ struct AidlProviderInfo : public CameraProviderManager::ProviderInfo {
         std::shared_ptr<aidl::android::hardware::camera::device::ICameraDevice>
                 startDeviceInterface();
         std::vector<int32_t> mAdditionalKeysForFeatureQuery;
+
+      private:
+        // Add the keys derived by the framework to the characteristics from the HAL
+        status_t deriveCharacteristics();
+
+        // Same as deriveCharacteristics, using the cached result if the characteristics
+        // from the HAL have not changed since the cache entry was stored
+        status_t deriveCharacteristics(CameraCharacteristicsCache* cache,
+                const std::string& providerName, int32_t interfaceVersion);
     };
 
  private:
@@ -32,7 +32,10 @@ namespace android {
 
 namespace camera3 {
 
-Camera3BufferManager::Camera3BufferManager() {
+Camera3BufferManager::Camera3BufferManager(std::shared_ptr<Camera3BufferPool> bufferPool) :
+        mBufferPool(bufferPool != nullptr ? std::move(bufferPool) :
+                std::make_shared<Camera3BufferPool>(
+                        Camera3BufferPool::createGraphicBufferAllocator())) {
 }
 
 Camera3BufferManager::~Camera3BufferManager() {
@@ -115,6 +118,10 @@ status_t Camera3BufferManager::registerStream(wp<Camera3OutputStream>& stream,
        currentStreamSet.maxAllowedBufferCount = streamInfo.totalBufferCount;
     }
 
+    // Get the buffers this stream used before the reconfiguration ready ahead of its first
+    // requests.
+    prefetchForStreamLocked(streamId, currentStreamSet);
+
     return OK;
 }
 
@@ -162,13 +169,46 @@ status_t Camera3BufferManager::unregisterStream(int streamId, int streamSetId, b
     return OK;
 }
 
-void Camera3BufferManager::notifyBufferRemoved(int streamId, int streamSetId, bool isMultiRes) {
+void Camera3BufferManager::notifyBufferRemoved(int streamId, int streamSetId, bool isMultiRes,
+        const sp<GraphicBuffer>& buffer, int fenceFd) {
+    sp<Fence> fence = new Fence(fenceFd);
     Mutex::Autolock l(mLock);
     StreamSetKey streamSetKey = {streamSetId, isMultiRes};
     StreamSet &streamSet = mStreamSetMap.editValueFor(streamSetKey);
     size_t& attachedBufferCount =
             streamSet.attachedBufferCountMap.editValueFor(streamId);
-    attachedBufferCount--;
+    if (attachedBufferCount > 0) {
+        attachedBufferCount--;
+    }
+
+    if (buffer != nullptr) {
+        mBufferPool->returnBuffer(getBufferKey(streamSet.streamInfoMap.valueFor(streamId)),
+                buffer, fence);
+    }
+}
+
+void Camera3BufferManager::prefetchForStream(int streamId, int streamSetId, bool isMultiRes) {
+    Mutex::Autolock l(mLock);
+    StreamSetKey streamSetKey = {streamSetId, isMultiRes};
+    if (!checkIfStreamRegisteredLocked(streamId, streamSetKey)) {
+        return;
+    }
+
+    prefetchForStreamLocked(streamId, mStreamSetMap.valueFor(streamSetKey));
+}
+
+void Camera3BufferManager::prefetchForStreamLocked(int streamId, const StreamSet& streamSet) {
+    const StreamInfo& info = streamSet.streamInfoMap.valueFor(streamId);
+    size_t attachedBufferCount = streamSet.attachedBufferCountMap.valueFor(streamId);
+    Camera3BufferPool::BufferKey key = getBufferKey(info);
+    size_t expectedBufferCount = std::min(mBufferPool->getWatermark(key), info.totalBufferCount);
+    if (expectedBufferCount > attachedBufferCount) {
+        mBufferPool->prefetch(key, expectedBufferCount - attachedBufferCount);
+    }
+}
+
+Camera3BufferPool::BufferKey Camera3BufferManager::getBufferKey(const StreamInfo& info) {
+    return {info.width, info.height, info.format, info.combinedUsage};
 }
 
 status_t Camera3BufferManager::checkAndFreeBufferOnOtherStreamsLocked(
@@ -212,6 +252,8 @@ status_t Camera3BufferManager::checkAndFreeBufferOnOtherStreamsLocked(
     }
     if (totalAllocatedBufferCount > streamSet.allocatedBufferWaterMark) {
         ALOGV("Stream %d: Freeing buffer: detach", firstOtherStreamId);
+        Camera3BufferPool::BufferKey key =
+                getBufferKey(streamSet.streamInfoMap.valueFor(firstOtherStreamId));
         sp<Camera3OutputStream> stream =
                 mStreamMap.valueFor(firstOtherStreamId).promote();
         if (stream == nullptr) {
@@ -220,7 +262,8 @@ status_t Camera3BufferManager::checkAndFreeBufferOnOtherStreamsLocked(
             return INVALID_OPERATION;
         }
 
-        // Detach and then drop the buffer.
+        // Detach the buffer and return it to the buffer pool, which frees it unless its size,
+        // format and usage need more warm buffers.
         //
         // Need to unlock because the stream may also be calling
         // into the buffer manager in parallel to signal buffer
@@ -229,10 +272,13 @@ status_t Camera3BufferManager::checkAndFreeBufferOnOtherStreamsLocked(
         {
             mLock.unlock();
             sp<GraphicBuffer> buffer;
-            stream->detachBuffer(&buffer, /*fenceFd*/ nullptr);
+            int fenceFd = -1;
+            stream->detachBuffer(&buffer, &fenceFd);
+            sp<Fence> fence = new Fence(fenceFd);
             mLock.lock();
             if (buffer.get() != nullptr) {
                 bufferFreed = true;
+                mBufferPool->returnBuffer(key, buffer, fence);
             }
         }
         if (bufferFreed) {
@@ -287,27 +333,24 @@ status_t Camera3BufferManager::getBufferForStream(int streamId, int streamSetId,
 
     if (mGrallocVersion < HARDWARE_DEVICE_API_VERSION(1,0)) {
         const StreamInfo& info = streamSet.streamInfoMap.valueFor(streamId);
+        Camera3BufferPool::BufferKey key = getBufferKey(info);
         GraphicBufferEntry buffer;
-        buffer.fenceFd = -1;
-        buffer.graphicBuffer = new GraphicBuffer(
-                info.width, info.height, PixelFormat(info.format), info.combinedUsage,
-                std::string("Camera3BufferManager pid [") +
-                        std::to_string(getpid()) + "]");
-        status_t res = buffer.graphicBuffer->initCheck();
-
-        ALOGV("%s: allocating a new graphic buffer (%dx%d, format 0x%x) %p with handle %p",
-                __FUNCTION__, info.width, info.height, info.format,
-                buffer.graphicBuffer.get(), buffer.graphicBuffer->handle);
+        sp<Fence> fence;
+        status_t res = mBufferPool->getBuffer(key, &buffer.graphicBuffer, &fence);
         if (res < 0) {
-            ALOGE("%s: graphic buffer allocation failed: (error %d %s) ",
-                    __FUNCTION__, res, strerror(-res));
             return res;
         }
-        ALOGV("%s: allocation done", __FUNCTION__);
+        buffer.fenceFd = fence->isValid() ? fence->dup() : -1;
+        ALOGV("%s: got a graphic buffer (%dx%d, format 0x%x) %p with handle %p from the pool",
+                __FUNCTION__, info.width, info.height, info.format,
+                buffer.graphicBuffer.get(), buffer.graphicBuffer->handle);
 
         // Increase the hand-out and attached buffer counts for tracking purposes.
         bufferCount++;
         attachedBufferCount++;
+        // Let the pool learn how many buffers of this kind a stream needs, so that they stay
+        // warm across stream reconfigurations.
+        mBufferPool->updateWatermark(key, attachedBufferCount);
         // Update the water mark to be the max hand-out buffer count + 1. An additional buffer is
         // added to reduce the chance of buffer allocation during stream steady state, especially
         // for cases where one stream is active, the other stream may request some buffers randomly.
@@ -342,6 +385,38 @@ status_t Camera3BufferManager::getBufferForStream(int streamId, int streamSetId,
     return OK;
 }
 
+void Camera3BufferManager::cancelBufferForStream(int streamId, int streamSetId,
+        bool isMultiRes, const sp<GraphicBuffer>& buffer, int fenceFd) {
+    ATRACE_CALL();
+    sp<Fence> fence = new Fence(fenceFd);
+
+    Mutex::Autolock l(mLock);
+    ALOGV("Stream %d set %d(%d): Buffer canceled", streamId, streamSetId, isMultiRes);
+
+    StreamSetKey streamSetKey = {streamSetId, isMultiRes};
+    if (!checkIfStreamRegisteredLocked(streamId, streamSetKey)) {
+        ALOGV("%s: canceling a buffer for an already unregistered stream "
+                "(stream %d with set id %d(%d))", __FUNCTION__, streamId, streamSetId,
+                isMultiRes);
+        return;
+    }
+
+    StreamSet& streamSet = mStreamSetMap.editValueFor(streamSetKey);
+    size_t& bufferCount = streamSet.handoutBufferCountMap.editValueFor(streamId);
+    size_t& attachedBufferCount = streamSet.attachedBufferCountMap.editValueFor(streamId);
+    if (bufferCount > 0) {
+        bufferCount--;
+    }
+    if (attachedBufferCount > 0) {
+        attachedBufferCount--;
+    }
+
+    if (buffer != nullptr) {
+        mBufferPool->returnBuffer(getBufferKey(streamSet.streamInfoMap.valueFor(streamId)),
+                buffer, fence);
+    }
+}
+
 status_t Camera3BufferManager::onBufferReleased(
         int streamId, int streamSetId, bool isMultiRes, bool* shouldFreeBuffer) {
     ATRACE_CALL();
@@ -487,6 +562,7 @@ void Camera3BufferManager::dump(int fd, [[maybe_unused]] const Vector<String16>&
     }
     std::string linesStr = lines.str();
     write(fd, linesStr.c_str(), linesStr.size());
+    mBufferPool->dump(fd);
 }
 
 bool Camera3BufferManager::checkIfStreamRegisteredLocked(int streamId,
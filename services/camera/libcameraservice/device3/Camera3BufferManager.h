@@ -22,6 +22,7 @@
 #include <ui/GraphicBuffer.h>
 #include <utils/RefBase.h>
 #include <utils/KeyedVector.h>
+#include "Camera3BufferPool.h"
 #include "Camera3OutputStream.h"
 
 namespace android {
@@ -41,10 +42,17 @@ class Camera3OutputStream;
  * In doing so, it reduces the memory footprint unless it is already minimal without impacting
  * performance.
  *
+ * Buffers are allocated from, and freed buffers go back to, a Camera3BufferPool, which keeps
+ * buffers warm across stream reconfigurations and allocates them ahead of time when possible.
+ *
  */
 class Camera3BufferManager: public virtual RefBase {
 public:
-    explicit Camera3BufferManager();
+    /**
+     * The buffer pool defaults to one allocating gralloc buffers, within
+     * Camera3BufferPool::kDefaultBudgetBytes.
+     */
+    explicit Camera3BufferManager(std::shared_ptr<Camera3BufferPool> bufferPool = nullptr);
 
     virtual ~Camera3BufferManager();
 
@@ -130,6 +138,16 @@ public:
             int streamId, int streamSetId, bool isMultiRes, sp<GraphicBuffer>* gb,
             int* fenceFd, bool noFreeBufferAtConsumer = false);
 
+    /**
+     * This method gives back a buffer obtained from getBufferForStream that the stream couldn't
+     * use, e.g. because attaching it to the buffer queue failed. The hand-out and attached buffer
+     * counts are restored, and the buffer is returned to the buffer pool.
+     *
+     * The manager takes ownership of fenceFd, the fence returned by getBufferForStream.
+     */
+    void cancelBufferForStream(int streamId, int streamSetId, bool isMultiRes,
+            const sp<GraphicBuffer>& buffer, int fenceFd);
+
     /**
      * This method notifies the manager that a buffer has been released by the consumer.
      *
@@ -177,8 +195,21 @@ public:
     /**
      * This method notifiers the manager that a buffer is freed from the buffer queue, usually
      * because onBufferReleased signals the caller to free a buffer via the shouldFreeBuffer flag.
+     *
+     * If the detached buffer is given, it's returned to the buffer pool for reuse by this or
+     * another stream, once its fence (which this method takes ownership of) signals.
      */
-    void notifyBufferRemoved(int streamId, int streamSetId, bool isMultiRes);
+    void notifyBufferRemoved(int streamId, int streamSetId, bool isMultiRes,
+            const sp<GraphicBuffer>& buffer = nullptr, int fenceFd = -1);
+
+    /**
+     * This method lets the manager know that a stream is about to be used by a repeating
+     * request, so that the buffers the stream needed the last time it was streaming can be
+     * allocated in the background, before the requests ask for them.
+     *
+     * Streams that aren't registered to this buffer manager are ignored.
+     */
+    void prefetchForStream(int streamId, int streamSetId, bool isMultiRes);
 
     /**
      * Dump the buffer manager statistics.
@@ -203,6 +234,8 @@ private:
      */
     mutable Mutex mLock;
 
+    const std::shared_ptr<Camera3BufferPool> mBufferPool;
+
     static const size_t kMaxBufferCount = BufferQueueDefs::NUM_BUFFER_SLOTS;
 
     struct GraphicBufferEntry {
@@ -319,6 +352,15 @@ private:
      */
     bool checkIfStreamRegisteredLocked(int streamId, StreamSetKey streamSetKey) const;
 
+    static Camera3BufferPool::BufferKey getBufferKey(const StreamInfo& info);
+
+    /**
+     * Queue the prefetch of the buffers the stream is expected to need, from the watermark the
+     * buffer pool learnt for its buffer size, format and usage. This method needs to be called
+     * with mLock held.
+     */
+    void prefetchForStreamLocked(int streamId, const StreamSet& streamSet);
+
     /**
      * Check if other streams in the stream set has extra buffer available to be freed, and
      * free one if so.
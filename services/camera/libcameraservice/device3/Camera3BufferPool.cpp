@@ -0,0 +1,350 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "Camera3-BufferPool"
+#define ATRACE_TAG ATRACE_TAG_CAMERA
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+#include <camera/StringUtils.h>
+#include <utils/Log.h>
+#include <utils/Trace.h>
+
+#include "Camera3BufferPool.h"
+
+namespace android {
+
+namespace camera3 {
+
+namespace {
+
+class GraphicBufferAllocator : public Camera3BufferPool::Allocator {
+  public:
+    status_t allocate(const Camera3BufferPool::BufferKey& key,
+            sp<GraphicBuffer>* buffer) override {
+        sp<GraphicBuffer> gb = new GraphicBuffer(key.width, key.height,
+                PixelFormat(key.format), key.usage,
+                std::string("Camera3BufferManager pid [") + std::to_string(getpid()) + "]");
+        status_t res = gb->initCheck();
+        if (res != OK) {
+            return res;
+        }
+        *buffer = gb;
+        return OK;
+    }
+};
+
+bool sameKey(const Camera3BufferPool::BufferKey& a, const Camera3BufferPool::BufferKey& b) {
+    return !(a < b) && !(b < a);
+}
+
+} // anonymous namespace
+
+std::shared_ptr<Camera3BufferPool::Allocator> Camera3BufferPool::createGraphicBufferAllocator() {
+    return std::make_shared<GraphicBufferAllocator>();
+}
+
+Camera3BufferPool::Camera3BufferPool(std::shared_ptr<Allocator> allocator, size_t budgetBytes) :
+        mAllocator(std::move(allocator)),
+        mBudgetBytes(budgetBytes) {
+    mWorker = std::thread([this]() {
+        pthread_setname_np(pthread_self(), "C3BufferPool");
+        workerLoop();
+    });
+}
+
+Camera3BufferPool::~Camera3BufferPool() {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mExiting = true;
+    }
+    mPrefetchQueued.notify_all();
+    mWorker.join();
+}
+
+size_t Camera3BufferPool::estimateBufferSize(const BufferKey& key) {
+    size_t pixels = static_cast<size_t>(key.width) * key.height;
+    switch (key.format) {
+        case HAL_PIXEL_FORMAT_BLOB:
+            // Width is the size in bytes
+            return pixels;
+        case HAL_PIXEL_FORMAT_Y8:
+            return pixels;
+        case HAL_PIXEL_FORMAT_YCBCR_420_888:
+        case HAL_PIXEL_FORMAT_YCRCB_420_SP:
+        case HAL_PIXEL_FORMAT_YV12:
+        case HAL_PIXEL_FORMAT_IMPLEMENTATION_DEFINED:
+            return pixels * 3 / 2;
+        case HAL_PIXEL_FORMAT_RAW10:
+            return pixels * 10 / 8;
+        case HAL_PIXEL_FORMAT_RAW12:
+            return pixels * 12 / 8;
+        case HAL_PIXEL_FORMAT_RAW16:
+        case HAL_PIXEL_FORMAT_Y16:
+        case HAL_PIXEL_FORMAT_RGB_565:
+            return pixels * 2;
+        case HAL_PIXEL_FORMAT_YCBCR_P010:
+            return pixels * 3;
+        case HAL_PIXEL_FORMAT_RGB_888:
+            return pixels * 3;
+        default:
+            return pixels * 4;
+    }
+}
+
+status_t Camera3BufferPool::getBuffer(const BufferKey& key, sp<GraphicBuffer>* buffer,
+        sp<Fence>* fence) {
+    ATRACE_CALL();
+    if (buffer == nullptr || fence == nullptr) {
+        return BAD_VALUE;
+    }
+
+    size_t size = estimateBufferSize(key);
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        KeyState& state = mKeys[key];
+        state.lastUsed = ++mUseSequence;
+        if (!state.warm.empty()) {
+            *buffer = std::move(state.warm.back().buffer);
+            *fence = std::move(state.warm.back().fence);
+            state.warm.pop_back();
+            mWarmBytes -= size;
+            mStats.hits++;
+            return OK;
+        }
+
+        // The buffer about to be allocated replaces one that was queued for prefetching, if any
+        auto queued = std::find_if(mPrefetchQueue.begin(), mPrefetchQueue.end(),
+                [&key](const BufferKey& other) { return sameKey(key, other); });
+        if (queued != mPrefetchQueue.end()) {
+            mPrefetchQueue.erase(queued);
+            state.pending--;
+            mPendingBytes -= size;
+        }
+        mStats.stalls++;
+    }
+
+    ALOGV("%s: no warm buffer for %ux%u format 0x%x usage 0x%" PRIx64 ", allocating",
+            __FUNCTION__, key.width, key.height, key.format, key.usage);
+    nsecs_t start = systemTime();
+    status_t res = mAllocator->allocate(key, buffer);
+    mStats.stallLatency.add(start, systemTime());
+    if (res != OK) {
+        ALOGE("%s: graphic buffer allocation failed: (error %d %s) ",
+                __FUNCTION__, res, strerror(-res));
+        std::lock_guard<std::mutex> lock(mLock);
+        mStats.allocationFailures++;
+        return res;
+    }
+    *fence = Fence::NO_FENCE;
+
+    return OK;
+}
+
+void Camera3BufferPool::returnBuffer(const BufferKey& key, const sp<GraphicBuffer>& buffer,
+        const sp<Fence>& fence) {
+    if (buffer == nullptr) {
+        return;
+    }
+
+    // Declared before the lock, so that evicted buffers are freed after it's released
+    std::vector<WarmBuffer> evicted;
+    std::lock_guard<std::mutex> lock(mLock);
+    KeyState& state = mKeys[key];
+    if (state.warm.size() + state.pending >= state.watermark) {
+        mStats.dropped++;
+        return;
+    }
+    size_t size = estimateBufferSize(key);
+    if (!reserveLocked(key, size, &evicted)) {
+        mStats.overBudget++;
+        return;
+    }
+    state.warm.push_back({buffer, fence != nullptr ? fence : Fence::NO_FENCE});
+    mWarmBytes += size;
+    mStats.recycled++;
+}
+
+void Camera3BufferPool::updateWatermark(const BufferKey& key, size_t bufferCount) {
+    std::lock_guard<std::mutex> lock(mLock);
+    KeyState& state = mKeys[key];
+    state.watermark = std::max(state.watermark, bufferCount);
+}
+
+size_t Camera3BufferPool::getWatermark(const BufferKey& key) const {
+    std::lock_guard<std::mutex> lock(mLock);
+    auto it = mKeys.find(key);
+    return (it != mKeys.end()) ? it->second.watermark : 0;
+}
+
+void Camera3BufferPool::prefetch(const BufferKey& key, size_t count) {
+    std::vector<WarmBuffer> evicted;
+    std::lock_guard<std::mutex> lock(mLock);
+    KeyState& state = mKeys[key];
+    state.lastUsed = ++mUseSequence;
+
+    size_t size = estimateBufferSize(key);
+    size_t queued = 0;
+    while (state.warm.size() + state.pending < count) {
+        if (!reserveLocked(key, size, &evicted)) {
+            mStats.overBudget++;
+            break;
+        }
+        mPrefetchQueue.push_back(key);
+        state.pending++;
+        mPendingBytes += size;
+        queued++;
+    }
+    if (queued > 0) {
+        ALOGV("%s: prefetching %zu buffers of %ux%u format 0x%x usage 0x%" PRIx64, __FUNCTION__,
+                queued, key.width, key.height, key.format, key.usage);
+        mPrefetchQueued.notify_one();
+    }
+}
+
+void Camera3BufferPool::waitForPrefetch() {
+    std::unique_lock<std::mutex> lock(mLock);
+    mPrefetchDone.wait(lock, [this]() {
+        return mExiting || (mPrefetchQueue.empty() && !mPrefetching);
+    });
+}
+
+size_t Camera3BufferPool::warmBufferCount(const BufferKey& key) const {
+    std::lock_guard<std::mutex> lock(mLock);
+    auto it = mKeys.find(key);
+    return (it != mKeys.end()) ? it->second.warm.size() : 0;
+}
+
+size_t Camera3BufferPool::warmBytes() const {
+    std::lock_guard<std::mutex> lock(mLock);
+    return mWarmBytes;
+}
+
+void Camera3BufferPool::clear() {
+    std::vector<WarmBuffer> freed;
+    std::lock_guard<std::mutex> lock(mLock);
+    for (auto& [key, state] : mKeys) {
+        std::move(state.warm.begin(), state.warm.end(), std::back_inserter(freed));
+        state.warm.clear();
+    }
+    mWarmBytes = 0;
+}
+
+Camera3BufferPool::Stats Camera3BufferPool::getStats() const {
+    std::lock_guard<std::mutex> lock(mLock);
+    return mStats;
+}
+
+bool Camera3BufferPool::reserveLocked(const BufferKey& key, size_t bytes,
+        std::vector<WarmBuffer>* evicted) {
+    // The warm buffers of the key itself aren't evicted
+    auto it = mKeys.find(key);
+    size_t ownBytes = (it != mKeys.end()) ? it->second.warm.size() * estimateBufferSize(key) : 0;
+    if (ownBytes + mPendingBytes + bytes > mBudgetBytes) {
+        return false;
+    }
+
+    while (mWarmBytes + mPendingBytes + bytes > mBudgetBytes) {
+        auto lru = mKeys.end();
+        for (auto state = mKeys.begin(); state != mKeys.end(); state++) {
+            if (state->second.warm.empty() || sameKey(state->first, key)) {
+                continue;
+            }
+            if (lru == mKeys.end() || state->second.lastUsed < lru->second.lastUsed) {
+                lru = state;
+            }
+        }
+        if (lru == mKeys.end()) {
+            return false;
+        }
+        evicted->push_back(std::move(lru->second.warm.back()));
+        lru->second.warm.pop_back();
+        mWarmBytes -= estimateBufferSize(lru->first);
+        mStats.evicted++;
+    }
+    return true;
+}
+
+void Camera3BufferPool::workerLoop() {
+    std::unique_lock<std::mutex> lock(mLock);
+    while (true) {
+        mPrefetchQueued.wait(lock, [this]() { return mExiting || !mPrefetchQueue.empty(); });
+        if (mExiting) {
+            break;
+        }
+        BufferKey key = mPrefetchQueue.front();
+        mPrefetchQueue.pop_front();
+        mPrefetching = true;
+        lock.unlock();
+
+        sp<GraphicBuffer> buffer;
+        status_t res;
+        {
+            ATRACE_NAME("Camera3BufferPool prefetch");
+            res = mAllocator->allocate(key, &buffer);
+        }
+
+        lock.lock();
+        size_t size = estimateBufferSize(key);
+        KeyState& state = mKeys[key];
+        state.pending--;
+        mPendingBytes -= size;
+        if (res == OK) {
+            state.warm.push_back({buffer, Fence::NO_FENCE});
+            mWarmBytes += size;
+            mStats.prefetched++;
+        } else {
+            ALOGW("%s: prefetching a %ux%u buffer (format 0x%x) failed: %s (%d)", __FUNCTION__,
+                    key.width, key.height, key.format, strerror(-res), res);
+            mStats.allocationFailures++;
+        }
+        mPrefetching = false;
+        mPrefetchDone.notify_all();
+    }
+    mPrefetchDone.notify_all();
+}
+
+void Camera3BufferPool::dump(int fd) const {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    std::ostringstream lines;
+    lines << fmt::sprintf("      Buffer pool: %zu KiB warm, %zu KiB being prefetched,"
+            " budget %zu KiB\n", mWarmBytes / 1024, mPendingBytes / 1024, mBudgetBytes / 1024);
+    for (const auto& [key, state] : mKeys) {
+        lines << fmt::sprintf("        %ux%u format 0x%x usage 0x%" PRIx64 ": %zu warm,"
+                " %zu prefetching, watermark %zu\n", key.width, key.height, key.format,
+                key.usage, state.warm.size(), state.pending, state.watermark);
+    }
+    lines << fmt::sprintf("        Buffers requested: %" PRId64 " warm, %" PRId64 " allocated"
+            " (%" PRId64 " failed); prefetched: %" PRId64 "\n", mStats.hits, mStats.stalls,
+            mStats.allocationFailures, mStats.prefetched);
+    lines << fmt::sprintf("        Buffers returned: %" PRId64 " recycled, %" PRId64 " dropped,"
+            " %" PRId64 " over budget; evicted: %" PRId64 "\n", mStats.recycled, mStats.dropped,
+            mStats.overBudget, mStats.evicted);
+    std::string linesStr = lines.str();
+    write(fd, linesStr.c_str(), linesStr.size());
+    mStats.stallLatency.dump(fd, "        Allocation stalls");
+}
+
+} // namespace camera3
+} // namespace android
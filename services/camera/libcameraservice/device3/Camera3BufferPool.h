@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SERVERS_CAMERA3_BUFFER_POOL_H
+#define ANDROID_SERVERS_CAMERA3_BUFFER_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <ui/Fence.h>
+#include <ui/GraphicBuffer.h>
+#include <utils/Errors.h>
+
+#include "utils/LatencyHistogram.h"
+
+namespace android {
+
+namespace camera3 {
+
+/**
+ * A pool of warm graphic buffers, shared by the streams of a camera device.
+ *
+ * Buffers are pooled by size, format and usage. The pool learns, for each of these keys, the
+ * largest number of buffers a stream needed at once (its watermark). That watermark outlives the
+ * streams, so when a stream configuration goes away and comes back (e.g. switching between photo
+ * and video modes), the buffers it needs can be allocated ahead of time on a background thread,
+ * or recycled from the previous configuration, instead of being allocated on the request path.
+ *
+ * Warm buffers are bounded by a memory budget. When the budget is exceeded, the buffers of the
+ * least recently used keys are freed first. Buffer sizes are estimated from their format, as the
+ * actual gralloc layout isn't known.
+ *
+ * Thread safe.
+ */
+class Camera3BufferPool {
+  public:
+    static constexpr size_t kDefaultBudgetBytes = 64 * 1024 * 1024;
+
+    struct BufferKey {
+        uint32_t width;
+        uint32_t height;
+        uint32_t format;
+        uint64_t usage;
+
+        bool operator<(const BufferKey& other) const {
+            if (width != other.width) return width < other.width;
+            if (height != other.height) return height < other.height;
+            if (format != other.format) return format < other.format;
+            return usage < other.usage;
+        }
+    };
+
+    /**
+     * Allocates the buffers of the pool. Called without any lock held, from the thread calling
+     * getBuffer, or from the prefetch thread.
+     */
+    class Allocator {
+      public:
+        virtual ~Allocator() = default;
+        virtual status_t allocate(const BufferKey& key, sp<GraphicBuffer>* buffer) = 0;
+    };
+
+    // Allocator backed by gralloc
+    static std::shared_ptr<Allocator> createGraphicBufferAllocator();
+
+    explicit Camera3BufferPool(std::shared_ptr<Allocator> allocator,
+            size_t budgetBytes = kDefaultBudgetBytes);
+    ~Camera3BufferPool();
+
+    /**
+     * Get a buffer for the given key: a warm one if any, otherwise a newly allocated one, which
+     * counts as an allocation stall. The fence must be waited on before writing to the buffer;
+     * it's Fence::NO_FENCE for new buffers.
+     */
+    status_t getBuffer(const BufferKey& key, sp<GraphicBuffer>* buffer, sp<Fence>* fence);
+
+    /**
+     * Give a buffer that a stream no longer uses back to the pool. The buffer is kept warm if
+     * fewer than the watermark of its key are, and it fits in the budget; otherwise it's freed.
+     */
+    void returnBuffer(const BufferKey& key, const sp<GraphicBuffer>& buffer,
+            const sp<Fence>& fence = Fence::NO_FENCE);
+
+    // Raise the watermark of a key to the given number of buffers in use at once
+    void updateWatermark(const BufferKey& key, size_t bufferCount);
+    size_t getWatermark(const BufferKey& key) const;
+
+    /**
+     * Allocate buffers in the background, until at least 'count' buffers of the key are warm,
+     * as far as the budget allows.
+     */
+    void prefetch(const BufferKey& key, size_t count);
+    // Wait until all the prefetches requested so far are done
+    void waitForPrefetch();
+
+    size_t warmBufferCount(const BufferKey& key) const;
+    size_t warmBytes() const;
+    // Free all warm buffers. The watermarks are kept.
+    void clear();
+
+    struct Stats {
+        // getBuffer calls served by a warm buffer, and by a synchronous allocation
+        int64_t hits = 0;
+        int64_t stalls = 0;
+        int64_t allocationFailures = 0;
+        // Buffers allocated by the prefetch thread
+        int64_t prefetched = 0;
+        // Buffers given back and kept warm, or freed because the key had enough warm buffers, or
+        // because they didn't fit in the budget
+        int64_t recycled = 0;
+        int64_t dropped = 0;
+        int64_t overBudget = 0;
+        // Warm buffers freed to make room for others
+        int64_t evicted = 0;
+        // Time spent allocating in getBuffer
+        CameraLogLatencyHistogram stallLatency;
+    };
+    Stats getStats() const;
+
+    void dump(int fd) const;
+
+    // Estimated memory used by one buffer of the key, in bytes
+    static size_t estimateBufferSize(const BufferKey& key);
+
+  private:
+    struct WarmBuffer {
+        sp<GraphicBuffer> buffer;
+        sp<Fence> fence;
+    };
+
+    struct KeyState {
+        std::vector<WarmBuffer> warm;
+        size_t watermark = 0;
+        // Queued or in progress prefetches
+        size_t pending = 0;
+        // Sequence number of the last getBuffer, for LRU eviction
+        uint64_t lastUsed = 0;
+    };
+
+    void workerLoop();
+
+    /**
+     * Make room in the budget for 'bytes' more bytes, by evicting the warm buffers of the least
+     * recently used keys other than 'key'. The evicted buffers are moved to 'evicted', to be
+     * freed once mLock is released. Returns false if the budget can't fit them.
+     */
+    bool reserveLocked(const BufferKey& key, size_t bytes, std::vector<WarmBuffer>* evicted);
+
+    const std::shared_ptr<Allocator> mAllocator;
+    const size_t mBudgetBytes;
+
+    mutable std::mutex mLock;
+    std::condition_variable mPrefetchQueued;
+    std::condition_variable mPrefetchDone;
+    std::map<BufferKey, KeyState> mKeys;
+    // One entry per buffer to prefetch
+    std::deque<BufferKey> mPrefetchQueue;
+    bool mPrefetching = false;
+    bool mExiting = false;
+    // Bytes of the warm buffers, and of the buffers being prefetched
+    size_t mWarmBytes = 0;
+    size_t mPendingBytes = 0;
+    uint64_t mUseSequence = 0;
+    Stats mStats;
+
+    std::thread mWorker;
+}; // class Camera3BufferPool
+
+} // namespace camera3
+
+} // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA3_BUFFER_POOL_H
@@ -302,6 +302,9 @@ status_t Camera3Device::initializeCommonLocked(sp<CameraProviderManager> manager
         mRotateAndCropMappers.emplace(mId, &mDeviceInfo);
     }
 
+    mRequestMetadataMappers.compose(mUHRCropAndMeteringRegionMappers, mDistortionMappers,
+            mZoomRatioMappers, mRotateAndCropMappers);
+
     // Hidl/AidlCamera3DeviceInjectionMethods
     mInjectionMethods = createCamera3DeviceInjectionMethods(this);
 
@@ -426,6 +429,11 @@ status_t Camera3Device::disconnectImpl() {
                     __FUNCTION__, stream->getId(), stream->getStrongCount() - 1);
         }
     }
+    mSessionStatsBuilder.mergeAndResetStageLatencies(&mCaptureStageLatencies);
+    for (size_t i = 0; i < mCaptureStageLatencies.size(); i++) {
+        mCaptureStageLatencies[i].log("Camera %s: %s latency", mId.c_str(),
+                captureStageName(static_cast<CaptureStage>(i)));
+    }
     ALOGI("%s: X", __FUNCTION__);
 
     if (mCameraServiceWatchdog != NULL) {
@@ -672,10 +680,10 @@ status_t Camera3Device::dump(int fd, [[maybe_unused]] const Vector<String16> &ar
         if (mInFlightMap.size() == 0) {
             lines += "      None\n";
         } else {
-            for (size_t i = 0; i < mInFlightMap.size(); i++) {
-                InFlightRequest r = mInFlightMap.valueAt(i);
+            for (const auto& entry : mInFlightMap) {
+                const InFlightRequest& r = entry.value;
                 lines += fmt::sprintf("      Frame %d |  Timestamp: %" PRId64 ", metadata"
-                        " arrived: %s, buffers left: %d\n", mInFlightMap.keyAt(i),
+                        " arrived: %s, buffers left: %d\n", entry.frameNumber,
                         r.shutterTimestamp, r.haveResultMetadata ? "true" : "false",
                         r.numBuffersLeft);
             }
@@ -685,12 +693,29 @@ status_t Camera3Device::dump(int fd, [[maybe_unused]] const Vector<String16> &ar
         lines += "      Failed to acquire In-flight lock!\n";
     }
     write(fd, lines.c_str(), lines.size());
+    mInFlightLock.dump(fd, "      In-flight lock");
+
+    mResultMetadataAssembler.dump(fd);
 
     if (mRequestThread != NULL) {
         mRequestThread->dumpCaptureRequestLatency(fd,
                 "    ProcessCaptureRequest latency histogram:");
     }
 
+    {
+        CaptureStageLatencies stageLatencies = mCaptureStageLatencies;
+        mSessionStatsBuilder.mergeStageLatencies(&stageLatencies);
+        if (stageLatencies[0].count() > 0) {
+            lines = "    Capture stage latencies, from request queued:\n";
+            for (size_t i = 0; i < stageLatencies.size(); i++) {
+                lines += fmt::sprintf("      %s: %s\n",
+                        captureStageName(static_cast<CaptureStage>(i)),
+                        stageLatencies[i].summary().c_str());
+            }
+            write(fd, lines.c_str(), lines.size());
+        }
+    }
+
     {
         lines = "    Last request sent:\n";
         LatestRequestInfo lastRequestInfo = getLatestRequestInfoLocked();
@@ -935,6 +960,16 @@ status_t Camera3Device::submitRequestsHelper(
     }
 
     if (repeating) {
+        // Start allocating the buffers the repeating request will keep asking for, so that its
+        // first frames don't stall on buffer allocation.
+        if (mBufferManager != nullptr) {
+            for (const auto& request : requestList) {
+                for (const auto& stream : request->mOutputStreams) {
+                    mBufferManager->prefetchForStream(stream->getId(), stream->getStreamSetId(),
+                            stream->isMultiResolution());
+                }
+            }
+        }
         res = mRequestThread->setRepeatingRequests(requestList, lastFrameNumber);
     } else {
         res = mRequestThread->queueRequestList(requestList, lastFrameNumber);
@@ -2093,6 +2128,7 @@ void Camera3Device::notifyStatus(bool idle) {
             std::map<int, StreamStats> streamStatsMap;
             mSessionStatsBuilder.buildAndReset(&requestCount, &resultErrorCount,
                     &deviceError, &mostRequestedFpsRange, &streamStatsMap);
+            mSessionStatsBuilder.mergeAndResetStageLatencies(&mCaptureStageLatencies);
             for (size_t i = 0; i < streamIds.size(); i++) {
                 int streamId = streamIds[i];
                 auto stats = streamStatsMap.find(streamId);
@@ -2990,7 +3026,7 @@ status_t Camera3Device::registerInFlight(uint32_t frameNumber,
         const std::set<std::string>& cameraIdsWithZoom, bool useZoomRatio,
         const SurfaceMap& outputSurfaces, nsecs_t requestTimeNs) {
     ATRACE_CALL();
-    std::lock_guard<std::mutex> l(mInFlightLock);
+    std::lock_guard<InstrumentedMutex> l(mInFlightLock);
 
     ssize_t res;
     res = mInFlightMap.add(frameNumber, InFlightRequest(numBuffers, resultExtras, hasInput,
@@ -3033,12 +3069,12 @@ void Camera3Device::checkInflightMapLengthLocked() {
     if (mExpectedInflightDuration > kMinWarnInflightDuration) {
         if (!mIsConstrainedHighSpeedConfiguration && mInFlightMap.size() > kInFlightWarnLimit) {
             CLOGW("In-flight list too large: %zu, total inflight duration %" PRIu64,
-                    mInFlightMap.size(), mExpectedInflightDuration);
+                    mInFlightMap.size(), mExpectedInflightDuration.load());
         } else if (mIsConstrainedHighSpeedConfiguration && mInFlightMap.size() >
                 kInFlightWarnLimitHighSpeed) {
             CLOGW("In-flight list too large for high speed configuration: %zu,"
                     "total inflight duration %" PRIu64,
-                    mInFlightMap.size(), mExpectedInflightDuration);
+                    mInFlightMap.size(), mExpectedInflightDuration.load());
         }
     }
 }
@@ -3050,7 +3086,7 @@ void Camera3Device::onInflightMapFlushedLocked() {
 void Camera3Device::removeInFlightMapEntryLocked(int idx) {
     ATRACE_HFR_CALL();
     nsecs_t duration = mInFlightMap.valueAt(idx).maxExpectedDuration;
-    mInFlightMap.removeItemsAt(idx, 1);
+    mInFlightMap.removeItemAt(idx);
 
     onInflightEntryRemovedLocked(duration);
 }
@@ -3916,6 +3952,14 @@ bool Camera3Device::RequestThread::threadLoop() {
 
     nsecs_t tRequestEnd = systemTime(SYSTEM_TIME_MONOTONIC);
     mRequestLatency.add(tRequestStart, tRequestEnd);
+    if (parent != nullptr) {
+        for (const auto& nextRequest : mNextRequests) {
+            if (nextRequest.submitted && nextRequest.captureRequest->mRequestTimeNs > 0) {
+                parent->mSessionStatsBuilder.addStageLatency(CaptureStage::REQUEST_SUBMITTED,
+                        tRequestEnd - nextRequest.captureRequest->mRequestTimeNs);
+            }
+        }
+    }
 
     if (useFlushLock) {
         mFlushLock.unlock();
@@ -4011,87 +4055,60 @@ status_t Camera3Device::RequestThread::prepareHalRequests() {
             {
                 sp<Camera3Device> parent = mParent.promote();
                 if (parent != nullptr) {
-                    List<PhysicalCameraSettings>::iterator it;
-                    for (it = captureRequest->mSettingsList.begin();
-                            it != captureRequest->mSettingsList.end(); it++) {
-                        if (parent->mUHRCropAndMeteringRegionMappers.find(it->cameraId) ==
-                                parent->mUHRCropAndMeteringRegionMappers.end()) {
-                            continue;
-                        }
-
-                        if (!captureRequest->mUHRCropAndMeteringRegionsUpdated) {
-                            res = parent->mUHRCropAndMeteringRegionMappers[it->cameraId].
-                                    updateCaptureRequest(&(it->metadata));
-                            if (res != OK) {
-                                SET_ERR("RequestThread: Unable to correct capture requests "
-                                        "for scaler crop region and metering regions for request "
-                                        "%d: %s (%d)", halRequest->frame_number, strerror(-res),
-                                        res);
-                                return INVALID_OPERATION;
-                            }
-                            captureRequest->mUHRCropAndMeteringRegionsUpdated = true;
-                        }
+                    // Apply the coordinate mappers of each camera in one pass. As before,
+                    // UHR, distortion and zoom ratio only map the first camera which has the
+                    // mapper, while rotate-and-crop maps them all.
+                    uint32_t pendingMappers = 0;
+                    if (!captureRequest->mUHRCropAndMeteringRegionsUpdated) {
+                        pendingMappers |= RequestMetadataMappers::UHR_CROP_AND_METERING_REGIONS;
                     }
-
-                    // Correct metadata regions for distortion correction if enabled
-                    for (it = captureRequest->mSettingsList.begin();
-                            it != captureRequest->mSettingsList.end(); it++) {
-                        if (parent->mDistortionMappers.find(it->cameraId) ==
-                                parent->mDistortionMappers.end()) {
-                            continue;
-                        }
-
-                        if (!captureRequest->mDistortionCorrectionUpdated) {
-                            res = parent->mDistortionMappers[it->cameraId].correctCaptureRequest(
-                                    &(it->metadata));
-                            if (res != OK) {
-                                SET_ERR("RequestThread: Unable to correct capture requests "
-                                        "for lens distortion for request %d: %s (%d)",
-                                        halRequest->frame_number, strerror(-res), res);
-                                return INVALID_OPERATION;
-                            }
-                            captureRequest->mDistortionCorrectionUpdated = true;
-                        }
+                    if (!captureRequest->mDistortionCorrectionUpdated) {
+                        pendingMappers |= RequestMetadataMappers::DISTORTION_CORRECTION;
+                    }
+                    if (!captureRequest->mZoomRatioUpdated) {
+                        pendingMappers |= RequestMetadataMappers::ZOOM_RATIO;
+                    }
+                    const bool rotateAndCropPending = captureRequest->mRotateAndCropAuto &&
+                            !captureRequest->mRotationAndCropUpdated;
+                    if (rotateAndCropPending) {
+                        pendingMappers |= RequestMetadataMappers::ROTATE_AND_CROP;
                     }
 
+                    List<PhysicalCameraSettings>::iterator it;
                     for (it = captureRequest->mSettingsList.begin();
                             it != captureRequest->mSettingsList.end(); it++) {
-                        if (parent->mZoomRatioMappers.find(it->cameraId) ==
-                                parent->mZoomRatioMappers.end()) {
+                        auto chain = parent->mRequestMetadataMappers.find(it->cameraId);
+                        if (chain == nullptr) {
                             continue;
                         }
 
-                        if (!captureRequest->mZoomRatioIs1x) {
+                        if (chain->zoomRatio != nullptr && !captureRequest->mZoomRatioIs1x) {
                             cameraIdsWithZoom.insert(it->cameraId);
                         }
 
-                        if (!captureRequest->mZoomRatioUpdated) {
-                            res = parent->mZoomRatioMappers[it->cameraId].updateCaptureRequest(
-                                    &(it->metadata));
-                            if (res != OK) {
-                                SET_ERR("RequestThread: Unable to correct capture requests "
-                                        "for zoom ratio for request %d: %s (%d)",
-                                        halRequest->frame_number, strerror(-res), res);
-                                return INVALID_OPERATION;
-                            }
+                        uint32_t applied = 0;
+                        RequestMetadataMappers::Mapper failed;
+                        res = parent->mRequestMetadataMappers.apply(*chain, pendingMappers,
+                                &(it->metadata), &applied, &failed);
+                        if (res != OK) {
+                            SET_ERR("RequestThread: Unable to correct capture requests "
+                                    "for %s for request %d: %s (%d)",
+                                    RequestMetadataMappers::mapperName(failed),
+                                    halRequest->frame_number, strerror(-res), res);
+                            return INVALID_OPERATION;
+                        }
+                        if (applied & RequestMetadataMappers::UHR_CROP_AND_METERING_REGIONS) {
+                            captureRequest->mUHRCropAndMeteringRegionsUpdated = true;
+                        }
+                        if (applied & RequestMetadataMappers::DISTORTION_CORRECTION) {
+                            captureRequest->mDistortionCorrectionUpdated = true;
+                        }
+                        if (applied & RequestMetadataMappers::ZOOM_RATIO) {
                             captureRequest->mZoomRatioUpdated = true;
                         }
+                        pendingMappers &= ~(applied & ~RequestMetadataMappers::ROTATE_AND_CROP);
                     }
-                    if (captureRequest->mRotateAndCropAuto &&
-                            !captureRequest->mRotationAndCropUpdated) {
-                        for (it = captureRequest->mSettingsList.begin();
-                                it != captureRequest->mSettingsList.end(); it++) {
-                            auto mapper = parent->mRotateAndCropMappers.find(it->cameraId);
-                            if (mapper != parent->mRotateAndCropMappers.end()) {
-                                res = mapper->second.updateCaptureRequest(&(it->metadata));
-                                if (res != OK) {
-                                    SET_ERR("RequestThread: Unable to correct capture requests "
-                                            "for rotate-and-crop for request %d: %s (%d)",
-                                            halRequest->frame_number, strerror(-res), res);
-                                    return INVALID_OPERATION;
-                                }
-                            }
-                        }
+                    if (rotateAndCropPending) {
                         captureRequest->mRotationAndCropUpdated = true;
                     }
 
@@ -4578,9 +4595,9 @@ status_t Camera3Device::RequestThread::setZoomOverride(int32_t zoomOverride) {
 
 nsecs_t Camera3Device::getExpectedInFlightDuration() {
     ATRACE_CALL();
-    std::lock_guard<std::mutex> l(mInFlightLock);
-    return mExpectedInflightDuration > kMinInflightDuration ?
-            mExpectedInflightDuration : kMinInflightDuration;
+    nsecs_t expectedInflightDuration = mExpectedInflightDuration;
+    return expectedInflightDuration > kMinInflightDuration ?
+            expectedInflightDuration : kMinInflightDuration;
 }
 
 void Camera3Device::RequestThread::cleanupPhysicalSettings(sp<CaptureRequest> request,
@@ -4701,7 +4718,7 @@ void Camera3Device::RequestThread::cleanUpFailedRequests(bool sendRequestError)
         {
           sp<Camera3Device> parent = mParent.promote();
           if (parent != NULL) {
-              std::lock_guard<std::mutex> l(parent->mInFlightLock);
+              std::lock_guard<InstrumentedMutex> l(parent->mInFlightLock);
               ssize_t idx = parent->mInFlightMap.indexOfKey(captureRequest->mResultExtras.frameNumber);
               if (idx >= 0) {
                   ALOGV("%s: Remove inflight request from queue: frameNumber %" PRId64,
@@ -17,6 +17,7 @@
 #ifndef ANDROID_SERVERS_CAMERA3DEVICE_H
 #define ANDROID_SERVERS_CAMERA3DEVICE_H
 
+#include <atomic>
 #include <utility>
 #include <unordered_map>
 #include <set>
@@ -46,11 +47,14 @@
 #include "device3/ZoomRatioMapper.h"
 #include "device3/RotateAndCropMapper.h"
 #include "device3/UHRCropAndMeteringRegionMapper.h"
+#include "device3/RequestMetadataMappers.h"
 #include "device3/InFlightRequest.h"
 #include "device3/Camera3OutputInterface.h"
+#include "device3/Camera3OutputUtils.h"
 #include "device3/Camera3OfflineSession.h"
 #include "device3/Camera3StreamInterface.h"
 #include "utils/AttributionAndPermissionUtils.h"
+#include "utils/InstrumentedMutex.h"
 #include "utils/TagMonitor.h"
 #include "utils/IPCTransport.h"
 #include "utils/LatencyHistogram.h"
@@ -678,6 +682,8 @@ class Camera3Device :
     sp<camera3::Camera3Stream> mInputStream;
     bool                       mIsInputStreamMultiResolution;
     SessionStatsBuilder        mSessionStatsBuilder;
+    // Capture stage latencies of the past sessions, merged in as each session goes idle
+    CaptureStageLatencies      mCaptureStageLatencies;
     // Map from stream group ID to physical cameras backing the stream group
     std::map<int32_t, std::set<std::string>> mGroupIdPhysicalCameraMap;
 
@@ -1347,9 +1353,10 @@ class Camera3Device :
     /**
      * In-flight queue for tracking completion of capture requests.
      */
-    std::mutex                    mInFlightLock;
+    InstrumentedMutex             mInFlightLock;
     camera3::InFlightRequestMap   mInFlightMap;
-    nsecs_t                       mExpectedInflightDuration = 0;
+    // Also read without mInFlightLock, by getExpectedInFlightDuration
+    std::atomic<nsecs_t>          mExpectedInflightDuration{0};
     int64_t                       mLastCompletedRegularFrameNumber = -1;
     int64_t                       mLastCompletedReprocessFrameNumber = -1;
     int64_t                       mLastCompletedZslFrameNumber = -1;
@@ -1453,6 +1460,8 @@ class Camera3Device :
     std::list<CaptureResult>    mResultQueue;
     std::condition_variable  mResultSignal;
     wp<NotificationListener> mListener;
+    // Assembles the result metadata, counters readable without the lock
+    camera3::ResultMetadataAssembler mResultMetadataAssembler;
 
     /**** End scope for mOutputLock ****/
 
@@ -1493,6 +1502,12 @@ class Camera3Device :
      */
     std::unordered_map<std::string, camera3::RotateAndCropMapper> mRotateAndCropMappers;
 
+    /**
+     * The mappers above composed per camera, applied to the capture requests by the
+     * RequestThread
+     */
+    camera3::RequestMetadataMappers mRequestMetadataMappers;
+
     // Debug tracker for metadata tag value changes
     // - Enabled with the -m <taglist> option to dumpsys, such as
     //   dumpsys -m android.control.aeState,android.control.aeMode
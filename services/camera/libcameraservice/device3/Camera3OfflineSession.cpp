@@ -90,9 +90,17 @@ const std::string& Camera3OfflineSession::getId() const {
     return mId;
 }
 
-status_t Camera3OfflineSession::dump(int /*fd*/) {
+status_t Camera3OfflineSession::dump(int fd) {
     ATRACE_CALL();
     std::lock_guard<std::mutex> il(mInterfaceLock);
+
+    size_t offlineReqCount;
+    {
+        std::lock_guard<InstrumentedMutex> lock(mOfflineReqsLock);
+        offlineReqCount = mOfflineReqs.size();
+    }
+    dprintf(fd, "    Offline requests in flight: %zu\n", offlineReqCount);
+    mOfflineReqsLock.dump(fd, "      Offline requests lock");
     return OK;
 }
 
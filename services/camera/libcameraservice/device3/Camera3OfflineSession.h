@@ -32,6 +32,7 @@
 #include "device3/Camera3OutputUtils.h"
 #include "device3/RotateAndCropMapper.h"
 #include "device3/ZoomRatioMapper.h"
+#include "utils/InstrumentedMutex.h"
 #include "utils/TagMonitor.h"
 #include <camera_metadata_hidden.h>
 
@@ -177,7 +178,7 @@ class Camera3OfflineSession :
     camera3::BufferRecords mBufferRecords;
     SessionStatsBuilder mSessionStatsBuilder;
 
-    std::mutex mOfflineReqsLock;
+    InstrumentedMutex mOfflineReqsLock;
     camera3::InFlightRequestMap mOfflineReqs;
 
     TagMonitor mTagMonitor;
@@ -193,6 +194,7 @@ class Camera3OfflineSession :
     std::mutex mOutputLock;
     std::list<CaptureResult> mResultQueue;
     std::condition_variable mResultSignal;
+    camera3::ResultMetadataAssembler mResultMetadataAssembler;
     // the last completed frame number of regular requests
     int64_t mLastCompletedRegularFrameNumber;
     // the last completed frame number of reprocess requests
@@ -771,6 +771,11 @@ status_t Camera3OutputStream::getBufferLockedCommon(ANativeWindowBuffer** anb, i
                         __FUNCTION__, mId, strerror(-res), res);
             }
             if (res != OK) {
+                // The buffer never made it to the buffer queue, give it back with its fence
+                mBufferManager->cancelBufferForStream(getId(), getStreamSetId(),
+                        isMultiResolution(), gb, *fenceFd);
+                *fenceFd = -1;
+                *anb = nullptr;
                 checkRetAndSetAbandonedLocked(res);
                 return res;
             }
@@ -869,6 +874,10 @@ status_t Camera3OutputStream::getBufferLockedCommon(ANativeWindowBuffer** anb, i
                         ALOGE("%s: Stream %d: Can't attach the output buffer to this surface:"
                                 " %s (%d)", __FUNCTION__, mId, strerror(-res), res);
                     }
+                    mBufferManager->cancelBufferForStream(getId(), getStreamSetId(),
+                            isMultiResolution(), gb, *fenceFd);
+                    *fenceFd = -1;
+                    *anb = nullptr;
                     checkRetAndSetAbandonedLocked(res);
                     return res;
                 }
@@ -952,6 +961,10 @@ status_t Camera3OutputStream::disconnectLocked() {
         mPreviewFrameSpacer->requestExit();
     }
 
+    if (mUseBufferManager && mState != STATE_ABANDONED) {
+        recycleFreeBuffersLocked();
+    }
+
     ALOGV("%s: disconnecting stream %d from native window", __FUNCTION__, getId());
 
     res = native_window_api_disconnect(mConsumer.get(),
@@ -1105,11 +1118,13 @@ void Camera3OutputStream::BufferProducerListener::onBufferReleased() {
 
     if (shouldFreeBuffer) {
         sp<GraphicBuffer> buffer;
-        // Detach and free a buffer (when buffer goes out of scope)
-        stream->detachBufferLocked(&buffer, /*fenceFd*/ nullptr);
+        int fenceFd = -1;
+        // Detach a buffer, and hand it to the buffer manager to recycle or free
+        stream->detachBufferLocked(&buffer, &fenceFd);
         if (buffer.get() != nullptr) {
             stream->mBufferManager->notifyBufferRemoved(
-                    stream->getId(), stream->getStreamSetId(), stream->isMultiResolution());
+                    stream->getId(), stream->getStreamSetId(), stream->isMultiResolution(),
+                    buffer, fenceFd);
         }
     }
 }
@@ -1185,6 +1200,27 @@ status_t Camera3OutputStream::detachBufferLocked(sp<GraphicBuffer>* buffer, int*
     return res;
 }
 
+void Camera3OutputStream::recycleFreeBuffersLocked() {
+    size_t recycled = 0;
+    for (size_t i = 0; i < mTotalBufferCount; i++) {
+        sp<GraphicBuffer> buffer;
+        sp<Fence> fence;
+        // Fails with NO_MEMORY once no free buffer is left
+        if (mConsumer->detachNextBuffer(&buffer, &fence) != OK || buffer == nullptr) {
+            break;
+        }
+        int fenceFd = (fence != nullptr && fence->isValid()) ? fence->dup() : -1;
+        mBufferManager->notifyBufferRemoved(getId(), getStreamSetId(), isMultiResolution(),
+                buffer, fenceFd);
+        recycled++;
+    }
+    if (recycled > 0) {
+        checkRemovedBuffersLocked(/*notifyBufferManager*/false);
+    }
+    ALOGV("%s: Stream %d: %zu free buffers handed back to the buffer manager", __FUNCTION__,
+            mId, recycled);
+}
+
 status_t Camera3OutputStream::dropBuffers(bool dropping) {
     Mutex::Autolock l(mLock);
     mDropBuffers = dropping;
@@ -410,6 +410,10 @@ class Camera3OutputStream :
     // manager so buffer manager doesn't need to be notified.
     void checkRemovedBuffersLocked(bool notifyBufferManager = true);
 
+    // Detach the free buffers from the consumer, and hand them to the buffer manager, so that
+    // they can be reused after the stream is reconfigured.
+    void recycleFreeBuffersLocked();
+
     // Check return status of IGBP calls and set abandoned state accordingly
     void checkRetAndSetAbandonedLocked(status_t res);
 
@@ -32,6 +32,8 @@
 
 #include <inttypes.h>
 
+#include <algorithm>
+
 #include <utils/Log.h>
 #include <utils/SortedVector.h>
 #include <utils/Trace.h>
@@ -210,6 +212,168 @@ void correctMeteringRegions(camera_metadata_t *meta) {
     }
 }
 
+/**
+ * Apply the coordinate mappers and the fixups to the result metadata of one camera, in a single
+ * pass: distortion correction, zoom ratio, rotate-and-crop, then the flash strength,
+ * autoframing and monochrome fixups. On error, *failedStep describes the step which failed.
+ */
+status_t mapResultMetadata(CaptureOutputStates& states, const std::string& cameraId,
+        const CameraMetadata& deviceInfo, bool zoomMethodIsRatio, bool zoomRatioIs1,
+        bool rotateAndCropAuto, CameraMetadata& metadata, const char** failedStep) {
+    // Fix up some result metadata to account for HAL-level distortion correction
+    auto distortionMapper = states.distortionMappers.find(cameraId);
+    if (distortionMapper != states.distortionMappers.end()) {
+        status_t res = distortionMapper->second.correctCaptureResult(&metadata);
+        if (res != OK) {
+            *failedStep = "correct capture result metadata";
+            return res;
+        }
+    }
+
+    // Fix up result metadata to account for zoom ratio availabilities between
+    // HAL and app.
+    status_t res = states.zoomRatioMappers[cameraId].updateCaptureResult(&metadata,
+            zoomMethodIsRatio, zoomRatioIs1);
+    if (res != OK) {
+        *failedStep = "update capture result zoom ratio metadata";
+        return res;
+    }
+
+    // Fix up result metadata to account for rotateAndCrop in AUTO mode
+    if (rotateAndCropAuto) {
+        auto rotateAndCropMapper = states.rotateAndCropMappers.find(cameraId);
+        if (rotateAndCropMapper != states.rotateAndCropMappers.end()) {
+            res = rotateAndCropMapper->second.updateCaptureResult(&metadata);
+            if (res != OK) {
+                *failedStep = "correct capture result rotate-and-crop";
+                return res;
+            }
+        }
+    }
+
+    // Fix up manual flash strength control metadata
+    res = fixupManualFlashStrengthControlTags(metadata);
+    if (res != OK) {
+        *failedStep = "set flash strength level defaults in result metadata";
+        return res;
+    }
+
+    // Fix up autoframing metadata
+    res = fixupAutoframingTags(metadata);
+    if (res != OK) {
+        *failedStep = "set autoframing defaults in result metadata";
+        return res;
+    }
+
+    // Fix up result metadata for monochrome camera.
+    res = fixupMonochromeTags(states, deviceInfo, metadata);
+    if (res != OK) {
+        *failedStep = "override result metadata";
+        return res;
+    }
+
+    return OK;
+}
+
+// Room left in the assembled result metadata for the entries added by the fixups and the
+// mappers, and by insertResultLocked().
+static constexpr size_t kResultMetadataExtraEntries = 16;
+static constexpr size_t kResultMetadataExtraData = 256;
+
+CameraMetadata ResultMetadataAssembler::assemble(const camera_metadata_t* result,
+        const camera_metadata_t* partials) {
+    const camera_metadata_t* sources[] = { result, partials };
+    size_t entryCount = 0;
+    size_t dataCount = 0;
+    for (const camera_metadata_t* source : sources) {
+        if (source == nullptr) continue;
+        entryCount += get_camera_metadata_entry_count(source);
+        dataCount += get_camera_metadata_data_count(source);
+    }
+    camera_metadata_t* assembled = allocate_camera_metadata(
+            std::max(entryCount, mLastEntryCount) + kResultMetadataExtraEntries,
+            std::max(dataCount, mLastDataCount) + kResultMetadataExtraData);
+    if (assembled == nullptr) {
+        ALOGE("%s: Unable to allocate %zu result metadata entries", __FUNCTION__, entryCount);
+        return CameraMetadata();
+    }
+    mAllocations.fetch_add(1, std::memory_order_relaxed);
+
+    // Merge the entries in tag order, so that the result needs no sort of its own. The sort
+    // is stable to keep the HAL result entries ahead of the partial ones.
+    mEntries.clear();
+    for (uint32_t s = 0; s < std::size(sources); s++) {
+        if (sources[s] == nullptr) continue;
+        const size_t count = get_camera_metadata_entry_count(sources[s]);
+        for (size_t i = 0; i < count; i++) {
+            camera_metadata_ro_entry_t entry;
+            if (get_camera_metadata_ro_entry(sources[s], i, &entry) == OK) {
+                mEntries.push_back({entry.tag, s, i});
+            }
+        }
+    }
+    std::stable_sort(mEntries.begin(), mEntries.end(),
+            [](const Entry& a, const Entry& b) { return a.tag < b.tag; });
+
+    for (const Entry& e : mEntries) {
+        camera_metadata_ro_entry_t entry;
+        get_camera_metadata_ro_entry(sources[e.source], e.index, &entry);
+        if (add_camera_metadata_entry(assembled, entry.tag, entry.data.u8, entry.count) != OK) {
+            ALOGE("%s: Unable to add result metadata tag 0x%x", __FUNCTION__, entry.tag);
+        }
+    }
+    mCopies.fetch_add(1, std::memory_order_relaxed);
+    mBytesCopied.fetch_add(get_camera_metadata_data_count(assembled), std::memory_order_relaxed);
+
+    // The entries are already in order: this moves none of them and sets the sorted flag
+    // which find() relies on.
+    sort_camera_metadata(assembled);
+    return CameraMetadata(assembled);
+}
+
+void ResultMetadataAssembler::countCopy(const camera_metadata_t* metadata) {
+    if (metadata == nullptr) return;
+    mAllocations.fetch_add(1, std::memory_order_relaxed);
+    mCopies.fetch_add(1, std::memory_order_relaxed);
+    mBytesCopied.fetch_add(get_camera_metadata_data_count(metadata),
+            std::memory_order_relaxed);
+}
+
+void ResultMetadataAssembler::countCopy(const CameraMetadata& metadata) {
+    const camera_metadata_t* buffer = metadata.getAndLock();
+    countCopy(buffer);
+    metadata.unlock(buffer);
+}
+
+void ResultMetadataAssembler::finish(const CameraMetadata& metadata,
+        const camera_metadata_t* assembled) {
+    const camera_metadata_t* buffer = metadata.getAndLock();
+    if (buffer != assembled) {
+        // A fixup or a mapper outgrew the assembled result.
+        countCopy(buffer);
+    }
+    if (buffer != nullptr) {
+        mLastEntryCount = get_camera_metadata_entry_count(buffer);
+        mLastDataCount = get_camera_metadata_data_count(buffer);
+    }
+    metadata.unlock(buffer);
+    mResults.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ResultMetadataAssembler::dump(int fd) const {
+    const int64_t results = mResults.load(std::memory_order_relaxed);
+    const int64_t allocations = mAllocations.load(std::memory_order_relaxed);
+    const int64_t copies = mCopies.load(std::memory_order_relaxed);
+    const int64_t bytes = mBytesCopied.load(std::memory_order_relaxed);
+    dprintf(fd, "    Result metadata: %" PRId64 " results, %" PRId64 " allocations, %" PRId64
+            " copies, %" PRId64 " data bytes copied", results, allocations, copies, bytes);
+    if (results > 0) {
+        dprintf(fd, " (%.2f allocations, %.2f copies, %" PRId64 " bytes per result)",
+                (double)allocations / results, (double)copies / results, bytes / results);
+    }
+    dprintf(fd, "\n");
+}
+
 void insertResultLocked(CaptureOutputStates& states, CaptureResult *result, uint32_t frameNumber) {
     if (result == nullptr) return;
 
@@ -240,9 +404,9 @@ void insertResultLocked(CaptureOutputStates& states, CaptureResult *result, uint
         metadata.unlock(pmeta);
     }
 
-    // Valid result, insert into queue
+    // Valid result, move into queue
     std::list<CaptureResult>::iterator queuedResult =
-            states.resultQueue.insert(states.resultQueue.end(), CaptureResult(*result));
+            states.resultQueue.insert(states.resultQueue.end(), std::move(*result));
     ALOGV("%s: result requestId = %" PRId32 ", frameNumber = %" PRId64
            ", burstId = %" PRId32, __FUNCTION__,
            queuedResult->mResultExtras.requestId,
@@ -262,6 +426,7 @@ void sendPartialCaptureResult(CaptureOutputStates& states,
     CaptureResult captureResult;
     captureResult.mResultExtras = resultExtras;
     captureResult.mMetadata = partialResult;
+    states.resultMetadataAssembler.countCopy(partialResult);
 
     // Fix up result metadata for monochrome camera.
     status_t res = fixupMonochromeTags(states, states.deviceInfo, captureResult.mMetadata);
@@ -299,17 +464,18 @@ void sendPartialCaptureResult(CaptureOutputStates& states,
     }
 }
 
+// The physical metadatas are moved into the result.
 void sendCaptureResult(
         CaptureOutputStates& states,
-        CameraMetadata &pendingMetadata,
+        const camera_metadata_t *pendingMetadata,
         CaptureResultExtras &resultExtras,
-        CameraMetadata &collectedPartialResult,
+        const CameraMetadata &collectedPartialResult,
         uint32_t frameNumber,
         bool reprocess, bool zslStillCapture, bool rotateAndCropAuto,
         const std::set<std::string>& cameraIdsWithZoom, bool useZoomRatio,
-        const std::vector<PhysicalCaptureResultInfo>& physicalMetadatas) {
+        std::vector<PhysicalCaptureResultInfo>& physicalMetadatas) {
     ATRACE_CALL();
-    if (pendingMetadata.isEmpty())
+    if (pendingMetadata == nullptr || get_camera_metadata_entry_count(pendingMetadata) == 0)
         return;
 
     std::lock_guard<std::mutex> l(states.outputLock);
@@ -341,17 +507,33 @@ void sendCaptureResult(
         states.nextResultFrameNum = frameNumber + 1;
     }
 
+    // The tag monitor sees the physical results before their fixups.
+    std::unordered_map<std::string, CameraMetadata> monitoredPhysicalMetadata;
+    if (states.tagMonitor.isMonitoring()) {
+        for (auto& m : physicalMetadatas) {
+            const auto& metadata = m.mCameraMetadataInfo.get<CameraMetadataInfo::metadata>();
+            monitoredPhysicalMetadata.emplace(m.mPhysicalCameraId, CameraMetadata(metadata));
+            states.resultMetadataAssembler.countCopy(metadata);
+        }
+    }
+
     CaptureResult captureResult;
     captureResult.mResultExtras = resultExtras;
-    captureResult.mMetadata = pendingMetadata;
-    captureResult.mPhysicalMetadatas = physicalMetadatas;
-
-    // Append any previous partials to form a complete result
-    if (states.usePartialResult && !collectedPartialResult.isEmpty()) {
-        captureResult.mMetadata.append(collectedPartialResult);
+    captureResult.mPhysicalMetadatas = std::move(physicalMetadatas);
+
+    // Merge any previous partials to form a complete result
+    const CameraMetadata noPartials;
+    const CameraMetadata& partials = states.usePartialResult ? collectedPartialResult : noPartials;
+    const camera_metadata_t *partialsBuffer = partials.getAndLock();
+    captureResult.mMetadata = states.resultMetadataAssembler.assemble(pendingMetadata,
+            partialsBuffer);
+    partials.unlock(partialsBuffer);
+    if (captureResult.mMetadata.isEmpty()) {
+        SET_ERR("Unable to assemble result metadata for frame %d", frameNumber);
+        return;
     }
-
-    captureResult.mMetadata.sort();
+    const camera_metadata_t *assembled = captureResult.mMetadata.getAndLock();
+    captureResult.mMetadata.unlock(assembled);
 
     // Check that there's a timestamp in the result metadata
     camera_metadata_entry timestamp = captureResult.mMetadata.find(ANDROID_SENSOR_TIMESTAMP);
@@ -373,129 +555,37 @@ void sendCaptureResult(
         }
     }
 
-    // Fix up some result metadata to account for HAL-level distortion correction
-    status_t res = OK;
-    auto iter = states.distortionMappers.find(states.cameraId);
-    if (iter != states.distortionMappers.end()) {
-        res = iter->second.correctCaptureResult(&captureResult.mMetadata);
-        if (res != OK) {
-            SET_ERR("Unable to correct capture result metadata for frame %d: %s (%d)",
-                    frameNumber, strerror(-res), res);
-            return;
-        }
-    }
-
-    // Fix up result metadata to account for zoom ratio availabilities between
-    // HAL and app.
+    // Map and fix up the logical camera result, then each physical camera result, one camera
+    // at a time.
+    const char* failedStep = nullptr;
     bool zoomRatioIs1 = cameraIdsWithZoom.find(states.cameraId) == cameraIdsWithZoom.end();
-    res = states.zoomRatioMappers[states.cameraId].updateCaptureResult(
-            &captureResult.mMetadata, useZoomRatio, zoomRatioIs1);
-    if (res != OK) {
-        SET_ERR("Failed to update capture result zoom ratio metadata for frame %d: %s (%d)",
-                frameNumber, strerror(-res), res);
-        return;
-    }
-
-    // Fix up result metadata to account for rotateAndCrop in AUTO mode
-    if (rotateAndCropAuto) {
-        auto mapper = states.rotateAndCropMappers.find(states.cameraId);
-        if (mapper != states.rotateAndCropMappers.end()) {
-            res = mapper->second.updateCaptureResult(
-                    &captureResult.mMetadata);
-            if (res != OK) {
-                SET_ERR("Unable to correct capture result rotate-and-crop for frame %d: %s (%d)",
-                        frameNumber, strerror(-res), res);
-                return;
-            }
-        }
-    }
-
-    // Fix up manual flash strength control metadata
-    res = fixupManualFlashStrengthControlTags(captureResult.mMetadata);
-    if (res != OK) {
-        SET_ERR("Failed to set flash strength level defaults in result metadata: %s (%d)",
-                strerror(-res), res);
-        return;
-    }
-    for (auto& physicalMetadata : captureResult.mPhysicalMetadatas) {
-        res = fixupManualFlashStrengthControlTags(physicalMetadata.mCameraMetadataInfo.
-                get<CameraMetadataInfo::metadata>());
-        if (res != OK) {
-            SET_ERR("Failed to set flash strength level defaults in physical result"
-                    " metadata: %s (%d)", strerror(-res), res);
-            return;
-        }
-    }
-
-    // Fix up autoframing metadata
-    res = fixupAutoframingTags(captureResult.mMetadata);
+    status_t res = mapResultMetadata(states, states.cameraId, states.deviceInfo,
+            useZoomRatio, zoomRatioIs1, rotateAndCropAuto, captureResult.mMetadata, &failedStep);
     if (res != OK) {
-        SET_ERR("Failed to set autoframing defaults in result metadata: %s (%d)",
+        SET_ERR("Unable to %s for frame %d: %s (%d)", failedStep, frameNumber,
                 strerror(-res), res);
         return;
     }
     for (auto& physicalMetadata : captureResult.mPhysicalMetadatas) {
-        res = fixupAutoframingTags(physicalMetadata.mCameraMetadataInfo.
-                get<CameraMetadataInfo::metadata>());
-        if (res != OK) {
-            SET_ERR("Failed to set autoframing defaults in physical result metadata: %s (%d)",
-                    strerror(-res), res);
-            return;
-        }
-    }
-
-    for (auto& physicalMetadata : captureResult.mPhysicalMetadatas) {
-        const std::string cameraId = physicalMetadata.mPhysicalCameraId;
-        auto mapper = states.distortionMappers.find(cameraId);
-        if (mapper != states.distortionMappers.end()) {
-            res = mapper->second.correctCaptureResult(
-                    &physicalMetadata.mCameraMetadataInfo.get<CameraMetadataInfo::metadata>());
-            if (res != OK) {
-                SET_ERR("Unable to correct physical capture result metadata for frame %d: %s (%d)",
-                        frameNumber, strerror(-res), res);
-                return;
-            }
-        }
-
+        const std::string &cameraId = physicalMetadata.mPhysicalCameraId;
         // Note: Physical camera continues to use SCALER_CROP_REGION to reflect
         // zoom levels. Model this by treating app-set ZOOM_RATIO as 1x.
-        res = states.zoomRatioMappers[cameraId].updateCaptureResult(
-                &physicalMetadata.mCameraMetadataInfo.get<CameraMetadataInfo::metadata>(),
-                /*zoomMethodIsRatio*/false,
-                /*zoomRatioIs1*/true);
+        res = mapResultMetadata(states, cameraId, states.physicalDeviceInfoMap.at(cameraId),
+                /*zoomMethodIsRatio*/false, /*zoomRatioIs1*/true, /*rotateAndCropAuto*/false,
+                physicalMetadata.mCameraMetadataInfo.get<CameraMetadataInfo::metadata>(),
+                &failedStep);
         if (res != OK) {
-            SET_ERR("Failed to update camera %s's physical zoom ratio metadata for "
-                    "frame %d: %s(%d)", cameraId.c_str(), frameNumber, strerror(-res), res);
+            SET_ERR("Unable to %s of physical camera %s for frame %d: %s (%d)", failedStep,
+                    cameraId.c_str(), frameNumber, strerror(-res), res);
             return;
         }
     }
 
-    // Fix up result metadata for monochrome camera.
-    res = fixupMonochromeTags(states, states.deviceInfo, captureResult.mMetadata);
-    if (res != OK) {
-        SET_ERR("Failed to override result metadata: %s (%d)", strerror(-res), res);
-        return;
-    }
-    for (auto& physicalMetadata : captureResult.mPhysicalMetadatas) {
-        const std::string &cameraId = physicalMetadata.mPhysicalCameraId;
-        res = fixupMonochromeTags(states,
-                states.physicalDeviceInfoMap.at(cameraId),
-                physicalMetadata.mCameraMetadataInfo.get<CameraMetadataInfo::metadata>());
-        if (res != OK) {
-            SET_ERR("Failed to override result metadata: %s (%d)", strerror(-res), res);
-            return;
-        }
-    }
-
-    std::unordered_map<std::string, CameraMetadata> monitoredPhysicalMetadata;
-    for (auto& m : physicalMetadatas) {
-        monitoredPhysicalMetadata.emplace(m.mPhysicalCameraId,
-                CameraMetadata(m.mCameraMetadataInfo.get<CameraMetadataInfo::metadata>()));
-    }
     states.tagMonitor.monitorMetadata(TagMonitor::RESULT,
             frameNumber, sensorTimestamp, captureResult.mMetadata,
             monitoredPhysicalMetadata);
 
+    states.resultMetadataAssembler.finish(captureResult.mMetadata, assembled);
     insertResultLocked(states, &captureResult, frameNumber);
 }
 
@@ -503,7 +593,7 @@ void removeInFlightMapEntryLocked(CaptureOutputStates& states, int idx) {
     ATRACE_CALL();
     InFlightRequestMap& inflightMap = states.inflightMap;
     nsecs_t duration = inflightMap.valueAt(idx).maxExpectedDuration;
-    inflightMap.removeItemsAt(idx, 1);
+    inflightMap.removeItemAt(idx);
 
     states.inflightIntf.onInflightEntryRemovedLocked(duration);
 }
@@ -591,13 +681,16 @@ bool erasePhysicalCameraIdSet(
 }
 
 const std::set<std::string>& getCameraIdsWithZoomLocked(
-        const InFlightRequestMap& inflightMap, const CameraMetadata& metadata,
+        const InFlightRequestMap& inflightMap, const camera_metadata_t *metadata,
         const std::set<std::string>& cameraIdsWithZoom) {
-    camera_metadata_ro_entry overrideEntry =
-            metadata.find(ANDROID_CONTROL_SETTINGS_OVERRIDE);
-    camera_metadata_ro_entry frameNumberEntry =
-            metadata.find(ANDROID_CONTROL_SETTINGS_OVERRIDING_FRAME_NUMBER);
-    if (overrideEntry.count != 1
+    camera_metadata_ro_entry overrideEntry;
+    camera_metadata_ro_entry frameNumberEntry;
+    if (metadata == nullptr
+            || find_camera_metadata_ro_entry(metadata, ANDROID_CONTROL_SETTINGS_OVERRIDE,
+                    &overrideEntry) != OK
+            || find_camera_metadata_ro_entry(metadata,
+                    ANDROID_CONTROL_SETTINGS_OVERRIDING_FRAME_NUMBER, &frameNumberEntry) != OK
+            || overrideEntry.count != 1
             || overrideEntry.data.i32[0] != ANDROID_CONTROL_SETTINGS_OVERRIDE_ZOOM
             || frameNumberEntry.count != 1) {
         // No valid overriding frame number, skip
@@ -651,7 +744,7 @@ void processCaptureResult(CaptureOutputStates& states, const camera_capture_resu
     std::vector<BufferToReturn> returnableBuffers{};
     nsecs_t shutterTimestamp = 0;
     {
-        std::lock_guard<std::mutex> l(states.inflightLock);
+        std::lock_guard<InstrumentedMutex> l(states.inflightLock);
         ssize_t idx = states.inflightMap.indexOfKey(frameNumber);
         if (idx == NAME_NOT_FOUND) {
             SET_ERR("Unknown frame number for capture result: %d",
@@ -703,8 +796,8 @@ void processCaptureResult(CaptureOutputStates& states, const camera_capture_resu
                                 // but we could still try and configure it for any future requests
                                 // that are still in flight. The assumption is that the physical
                                 // device id remains the same for the duration of the pending queue.
-                                for (size_t i = 0; i < states.inflightMap.size(); i++) {
-                                    auto &r = states.inflightMap.editValueAt(i);
+                                for (auto& entry : states.inflightMap) {
+                                    auto &r = entry.value;
                                     if (r.requestTimeNs >= request.requestTimeNs) {
                                         r.transform = transform;
                                     }
@@ -739,6 +832,10 @@ void processCaptureResult(CaptureOutputStates& states, const camera_capture_resu
                 return;
             }
             if (isPartialResult) {
+                if (request.collectedPartialResult.isEmpty() && request.requestTimeNs > 0) {
+                    states.sessionStatsBuilder.addStageLatency(CaptureStage::PARTIAL_RESULT,
+                            systemTime() - request.requestTimeNs);
+                }
                 request.collectedPartialResult.append(result->result);
             }
 
@@ -781,6 +878,10 @@ void processCaptureResult(CaptureOutputStates& states, const camera_capture_resu
             }
             request.haveResultMetadata = true;
             request.errorBufStrategy = ERROR_BUF_RETURN_NOTIFY;
+            if (request.requestTimeNs > 0) {
+                states.sessionStatsBuilder.addStageLatency(CaptureStage::RESULT,
+                        systemTime() - request.requestTimeNs);
+            }
         }
 
         uint32_t numBuffersReturned = result->num_output_buffers;
@@ -799,6 +900,10 @@ void processCaptureResult(CaptureOutputStates& states, const camera_capture_resu
                     frameNumber);
             return;
         }
+        if (numBuffersReturned > 0 && request.numBuffersLeft == 0 && request.requestTimeNs > 0) {
+            states.sessionStatsBuilder.addStageLatency(CaptureStage::BUFFERS_RETURNED,
+                    systemTime() - request.requestTimeNs);
+        }
 
         camera_metadata_ro_entry_t entry;
         res = find_camera_metadata_ro_entry(result->result,
@@ -821,20 +926,29 @@ void processCaptureResult(CaptureOutputStates& states, const camera_capture_resu
 
         if (result->result != NULL && !isPartialResult) {
             for (uint32_t i = 0; i < result->num_physcam_metadata; i++) {
-                CameraMetadata physicalMetadata;
-                physicalMetadata.append(result->physcam_metadata[i]);
-                request.physicalMetadatas.push_back({result->physcam_ids[i],
-                        physicalMetadata});
+                const camera_metadata_t *halMetadata = result->physcam_metadata[i];
+                // Leave room for the fixups and the mappers to update it in place.
+                CameraMetadata physicalMetadata(
+                        get_camera_metadata_entry_count(halMetadata)
+                                + kResultMetadataExtraEntries,
+                        get_camera_metadata_data_count(halMetadata)
+                                + kResultMetadataExtraData);
+                physicalMetadata.append(halMetadata);
+                states.resultMetadataAssembler.countCopy(halMetadata);
+                auto& info = request.physicalMetadatas.emplace_back();
+                info.mPhysicalCameraId = result->physcam_ids[i];
+                info.mCameraMetadataInfo.set<CameraMetadataInfo::metadata>(
+                        std::move(physicalMetadata));
             }
             if (shutterTimestamp == 0) {
                 request.pendingMetadata = result->result;
-                request.collectedPartialResult = collectedPartialResult;
+                states.resultMetadataAssembler.countCopy(result->result);
+                request.collectedPartialResult.acquire(collectedPartialResult);
             } else if (request.hasCallback) {
-                CameraMetadata metadata;
-                metadata = result->result;
+                // The HAL result is only read, sendCaptureResult() assembles the copy.
                 auto cameraIdsWithZoom = getCameraIdsWithZoomLocked(
-                        states.inflightMap, metadata, request.cameraIdsWithZoom);
-                sendCaptureResult(states, metadata, request.resultExtras,
+                        states.inflightMap, result->result, request.cameraIdsWithZoom);
+                sendCaptureResult(states, result->result, request.resultExtras,
                     collectedPartialResult, frameNumber,
                     hasInputBufferInRequest, request.zslCapture && request.stillCapture,
                     request.rotateAndCropAuto, cameraIdsWithZoom, request.useZoomRatio,
@@ -1030,7 +1144,7 @@ void notifyShutter(CaptureOutputStates& states, const camera_shutter_msg_t &msg)
     // Set timestamp for the request in the in-flight tracking
     // and get the request ID to send upstream
     {
-        std::lock_guard<std::mutex> l(states.inflightLock);
+        std::lock_guard<InstrumentedMutex> l(states.inflightLock);
         InFlightRequestMap& inflightMap = states.inflightMap;
         idx = inflightMap.indexOfKey(msg.frame_number);
         if (idx >= 0) {
@@ -1068,6 +1182,10 @@ void notifyShutter(CaptureOutputStates& states, const camera_shutter_msg_t &msg)
             }
 
             r.shutterTimestamp = msg.timestamp;
+            if (r.requestTimeNs > 0) {
+                states.sessionStatsBuilder.addStageLatency(CaptureStage::SHUTTER,
+                        systemTime() - r.requestTimeNs);
+            }
             if (msg.readout_timestamp_valid) {
                 r.resultExtras.hasReadoutTimestamp = true;
                 r.resultExtras.readoutTimestamp = msg.readout_timestamp;
@@ -1100,14 +1218,16 @@ void notifyShutter(CaptureOutputStates& states, const camera_shutter_msg_t &msg)
                     }
                 }
                 // send pending result and buffers; this queues them up for delivery later
+                const camera_metadata_t *pendingMetadata = r.pendingMetadata.getAndLock();
                 const auto& cameraIdsWithZoom = getCameraIdsWithZoomLocked(
-                        inflightMap, r.pendingMetadata, r.cameraIdsWithZoom);
+                        inflightMap, pendingMetadata, r.cameraIdsWithZoom);
                 sendCaptureResult(states,
-                    r.pendingMetadata, r.resultExtras,
+                    pendingMetadata, r.resultExtras,
                     r.collectedPartialResult, msg.frame_number,
                     r.hasInputBuffer, r.zslCapture && r.stillCapture,
                     r.rotateAndCropAuto, cameraIdsWithZoom, r.useZoomRatio,
                     r.physicalMetadatas);
+                r.pendingMetadata.unlock(pendingMetadata);
             }
             collectAndRemovePendingOutputBuffers(
                     states.useHalBufManager, states.halBufManagedStreamIds,
@@ -1186,7 +1306,7 @@ void notifyError(CaptureOutputStates& states, const camera_error_msg_t &msg) {
         {
             std::vector<BufferToReturn> returnableBuffers{};
             {
-                std::lock_guard<std::mutex> l(states.inflightLock);
+                std::lock_guard<InstrumentedMutex> l(states.inflightLock);
                 ssize_t idx = states.inflightMap.indexOfKey(msg.frame_number);
                 if (idx >= 0) {
                     InFlightRequest &r = states.inflightMap.editValueAt(idx);
@@ -1281,9 +1401,9 @@ void flushInflightRequests(FlushInflightReqStates& states) {
     ATRACE_CALL();
     std::vector<BufferToReturn> returnableBuffers{};
     { // First return buffers cached in inFlightMap
-        std::lock_guard<std::mutex> l(states.inflightLock);
-        for (size_t idx = 0; idx < states.inflightMap.size(); idx++) {
-            const InFlightRequest &request = states.inflightMap.valueAt(idx);
+        std::lock_guard<InstrumentedMutex> l(states.inflightLock);
+        for (const auto& entry : states.inflightMap) {
+            const InFlightRequest &request = entry.value;
             collectReturnableOutputBuffers(
                 states.useHalBufManager, states.halBufManagedStreamIds,
                 states.listener,
@@ -1299,7 +1419,7 @@ void flushInflightRequests(FlushInflightReqStates& states) {
             }
             ALOGW("%s: Frame %d |  Timestamp: %" PRId64 ", metadata"
                     " arrived: %s, buffers left: %d.\n", __FUNCTION__,
-                    states.inflightMap.keyAt(idx), request.shutterTimestamp,
+                    entry.frameNumber, request.shutterTimestamp,
                     request.haveResultMetadata ? "true" : "false",
                     request.numBuffersLeft);
         }
@@ -17,8 +17,10 @@
 #ifndef ANDROID_SERVERS_CAMERA3_OUTPUT_UTILS_H
 #define ANDROID_SERVERS_CAMERA3_OUTPUT_UTILS_H
 
+#include <atomic>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 #include <cutils/native_handle.h>
 
@@ -33,6 +35,7 @@
 #include "device3/InFlightRequest.h"
 #include "device3/Camera3Stream.h"
 #include "device3/Camera3OutputStreamInterface.h"
+#include "utils/InstrumentedMutex.h"
 #include "utils/SessionStatsBuilder.h"
 #include "utils/TagMonitor.h"
 
@@ -114,11 +117,50 @@ namespace camera3 {
     void finishReturningOutputBuffers(const std::vector<BufferToReturn> &returnableBuffers,
             sp<NotificationListener> listener, SessionStatsBuilder& sessionStatsBuilder);
 
+    // Assembles the result metadata of each capture from the final HAL result and the
+    // collected partial results with a single allocation, merging the entries in tag order.
+    // The allocation is sized from the previous results so that the fixups and the mappers
+    // applied afterwards update the result in place.
+    //
+    // Called with outputLock held. The counters may be read by any thread for dumpsys.
+    class ResultMetadataAssembler {
+      public:
+        // Returns the sorted union of result and partials, the entries of result first
+        // for duplicate tags.
+        CameraMetadata assemble(const camera_metadata_t* result,
+                const camera_metadata_t* partials);
+
+        // Accounts for a copy of HAL or result metadata made outside of assemble().
+        void countCopy(const camera_metadata_t* metadata);
+        void countCopy(const CameraMetadata& metadata);
+
+        // Accounts for the final result metadata, assembled at "assembled", before it is
+        // queued.
+        void finish(const CameraMetadata& metadata, const camera_metadata_t* assembled);
+
+        void dump(int fd) const;
+
+      private:
+        struct Entry {
+            uint32_t tag;
+            uint32_t source;  // 0 for result, 1 for partials
+            size_t index;
+        };
+        std::vector<Entry> mEntries;  // scratch space for the merge
+        size_t mLastEntryCount = 0;
+        size_t mLastDataCount = 0;
+
+        std::atomic<int64_t> mResults{0};
+        std::atomic<int64_t> mAllocations{0};
+        std::atomic<int64_t> mCopies{0};
+        std::atomic<int64_t> mBytesCopied{0};
+    };
+
     // Camera3Device/Camera3OfflineSession internal states used in notify/processCaptureResult
     // callbacks
     struct CaptureOutputStates {
         const std::string& cameraId;
-        std::mutex& inflightLock;
+        InstrumentedMutex& inflightLock;
         int64_t& lastCompletedRegularFrameNumber;
         int64_t& lastCompletedReprocessFrameNumber;
         int64_t& lastCompletedZslFrameNumber;
@@ -156,6 +198,7 @@ namespace camera3 {
         bool& isFixedFps;
         int rotationOverride;
         std::string &activePhysicalId;
+        ResultMetadataAssembler& resultMetadataAssembler;
     };
 
     void processCaptureResult(CaptureOutputStates& states, const camera_capture_result *result);
@@ -184,7 +227,7 @@ namespace camera3 {
 
     struct FlushInflightReqStates {
         const std::string& cameraId;
-        std::mutex& inflightLock;
+        InstrumentedMutex& inflightLock;
         InFlightRequestMap& inflightMap; // end of inflightLock scope
         const bool useHalBufManager;
         const std::set<int32_t > &halBufManagedStreamIds;
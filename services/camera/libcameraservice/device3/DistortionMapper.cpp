@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
 
 #include "device3/DistortionMapper.h"
 #include "utils/SessionConfigurationUtilsHost.h"
@@ -141,22 +142,11 @@ status_t DistortionMapper::correctCaptureRequest(CameraMetadata *request) {
     camera_metadata_entry_t e;
     e = request->find(ANDROID_DISTORTION_CORRECTION_MODE);
     if (e.count != 0 && e.data.u8[0] != ANDROID_DISTORTION_CORRECTION_MODE_OFF) {
-        for (auto region : kMeteringRegionsToCorrect) {
-            e = request->find(region);
-            for (size_t j = 0; j < e.count; j += 5) {
-                int32_t weight = e.data.i32[j + 4];
-                if (weight == 0) {
-                    continue;
-                }
-                res = mapCorrectedToRaw(e.data.i32 + j, 2, mapperInfo, /*clamp*/true);
-                if (res != OK) return res;
-            }
-        }
-        for (auto rect : kRectsToCorrect) {
-            e = request->find(rect);
-            res = mapCorrectedRectToRaw(e.data.i32, e.count / 4, mapperInfo, /*clamp*/true);
-            if (res != OK) return res;
-        }
+        gatherCornersLocked(request);
+        res = mapCorrectedToRawBatch(mBatchCoords.data(), mBatchCoords.size() / 2, mapperInfo,
+                /*clamp*/true);
+        if (res != OK) return res;
+        scatterCornersLocked(request);
     }
     return OK;
 }
@@ -180,25 +170,14 @@ status_t DistortionMapper::correctCaptureResult(CameraMetadata *result) {
     camera_metadata_entry_t e;
     e = result->find(ANDROID_DISTORTION_CORRECTION_MODE);
     if (e.count != 0 && e.data.u8[0] != ANDROID_DISTORTION_CORRECTION_MODE_OFF) {
-        for (auto region : kMeteringRegionsToCorrect) {
-            e = result->find(region);
-            for (size_t j = 0; j < e.count; j += 5) {
-                int32_t weight = e.data.i32[j + 4];
-                if (weight == 0) {
-                    continue;
-                }
-                res = mapRawToCorrected(e.data.i32 + j, 2, mapperInfo, /*clamp*/true);
-                if (res != OK) return res;
-            }
-        }
-        for (auto rect : kRectsToCorrect) {
-            e = result->find(rect);
-            res = mapRawRectToCorrected(e.data.i32, e.count / 4, mapperInfo, /*clamp*/true);
-            if (res != OK) return res;
-        }
+        gatherCornersLocked(result);
+        res = mapRawToCorrectedBatch(mBatchCoords.data(), mBatchCoords.size() / 2, mapperInfo,
+                /*clamp*/true);
+        if (res != OK) return res;
+        scatterCornersLocked(result);
         for (auto pts : kResultPointsToCorrectNoClamp) {
             e = result->find(pts);
-            res = mapRawToCorrected(e.data.i32, e.count / 2, mapperInfo, /*clamp*/false);
+            res = mapRawToCorrectedBatch(e.data.i32, e.count / 2, mapperInfo, /*clamp*/false);
             if (res != OK) return res;
         }
     }
@@ -206,6 +185,57 @@ status_t DistortionMapper::correctCaptureResult(CameraMetadata *result) {
     return OK;
 }
 
+void DistortionMapper::gatherCornersLocked(CameraMetadata *metadata) {
+    mBatchCoords.clear();
+    camera_metadata_entry_t e;
+    for (auto region : kMeteringRegionsToCorrect) {
+        e = metadata->find(region);
+        for (size_t j = 0; j < e.count; j += 5) {
+            int32_t weight = e.data.i32[j + 4];
+            if (weight == 0) {
+                continue;
+            }
+            mBatchCoords.insert(mBatchCoords.end(), e.data.i32 + j, e.data.i32 + j + 4);
+        }
+    }
+    for (auto rect : kRectsToCorrect) {
+        e = metadata->find(rect);
+        for (size_t j = 0; j + 4 <= e.count; j += 4) {
+            // Map from (l, t, width, height) to (l, t, r, b)
+            mBatchCoords.push_back(e.data.i32[j]);
+            mBatchCoords.push_back(e.data.i32[j + 1]);
+            mBatchCoords.push_back(e.data.i32[j] + e.data.i32[j + 2] - 1);
+            mBatchCoords.push_back(e.data.i32[j + 1] + e.data.i32[j + 3] - 1);
+        }
+    }
+}
+
+void DistortionMapper::scatterCornersLocked(CameraMetadata *metadata) {
+    const int32_t *coords = mBatchCoords.data();
+    camera_metadata_entry_t e;
+    for (auto region : kMeteringRegionsToCorrect) {
+        e = metadata->find(region);
+        for (size_t j = 0; j < e.count; j += 5) {
+            int32_t weight = e.data.i32[j + 4];
+            if (weight == 0) {
+                continue;
+            }
+            std::copy(coords, coords + 4, e.data.i32 + j);
+            coords += 4;
+        }
+    }
+    for (auto rect : kRectsToCorrect) {
+        e = metadata->find(rect);
+        for (size_t j = 0; j + 4 <= e.count; j += 4, coords += 4) {
+            // Map back to (l, t, width, height)
+            e.data.i32[j] = coords[0];
+            e.data.i32[j + 1] = coords[1];
+            e.data.i32[j + 2] = coords[2] - coords[0] + 1;
+            e.data.i32[j + 3] = coords[3] - coords[1] + 1;
+        }
+    }
+}
+
 // Utility methods; not guarded by mutex
 
 status_t DistortionMapper::updateCalibration(const CameraMetadata &result, bool isStatic,
@@ -262,6 +292,7 @@ status_t DistortionMapper::updateCalibration(const CameraMetadata &result, bool
     mapperInfo->mValidMapping = true;
     // Need to recalculate grid
     mapperInfo->mValidGrids = false;
+    mCalibrationGeneration.fetch_add(1, std::memory_order_release);
 
     return OK;
 }
@@ -278,7 +309,7 @@ status_t DistortionMapper::mapRawToCorrected(int32_t *coordPairs, int coordCount
     }
 
     for (int i = 0; i < coordCount * 2; i += 2) {
-        const GridQuad *quad = findEnclosingQuad(coordPairs + i, mapperInfo->mDistortedGrid);
+        const GridQuad *quad = findEnclosingDistortedQuad(coordPairs + i, mapperInfo);
         if (quad == nullptr) {
             ALOGE("Raw to corrected mapping failure: No quad found for (%d, %d)",
                     *(coordPairs + i), *(coordPairs + i + 1));
@@ -458,6 +489,98 @@ status_t DistortionMapper::mapCorrectedRectToRaw(int32_t *rects, int rectCount,
     return OK;
 }
 
+status_t DistortionMapper::mapCorrectedToRawBatch(int32_t *coordPairs, int coordCount,
+        const DistortionMapperInfo *mapperInfo, bool clamp, bool simple) const {
+    if (!mapperInfo->mValidMapping) return INVALID_OPERATION;
+
+    const float scaleX = mapperInfo->mArrayWidth / mapperInfo->mActiveWidth;
+    const float scaleY = mapperInfo->mArrayHeight / mapperInfo->mActiveHeight;
+    const float activeCx = mapperInfo->mCx - mapperInfo->mArrayDiffX;
+    const float activeCy = mapperInfo->mCy - mapperInfo->mArrayDiffY;
+    const float fx = mapperInfo->mFx, fy = mapperInfo->mFy;
+    const float cx = mapperInfo->mCx, cy = mapperInfo->mCy, s = mapperInfo->mS;
+    const float invFx = mapperInfo->mInvFx, invFy = mapperInfo->mInvFy;
+    const float k0 = mapperInfo->mK[0], k1 = mapperInfo->mK[1], k2 = mapperInfo->mK[2];
+    const float k3 = mapperInfo->mK[3], k4 = mapperInfo->mK[4];
+    const float maxX = mapperInfo->mArrayWidth - 1;
+    const float maxY = mapperInfo->mArrayHeight - 1;
+
+    float xs[kBatchSize];
+    float ys[kBatchSize];
+    for (int start = 0; start < coordCount; start += kBatchSize) {
+        const int count = std::min(kBatchSize, coordCount - start);
+        int32_t *block = coordPairs + start * 2;
+        for (int i = 0; i < count; i++) {
+            xs[i] = block[i * 2];
+            ys[i] = block[i * 2 + 1];
+        }
+        if (simple) {
+            for (int i = 0; i < count; i++) {
+                xs[i] *= scaleX;
+                ys[i] *= scaleY;
+            }
+        } else {
+            // Same math as mapCorrectedToRawImpl
+            for (int i = 0; i < count; i++) {
+                const float ywi = (ys[i] - activeCy) * invFy;
+                const float xwi = (xs[i] - activeCx - s * ywi) * invFx;
+                const float rSq = xwi * xwi + ywi * ywi;
+                const float Fr = 1.f + (k0 * rSq) + (k1 * rSq * rSq) + (k2 * rSq * rSq * rSq);
+                const float xc = xwi * Fr + (k3 * 2 * xwi * ywi) + k4 * (rSq + 2 * xwi * xwi);
+                const float yc = ywi * Fr + (k4 * 2 * xwi * ywi) + k3 * (rSq + 2 * ywi * ywi);
+                xs[i] = fx * xc + s * yc + cx;
+                ys[i] = fy * yc + cy;
+            }
+        }
+        if (clamp) {
+            for (int i = 0; i < count; i++) {
+                xs[i] = std::min(maxX, std::max(0.f, xs[i]));
+                ys[i] = std::min(maxY, std::max(0.f, ys[i]));
+            }
+        }
+        for (int i = 0; i < count; i++) {
+            block[i * 2] = static_cast<int32_t>(std::round(xs[i]));
+            block[i * 2 + 1] = static_cast<int32_t>(std::round(ys[i]));
+        }
+    }
+    return OK;
+}
+
+status_t DistortionMapper::mapRawToCorrectedBatch(int32_t *coordPairs, int coordCount,
+        DistortionMapperInfo *mapperInfo, bool clamp, bool simple) {
+    if (!mapperInfo->mValidMapping) return INVALID_OPERATION;
+
+    // The complex correction is a search per point, which the inverse lookup grid bounds
+    if (!simple) return mapRawToCorrected(coordPairs, coordCount, mapperInfo, clamp, simple);
+
+    const float scaleX = mapperInfo->mActiveWidth / mapperInfo->mArrayWidth;
+    const float scaleY = mapperInfo->mActiveHeight / mapperInfo->mArrayHeight;
+    const float maxX = mapperInfo->mActiveWidth - 1;
+    const float maxY = mapperInfo->mActiveHeight - 1;
+
+    float xs[kBatchSize];
+    float ys[kBatchSize];
+    for (int start = 0; start < coordCount; start += kBatchSize) {
+        const int count = std::min(kBatchSize, coordCount - start);
+        int32_t *block = coordPairs + start * 2;
+        for (int i = 0; i < count; i++) {
+            xs[i] = block[i * 2] * scaleX;
+            ys[i] = block[i * 2 + 1] * scaleY;
+        }
+        if (clamp) {
+            for (int i = 0; i < count; i++) {
+                xs[i] = std::min(maxX, std::max(0.f, xs[i]));
+                ys[i] = std::min(maxY, std::max(0.f, ys[i]));
+            }
+        }
+        for (int i = 0; i < count; i++) {
+            block[i * 2] = static_cast<int32_t>(std::round(xs[i]));
+            block[i * 2 + 1] = static_cast<int32_t>(std::round(ys[i]));
+        }
+    }
+    return OK;
+}
+
 status_t DistortionMapper::buildGrids(DistortionMapperInfo *mapperInfo) {
     if (mapperInfo->mCorrectedGrid.size() != kGridSize * kGridSize) {
         mapperInfo->mCorrectedGrid.resize(kGridSize * kGridSize);
@@ -488,47 +611,120 @@ status_t DistortionMapper::buildGrids(DistortionMapperInfo *mapperInfo) {
         }
     }
 
+    // Reset the inverse lookup grid to cover the distorted grid; its cells are built on demand
+    mapperInfo->mDistortedQuadBounds.resize(kGridSize * kGridSize);
+    float minX = std::numeric_limits<float>::max(), minY = std::numeric_limits<float>::max();
+    float maxX = std::numeric_limits<float>::lowest(), maxY = std::numeric_limits<float>::lowest();
+    for (size_t i = 0; i < mapperInfo->mDistortedGrid.size(); i++) {
+        const auto &coords = mapperInfo->mDistortedGrid[i].coords;
+        auto &bounds = mapperInfo->mDistortedQuadBounds[i];
+        bounds = {coords[0], coords[1], coords[0], coords[1]};
+        for (size_t j = 2; j < coords.size(); j += 2) {
+            bounds[0] = std::min(bounds[0], coords[j]);
+            bounds[1] = std::min(bounds[1], coords[j + 1]);
+            bounds[2] = std::max(bounds[2], coords[j]);
+            bounds[3] = std::max(bounds[3], coords[j + 1]);
+        }
+        minX = std::min(minX, bounds[0]);
+        minY = std::min(minY, bounds[1]);
+        maxX = std::max(maxX, bounds[2]);
+        maxY = std::max(maxY, bounds[3]);
+    }
+    mapperInfo->mInverseGridX = minX - kInverseGridMargin;
+    mapperInfo->mInverseGridY = minY - kInverseGridMargin;
+    mapperInfo->mInverseCellWidth = (maxX - minX + 2 * kInverseGridMargin) / kInverseGridSize;
+    mapperInfo->mInverseCellHeight = (maxY - minY + 2 * kInverseGridMargin) / kInverseGridSize;
+    mapperInfo->mInverseGrid.assign(kInverseGridSize * kInverseGridSize, {});
+
     mapperInfo->mValidGrids = true;
     return OK;
 }
 
+void DistortionMapper::buildInverseGridCell(DistortionMapperInfo *mapperInfo,
+        size_t cellIndex) {
+    auto &cell = mapperInfo->mInverseGrid[cellIndex];
+    const float cellX = mapperInfo->mInverseGridX +
+            (cellIndex % kInverseGridSize) * mapperInfo->mInverseCellWidth;
+    const float cellY = mapperInfo->mInverseGridY +
+            (cellIndex / kInverseGridSize) * mapperInfo->mInverseCellHeight;
+    const float left = cellX - kInverseGridMargin;
+    const float top = cellY - kInverseGridMargin;
+    const float right = cellX + mapperInfo->mInverseCellWidth + kInverseGridMargin;
+    const float bottom = cellY + mapperInfo->mInverseCellHeight + kInverseGridMargin;
+
+    cell.mQuads.clear();
+    for (size_t i = 0; i < mapperInfo->mDistortedQuadBounds.size(); i++) {
+        const auto &bounds = mapperInfo->mDistortedQuadBounds[i];
+        if (bounds[0] <= right && bounds[2] >= left && bounds[1] <= bottom && bounds[3] >= top) {
+            cell.mQuads.push_back(static_cast<uint16_t>(i));
+        }
+    }
+    cell.mBuilt = true;
+}
+
+const DistortionMapper::GridQuad* DistortionMapper::findEnclosingDistortedQuad(
+        const int32_t pt[2], DistortionMapperInfo *mapperInfo) {
+    // Points outside of the inverse lookup grid are outside all the quads
+    const float cellX = (pt[0] - mapperInfo->mInverseGridX) / mapperInfo->mInverseCellWidth;
+    const float cellY = (pt[1] - mapperInfo->mInverseGridY) / mapperInfo->mInverseCellHeight;
+    if (!(cellX >= 0 && cellX <= kInverseGridSize && cellY >= 0 && cellY <= kInverseGridSize)) {
+        return nullptr;
+    }
+    const size_t col = std::min(static_cast<size_t>(cellX), kInverseGridSize - 1);
+    const size_t row = std::min(static_cast<size_t>(cellY), kInverseGridSize - 1);
+    const size_t cellIndex = row * kInverseGridSize + col;
+    if (!mapperInfo->mInverseGrid[cellIndex].mBuilt) {
+        buildInverseGridCell(mapperInfo, cellIndex);
+    }
+
+    // In grid order, so that points on shared edges get the same quad as findEnclosingQuad
+    for (uint16_t i : mapperInfo->mInverseGrid[cellIndex].mQuads) {
+        const GridQuad &quad = mapperInfo->mDistortedGrid[i];
+        if (quadContains(pt, quad)) return &quad;
+    }
+    return nullptr;
+}
+
 const DistortionMapper::GridQuad* DistortionMapper::findEnclosingQuad(
         const int32_t pt[2], const std::vector<GridQuad>& grid) {
-    const float x = pt[0];
-    const float y = pt[1];
-
     for (const GridQuad& quad : grid) {
-        const float &x1 = quad.coords[0];
-        const float &y1 = quad.coords[1];
-        const float &x2 = quad.coords[2];
-        const float &y2 = quad.coords[3];
-        const float &x3 = quad.coords[4];
-        const float &y3 = quad.coords[5];
-        const float &x4 = quad.coords[6];
-        const float &y4 = quad.coords[7];
-
-        // Point-in-quad test:
-
-        // Quad has corners P1-P4; if P is within the quad, then it is on the same side of all the
-        // edges (or on top of one of the edges or corners), traversed in a consistent direction.
-        // This means that the cross product of edge En = Pn->P(n+1 mod 4) and line Ep = Pn->P must
-        // have the same sign (or be zero) for all edges.
-        // For clockwise traversal, the sign should be negative or zero for Ep x En, indicating that
-        // En is to the left of Ep, or overlapping.
-        float s1 = (x - x1) * (y2 - y1) - (y - y1) * (x2 - x1);
-        if (s1 > 0) continue;
-        float s2 = (x - x2) * (y3 - y2) - (y - y2) * (x3 - x2);
-        if (s2 > 0) continue;
-        float s3 = (x - x3) * (y4 - y3) - (y - y3) * (x4 - x3);
-        if (s3 > 0) continue;
-        float s4 = (x - x4) * (y1 - y4) - (y - y4) * (x1 - x4);
-        if (s4 > 0) continue;
-
-        return &quad;
+        if (quadContains(pt, quad)) return &quad;
     }
     return nullptr;
 }
 
+bool DistortionMapper::quadContains(const int32_t pt[2], const GridQuad& quad) {
+    const float x = pt[0];
+    const float y = pt[1];
+
+    const float &x1 = quad.coords[0];
+    const float &y1 = quad.coords[1];
+    const float &x2 = quad.coords[2];
+    const float &y2 = quad.coords[3];
+    const float &x3 = quad.coords[4];
+    const float &y3 = quad.coords[5];
+    const float &x4 = quad.coords[6];
+    const float &y4 = quad.coords[7];
+
+    // Point-in-quad test:
+
+    // Quad has corners P1-P4; if P is within the quad, then it is on the same side of all the
+    // edges (or on top of one of the edges or corners), traversed in a consistent direction.
+    // This means that the cross product of edge En = Pn->P(n+1 mod 4) and line Ep = Pn->P must
+    // have the same sign (or be zero) for all edges.
+    // For clockwise traversal, the sign should be negative or zero for Ep x En, indicating that
+    // En is to the left of Ep, or overlapping.
+    float s1 = (x - x1) * (y2 - y1) - (y - y1) * (x2 - x1);
+    if (s1 > 0) return false;
+    float s2 = (x - x2) * (y3 - y2) - (y - y2) * (x3 - x2);
+    if (s2 > 0) return false;
+    float s3 = (x - x3) * (y4 - y3) - (y - y3) * (x4 - x3);
+    if (s3 > 0) return false;
+    float s4 = (x - x4) * (y1 - y4) - (y - y4) * (x1 - x4);
+    if (s4 > 0) return false;
+    return true;
+}
+
 float DistortionMapper::calculateUorV(const int32_t pt[2], const GridQuad& quad, bool calculateU) {
     const float x = pt[0];
     const float y = pt[1];
@@ -19,7 +19,9 @@
 
 #include <utils/Errors.h>
 #include <array>
+#include <atomic>
 #include <mutex>
+#include <vector>
 
 #include "camera/CameraMetadata.h"
 #include "device3/CoordinateMapper.h"
@@ -58,6 +60,14 @@ class DistortionMapper : public CoordinateMapper {
      */
     bool calibrationValid() const;
 
+    /**
+     * Incremented whenever the lens calibration changes, so that corrected capture requests
+     * can be reused until then
+     */
+    uint32_t calibrationGeneration() const {
+        return mCalibrationGeneration.load(std::memory_order_acquire);
+    }
+
     /**
      * Correct capture request if distortion correction is enabled
      */
@@ -127,6 +137,16 @@ class DistortionMapper : public CoordinateMapper {
     status_t mapCorrectedRectToRaw(int32_t *rects, int rectCount,
            const DistortionMapperInfo *mapperInfo, bool clamp, bool simple = true) const;
 
+    /**
+     * Batched versions of mapCorrectedToRaw and mapRawToCorrected, for all the coordinates of a
+     * capture request or result at once. The coordinates are processed in blocks, de-interleaved
+     * so that the per-coordinate math vectorizes. Results match the unbatched versions.
+     */
+    status_t mapCorrectedToRawBatch(int32_t *coordPairs, int coordCount,
+            const DistortionMapperInfo *mapperInfo, bool clamp, bool simple = true) const;
+    status_t mapRawToCorrectedBatch(int32_t *coordPairs, int coordCount,
+            DistortionMapperInfo *mapperInfo, bool clamp, bool simple = true);
+
     struct GridQuad {
         // Source grid quad, or null
         const GridQuad *src;
@@ -155,12 +175,30 @@ class DistortionMapper : public CoordinateMapper {
 
         std::vector<GridQuad> mCorrectedGrid;
         std::vector<GridQuad> mDistortedGrid;
+
+        // Inverse lookup grid over the bounds of the distorted grid: each cell lists, in grid
+        // order, the distorted quads which may enclose a point within it. Cells are filled in
+        // the first time a point falls within them, and reset when the grids are rebuilt.
+        struct InverseGridCell {
+            bool mBuilt = false;
+            std::vector<uint16_t> mQuads;
+        };
+        std::vector<InverseGridCell> mInverseGrid;
+        // Bounding boxes (min x, min y, max x, max y) of the distorted quads
+        std::vector<std::array<float, 4>> mDistortedQuadBounds;
+        float mInverseGridX, mInverseGridY;
+        float mInverseCellWidth, mInverseCellHeight;
     };
 
     // Find which grid quad encloses the point; returns null if none do
     static const GridQuad* findEnclosingQuad(
             const int32_t pt[2], const std::vector<GridQuad>& grid);
 
+    // Same as findEnclosingQuad on the distorted grid, searching only the quads listed by the
+    // inverse lookup grid
+    static const GridQuad* findEnclosingDistortedQuad(
+            const int32_t pt[2], DistortionMapperInfo *mapperInfo);
+
     // Calculate 'horizontal' interpolation coordinate for the point and the quad
     // Assumes the point P is within the quad Q.
     // Given quad with points P1-P4, and edges E12-E41, and considering the edge segments as
@@ -188,8 +226,15 @@ class DistortionMapper : public CoordinateMapper {
     constexpr static float kGridMargin = 0.05f;
     // Fuzziness for float inequality tests
     constexpr static float kFloatFuzz = 1e-4;
+    // Number of cells in each dimension of the inverse lookup grid
+    constexpr static size_t kInverseGridSize = 2 * kGridSize;
+    // Margin, in pixels, by which inverse lookup grid cells are expanded to absorb rounding
+    constexpr static float kInverseGridMargin = 1.f;
+    // Number of coordinates processed at once by the batched mapping methods
+    constexpr static int kBatchSize = 32;
 
     bool mMaxResolution = false;
+    std::atomic<uint32_t> mCalibrationGeneration{0};
 
     status_t setupStaticInfoLocked(const CameraMetadata &deviceInfo, bool maxResolution);
 
@@ -209,6 +254,20 @@ class DistortionMapper : public CoordinateMapper {
     // Utility to create reverse mapping grids
     status_t buildGrids(DistortionMapperInfo *mapperInfo);
 
+    // List the distorted quads overlapping a cell of the inverse lookup grid
+    static void buildInverseGridCell(DistortionMapperInfo *mapperInfo, size_t cellIndex);
+
+    // Point-in-quad test used by the enclosing quad searches
+    static bool quadContains(const int32_t pt[2], const GridQuad& quad);
+
+    // Gather the corners of the weighted metering regions and of the rectangles of the
+    // metadata into mBatchCoords, and write them back once mapped
+    void gatherCornersLocked(CameraMetadata *metadata);
+    void scatterCornersLocked(CameraMetadata *metadata);
+
+    // Scratch space for the corners of a request or result; guarded by mMutex
+    std::vector<int32_t> mBatchCoords;
+
     DistortionMapperInfo mDistortionMapperInfo;
     DistortionMapperInfo mDistortionMapperInfoMaximumResolution;
 
@@ -0,0 +1,254 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SERVERS_CAMERA3_FRAME_NUMBER_MAP_H
+#define ANDROID_SERVERS_CAMERA3_FRAME_NUMBER_MAP_H
+
+#include <sys/types.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <utils/Errors.h>
+#include <utils/Log.h>
+
+namespace android {
+
+namespace camera3 {
+
+/**
+ * Map from frame number to the state of an in-flight frame, as a ring of slots indexed by frame
+ * number.
+ *
+ * Frame numbers in flight are close to each other, so adding, finding and removing an entry are
+ * O(1), and entries never move once added, unlike in a sorted vector where completing the
+ * oldest frame shifts every other one. The ring grows when the oldest and newest frame numbers
+ * in flight are further apart than its capacity. Iteration is in increasing frame number order.
+ *
+ * The index based methods follow KeyedVector. An index is the slot of an entry: it stays valid
+ * until that entry is removed, or until another entry is added.
+ *
+ * Not thread safe.
+ */
+template <typename V>
+class FrameNumberMap {
+  public:
+    static constexpr size_t kDefaultCapacity = 64;
+
+    struct Entry {
+        const uint32_t frameNumber;
+        V value;
+    };
+
+    explicit FrameNumberMap(size_t capacity = kDefaultCapacity) {
+        size_t slots = 1;
+        while (slots < capacity) slots <<= 1;
+        mSlots.resize(slots);
+    }
+
+    FrameNumberMap(const FrameNumberMap& other) : FrameNumberMap(other.mSlots.size()) {
+        for (const auto& entry : other) {
+            add(entry.frameNumber, entry.value);
+        }
+    }
+
+    FrameNumberMap& operator=(const FrameNumberMap& other) {
+        if (this != &other) {
+            FrameNumberMap copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+
+    size_t size() const { return mCount; }
+    bool isEmpty() const { return mCount == 0; }
+    size_t capacity() const { return mSlots.size(); }
+
+    /**
+     * Add an entry, replacing any existing one for the same frame number. Returns its index.
+     */
+    ssize_t add(uint32_t frameNumber, const V& value) {
+        return emplace(frameNumber, value);
+    }
+
+    ssize_t add(uint32_t frameNumber, V&& value) {
+        return emplace(frameNumber, std::move(value));
+    }
+
+    // Returns NAME_NOT_FOUND if the frame number isn't in the map
+    ssize_t indexOfKey(uint32_t frameNumber) const {
+        size_t index = frameNumber & mask();
+        const auto& slot = mSlots[index];
+        if (slot == nullptr || slot->frameNumber != frameNumber) {
+            return NAME_NOT_FOUND;
+        }
+        return index;
+    }
+
+    uint32_t keyAt(size_t index) const { return mSlots[index]->frameNumber; }
+    const V& valueAt(size_t index) const { return mSlots[index]->value; }
+    V& editValueAt(size_t index) { return mSlots[index]->value; }
+
+    // The frame number must be in the map
+    const V& valueFor(uint32_t frameNumber) const {
+        ssize_t index = indexOfKey(frameNumber);
+        LOG_ALWAYS_FATAL_IF(index < 0, "%s: frame %u not found", __FUNCTION__, frameNumber);
+        return valueAt(index);
+    }
+
+    void removeItemAt(size_t index) {
+        uint32_t frameNumber = mSlots[index]->frameNumber;
+        mSlots[index].reset();
+        mCount--;
+        if (mCount == 0) {
+            return;
+        }
+        // Move the bounds to the closest remaining entries
+        if (frameNumber == mOldest) {
+            while (mSlots[mOldest & mask()] == nullptr) mOldest++;
+        } else if (frameNumber == mNewest) {
+            while (mSlots[mNewest & mask()] == nullptr) mNewest--;
+        }
+    }
+
+    // Returns NAME_NOT_FOUND if the frame number isn't in the map
+    ssize_t removeItem(uint32_t frameNumber) {
+        ssize_t index = indexOfKey(frameNumber);
+        if (index >= 0) {
+            removeItemAt(index);
+        }
+        return index;
+    }
+
+    void clear() {
+        for (auto& slot : mSlots) {
+            slot.reset();
+        }
+        mCount = 0;
+    }
+
+    void swap(FrameNumberMap& other) {
+        std::swap(mSlots, other.mSlots);
+        std::swap(mCount, other.mCount);
+        std::swap(mOldest, other.mOldest);
+        std::swap(mNewest, other.mNewest);
+    }
+
+    template <typename MapT, typename EntryT>
+    class Iterator {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Entry;
+        using difference_type = std::ptrdiff_t;
+        using pointer = EntryT*;
+        using reference = EntryT&;
+
+        Iterator(MapT* map, uint32_t frameNumber, size_t remaining) :
+                mMap(map), mFrameNumber(frameNumber), mRemaining(remaining) {
+            skipEmpty();
+        }
+
+        reference operator*() const { return *mMap->mSlots[mFrameNumber & mMap->mask()]; }
+        pointer operator->() const { return &**this; }
+
+        Iterator& operator++() {
+            mRemaining--;
+            mFrameNumber++;
+            skipEmpty();
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const { return mRemaining == other.mRemaining; }
+        bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+      private:
+        void skipEmpty() {
+            if (mRemaining == 0) return;
+            while (mMap->mSlots[mFrameNumber & mMap->mask()] == nullptr) mFrameNumber++;
+        }
+
+        MapT* mMap;
+        uint32_t mFrameNumber;
+        // Entries left to visit, including the current one
+        size_t mRemaining;
+    };
+    using iterator = Iterator<FrameNumberMap, Entry>;
+    using const_iterator = Iterator<const FrameNumberMap, const Entry>;
+
+    iterator begin() { return iterator(this, mOldest, mCount); }
+    iterator end() { return iterator(this, mOldest, 0); }
+    const_iterator begin() const { return const_iterator(this, mOldest, mCount); }
+    const_iterator end() const { return const_iterator(this, mOldest, 0); }
+
+  private:
+    size_t mask() const { return mSlots.size() - 1; }
+
+    template <typename T>
+    ssize_t emplace(uint32_t frameNumber, T&& value) {
+        if (mCount == 0) {
+            mOldest = mNewest = frameNumber;
+        } else {
+            ssize_t index = indexOfKey(frameNumber);
+            if (index >= 0) {
+                mSlots[index]->value = std::forward<T>(value);
+                return index;
+            }
+            uint32_t oldest = std::min(mOldest, frameNumber);
+            uint32_t newest = std::max(mNewest, frameNumber);
+            if (newest - oldest >= mSlots.size()) {
+                grow(static_cast<size_t>(newest - oldest) + 1);
+            }
+            mOldest = oldest;
+            mNewest = newest;
+        }
+
+        size_t index = frameNumber & mask();
+        mSlots[index].reset(new Entry{frameNumber, std::forward<T>(value)});
+        mCount++;
+        return index;
+    }
+
+    void grow(size_t span) {
+        size_t slots = mSlots.size();
+        while (slots < span) slots <<= 1;
+        ALOGV("%s: frames in flight span %zu, growing from %zu to %zu slots", __FUNCTION__,
+                span, mSlots.size(), slots);
+        std::vector<std::unique_ptr<Entry>> grown(slots);
+        for (auto& slot : mSlots) {
+            if (slot != nullptr) {
+                size_t index = slot->frameNumber & (slots - 1);
+                grown[index] = std::move(slot);
+            }
+        }
+        mSlots = std::move(grown);
+    }
+
+    std::vector<std::unique_ptr<Entry>> mSlots;
+    size_t mCount = 0;
+    // Oldest and newest frame numbers in the map, when not empty
+    uint32_t mOldest = 0;
+    uint32_t mNewest = 0;
+}; // class FrameNumberMap
+
+} // namespace camera3
+
+} // namespace android
+
+#endif
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "Camera3-RequestMetadataMappers"
+#define ATRACE_TAG ATRACE_TAG_CAMERA
+//#define LOG_NDEBUG 0
+
+#include <string.h>
+
+#include <utils/Log.h>
+#include <utils/Trace.h>
+
+#include "device3/RequestMetadataMappers.h"
+
+namespace android {
+
+namespace camera3 {
+
+void RequestMetadataMappers::compose(
+        std::unordered_map<std::string, UHRCropAndMeteringRegionMapper>& uhrMappers,
+        std::unordered_map<std::string, DistortionMapper>& distortionMappers,
+        std::unordered_map<std::string, ZoomRatioMapper>& zoomRatioMappers,
+        std::unordered_map<std::string, RotateAndCropMapper>& rotateAndCropMappers) {
+    mChains.clear();
+    for (auto& [cameraId, mapper] : uhrMappers) {
+        mChains[cameraId].uhrCropAndMeteringRegions = &mapper;
+    }
+    for (auto& [cameraId, mapper] : distortionMappers) {
+        mChains[cameraId].distortion = &mapper;
+    }
+    for (auto& [cameraId, mapper] : zoomRatioMappers) {
+        mChains[cameraId].zoomRatio = &mapper;
+    }
+    for (auto& [cameraId, mapper] : rotateAndCropMappers) {
+        mChains[cameraId].rotateAndCrop = &mapper;
+    }
+}
+
+RequestMetadataMappers::Chain* RequestMetadataMappers::find(const std::string& cameraId) {
+    auto it = mChains.find(cameraId);
+    return it != mChains.end() ? &it->second : nullptr;
+}
+
+status_t RequestMetadataMappers::apply(Chain& chain, uint32_t mappers, CameraMetadata* settings,
+        uint32_t* applied, Mapper* failed) {
+    *applied = 0;
+    mappers &= availableMappers(chain);
+    if (mappers == 0) return OK;
+
+    // Read before mapping: a calibration update during the mapping invalidates the result.
+    const uint32_t calibrationGeneration =
+            chain.distortion != nullptr ? chain.distortion->calibrationGeneration() : 0;
+    auto& cache = chain.cache;
+    if (cache.valid && cache.mappers == mappers
+            && cache.calibrationGeneration == calibrationGeneration
+            && sameSettings(cache.settings, *settings)) {
+        *settings = cache.mapped;
+        *applied = mappers;
+        mCacheHits++;
+        return OK;
+    }
+    mCacheMisses++;
+    cache.valid = false;
+    CameraMetadata original(*settings);
+
+    ATRACE_CALL();
+    status_t res;
+    if (mappers & UHR_CROP_AND_METERING_REGIONS) {
+        res = chain.uhrCropAndMeteringRegions->updateCaptureRequest(settings);
+        if (res != OK) {
+            *failed = UHR_CROP_AND_METERING_REGIONS;
+            return res;
+        }
+        *applied |= UHR_CROP_AND_METERING_REGIONS;
+    }
+    if (mappers & DISTORTION_CORRECTION) {
+        res = chain.distortion->correctCaptureRequest(settings);
+        if (res != OK) {
+            *failed = DISTORTION_CORRECTION;
+            return res;
+        }
+        *applied |= DISTORTION_CORRECTION;
+    }
+    if (mappers & ZOOM_RATIO) {
+        res = chain.zoomRatio->updateCaptureRequest(settings);
+        if (res != OK) {
+            *failed = ZOOM_RATIO;
+            return res;
+        }
+        *applied |= ZOOM_RATIO;
+    }
+    if (mappers & ROTATE_AND_CROP) {
+        res = chain.rotateAndCrop->updateCaptureRequest(settings);
+        if (res != OK) {
+            *failed = ROTATE_AND_CROP;
+            return res;
+        }
+        *applied |= ROTATE_AND_CROP;
+    }
+
+    cache.settings = std::move(original);
+    cache.mapped = *settings;
+    cache.mappers = mappers;
+    cache.calibrationGeneration = calibrationGeneration;
+    cache.valid = true;
+    return OK;
+}
+
+const char* RequestMetadataMappers::mapperName(Mapper mapper) {
+    switch (mapper) {
+        case UHR_CROP_AND_METERING_REGIONS:
+            return "scaler crop region and metering regions";
+        case DISTORTION_CORRECTION:
+            return "lens distortion";
+        case ZOOM_RATIO:
+            return "zoom ratio";
+        case ROTATE_AND_CROP:
+            return "rotate-and-crop";
+    }
+    return "unknown";
+}
+
+uint32_t RequestMetadataMappers::availableMappers(const Chain& chain) {
+    uint32_t mappers = 0;
+    if (chain.uhrCropAndMeteringRegions != nullptr) mappers |= UHR_CROP_AND_METERING_REGIONS;
+    if (chain.distortion != nullptr) mappers |= DISTORTION_CORRECTION;
+    if (chain.zoomRatio != nullptr) mappers |= ZOOM_RATIO;
+    if (chain.rotateAndCrop != nullptr) mappers |= ROTATE_AND_CROP;
+    return mappers;
+}
+
+// Same entries in the same order. Settings built differently may compare unequal, which only
+// costs a cache miss.
+bool RequestMetadataMappers::sameSettings(const CameraMetadata& a, const CameraMetadata& b) {
+    if (a.entryCount() != b.entryCount()) return false;
+    const camera_metadata_t* bufferA = a.getAndLock();
+    const camera_metadata_t* bufferB = b.getAndLock();
+    bool same = true;
+    const size_t count = a.entryCount();
+    for (size_t i = 0; i < count && same; i++) {
+        camera_metadata_ro_entry_t entryA, entryB;
+        if (get_camera_metadata_ro_entry(bufferA, i, &entryA) != OK ||
+                get_camera_metadata_ro_entry(bufferB, i, &entryB) != OK) {
+            same = false;
+            break;
+        }
+        same = entryA.tag == entryB.tag && entryA.type == entryB.type &&
+                entryA.count == entryB.count &&
+                memcmp(entryA.data.u8, entryB.data.u8,
+                        entryA.count * camera_metadata_type_size[entryA.type]) == 0;
+    }
+    b.unlock(bufferB);
+    a.unlock(bufferA);
+    return same;
+}
+
+} // namespace camera3
+
+} // namespace android
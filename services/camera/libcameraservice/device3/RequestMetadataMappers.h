@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SERVERS_REQUEST_METADATA_MAPPERS_H
+#define ANDROID_SERVERS_REQUEST_METADATA_MAPPERS_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include <utils/Errors.h>
+
+#include "camera/CameraMetadata.h"
+#include "device3/DistortionMapper.h"
+#include "device3/RotateAndCropMapper.h"
+#include "device3/UHRCropAndMeteringRegionMapper.h"
+#include "device3/ZoomRatioMapper.h"
+
+namespace android {
+
+namespace camera3 {
+
+/**
+ * The coordinate mappers applied to the settings of each camera of a capture request,
+ * composed into a single stage: one lookup by camera id, then UHR crop and metering regions,
+ * distortion correction, zoom ratio and rotate-and-crop in that order.
+ *
+ * The mapped settings of each camera are cached, so that a new request with the same settings
+ * as the previous one, such as a repeating request submitted again, reuses them instead of
+ * mapping them again. The cache is invalidated when the lens calibration changes.
+ *
+ * Not thread safe: used by the request thread only, after compose().
+ */
+class RequestMetadataMappers {
+  public:
+    // Mappers, as bit flags
+    enum Mapper : uint32_t {
+        UHR_CROP_AND_METERING_REGIONS = 1 << 0,
+        DISTORTION_CORRECTION = 1 << 1,
+        ZOOM_RATIO = 1 << 2,
+        ROTATE_AND_CROP = 1 << 3,
+    };
+
+    // The mappers of one camera, null when not needed
+    struct Chain {
+        UHRCropAndMeteringRegionMapper* uhrCropAndMeteringRegions = nullptr;
+        DistortionMapper* distortion = nullptr;
+        ZoomRatioMapper* zoomRatio = nullptr;
+        RotateAndCropMapper* rotateAndCrop = nullptr;
+
+        // Last settings mapped, and the result
+        struct {
+            bool valid = false;
+            uint32_t mappers = 0;
+            uint32_t calibrationGeneration = 0;
+            CameraMetadata settings;
+            CameraMetadata mapped;
+        } cache;
+    };
+
+    /**
+     * Composes the mappers of each camera. The mappers are referenced, not copied: the maps
+     * must not be modified until the next compose().
+     */
+    void compose(
+            std::unordered_map<std::string, UHRCropAndMeteringRegionMapper>& uhrMappers,
+            std::unordered_map<std::string, DistortionMapper>& distortionMappers,
+            std::unordered_map<std::string, ZoomRatioMapper>& zoomRatioMappers,
+            std::unordered_map<std::string, RotateAndCropMapper>& rotateAndCropMappers);
+
+    // Returns the mappers of the camera, or null if it has none.
+    Chain* find(const std::string& cameraId);
+
+    /**
+     * Applies the requested mappers of the chain which exist to the settings. Returns in
+     * *applied the mappers applied, and on error in *failed the mapper which failed.
+     */
+    status_t apply(Chain& chain, uint32_t mappers, CameraMetadata* settings,
+            uint32_t* applied, Mapper* failed);
+
+    int64_t cacheHits() const { return mCacheHits; }
+    int64_t cacheMisses() const { return mCacheMisses; }
+
+    static const char* mapperName(Mapper mapper);
+
+  private:
+    static uint32_t availableMappers(const Chain& chain);
+    static bool sameSettings(const CameraMetadata& a, const CameraMetadata& b);
+
+    std::unordered_map<std::string, Chain> mChains;
+    int64_t mCacheHits = 0;
+    int64_t mCacheMisses = 0;
+}; // class RequestMetadataMappers
+
+} // namespace camera3
+
+} // namespace android
+
+#endif
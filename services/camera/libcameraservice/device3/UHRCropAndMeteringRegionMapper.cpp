@@ -22,7 +22,7 @@
 #include <cmath>
 
 #include "device3/UHRCropAndMeteringRegionMapper.h"
-#include "utils/SessionConfigurationUtils.h"
+#include "utils/SessionConfigurationUtilsHost.h"
 
 namespace android {
 
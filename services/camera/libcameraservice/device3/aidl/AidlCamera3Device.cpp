@@ -423,7 +423,8 @@ int32_t AidlCamera3Device::getCaptureResultFMQSize() {
         mDistortionMappers, mZoomRatioMappers, mRotateAndCropMappers,
         mTagMonitor, mInputStream, mOutputStreams, mSessionStatsBuilder, listener, *this,
         *this, *(mInterface), mLegacyClient, mMinExpectedDuration, mIsFixedFps,
-        mRotationOverride, mActivePhysicalId}, mResultMetadataQueue
+        mRotationOverride, mActivePhysicalId,
+        mResultMetadataAssembler}, mResultMetadataQueue
     };
 
     for (const auto& result : results) {
@@ -465,7 +466,8 @@ int32_t AidlCamera3Device::getCaptureResultFMQSize() {
         mDistortionMappers, mZoomRatioMappers, mRotateAndCropMappers,
         mTagMonitor, mInputStream, mOutputStreams, mSessionStatsBuilder, listener, *this,
         *this, *(mInterface), mLegacyClient, mMinExpectedDuration, mIsFixedFps,
-        mRotationOverride, mActivePhysicalId}, mResultMetadataQueue
+        mRotationOverride, mActivePhysicalId,
+        mResultMetadataAssembler}, mResultMetadataQueue
     };
     for (const auto& msg : msgs) {
         camera3::notify(states, msg, mSensorReadoutTimestampSupported);
@@ -593,7 +595,7 @@ status_t AidlCamera3Device::switchToOffline(
     InFlightRequestMap offlineReqs;
     // Verify inflight requests and their pending buffers
     {
-        std::lock_guard<std::mutex> l(mInFlightLock);
+        std::lock_guard<InstrumentedMutex> l(mInFlightLock);
         for (auto offlineReq : offlineSessionInfo.offlineRequests) {
             int idx = mInFlightMap.indexOfKey(offlineReq.frameNumber);
             if (idx == NAME_NOT_FOUND) {
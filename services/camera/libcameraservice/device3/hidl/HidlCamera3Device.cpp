@@ -392,7 +392,8 @@ hardware::Return<void> HidlCamera3Device::processCaptureResult_3_4(
         mDistortionMappers, mZoomRatioMappers, mRotateAndCropMappers,
         mTagMonitor, mInputStream, mOutputStreams, mSessionStatsBuilder, listener, *this, *this,
         *mInterface, mLegacyClient, mMinExpectedDuration, mIsFixedFps, mRotationOverride,
-        mActivePhysicalId}, mResultMetadataQueue
+        mActivePhysicalId,
+        mResultMetadataAssembler}, mResultMetadataQueue
     };
 
     //HidlCaptureOutputStates hidlStates {
@@ -455,7 +456,8 @@ hardware::Return<void> HidlCamera3Device::processCaptureResult(
         mDistortionMappers, mZoomRatioMappers, mRotateAndCropMappers,
         mTagMonitor, mInputStream, mOutputStreams, mSessionStatsBuilder, listener, *this, *this,
         *mInterface, mLegacyClient, mMinExpectedDuration, mIsFixedFps, mRotationOverride,
-        mActivePhysicalId}, mResultMetadataQueue
+        mActivePhysicalId,
+        mResultMetadataAssembler}, mResultMetadataQueue
     };
 
     for (const auto& result : results) {
@@ -503,7 +505,8 @@ hardware::Return<void> HidlCamera3Device::notifyHelper(
         mDistortionMappers, mZoomRatioMappers, mRotateAndCropMappers,
         mTagMonitor, mInputStream, mOutputStreams, mSessionStatsBuilder, listener, *this, *this,
         *mInterface, mLegacyClient, mMinExpectedDuration, mIsFixedFps, mRotationOverride,
-        mActivePhysicalId}, mResultMetadataQueue
+        mActivePhysicalId,
+        mResultMetadataAssembler}, mResultMetadataQueue
     };
     for (const auto& msg : msgs) {
         camera3::notify(states, msg);
@@ -630,7 +633,7 @@ status_t HidlCamera3Device::switchToOffline(
     InFlightRequestMap offlineReqs;
     // Verify inflight requests and their pending buffers
     {
-        std::lock_guard<std::mutex> l(mInFlightLock);
+        std::lock_guard<InstrumentedMutex> l(mInFlightLock);
         for (auto offlineReq : offlineSessionInfo.offlineRequests) {
             int idx = mInFlightMap.indexOfKey(offlineReq.frameNumber);
             if (idx == NAME_NOT_FOUND) {
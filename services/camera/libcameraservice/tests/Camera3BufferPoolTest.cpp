@@ -0,0 +1,241 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "Camera3BufferPoolTest"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <memory>
+
+#include <gtest/gtest.h>
+#include <ui/Fence.h>
+#include <ui/GraphicBuffer.h>
+#include <utils/Errors.h>
+
+#include "../device3/Camera3BufferManager.h"
+#include "../device3/Camera3BufferPool.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+const Camera3BufferPool::BufferKey kPreviewKey = {1920, 1080,
+        HAL_PIXEL_FORMAT_IMPLEMENTATION_DEFINED, GRALLOC_USAGE_HW_TEXTURE};
+const Camera3BufferPool::BufferKey kYuvKey = {640, 480, HAL_PIXEL_FORMAT_YCBCR_420_888,
+        GRALLOC_USAGE_SW_READ_OFTEN};
+
+// Hands out buffers without backing memory, and counts them
+class FakeAllocator : public Camera3BufferPool::Allocator {
+  public:
+    status_t allocate(const Camera3BufferPool::BufferKey&, sp<GraphicBuffer>* buffer) override {
+        if (mFail) {
+            return NO_MEMORY;
+        }
+        *buffer = sp<GraphicBuffer>::make();
+        mAllocations++;
+        return OK;
+    }
+
+    std::atomic<int> mAllocations{0};
+    std::atomic<bool> mFail{false};
+};
+
+} // namespace
+
+class Camera3BufferPoolTest : public testing::Test {
+  protected:
+    void createPool(size_t budgetBytes = Camera3BufferPool::kDefaultBudgetBytes) {
+        mAllocator = std::make_shared<FakeAllocator>();
+        mPool = std::make_shared<Camera3BufferPool>(mAllocator, budgetBytes);
+    }
+
+    void SetUp() override { createPool(); }
+
+    sp<GraphicBuffer> getBuffer(const Camera3BufferPool::BufferKey& key) {
+        sp<GraphicBuffer> buffer;
+        sp<Fence> fence;
+        EXPECT_EQ(mPool->getBuffer(key, &buffer, &fence), OK);
+        EXPECT_NE(buffer, nullptr);
+        EXPECT_NE(fence, nullptr);
+        return buffer;
+    }
+
+    std::shared_ptr<FakeAllocator> mAllocator;
+    std::shared_ptr<Camera3BufferPool> mPool;
+};
+
+TEST_F(Camera3BufferPoolTest, RecycleUpToWatermark) {
+    sp<GraphicBuffer> first = getBuffer(kPreviewKey);
+    sp<GraphicBuffer> second = getBuffer(kPreviewKey);
+    EXPECT_EQ(mAllocator->mAllocations, 2);
+
+    // Without a watermark, nothing is kept
+    mPool->returnBuffer(kPreviewKey, first);
+    EXPECT_EQ(mPool->warmBufferCount(kPreviewKey), 0u);
+
+    mPool->updateWatermark(kPreviewKey, 1);
+    mPool->updateWatermark(kPreviewKey, 0);
+    EXPECT_EQ(mPool->getWatermark(kPreviewKey), 1u);
+    mPool->returnBuffer(kPreviewKey, second);
+    mPool->returnBuffer(kPreviewKey, first);
+    EXPECT_EQ(mPool->warmBufferCount(kPreviewKey), 1u);
+    EXPECT_EQ(mPool->warmBytes(), Camera3BufferPool::estimateBufferSize(kPreviewKey));
+
+    // Warm buffers are only handed out for their own key
+    EXPECT_NE(getBuffer(kYuvKey), second);
+    EXPECT_EQ(getBuffer(kPreviewKey), second);
+    EXPECT_EQ(mAllocator->mAllocations, 3);
+    EXPECT_EQ(mPool->warmBytes(), 0u);
+
+    Camera3BufferPool::Stats stats = mPool->getStats();
+    EXPECT_EQ(stats.hits, 1);
+    EXPECT_EQ(stats.stalls, 3);
+    EXPECT_EQ(stats.stallLatency.count(), 3);
+    EXPECT_EQ(stats.recycled, 1);
+    EXPECT_EQ(stats.dropped, 2);
+}
+
+TEST_F(Camera3BufferPoolTest, PrefetchAvoidsStalls) {
+    mPool->prefetch(kPreviewKey, 4);
+    mPool->waitForPrefetch();
+    EXPECT_EQ(mPool->warmBufferCount(kPreviewKey), 4u);
+
+    // Already warm buffers count towards the prefetch
+    mPool->prefetch(kPreviewKey, 3);
+    mPool->waitForPrefetch();
+    EXPECT_EQ(mAllocator->mAllocations, 4);
+
+    for (int i = 0; i < 4; i++) {
+        getBuffer(kPreviewKey);
+    }
+    Camera3BufferPool::Stats stats = mPool->getStats();
+    EXPECT_EQ(stats.prefetched, 4);
+    EXPECT_EQ(stats.hits, 4);
+    EXPECT_EQ(stats.stalls, 0);
+    EXPECT_EQ(mAllocator->mAllocations, 4);
+}
+
+TEST_F(Camera3BufferPoolTest, BudgetEvictsLeastRecentlyUsed) {
+    size_t previewSize = Camera3BufferPool::estimateBufferSize(kPreviewKey);
+    size_t yuvSize = Camera3BufferPool::estimateBufferSize(kYuvKey);
+    createPool(2 * previewSize + yuvSize / 2);
+
+    // Buffers of a key are never evicted for the same key
+    mPool->prefetch(kPreviewKey, 3);
+    mPool->waitForPrefetch();
+    EXPECT_EQ(mPool->warmBufferCount(kPreviewKey), 2u);
+    EXPECT_EQ(mPool->getStats().overBudget, 1);
+
+    // Room for the more recently used key is made by evicting the other one
+    mPool->prefetch(kYuvKey, 1);
+    mPool->waitForPrefetch();
+    EXPECT_EQ(mPool->warmBufferCount(kYuvKey), 1u);
+    EXPECT_EQ(mPool->warmBufferCount(kPreviewKey), 1u);
+    EXPECT_EQ(mPool->getStats().evicted, 1);
+    EXPECT_LE(mPool->warmBytes(), 2 * previewSize + yuvSize / 2);
+
+    // Returned buffers are subject to the budget too
+    mPool->updateWatermark(kPreviewKey, 3);
+    sp<GraphicBuffer> buffer = getBuffer(kPreviewKey);
+    mPool->returnBuffer(kPreviewKey, buffer);
+    mPool->returnBuffer(kPreviewKey, sp<GraphicBuffer>::make());
+    EXPECT_EQ(mPool->warmBufferCount(kPreviewKey), 2u);
+    EXPECT_EQ(mPool->warmBufferCount(kYuvKey), 0u);
+    mPool->returnBuffer(kPreviewKey, sp<GraphicBuffer>::make());
+    EXPECT_EQ(mPool->warmBufferCount(kPreviewKey), 2u);
+    EXPECT_EQ(mPool->getStats().overBudget, 2);
+
+    mPool->clear();
+    EXPECT_EQ(mPool->warmBytes(), 0u);
+    EXPECT_EQ(mPool->getWatermark(kPreviewKey), 3u);
+}
+
+TEST_F(Camera3BufferPoolTest, AllocationFailure) {
+    mAllocator->mFail = true;
+    sp<GraphicBuffer> buffer;
+    sp<Fence> fence;
+    EXPECT_EQ(mPool->getBuffer(kPreviewKey, &buffer, &fence), NO_MEMORY);
+    EXPECT_EQ(buffer, nullptr);
+
+    mPool->prefetch(kPreviewKey, 1);
+    mPool->waitForPrefetch();
+    EXPECT_EQ(mPool->warmBufferCount(kPreviewKey), 0u);
+    EXPECT_EQ(mPool->warmBytes(), 0u);
+    EXPECT_EQ(mPool->getStats().allocationFailures, 2);
+}
+
+TEST_F(Camera3BufferPoolTest, BufferManagerReconfiguration) {
+    sp<Camera3BufferManager> manager = sp<Camera3BufferManager>::make(mPool);
+    const int kStreamId = 0;
+    const int kStreamSetId = 1;
+    StreamInfo info(kStreamId, kStreamSetId, kYuvKey.width, kYuvKey.height, kYuvKey.format,
+            HAL_DATASPACE_UNKNOWN, kYuvKey.usage, /*bufferCount*/4, /*configured*/true);
+    // Only streams sharing buffers with others in their set are promoted by the manager
+    wp<Camera3OutputStream> stream;
+
+    ASSERT_EQ(manager->registerStream(stream, info), OK);
+    sp<GraphicBuffer> buffers[2];
+    for (auto& buffer : buffers) {
+        int fenceFd = -1;
+        ASSERT_EQ(manager->getBufferForStream(kStreamId, kStreamSetId, /*isMultiRes*/false,
+                &buffer, &fenceFd), OK);
+        EXPECT_EQ(fenceFd, -1);
+    }
+    EXPECT_EQ(mAllocator->mAllocations, 2);
+    EXPECT_EQ(mPool->getWatermark(kYuvKey), 2u);
+
+    // A buffer freed by the stream is kept warm
+    manager->notifyBufferRemoved(kStreamId, kStreamSetId, /*isMultiRes*/false, buffers[0]);
+    EXPECT_EQ(mPool->warmBufferCount(kYuvKey), 1u);
+    ASSERT_EQ(manager->unregisterStream(kStreamId, kStreamSetId, /*isMultiRes*/false), OK);
+
+    // After reconfiguring, the missing buffer is prefetched, and the stream doesn't stall
+    ASSERT_EQ(manager->registerStream(stream, info), OK);
+    mPool->waitForPrefetch();
+    EXPECT_EQ(mAllocator->mAllocations, 3);
+    for (auto& buffer : buffers) {
+        int fenceFd = -1;
+        ASSERT_EQ(manager->getBufferForStream(kStreamId, kStreamSetId, /*isMultiRes*/false,
+                &buffer, &fenceFd), OK);
+    }
+    EXPECT_EQ(mAllocator->mAllocations, 3);
+    EXPECT_EQ(mPool->getStats().hits, 2);
+
+    // Prefetching for a stream with all its buffers attached, or an unknown stream, is a no-op
+    manager->prefetchForStream(kStreamId, kStreamSetId, /*isMultiRes*/false);
+    manager->prefetchForStream(kStreamId + 1, kStreamSetId, /*isMultiRes*/false);
+    mPool->waitForPrefetch();
+    EXPECT_EQ(mAllocator->mAllocations, 3);
+
+    // A buffer the stream couldn't attach goes back to the pool, along with its fence
+    int fenceFds[2];
+    ASSERT_EQ(pipe(fenceFds), 0);
+    close(fenceFds[1]);
+    manager->cancelBufferForStream(kStreamId, kStreamSetId, /*isMultiRes*/false, buffers[1],
+            fenceFds[0]);
+    EXPECT_EQ(mPool->warmBufferCount(kYuvKey), 1u);
+    sp<GraphicBuffer> buffer;
+    int fenceFd = -1;
+    ASSERT_EQ(manager->getBufferForStream(kStreamId, kStreamSetId, /*isMultiRes*/false,
+            &buffer, &fenceFd), OK);
+    EXPECT_EQ(buffer, buffers[1]);
+    EXPECT_NE(fenceFd, -1);
+    close(fenceFd);
+    EXPECT_EQ(mAllocator->mAllocations, 3);
+}
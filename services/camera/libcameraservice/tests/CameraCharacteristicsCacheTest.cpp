@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "CameraCharacteristicsCacheTest"
+
+#include <string>
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+#include <utils/Errors.h>
+
+#include "../common/CameraCharacteristicsCache.h"
+
+using namespace android;
+
+namespace {
+
+const std::string kFingerprint = "test/fingerprint";
+
+CameraMetadata makeCharacteristics() {
+    CameraMetadata characteristics;
+    const int32_t activeArray[] = {0, 0, 4032, 3024};
+    characteristics.update(ANDROID_SENSOR_INFO_ACTIVE_ARRAY_SIZE, activeArray, 4);
+    const float maxZoom = 8.f;
+    characteristics.update(ANDROID_SCALER_AVAILABLE_MAX_DIGITAL_ZOOM, &maxZoom, 1);
+    const uint8_t hwLevel = ANDROID_INFO_SUPPORTED_HARDWARE_LEVEL_FULL;
+    characteristics.update(ANDROID_INFO_SUPPORTED_HARDWARE_LEVEL, &hwLevel, 1);
+    return characteristics;
+}
+
+CameraCharacteristicsCache::Key makeKey(const CameraMetadata& characteristics) {
+    CameraCharacteristicsCache::Key key;
+    key.providerName = "android.hardware.camera.provider.ICameraProvider/internal/0";
+    key.deviceName = "device@1.1/internal/0";
+    key.interfaceVersion = 3;
+    key.halCharacteristicsHash = CameraCharacteristicsCache::hash(characteristics);
+    key.derivationFlags = 0x5;
+    key.mediaCodecsHash = 0x1234;
+    return key;
+}
+
+} // namespace
+
+TEST(CameraCharacteristicsCacheTest, RoundTrip) {
+    TemporaryDir dir;
+    CameraCharacteristicsCache cache(dir.path, kFingerprint);
+    const CameraMetadata hal = makeCharacteristics();
+    const auto key = makeKey(hal);
+
+    CameraCharacteristicsCache::Entry entry;
+    EXPECT_EQ(NAME_NOT_FOUND, cache.load(key, &entry));
+
+    CameraCharacteristicsCache::Entry stored;
+    stored.characteristics = hal;
+    const float zoomRange[] = {1.f, 8.f};
+    stored.characteristics.update(ANDROID_CONTROL_ZOOM_RATIO_RANGE, zoomRange, 2);
+    stored.supportNativeZoomRatio = true;
+    ASSERT_EQ(OK, cache.store(key, stored));
+
+    // As if by a new cameraserver instance
+    CameraCharacteristicsCache reloaded(dir.path, kFingerprint);
+    ASSERT_EQ(OK, reloaded.load(key, &entry));
+    EXPECT_TRUE(entry.supportNativeZoomRatio);
+    EXPECT_FALSE(entry.compositeJpegRDisabled);
+    EXPECT_EQ(CameraCharacteristicsCache::hash(stored.characteristics),
+            CameraCharacteristicsCache::hash(entry.characteristics));
+    auto zoom = entry.characteristics.find(ANDROID_CONTROL_ZOOM_RATIO_RANGE);
+    ASSERT_EQ(2u, zoom.count);
+    EXPECT_EQ(8.f, zoom.data.f[1]);
+}
+
+TEST(CameraCharacteristicsCacheTest, MismatchedKeyIsMiss) {
+    TemporaryDir dir;
+    CameraCharacteristicsCache cache(dir.path, kFingerprint);
+    CameraCharacteristicsCache::Entry stored;
+    stored.characteristics = makeCharacteristics();
+    const auto key = makeKey(stored.characteristics);
+    ASSERT_EQ(OK, cache.store(key, stored));
+
+    CameraCharacteristicsCache::Entry entry;
+    auto otherKey = key;
+    otherKey.halCharacteristicsHash++;
+    EXPECT_EQ(NAME_NOT_FOUND, cache.load(otherKey, &entry));
+    otherKey = key;
+    otherKey.interfaceVersion++;
+    EXPECT_EQ(NAME_NOT_FOUND, cache.load(otherKey, &entry));
+    otherKey = key;
+    otherKey.derivationFlags = 0;
+    EXPECT_EQ(NAME_NOT_FOUND, cache.load(otherKey, &entry));
+    // As after a media module update
+    otherKey = key;
+    otherKey.mediaCodecsHash++;
+    EXPECT_EQ(NAME_NOT_FOUND, cache.load(otherKey, &entry));
+
+    CameraCharacteristicsCache otherBuild(dir.path, "other/fingerprint");
+    EXPECT_EQ(NAME_NOT_FOUND, otherBuild.load(key, &entry));
+
+    EXPECT_EQ(OK, cache.load(key, &entry));
+}
+
+TEST(CameraCharacteristicsCacheTest, CorruptEntryIsRejected) {
+    TemporaryDir dir;
+    CameraCharacteristicsCache cache(dir.path, kFingerprint);
+    CameraCharacteristicsCache::Entry stored;
+    stored.characteristics = makeCharacteristics();
+    const auto key = makeKey(stored.characteristics);
+    ASSERT_EQ(OK, cache.store(key, stored));
+
+    // Flip a byte of the stored metadata
+    std::string path = std::string(dir.path) + "/" +
+            "android.hardware.camera.provider.ICameraProvider_internal_0_device_1.1_internal_0";
+    std::string contents;
+    ASSERT_TRUE(android::base::ReadFileToString(path, &contents));
+    contents[contents.size() - 8] ^= 0xff;
+    ASSERT_TRUE(android::base::WriteStringToFile(contents, path));
+
+    CameraCharacteristicsCache::Entry entry;
+    EXPECT_EQ(BAD_VALUE, cache.load(key, &entry));
+
+    // Truncated
+    ASSERT_TRUE(android::base::WriteStringToFile(contents.substr(0, 10), path));
+    EXPECT_EQ(BAD_VALUE, cache.load(key, &entry));
+
+    // Replaced by a valid entry
+    ASSERT_EQ(OK, cache.store(key, stored));
+    EXPECT_EQ(OK, cache.load(key, &entry));
+}
+
+TEST(CameraCharacteristicsCacheTest, HashIgnoresCapacity) {
+    const CameraMetadata characteristics = makeCharacteristics();
+    CameraMetadata larger(/*entryCapacity*/ 100, /*dataCapacity*/ 4096);
+    larger.append(characteristics);
+    EXPECT_EQ(CameraCharacteristicsCache::hash(characteristics),
+            CameraCharacteristicsCache::hash(larger));
+
+    const float maxZoom = 10.f;
+    larger.update(ANDROID_SCALER_AVAILABLE_MAX_DIGITAL_ZOOM, &maxZoom, 1);
+    EXPECT_NE(CameraCharacteristicsCache::hash(characteristics),
+            CameraCharacteristicsCache::hash(larger));
+}
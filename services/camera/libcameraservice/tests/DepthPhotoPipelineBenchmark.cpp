@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "../common/DepthPhotoPipeline.h"
+#include "../common/DepthPhotoProcessor.h"
+#include "NV12Compressor.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+const size_t kMainWidth = 1920;
+const size_t kMainHeight = 1440;
+const int kJpegQuality = 95;
+// Frames of a burst capture
+const size_t kBurstLength = 8;
+
+// Noisy color image, so that the main jpeg has a realistic size
+std::vector<uint8_t> makeMainJpeg() {
+    std::vector<uint8_t> nv12(kMainWidth * kMainHeight * 3 / 2);
+    std::default_random_engine gen(1234);
+    std::uniform_int_distribution<int> dist(0, UINT8_MAX);
+    for (auto& sample : nv12) {
+        sample = dist(gen);
+    }
+    NV12Compressor compressor;
+    compressor.compress(nv12.data(), kMainWidth, kMainHeight, kJpegQuality);
+    return compressor.getCompressedData();
+}
+
+// A slanted plane between 0.5m and 4m, with the confidence of a typical ToF sensor
+std::vector<uint16_t> makeDepthMap(size_t width, size_t height) {
+    std::vector<uint16_t> depth(width * height);
+    std::default_random_engine gen(1235);
+    std::uniform_int_distribution<int> confidence(0, 7);
+    std::normal_distribution<float> noise(0.f, 20.f);
+    for (size_t y = 0; y < height; y++) {
+        for (size_t x = 0; x < width; x++) {
+            float range = 500.f + 3500.f * (x + y) / (width + height) + noise(gen);
+            uint16_t millimeters = std::clamp<int>(range, 1, 0x1FFF);
+            depth[y * width + x] = millimeters | (confidence(gen) << 13);
+        }
+    }
+    return depth;
+}
+
+struct Inputs {
+    std::vector<uint8_t> mainJpeg;
+    std::vector<uint16_t> depthMap;
+    DepthPhotoInputFrame frame;
+    std::vector<std::vector<uint8_t>> outputs;
+
+    Inputs(size_t depthWidth, size_t depthHeight) :
+            mainJpeg(makeMainJpeg()), depthMap(makeDepthMap(depthWidth, depthHeight)) {
+        frame.mMainJpegBuffer = reinterpret_cast<const char*>(mainJpeg.data());
+        frame.mMainJpegSize = mainJpeg.size();
+        frame.mMainJpegWidth = kMainWidth;
+        frame.mMainJpegHeight = kMainHeight;
+        frame.mMaxJpegSize = std::max(mainJpeg.size(), MIN_JPEG_BUFFER_SIZE);
+        frame.mJpegQuality = kJpegQuality;
+        frame.mDepthMapBuffer = depthMap.data();
+        frame.mDepthMapWidth = frame.mDepthMapStride = depthWidth;
+        frame.mDepthMapHeight = depthHeight;
+        frame.mIntrinsicCalibration[0] = frame.mIntrinsicCalibration[1] = 1500.f;
+        frame.mIntrinsicCalibration[2] = kMainWidth / 2.f;
+        frame.mIntrinsicCalibration[3] = kMainHeight / 2.f;
+        frame.mIsIntrinsicCalibrationValid = 1;
+        outputs.assign(kBurstLength, std::vector<uint8_t>(frame.mMaxJpegSize * 3));
+    }
+};
+
+void setStageCounters(benchmark::State& state, const DepthPhotoPipeline::Stats& stats) {
+    state.counters["depthMapUs"] = ns2us(stats.depthMapEncoding.mean());
+    state.counters["mainImageUs"] = ns2us(stats.mainImagePackaging.mean());
+    state.counters["containerUs"] = ns2us(stats.containerAssembly.mean());
+    state.counters["queueUs"] = ns2us(stats.queue.mean());
+    state.counters["latencyUs"] = ns2us(stats.total.mean());
+}
+
+} // namespace
+
+// state.range(0), state.range(1): depth map size
+
+// A burst processed one frame after the other, as on the composite stream thread
+static void BM_DepthPhotoBurstSynchronous(benchmark::State& state) {
+    Inputs inputs(state.range(0), state.range(1));
+    DepthPhotoPipeline::Stats stats;
+    for (auto _ : state) {
+        for (auto& output : inputs.outputs) {
+            size_t actualSize = 0;
+            DepthPhotoStageTimes times;
+            nsecs_t start = systemTime();
+            if (processDepthPhotoFrame(inputs.frame, output.size(), output.data(), &actualSize,
+                    &times) != 0) {
+                state.SkipWithError("Depth photo processing failed");
+                return;
+            }
+            stats.depthMapEncoding.add(times.mDepthMapEncoding);
+            stats.mainImagePackaging.add(times.mMainImagePackaging);
+            stats.containerAssembly.add(times.mContainerAssembly);
+            stats.total.add(systemTime() - start);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kBurstLength);
+    setStageCounters(state, stats);
+}
+BENCHMARK(BM_DepthPhotoBurstSynchronous)->Args({320, 240})->Args({640, 480})
+        ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// state.range(2): worker count, with as many frames in flight
+static void BM_DepthPhotoBurstPipelined(benchmark::State& state) {
+    Inputs inputs(state.range(0), state.range(1));
+    DepthPhotoPipeline pipeline(state.range(2), state.range(2));
+    bool failed = false;
+    for (auto _ : state) {
+        for (auto& output : inputs.outputs) {
+            pipeline.submit(inputs.frame, output.size(), output.data(),
+                    [&failed](const DepthPhotoPipeline::Result& result) {
+                        failed |= result.status != OK;
+                    });
+        }
+        pipeline.waitForIdle();
+        if (failed) {
+            state.SkipWithError("Depth photo processing failed");
+            return;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kBurstLength);
+    setStageCounters(state, pipeline.getStats());
+}
+BENCHMARK(BM_DepthPhotoBurstPipelined)->ArgsProduct({{320}, {240}, {1, 2, 4}})
+        ->ArgsProduct({{640}, {480}, {1, 2, 4}})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
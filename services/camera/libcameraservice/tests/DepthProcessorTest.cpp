@@ -22,6 +22,7 @@
 
 #include <gtest/gtest.h>
 
+#include "../common/DepthPhotoPipeline.h"
 #include "../common/DepthPhotoProcessor.h"
 #include "../utils/ExifUtils.h"
 #include "NV12Compressor.h"
@@ -320,3 +321,83 @@ TEST(DepthProcessorTest, TestDephtPhotoPhysicalRotation) {
         ASSERT_EQ(confidenceMapHeight, expectedHeight);
     }
 }
+
+TEST(DepthProcessorTest, PipelineMatchesSynchronousProcessing) {
+    int jpegQuality = 95;
+    static const size_t kFrameCount = 6;
+    static const size_t kMaxInFlight = 2;
+
+    std::vector<uint8_t> colorJpegBuffer;
+    generateColorJpegBuffer(jpegQuality, ExifOrientation::ORIENTATION_UNDEFINED,
+            /*includeExif*/ false, /*switchDimensions*/ false, &colorJpegBuffer);
+
+    std::array<uint16_t, kTestBufferDepthSize> depth16Buffer;
+    generateDepth16Buffer(&depth16Buffer);
+
+    DepthPhotoInputFrame inputFrame;
+    inputFrame.mMainJpegBuffer = reinterpret_cast<const char*> (colorJpegBuffer.data());
+    inputFrame.mMainJpegSize = colorJpegBuffer.size();
+    // Worst case both depth and confidence maps have the same size as the main color image.
+    inputFrame.mMaxJpegSize = inputFrame.mMainJpegSize * 3;
+    inputFrame.mMainJpegWidth = kTestBufferWidth;
+    inputFrame.mMainJpegHeight = kTestBufferHeight;
+    inputFrame.mJpegQuality = jpegQuality;
+    inputFrame.mDepthMapBuffer = depth16Buffer.data();
+    inputFrame.mDepthMapWidth = inputFrame.mDepthMapStride = kTestBufferWidth;
+    inputFrame.mDepthMapHeight = kTestBufferHeight;
+
+    std::vector<uint8_t> expectedBuffer(inputFrame.mMaxJpegSize);
+    size_t expectedSize = 0;
+    ASSERT_EQ(processDepthPhotoFrame(inputFrame, expectedBuffer.size(), expectedBuffer.data(),
+                &expectedSize), 0);
+
+    std::vector<std::vector<uint8_t>> depthPhotoBuffers(kFrameCount,
+            std::vector<uint8_t>(inputFrame.mMaxJpegSize));
+    std::vector<DepthPhotoPipeline::Result> results(kFrameCount);
+    std::vector<size_t> completionOrder;
+    size_t maxInFlight = 0;
+    {
+        DepthPhotoPipeline pipeline(/*workerCount*/ 3, kMaxInFlight);
+        for (size_t i = 0; i < kFrameCount; i++) {
+            ASSERT_EQ(pipeline.submit(inputFrame, depthPhotoBuffers[i].size(),
+                    depthPhotoBuffers[i].data(),
+                    [&, i](const DepthPhotoPipeline::Result& result) {
+                        // Completions are serialized, no locking needed
+                        completionOrder.push_back(i);
+                        results[i] = result;
+                    }), OK);
+            maxInFlight = std::max(maxInFlight, pipeline.inFlight());
+        }
+        pipeline.waitForIdle();
+        EXPECT_EQ(pipeline.inFlight(), 0u);
+
+        auto stats = pipeline.getStats();
+        EXPECT_EQ(stats.total.count, static_cast<int64_t>(kFrameCount));
+        EXPECT_EQ(stats.failures, 0);
+        EXPECT_GT(stats.depthMapEncoding.mean(), 0);
+        EXPECT_GT(stats.containerAssembly.mean(), 0);
+    }
+
+    EXPECT_LE(maxInFlight, kMaxInFlight);
+    ASSERT_EQ(completionOrder.size(), kFrameCount);
+    for (size_t i = 0; i < kFrameCount; i++) {
+        EXPECT_EQ(completionOrder[i], i);
+        ASSERT_EQ(results[i].status, OK);
+        ASSERT_EQ(results[i].actualSize, expectedSize);
+        EXPECT_GE(results[i].totalTime, results[i].queueTime);
+        EXPECT_EQ(memcmp(depthPhotoBuffers[i].data(), expectedBuffer.data(), expectedSize), 0);
+    }
+}
+
+TEST(DepthProcessorTest, PipelineReportsFailures) {
+    DepthPhotoInputFrame inputFrame;
+    std::vector<uint8_t> depthPhotoBuffer(MIN_JPEG_BUFFER_SIZE);
+    status_t status = OK;
+
+    DepthPhotoPipeline pipeline;
+    ASSERT_EQ(pipeline.submit(inputFrame, depthPhotoBuffer.size(), depthPhotoBuffer.data(),
+            [&](const DepthPhotoPipeline::Result& result) { status = result.status; }), OK);
+    pipeline.waitForIdle();
+    EXPECT_EQ(status, BAD_VALUE);
+    EXPECT_EQ(pipeline.getStats().failures, 1);
+}
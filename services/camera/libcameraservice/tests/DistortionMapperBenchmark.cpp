@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "../device3/DistortionMapper.h"
+
+using namespace android;
+using namespace android::camera3;
+using DistortionMapperInfo = android::camera3::DistortionMapper::DistortionMapperInfo;
+
+namespace {
+
+int32_t activeArray[] = {0, 8, 3278, 2450};
+int32_t preCorrectionActiveArray[] = {0, 0, 3280, 2464};
+float distortion[] = {0.06875723, -0.13922249, 0.02818312, -0.00032781, -0.00025431};
+float intrinsics[] = {1812.50000000, 1812.50000000, 1645.59533691, 1229.23229980, 0.00000000};
+
+void setupMapper(DistortionMapper *m) {
+    CameraMetadata deviceInfo;
+    deviceInfo.update(ANDROID_SENSOR_INFO_PRE_CORRECTION_ACTIVE_ARRAY_SIZE,
+            preCorrectionActiveArray, 4);
+    deviceInfo.update(ANDROID_SENSOR_INFO_ACTIVE_ARRAY_SIZE, activeArray, 4);
+    deviceInfo.update(ANDROID_LENS_INTRINSIC_CALIBRATION, intrinsics, 5);
+    deviceInfo.update(ANDROID_LENS_DISTORTION, distortion, 5);
+    m->setupStaticInfo(deviceInfo);
+}
+
+// The points of a result: corners of metering regions and face rectangles
+std::vector<int32_t> makeCoords(size_t coordCount) {
+    std::default_random_engine gen(1234);
+    std::uniform_int_distribution<int> xDist(0, activeArray[2] - 1);
+    std::uniform_int_distribution<int> yDist(0, activeArray[3] - 1);
+    std::vector<int32_t> coords(coordCount * 2);
+    for (size_t i = 0; i < coords.size(); i += 2) {
+        coords[i] = xDist(gen);
+        coords[i + 1] = yDist(gen);
+    }
+    return coords;
+}
+
+} // namespace
+
+// state.range(0): number of points; state.range(1): whether to use the complex correction
+
+// Per region, as correctCaptureRequest() did before batching
+static void BM_CorrectedToRawPerRegion(benchmark::State& state) {
+    DistortionMapper m;
+    setupMapper(&m);
+    DistortionMapperInfo *mapperInfo = m.getMapperInfo();
+    const auto coords = makeCoords(state.range(0));
+    const bool simple = state.range(1) == 0;
+    for (auto _ : state) {
+        auto mapped = coords;
+        for (size_t i = 0; i < mapped.size(); i += 4) {
+            m.mapCorrectedToRaw(mapped.data() + i, 2, mapperInfo, /*clamp*/true, simple);
+        }
+        benchmark::DoNotOptimize(mapped.data());
+    }
+}
+BENCHMARK(BM_CorrectedToRawPerRegion)->ArgsProduct({{8, 64, 512}, {0, 1}});
+
+static void BM_CorrectedToRawBatch(benchmark::State& state) {
+    DistortionMapper m;
+    setupMapper(&m);
+    DistortionMapperInfo *mapperInfo = m.getMapperInfo();
+    const auto coords = makeCoords(state.range(0));
+    const bool simple = state.range(1) == 0;
+    for (auto _ : state) {
+        auto mapped = coords;
+        m.mapCorrectedToRawBatch(mapped.data(), mapped.size() / 2, mapperInfo, /*clamp*/true,
+                simple);
+        benchmark::DoNotOptimize(mapped.data());
+    }
+}
+BENCHMARK(BM_CorrectedToRawBatch)->ArgsProduct({{8, 64, 512}, {0, 1}});
+
+// Searching the whole distorted grid for each point
+static void BM_RawToCorrectedGridSearch(benchmark::State& state) {
+    DistortionMapper m;
+    setupMapper(&m);
+    DistortionMapperInfo *mapperInfo = m.getMapperInfo();
+    auto coords = makeCoords(state.range(0));
+    m.mapCorrectedToRaw(coords.data(), coords.size() / 2, mapperInfo, /*clamp*/true,
+            /*simple*/false);
+    // Builds the grids
+    auto warmup = coords;
+    m.mapRawToCorrected(warmup.data(), 1, mapperInfo, /*clamp*/true, /*simple*/false);
+    for (auto _ : state) {
+        for (size_t i = 0; i < coords.size(); i += 2) {
+            benchmark::DoNotOptimize(DistortionMapper::findEnclosingQuad(coords.data() + i,
+                    mapperInfo->mDistortedGrid));
+        }
+    }
+}
+BENCHMARK(BM_RawToCorrectedGridSearch)->Arg(8)->Arg(64)->Arg(512);
+
+// Searching the quads listed by the inverse lookup grid
+static void BM_RawToCorrectedInverseGrid(benchmark::State& state) {
+    DistortionMapper m;
+    setupMapper(&m);
+    DistortionMapperInfo *mapperInfo = m.getMapperInfo();
+    auto coords = makeCoords(state.range(0));
+    m.mapCorrectedToRaw(coords.data(), coords.size() / 2, mapperInfo, /*clamp*/true,
+            /*simple*/false);
+    auto warmup = coords;
+    m.mapRawToCorrected(warmup.data(), 1, mapperInfo, /*clamp*/true, /*simple*/false);
+    for (auto _ : state) {
+        for (size_t i = 0; i < coords.size(); i += 2) {
+            benchmark::DoNotOptimize(DistortionMapper::findEnclosingDistortedQuad(
+                    coords.data() + i, mapperInfo));
+        }
+    }
+}
+BENCHMARK(BM_RawToCorrectedInverseGrid)->Arg(8)->Arg(64)->Arg(512);
+
+BENCHMARK_MAIN();
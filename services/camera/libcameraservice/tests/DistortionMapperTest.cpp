@@ -379,3 +379,143 @@ TEST(DistortionMapperTest, CompareToOpenCV) {
                 << expCoords[i] << ", " << expCoords[i + 1] << ")";
     }
 }
+
+void RandomCoords(std::vector<int32_t> *coords, int32_t* activeArray, size_t coordCount) {
+    std::default_random_engine gen(1234);
+    std::uniform_int_distribution<int> x_dist(0, activeArray[2] - 1);
+    std::uniform_int_distribution<int> y_dist(0, activeArray[3] - 1);
+    coords->resize(coordCount * 2);
+    for (size_t i = 0; i < coords->size(); i += 2) {
+        (*coords)[i] = x_dist(gen);
+        (*coords)[i + 1] = y_dist(gen);
+    }
+    coords->insert(coords->end(), basicCoords.begin(), basicCoords.end());
+}
+
+// The batched mapping must give the same results as mapping coordinate pairs one at a time
+TEST(DistortionMapperTest, BatchMatchesUnbatched) {
+    float bigDistortion[] = {0.1, -0.003, 0.004, 0.02, 0.01};
+
+    DistortionMapper m;
+    setupTestMapper(&m, bigDistortion, testICal,
+            /*activeArray*/testActiveArray,
+            /*preCorrectionActiveArray*/testPreCorrActiveArray);
+    DistortionMapperInfo *mapperInfo = m.getMapperInfo();
+
+    std::vector<int32_t> coords;
+    // Not a multiple of the batch size
+    RandomCoords(&coords, testActiveArray, 1001);
+
+    for (bool simple : {true, false}) {
+        for (bool clamp : {true, false}) {
+            auto expected = coords;
+            auto batched = coords;
+            ASSERT_EQ(OK, m.mapCorrectedToRaw(expected.data(), expected.size() / 2, mapperInfo,
+                    clamp, simple));
+            ASSERT_EQ(OK, m.mapCorrectedToRawBatch(batched.data(), batched.size() / 2,
+                    mapperInfo, clamp, simple));
+            for (size_t i = 0; i < coords.size(); i++) {
+                // Allow for different floating point contraction in the vectorized math
+                EXPECT_NEAR(expected[i], batched[i], simple ? 0 : 1)
+                        << "corrected to raw, simple " << simple << ", clamp " << clamp
+                        << ", [" << i << "]";
+            }
+
+            // Back to corrected coordinates, from the same raw coordinates
+            batched = expected;
+            ASSERT_EQ(OK, m.mapRawToCorrected(expected.data(), expected.size() / 2, mapperInfo,
+                    clamp, simple));
+            ASSERT_EQ(OK, m.mapRawToCorrectedBatch(batched.data(), batched.size() / 2,
+                    mapperInfo, clamp, simple));
+            for (size_t i = 0; i < coords.size(); i++) {
+                EXPECT_EQ(expected[i], batched[i])
+                        << "raw to corrected, simple " << simple << ", clamp " << clamp
+                        << ", [" << i << "]";
+            }
+        }
+    }
+}
+
+// The inverse lookup grid must find the same quad as searching the whole distorted grid,
+// including for points on quad edges and outside of the grid
+TEST(DistortionMapperTest, InverseGridMatchesSearch) {
+    float bigDistortion[] = {0.1, -0.003, 0.004, 0.02, 0.01};
+
+    DistortionMapper m;
+    setupTestMapper(&m, bigDistortion, testICal,
+            /*activeArray*/testActiveArray,
+            /*preCorrectionActiveArray*/testPreCorrActiveArray);
+    DistortionMapperInfo *mapperInfo = m.getMapperInfo();
+
+    for (int pass = 0; pass < 2; pass++) {
+        // Builds the grids
+        int32_t pt[2] = {testPreCorrActiveArray[2] / 2, testPreCorrActiveArray[3] / 2};
+        ASSERT_EQ(OK, m.mapRawToCorrected(pt, 1, mapperInfo, /*clamp*/false, /*simple*/false));
+
+        const auto &grid = mapperInfo->mDistortedGrid;
+        std::vector<std::array<int32_t, 2>> points;
+        for (const auto &quad : grid) {
+            for (size_t i = 0; i < quad.coords.size(); i += 2) {
+                points.push_back({static_cast<int32_t>(std::round(quad.coords[i])),
+                        static_cast<int32_t>(std::round(quad.coords[i + 1]))});
+            }
+        }
+        for (int32_t y = -200; y < testPreCorrActiveArray[3] + 200; y += 7) {
+            for (int32_t x = -200; x < testPreCorrActiveArray[2] + 200; x += 7) {
+                points.push_back({x, y});
+            }
+        }
+        for (const auto &p : points) {
+            EXPECT_EQ(DistortionMapper::findEnclosingQuad(p.data(), grid),
+                    DistortionMapper::findEnclosingDistortedQuad(p.data(), mapperInfo))
+                    << "(" << p[0] << ", " << p[1] << "), pass " << pass;
+        }
+
+        // A calibration change rebuilds the grids, and the inverse lookup grid with them
+        CameraMetadata result;
+        float newDistortion[] = {0.05, -0.01, 0.002, 0.01, 0.005};
+        result.update(ANDROID_LENS_INTRINSIC_CALIBRATION, testICal, 5);
+        result.update(ANDROID_LENS_DISTORTION, newDistortion, 5);
+        ASSERT_EQ(OK, m.updateCalibration(result));
+    }
+}
+
+// Correcting a capture result maps all its regions in one batch, with the same results as
+// mapping each region separately
+TEST(DistortionMapperTest, CorrectCaptureResultBatched) {
+    float bigDistortion[] = {0.1, -0.003, 0.004, 0.02, 0.01};
+
+    DistortionMapper m;
+    setupTestMapper(&m, bigDistortion, testICal,
+            /*activeArray*/testActiveArray,
+            /*preCorrectionActiveArray*/testPreCorrActiveArray);
+    DistortionMapperInfo *mapperInfo = m.getMapperInfo();
+
+    int32_t aeRegions[] = {100, 100, 300, 200, 1000, 500, 500, 600, 600, 0};
+    int32_t afRegions[] = {400, 300, 600, 450, 1};
+    int32_t cropRegion[] = {50, 40, 900, 700};
+    uint8_t distortionMode = ANDROID_DISTORTION_CORRECTION_MODE_FAST;
+
+    CameraMetadata result;
+    result.update(ANDROID_LENS_INTRINSIC_CALIBRATION, testICal, 5);
+    result.update(ANDROID_LENS_DISTORTION, bigDistortion, 5);
+    result.update(ANDROID_DISTORTION_CORRECTION_MODE, &distortionMode, 1);
+    result.update(ANDROID_CONTROL_AE_REGIONS, aeRegions, 10);
+    result.update(ANDROID_CONTROL_AF_REGIONS, afRegions, 5);
+    result.update(ANDROID_SCALER_CROP_REGION, cropRegion, 4);
+    ASSERT_EQ(OK, m.correctCaptureResult(&result));
+
+    ASSERT_EQ(OK, m.mapRawToCorrected(aeRegions, 2, mapperInfo, /*clamp*/true));
+    ASSERT_EQ(OK, m.mapRawToCorrected(afRegions, 2, mapperInfo, /*clamp*/true));
+    ASSERT_EQ(OK, m.mapRawRectToCorrected(cropRegion, 1, mapperInfo, /*clamp*/true));
+
+    auto e = result.find(ANDROID_CONTROL_AE_REGIONS);
+    ASSERT_EQ(10u, e.count);
+    for (size_t i = 0; i < e.count; i++) EXPECT_EQ(aeRegions[i], e.data.i32[i]) << i;
+    // Zero-weight region left alone
+    EXPECT_EQ(500, e.data.i32[5]);
+    e = result.find(ANDROID_CONTROL_AF_REGIONS);
+    for (size_t i = 0; i < e.count; i++) EXPECT_EQ(afRegions[i], e.data.i32[i]) << i;
+    e = result.find(ANDROID_SCALER_CROP_REGION);
+    for (size_t i = 0; i < e.count; i++) EXPECT_EQ(cropRegion[i], e.data.i32[i]) << i;
+}
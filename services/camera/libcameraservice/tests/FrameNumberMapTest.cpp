@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "FrameNumberMapTest"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <utils/Errors.h>
+
+#include "../device3/FrameNumberMap.h"
+#include "../utils/InstrumentedMutex.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+std::vector<uint32_t> frameNumbers(const FrameNumberMap<std::string>& map) {
+    std::vector<uint32_t> keys;
+    for (const auto& entry : map) {
+        keys.push_back(entry.frameNumber);
+    }
+    return keys;
+}
+
+} // namespace
+
+TEST(FrameNumberMapTest, AddFindRemove) {
+    FrameNumberMap<std::string> map;
+    EXPECT_TRUE(map.isEmpty());
+    EXPECT_EQ(map.indexOfKey(5), NAME_NOT_FOUND);
+
+    ssize_t idx = map.add(5, "five");
+    ASSERT_GE(idx, 0);
+    map.add(6, "six");
+    EXPECT_EQ(map.size(), 2u);
+    EXPECT_EQ(map.indexOfKey(5), idx);
+    EXPECT_EQ(map.keyAt(idx), 5u);
+    EXPECT_EQ(map.valueAt(idx), "five");
+    EXPECT_EQ(map.valueFor(6), "six");
+
+    // Adding an existing frame number replaces its value
+    EXPECT_EQ(map.add(5, "FIVE"), idx);
+    EXPECT_EQ(map.size(), 2u);
+    map.editValueAt(idx) += "!";
+    EXPECT_EQ(map.valueFor(5), "FIVE!");
+
+    // A frame number sharing the slot of an entry isn't found
+    EXPECT_EQ(map.indexOfKey(5 + map.capacity()), NAME_NOT_FOUND);
+
+    EXPECT_EQ(map.removeItem(5), idx);
+    EXPECT_EQ(map.indexOfKey(5), NAME_NOT_FOUND);
+    EXPECT_EQ(map.removeItem(5), NAME_NOT_FOUND);
+    EXPECT_EQ(map.size(), 1u);
+
+    map.clear();
+    EXPECT_TRUE(map.isEmpty());
+    EXPECT_EQ(map.begin(), map.end());
+}
+
+TEST(FrameNumberMapTest, OrderedIterationAcrossGrowth) {
+    FrameNumberMap<std::string> map(4);
+    EXPECT_EQ(map.capacity(), 4u);
+
+    // Added out of order, further apart than the capacity
+    std::vector<uint32_t> expected = {100, 101, 103, 110, 140};
+    for (uint32_t frameNumber : {103u, 100u, 140u, 101u, 110u}) {
+        map.add(frameNumber, std::to_string(frameNumber));
+    }
+    EXPECT_GE(map.capacity(), 41u);
+    EXPECT_EQ(frameNumbers(map), expected);
+    for (uint32_t frameNumber : expected) {
+        EXPECT_EQ(map.valueFor(frameNumber), std::to_string(frameNumber));
+    }
+
+    // Removing from both ends and the middle keeps the order
+    map.removeItem(100);
+    map.removeItem(140);
+    map.removeItem(103);
+    expected = {101, 110};
+    EXPECT_EQ(frameNumbers(map), expected);
+
+    for (auto& entry : map) {
+        entry.value = "edited";
+    }
+    EXPECT_EQ(map.valueFor(110), "edited");
+}
+
+TEST(FrameNumberMapTest, Copy) {
+    FrameNumberMap<std::string> map;
+    for (uint32_t frameNumber = 10; frameNumber < 20; frameNumber += 3) {
+        map.add(frameNumber, std::to_string(frameNumber));
+    }
+
+    FrameNumberMap<std::string> copy(map);
+    map.editValueAt(map.indexOfKey(10)) = "changed";
+    map.removeItem(13);
+    EXPECT_EQ(frameNumbers(copy), std::vector<uint32_t>({10, 13, 16, 19}));
+    EXPECT_EQ(copy.valueFor(10), "10");
+
+    copy = map;
+    EXPECT_EQ(frameNumbers(copy), frameNumbers(map));
+    EXPECT_EQ(copy.valueFor(10), "changed");
+}
+
+TEST(FrameNumberMapTest, SlidingWindow) {
+    // Frames are mostly completed in order, with a few ones lagging behind, as in a repeating
+    // request with occasional long running captures.
+    const size_t kInFlight = 8;
+    FrameNumberMap<std::string> map(kInFlight);
+    uint32_t next = 0;
+    for (; next < kInFlight; next++) {
+        map.add(next, std::to_string(next));
+    }
+    for (uint32_t completed = 0; completed < 1000; completed++) {
+        map.add(next, std::to_string(next));
+        next++;
+        if (completed % 100 == 0) {
+            // Keep this one in flight a little longer
+            continue;
+        }
+        ASSERT_GE(map.removeItem(completed), 0) << "frame " << completed;
+        if (completed % 100 == 50) {
+            ASSERT_GE(map.removeItem(completed - 50), 0);
+        }
+
+        uint32_t previous = 0;
+        size_t count = 0;
+        for (const auto& entry : map) {
+            ASSERT_TRUE(count == 0 || entry.frameNumber > previous);
+            previous = entry.frameNumber;
+            count++;
+        }
+        ASSERT_EQ(count, map.size());
+    }
+    // Only the lagging frames made the ring grow
+    EXPECT_LE(map.capacity(), 64u);
+}
+
+TEST(FrameNumberMapTest, InstrumentedMutexWaitStats) {
+    InstrumentedMutex lock;
+    {
+        std::lock_guard<InstrumentedMutex> l(lock);
+    }
+    EXPECT_EQ(lock.acquisitions(), 1);
+    EXPECT_EQ(lock.contended(), 0);
+    EXPECT_EQ(lock.maxWait(), 0);
+
+    const nsecs_t kHoldTime = ms2ns(20);
+    std::unique_lock<InstrumentedMutex> held(lock);
+    std::thread waiter([&lock]() {
+        std::lock_guard<InstrumentedMutex> l(lock);
+    });
+    // Let the waiter block before releasing
+    while (lock.acquisitions() < 3) {
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(std::chrono::nanoseconds(kHoldTime));
+    held.unlock();
+    waiter.join();
+
+    EXPECT_EQ(lock.acquisitions(), 3);
+    EXPECT_EQ(lock.contended(), 1);
+    EXPECT_GE(lock.maxWait(), kHoldTime / 2);
+    EXPECT_EQ(lock.totalWait(), lock.maxWait());
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "LatencyHistogramTest"
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../utils/LatencyHistogram.h"
+
+using namespace android;
+
+using Histogram = CameraLogLatencyHistogram;
+
+TEST(LatencyHistogramTest, BucketBoundaries) {
+    // Buckets are contiguous, and the lower bound of each one maps back to it
+    for (int32_t i = 0; i < Histogram::kBucketCount; i++) {
+        int64_t lower = Histogram::bucketLowerBound(i);
+        EXPECT_EQ(Histogram::bucketIndex(lower), i) << "bucket " << i;
+        if (i > 0) {
+            EXPECT_EQ(Histogram::bucketIndex(lower - 1), i - 1) << "bucket " << i;
+        }
+    }
+
+    // Relative width of the buckets is bounded
+    for (int32_t i = Histogram::kSubBucketCount; i < Histogram::kBucketCount - 1; i++) {
+        int64_t lower = Histogram::bucketLowerBound(i);
+        int64_t width = Histogram::bucketLowerBound(i + 1) - lower;
+        EXPECT_LE(width * Histogram::kSubBucketCount, lower) << "bucket " << i;
+    }
+
+    EXPECT_EQ(Histogram::bucketIndex(-5), 0);
+    EXPECT_EQ(Histogram::bucketIndex(INT64_MAX), Histogram::kBucketCount - 1);
+}
+
+TEST(LatencyHistogramTest, Percentiles) {
+    Histogram histogram;
+    EXPECT_EQ(histogram.percentile(50), 0);
+    EXPECT_EQ(histogram.mean(), 0);
+
+    for (int i = 1; i <= 100; i++) {
+        histogram.add(ms2ns(i));
+    }
+    EXPECT_EQ(histogram.count(), 100);
+    EXPECT_EQ(histogram.max(), ms2ns(100));
+    EXPECT_NEAR(histogram.mean(), ms2ns(50) + us2ns(500), us2ns(1));
+
+    // Within the relative error of the buckets
+    for (double percentile : {10.0, 50.0, 90.0, 99.0}) {
+        nsecs_t expected = ms2ns(percentile);
+        EXPECT_GE(histogram.percentile(percentile), expected) << percentile;
+        EXPECT_LE(histogram.percentile(percentile), expected * 5 / 4) << percentile;
+    }
+    EXPECT_EQ(histogram.percentile(100), ms2ns(100));
+
+    histogram.reset();
+    EXPECT_EQ(histogram.count(), 0);
+    EXPECT_EQ(histogram.max(), 0);
+    EXPECT_EQ(histogram.percentile(50), 0);
+}
+
+TEST(LatencyHistogramTest, Merge) {
+    Histogram fast, slow;
+    for (int i = 0; i < 90; i++) {
+        fast.add(0, ms2ns(10));
+    }
+    for (int i = 0; i < 10; i++) {
+        slow.add(0, ms2ns(1000));
+    }
+
+    Histogram merged(fast);
+    merged.merge(slow);
+    EXPECT_EQ(merged.count(), 100);
+    EXPECT_EQ(merged.max(), ms2ns(1000));
+    EXPECT_LE(merged.percentile(90), ms2ns(10) * 5 / 4);
+    EXPECT_GE(merged.percentile(95), ms2ns(1000));
+    EXPECT_EQ(fast.count(), 90);
+
+    Histogram drained;
+    drained.mergeAndReset(merged);
+    EXPECT_EQ(drained.count(), 100);
+    EXPECT_EQ(drained.percentile(95), ms2ns(1000));
+    EXPECT_EQ(merged.count(), 0);
+    EXPECT_EQ(merged.percentile(50), 0);
+}
+
+TEST(LatencyHistogramTest, ConcurrentAdd) {
+    const int kThreadCount = 4;
+    const int kSamplesPerThread = 10000;
+    Histogram histogram;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreadCount; t++) {
+        threads.emplace_back([&histogram, t]() {
+            for (int i = 0; i < kSamplesPerThread; i++) {
+                histogram.add(us2ns(t * 1000 + i % 1000));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(histogram.count(), kThreadCount * kSamplesPerThread);
+    EXPECT_EQ(histogram.max(), us2ns((kThreadCount - 1) * 1000 + 999));
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "../device3/RequestMetadataMappers.h"
+#include "SyntheticCameraMetadata.h"
+
+using namespace android;
+using namespace android::camera3;
+using namespace android::camera3::test;
+
+namespace {
+
+const std::string kCameraId = "0";
+
+constexpr uint32_t kAllMappers = RequestMetadataMappers::UHR_CROP_AND_METERING_REGIONS |
+        RequestMetadataMappers::DISTORTION_CORRECTION | RequestMetadataMappers::ZOOM_RATIO |
+        RequestMetadataMappers::ROTATE_AND_CROP;
+
+} // namespace
+
+// One map lookup per mapper, as the request thread did before the mappers were composed.
+static void BM_SeparateMappers(benchmark::State& state) {
+    SyntheticCamera camera(kCameraId);
+    int64_t frame = 0;
+    for (auto _ : state) {
+        CameraMetadata settings = makeSyntheticRequest(frame++);
+        auto uhr = camera.uhrMappers.find(kCameraId);
+        if (uhr != camera.uhrMappers.end()) uhr->second.updateCaptureRequest(&settings);
+        auto distortion = camera.distortionMappers.find(kCameraId);
+        if (distortion != camera.distortionMappers.end()) {
+            distortion->second.correctCaptureRequest(&settings);
+        }
+        auto zoom = camera.zoomRatioMappers.find(kCameraId);
+        if (zoom != camera.zoomRatioMappers.end()) zoom->second.updateCaptureRequest(&settings);
+        auto rotate = camera.rotateAndCropMappers.find(kCameraId);
+        if (rotate != camera.rotateAndCropMappers.end()) {
+            rotate->second.updateCaptureRequest(&settings);
+        }
+        benchmark::DoNotOptimize(settings);
+    }
+}
+BENCHMARK(BM_SeparateMappers);
+
+// state.range(0): whether consecutive requests have the same settings
+static void BM_ComposedMappers(benchmark::State& state) {
+    SyntheticCamera camera(kCameraId);
+    RequestMetadataMappers mappers;
+    mappers.compose(camera.uhrMappers, camera.distortionMappers, camera.zoomRatioMappers,
+            camera.rotateAndCropMappers);
+    const bool repeating = state.range(0) != 0;
+    int64_t frame = 0;
+    for (auto _ : state) {
+        CameraMetadata settings = makeSyntheticRequest(repeating ? 0 : frame++);
+        uint32_t applied;
+        RequestMetadataMappers::Mapper failed;
+        auto chain = mappers.find(kCameraId);
+        if (chain != nullptr) mappers.apply(*chain, kAllMappers, &settings, &applied, &failed);
+        benchmark::DoNotOptimize(settings);
+    }
+    state.counters["cacheHits"] = mappers.cacheHits();
+}
+BENCHMARK(BM_ComposedMappers)->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "RequestMetadataMappersTest"
+
+#include <gtest/gtest.h>
+#include <utils/Errors.h>
+
+#include "../device3/RequestMetadataMappers.h"
+#include "SyntheticCameraMetadata.h"
+
+using namespace android;
+using namespace android::camera3;
+using namespace android::camera3::test;
+
+namespace {
+
+const std::string kCameraId = "0";
+
+constexpr uint32_t kAllMappers = RequestMetadataMappers::UHR_CROP_AND_METERING_REGIONS |
+        RequestMetadataMappers::DISTORTION_CORRECTION | RequestMetadataMappers::ZOOM_RATIO |
+        RequestMetadataMappers::ROTATE_AND_CROP;
+
+// The mappers applied one after another, as the request thread used to.
+CameraMetadata mapSequentially(SyntheticCamera& camera, CameraMetadata settings) {
+    EXPECT_EQ(OK, camera.uhrMappers[kCameraId].updateCaptureRequest(&settings));
+    EXPECT_EQ(OK, camera.distortionMappers[kCameraId].correctCaptureRequest(&settings));
+    EXPECT_EQ(OK, camera.zoomRatioMappers[kCameraId].updateCaptureRequest(&settings));
+    EXPECT_EQ(OK, camera.rotateAndCropMappers.at(kCameraId).updateCaptureRequest(&settings));
+    return settings;
+}
+
+void expectSameRegions(const CameraMetadata& expected, const CameraMetadata& actual) {
+    for (uint32_t tag : {ANDROID_SCALER_CROP_REGION, ANDROID_CONTROL_AE_REGIONS,
+            ANDROID_CONTROL_AF_REGIONS, ANDROID_CONTROL_AWB_REGIONS}) {
+        auto e = expected.find(tag);
+        auto a = actual.find(tag);
+        ASSERT_EQ(e.count, a.count) << tag;
+        for (size_t i = 0; i < e.count; i++) {
+            EXPECT_EQ(e.data.i32[i], a.data.i32[i]) << tag << " [" << i << "]";
+        }
+    }
+    EXPECT_EQ(expected.find(ANDROID_CONTROL_ZOOM_RATIO).data.f[0],
+            actual.find(ANDROID_CONTROL_ZOOM_RATIO).data.f[0]);
+}
+
+} // namespace
+
+TEST(RequestMetadataMappersTest, MatchesSequentialMappers) {
+    SyntheticCamera camera(kCameraId);
+    RequestMetadataMappers mappers;
+    mappers.compose(camera.uhrMappers, camera.distortionMappers, camera.zoomRatioMappers,
+            camera.rotateAndCropMappers);
+    auto chain = mappers.find(kCameraId);
+    ASSERT_NE(nullptr, chain);
+    ASSERT_EQ(nullptr, mappers.find("1"));
+
+    const CameraMetadata expected = mapSequentially(camera, makeSyntheticRequest());
+
+    CameraMetadata settings = makeSyntheticRequest();
+    uint32_t applied = 0;
+    RequestMetadataMappers::Mapper failed;
+    ASSERT_EQ(OK, mappers.apply(*chain, kAllMappers, &settings, &applied, &failed));
+    EXPECT_EQ(kAllMappers, applied);
+    expectSameRegions(expected, settings);
+}
+
+TEST(RequestMetadataMappersTest, OnlyRequestedMappers) {
+    SyntheticCamera camera(kCameraId);
+    RequestMetadataMappers mappers;
+    camera.rotateAndCropMappers.clear();
+    mappers.compose(camera.uhrMappers, camera.distortionMappers, camera.zoomRatioMappers,
+            camera.rotateAndCropMappers);
+
+    CameraMetadata expected = makeSyntheticRequest();
+    ASSERT_EQ(OK, camera.zoomRatioMappers[kCameraId].updateCaptureRequest(&expected));
+
+    CameraMetadata settings = makeSyntheticRequest();
+    uint32_t applied = 0;
+    RequestMetadataMappers::Mapper failed;
+    ASSERT_EQ(OK, mappers.apply(*mappers.find(kCameraId),
+            RequestMetadataMappers::ZOOM_RATIO | RequestMetadataMappers::ROTATE_AND_CROP,
+            &settings, &applied, &failed));
+    // No rotate-and-crop mapper for this camera
+    EXPECT_EQ(RequestMetadataMappers::ZOOM_RATIO, applied);
+    expectSameRegions(expected, settings);
+}
+
+TEST(RequestMetadataMappersTest, CachesRepeatedSettings) {
+    SyntheticCamera camera(kCameraId);
+    RequestMetadataMappers mappers;
+    mappers.compose(camera.uhrMappers, camera.distortionMappers, camera.zoomRatioMappers,
+            camera.rotateAndCropMappers);
+    auto chain = mappers.find(kCameraId);
+    uint32_t applied = 0;
+    RequestMetadataMappers::Mapper failed;
+
+    CameraMetadata first = makeSyntheticRequest();
+    ASSERT_EQ(OK, mappers.apply(*chain, kAllMappers, &first, &applied, &failed));
+    CameraMetadata second = makeSyntheticRequest();
+    ASSERT_EQ(OK, mappers.apply(*chain, kAllMappers, &second, &applied, &failed));
+    EXPECT_EQ(kAllMappers, applied);
+    EXPECT_EQ(1, mappers.cacheHits());
+    EXPECT_EQ(1, mappers.cacheMisses());
+    expectSameRegions(first, second);
+
+    // Different settings, or different mappers, are mapped again
+    CameraMetadata other = makeSyntheticRequest(/*frame*/1);
+    ASSERT_EQ(OK, mappers.apply(*chain, kAllMappers, &other, &applied, &failed));
+    EXPECT_EQ(2, mappers.cacheMisses());
+    CameraMetadata zoomOnly = makeSyntheticRequest(/*frame*/1);
+    ASSERT_EQ(OK, mappers.apply(*chain, RequestMetadataMappers::ZOOM_RATIO, &zoomOnly,
+            &applied, &failed));
+    EXPECT_EQ(3, mappers.cacheMisses());
+    EXPECT_EQ(1, mappers.cacheHits());
+}
+
+TEST(RequestMetadataMappersTest, CalibrationChangeInvalidatesCache) {
+    SyntheticCamera camera(kCameraId);
+    RequestMetadataMappers mappers;
+    mappers.compose(camera.uhrMappers, camera.distortionMappers, camera.zoomRatioMappers,
+            camera.rotateAndCropMappers);
+    auto chain = mappers.find(kCameraId);
+    uint32_t applied = 0;
+    RequestMetadataMappers::Mapper failed;
+
+    CameraMetadata before = makeSyntheticRequest();
+    ASSERT_EQ(OK, mappers.apply(*chain, kAllMappers, &before, &applied, &failed));
+
+    // Same calibration: no change
+    CameraMetadata result;
+    const float intrinsics[] = {3000.f, 3000.f, 2016.f, 1512.f, 0.f};
+    const float distortion[] = {0.05f, -0.02f, 0.001f, 0.0005f, -0.0002f};
+    result.update(ANDROID_LENS_INTRINSIC_CALIBRATION, intrinsics, 5);
+    result.update(ANDROID_LENS_DISTORTION, distortion, 5);
+    const uint32_t generation = camera.distortionMappers[kCameraId].calibrationGeneration();
+    ASSERT_EQ(OK, camera.distortionMappers[kCameraId].updateCalibration(result));
+    EXPECT_EQ(generation, camera.distortionMappers[kCameraId].calibrationGeneration());
+
+    const float newDistortion[] = {0.1f, -0.05f, 0.001f, 0.0005f, -0.0002f};
+    result.update(ANDROID_LENS_DISTORTION, newDistortion, 5);
+    ASSERT_EQ(OK, camera.distortionMappers[kCameraId].updateCalibration(result));
+    EXPECT_NE(generation, camera.distortionMappers[kCameraId].calibrationGeneration());
+
+    CameraMetadata after = makeSyntheticRequest();
+    ASSERT_EQ(OK, mappers.apply(*chain, kAllMappers, &after, &applied, &failed));
+    EXPECT_EQ(0, mappers.cacheHits());
+    EXPECT_EQ(2, mappers.cacheMisses());
+    expectSameRegions(mapSequentially(camera, makeSyntheticRequest()), after);
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ResultMetadataAssemblerTest"
+
+#include <string>
+#include <vector>
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+#include <utils/Errors.h>
+
+#include "../device3/Camera3OutputUtils.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+CameraMetadata makeResult() {
+    CameraMetadata result;
+    const int64_t timestamp = 1000;
+    const uint8_t aeState = ANDROID_CONTROL_AE_STATE_CONVERGED;
+    const float focusDistance = 0.5f;
+    const int32_t cropRegion[] = {0, 0, 4000, 3000};
+    result.update(ANDROID_SENSOR_TIMESTAMP, &timestamp, 1);
+    result.update(ANDROID_SCALER_CROP_REGION, cropRegion, 4);
+    result.update(ANDROID_CONTROL_AE_STATE, &aeState, 1);
+    result.update(ANDROID_LENS_FOCUS_DISTANCE, &focusDistance, 1);
+    return result;
+}
+
+CameraMetadata makePartials() {
+    CameraMetadata partials;
+    const uint8_t afState = ANDROID_CONTROL_AF_STATE_PASSIVE_FOCUSED;
+    const float focusDistance = 1.5f;  // also in the result
+    const int32_t aeRegions[] = {10, 10, 20, 20, 1};
+    partials.update(ANDROID_LENS_FOCUS_DISTANCE, &focusDistance, 1);
+    partials.update(ANDROID_CONTROL_AF_STATE, &afState, 1);
+    partials.update(ANDROID_CONTROL_AE_REGIONS, aeRegions, 5);
+    return partials;
+}
+
+CameraMetadata assemble(ResultMetadataAssembler& assembler, const CameraMetadata& result,
+        const CameraMetadata& partials) {
+    const camera_metadata_t* resultBuffer = result.getAndLock();
+    const camera_metadata_t* partialsBuffer = partials.getAndLock();
+    CameraMetadata assembled = assembler.assemble(resultBuffer, partialsBuffer);
+    partials.unlock(partialsBuffer);
+    result.unlock(resultBuffer);
+    return assembled;
+}
+
+} // namespace
+
+TEST(ResultMetadataAssemblerTest, MergesInTagOrder) {
+    ResultMetadataAssembler assembler;
+    const CameraMetadata result = makeResult();
+    const CameraMetadata partials = makePartials();
+
+    CameraMetadata assembled = assemble(assembler, result, partials);
+    ASSERT_EQ(result.entryCount() + partials.entryCount(), assembled.entryCount());
+
+    const camera_metadata_t* buffer = assembled.getAndLock();
+    uint32_t previousTag = 0;
+    for (size_t i = 0; i < get_camera_metadata_entry_count(buffer); i++) {
+        camera_metadata_ro_entry_t entry;
+        ASSERT_EQ(OK, get_camera_metadata_ro_entry(buffer, i, &entry));
+        EXPECT_LE(previousTag, entry.tag);
+        previousTag = entry.tag;
+    }
+    assembled.unlock(buffer);
+
+    // Lookups work without a further sort, and the HAL result wins over the partials.
+    EXPECT_EQ(1000, assembled.find(ANDROID_SENSOR_TIMESTAMP).data.i64[0]);
+    EXPECT_EQ(ANDROID_CONTROL_AF_STATE_PASSIVE_FOCUSED,
+            assembled.find(ANDROID_CONTROL_AF_STATE).data.u8[0]);
+    EXPECT_EQ(5u, assembled.find(ANDROID_CONTROL_AE_REGIONS).count);
+    EXPECT_FLOAT_EQ(0.5f, assembled.find(ANDROID_LENS_FOCUS_DISTANCE).data.f[0]);
+}
+
+TEST(ResultMetadataAssemblerTest, WithoutPartials) {
+    ResultMetadataAssembler assembler;
+    const CameraMetadata result = makeResult();
+
+    const camera_metadata_t* resultBuffer = result.getAndLock();
+    CameraMetadata assembled = assembler.assemble(resultBuffer, nullptr);
+    result.unlock(resultBuffer);
+    EXPECT_EQ(result.entryCount(), assembled.entryCount());
+    EXPECT_EQ(4u, assembled.find(ANDROID_SCALER_CROP_REGION).count);
+}
+
+TEST(ResultMetadataAssemblerTest, FixupsUpdateInPlace) {
+    ResultMetadataAssembler assembler;
+    const CameraMetadata result = makeResult();
+    const CameraMetadata partials = makePartials();
+
+    CameraMetadata assembled = assemble(assembler, result, partials);
+    const camera_metadata_t* buffer = assembled.getAndLock();
+    assembled.unlock(buffer);
+
+    // As fixupAutoframingTags() and insertResultLocked() do
+    const uint8_t autoframing = ANDROID_CONTROL_AUTOFRAMING_OFF;
+    const uint8_t autoframingState = ANDROID_CONTROL_AUTOFRAMING_STATE_INACTIVE;
+    const int32_t requestId = 7;
+    const int32_t frameCount = 42;
+    ASSERT_EQ(OK, assembled.update(ANDROID_CONTROL_AUTOFRAMING, &autoframing, 1));
+    ASSERT_EQ(OK, assembled.update(ANDROID_CONTROL_AUTOFRAMING_STATE, &autoframingState, 1));
+    ASSERT_EQ(OK, assembled.update(ANDROID_REQUEST_ID, &requestId, 1));
+    ASSERT_EQ(OK, assembled.update(ANDROID_REQUEST_FRAME_COUNT, &frameCount, 1));
+
+    const camera_metadata_t* updated = assembled.getAndLock();
+    EXPECT_EQ(buffer, updated);
+    assembled.unlock(updated);
+}
+
+TEST(ResultMetadataAssemblerTest, SizedFromPreviousResults) {
+    ResultMetadataAssembler assembler;
+    const CameraMetadata result = makeResult();
+    const CameraMetadata partials = makePartials();
+
+    // A first result which grew during its fixups
+    CameraMetadata assembled = assemble(assembler, result, partials);
+    const camera_metadata_t* buffer = assembled.getAndLock();
+    assembled.unlock(buffer);
+    std::vector<float> curve(256, 0.5f);
+    ASSERT_EQ(OK, assembled.update(ANDROID_TONEMAP_CURVE_RED, curve.data(), curve.size()));
+    assembler.finish(assembled, buffer);
+    const size_t lastDataCount = [&]() {
+        const camera_metadata_t* b = assembled.getAndLock();
+        const size_t count = get_camera_metadata_data_count(b);
+        assembled.unlock(b);
+        return count;
+    }();
+
+    // The next result reserves as much, so that the same fixups need no reallocation.
+    CameraMetadata next = assemble(assembler, result, partials);
+    const camera_metadata_t* nextBuffer = next.getAndLock();
+    EXPECT_LE(lastDataCount, get_camera_metadata_data_capacity(nextBuffer));
+    next.unlock(nextBuffer);
+}
+
+TEST(ResultMetadataAssemblerTest, CountsAllocationsAndCopies) {
+    ResultMetadataAssembler assembler;
+    const CameraMetadata result = makeResult();
+    const CameraMetadata partials = makePartials();
+
+    CameraMetadata assembled = assemble(assembler, result, partials);
+    const camera_metadata_t* buffer = assembled.getAndLock();
+    assembled.unlock(buffer);
+    assembler.finish(assembled, buffer);
+    assembler.countCopy(result);
+
+    TemporaryFile file;
+    assembler.dump(file.fd);
+    std::string dump;
+    ASSERT_TRUE(android::base::ReadFileToString(file.path, &dump));
+    EXPECT_NE(std::string::npos, dump.find("1 results, 2 allocations, 2 copies")) << dump;
+}
@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "SessionConfigurationQueryCacheTest"
+
+#include <inttypes.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <system/graphics.h>
+#include <utils/Errors.h>
+#include <utils/Log.h>
+#include <utils/Timers.h>
+
+#include "../common/SessionConfigurationQueryCache.h"
+
+using namespace android;
+using hardware::camera2::params::OutputConfiguration;
+using hardware::camera2::params::SessionConfiguration;
+
+namespace {
+
+const std::string kCameraId = "0";
+
+// Session configuration queries served by a provider, with the cost of a HAL round trip
+struct FakeProvider {
+    int mQueries = 0;
+
+    bool isSessionConfigurationSupported(const SessionConfiguration& configuration) {
+        mQueries++;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        int64_t pixels = 0;
+        for (const auto& output : configuration.getOutputConfigurations()) {
+            pixels += static_cast<int64_t>(output.getWidth()) * output.getHeight();
+        }
+        return configuration.getOutputConfigurations().size() <= 3 && pixels <= 16'000'000;
+    }
+};
+
+// The lookup done by CameraProviderManager::isSessionConfigurationSupported
+bool query(SessionConfigurationQueryCache* cache, FakeProvider* provider,
+        const SessionConfiguration& configuration) {
+    SessionConfigurationQueryCache::Key key;
+    bool supported = false;
+    if (cache != nullptr) {
+        if (!SessionConfigurationQueryCache::makeKey(kCameraId, configuration,
+                /*overrideForPerfClass*/false, /*checkSessionParams*/true, &key)) {
+            ADD_FAILURE() << "Configuration not cacheable";
+        } else if (cache->lookup(&key, &supported)) {
+            return supported;
+        }
+    }
+    supported = provider->isSessionConfigurationSupported(configuration);
+    if (cache != nullptr) cache->insert(key, supported);
+    return supported;
+}
+
+OutputConfiguration makeOutput(int width, int height, int format, int64_t streamUseCase) {
+    return OutputConfiguration(OutputConfiguration::SURFACE_TYPE_SURFACE_TEXTURE, width, height,
+            format, ANDROID_REQUEST_AVAILABLE_COLOR_SPACE_PROFILES_MAP_UNSPECIFIED,
+            OutputConfiguration::MIRROR_MODE_AUTO, /*useReadoutTimestamp*/false,
+            OutputConfiguration::TIMESTAMP_BASE_DEFAULT, HAL_DATASPACE_UNKNOWN, /*usage*/0,
+            streamUseCase, /*physicalCamId*/"");
+}
+
+SessionConfiguration makeSession(const std::vector<OutputConfiguration>& outputs) {
+    SessionConfiguration session(/*inputWidth*/0, /*inputHeight*/0, /*inputFormat*/-1,
+            /*operatingMode*/0);
+    for (const auto& output : outputs) {
+        session.addOutputConfiguration(output);
+    }
+    return session;
+}
+
+// What CameraX checks when binding preview, image analysis and image capture use cases: each
+// use case alone, pairs, and all three, over the candidate sizes of each.
+std::vector<SessionConfiguration> makeCameraXProbes() {
+    const std::vector<OutputConfiguration> previews = {
+        makeOutput(1920, 1080, HAL_PIXEL_FORMAT_IMPLEMENTATION_DEFINED,
+                ANDROID_SCALER_AVAILABLE_STREAM_USE_CASES_PREVIEW),
+        makeOutput(1280, 720, HAL_PIXEL_FORMAT_IMPLEMENTATION_DEFINED,
+                ANDROID_SCALER_AVAILABLE_STREAM_USE_CASES_PREVIEW),
+    };
+    const std::vector<OutputConfiguration> analyses = {
+        makeOutput(640, 480, HAL_PIXEL_FORMAT_YCBCR_420_888,
+                ANDROID_SCALER_AVAILABLE_STREAM_USE_CASES_DEFAULT),
+    };
+    const std::vector<OutputConfiguration> captures = {
+        makeOutput(4032, 3024, HAL_PIXEL_FORMAT_BLOB,
+                ANDROID_SCALER_AVAILABLE_STREAM_USE_CASES_STILL_CAPTURE),
+        makeOutput(1920, 1440, HAL_PIXEL_FORMAT_BLOB,
+                ANDROID_SCALER_AVAILABLE_STREAM_USE_CASES_STILL_CAPTURE),
+    };
+
+    std::vector<SessionConfiguration> probes;
+    for (const auto& preview : previews) {
+        probes.push_back(makeSession({preview}));
+        for (const auto& analysis : analyses) {
+            probes.push_back(makeSession({preview, analysis}));
+            for (const auto& capture : captures) {
+                probes.push_back(makeSession({preview, analysis, capture}));
+            }
+        }
+        for (const auto& capture : captures) {
+            probes.push_back(makeSession({preview, capture}));
+        }
+    }
+    return probes;
+}
+
+} // namespace
+
+TEST(SessionConfigurationQueryCacheTest, CameraXProbeSequence) {
+    const std::vector<SessionConfiguration> probes = makeCameraXProbes();
+    // The app binds the use cases again on each resume and rotation
+    constexpr int kBinds = 5;
+
+    FakeProvider uncachedProvider;
+    std::vector<bool> expected;
+    nsecs_t start = systemTime();
+    for (int bind = 0; bind < kBinds; bind++) {
+        for (const auto& probe : probes) {
+            expected.push_back(query(/*cache*/nullptr, &uncachedProvider, probe));
+        }
+    }
+    const nsecs_t uncachedDuration = systemTime() - start;
+
+    SessionConfigurationQueryCache cache;
+    FakeProvider cachedProvider;
+    size_t i = 0;
+    start = systemTime();
+    for (int bind = 0; bind < kBinds; bind++) {
+        for (const auto& probe : probes) {
+            EXPECT_EQ(expected[i++], query(&cache, &cachedProvider, probe));
+        }
+    }
+    const nsecs_t cachedDuration = systemTime() - start;
+
+    ALOGI("%zu probes x %d binds: %" PRId64 " us uncached, %" PRId64 " us cached",
+            probes.size(), kBinds, ns2us(uncachedDuration), ns2us(cachedDuration));
+    EXPECT_EQ(static_cast<int>(probes.size()), cachedProvider.mQueries);
+    EXPECT_EQ(static_cast<int>(probes.size()) * (kBinds - 1), cache.hits());
+    EXPECT_EQ(static_cast<int>(probes.size()), cache.misses());
+    EXPECT_LT(cachedDuration, uncachedDuration);
+}
+
+TEST(SessionConfigurationQueryCacheTest, KeyCoversQuery) {
+    const SessionConfiguration session = makeSession({
+            makeOutput(1920, 1080, HAL_PIXEL_FORMAT_IMPLEMENTATION_DEFINED,
+                    ANDROID_SCALER_AVAILABLE_STREAM_USE_CASES_PREVIEW)});
+    SessionConfigurationQueryCache::Key key, same, other;
+    ASSERT_TRUE(SessionConfigurationQueryCache::makeKey(kCameraId, session,
+            /*overrideForPerfClass*/false, /*checkSessionParams*/true, &key));
+    ASSERT_TRUE(SessionConfigurationQueryCache::makeKey(kCameraId, makeSession({
+            makeOutput(1920, 1080, HAL_PIXEL_FORMAT_IMPLEMENTATION_DEFINED,
+                    ANDROID_SCALER_AVAILABLE_STREAM_USE_CASES_PREVIEW)}),
+            /*overrideForPerfClass*/false, /*checkSessionParams*/true, &same));
+    EXPECT_EQ(key.encoding, same.encoding);
+    EXPECT_EQ(key.hash, same.hash);
+
+    ASSERT_TRUE(SessionConfigurationQueryCache::makeKey("1", session,
+            /*overrideForPerfClass*/false, /*checkSessionParams*/true, &other));
+    EXPECT_NE(key.encoding, other.encoding);
+    ASSERT_TRUE(SessionConfigurationQueryCache::makeKey(kCameraId, session,
+            /*overrideForPerfClass*/true, /*checkSessionParams*/true, &other));
+    EXPECT_NE(key.encoding, other.encoding);
+    ASSERT_TRUE(SessionConfigurationQueryCache::makeKey(kCameraId, makeSession({
+            makeOutput(1920, 1080, HAL_PIXEL_FORMAT_IMPLEMENTATION_DEFINED,
+                    ANDROID_SCALER_AVAILABLE_STREAM_USE_CASES_VIDEO_RECORD)}),
+            /*overrideForPerfClass*/false, /*checkSessionParams*/true, &other));
+    EXPECT_NE(key.encoding, other.encoding);
+}
+
+TEST(SessionConfigurationQueryCacheTest, InvalidateDropsAnswers) {
+    SessionConfigurationQueryCache cache;
+    const SessionConfiguration session = makeCameraXProbes()[0];
+    SessionConfigurationQueryCache::Key key;
+    ASSERT_TRUE(SessionConfigurationQueryCache::makeKey(kCameraId, session,
+            /*overrideForPerfClass*/false, /*checkSessionParams*/true, &key));
+    bool supported = false;
+    ASSERT_FALSE(cache.lookup(&key, &supported));
+    cache.insert(key, true);
+    ASSERT_TRUE(cache.lookup(&key, &supported));
+    EXPECT_TRUE(supported);
+
+    cache.invalidate();
+    EXPECT_FALSE(cache.lookup(&key, &supported));
+
+    // An answer obtained before an invalidation is dropped
+    cache.invalidate();
+    cache.insert(key, true);
+    EXPECT_FALSE(cache.lookup(&key, &supported));
+}
+
+TEST(SessionConfigurationQueryCacheTest, EvictsLeastRecentlyUsed) {
+    SessionConfigurationQueryCache cache(/*capacity*/2);
+    const std::vector<SessionConfiguration> probes = makeCameraXProbes();
+    std::vector<SessionConfigurationQueryCache::Key> keys(3);
+    bool supported;
+    for (size_t i = 0; i < keys.size(); i++) {
+        ASSERT_TRUE(SessionConfigurationQueryCache::makeKey(kCameraId, probes[i],
+                /*overrideForPerfClass*/false, /*checkSessionParams*/true, &keys[i]));
+    }
+    cache.lookup(&keys[0], &supported);
+    cache.insert(keys[0], true);
+    cache.lookup(&keys[1], &supported);
+    cache.insert(keys[1], false);
+    // Make the first answer the most recently used
+    ASSERT_TRUE(cache.lookup(&keys[0], &supported));
+    cache.lookup(&keys[2], &supported);
+    cache.insert(keys[2], true);
+
+    EXPECT_TRUE(cache.lookup(&keys[0], &supported));
+    EXPECT_FALSE(cache.lookup(&keys[1], &supported));
+    EXPECT_TRUE(cache.lookup(&keys[2], &supported));
+}
@@ -67,3 +67,33 @@ TEST(SessionStatsBuilderTest, FpsHistogramTest) {
     ASSERT_EQ(mostRequestedFpsRange, make_pair(2, 2)) << "Incorrect stats overflow behavior";
 
 }
+
+TEST(SessionStatsBuilderTest, StageLatencyTest) {
+    SessionStatsBuilder b{};
+    CaptureStageLatencies total;
+
+    for (int i = 1; i <= 10; i++) {
+        b.addStageLatency(CaptureStage::SHUTTER, ms2ns(10 * i));
+        b.addStageLatency(CaptureStage::RESULT, ms2ns(20 * i));
+    }
+
+    // Merging keeps the session latencies
+    CaptureStageLatencies current;
+    b.mergeStageLatencies(&current);
+    ASSERT_EQ(current[static_cast<size_t>(CaptureStage::SHUTTER)].count(), 10);
+    ASSERT_EQ(current[static_cast<size_t>(CaptureStage::PARTIAL_RESULT)].count(), 0);
+
+    // Sessions accumulate into the total
+    b.mergeAndResetStageLatencies(&total);
+    b.addStageLatency(CaptureStage::SHUTTER, ms2ns(200));
+    b.mergeAndResetStageLatencies(&total);
+
+    const auto& shutter = total[static_cast<size_t>(CaptureStage::SHUTTER)];
+    ASSERT_EQ(shutter.count(), 11);
+    ASSERT_EQ(shutter.max(), ms2ns(200));
+    ASSERT_EQ(total[static_cast<size_t>(CaptureStage::RESULT)].count(), 10);
+
+    b.mergeStageLatencies(&current);
+    ASSERT_EQ(current[static_cast<size_t>(CaptureStage::SHUTTER)].count(), 10)
+            << "Stage latencies not reset";
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SERVERS_CAMERA_TESTS_SYNTHETIC_CAMERA_METADATA_H
+#define ANDROID_SERVERS_CAMERA_TESTS_SYNTHETIC_CAMERA_METADATA_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../device3/DistortionMapper.h"
+#include "../device3/RotateAndCropMapper.h"
+#include "../device3/UHRCropAndMeteringRegionMapper.h"
+#include "../device3/ZoomRatioMapper.h"
+
+namespace android {
+namespace camera3 {
+namespace test {
+
+// Static metadata of a 12MP camera with distortion correction, zoom ratio and
+// rotate-and-crop, and its request coordinate mappers.
+struct SyntheticCamera {
+    CameraMetadata deviceInfo;
+
+    std::unordered_map<std::string, UHRCropAndMeteringRegionMapper> uhrMappers;
+    std::unordered_map<std::string, DistortionMapper> distortionMappers;
+    std::unordered_map<std::string, ZoomRatioMapper> zoomRatioMappers;
+    std::unordered_map<std::string, RotateAndCropMapper> rotateAndCropMappers;
+
+    explicit SyntheticCamera(const std::string& cameraId) {
+        const int32_t activeArray[] = {16, 12, 4000, 3000};
+        const int32_t preCorrectionActiveArray[] = {0, 0, 4032, 3024};
+        const int32_t activeArrayMaxResolution[] = {32, 24, 8000, 6000};
+        const int32_t preCorrectionActiveArrayMaxResolution[] = {0, 0, 8064, 6048};
+        const float intrinsics[] = {3000.f, 3000.f, 2016.f, 1512.f, 0.f};
+        const float distortion[] = {0.05f, -0.02f, 0.001f, 0.0005f, -0.0002f};
+        const uint8_t distortionModes[] = {ANDROID_DISTORTION_CORRECTION_MODE_OFF,
+                ANDROID_DISTORTION_CORRECTION_MODE_FAST,
+                ANDROID_DISTORTION_CORRECTION_MODE_HIGH_QUALITY};
+        const uint8_t rotateAndCropModes[] = {ANDROID_SCALER_ROTATE_AND_CROP_NONE,
+                ANDROID_SCALER_ROTATE_AND_CROP_90, ANDROID_SCALER_ROTATE_AND_CROP_AUTO};
+        const float maxDigitalZoom = 8.f;
+
+        deviceInfo.update(ANDROID_SENSOR_INFO_ACTIVE_ARRAY_SIZE, activeArray, 4);
+        deviceInfo.update(ANDROID_SENSOR_INFO_PRE_CORRECTION_ACTIVE_ARRAY_SIZE,
+                preCorrectionActiveArray, 4);
+        deviceInfo.update(ANDROID_SENSOR_INFO_ACTIVE_ARRAY_SIZE_MAXIMUM_RESOLUTION,
+                activeArrayMaxResolution, 4);
+        deviceInfo.update(ANDROID_SENSOR_INFO_PRE_CORRECTION_ACTIVE_ARRAY_SIZE_MAXIMUM_RESOLUTION,
+                preCorrectionActiveArrayMaxResolution, 4);
+        deviceInfo.update(ANDROID_LENS_INTRINSIC_CALIBRATION, intrinsics, 5);
+        deviceInfo.update(ANDROID_LENS_DISTORTION, distortion, 5);
+        deviceInfo.update(ANDROID_DISTORTION_CORRECTION_AVAILABLE_MODES, distortionModes, 3);
+        deviceInfo.update(ANDROID_SCALER_AVAILABLE_ROTATE_AND_CROP_MODES, rotateAndCropModes, 3);
+        deviceInfo.update(ANDROID_SCALER_AVAILABLE_MAX_DIGITAL_ZOOM, &maxDigitalZoom, 1);
+        bool supportNativeZoomRatio = false;
+        ZoomRatioMapper::overrideZoomRatioTags(&deviceInfo, &supportNativeZoomRatio);
+
+        uhrMappers[cameraId] = UHRCropAndMeteringRegionMapper(deviceInfo,
+                /*usePreCorrectionArray*/true);
+        distortionMappers[cameraId].setupStaticInfo(deviceInfo);
+        zoomRatioMappers[cameraId] = ZoomRatioMapper(&deviceInfo, supportNativeZoomRatio,
+                /*usePrecorrectArray*/true);
+        rotateAndCropMappers.emplace(cameraId, &deviceInfo);
+    }
+};
+
+// Preview request settings, with "frame" changing the exposure time so that consecutive
+// requests differ.
+inline CameraMetadata makeSyntheticRequest(int64_t frame = 0) {
+    CameraMetadata request;
+    const int32_t cropRegion[] = {516, 387, 3000, 2250};
+    const int32_t aeRegions[] = {1000, 800, 1400, 1100, 1000};
+    const int32_t afRegions[] = {1900, 1400, 2100, 1600, 1000};
+    const int32_t awbRegions[] = {0, 0, 4000, 3000, 0};
+    const float zoomRatio = 2.f;
+    const uint8_t distortionMode = ANDROID_DISTORTION_CORRECTION_MODE_FAST;
+    const uint8_t rotateAndCrop = ANDROID_SCALER_ROTATE_AND_CROP_90;
+    const uint8_t sensorPixelMode = ANDROID_SENSOR_PIXEL_MODE_DEFAULT;
+    const uint8_t controlMode = ANDROID_CONTROL_MODE_AUTO;
+    const uint8_t aeMode = ANDROID_CONTROL_AE_MODE_ON;
+    const uint8_t afMode = ANDROID_CONTROL_AF_MODE_CONTINUOUS_PICTURE;
+    const uint8_t awbMode = ANDROID_CONTROL_AWB_MODE_AUTO;
+    const int32_t fpsRange[] = {30, 30};
+    const int64_t exposureTime = 10000000 + frame % 1000;
+    const int32_t sensitivity = 400;
+    const int64_t frameDuration = 33333333;
+    const uint8_t noiseReduction = ANDROID_NOISE_REDUCTION_MODE_FAST;
+    const uint8_t edgeMode = ANDROID_EDGE_MODE_FAST;
+    const uint8_t tonemapMode = ANDROID_TONEMAP_MODE_FAST;
+    const std::vector<float> tonemapCurve(64, 0.5f);
+
+    request.update(ANDROID_SCALER_CROP_REGION, cropRegion, 4);
+    request.update(ANDROID_CONTROL_AE_REGIONS, aeRegions, 5);
+    request.update(ANDROID_CONTROL_AF_REGIONS, afRegions, 5);
+    request.update(ANDROID_CONTROL_AWB_REGIONS, awbRegions, 5);
+    request.update(ANDROID_CONTROL_ZOOM_RATIO, &zoomRatio, 1);
+    request.update(ANDROID_DISTORTION_CORRECTION_MODE, &distortionMode, 1);
+    request.update(ANDROID_SCALER_ROTATE_AND_CROP, &rotateAndCrop, 1);
+    request.update(ANDROID_SENSOR_PIXEL_MODE, &sensorPixelMode, 1);
+    request.update(ANDROID_CONTROL_MODE, &controlMode, 1);
+    request.update(ANDROID_CONTROL_AE_MODE, &aeMode, 1);
+    request.update(ANDROID_CONTROL_AF_MODE, &afMode, 1);
+    request.update(ANDROID_CONTROL_AWB_MODE, &awbMode, 1);
+    request.update(ANDROID_CONTROL_AE_TARGET_FPS_RANGE, fpsRange, 2);
+    request.update(ANDROID_SENSOR_EXPOSURE_TIME, &exposureTime, 1);
+    request.update(ANDROID_SENSOR_SENSITIVITY, &sensitivity, 1);
+    request.update(ANDROID_SENSOR_FRAME_DURATION, &frameDuration, 1);
+    request.update(ANDROID_NOISE_REDUCTION_MODE, &noiseReduction, 1);
+    request.update(ANDROID_EDGE_MODE, &edgeMode, 1);
+    request.update(ANDROID_TONEMAP_MODE, &tonemapMode, 1);
+    request.update(ANDROID_TONEMAP_CURVE_RED, tonemapCurve.data(), tonemapCurve.size());
+    request.update(ANDROID_TONEMAP_CURVE_GREEN, tonemapCurve.data(), tonemapCurve.size());
+    request.update(ANDROID_TONEMAP_CURVE_BLUE, tonemapCurve.data(), tonemapCurve.size());
+    request.sort();
+    return request;
+}
+
+} // namespace test
+} // namespace camera3
+} // namespace android
+
+#endif
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SERVERS_CAMERA_INSTRUMENTED_MUTEX_H
+#define ANDROID_SERVERS_CAMERA_INSTRUMENTED_MUTEX_H
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <mutex>
+
+#include <utils/Timers.h>
+
+namespace android {
+
+/**
+ * A std::mutex that keeps track of how long its callers waited for it.
+ *
+ * Uncontended acquisitions only cost a try_lock and a counter increment; the clock is read only
+ * when the mutex is already held by another thread. Can be used with std::lock_guard and
+ * std::unique_lock.
+ */
+class InstrumentedMutex {
+  public:
+    void lock() {
+        mAcquisitions.fetch_add(1, std::memory_order_relaxed);
+        if (mMutex.try_lock()) {
+            return;
+        }
+
+        nsecs_t start = systemTime();
+        mMutex.lock();
+        nsecs_t wait = systemTime() - start;
+        mContended.fetch_add(1, std::memory_order_relaxed);
+        mTotalWait.fetch_add(wait, std::memory_order_relaxed);
+        nsecs_t maxWait = mMaxWait.load(std::memory_order_relaxed);
+        while (wait > maxWait &&
+                !mMaxWait.compare_exchange_weak(maxWait, wait, std::memory_order_relaxed)) {
+        }
+    }
+
+    bool try_lock() {
+        if (mMutex.try_lock()) {
+            mAcquisitions.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    void unlock() { mMutex.unlock(); }
+
+    int64_t acquisitions() const { return mAcquisitions.load(std::memory_order_relaxed); }
+    int64_t contended() const { return mContended.load(std::memory_order_relaxed); }
+    nsecs_t totalWait() const { return mTotalWait.load(std::memory_order_relaxed); }
+    nsecs_t maxWait() const { return mMaxWait.load(std::memory_order_relaxed); }
+
+    void dump(int fd, const char* name) const {
+        int64_t acquired = acquisitions();
+        int64_t waited = contended();
+        dprintf(fd, "%s: %" PRId64 " acquisitions, %" PRId64 " contended (%.2f%%), "
+                "wait total %" PRId64 " us, mean %" PRId64 " us, max %" PRId64 " us\n",
+                name, acquired, waited, acquired > 0 ? 100.0 * waited / acquired : 0.0,
+                ns2us(totalWait()), waited > 0 ? ns2us(totalWait() / waited) : 0,
+                ns2us(maxWait()));
+    }
+
+  private:
+    std::mutex mMutex;
+    std::atomic<int64_t> mAcquisitions{0};
+    std::atomic<int64_t> mContended{0};
+    std::atomic<nsecs_t> mTotalWait{0};
+    std::atomic<nsecs_t> mMaxWait{0};
+}; // class InstrumentedMutex
+
+} // namespace android
+
+#endif
@@ -16,6 +16,11 @@
 
 #define LOG_TAG "CameraLatencyHistogram"
 #include <inttypes.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+
 #include <android-base/stringprintf.h>
 #include <utils/Log.h>
 #include <camera/StringUtils.h>
@@ -105,4 +110,142 @@ void CameraLatencyHistogram::formatHistogramText(
     lineBinCounts += " (%)";
 }
 
+CameraLogLatencyHistogram::CameraLogLatencyHistogram(const CameraLogLatencyHistogram& other) {
+    merge(other);
+}
+
+CameraLogLatencyHistogram& CameraLogLatencyHistogram::operator=(
+        const CameraLogLatencyHistogram& other) {
+    if (this != &other) {
+        reset();
+        merge(other);
+    }
+    return *this;
+}
+
+int32_t CameraLogLatencyHistogram::bucketIndex(int64_t durationUs) {
+    if (durationUs < kSubBucketCount) {
+        return std::max<int32_t>(durationUs, 0);
+    }
+    int32_t exponent = 63 - __builtin_clzll(durationUs);
+    if (exponent >= kMaxExponent) {
+        return kBucketCount - 1;
+    }
+    int32_t subBucket = (durationUs >> (exponent - kSubBucketBits)) & (kSubBucketCount - 1);
+    return (exponent - kSubBucketBits + 1) * kSubBucketCount + subBucket;
+}
+
+int64_t CameraLogLatencyHistogram::bucketLowerBound(int32_t index) {
+    if (index < kSubBucketCount) {
+        return index;
+    }
+    int32_t exponent = index / kSubBucketCount + kSubBucketBits - 1;
+    int64_t subBucket = index % kSubBucketCount;
+    return (kSubBucketCount + subBucket) << (exponent - kSubBucketBits);
+}
+
+void CameraLogLatencyHistogram::add(nsecs_t duration) {
+    duration = std::max<nsecs_t>(duration, 0);
+    mBuckets[bucketIndex(ns2us(duration))].fetch_add(1, std::memory_order_relaxed);
+    mTotal.fetch_add(duration, std::memory_order_relaxed);
+    updateMax(duration);
+    mCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void CameraLogLatencyHistogram::merge(const CameraLogLatencyHistogram& other) {
+    for (int32_t i = 0; i < kBucketCount; i++) {
+        mBuckets[i].fetch_add(other.mBuckets[i].load(std::memory_order_relaxed),
+                std::memory_order_relaxed);
+    }
+    mTotal.fetch_add(other.mTotal.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    updateMax(other.max());
+    mCount.fetch_add(other.count(), std::memory_order_relaxed);
+}
+
+void CameraLogLatencyHistogram::mergeAndReset(CameraLogLatencyHistogram& other) {
+    for (int32_t i = 0; i < kBucketCount; i++) {
+        mBuckets[i].fetch_add(other.mBuckets[i].exchange(0, std::memory_order_relaxed),
+                std::memory_order_relaxed);
+    }
+    mTotal.fetch_add(other.mTotal.exchange(0, std::memory_order_relaxed),
+            std::memory_order_relaxed);
+    updateMax(other.mMax.exchange(0, std::memory_order_relaxed));
+    mCount.fetch_add(other.mCount.exchange(0, std::memory_order_relaxed),
+            std::memory_order_relaxed);
+}
+
+void CameraLogLatencyHistogram::reset() {
+    for (auto& bucket : mBuckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    mTotal.store(0, std::memory_order_relaxed);
+    mMax.store(0, std::memory_order_relaxed);
+    mCount.store(0, std::memory_order_relaxed);
+}
+
+void CameraLogLatencyHistogram::updateMax(nsecs_t duration) {
+    nsecs_t max = mMax.load(std::memory_order_relaxed);
+    while (duration > max &&
+            !mMax.compare_exchange_weak(max, duration, std::memory_order_relaxed)) {
+    }
+}
+
+nsecs_t CameraLogLatencyHistogram::mean() const {
+    int64_t samples = count();
+    return samples > 0 ? mTotal.load(std::memory_order_relaxed) / samples : 0;
+}
+
+nsecs_t CameraLogLatencyHistogram::percentile(double percentile) const {
+    // The bucket counts may be ahead of the sample count while samples are added
+    int64_t samples = 0;
+    for (const auto& bucket : mBuckets) {
+        samples += bucket.load(std::memory_order_relaxed);
+    }
+    if (samples == 0) {
+        return 0;
+    }
+
+    int64_t rank = std::max<int64_t>(std::ceil(samples * percentile / 100.0), 1);
+    int64_t seen = 0;
+    int32_t index = 0;
+    for (; index < kBucketCount - 1; index++) {
+        seen += mBuckets[index].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            break;
+        }
+    }
+    if (index == kBucketCount - 1) {
+        return max();
+    }
+    return std::min(us2ns(bucketLowerBound(index + 1)), max());
+}
+
+std::string CameraLogLatencyHistogram::summary() const {
+    return fmt::sprintf("%" PRId64 " samples, mean %.2f, p50 %.2f, p90 %.2f, p99 %.2f,"
+            " max %.2f (ms)", count(), mean() / 1e6, percentile(50) / 1e6,
+            percentile(90) / 1e6, percentile(99) / 1e6, max() / 1e6);
+}
+
+void CameraLogLatencyHistogram::dump(int fd, const char* name) const {
+    if (count() == 0) {
+        return;
+    }
+
+    std::string line = fmt::sprintf("%s: %s\n", name, summary().c_str());
+    write(fd, line.c_str(), line.size());
+}
+
+void CameraLogLatencyHistogram::log(const char* fmt, ...) const {
+    if (count() == 0) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, fmt);
+    std::string histogramName;
+    base::StringAppendV(&histogramName, fmt, args);
+    va_end(args);
+    ALOGI("%s: %s", histogramName.c_str(), summary().c_str());
+}
+
 }; //namespace android
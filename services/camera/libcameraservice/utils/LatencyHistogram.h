@@ -17,6 +17,9 @@
 #ifndef ANDROID_SERVERS_CAMERA_LATENCY_HISTOGRAM_H_
 #define ANDROID_SERVERS_CAMERA_LATENCY_HISTOGRAM_H_
 
+#include <array>
+#include <atomic>
+#include <string>
 #include <vector>
 
 #include <utils/Timers.h>
@@ -43,6 +46,57 @@ private:
     void formatHistogramText(std::string& lineBins, std::string& lineBinCounts) const;
 }; // class CameraLatencyHistogram
 
+// Log-bucketed histogram for camera latencies, in the style of HDR histograms: each power of two
+// range of latencies is split into a few linear buckets, so that latencies from microseconds to
+// tens of seconds are recorded with a bounded relative error. Samples can be added from any
+// thread without locking, and histograms can be merged, e.g. to aggregate per-session histograms.
+class CameraLogLatencyHistogram {
+public:
+    // Each power of two range is split into 2^kSubBucketBits buckets
+    static constexpr int32_t kSubBucketBits = 2;
+    static constexpr int32_t kSubBucketCount = 1 << kSubBucketBits;
+    // Latencies are recorded in microseconds. Latencies above 2^kMaxExponent us (~67s) are
+    // recorded in the last bucket.
+    static constexpr int32_t kMaxExponent = 26;
+    static constexpr int32_t kBucketCount = (kMaxExponent - kSubBucketBits + 1) * kSubBucketCount;
+
+    CameraLogLatencyHistogram() = default;
+    CameraLogLatencyHistogram(const CameraLogLatencyHistogram& other);
+    CameraLogLatencyHistogram& operator=(const CameraLogLatencyHistogram& other);
+
+    void add(nsecs_t start, nsecs_t end) { add(end - start); }
+    void add(nsecs_t duration);
+    // Add the samples of 'other' to this histogram
+    void merge(const CameraLogLatencyHistogram& other);
+    // Move the samples of 'other' to this histogram, without losing samples added concurrently
+    // to 'other'
+    void mergeAndReset(CameraLogLatencyHistogram& other);
+    void reset();
+
+    int64_t count() const { return mCount.load(std::memory_order_relaxed); }
+    nsecs_t mean() const;
+    nsecs_t max() const { return mMax.load(std::memory_order_relaxed); }
+    // Upper bound of the bucket containing the given percentile (0 - 100), capped at max()
+    nsecs_t percentile(double percentile) const;
+
+    // Count, mean, median, 90th and 99th percentiles, and max, in ms
+    std::string summary() const;
+    void dump(int fd, const char* name) const;
+    void log(const char* format, ...) const;
+
+    static int32_t bucketIndex(int64_t durationUs);
+    // Smallest latency recorded in the given bucket, in us
+    static int64_t bucketLowerBound(int32_t index);
+
+private:
+    std::array<std::atomic<int64_t>, kBucketCount> mBuckets{};
+    std::atomic<int64_t> mCount{0};
+    std::atomic<nsecs_t> mTotal{0};
+    std::atomic<nsecs_t> mMax{0};
+
+    void updateMax(nsecs_t duration);
+}; // class CameraLogLatencyHistogram
+
 }; // namespace android
 
 #endif // ANDROID_SERVERS_CAMERA_LATENCY_HISTOGRAM_H_
@@ -166,6 +166,40 @@ void SessionStatsBuilder::incFpsRequestedCount(int32_t minFps, int32_t maxFps,
     }
 }
 
+const char* captureStageName(CaptureStage stage) {
+    switch (stage) {
+        case CaptureStage::REQUEST_SUBMITTED:
+            return "Request submitted";
+        case CaptureStage::SHUTTER:
+            return "Shutter";
+        case CaptureStage::PARTIAL_RESULT:
+            return "First partial result";
+        case CaptureStage::RESULT:
+            return "Final result";
+        case CaptureStage::BUFFERS_RETURNED:
+            return "Buffers returned";
+        default:
+            return "Unknown";
+    }
+}
+
+void SessionStatsBuilder::addStageLatency(CaptureStage stage, nsecs_t latency) {
+    if (stage >= CaptureStage::COUNT) return;
+    mStageLatencies[static_cast<size_t>(stage)].add(latency);
+}
+
+void SessionStatsBuilder::mergeAndResetStageLatencies(CaptureStageLatencies* latencies) {
+    for (size_t i = 0; i < mStageLatencies.size(); i++) {
+        (*latencies)[i].mergeAndReset(mStageLatencies[i]);
+    }
+}
+
+void SessionStatsBuilder::mergeStageLatencies(CaptureStageLatencies* latencies) const {
+    for (size_t i = 0; i < mStageLatencies.size(); i++) {
+        (*latencies)[i].merge(mStageLatencies[i]);
+    }
+}
+
 void StreamStats::updateLatencyHistogram(int32_t latencyMs) {
     size_t i;
     for (i = 0; i < mCaptureLatencyBins.size(); i++) {
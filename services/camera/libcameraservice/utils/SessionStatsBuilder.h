@@ -18,6 +18,7 @@
 #define ANDROID_SERVICE_UTILS_SESSION_STATS_BUILDER_H
 
 #include <utils/Errors.h>
+#include <utils/Timers.h>
 
 #include <array>
 #include <map>
@@ -25,6 +26,8 @@
 #include <unordered_map>
 #include <utility>
 
+#include "LatencyHistogram.h"
+
 namespace android {
 
 // Helper class to build stream stats
@@ -55,6 +58,20 @@ struct StreamStats {
     void updateLatencyHistogram(int32_t latencyMs);
 };
 
+// Stages of a capture, each measured from the time the request was queued
+enum class CaptureStage : int32_t {
+    REQUEST_SUBMITTED = 0, // Request accepted by the HAL
+    SHUTTER,               // Shutter notification
+    PARTIAL_RESULT,        // First partial result metadata
+    RESULT,                // Final result metadata
+    BUFFERS_RETURNED,      // Last buffer of the request returned by the HAL
+    COUNT
+};
+const char* captureStageName(CaptureStage stage);
+
+using CaptureStageLatencies =
+        std::array<CameraLogLatencyHistogram, static_cast<size_t>(CaptureStage::COUNT)>;
+
 // Helper class to build session stats
 class SessionStatsBuilder {
 public:
@@ -86,6 +103,13 @@ public:
 
     void incFpsRequestedCount(int32_t minFps, int32_t maxFps, int64_t frameNumber);
 
+    // Capture stage latencies. Don't take the builder lock, so can be called from any thread.
+    void addStageLatency(CaptureStage stage, nsecs_t latency);
+    // Move the stage latencies of the session into 'latencies'.
+    void mergeAndResetStageLatencies(/*inout*/CaptureStageLatencies* latencies);
+    // Add the stage latencies of the session so far to 'latencies'.
+    void mergeStageLatencies(/*inout*/CaptureStageLatencies* latencies) const;
+
     SessionStatsBuilder() : mRequestCount(0), mErrorResultCount(0),
              mCounterStopped(false), mDeviceError(false) {}
 private:
@@ -102,6 +126,8 @@ private:
 
     // Map from stream id to stream statistics
     std::map<int, StreamStats> mStatsMap;
+
+    CaptureStageLatencies mStageLatencies;
 };
 
 }; // namespace android
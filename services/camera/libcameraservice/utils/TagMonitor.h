@@ -64,6 +64,8 @@ class TagMonitor {
     // Disable monitoring; does not clear the event log
     void disableMonitoring();
 
+    bool isMonitoring() const { return mMonitoringEnabled; }
+
     // Scan through the metadata and update the monitoring information
     void monitorMetadata(eventSource source, int64_t frameNumber,
             nsecs_t timestamp, const CameraMetadata& metadata,